@@ -32,6 +32,9 @@
 #include "AMD_Types.h"
 
 #include "../src/AMD_Common.h"
+#include "../src/AMD_DirtyRegions.h"
+#include "../src/AMD_StateCache.h"
+#include "../src/AMD_StateCacheD3D11.h"
 #include "../src/AMD_Texture2D.h"
 #include "../src/AMD_Buffer.h"
 #include "../src/AMD_Rand.h"
@@ -0,0 +1,293 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "AMD_DirtyRegions.h"
+
+namespace AMD
+{
+    static uint64 RectArea(const DirtyRect & rect)
+    {
+        if (rect.right <= rect.left || rect.bottom <= rect.top) { return 0; }
+
+        return (uint64)(rect.right - rect.left) * (uint64)(rect.bottom - rect.top);
+    }
+
+    static bool RectsTouch(const DirtyRect & a, const DirtyRect & b)
+    {
+        return a.left <= b.right && b.left <= a.right && a.top <= b.bottom && b.top <= a.bottom;
+    }
+
+    static bool RectContains(const DirtyRect & outer, const DirtyRect & inner)
+    {
+        return outer.left <= inner.left && outer.top <= inner.top && outer.right >= inner.right && outer.bottom >= inner.bottom;
+    }
+
+    static bool RectsEqual(const DirtyRect & a, const DirtyRect & b)
+    {
+        return a.left == b.left && a.top == b.top && a.right == b.right && a.bottom == b.bottom;
+    }
+
+    void MergeDirtyRects(std::vector<DirtyRect> & rects, float maxWaste)
+    {
+        for (size_t i = 0; i < rects.size(); )
+        {
+            if (RectArea(rects[i]) == 0) { rects.erase(rects.begin() + i); }
+            else                         { i++; }
+        }
+
+        // keep merging pairs until nothing changes, the lists are a handful of rects at most
+        bool merged = true;
+        while (merged)
+        {
+            merged = false;
+
+            for (size_t i = 0; i < rects.size() && merged == false; i++)
+            {
+                for (size_t j = i + 1; j < rects.size(); j++)
+                {
+                    const DirtyRect & a = rects[i];
+                    const DirtyRect & b = rects[j];
+
+                    if (RectsTouch(a, b) == false) { continue; }
+
+                    DirtyRect bound = { MIN(a.left, b.left), MIN(a.top, b.top), MAX(a.right, b.right), MAX(a.bottom, b.bottom) };
+                    DirtyRect overlap = { MAX(a.left, b.left), MAX(a.top, b.top), MIN(a.right, b.right), MIN(a.bottom, b.bottom) };
+
+                    const double unionArea = (double)(RectArea(a) + RectArea(b) - RectArea(overlap));
+
+                    if ((double)RectArea(bound) <= unionArea * (1.0 + (double)maxWaste))
+                    {
+                        rects[i] = bound;
+                        rects.erase(rects.begin() + j);
+                        merged = true;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    DirtyRegionList::DirtyRegionList()
+        : _count(0)
+        , _texels(0)
+        , _empty(true)
+    {
+    }
+
+    void DirtyRegionList::Clear()
+    {
+        _rects.clear();
+        _subresources.clear();
+        _count = 0;
+        _texels = 0;
+        _empty = true;
+    }
+
+    DirtyRegions::DirtyRegions()
+        : _width(0)
+        , _height(0)
+        , _array(0)
+        , _maxWaste(0.25f)
+    {
+    }
+
+    void DirtyRegions::Init(uint width, uint height, uint arraySize)
+    {
+        Release();
+
+        _width = width;
+        _height = height;
+        _array = arraySize > 0 ? arraySize : 1;
+        _frame.resize(_array);
+    }
+
+    void DirtyRegions::Release()
+    {
+        _width = 0;
+        _height = 0;
+        _array = 0;
+        _frame.clear();
+        _pending.clear();
+    }
+
+    bool DirtyRegions::IsFullSlice(const DirtyRect & rect) const
+    {
+        return rect.left <= 0 && rect.top <= 0 && rect.right >= (int)_width && rect.bottom >= (int)_height;
+    }
+
+    void DirtyRegions::AddToSet(RegionSet & set, const DirtyRect & rect, uint subresource) const
+    {
+        if (subresource >= set.size()) { return; }
+
+        DirtyRect clipped = { MAX(rect.left, 0), MAX(rect.top, 0), MIN(rect.right, (int)_width), MIN(rect.bottom, (int)_height) };
+        if (RectArea(clipped) == 0) { return; }
+
+        std::vector<DirtyRect> & rects = set[subresource];
+
+        for (size_t i = 0; i < rects.size(); i++)
+        {
+            if (RectContains(rects[i], clipped)) { return; }
+        }
+
+        if (IsFullSlice(clipped))
+        {
+            rects.assign(1, clipped);
+            return;
+        }
+
+        rects.push_back(clipped);
+        MergeDirtyRects(rects, _maxWaste);
+    }
+
+    void DirtyRegions::MergeSet(RegionSet & dst, const RegionSet & src) const
+    {
+        for (size_t subresource = 0; subresource < src.size(); subresource++)
+        {
+            for (size_t i = 0; i < src[subresource].size(); i++)
+            {
+                AddToSet(dst, src[subresource][i], (uint)subresource);
+            }
+        }
+    }
+
+    void DirtyRegions::AddRect(const DirtyRect & rect, uint subresource)
+    {
+        AddToSet(_frame, rect, subresource);
+    }
+
+    void DirtyRegions::AddSubresource(uint subresource)
+    {
+        DirtyRect full = { 0, 0, (int)_width, (int)_height };
+        AddToSet(_frame, full, subresource);
+    }
+
+    void DirtyRegions::AddAll()
+    {
+        for (uint i = 0; i < _array; i++)
+        {
+            AddSubresource(i);
+        }
+    }
+
+    void DirtyRegions::Resolve(const RegionSet & set, DirtyRegionList & list) const
+    {
+        list.Clear();
+
+        bool allFull = true;
+        bool allSameSingleRect = true;
+        bool onlyFull = true;
+
+        for (size_t subresource = 0; subresource < set.size(); subresource++)
+        {
+            const std::vector<DirtyRect> & rects = set[subresource];
+
+            for (size_t i = 0; i < rects.size(); i++)
+            {
+                list._texels += RectArea(rects[i]);
+                onlyFull = onlyFull && IsFullSlice(rects[i]);
+            }
+
+            allFull = allFull && rects.size() == 1 && IsFullSlice(rects[0]);
+            allSameSingleRect = allSameSingleRect && rects.size() == 1 && RectsEqual(rects[0], set[0].empty() ? rects[0] : set[0][0]);
+        }
+
+        if (list._texels == 0) { return; }
+
+        list._empty = false;
+
+        if (allFull) // whole resource: NULL, NULL, 0
+        {
+            return;
+        }
+
+        if (allSameSingleRect && _array > 1) // one region in all subresources: rect, NULL, 0
+        {
+            list._rects.push_back(set[0][0]);
+            return;
+        }
+
+        for (size_t subresource = 0; subresource < set.size(); subresource++)
+        {
+            const std::vector<DirtyRect> & rects = set[subresource];
+
+            for (size_t i = 0; i < rects.size(); i++)
+            {
+                if (onlyFull == false) { list._rects.push_back(rects[i]); }
+                if (_array > 1)        { list._subresources.push_back((uint)subresource); }
+
+                list._count++;
+            }
+        }
+    }
+
+    void DirtyRegions::GetFrameRegions(DirtyRegionList & list) const
+    {
+        Resolve(_frame, list);
+    }
+
+    void DirtyRegions::EndFrame(uint gpu, uint gpuCount)
+    {
+        if (_pending.size() != gpuCount)
+        {
+            _pending.resize(gpuCount, RegionSet(_array));
+        }
+
+        for (uint i = 0; i < gpuCount; i++)
+        {
+            if (i != gpu) { MergeSet(_pending[i], _frame); }
+        }
+
+        for (size_t i = 0; i < _frame.size(); i++)
+        {
+            _frame[i].clear();
+        }
+    }
+
+    void DirtyRegions::GetPendingRegions(uint gpu, DirtyRegionList & list) const
+    {
+        if (gpu >= _pending.size()) { list.Clear(); return; }
+
+        Resolve(_pending[gpu], list);
+    }
+
+    void DirtyRegions::GetBroadcastRegions(uint srcGpu, DirtyRegionList & list) const
+    {
+        RegionSet all(_array);
+
+        for (uint i = 0; i < (uint)_pending.size(); i++)
+        {
+            if (i != srcGpu) { MergeSet(all, _pending[i]); }
+        }
+
+        Resolve(all, list);
+    }
+
+    void DirtyRegions::MarkReceived(uint gpu)
+    {
+        if (gpu >= _pending.size()) { return; }
+
+        for (size_t i = 0; i < _pending[gpu].size(); i++)
+        {
+            _pending[gpu][i].clear();
+        }
+    }
+}
@@ -0,0 +1,123 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef AMD_LIB_DIRTY_REGIONS_H
+#define AMD_LIB_DIRTY_REGIONS_H
+
+#include <stddef.h>
+#include <vector>
+
+#include "AMD_Types.h"
+
+namespace AMD
+{
+    // same layout as D3D11_RECT, so a list can be passed straight to agsDriverExtensions_NotifyResourceEndWrites
+    struct DirtyRect
+    {
+        int left;
+        int top;
+        int right;
+        int bottom;
+    };
+
+    // merges overlapping or adjacent rects in place, as long as the merged bounding rect
+    // doesn't cover more than (1 + maxWaste) times the area of the rects it replaces
+    void MergeDirtyRects(std::vector<DirtyRect> & rects, float maxWaste);
+
+    // A resolved region list, laid out the way agsDriverExtensions_NotifyResourceEndWrites expects it:
+    //   GetCount() == 0                 - all subresources, GetRects() is NULL (whole area) or a single rect
+    //   GetSubresources() == NULL       - GetCount() rects in subresource 0
+    //   GetRects() == NULL              - GetCount() whole subresources
+    //   otherwise                       - GetRects()[i] in GetSubresources()[i]
+    class DirtyRegionList
+    {
+    public:
+        DirtyRegionList();
+
+        void                Clear();
+
+        const DirtyRect *   GetRects() const { return _rects.empty() ? NULL : &_rects[0]; }
+        const uint *        GetSubresources() const { return _subresources.empty() ? NULL : &_subresources[0]; }
+        uint                GetCount() const { return _count; }
+        bool                IsEmpty() const { return _empty; }
+
+        // texels covered by the list, so callers can report the transfer size
+        uint64              GetTexelCount() const { return _texels; }
+
+    private:
+        friend class DirtyRegions;
+
+        std::vector<DirtyRect>  _rects;
+        std::vector<uint>       _subresources;
+        uint                    _count;
+        uint64                  _texels;
+        bool                    _empty;
+    };
+
+    // Tracks the regions of a resource written in the current frame, and the regions
+    // each AFR GPU has not received yet. With more than 2 GPUs and a non broadcast
+    // transfer, the next GPU also misses what the other GPUs wrote since its last frame.
+    class DirtyRegions
+    {
+    public:
+        DirtyRegions();
+
+        void Init(uint width, uint height, uint arraySize);
+        void Release();
+
+        void SetMaxWaste(float maxWaste) { _maxWaste = maxWaste; }
+
+        // writes in the current frame
+        void AddRect(const DirtyRect & rect, uint subresource);
+        void AddSubresource(uint subresource);
+        void AddAll();
+
+        void GetFrameRegions(DirtyRegionList & list) const;
+
+        // moves the current frame's writes to the pending list of every GPU other than gpu
+        void EndFrame(uint gpu, uint gpuCount);
+
+        // regions gpu is missing, and the union of what all GPUs but srcGpu are missing (for broadcasts)
+        void GetPendingRegions(uint gpu, DirtyRegionList & list) const;
+        void GetBroadcastRegions(uint srcGpu, DirtyRegionList & list) const;
+
+        void MarkReceived(uint gpu);
+
+    private:
+        typedef std::vector< std::vector<DirtyRect> > RegionSet; // rects per subresource
+
+        void AddToSet(RegionSet & set, const DirtyRect & rect, uint subresource) const;
+        void MergeSet(RegionSet & dst, const RegionSet & src) const;
+        void Resolve(const RegionSet & set, DirtyRegionList & list) const;
+        bool IsFullSlice(const DirtyRect & rect) const;
+
+        uint                    _width;
+        uint                    _height;
+        uint                    _array;
+        float                   _maxWaste;
+
+        RegionSet               _frame;
+        std::vector<RegionSet>  _pending; // per GPU
+    };
+}
+
+#endif //AMD_LIB_DIRTY_REGIONS_H
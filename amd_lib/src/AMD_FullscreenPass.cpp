@@ -25,6 +25,7 @@
 #include "AMD_LIB.h"
 
 #include "AMD_FullscreenPass.h"
+#include "AMD_StateCache.h"
 
 #include "Shaders\inc\VS_FULLSCREEN.inc"
 #include "Shaders\inc\VS_SCREENQUAD.inc"
@@ -170,6 +171,99 @@ namespace AMD
         return S_OK;
     }
 
+    HRESULT RenderFullscreenPass(
+        StateCache &                stateCache,
+        ID3D11DeviceContext*        pDeviceContext,
+        D3D11_VIEWPORT              Viewport,
+        ID3D11VertexShader*         pVS,
+        ID3D11PixelShader*          pPS,
+        D3D11_RECT*                 pScissor,   unsigned int uNumSR,
+        ID3D11Buffer**              ppCB,       unsigned int uNumCBs,
+        ID3D11SamplerState**        ppSamplers, unsigned int uNumSamplers,
+        ID3D11ShaderResourceView**  ppSRVs,     unsigned int uNumSRVs,
+        ID3D11RenderTargetView**    ppRTVs,     unsigned int uNumRTVs,
+        ID3D11UnorderedAccessView** ppUAVs,     unsigned int uStartUAV, unsigned int uNumUAVs,
+        ID3D11DepthStencilView*     pDSV,
+        ID3D11DepthStencilState*    pOutputDSS, unsigned int uStencilRef,
+        ID3D11BlendState *          pOutputBS,
+        ID3D11RasterizerState *     pOutputRS)
+    {
+        return RenderFullscreenInstancedPass(stateCache,
+                                             pDeviceContext,
+                                             Viewport,
+                                             pVS, NULL, pPS,
+                                             pScissor, uNumSR,
+                                             ppCB, uNumCBs,
+                                             ppSamplers, uNumSamplers,
+                                             ppSRVs, uNumSRVs,
+                                             ppRTVs, uNumRTVs,
+                                             ppUAVs, uStartUAV, uNumUAVs,
+                                             pDSV, pOutputDSS, uStencilRef,
+                                             pOutputBS, pOutputRS, 1);
+    }
+
+    HRESULT RenderFullscreenInstancedPass(
+        StateCache &                stateCache,
+        ID3D11DeviceContext*        pDeviceContext,
+        D3D11_VIEWPORT              Viewport,
+        ID3D11VertexShader*         pVS,
+        ID3D11GeometryShader*       pGS,
+        ID3D11PixelShader*          pPS,
+        D3D11_RECT*                 pScissor,   unsigned int uNumSR,
+        ID3D11Buffer**              ppCB,       unsigned int uNumCBs,
+        ID3D11SamplerState**        ppSamplers, unsigned int uNumSamplers,
+        ID3D11ShaderResourceView**  ppSRVs,     unsigned int uNumSRVs,
+        ID3D11RenderTargetView**    ppRTVs,     unsigned int uNumRTVs,
+        ID3D11UnorderedAccessView** ppUAVs,    unsigned int uStartUAV, unsigned int uNumUAVs,
+        ID3D11DepthStencilView*     pDSV,
+        ID3D11DepthStencilState*    pOutputDSS, unsigned int uStencilRef,
+        ID3D11BlendState *          pOutputBS,
+        ID3D11RasterizerState *     pOutputRS,
+        unsigned int                instanceCount)
+    {
+        float white[] = {1.0f, 1.0f, 1.0f, 1.0f};
+        ID3D11Buffer*              pNullBuffer[8] = { NULL };
+        uint NullStride[8] = { 0 };
+        uint NullOffset[8] = { 0 };
+
+        if ((pDeviceContext == NULL || (pVS == NULL && pPS == NULL) || (ppRTVs == NULL && pDSV == NULL && ppUAVs == NULL)))
+        {
+            AMD_OUTPUT_DEBUG_STRING("Invalid pointer argument in function %s\n", AMD_FUNCTION_NAME);
+            return E_POINTER;
+        }
+
+        stateCache.SetDepthStencilState( pOutputDSS, uStencilRef );
+        if (ppUAVs == NULL)
+        {
+            stateCache.SetRenderTargets( uNumRTVs, ppRTVs, pDSV );
+        }
+        else
+        {
+            stateCache.SetRenderTargetsAndUnorderedAccessViews( uNumRTVs, ppRTVs, pDSV, uStartUAV, uNumUAVs, ppUAVs );
+        }
+        stateCache.SetBlendState( pOutputBS, white, 0xFFFFFFFF );
+
+        stateCache.SetViewports( 1, (const StateViewport *)&Viewport );
+        stateCache.SetScissorRects( uNumSR, (const StateRect *)pScissor );
+        stateCache.SetRasterizerState( pOutputRS );
+
+        stateCache.SetConstantBuffers( STATE_CACHE_STAGE_PS, 0, uNumCBs, ppCB );
+        stateCache.SetShaderResources( STATE_CACHE_STAGE_PS, 0, uNumSRVs, ppSRVs );
+        stateCache.SetSamplers( STATE_CACHE_STAGE_PS, 0, uNumSamplers, ppSamplers );
+
+        stateCache.SetInputLayout( NULL );
+        pDeviceContext->IASetVertexBuffers( 0, AMD_ARRAY_SIZE(pNullBuffer), pNullBuffer, NullStride, NullOffset );
+        pDeviceContext->IASetPrimitiveTopology( D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST );
+
+        stateCache.SetShader( pVS );
+        stateCache.SetShader( pGS );
+        stateCache.SetShader( pPS );
+
+        pDeviceContext->Draw( 3 * instanceCount, 0 );
+
+        return S_OK;
+    }
+
     HRESULT RenderFullscreenAlignedQuads(
         ID3D11DeviceContext*       pDeviceContext,
         D3D11_VIEWPORT             Viewport,
@@ -27,6 +27,8 @@
 
 namespace AMD
 {
+    class StateCache;
+
     extern "C++"
     {
         HRESULT CreateFullscreenPass(ID3D11VertexShader** ppVS, ID3D11Device* pDevice);
@@ -67,6 +69,44 @@ namespace AMD
             ID3D11RasterizerState *     pOutputRS,
             unsigned int                instanceCount);
 
+        // the same passes, with the state bound through stateCache: what is already bound isn't
+        // bound again, and nothing is unbound after the draw (the cache unbinds what conflicts)
+        HRESULT RenderFullscreenPass(
+            StateCache &               stateCache,
+            ID3D11DeviceContext*       pDeviceContext,
+            D3D11_VIEWPORT             Viewport,
+            ID3D11VertexShader*        pVS,
+            ID3D11PixelShader*         pPS,
+            D3D11_RECT*                pScissor,   unsigned int uNumSR,
+            ID3D11Buffer**             ppCB,       unsigned int uNumCBs,
+            ID3D11SamplerState**       ppSamplers, unsigned int uNumSamplers,
+            ID3D11ShaderResourceView** ppSRVs,     unsigned int uNumSRVs,
+            ID3D11RenderTargetView**   ppRTVs,     unsigned int uNumRTVs,
+            ID3D11UnorderedAccessView**ppUAVs,     unsigned int uStartUAV, unsigned int uNumUAVs,
+            ID3D11DepthStencilView*    pDSV,
+            ID3D11DepthStencilState*   pOutputDSS, unsigned int uStencilRef,
+            ID3D11BlendState *         pOutputBS,
+            ID3D11RasterizerState *    pOutputRS);
+
+        HRESULT RenderFullscreenInstancedPass(
+            StateCache &                stateCache,
+            ID3D11DeviceContext*        pDeviceContext,
+            D3D11_VIEWPORT              Viewport,
+            ID3D11VertexShader*         pVS,
+            ID3D11GeometryShader*       pGS,
+            ID3D11PixelShader*          pPS,
+            D3D11_RECT*                 pScissor,   unsigned int uNumSR,
+            ID3D11Buffer**              ppCB,       unsigned int uNumCBs,
+            ID3D11SamplerState**        ppSamplers, unsigned int uNumSamplers,
+            ID3D11ShaderResourceView**  ppSRVs,     unsigned int uNumSRVs,
+            ID3D11RenderTargetView**    ppRTVs,     unsigned int uNumRTVs,
+            ID3D11UnorderedAccessView** ppUAVs,     unsigned int uStartUAV, unsigned int uNumUAVs,
+            ID3D11DepthStencilView*     pDSV,
+            ID3D11DepthStencilState*    pOutputDSS, unsigned int uStencilRef,
+            ID3D11BlendState *          pOutputBS,
+            ID3D11RasterizerState *     pOutputRS,
+            unsigned int                instanceCount);
+
         HRESULT RenderFullscreenAlignedQuads(
             ID3D11DeviceContext*       pDeviceContext,
             D3D11_VIEWPORT             Viewport,
@@ -0,0 +1,572 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include <string.h>
+
+#include "AMD_StateCache.h"
+
+namespace AMD
+{
+    // a slot the cache knows nothing about: it differs from anything a call sets, and as a
+    // shader resource it may conflict with any output
+    static const char           s_UnknownTag = 0;
+    static const void * const   UNKNOWN = &s_UnknownTag;
+
+    static ID3D11ShaderResourceView *  const s_NullSRV[STATE_CACHE_SRV_SLOT_COUNT] = { NULL };
+    static ID3D11RenderTargetView *    const s_NullRTV[STATE_CACHE_RTV_SLOT_COUNT] = { NULL };
+    static ID3D11UnorderedAccessView * const s_NullUAV[STATE_CACHE_UAV_SLOT_COUNT] = { NULL };
+
+    static const float s_DefaultBlendFactor[4] = { 1.0f, 1.0f, 1.0f, 1.0f }; // what D3D11 uses for a NULL blend factor
+
+    StateCache::StateCache()
+        : _pTarget(NULL)
+        , _enabled(true)
+    {
+        Invalidate();
+        ResetCounters();
+    }
+
+    void StateCache::Invalidate()
+    {
+        for (uint stage = 0; stage < STATE_CACHE_STAGE_COUNT; stage++)
+        {
+            _shader[stage] = UNKNOWN;
+            _srvEnd[stage] = STATE_CACHE_SRV_SLOT_COUNT;
+
+            for (uint slot = 0; slot < STATE_CACHE_SRV_SLOT_COUNT; slot++)
+            {
+                _srv[stage][slot] = UNKNOWN;
+                _srvResource[stage][slot] = UNKNOWN;
+            }
+            for (uint slot = 0; slot < STATE_CACHE_SAMPLER_SLOT_COUNT; slot++)
+            {
+                _sampler[stage][slot] = UNKNOWN;
+            }
+            for (uint slot = 0; slot < STATE_CACHE_CB_SLOT_COUNT; slot++)
+            {
+                _cb[stage][slot] = UNKNOWN;
+                _cbFirstConstant[stage][slot] = 0;
+                _cbConstantCount[stage][slot] = 0;
+            }
+        }
+
+        _outputKnown = false;
+        _rtvCount = 0;
+        _dsv = NULL;
+        _uavStart = 0;
+        _uavCount = 0;
+        _outputResourceCount = 0;
+
+        _inputLayout = UNKNOWN;
+        _blendState = UNKNOWN;
+        memset(_blendFactor, 0, sizeof(_blendFactor));
+        _sampleMask = 0;
+        _depthStencilState = UNKNOWN;
+        _stencilRef = 0;
+        _rasterizerState = UNKNOWN;
+        _viewportCount = STATE_CACHE_VIEWPORT_COUNT + 1;
+        _scissorCount = STATE_CACHE_VIEWPORT_COUNT + 1;
+    }
+
+    void StateCache::InvalidateShaderResources(STATE_CACHE_STAGE stage, uint start, uint count)
+    {
+        for (uint slot = start; slot < start + count && slot < STATE_CACHE_SRV_SLOT_COUNT; slot++)
+        {
+            _srv[stage][slot] = UNKNOWN;
+            _srvResource[stage][slot] = UNKNOWN;
+            _srvEnd[stage] = MAX(_srvEnd[stage], slot + 1);
+        }
+    }
+
+    void StateCache::ResetCounters()
+    {
+        memset(&_counters, 0, sizeof(_counters));
+    }
+
+    // counts the call; false if there is nothing to forward it to
+    bool StateCache::BeginCall()
+    {
+        _counters.calls++;
+        return _pTarget != NULL;
+    }
+
+    bool StateCache::ShaderChanged(STATE_CACHE_STAGE stage, const void * pShader)
+    {
+        if (BeginCall() == false)
+        {
+            return false;
+        }
+
+        if (_enabled == true && _shader[stage] == pShader)
+        {
+            _counters.avoided++;
+            return false;
+        }
+
+        _shader[stage] = pShader;
+        _counters.forwarded++;
+        return true;
+    }
+
+    // [first, end) is the part of the call that changes a slot; the rest is already bound
+    bool StateCache::SlotsChanged(const void ** pSlot, uint start, uint count, const void * const * ppValue, uint & first, uint & end)
+    {
+        first = count;
+        end = 0;
+
+        for (uint i = 0; i < count; i++)
+        {
+            if (_enabled == false || pSlot[start + i] != ppValue[i])
+            {
+                first = MIN(first, i);
+                end = i + 1;
+                pSlot[start + i] = ppValue[i];
+            }
+        }
+
+        if (end == 0)
+        {
+            _counters.avoided++;
+            return false;
+        }
+
+        _counters.forwarded++;
+        return true;
+    }
+
+    void StateCache::SetShader(ID3D11VertexShader * pShader)   { if (ShaderChanged(STATE_CACHE_STAGE_VS, pShader) == true) { _pTarget->SetShader(pShader); } }
+    void StateCache::SetShader(ID3D11HullShader * pShader)     { if (ShaderChanged(STATE_CACHE_STAGE_HS, pShader) == true) { _pTarget->SetShader(pShader); } }
+    void StateCache::SetShader(ID3D11DomainShader * pShader)   { if (ShaderChanged(STATE_CACHE_STAGE_DS, pShader) == true) { _pTarget->SetShader(pShader); } }
+    void StateCache::SetShader(ID3D11GeometryShader * pShader) { if (ShaderChanged(STATE_CACHE_STAGE_GS, pShader) == true) { _pTarget->SetShader(pShader); } }
+    void StateCache::SetShader(ID3D11PixelShader * pShader)    { if (ShaderChanged(STATE_CACHE_STAGE_PS, pShader) == true) { _pTarget->SetShader(pShader); } }
+    void StateCache::SetShader(ID3D11ComputeShader * pShader)  { if (ShaderChanged(STATE_CACHE_STAGE_CS, pShader) == true) { _pTarget->SetShader(pShader); } }
+
+    void StateCache::SetShaderResources(STATE_CACHE_STAGE stage, uint start, uint count, ID3D11ShaderResourceView * const * ppSRV)
+    {
+        if (BeginCall() == false || count == 0)
+        {
+            return;
+        }
+
+        if (start + count > STATE_CACHE_SRV_SLOT_COUNT)
+        {
+            _counters.forwarded++;
+            _pTarget->SetShaderResources(stage, start, count, ppSRV);
+            return;
+        }
+
+        uint first, end;
+        if (SlotsChanged(_srv[stage], start, count, (const void * const *)ppSRV, first, end) == false)
+        {
+            return;
+        }
+
+        // a resource still bound as an output would be bound as NULL by D3D11, so the outputs go first
+        bool conflict = false;
+        for (uint i = first; i < end; i++)
+        {
+            const void * pResource = ppSRV[i] != NULL ? _pTarget->GetResource(ppSRV[i]) : NULL;
+
+            _srvResource[stage][start + i] = pResource;
+            conflict = conflict || (pResource != NULL && IsOutput(pResource) == true);
+        }
+
+        if (conflict == true)
+        {
+            UnbindOutputs();
+        }
+
+        _pTarget->SetShaderResources(stage, start + first, end - first, ppSRV + first);
+
+        _srvEnd[stage] = MAX(_srvEnd[stage], start + end);
+        while (_srvEnd[stage] > 0 && _srv[stage][_srvEnd[stage] - 1] == NULL)
+        {
+            _srvEnd[stage]--;
+        }
+    }
+
+    void StateCache::SetSamplers(STATE_CACHE_STAGE stage, uint start, uint count, ID3D11SamplerState * const * ppSampler)
+    {
+        if (BeginCall() == false || count == 0)
+        {
+            return;
+        }
+
+        uint first, end;
+        if (start + count > STATE_CACHE_SAMPLER_SLOT_COUNT)
+        {
+            _counters.forwarded++;
+            _pTarget->SetSamplers(stage, start, count, ppSampler);
+        }
+        else if (SlotsChanged(_sampler[stage], start, count, (const void * const *)ppSampler, first, end) == true)
+        {
+            _pTarget->SetSamplers(stage, start + first, end - first, ppSampler + first);
+        }
+    }
+
+    void StateCache::SetConstantBuffers(STATE_CACHE_STAGE stage, uint start, uint count, ID3D11Buffer * const * ppCB)
+    {
+        SetConstantBufferRanges(stage, start, count, ppCB, NULL, NULL);
+    }
+
+    void StateCache::SetConstantBuffers(STATE_CACHE_STAGE stage, uint start, uint count, ID3D11Buffer * const * ppCB,
+                                        const uint * pFirstConstant, const uint * pConstantCount)
+    {
+        SetConstantBufferRanges(stage, start, count, ppCB, pFirstConstant, pConstantCount);
+    }
+
+    // without pFirstConstant the whole buffers are bound; a slot changes with its buffer or its range
+    void StateCache::SetConstantBufferRanges(STATE_CACHE_STAGE stage, uint start, uint count, ID3D11Buffer * const * ppCB,
+                                             const uint * pFirstConstant, const uint * pConstantCount)
+    {
+        if (BeginCall() == false || count == 0)
+        {
+            return;
+        }
+
+        uint first = 0, end = count;
+        if (start + count <= STATE_CACHE_CB_SLOT_COUNT)
+        {
+            first = count;
+            end = 0;
+
+            for (uint i = 0; i < count; i++)
+            {
+                const uint firstConstant = pFirstConstant != NULL ? pFirstConstant[i] : 0;
+                const uint constantCount = pFirstConstant != NULL ? pConstantCount[i] : 0;
+
+                if (_enabled == false || _cb[stage][start + i] != ppCB[i] ||
+                    _cbFirstConstant[stage][start + i] != firstConstant || _cbConstantCount[stage][start + i] != constantCount)
+                {
+                    first = MIN(first, i);
+                    end = i + 1;
+                    _cb[stage][start + i] = ppCB[i];
+                    _cbFirstConstant[stage][start + i] = firstConstant;
+                    _cbConstantCount[stage][start + i] = constantCount;
+                }
+            }
+
+            if (end == 0)
+            {
+                _counters.avoided++;
+                return;
+            }
+        }
+
+        _counters.forwarded++;
+        if (pFirstConstant != NULL)
+        {
+            _pTarget->SetConstantBuffers(stage, start + first, end - first, ppCB + first, pFirstConstant + first, pConstantCount + first);
+        }
+        else
+        {
+            _pTarget->SetConstantBuffers(stage, start + first, end - first, ppCB + first);
+        }
+    }
+
+    void StateCache::SetRenderTargets(uint rtvCount, ID3D11RenderTargetView * const * ppRTV, ID3D11DepthStencilView * pDSV)
+    {
+        SetRenderTargetsAndUnorderedAccessViews(rtvCount, ppRTV, pDSV, rtvCount, 0, NULL);
+    }
+
+    void StateCache::SetRenderTargetsAndUnorderedAccessViews(uint rtvCount, ID3D11RenderTargetView * const * ppRTV, ID3D11DepthStencilView * pDSV,
+                                                             uint uavStart, uint uavCount, ID3D11UnorderedAccessView * const * ppUAV)
+    {
+        if (BeginCall() == false)
+        {
+            return;
+        }
+
+        if (rtvCount > STATE_CACHE_RTV_SLOT_COUNT || uavStart + uavCount > STATE_CACHE_UAV_SLOT_COUNT)
+        {
+            _counters.forwarded++;
+            _pTarget->SetOutputs(rtvCount, ppRTV, pDSV, uavStart, uavCount, ppUAV);
+            _outputKnown = false;
+            return;
+        }
+
+        bool same = _enabled == true && _outputKnown == true && _rtvCount == rtvCount && _dsv == pDSV && _uavStart == uavStart && _uavCount == uavCount;
+        for (uint i = 0; same == true && i < rtvCount; i++)
+        {
+            same = _rtv[i] == ppRTV[i];
+        }
+        for (uint i = 0; same == true && i < uavCount; i++)
+        {
+            same = _uav[i] == ppUAV[i];
+        }
+
+        if (same == true)
+        {
+            _counters.avoided++;
+            return;
+        }
+
+        _outputKnown = true;
+        _rtvCount = rtvCount;
+        _dsv = pDSV;
+        _uavStart = uavStart;
+        _uavCount = uavCount;
+        _outputResourceCount = 0;
+
+        for (uint i = 0; i < rtvCount; i++)
+        {
+            _rtv[i] = ppRTV[i];
+            if (ppRTV[i] != NULL)
+            {
+                _outputResource[_outputResourceCount++] = _pTarget->GetResource(ppRTV[i]);
+            }
+        }
+        if (pDSV != NULL) // a read-only DSV may be read at the same time, the cache unbinds it anyway
+        {
+            _outputResource[_outputResourceCount++] = _pTarget->GetResource(pDSV);
+        }
+        for (uint i = 0; i < uavCount; i++)
+        {
+            _uav[i] = ppUAV[i];
+            if (ppUAV[i] != NULL)
+            {
+                _outputResource[_outputResourceCount++] = _pTarget->GetResource(ppUAV[i]);
+            }
+        }
+
+        UnbindConflictingShaderResources();
+
+        _counters.forwarded++;
+        _pTarget->SetOutputs(rtvCount, ppRTV, pDSV, uavStart, uavCount, ppUAV);
+    }
+
+    void StateCache::SetInputLayout(ID3D11InputLayout * pInputLayout)
+    {
+        if (BeginCall() == false)
+        {
+            return;
+        }
+
+        if (_enabled == true && _inputLayout == pInputLayout)
+        {
+            _counters.avoided++;
+            return;
+        }
+
+        _inputLayout = pInputLayout;
+        _counters.forwarded++;
+        _pTarget->SetInputLayout(pInputLayout);
+    }
+
+    void StateCache::SetBlendState(ID3D11BlendState * pBlendState, const float blendFactor[4], uint sampleMask)
+    {
+        if (BeginCall() == false)
+        {
+            return;
+        }
+
+        const float * pFactor = blendFactor != NULL ? blendFactor : s_DefaultBlendFactor;
+
+        if (_enabled == true && _blendState == pBlendState && _sampleMask == sampleMask && memcmp(_blendFactor, pFactor, sizeof(_blendFactor)) == 0)
+        {
+            _counters.avoided++;
+            return;
+        }
+
+        _blendState = pBlendState;
+        _sampleMask = sampleMask;
+        memcpy(_blendFactor, pFactor, sizeof(_blendFactor));
+        _counters.forwarded++;
+        _pTarget->SetBlendState(pBlendState, blendFactor, sampleMask);
+    }
+
+    void StateCache::SetDepthStencilState(ID3D11DepthStencilState * pDepthStencilState, uint stencilRef)
+    {
+        if (BeginCall() == false)
+        {
+            return;
+        }
+
+        if (_enabled == true && _depthStencilState == pDepthStencilState && _stencilRef == stencilRef)
+        {
+            _counters.avoided++;
+            return;
+        }
+
+        _depthStencilState = pDepthStencilState;
+        _stencilRef = stencilRef;
+        _counters.forwarded++;
+        _pTarget->SetDepthStencilState(pDepthStencilState, stencilRef);
+    }
+
+    void StateCache::SetRasterizerState(ID3D11RasterizerState * pRasterizerState)
+    {
+        if (BeginCall() == false)
+        {
+            return;
+        }
+
+        if (_enabled == true && _rasterizerState == pRasterizerState)
+        {
+            _counters.avoided++;
+            return;
+        }
+
+        _rasterizerState = pRasterizerState;
+        _counters.forwarded++;
+        _pTarget->SetRasterizerState(pRasterizerState);
+    }
+
+    void StateCache::SetViewports(uint count, const StateViewport * pViewports)
+    {
+        if (BeginCall() == false)
+        {
+            return;
+        }
+
+        if (_enabled == true && _viewportCount == count && (count == 0 || memcmp(_viewport, pViewports, count * sizeof(StateViewport)) == 0))
+        {
+            _counters.avoided++;
+            return;
+        }
+
+        if (count <= STATE_CACHE_VIEWPORT_COUNT)
+        {
+            _viewportCount = count;
+            memcpy(_viewport, pViewports, count * sizeof(StateViewport));
+        }
+        else
+        {
+            _viewportCount = STATE_CACHE_VIEWPORT_COUNT + 1;
+        }
+        _counters.forwarded++;
+        _pTarget->SetViewports(count, pViewports);
+    }
+
+    void StateCache::SetScissorRects(uint count, const StateRect * pRects)
+    {
+        if (BeginCall() == false)
+        {
+            return;
+        }
+
+        if (_enabled == true && _scissorCount == count && (count == 0 || memcmp(_scissor, pRects, count * sizeof(StateRect)) == 0))
+        {
+            _counters.avoided++;
+            return;
+        }
+
+        if (count <= STATE_CACHE_VIEWPORT_COUNT)
+        {
+            _scissorCount = count;
+            memcpy(_scissor, pRects, count * sizeof(StateRect));
+        }
+        else
+        {
+            _scissorCount = STATE_CACHE_VIEWPORT_COUNT + 1;
+        }
+        _counters.forwarded++;
+        _pTarget->SetScissorRects(count, pRects);
+    }
+
+    bool StateCache::IsOutput(const void * pResource) const
+    {
+        if (_outputKnown == false)
+        {
+            return true;
+        }
+
+        for (uint i = 0; i < _outputResourceCount; i++)
+        {
+            if (_outputResource[i] == pResource)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool StateCache::ConflictsWithOutputs(STATE_CACHE_STAGE stage, uint slot) const
+    {
+        const void * pResource = _srvResource[stage][slot];
+
+        if (_srv[stage][slot] == NULL || pResource == NULL)
+        {
+            return false;
+        }
+
+        return pResource == UNKNOWN || IsOutput(pResource) == true;
+    }
+
+    void StateCache::UnbindOutputs()
+    {
+        // outputs the cache doesn't know may include UAVs as well
+        const uint uavCount = _outputKnown ? _uavCount : STATE_CACHE_UAV_SLOT_COUNT;
+        const uint uavStart = _outputKnown ? _uavStart : 0;
+
+        _counters.forwarded++;
+        _counters.unbinds++;
+        _pTarget->SetOutputs(0, s_NullRTV, NULL, uavStart, uavCount, s_NullUAV);
+
+        _outputKnown = true;
+        _rtvCount = 0;
+        _dsv = NULL;
+        _uavStart = 0;
+        _uavCount = 0;
+        _outputResourceCount = 0;
+    }
+
+    // unbinds the runs of shader resource slots that conflict with the outputs being bound;
+    // a stage the cache knows nothing about is unbound as a whole
+    void StateCache::UnbindConflictingShaderResources()
+    {
+        for (uint stage = 0; stage < STATE_CACHE_STAGE_COUNT; stage++)
+        {
+            uint slot = 0;
+            while (slot < _srvEnd[stage])
+            {
+                if (ConflictsWithOutputs((STATE_CACHE_STAGE)stage, slot) == false)
+                {
+                    slot++;
+                    continue;
+                }
+
+                uint end = slot + 1;
+                while (end < _srvEnd[stage] && ConflictsWithOutputs((STATE_CACHE_STAGE)stage, end) == true)
+                {
+                    end++;
+                }
+
+                _counters.forwarded++;
+                _counters.unbinds++;
+                _pTarget->SetShaderResources((STATE_CACHE_STAGE)stage, slot, end - slot, s_NullSRV);
+
+                for (uint i = slot; i < end; i++)
+                {
+                    _srv[stage][i] = NULL;
+                    _srvResource[stage][i] = NULL;
+                }
+                slot = end;
+            }
+
+            while (_srvEnd[stage] > 0 && _srv[stage][_srvEnd[stage] - 1] == NULL)
+            {
+                _srvEnd[stage]--;
+            }
+        }
+    }
+}
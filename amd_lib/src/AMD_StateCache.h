@@ -0,0 +1,235 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef AMD_LIB_STATE_CACHE_H
+#define AMD_LIB_STATE_CACHE_H
+
+#include "AMD_Types.h"
+
+// Only pointers to these go through the cache, so it builds without d3d11.h and can be
+// checked against a recording target on any platform (see tools/StateCache)
+struct ID3D11Resource;
+struct ID3D11ShaderResourceView;
+struct ID3D11RenderTargetView;
+struct ID3D11DepthStencilView;
+struct ID3D11UnorderedAccessView;
+struct ID3D11SamplerState;
+struct ID3D11Buffer;
+struct ID3D11InputLayout;
+struct ID3D11BlendState;
+struct ID3D11DepthStencilState;
+struct ID3D11RasterizerState;
+struct ID3D11VertexShader;
+struct ID3D11HullShader;
+struct ID3D11DomainShader;
+struct ID3D11GeometryShader;
+struct ID3D11PixelShader;
+struct ID3D11ComputeShader;
+
+namespace AMD
+{
+    enum STATE_CACHE_STAGE
+    {
+        STATE_CACHE_STAGE_VS,
+        STATE_CACHE_STAGE_HS,
+        STATE_CACHE_STAGE_DS,
+        STATE_CACHE_STAGE_GS,
+        STATE_CACHE_STAGE_PS,
+        STATE_CACHE_STAGE_CS,
+        STATE_CACHE_STAGE_COUNT
+    };
+
+    // the D3D11 slot counts
+    const uint STATE_CACHE_SRV_SLOT_COUNT      = 128;
+    const uint STATE_CACHE_SAMPLER_SLOT_COUNT  = 16;
+    const uint STATE_CACHE_CB_SLOT_COUNT       = 14;
+    const uint STATE_CACHE_RTV_SLOT_COUNT      = 8;
+    const uint STATE_CACHE_UAV_SLOT_COUNT      = 8;
+    const uint STATE_CACHE_VIEWPORT_COUNT      = 16;
+
+    // same layout as D3D11_VIEWPORT
+    struct StateViewport
+    {
+        float TopLeftX;
+        float TopLeftY;
+        float Width;
+        float Height;
+        float MinDepth;
+        float MaxDepth;
+    };
+
+    // same layout as D3D11_RECT
+    struct StateRect
+    {
+        int left;
+        int top;
+        int right;
+        int bottom;
+    };
+
+    // Where the cache sends the calls it doesn't drop: a device context in the sample (see
+    // StateCacheD3D11), a recording mock in tools/StateCache
+    class StateCacheTarget
+    {
+    public:
+        virtual ~StateCacheTarget() {}
+
+        virtual void SetShader(ID3D11VertexShader * pShader) = 0;
+        virtual void SetShader(ID3D11HullShader * pShader) = 0;
+        virtual void SetShader(ID3D11DomainShader * pShader) = 0;
+        virtual void SetShader(ID3D11GeometryShader * pShader) = 0;
+        virtual void SetShader(ID3D11PixelShader * pShader) = 0;
+        virtual void SetShader(ID3D11ComputeShader * pShader) = 0;
+
+        virtual void SetShaderResources(STATE_CACHE_STAGE stage, uint start, uint count, ID3D11ShaderResourceView * const * ppSRV) = 0;
+        virtual void SetSamplers(STATE_CACHE_STAGE stage, uint start, uint count, ID3D11SamplerState * const * ppSampler) = 0;
+        virtual void SetConstantBuffers(STATE_CACHE_STAGE stage, uint start, uint count, ID3D11Buffer * const * ppCB) = 0;
+
+        // a range of each buffer, in 16 byte constants, like the D3D11.1 SetConstantBuffers1
+        virtual void SetConstantBuffers(STATE_CACHE_STAGE stage, uint start, uint count, ID3D11Buffer * const * ppCB,
+                                        const uint * pFirstConstant, const uint * pConstantCount) = 0;
+
+        // uavCount == 0 leaves the UAVs to the render targets call, like OMSetRenderTargets
+        virtual void SetOutputs(uint rtvCount, ID3D11RenderTargetView * const * ppRTV, ID3D11DepthStencilView * pDSV,
+                                uint uavStart, uint uavCount, ID3D11UnorderedAccessView * const * ppUAV) = 0;
+
+        virtual void SetInputLayout(ID3D11InputLayout * pInputLayout) = 0;
+        virtual void SetBlendState(ID3D11BlendState * pBlendState, const float blendFactor[4], uint sampleMask) = 0;
+        virtual void SetDepthStencilState(ID3D11DepthStencilState * pDepthStencilState, uint stencilRef) = 0;
+        virtual void SetRasterizerState(ID3D11RasterizerState * pRasterizerState) = 0;
+        virtual void SetViewports(uint count, const StateViewport * pViewports) = 0;
+        virtual void SetScissorRects(uint count, const StateRect * pRects) = 0;
+
+        // the resource of a view, to find the inputs and outputs that conflict
+        virtual ID3D11Resource * GetResource(ID3D11ShaderResourceView * pView) = 0;
+        virtual ID3D11Resource * GetResource(ID3D11RenderTargetView * pView) = 0;
+        virtual ID3D11Resource * GetResource(ID3D11DepthStencilView * pView) = 0;
+        virtual ID3D11Resource * GetResource(ID3D11UnorderedAccessView * pView) = 0;
+    };
+
+    struct StateCacheCounters
+    {
+        uint64 calls;       // Set calls made to the cache
+        uint64 forwarded;   // calls made to the target, the unbinds included
+        uint64 avoided;     // calls dropped, everything they set was already set
+        uint64 unbinds;     // calls made to unbind the inputs or the outputs that conflict
+    };
+
+    // Keeps what is bound to a context and only forwards the calls that change it. Instead of
+    // unbinding every render target and shader resource before a pass, it unbinds the shader
+    // resources whose resource is about to be an output, and the outputs whose resource is
+    // about to be a shader resource. What the cache doesn't see (a library or a draw helper
+    // binding through the context itself) must be reported with Invalidate.
+    class StateCache
+    {
+    public:
+        StateCache();
+
+        void                        SetTarget(StateCacheTarget * pTarget) { _pTarget = pTarget; Invalidate(); }
+
+        // disabled, every call is forwarded; the cache still tracks what is bound, so that
+        // shader resources and outputs that conflict are unbound as before
+        void                        SetEnabled(bool enabled) { _enabled = enabled; Invalidate(); }
+        bool                        IsEnabled() const { return _enabled; }
+
+        // forgets everything that is bound; the next calls are all forwarded
+        void                        Invalidate();
+        void                        InvalidateShaderResources(STATE_CACHE_STAGE stage, uint start, uint count);
+
+        void                        SetShader(ID3D11VertexShader * pShader);
+        void                        SetShader(ID3D11HullShader * pShader);
+        void                        SetShader(ID3D11DomainShader * pShader);
+        void                        SetShader(ID3D11GeometryShader * pShader);
+        void                        SetShader(ID3D11PixelShader * pShader);
+        void                        SetShader(ID3D11ComputeShader * pShader);
+
+        void                        SetShaderResources(STATE_CACHE_STAGE stage, uint start, uint count, ID3D11ShaderResourceView * const * ppSRV);
+        void                        SetSamplers(STATE_CACHE_STAGE stage, uint start, uint count, ID3D11SamplerState * const * ppSampler);
+        void                        SetConstantBuffers(STATE_CACHE_STAGE stage, uint start, uint count, ID3D11Buffer * const * ppCB);
+        void                        SetConstantBuffers(STATE_CACHE_STAGE stage, uint start, uint count, ID3D11Buffer * const * ppCB,
+                                                       const uint * pFirstConstant, const uint * pConstantCount);
+
+        void                        SetRenderTargets(uint rtvCount, ID3D11RenderTargetView * const * ppRTV, ID3D11DepthStencilView * pDSV);
+        void                        SetRenderTargetsAndUnorderedAccessViews(uint rtvCount, ID3D11RenderTargetView * const * ppRTV, ID3D11DepthStencilView * pDSV,
+                                                                            uint uavStart, uint uavCount, ID3D11UnorderedAccessView * const * ppUAV);
+
+        void                        SetInputLayout(ID3D11InputLayout * pInputLayout);
+        void                        SetBlendState(ID3D11BlendState * pBlendState, const float blendFactor[4], uint sampleMask);
+        void                        SetDepthStencilState(ID3D11DepthStencilState * pDepthStencilState, uint stencilRef);
+        void                        SetRasterizerState(ID3D11RasterizerState * pRasterizerState);
+        void                        SetViewports(uint count, const StateViewport * pViewports);
+        void                        SetScissorRects(uint count, const StateRect * pRects);
+
+        const StateCacheCounters &  GetCounters() const { return _counters; }
+        void                        ResetCounters();
+
+    private:
+        bool                        BeginCall();
+        bool                        ShaderChanged(STATE_CACHE_STAGE stage, const void * pShader);
+        bool                        SlotsChanged(const void ** pSlot, uint start, uint count, const void * const * ppValue, uint & first, uint & end);
+        void                        SetConstantBufferRanges(STATE_CACHE_STAGE stage, uint start, uint count, ID3D11Buffer * const * ppCB,
+                                                            const uint * pFirstConstant, const uint * pConstantCount);
+
+        bool                        IsOutput(const void * pResource) const;
+        bool                        ConflictsWithOutputs(STATE_CACHE_STAGE stage, uint slot) const;
+        void                        UnbindOutputs();
+        void                        UnbindConflictingShaderResources();
+
+        StateCacheTarget *          _pTarget;
+        bool                        _enabled;
+
+        const void *                _shader[STATE_CACHE_STAGE_COUNT];
+        const void *                _srv[STATE_CACHE_STAGE_COUNT][STATE_CACHE_SRV_SLOT_COUNT];
+        const void *                _srvResource[STATE_CACHE_STAGE_COUNT][STATE_CACHE_SRV_SLOT_COUNT];
+        uint                        _srvEnd[STATE_CACHE_STAGE_COUNT];    // slots from here on are NULL
+        const void *                _sampler[STATE_CACHE_STAGE_COUNT][STATE_CACHE_SAMPLER_SLOT_COUNT];
+        const void *                _cb[STATE_CACHE_STAGE_COUNT][STATE_CACHE_CB_SLOT_COUNT];
+        uint                        _cbFirstConstant[STATE_CACHE_STAGE_COUNT][STATE_CACHE_CB_SLOT_COUNT];
+        uint                        _cbConstantCount[STATE_CACHE_STAGE_COUNT][STATE_CACHE_CB_SLOT_COUNT]; // 0 for the whole buffer
+
+        bool                        _outputKnown;
+        uint                        _rtvCount;
+        const void *                _rtv[STATE_CACHE_RTV_SLOT_COUNT];
+        const void *                _dsv;
+        uint                        _uavStart;
+        uint                        _uavCount;
+        const void *                _uav[STATE_CACHE_UAV_SLOT_COUNT];
+        uint                        _outputResourceCount;
+        const void *                _outputResource[STATE_CACHE_RTV_SLOT_COUNT + 1 + STATE_CACHE_UAV_SLOT_COUNT];
+
+        const void *                _inputLayout;
+        const void *                _blendState;
+        float                       _blendFactor[4];
+        uint                        _sampleMask;
+        const void *                _depthStencilState;
+        uint                        _stencilRef;
+        const void *                _rasterizerState;
+        uint                        _viewportCount;                      // STATE_CACHE_VIEWPORT_COUNT + 1 if unknown
+        StateViewport               _viewport[STATE_CACHE_VIEWPORT_COUNT];
+        uint                        _scissorCount;                       // STATE_CACHE_VIEWPORT_COUNT + 1 if unknown
+        StateRect                   _scissor[STATE_CACHE_VIEWPORT_COUNT];
+
+        StateCacheCounters          _counters;
+    };
+}
+
+#endif //AMD_LIB_STATE_CACHE_H
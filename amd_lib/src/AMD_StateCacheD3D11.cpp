@@ -0,0 +1,178 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#include "AMD_StateCacheD3D11.h"
+
+namespace AMD
+{
+    static_assert(sizeof(StateViewport) == sizeof(D3D11_VIEWPORT), "StateViewport must have the layout of D3D11_VIEWPORT");
+    static_assert(sizeof(StateRect) == sizeof(D3D11_RECT), "StateRect must have the layout of D3D11_RECT");
+    static_assert(STATE_CACHE_SRV_SLOT_COUNT == D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT, "SRV slot count");
+    static_assert(STATE_CACHE_SAMPLER_SLOT_COUNT == D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT, "sampler slot count");
+    static_assert(STATE_CACHE_CB_SLOT_COUNT == D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT, "constant buffer slot count");
+    static_assert(STATE_CACHE_RTV_SLOT_COUNT == D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT, "render target slot count");
+    static_assert(STATE_CACHE_UAV_SLOT_COUNT == D3D11_PS_CS_UAV_REGISTER_COUNT, "UAV slot count");
+    static_assert(STATE_CACHE_VIEWPORT_COUNT == D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE, "viewport count");
+
+    // the view holds a reference to its resource, so the pointer stays valid as long as the view is bound
+    template <class VIEW>
+    static ID3D11Resource * GetViewResource(VIEW * pView)
+    {
+        ID3D11Resource * pResource = NULL;
+        pView->GetResource(&pResource);
+        if (pResource != NULL)
+        {
+            pResource->Release();
+        }
+        return pResource;
+    }
+
+    void StateCacheD3D11::SetContext(ID3D11DeviceContext * pContext)
+    {
+        _pContext = pContext;
+        _pContext1 = NULL;
+
+        // the interface lives as long as the context, so the reference QueryInterface added is dropped
+        if (pContext != NULL && SUCCEEDED(pContext->QueryInterface(__uuidof(ID3D11DeviceContext1), (void **)&_pContext1)))
+        {
+            _pContext1->Release();
+        }
+    }
+
+    void StateCacheD3D11::SetShader(ID3D11VertexShader * pShader)   { _pContext->VSSetShader(pShader, NULL, 0); }
+    void StateCacheD3D11::SetShader(ID3D11HullShader * pShader)     { _pContext->HSSetShader(pShader, NULL, 0); }
+    void StateCacheD3D11::SetShader(ID3D11DomainShader * pShader)   { _pContext->DSSetShader(pShader, NULL, 0); }
+    void StateCacheD3D11::SetShader(ID3D11GeometryShader * pShader) { _pContext->GSSetShader(pShader, NULL, 0); }
+    void StateCacheD3D11::SetShader(ID3D11PixelShader * pShader)    { _pContext->PSSetShader(pShader, NULL, 0); }
+    void StateCacheD3D11::SetShader(ID3D11ComputeShader * pShader)  { _pContext->CSSetShader(pShader, NULL, 0); }
+
+    void StateCacheD3D11::SetShaderResources(STATE_CACHE_STAGE stage, uint start, uint count, ID3D11ShaderResourceView * const * ppSRV)
+    {
+        switch (stage)
+        {
+        case STATE_CACHE_STAGE_VS: _pContext->VSSetShaderResources(start, count, ppSRV); break;
+        case STATE_CACHE_STAGE_HS: _pContext->HSSetShaderResources(start, count, ppSRV); break;
+        case STATE_CACHE_STAGE_DS: _pContext->DSSetShaderResources(start, count, ppSRV); break;
+        case STATE_CACHE_STAGE_GS: _pContext->GSSetShaderResources(start, count, ppSRV); break;
+        case STATE_CACHE_STAGE_PS: _pContext->PSSetShaderResources(start, count, ppSRV); break;
+        case STATE_CACHE_STAGE_CS: _pContext->CSSetShaderResources(start, count, ppSRV); break;
+        default: break;
+        }
+    }
+
+    void StateCacheD3D11::SetSamplers(STATE_CACHE_STAGE stage, uint start, uint count, ID3D11SamplerState * const * ppSampler)
+    {
+        switch (stage)
+        {
+        case STATE_CACHE_STAGE_VS: _pContext->VSSetSamplers(start, count, ppSampler); break;
+        case STATE_CACHE_STAGE_HS: _pContext->HSSetSamplers(start, count, ppSampler); break;
+        case STATE_CACHE_STAGE_DS: _pContext->DSSetSamplers(start, count, ppSampler); break;
+        case STATE_CACHE_STAGE_GS: _pContext->GSSetSamplers(start, count, ppSampler); break;
+        case STATE_CACHE_STAGE_PS: _pContext->PSSetSamplers(start, count, ppSampler); break;
+        case STATE_CACHE_STAGE_CS: _pContext->CSSetSamplers(start, count, ppSampler); break;
+        default: break;
+        }
+    }
+
+    void StateCacheD3D11::SetConstantBuffers(STATE_CACHE_STAGE stage, uint start, uint count, ID3D11Buffer * const * ppCB)
+    {
+        switch (stage)
+        {
+        case STATE_CACHE_STAGE_VS: _pContext->VSSetConstantBuffers(start, count, ppCB); break;
+        case STATE_CACHE_STAGE_HS: _pContext->HSSetConstantBuffers(start, count, ppCB); break;
+        case STATE_CACHE_STAGE_DS: _pContext->DSSetConstantBuffers(start, count, ppCB); break;
+        case STATE_CACHE_STAGE_GS: _pContext->GSSetConstantBuffers(start, count, ppCB); break;
+        case STATE_CACHE_STAGE_PS: _pContext->PSSetConstantBuffers(start, count, ppCB); break;
+        case STATE_CACHE_STAGE_CS: _pContext->CSSetConstantBuffers(start, count, ppCB); break;
+        default: break;
+        }
+    }
+
+    void StateCacheD3D11::SetConstantBuffers(STATE_CACHE_STAGE stage, uint start, uint count, ID3D11Buffer * const * ppCB,
+                                             const uint * pFirstConstant, const uint * pConstantCount)
+    {
+        if (_pContext1 == NULL)
+        {
+            SetConstantBuffers(stage, start, count, ppCB);
+            return;
+        }
+
+        switch (stage)
+        {
+        case STATE_CACHE_STAGE_VS: _pContext1->VSSetConstantBuffers1(start, count, ppCB, pFirstConstant, pConstantCount); break;
+        case STATE_CACHE_STAGE_HS: _pContext1->HSSetConstantBuffers1(start, count, ppCB, pFirstConstant, pConstantCount); break;
+        case STATE_CACHE_STAGE_DS: _pContext1->DSSetConstantBuffers1(start, count, ppCB, pFirstConstant, pConstantCount); break;
+        case STATE_CACHE_STAGE_GS: _pContext1->GSSetConstantBuffers1(start, count, ppCB, pFirstConstant, pConstantCount); break;
+        case STATE_CACHE_STAGE_PS: _pContext1->PSSetConstantBuffers1(start, count, ppCB, pFirstConstant, pConstantCount); break;
+        case STATE_CACHE_STAGE_CS: _pContext1->CSSetConstantBuffers1(start, count, ppCB, pFirstConstant, pConstantCount); break;
+        default: break;
+        }
+    }
+
+    void StateCacheD3D11::SetOutputs(uint rtvCount, ID3D11RenderTargetView * const * ppRTV, ID3D11DepthStencilView * pDSV,
+                                     uint uavStart, uint uavCount, ID3D11UnorderedAccessView * const * ppUAV)
+    {
+        if (uavCount == 0)
+        {
+            _pContext->OMSetRenderTargets(rtvCount, ppRTV, pDSV);
+        }
+        else
+        {
+            _pContext->OMSetRenderTargetsAndUnorderedAccessViews(rtvCount, ppRTV, pDSV, uavStart, uavCount, ppUAV, NULL);
+        }
+    }
+
+    void StateCacheD3D11::SetInputLayout(ID3D11InputLayout * pInputLayout)
+    {
+        _pContext->IASetInputLayout(pInputLayout);
+    }
+
+    void StateCacheD3D11::SetBlendState(ID3D11BlendState * pBlendState, const float blendFactor[4], uint sampleMask)
+    {
+        _pContext->OMSetBlendState(pBlendState, blendFactor, sampleMask);
+    }
+
+    void StateCacheD3D11::SetDepthStencilState(ID3D11DepthStencilState * pDepthStencilState, uint stencilRef)
+    {
+        _pContext->OMSetDepthStencilState(pDepthStencilState, stencilRef);
+    }
+
+    void StateCacheD3D11::SetRasterizerState(ID3D11RasterizerState * pRasterizerState)
+    {
+        _pContext->RSSetState(pRasterizerState);
+    }
+
+    void StateCacheD3D11::SetViewports(uint count, const StateViewport * pViewports)
+    {
+        _pContext->RSSetViewports(count, (const D3D11_VIEWPORT *)pViewports);
+    }
+
+    void StateCacheD3D11::SetScissorRects(uint count, const StateRect * pRects)
+    {
+        _pContext->RSSetScissorRects(count, (const D3D11_RECT *)pRects);
+    }
+
+    ID3D11Resource * StateCacheD3D11::GetResource(ID3D11ShaderResourceView * pView)  { return GetViewResource(pView); }
+    ID3D11Resource * StateCacheD3D11::GetResource(ID3D11RenderTargetView * pView)    { return GetViewResource(pView); }
+    ID3D11Resource * StateCacheD3D11::GetResource(ID3D11DepthStencilView * pView)    { return GetViewResource(pView); }
+    ID3D11Resource * StateCacheD3D11::GetResource(ID3D11UnorderedAccessView * pView) { return GetViewResource(pView); }
+}
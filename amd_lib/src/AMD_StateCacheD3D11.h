@@ -0,0 +1,78 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+#ifndef AMD_LIB_STATE_CACHE_D3D11_H
+#define AMD_LIB_STATE_CACHE_D3D11_H
+
+#include <d3d11_1.h>
+
+#include "AMD_StateCache.h"
+
+namespace AMD
+{
+    // forwards what a StateCache doesn't drop to a D3D11 device context
+    class StateCacheD3D11 : public StateCacheTarget
+    {
+    public:
+        StateCacheD3D11() : _pContext(NULL), _pContext1(NULL) {}
+
+        void                    SetContext(ID3D11DeviceContext * pContext);
+        ID3D11DeviceContext *   GetContext() const { return _pContext; }
+
+        // D3D11.1 binds a range of a constant buffer; without it a range binds the whole buffer
+        bool                    SupportsConstantBufferRanges() const { return _pContext1 != NULL; }
+
+        virtual void SetShader(ID3D11VertexShader * pShader);
+        virtual void SetShader(ID3D11HullShader * pShader);
+        virtual void SetShader(ID3D11DomainShader * pShader);
+        virtual void SetShader(ID3D11GeometryShader * pShader);
+        virtual void SetShader(ID3D11PixelShader * pShader);
+        virtual void SetShader(ID3D11ComputeShader * pShader);
+
+        virtual void SetShaderResources(STATE_CACHE_STAGE stage, uint start, uint count, ID3D11ShaderResourceView * const * ppSRV);
+        virtual void SetSamplers(STATE_CACHE_STAGE stage, uint start, uint count, ID3D11SamplerState * const * ppSampler);
+        virtual void SetConstantBuffers(STATE_CACHE_STAGE stage, uint start, uint count, ID3D11Buffer * const * ppCB);
+        virtual void SetConstantBuffers(STATE_CACHE_STAGE stage, uint start, uint count, ID3D11Buffer * const * ppCB,
+                                        const uint * pFirstConstant, const uint * pConstantCount);
+
+        virtual void SetOutputs(uint rtvCount, ID3D11RenderTargetView * const * ppRTV, ID3D11DepthStencilView * pDSV,
+                                uint uavStart, uint uavCount, ID3D11UnorderedAccessView * const * ppUAV);
+
+        virtual void SetInputLayout(ID3D11InputLayout * pInputLayout);
+        virtual void SetBlendState(ID3D11BlendState * pBlendState, const float blendFactor[4], uint sampleMask);
+        virtual void SetDepthStencilState(ID3D11DepthStencilState * pDepthStencilState, uint stencilRef);
+        virtual void SetRasterizerState(ID3D11RasterizerState * pRasterizerState);
+        virtual void SetViewports(uint count, const StateViewport * pViewports);
+        virtual void SetScissorRects(uint count, const StateRect * pRects);
+
+        virtual ID3D11Resource * GetResource(ID3D11ShaderResourceView * pView);
+        virtual ID3D11Resource * GetResource(ID3D11RenderTargetView * pView);
+        virtual ID3D11Resource * GetResource(ID3D11DepthStencilView * pView);
+        virtual ID3D11Resource * GetResource(ID3D11UnorderedAccessView * pView);
+
+    private:
+        ID3D11DeviceContext *   _pContext;
+        ID3D11DeviceContext1 *  _pContext1;     // the same context, not referenced
+    };
+}
+
+#endif //AMD_LIB_STATE_CACHE_D3D11_H
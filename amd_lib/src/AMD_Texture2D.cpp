@@ -66,6 +66,8 @@ namespace AMD
         _mips = 0;
         _sample = 0;
 
+        _dirty.Release();
+
         for (int i = 0; i < 6; i++)
         {
             AMD_SAFE_RELEASE(_rtv_cube[i]);
@@ -150,6 +152,8 @@ namespace AMD
                 _array = uArraySize;
                 _mips = uMipLevels;
                 _sample = uSampleCount;
+
+                _dirty.Init(uWidth, uHeight, uArraySize);
             }
 
             if (DXGI_FORMAT_UNKNOWN != SRV_Format)
@@ -25,6 +25,8 @@
 
 #include <d3d11.h>
 
+#include "AMD_DirtyRegions.h"
+
 // forward declarations
 struct AGSContext;
 
@@ -49,6 +51,8 @@ namespace AMD
         unsigned int                _mips;
         unsigned int                _sample;
 
+        DirtyRegions                _dirty; // regions written since the last transfer, see NotifyResourceEndWrites
+
         Texture2D();
         ~Texture2D();
 
@@ -22,6 +22,9 @@
 
 #include "AMD_LIB.h"
 
+#include "AMD_UnitCube.h"
+#include "AMD_StateCache.h"
+
 #include "Shaders\inc\VS_UNIT_CUBE.inc"
 #include "Shaders\inc\VS_CLIP_SPACE_CUBE.inc"
 #include "Shaders\inc\PS_UNIT_CUBE.inc"
@@ -159,4 +162,81 @@ namespace AMD
 
         return S_OK;
     }
+
+    HRESULT RenderUnitCube(StateCache &                 stateCache,
+        ID3D11DeviceContext*                            pd3dContext,
+        D3D11_VIEWPORT                                  VP,
+        D3D11_RECT*                                     pSR,   unsigned int nSRCount,
+        ID3D11RasterizerState *                         pRS,
+        ID3D11BlendState *                              pBS,   const float bsFactor[],
+        ID3D11DepthStencilState*                        pDSS,  unsigned int stencilRef,
+        ID3D11VertexShader*                             pVS,
+        ID3D11HullShader*                               pHS,
+        ID3D11DomainShader*                             pDS,
+        ID3D11GeometryShader*                           pGS,
+        ID3D11PixelShader*                              pPS,
+        ID3D11Buffer**                                  ppCB,  unsigned int nCBStart,  unsigned int nCBCount,
+        ID3D11SamplerState**                            ppSS,  unsigned int nSSStart,  unsigned int nSSCount,
+        ID3D11ShaderResourceView**                      ppSRV, unsigned int nSRVStart, unsigned int nSRVCount,
+        ID3D11RenderTargetView**                        ppRTV, unsigned int nRTVCount,
+        ID3D11DepthStencilView*                         pDSV,
+        unsigned int                                    nInstanceCount)
+    {
+        ID3D11Buffer *             const pNullBuffer[8] = { 0 };
+
+        UINT NullStride[8] = { 0 };
+        UINT NullOffset[8] = { 0 };
+
+        if ( pd3dContext == NULL || pVS == NULL || (ppRTV == NULL && pDSV == NULL) )
+        {
+            AMD_OUTPUT_DEBUG_STRING("Invalid interface pointers in function %s\n", AMD_FUNCTION_NAME);
+            return E_POINTER;
+        }
+
+        stateCache.SetShader( pVS );
+        stateCache.SetShader( pHS );
+        stateCache.SetShader( pDS );
+        stateCache.SetShader( pGS );
+        stateCache.SetShader( pPS );
+
+        // only the stages that have a shader need the resources
+        for (unsigned int stage = STATE_CACHE_STAGE_VS; stage <= STATE_CACHE_STAGE_PS; stage++)
+        {
+            const bool used = (stage == STATE_CACHE_STAGE_VS) ||
+                              (stage == STATE_CACHE_STAGE_HS && pHS != NULL) ||
+                              (stage == STATE_CACHE_STAGE_DS && pDS != NULL) ||
+                              (stage == STATE_CACHE_STAGE_GS && pGS != NULL) ||
+                              (stage == STATE_CACHE_STAGE_PS && pPS != NULL);
+
+            if (used == true)
+            {
+                stateCache.SetSamplers( (STATE_CACHE_STAGE)stage, nSSStart, nSSCount, ppSS );
+                stateCache.SetShaderResources( (STATE_CACHE_STAGE)stage, nSRVStart, nSRVCount, ppSRV );
+                stateCache.SetConstantBuffers( (STATE_CACHE_STAGE)stage, nCBStart, nCBCount, ppCB );
+            }
+        }
+
+        stateCache.SetDepthStencilState( pDSS, stencilRef );
+        stateCache.SetRenderTargets( nRTVCount, ppRTV, pDSV );
+        stateCache.SetBlendState( pBS, bsFactor, 0xFFFFFFFF );
+
+        stateCache.SetViewports( 1, (const StateViewport *)&VP );
+        stateCache.SetScissorRects( nSRCount, (const StateRect *)pSR );
+        stateCache.SetRasterizerState( pRS );
+
+        stateCache.SetInputLayout( NULL );
+        pd3dContext->IASetVertexBuffers( 0, AMD_ARRAY_SIZE(pNullBuffer), pNullBuffer, NullStride, NullOffset );
+        pd3dContext->IASetPrimitiveTopology( D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST );
+
+        if (nInstanceCount == 1)
+        {
+            pd3dContext->Draw( 36, 0 );
+        }
+        else
+        {
+            pd3dContext->DrawInstanced( 36, nInstanceCount, 0, 0 );
+        }
+
+        return S_OK;
+    }
 }
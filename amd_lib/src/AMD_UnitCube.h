@@ -27,6 +27,8 @@
 
 namespace AMD
 {
+    class StateCache;
+
     HRESULT CreateUnitCube(ID3D11VertexShader** ppVS, ID3D11Device* pDevice);
     HRESULT CreateUnitCube(ID3D11PixelShader** ppPS, ID3D11Device* pDevice);
 
@@ -48,6 +50,27 @@ namespace AMD
         ID3D11ShaderResourceView** ppSRV, unsigned int uStartSRV, unsigned int uNumSRV,
         ID3D11RenderTargetView**   ppRTV, unsigned int uNumRTV,
         ID3D11DepthStencilView*    pDSV);
+
+    // the same draw, with the state bound through stateCache (see RenderFullscreenPass);
+    // uNumInstances cubes, the vertex shader tells them apart by SV_InstanceID
+    HRESULT RenderUnitCube(StateCache & stateCache,
+        ID3D11DeviceContext*       pDeviceContext,
+        D3D11_VIEWPORT             VP,
+        D3D11_RECT*                pSR,   unsigned int uNumSR,
+        ID3D11RasterizerState *    pRS,
+        ID3D11BlendState *         pBS,   const float bsFactor[],
+        ID3D11DepthStencilState*   pDSS,  unsigned int stencilRef,
+        ID3D11VertexShader*        pVS,
+        ID3D11HullShader*          pHS,
+        ID3D11DomainShader*        pDS,
+        ID3D11GeometryShader*      pGS,
+        ID3D11PixelShader*         pPS,
+        ID3D11Buffer**             ppCB,  unsigned int uStartCB,  unsigned int uNumCB,
+        ID3D11SamplerState**       ppSS,  unsigned int uStartSS,  unsigned int uNumSS,
+        ID3D11ShaderResourceView** ppSRV, unsigned int uStartSRV, unsigned int uNumSRV,
+        ID3D11RenderTargetView**   ppRTV, unsigned int uNumRTV,
+        ID3D11DepthStencilView*    pDSV,
+        unsigned int               uNumInstances = 1);
 }
 
 #endif
@@ -230,6 +230,82 @@ HRESULT Mesh::Render(ID3D11DeviceContext * pContext)
 #endif
 }
 
+// Draws instanceCount instances of every subset; the shaders tell the instances apart
+// with SV_InstanceID. CDXUTSDKMesh has no instanced draw, so its meshes are walked here
+// the way CDXUTSDKMesh::RenderMesh does it.
+HRESULT Mesh::Render(ID3D11DeviceContext * pContext, unsigned int instanceCount)
+{
+    if (m_isSdkMesh)
+    {
+        if (m_sdkMesh.GetOutstandingBufferResources() > 0)
+        {
+            return S_OK;
+        }
+
+        for (unsigned int mesh = 0; mesh < m_sdkMesh.GetNumMeshes(); mesh++)
+        {
+            const SDKMESH_MESH * pMesh = m_sdkMesh.GetMesh(mesh);
+
+            ID3D11Buffer * pVB[MAX_D3D11_VERTEX_STREAMS];
+            unsigned int   stride[MAX_D3D11_VERTEX_STREAMS];
+            unsigned int   offset[MAX_D3D11_VERTEX_STREAMS];
+
+            if (pMesh->NumVertexBuffers > MAX_D3D11_VERTEX_STREAMS)
+            {
+                return E_FAIL;
+            }
+
+            for (unsigned int vb = 0; vb < pMesh->NumVertexBuffers; vb++)
+            {
+                pVB[vb] = m_sdkMesh.GetVB11(mesh, vb);
+                stride[vb] = m_sdkMesh.GetVertexStride(mesh, vb);
+                offset[vb] = 0;
+            }
+
+            pContext->IASetVertexBuffers(0, pMesh->NumVertexBuffers, pVB, stride, offset);
+            pContext->IASetIndexBuffer(m_sdkMesh.GetIB11(mesh), m_sdkMesh.GetIBFormat11(mesh), 0);
+
+            for (unsigned int subset = 0; subset < m_sdkMesh.GetNumSubsets(mesh); subset++)
+            {
+                const SDKMESH_SUBSET * pSubset = m_sdkMesh.GetSubset(mesh, subset);
+                SDKMESH_MATERIAL *     pMaterial = m_sdkMesh.GetMaterial(pSubset->MaterialID);
+
+                pContext->IASetPrimitiveTopology(CDXUTSDKMesh::GetPrimitiveType11((SDKMESH_PRIMITIVE_TYPE)pSubset->PrimitiveType));
+
+                if (!IsErrorResource(pMaterial->pDiffuseRV11))
+                {
+                    pContext->PSSetShaderResources(0, 1, &pMaterial->pDiffuseRV11);
+                }
+
+                pContext->DrawIndexedInstanced((UINT)pSubset->IndexCount, instanceCount, (UINT)pSubset->IndexStart, (INT)pSubset->VertexStart, 0);
+            }
+        }
+        return S_OK;
+    }
+#ifdef AMD_SDK_MINIMAL
+    else
+    {
+        // the minimal-dependencies version of AMD_SDK
+        // only supports sdkmesh
+        return E_FAIL;
+    }
+#else
+    unsigned int stride = sizeof(Vertex), offset = 0;
+    pContext->IASetIndexBuffer(_b1d_index, DXGI_FORMAT_R32_UINT, 0);
+    pContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    pContext->IASetVertexBuffers(0, 1, &_b1d_vertex, &stride, &offset);
+
+    for (unsigned int i = 0; i < _material_group.size(); i++)
+    {
+        pContext->PSSetShaderResources(0, 1, &_srv[_material_group[i]._texture_index]);
+
+        pContext->DrawIndexedInstanced(_material_group[i]._index_count, instanceCount, _material_group[i]._first_index, 0, 0);
+    }
+
+    return S_OK;
+#endif
+}
+
 HRESULT Mesh::Release()
 {
     if (m_isSdkMesh)
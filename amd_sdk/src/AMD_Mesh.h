@@ -84,6 +84,7 @@ public:
     HRESULT Create(ID3D11Device * pDevice, const char * path, const char * name, bool sdkmesh = false);
 
     HRESULT Render(ID3D11DeviceContext * pContext);
+    HRESULT Render(ID3D11DeviceContext * pContext, unsigned int instanceCount);
     HRESULT Release();
 
     ID3D11ShaderResourceView ** srv();
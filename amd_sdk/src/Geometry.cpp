@@ -51,7 +51,7 @@ static void NormalizePlane( XMFLOAT4* pPlaneEquation )
 //--------------------------------------------------------------------------------------
 // Extract all 6 plane equations from frustum denoted by supplied matrix
 //--------------------------------------------------------------------------------------
-void ExtractPlanesFromFrustum( XMFLOAT4* pPlaneEquation, const XMMATRIX* pMatrix, bool bNormalize )
+void AMD::ExtractPlanesFromFrustum( XMFLOAT4* pPlaneEquation, const XMMATRIX* pMatrix, bool bNormalize )
 {
     XMFLOAT4X4 TempMat;
     XMStoreFloat4x4( &TempMat, *pMatrix);
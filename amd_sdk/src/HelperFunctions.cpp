@@ -464,6 +464,13 @@ void AMD::ParseCommandLine( CmdLineParams* pCmdLineParams )
     swprintf_s( pCmdLineParams->strCaptureFilename, L"FrameCapture.bmp" );
     pCmdLineParams->iExitFrame = -1;
     pCmdLineParams->bRenderHUD = true;
+    pCmdLineParams->bBenchmark = false;
+    pCmdLineParams->strBenchmarkPath[0] = 0;
+    pCmdLineParams->strBenchmarkOutput[0] = 0;
+    pCmdLineParams->strBenchmarkSweep[0] = 0;
+    pCmdLineParams->iBenchmarkWarmupFrames = 120;
+    pCmdLineParams->iBenchmarkFrames = 1000;
+    pCmdLineParams->strScene[0] = 0;
 
     // Perform application-dependant command line processing
     WCHAR* strCmdLine = GetCommandLine();
@@ -537,6 +544,65 @@ void AMD::ParseCommandLine( CmdLineParams* pCmdLineParams )
                 }
                 continue;
             }
+
+            // -scene:scenefile replaces the scene of the sample
+            if (IsNextArg( strCmdLine, L"scene" ))
+            {
+                if (GetCmdParam( strCmdLine, strFlag ))
+                {
+                    swprintf_s( pCmdLineParams->strScene, L"%s", strFlag );
+                }
+                continue;
+            }
+
+            // -benchmark[:pathfile] runs the path, then saves the results and exits
+            if (IsNextArg( strCmdLine, L"benchmark" ))
+            {
+                if (GetCmdParam( strCmdLine, strFlag ))
+                {
+                    swprintf_s( pCmdLineParams->strBenchmarkPath, L"%s", strFlag );
+                }
+                pCmdLineParams->bBenchmark = true;
+                continue;
+            }
+
+            if (IsNextArg( strCmdLine, L"benchmarkoutput" ))
+            {
+                if (GetCmdParam( strCmdLine, strFlag ))
+                {
+                    swprintf_s( pCmdLineParams->strBenchmarkOutput, L"%s", strFlag );
+                }
+                continue;
+            }
+
+            // -benchmarksweep:sweepfile runs the benchmark once per configuration, and saves their ranking
+            if (IsNextArg( strCmdLine, L"benchmarksweep" ))
+            {
+                if (GetCmdParam( strCmdLine, strFlag ))
+                {
+                    swprintf_s( pCmdLineParams->strBenchmarkSweep, L"%s", strFlag );
+                    pCmdLineParams->bBenchmark = true;
+                }
+                continue;
+            }
+
+            if (IsNextArg( strCmdLine, L"benchmarkwarmup" ))
+            {
+                if (GetCmdParam( strCmdLine, strFlag ))
+                {
+                    pCmdLineParams->iBenchmarkWarmupFrames = _wtoi( strFlag );
+                }
+                continue;
+            }
+
+            if (IsNextArg( strCmdLine, L"benchmarkframes" ))
+            {
+                if (GetCmdParam( strCmdLine, strFlag ))
+                {
+                    pCmdLineParams->iBenchmarkFrames = _wtoi( strFlag );
+                }
+                continue;
+            }
         }
     }
 }
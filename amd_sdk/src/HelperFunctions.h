@@ -40,6 +40,13 @@ namespace AMD
         WCHAR strCaptureFilename[256];
         int iExitFrame;
         bool bRenderHUD;
+        bool bBenchmark;
+        WCHAR strBenchmarkPath[256];
+        WCHAR strBenchmarkOutput[256];
+        WCHAR strBenchmarkSweep[256];
+        int iBenchmarkWarmupFrames;
+        int iBenchmarkFrames;
+        WCHAR strScene[256];
     } CmdLineParams;
 
 
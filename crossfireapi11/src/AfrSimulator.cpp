@@ -0,0 +1,714 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: AfrSimulator.cpp
+//
+// Software model of N GPUs running in alternate frame rendering (AFR) order.
+//
+// The model is event based: frames are simulated one after the other, each on its own
+// GPU timeline. Every call advances a cursor on the current GPU. Transfers are placed on
+// links (GPU to GPU, GPU to system memory, system memory to GPU); transfers sharing a link
+// are serialized, which is how contention between frames shows up.
+//--------------------------------------------------------------------------------------
+#include "AfrSimulator.h"
+
+#include <assert.h>
+#include <stddef.h>
+
+namespace AMD
+{
+    static double Max(double a, double b) { return a > b ? a : b; }
+    static double Min(double a, double b) { return a < b ? a : b; }
+
+    static double RectArea(const AfrSimRect & rect, unsigned int width, unsigned int height)
+    {
+        const double l = Max(0.0, (double)rect.left);
+        const double t = Max(0.0, (double)rect.top);
+        const double r = Min((double)width, (double)rect.right);
+        const double b = Min((double)height, (double)rect.bottom);
+
+        return (r > l && b > t) ? (r - l) * (b - t) : 0.0;
+    }
+
+    const char * GetAfrSimTransferName(int transfer)
+    {
+        switch (transfer)
+        {
+        case AFR_SIM_TRANSFER_DEFAULT:              return "default";
+        case AFR_SIM_TRANSFER_DISABLE:              return "disable";
+        case AFR_SIM_TRANSFER_1STEP_P2P:            return "1step";
+        case AFR_SIM_TRANSFER_2STEP_NO_BROADCAST:   return "2step";
+        case AFR_SIM_TRANSFER_2STEP_WITH_BROADCAST: return "broadcast";
+        }
+        return "unknown";
+    }
+
+    AfrSimulator::AfrSimulator()
+        : m_FrameIndex(0)
+        , m_InFrame(false)
+        , m_Cursor(0.0)
+        , m_LastSubmit(0.0)
+        , m_LastFrameEnd(0.0)
+    {
+        Init(AfrSimulatorDesc());
+    }
+
+    void AfrSimulator::Init(const AfrSimulatorDesc & desc)
+    {
+        m_Desc = desc;
+        if (m_Desc.m_GpuCount == 0) { m_Desc.m_GpuCount = 1; }
+
+        const unsigned int gpuCount = m_Desc.m_GpuCount;
+
+        m_Resources.clear();
+        m_Stats.clear();
+
+        m_GpuFree.assign(gpuCount, 0.0);
+        m_IncomingStart.clear();
+        m_IncomingEnd.clear();
+        m_IncomingGpu.clear();
+
+        Link idle = { 0.0 };
+        m_P2PLink.assign(gpuCount, idle);
+        m_UploadLink.assign(gpuCount, idle);
+        m_DownloadLink.assign(gpuCount, idle);
+
+        m_FrameIndex = 0;
+        m_InFrame = false;
+        m_Cursor = 0.0;
+        m_LastSubmit = 0.0;
+        m_LastFrameEnd = 0.0;
+    }
+
+    AfrSimResource AfrSimulator::CreateTexture2D(unsigned int width, unsigned int height, unsigned int arraySize, unsigned int bytesPerTexel, int transferType)
+    {
+        Resource res;
+        res.m_Valid = true;
+        res.m_Width = width;
+        res.m_Height = height;
+        res.m_ArraySize = arraySize > 0 ? arraySize : 1;
+        res.m_BytesPerTexel = bytesPerTexel;
+        res.m_TransferType = transferType;
+        res.m_Arrival.assign(m_Desc.m_GpuCount, 0.0);
+        res.m_OutgoingUntil.assign(m_Desc.m_GpuCount, 0.0);
+        res.m_EndAllAccess.assign(m_Desc.m_GpuCount, 0.0);
+        res.m_EndAllAccessDone.assign(m_Desc.m_GpuCount, false);
+        res.m_WrittenThisFrame = false;
+        res.m_EndWritesThisFrame = false;
+
+        // reuse released slots so handles stay small
+        for (size_t i = 0; i < m_Resources.size(); i++)
+        {
+            if (m_Resources[i].m_Valid == false)
+            {
+                m_Resources[i] = res;
+                return (AfrSimResource)i;
+            }
+        }
+
+        m_Resources.push_back(res);
+        return (AfrSimResource)(m_Resources.size() - 1);
+    }
+
+    void AfrSimulator::ReleaseTexture2D(AfrSimResource resource)
+    {
+        if (resource >= 0 && resource < (AfrSimResource)m_Resources.size())
+        {
+            m_Resources[resource].m_Valid = false;
+        }
+    }
+
+    double AfrSimulator::GetRegionBytes(AfrSimResource resource, const AfrSimRect * pRects, const unsigned int * pSubresources, unsigned int count) const
+    {
+        if (resource < 0 || resource >= (AfrSimResource)m_Resources.size() || m_Resources[resource].m_Valid == false)
+        {
+            return 0.0;
+        }
+
+        const Resource & res = m_Resources[resource];
+        const double slice = (double)res.m_Width * (double)res.m_Height;
+
+        // count == 0 means all subresources with (at most) one region
+        if (count == 0)
+        {
+            const double area = pRects != NULL ? RectArea(pRects[0], res.m_Width, res.m_Height) : slice;
+            return area * res.m_ArraySize * res.m_BytesPerTexel;
+        }
+
+        double texels = 0.0;
+        for (unsigned int i = 0; i < count; i++)
+        {
+            if (pSubresources != NULL && pSubresources[i] >= res.m_ArraySize) { continue; }
+
+            texels += pRects != NULL ? RectArea(pRects[i], res.m_Width, res.m_Height) : slice;
+        }
+
+        return texels * res.m_BytesPerTexel;
+    }
+
+    double AfrSimulator::Transfer(Link & link, double start, double bytes, double bandwidth, double latency)
+    {
+        const double begin = Max(start, link.m_BusyUntil);
+        const double duration = latency + (bandwidth > 0.0 ? bytes / (bandwidth * 1.0e6) : 0.0); // GB/s -> bytes per ms
+
+        link.m_BusyUntil = begin + duration;
+
+        return link.m_BusyUntil;
+    }
+
+    void AfrSimulator::Deliver(Resource & res, unsigned int gpu, double start, double end, double bytes)
+    {
+        res.m_Arrival[gpu] = Max(res.m_Arrival[gpu], end);
+
+        m_IncomingStart.push_back(start);
+        m_IncomingEnd.push_back(end);
+        m_IncomingGpu.push_back(gpu);
+
+        m_Current.m_TransferBytes += bytes;
+    }
+
+    void AfrSimulator::BeginFrame()
+    {
+        assert(m_InFrame == false);
+
+        const unsigned int gpu = GetCurrentGpu();
+
+        const double submit = m_FrameIndex == 0 ? 0.0 : m_LastSubmit + m_Desc.m_CpuFrameTime;
+        const double start = Max(submit, m_GpuFree[gpu]);
+
+        // the CPU can't run ahead of the GPU that will execute the frame
+        m_LastSubmit = start;
+
+        m_Current.m_FrameIndex = m_FrameIndex;
+        m_Current.m_Gpu = gpu;
+        m_Current.m_TransferBytes = 0.0;
+        m_Current.m_StallTime = 0.0;
+        m_Current.m_ContentionTime = 0.0;
+        m_Current.m_WriteWaitTime = 0.0;
+        m_Current.m_EndWritesCount = 0;
+        m_Current.m_BeginAllAccessCount = 0;
+        m_Current.m_EndAllAccessCount = 0;
+        m_Current.m_CopyCount = 0;
+        m_Current.m_Start = start;
+
+        // transfers landing on this GPU while it renders slow it down
+        double overlap = 0.0;
+        for (size_t i = 0; i < m_IncomingGpu.size(); )
+        {
+            if (m_IncomingGpu[i] == gpu)
+            {
+                overlap += Max(0.0, m_IncomingEnd[i] - Max(m_IncomingStart[i], start));
+
+                m_IncomingStart[i] = m_IncomingStart.back(); m_IncomingStart.pop_back();
+                m_IncomingEnd[i] = m_IncomingEnd.back();     m_IncomingEnd.pop_back();
+                m_IncomingGpu[i] = m_IncomingGpu.back();     m_IncomingGpu.pop_back();
+            }
+            else
+            {
+                i++;
+            }
+        }
+
+        m_Current.m_ContentionTime = overlap * m_Desc.m_Contention;
+
+        m_Cursor = start + m_Current.m_ContentionTime;
+
+        for (size_t i = 0; i < m_Resources.size(); i++)
+        {
+            m_Resources[i].m_WrittenThisFrame = false;
+            m_Resources[i].m_EndWritesThisFrame = false;
+            m_Resources[i].m_EndAllAccessDone[gpu] = false;
+        }
+
+        m_InFrame = true;
+    }
+
+    void AfrSimulator::EndFrame()
+    {
+        assert(m_InFrame == true);
+
+        const unsigned int gpu = GetCurrentGpu();
+        const unsigned int next = (gpu + 1) % m_Desc.m_GpuCount;
+
+        for (size_t i = 0; i < m_Resources.size(); i++)
+        {
+            Resource & res = m_Resources[i];
+            if (res.m_Valid == false) { continue; }
+
+            // without an EndAllAccess the driver has to assume the resource is in use until the frame is done
+            if (res.m_EndAllAccessDone[gpu] == false)
+            {
+                res.m_EndAllAccess[gpu] = m_Cursor;
+            }
+
+            // default driver tracking sends the whole resource to the next GPU once the frame is done
+            if (res.m_TransferType == AFR_SIM_TRANSFER_DEFAULT && res.m_WrittenThisFrame && m_Desc.m_GpuCount > 1)
+            {
+                const double bytes = GetRegionBytes((AfrSimResource)i, NULL, NULL, 0);
+                const double start = Max(m_Cursor, res.m_EndAllAccess[next]);
+                const double end = Transfer(m_P2PLink[next], start, bytes, m_Desc.m_P2PBandwidth, m_Desc.m_P2PLatency);
+                Deliver(res, next, start, end, bytes);
+                res.m_OutgoingUntil[gpu] = Max(res.m_OutgoingUntil[gpu], end);
+            }
+        }
+
+        // frames are presented in order, so a frame can't be shown before the previous one
+        const double present = Max(m_Cursor, m_LastFrameEnd);
+
+        m_Current.m_End = m_Cursor;
+        m_Current.m_GpuTime = m_Cursor - m_Current.m_Start;
+        m_Current.m_FrameTime = present - m_LastFrameEnd;
+
+        m_GpuFree[gpu] = m_Cursor;
+        m_LastFrameEnd = present;
+
+        m_Stats.push_back(m_Current);
+
+        m_FrameIndex++;
+        m_InFrame = false;
+    }
+
+    void AfrSimulator::Work(double ms)
+    {
+        m_Cursor += ms;
+    }
+
+    void AfrSimulator::Render(AfrSimResource target, double ms)
+    {
+        if (target >= 0 && target < (AfrSimResource)m_Resources.size())
+        {
+            Resource & res = m_Resources[target];
+            res.m_WrittenThisFrame = true;
+
+            // the driver can't let the GPU overwrite a resource a transfer is still reading or writing
+            const double until = Max(res.m_OutgoingUntil[GetCurrentGpu()], res.m_Arrival[GetCurrentGpu()]);
+            if (until > m_Cursor)
+            {
+                m_Current.m_WriteWaitTime += until - m_Cursor;
+                m_Cursor = until;
+            }
+        }
+
+        Work(ms);
+    }
+
+    void AfrSimulator::CopyResource(AfrSimResource dst, AfrSimResource src)
+    {
+        CopyRegion(dst, src, NULL, NULL, 0);
+    }
+
+    void AfrSimulator::CopyRegion(AfrSimResource dst, AfrSimResource src, const AfrSimRect * pRects, const unsigned int * pSubresources, unsigned int count)
+    {
+        m_Current.m_CopyCount++;
+
+        if (dst < 0 || src < 0) { return; }
+
+        const double bytes = GetRegionBytes(src, pRects, pSubresources, count);
+
+        Render(dst, m_Desc.m_CopyBandwidth > 0.0 ? bytes / (m_Desc.m_CopyBandwidth * 1.0e6) : 0.0);
+    }
+
+    void AfrSimulator::NotifyResourceEndWrites(AfrSimResource resource, const AfrSimRect * pTransferRegions, const unsigned int * pSubresources, unsigned int numSubresources)
+    {
+        m_Current.m_EndWritesCount++;
+
+        if (resource < 0 || resource >= (AfrSimResource)m_Resources.size() || m_Desc.m_GpuCount < 2) { return; }
+
+        Resource & res = m_Resources[resource];
+        if (res.m_Valid == false) { return; }
+
+        res.m_EndWritesThisFrame = true;
+
+        const unsigned int gpu = GetCurrentGpu();
+        const unsigned int next = (gpu + 1) % m_Desc.m_GpuCount;
+        const double bytes = GetRegionBytes(resource, pTransferRegions, pSubresources, numSubresources);
+
+        switch (res.m_TransferType)
+        {
+        case AFR_SIM_TRANSFER_1STEP_P2P:
+            {
+                // EndAllAccess in frame N-(NumGpus-1) allows a 1 step P2P in frame N to start,
+                // and frame N-(NumGpus-1) is the last frame the next GPU rendered
+                const double start = Max(m_Cursor, res.m_EndAllAccess[next]);
+                const double end = Transfer(m_P2PLink[next], start, bytes, m_Desc.m_P2PBandwidth, m_Desc.m_P2PLatency);
+                Deliver(res, next, start, end, bytes);
+                res.m_OutgoingUntil[gpu] = Max(res.m_OutgoingUntil[gpu], end);
+            }
+            break;
+
+        case AFR_SIM_TRANSFER_2STEP_NO_BROADCAST:
+            {
+                const double staged = Transfer(m_UploadLink[gpu], m_Cursor, bytes, m_Desc.m_SysMemBandwidth, m_Desc.m_SysMemLatency);
+                const double end = Transfer(m_DownloadLink[next], staged, bytes, m_Desc.m_SysMemBandwidth, m_Desc.m_SysMemLatency);
+                Deliver(res, next, staged, end, bytes);
+                res.m_OutgoingUntil[gpu] = Max(res.m_OutgoingUntil[gpu], staged);
+            }
+            break;
+
+        case AFR_SIM_TRANSFER_2STEP_WITH_BROADCAST:
+            {
+                const double staged = Transfer(m_UploadLink[gpu], m_Cursor, bytes, m_Desc.m_SysMemBandwidth, m_Desc.m_SysMemLatency);
+                res.m_OutgoingUntil[gpu] = Max(res.m_OutgoingUntil[gpu], staged);
+                for (unsigned int i = 1; i < m_Desc.m_GpuCount; i++)
+                {
+                    const unsigned int dst = (gpu + i) % m_Desc.m_GpuCount;
+                    const double end = Transfer(m_DownloadLink[dst], staged, bytes, m_Desc.m_SysMemBandwidth, m_Desc.m_SysMemLatency);
+                    Deliver(res, dst, staged, end, bytes);
+                }
+            }
+            break;
+
+        default: // DEFAULT is handled at the end of the frame, DISABLE never transfers
+            break;
+        }
+    }
+
+    void AfrSimulator::NotifyResourceBeginAllAccess(AfrSimResource resource)
+    {
+        m_Current.m_BeginAllAccessCount++;
+
+        if (resource < 0 || resource >= (AfrSimResource)m_Resources.size()) { return; }
+
+        const Resource & res = m_Resources[resource];
+        const double arrival = res.m_Arrival[GetCurrentGpu()];
+
+        if (arrival > m_Cursor)
+        {
+            m_Current.m_StallTime += arrival - m_Cursor;
+            m_Cursor = arrival;
+        }
+    }
+
+    bool AfrSimulator::HasArrived(AfrSimResource resource) const
+    {
+        if (resource < 0 || resource >= (AfrSimResource)m_Resources.size()) { return false; }
+
+        return m_Resources[resource].m_Arrival[GetCurrentGpu()] <= m_Cursor;
+    }
+
+    void AfrSimulator::NotifyResourceEndAllAccess(AfrSimResource resource)
+    {
+        m_Current.m_EndAllAccessCount++;
+
+        if (resource < 0 || resource >= (AfrSimResource)m_Resources.size()) { return; }
+
+        Resource & res = m_Resources[resource];
+        const unsigned int gpu = GetCurrentGpu();
+
+        res.m_EndAllAccess[gpu] = m_Cursor;
+        res.m_EndAllAccessDone[gpu] = true;
+    }
+
+    //--------------------------------------------------------------------------------------
+    // Sample replay
+    //--------------------------------------------------------------------------------------
+    static const int         SIM_CUBE_FACE_COUNT = 6;
+    static const int         SIM_SHADOWFX_TEXTURE_2D = 0;
+    static const int         SIM_SHADOWFX_TEXTURE_2D_ARRAY = 1;
+    static const unsigned    SIM_R32_BYTES = 4;
+
+    static bool RequiresTransfer(int flag)
+    {
+        return flag != AFR_SIM_TRANSFER_DISABLE && flag != AFR_SIM_TRANSFER_DEFAULT;
+    }
+
+    AfrSimSampleReplay::AfrSimSampleReplay()
+        : m_ShadowMap(-1)
+        , m_ReadSlot(TRANSFER_RING_INVALID_INDEX)
+        , m_ShadowMapCfxFlag(AFR_SIM_TRANSFER_DEFAULT)
+        , m_ShadowMapTransferCfxFlag(AFR_SIM_TRANSFER_DEFAULT)
+        , m_ShadowMapFrameDelay(0)
+    {
+    }
+
+    void AfrSimSampleReplay::Init(AfrSimulator & sim, const AfrSimSampleSettings & settings)
+    {
+        Release(sim);
+
+        m_Settings = settings;
+        m_ShadowMapFrameDelay = 0;
+
+        if (m_Settings.m_MaxShadowMapFrameDelay <= 0)
+        {
+            // if running on an MGPU PC, update shadow map once in a few frames
+            m_Settings.m_MaxShadowMapFrameDelay = sim.GetDesc().m_GpuCount > 1 ? 6 : 1;
+        }
+
+        // same flag selection as OnD3D11CreateDevice / OnGUIEvent
+        if (m_Settings.m_EnableCrossfireApiTransfers == false)
+        {
+            m_ShadowMapCfxFlag = m_ShadowMapTransferCfxFlag = AFR_SIM_TRANSFER_DEFAULT;
+        }
+        else if (m_Settings.m_Enable2StepGpuTransfer == true)
+        {
+            m_ShadowMapCfxFlag = AFR_SIM_TRANSFER_DISABLE;
+            m_ShadowMapTransferCfxFlag = m_Settings.m_ResourceTransferType;
+        }
+        else
+        {
+            m_ShadowMapCfxFlag = m_Settings.m_ResourceTransferType;
+            m_ShadowMapTransferCfxFlag = AFR_SIM_TRANSFER_DISABLE;
+        }
+
+        m_TransferRing.Init(sim.GetDesc().m_GpuCount, SIM_CUBE_FACE_COUNT, m_Settings.m_TransferSlotCount);
+
+        // same resources as InitTransferredResources
+        const unsigned int size = m_Settings.m_ShadowMapSize;
+        const bool         array = m_Settings.m_ShadowTextureType == SIM_SHADOWFX_TEXTURE_2D_ARRAY;
+        const unsigned int width = array ? size : size * m_Settings.m_AtlasScaleW;
+        const unsigned int height = array ? size : size * m_Settings.m_AtlasScaleH;
+        const unsigned int arraySize = array ? SIM_CUBE_FACE_COUNT : 1;
+
+        m_ShadowMap = sim.CreateTexture2D(width, height, arraySize, SIM_R32_BYTES, m_ShadowMapCfxFlag);
+        if (m_Settings.m_Enable2StepGpuTransfer == true)
+        {
+            for (unsigned int slot = 0; slot < m_TransferRing.GetSlotCount(); slot++)
+            {
+                m_ShadowMapTransfer.push_back(sim.CreateTexture2D(width, height, arraySize, SIM_R32_BYTES, m_ShadowMapTransferCfxFlag));
+            }
+        }
+    }
+
+    void AfrSimSampleReplay::Release(AfrSimulator & sim)
+    {
+        sim.ReleaseTexture2D(m_ShadowMap);
+        for (size_t i = 0; i < m_ShadowMapTransfer.size(); i++)
+        {
+            sim.ReleaseTexture2D(m_ShadowMapTransfer[i]);
+        }
+
+        m_ShadowMap = -1;
+        m_ShadowMapTransfer.clear();
+    }
+
+    unsigned int AfrSimSampleReplay::GetNextFrameFaces(unsigned int * pFaces) const
+    {
+        const int    frameDelay = m_ShadowMapFrameDelay + 1;
+        unsigned int faceCount = 0;
+
+        if (m_Settings.m_SingleFacePerFrame)
+        {
+            pFaces[faceCount++] = (unsigned int)(frameDelay % SIM_CUBE_FACE_COUNT);
+        }
+        else if (frameDelay % m_Settings.m_MaxShadowMapFrameDelay == 0)
+        {
+            for (unsigned int face = 0; face < (unsigned int)SIM_CUBE_FACE_COUNT; face++)
+            {
+                pFaces[faceCount++] = face;
+            }
+        }
+
+        return faceCount;
+    }
+
+    void AfrSimSampleReplay::RenderFrame(AfrSimulator & sim)
+    {
+        const bool oneStep = m_Settings.m_EnableCrossfireApiTransfers == true && m_Settings.m_Enable2StepGpuTransfer == false;
+        const bool twoStep = m_Settings.m_EnableCrossfireApiTransfers == true && m_Settings.m_Enable2StepGpuTransfer == true;
+
+        sim.BeginFrame();
+        m_DelayedEndAllAccess.clear();
+
+        sim.Work(m_Settings.m_DepthPrepassTime);
+
+        unsigned int faces[SIM_CUBE_FACE_COUNT];
+        const unsigned int faceCount = GetNextFrameFaces(faces);
+
+        m_ShadowMapFrameDelay++;
+
+        // the order the frame graph places the notifications in
+        m_ReadSlot = TRANSFER_RING_INVALID_INDEX;
+        if (twoStep == true)
+        {
+            ReceiveShadowMapTransfer(sim, faceCount > 0);
+        }
+
+        if (faceCount > 0)
+        {
+            if (oneStep == true) { sim.NotifyResourceBeginAllAccess(m_ShadowMap); }
+
+            RenderShadowMapFaces(sim, faces, faceCount);
+
+            if (twoStep == true) { SendShadowMapFaces(sim); }
+        }
+
+        sim.Work(m_Settings.m_MaskingTime);
+
+        if (oneStep == true && faceCount == 0) { sim.NotifyResourceBeginAllAccess(m_ShadowMap); }
+
+        sim.Work(m_Settings.m_FilteringTime); // ShadowFX_Render reads the shadow map
+
+        if (oneStep == true) { EndAllAccess(sim, m_ShadowMap); }
+
+        sim.Work(m_Settings.m_SceneTime);
+
+        for (size_t i = 0; i < m_DelayedEndAllAccess.size(); i++)
+        {
+            sim.NotifyResourceEndAllAccess(m_DelayedEndAllAccess[i]);
+        }
+
+        sim.EndFrame();
+    }
+
+    void AfrSimSampleReplay::EndAllAccess(AfrSimulator & sim, AfrSimResource resource)
+    {
+        if (m_Settings.m_DelayEndAllAccess == true)
+        {
+            m_DelayedEndAllAccess.push_back(resource);
+        }
+        else
+        {
+            sim.NotifyResourceEndAllAccess(resource);
+        }
+    }
+
+    void AfrSimSampleReplay::ReceiveShadowMapTransfer(AfrSimulator & sim, bool sending)
+    {
+        // unlike the sample, the simulator knows which transfers have landed
+        bool completed[TRANSFER_RING_MAX_SLOT_COUNT];
+        for (unsigned int slot = 0; slot < m_TransferRing.GetSlotCount(); slot++)
+        {
+            completed[slot] = sim.HasArrived(m_ShadowMapTransfer[slot]);
+        }
+
+        m_ReadSlot = m_TransferRing.GetReadSlot(sim.GetCurrentGpu(), sim.GetFrameIndex(), completed);
+        if (m_ReadSlot == TRANSFER_RING_INVALID_INDEX)
+        {
+            return;
+        }
+
+        const AfrSimResource slot = m_ShadowMapTransfer[m_ReadSlot];
+
+        sim.NotifyResourceBeginAllAccess(slot);
+
+        unsigned int faces[SIM_CUBE_FACE_COUNT];
+        if (m_TransferRing.GetFacesToRead(sim.GetCurrentGpu(), m_ReadSlot, faces) > 0)
+        {
+            sim.CopyResource(m_ShadowMap, slot);
+        }
+
+        // the slot read in this frame may also be the one written, then the send pass is its last access
+        if (sending == false || m_TransferRing.GetWriteSlot(sim.GetFrameIndex()) != m_ReadSlot)
+        {
+            EndAllAccess(sim, slot);
+        }
+    }
+
+    void AfrSimSampleReplay::RenderShadowMapFaces(AfrSimulator & sim, const unsigned int * pFaces, unsigned int faceCount)
+    {
+        sim.Render(m_ShadowMap, m_Settings.m_ShadowFaceTime * faceCount); // subregion clears + scene
+
+        for (unsigned int i = 0; i < faceCount; i++)
+        {
+            m_TransferRing.MarkRendered(sim.GetCurrentGpu(), pFaces[i], sim.GetFrameIndex());
+        }
+
+        if (m_Settings.m_EnableCrossfireApiTransfers == false || m_Settings.m_Enable2StepGpuTransfer == true || RequiresTransfer(m_ShadowMapCfxFlag) == false)
+        {
+            return;
+        }
+
+        if (faceCount == SIM_CUBE_FACE_COUNT)
+        {
+            sim.NotifyResourceEndWrites(m_ShadowMap, NULL, NULL, 0);
+            return;
+        }
+
+        AfrSimRect   rects[SIM_CUBE_FACE_COUNT];
+        unsigned int subresources[SIM_CUBE_FACE_COUNT];
+        for (unsigned int i = 0; i < faceCount; i++)
+        {
+            const int size = (int)m_Settings.m_ShadowMapSize;
+            const int x = (int)(pFaces[i] % m_Settings.m_AtlasScaleW) * size;
+            const int y = (int)(pFaces[i] / m_Settings.m_AtlasScaleW) * size;
+            const AfrSimRect rect = { x, y, x + size, y + size };
+
+            rects[i] = rect;
+            subresources[i] = pFaces[i];
+        }
+
+        if (m_Settings.m_ShadowTextureType == SIM_SHADOWFX_TEXTURE_2D)
+        {
+            sim.NotifyResourceEndWrites(m_ShadowMap, rects, NULL, faceCount);
+        }
+        else
+        {
+            sim.NotifyResourceEndWrites(m_ShadowMap, NULL, subresources, faceCount);
+        }
+    }
+
+    void AfrSimSampleReplay::SendShadowMapFaces(AfrSimulator & sim)
+    {
+        const unsigned int   writeSlot = m_TransferRing.GetWriteSlot(sim.GetFrameIndex());
+        const AfrSimResource slot = m_ShadowMapTransfer[writeSlot];
+
+        if (writeSlot != m_ReadSlot)
+        {
+            sim.NotifyResourceBeginAllAccess(slot);
+        }
+
+        // only the faces the slot is missing are copied and transferred
+        unsigned int faces[SIM_CUBE_FACE_COUNT];
+        const unsigned int faceCount = m_TransferRing.GetFacesToWrite(sim.GetCurrentGpu(), writeSlot, faces);
+
+        AfrSimRect   rects[SIM_CUBE_FACE_COUNT];
+        unsigned int subresources[SIM_CUBE_FACE_COUNT];
+        for (unsigned int i = 0; i < faceCount; i++)
+        {
+            const int size = (int)m_Settings.m_ShadowMapSize;
+            const int x = (int)(faces[i] % m_Settings.m_AtlasScaleW) * size;
+            const int y = (int)(faces[i] / m_Settings.m_AtlasScaleW) * size;
+            const AfrSimRect rect = { x, y, x + size, y + size };
+
+            rects[i] = rect;
+            subresources[i] = faces[i];
+        }
+
+        const bool array = m_Settings.m_ShadowTextureType == SIM_SHADOWFX_TEXTURE_2D_ARRAY;
+
+        if (faceCount == SIM_CUBE_FACE_COUNT)
+        {
+            sim.CopyResource(slot, m_ShadowMap);
+        }
+        else if (faceCount > 0)
+        {
+            sim.CopyRegion(slot, m_ShadowMap, array ? NULL : rects, array ? subresources : NULL, faceCount); // blits / CopySubresourceRegion
+        }
+
+        if (faceCount > 0 && RequiresTransfer(m_ShadowMapTransferCfxFlag))
+        {
+            if (faceCount == SIM_CUBE_FACE_COUNT)
+            {
+                sim.NotifyResourceEndWrites(slot, NULL, NULL, 0);
+            }
+            else
+            {
+                sim.NotifyResourceEndWrites(slot, array ? NULL : rects, array ? subresources : NULL, faceCount);
+            }
+
+            m_TransferRing.MarkSent(sim.GetCurrentGpu(), writeSlot, sim.GetFrameIndex(), m_ShadowMapTransferCfxFlag == AFR_SIM_TRANSFER_2STEP_WITH_BROADCAST);
+        }
+
+        EndAllAccess(sim, slot);
+    }
+}
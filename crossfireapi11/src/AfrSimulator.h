@@ -0,0 +1,270 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: AfrSimulator.h
+//
+// Software model of N GPUs running in alternate frame rendering (AFR) order.
+// It mirrors the agsDriverExtensions_CreateTexture2D / NotifyResourceEndWrites /
+// NotifyResourceBeginAllAccess / NotifyResourceEndAllAccess calls and predicts the
+// bytes transferred, the time a GPU stalls waiting for a transfer and the frame time.
+//
+// This code has no dependency on Windows, D3D11 or AGS, so it can be built and run
+// headless (see tools/AfrSimulator).
+//--------------------------------------------------------------------------------------
+#ifndef AFR_SIMULATOR_H
+#define AFR_SIMULATOR_H
+
+#include <vector>
+
+#include "TransferRing.h"
+
+namespace AMD
+{
+    // The values match AGSAfrTransferType, so the sample can cast between the two
+    typedef enum AFR_SIM_TRANSFER_t
+    {
+        AFR_SIM_TRANSFER_DEFAULT                     = 0, // driver tracking: whole resource is sent to the next GPU at the end of the frame
+        AFR_SIM_TRANSFER_DISABLE                     = 1, // no transfer
+        AFR_SIM_TRANSFER_1STEP_P2P                   = 2, // GPU to next GPU, waits for the next GPU to be done with the resource
+        AFR_SIM_TRANSFER_2STEP_NO_BROADCAST          = 3, // GPU to system memory to next GPU
+        AFR_SIM_TRANSFER_2STEP_WITH_BROADCAST        = 4, // GPU to system memory to all the other GPUs
+    } AFR_SIM_TRANSFER;
+
+    // default, disable, 1step, 2step or broadcast, the names the tools and the benchmark results use
+    const char * GetAfrSimTransferName(int transfer);
+
+    typedef int AfrSimResource; // handle returned by AfrSimulator::CreateTexture2D, -1 is invalid
+
+    struct AfrSimRect // same layout as D3D11_RECT
+    {
+        int left, top, right, bottom;
+    };
+
+    struct AfrSimulatorDesc
+    {
+        unsigned int m_GpuCount;            // number of GPUs in AFR order
+        double       m_P2PBandwidth;        // GB/s of a GPU to GPU link
+        double       m_P2PLatency;          // ms to start a GPU to GPU transfer
+        double       m_SysMemBandwidth;     // GB/s of a GPU to (or from) system memory link
+        double       m_SysMemLatency;       // ms to start a system memory transfer
+        double       m_CopyBandwidth;       // GB/s of a local GPU copy (CopyResource/blits)
+        double       m_Contention;          // [0, 1] fraction of a GPU's rendering speed lost while it is the target of a transfer
+        double       m_CpuFrameTime;        // ms between frame submissions on the CPU
+
+        AfrSimulatorDesc()
+            : m_GpuCount(2)
+            , m_P2PBandwidth(6.0)
+            , m_P2PLatency(0.05)
+            , m_SysMemBandwidth(10.0)
+            , m_SysMemLatency(0.02)
+            , m_CopyBandwidth(150.0)
+            , m_Contention(0.3)
+            , m_CpuFrameTime(2.0)
+        {}
+    };
+
+    struct AfrSimFrameStats
+    {
+        unsigned int m_FrameIndex;
+        unsigned int m_Gpu;
+        double       m_TransferBytes;       // bytes that left this GPU in this frame (all destinations)
+        double       m_StallTime;           // ms this GPU waited in BeginAllAccess
+        double       m_ContentionTime;      // ms added to this frame by incoming transfers
+        double       m_WriteWaitTime;       // ms this GPU waited to overwrite a resource an outgoing transfer was still reading
+        double       m_GpuTime;             // ms from the start to the end of the frame on its GPU
+        double       m_FrameTime;           // ms between this frame's end and the previous frame's end (what the user sees)
+        unsigned int m_EndWritesCount;      // Crossfire API calls made in this frame
+        unsigned int m_BeginAllAccessCount;
+        unsigned int m_EndAllAccessCount;
+        unsigned int m_CopyCount;           // CopyResource and CopyRegion
+        double       m_Start;
+        double       m_End;
+    };
+
+    class AfrSimulator
+    {
+    public:
+        AfrSimulator();
+
+        void                      Init(const AfrSimulatorDesc & desc);
+        const AfrSimulatorDesc &  GetDesc() const { return m_Desc; }
+
+        // agsDriverExtensions_CreateTexture2D
+        AfrSimResource            CreateTexture2D(unsigned int width, unsigned int height, unsigned int arraySize, unsigned int bytesPerTexel, int transferType);
+        void                      ReleaseTexture2D(AfrSimResource resource);
+
+        // frame boundaries; frame N runs on GPU N % GpuCount
+        void                      BeginFrame();
+        void                      EndFrame();
+
+        // GPU work issued on the current frame's GPU
+        void                      Work(double ms);
+        void                      Render(AfrSimResource target, double ms); // work that writes to target
+        void                      CopyResource(AfrSimResource dst, AfrSimResource src);
+        void                      CopyRegion(AfrSimResource dst, AfrSimResource src, const AfrSimRect * pRects, const unsigned int * pSubresources, unsigned int count);
+
+        // agsDriverExtensions_NotifyResource*
+        void                      NotifyResourceEndWrites(AfrSimResource resource, const AfrSimRect * pTransferRegions, const unsigned int * pSubresources, unsigned int numSubresources);
+        void                      NotifyResourceBeginAllAccess(AfrSimResource resource);
+        void                      NotifyResourceEndAllAccess(AfrSimResource resource);
+
+        // the transfers to the current frame's GPU have landed, BeginAllAccess wouldn't wait
+        bool                      HasArrived(AfrSimResource resource) const;
+
+        unsigned int              GetFrameIndex() const { return m_FrameIndex; }
+        unsigned int              GetCurrentGpu() const { return m_FrameIndex % m_Desc.m_GpuCount; }
+
+        const std::vector<AfrSimFrameStats> & GetFrameStats() const { return m_Stats; }
+
+        // bytes described by an EndWrites() region list, exposed so callers can report it
+        double                    GetRegionBytes(AfrSimResource resource, const AfrSimRect * pRects, const unsigned int * pSubresources, unsigned int count) const;
+
+    private:
+        struct Resource
+        {
+            bool                    m_Valid;
+            unsigned int            m_Width;
+            unsigned int            m_Height;
+            unsigned int            m_ArraySize;
+            unsigned int            m_BytesPerTexel;
+            int                     m_TransferType;
+
+            std::vector<double>     m_Arrival;          // per GPU: time the latest incoming transfer lands
+            std::vector<double>     m_OutgoingUntil;    // per GPU: time the latest outgoing transfer stops reading the resource
+            std::vector<double>     m_EndAllAccess;     // per GPU: time of the last EndAllAccess (or frame end if it was never called)
+            std::vector<bool>       m_EndAllAccessDone; // per GPU: EndAllAccess was called during the GPU's last frame
+            bool                    m_WrittenThisFrame;
+            bool                    m_EndWritesThisFrame;
+        };
+
+        struct Link
+        {
+            double                  m_BusyUntil;
+        };
+
+        double                    Transfer(Link & link, double start, double bytes, double bandwidth, double latency);
+        void                      Deliver(Resource & res, unsigned int gpu, double start, double end, double bytes);
+
+        AfrSimulatorDesc          m_Desc;
+        std::vector<Resource>     m_Resources;
+
+        std::vector<double>       m_GpuFree;          // per GPU: time the GPU finishes its last frame
+        std::vector<double>       m_IncomingStart;    // per GPU: transfers landing on the GPU since its last frame started
+        std::vector<double>       m_IncomingEnd;
+        std::vector<unsigned int> m_IncomingGpu;
+        std::vector<Link>         m_P2PLink;          // per GPU: incoming GPU to GPU link
+        std::vector<Link>         m_UploadLink;       // per GPU: GPU to system memory
+        std::vector<Link>         m_DownloadLink;     // per GPU: system memory to GPU
+
+        unsigned int              m_FrameIndex;
+        bool                      m_InFrame;
+        double                    m_Cursor;           // current time on the current frame's GPU
+        double                    m_LastSubmit;
+        double                    m_LastFrameEnd;
+        AfrSimFrameStats          m_Current;
+
+        std::vector<AfrSimFrameStats> m_Stats;
+    };
+
+    //--------------------------------------------------------------------------------------
+    // Replays the exact AGS call sequence that the frame graph in CrossfireAPI11.cpp emits
+    // for one frame in the single face and all faces update modes.
+    // The settings mirror the globals that drive those modes. 2-step transfers go through
+    // a ring of transfer surfaces; the replay reads the newest slot that has landed, which
+    // the simulator can tell but the sample can't, so the sample waits for the newest one.
+    //--------------------------------------------------------------------------------------
+    struct AfrSimSampleSettings
+    {
+        int          m_ShadowTextureType;          // 0 = atlas (SHADOWFX_TEXTURE_2D), 1 = array (SHADOWFX_TEXTURE_2D_ARRAY)
+        int          m_ResourceTransferType;       // g_ResourceCfxTransferFlag
+        bool         m_EnableCrossfireApiTransfers;
+        bool         m_Enable2StepGpuTransfer;
+        bool         m_DelayEndAllAccess;
+        bool         m_SingleFacePerFrame;
+        unsigned int m_ShadowMapSize;
+        unsigned int m_AtlasScaleW;
+        unsigned int m_AtlasScaleH;
+        int          m_MaxShadowMapFrameDelay;
+        unsigned int m_TransferSlotCount;          // 2-step transfer surfaces, 0 = TransferRing::GetSlotCount(GpuCount)
+
+        // GPU cost of the passes in ms, used to place the calls on the timeline
+        double       m_DepthPrepassTime;
+        double       m_ShadowFaceTime;             // per cube face
+        double       m_MaskingTime;
+        double       m_FilteringTime;
+        double       m_SceneTime;
+
+        AfrSimSampleSettings()
+            : m_ShadowTextureType(0)
+            , m_ResourceTransferType(AFR_SIM_TRANSFER_1STEP_P2P)
+            , m_EnableCrossfireApiTransfers(true)
+            , m_Enable2StepGpuTransfer(false)
+            , m_DelayEndAllAccess(false)
+            , m_SingleFacePerFrame(false)
+            , m_ShadowMapSize(1024)
+            , m_AtlasScaleW(3)
+            , m_AtlasScaleH(2)
+            , m_MaxShadowMapFrameDelay(6)
+            , m_TransferSlotCount(0)
+            , m_DepthPrepassTime(0.5)
+            , m_ShadowFaceTime(0.3)
+            , m_MaskingTime(0.1)
+            , m_FilteringTime(1.0)
+            , m_SceneTime(1.5)
+        {}
+    };
+
+    class AfrSimSampleReplay
+    {
+    public:
+        AfrSimSampleReplay();
+
+        // creates the shadow map (and transfer shadow map) the way InitTransferredResources does
+        void Init(AfrSimulator & sim, const AfrSimSampleSettings & settings);
+        void Release(AfrSimulator & sim);
+
+        // the cube faces the next RenderFrame renders, up to 6
+        unsigned int GetNextFrameFaces(unsigned int * pFaces) const;
+
+        // one full OnD3D11FrameRender worth of calls
+        void RenderFrame(AfrSimulator & sim);
+
+    private:
+        void ReceiveShadowMapTransfer(AfrSimulator & sim, bool sending);
+        void RenderShadowMapFaces(AfrSimulator & sim, const unsigned int * pFaces, unsigned int faceCount);
+        void SendShadowMapFaces(AfrSimulator & sim);
+        void EndAllAccess(AfrSimulator & sim, AfrSimResource resource);
+
+        AfrSimSampleSettings        m_Settings;
+        AfrSimResource              m_ShadowMap;
+        std::vector<AfrSimResource> m_ShadowMapTransfer;  // ring slots
+        TransferRing                m_TransferRing;
+        unsigned int                m_ReadSlot;
+        std::vector<AfrSimResource> m_DelayedEndAllAccess;
+        int                         m_ShadowMapCfxFlag;
+        int                         m_ShadowMapTransferCfxFlag;
+        int                         m_ShadowMapFrameDelay;
+    };
+}
+
+#endif // AFR_SIMULATOR_H
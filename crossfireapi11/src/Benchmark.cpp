@@ -0,0 +1,455 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//--------------------------------------------------------------------------------------
+// File: Benchmark.cpp
+//
+// The scripted camera and light path of the benchmark mode, and its results.
+//--------------------------------------------------------------------------------------
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <math.h>
+#include <string.h>
+
+#ifdef _MSC_VER
+#pragma warning( disable : 4996 ) // fopen/sscanf are fine for this use
+#endif
+
+namespace AMD
+{
+    static const char * BENCHMARK_TRACK_NAME[BENCHMARK_TRACK_COUNT] = { "camera", "light" };
+
+    BenchmarkPath::BenchmarkPath() :
+        m_ErrorLine(0)
+    {
+    }
+
+    void BenchmarkPath::Clear()
+    {
+        for (unsigned int track = 0; track < BENCHMARK_TRACK_COUNT; track++)
+        {
+            m_Keys[track].clear();
+        }
+        m_ErrorLine = 0;
+    }
+
+    void BenchmarkPath::AddKey(BENCHMARK_TRACK track, const BenchmarkKey & key)
+    {
+        m_Keys[track].push_back(key);
+    }
+
+    bool BenchmarkPath::Load(const char * path)
+    {
+        Clear();
+
+        FILE * file = fopen(path, "rb");
+        if (file == NULL)
+        {
+            return false;
+        }
+
+        std::string text;
+        char        buffer[4096];
+        size_t      size = 0;
+        while ((size = fread(buffer, 1, sizeof(buffer), file)) > 0)
+        {
+            text.append(buffer, size);
+        }
+        fclose(file);
+
+        return Parse(text.c_str());
+    }
+
+    bool BenchmarkPath::Parse(const char * text)
+    {
+        Clear();
+
+        unsigned int lineNumber = 0;
+        const char * pLine = text;
+
+        while (*pLine != 0)
+        {
+            const char * pEnd = pLine;
+            while (*pEnd != 0 && *pEnd != '\n')
+            {
+                pEnd++;
+            }
+            lineNumber++;
+
+            // the line up to its comment
+            std::string line(pLine, pEnd);
+            const size_t comment = line.find('#');
+            if (comment != std::string::npos)
+            {
+                line.resize(comment);
+            }
+
+            char         name[16] = { 0 };
+            BenchmarkKey key;
+            int          consumed = 0;
+            const int    fields = sscanf(line.c_str(), " %15s %f %f %f %f %f %f %f %n", name,
+                                         &key.m_Time, &key.m_Eye[0], &key.m_Eye[1], &key.m_Eye[2], &key.m_At[0], &key.m_At[1], &key.m_At[2], &consumed);
+
+            if (fields > 0) // not an empty line
+            {
+                unsigned int track = 0;
+                while (track < BENCHMARK_TRACK_COUNT && strcmp(name, BENCHMARK_TRACK_NAME[track]) != 0)
+                {
+                    track++;
+                }
+
+                // a known track, 7 numbers and nothing after them, in increasing time
+                if (track == BENCHMARK_TRACK_COUNT || fields != 8 || line[consumed] != 0 || key.m_Time < 0.0f ||
+                    (m_Keys[track].empty() == false && key.m_Time < m_Keys[track].back().m_Time))
+                {
+                    m_ErrorLine = lineNumber;
+                    return false;
+                }
+
+                m_Keys[track].push_back(key);
+            }
+
+            pLine = *pEnd == 0 ? pEnd : pEnd + 1;
+        }
+
+        return true;
+    }
+
+    float BenchmarkPath::GetDuration() const
+    {
+        float duration = 0.0f;
+        for (unsigned int track = 0; track < BENCHMARK_TRACK_COUNT; track++)
+        {
+            if (m_Keys[track].empty() == false && m_Keys[track].back().m_Time > duration)
+            {
+                duration = m_Keys[track].back().m_Time;
+            }
+        }
+        return duration;
+    }
+
+    bool BenchmarkPath::Sample(BENCHMARK_TRACK track, float time, float * pEye, float * pAt) const
+    {
+        const std::vector<BenchmarkKey> & keys = m_Keys[track];
+        if (keys.empty() == true)
+        {
+            return false;
+        }
+
+        // the track repeats after its last key
+        const float duration = keys.back().m_Time;
+        if (duration > 0.0f && time > duration)
+        {
+            time = fmodf(time, duration);
+        }
+
+        unsigned int next = 0;
+        while (next < keys.size() && keys[next].m_Time <= time)
+        {
+            next++;
+        }
+
+        const BenchmarkKey & a = keys[next == 0 ? 0 : next - 1];
+        const BenchmarkKey & b = keys[next == keys.size() ? next - 1 : next];
+        const float          length = b.m_Time - a.m_Time;
+        const float          t = length > 0.0f ? (time - a.m_Time) / length : 0.0f;
+
+        for (unsigned int i = 0; i < 3; i++)
+        {
+            pEye[i] = a.m_Eye[i] + (b.m_Eye[i] - a.m_Eye[i]) * t;
+            pAt[i] = a.m_At[i] + (b.m_At[i] - a.m_At[i]) * t;
+        }
+        return true;
+    }
+
+    static double GetPercentile(const std::vector<double> & sorted, double percentile)
+    {
+        const double       rank = percentile * (double)(sorted.size() - 1);
+        const unsigned int below = (unsigned int)rank;
+        const unsigned int above = below + 1 < sorted.size() ? below + 1 : below;
+
+        return sorted[below] + (sorted[above] - sorted[below]) * (rank - (double)below);
+    }
+
+    BenchmarkStats GetBenchmarkStats(const double * pValues, unsigned int count)
+    {
+        BenchmarkStats stats;
+        memset(&stats, 0, sizeof(stats));
+
+        if (count == 0)
+        {
+            return stats;
+        }
+
+        std::vector<double> sorted(pValues, pValues + count);
+        std::sort(sorted.begin(), sorted.end());
+
+        double sum = 0.0;
+        for (unsigned int i = 0; i < count; i++)
+        {
+            sum += sorted[i];
+        }
+
+        stats.m_Count = count;
+        stats.m_Mean = sum / (double)count;
+
+        double squares = 0.0;
+        for (unsigned int i = 0; i < count; i++)
+        {
+            squares += (sorted[i] - stats.m_Mean) * (sorted[i] - stats.m_Mean);
+        }
+
+        stats.m_StdDev = count > 1 ? sqrt(squares / (double)(count - 1)) : 0.0;
+        stats.m_Min = sorted.front();
+        stats.m_P50 = GetPercentile(sorted, 0.50);
+        stats.m_P90 = GetPercentile(sorted, 0.90);
+        stats.m_P95 = GetPercentile(sorted, 0.95);
+        stats.m_P99 = GetPercentile(sorted, 0.99);
+        stats.m_Max = sorted.back();
+        return stats;
+    }
+
+    double GetBenchmarkConfidence95(const BenchmarkStats & stats)
+    {
+        // two sided 97.5% quantiles of Student's t, by degrees of freedom
+        static const double t[] = { 12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+                                    2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+                                    2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042 };
+
+        if (stats.m_Count < 2)
+        {
+            return 0.0;
+        }
+
+        const unsigned int degrees = stats.m_Count - 1;
+        const double       quantile = degrees <= sizeof(t) / sizeof(t[0]) ? t[degrees - 1] : 1.95996 + 2.37 / (double)degrees;
+
+        return quantile * stats.m_StdDev / sqrt((double)stats.m_Count);
+    }
+
+    BenchmarkResults::BenchmarkResults() :
+        m_FrameCount(0)
+    {
+    }
+
+    void BenchmarkResults::Reset()
+    {
+        m_Settings.clear();
+        m_Metrics.clear();
+        m_FrameCount = 0;
+    }
+
+    void BenchmarkResults::SetSetting(const char * name, const char * value)
+    {
+        for (size_t i = 0; i < m_Settings.size(); i++)
+        {
+            if (m_Settings[i].m_Name == name)
+            {
+                m_Settings[i].m_Value = value;
+                return;
+            }
+        }
+
+        Setting setting;
+        setting.m_Name = name;
+        setting.m_Value = value;
+        m_Settings.push_back(setting);
+    }
+
+    unsigned int BenchmarkResults::AddMetric(const char * name, const char * unit)
+    {
+        const unsigned int found = FindMetric(name);
+        if (found != BENCHMARK_INVALID_INDEX)
+        {
+            return found;
+        }
+
+        Metric metric;
+        metric.m_Name = name;
+        metric.m_Unit = unit;
+        metric.m_Samples.resize(m_FrameCount, 0.0);
+        m_Metrics.push_back(metric);
+
+        return (unsigned int)m_Metrics.size() - 1;
+    }
+
+    unsigned int BenchmarkResults::FindMetric(const char * name) const
+    {
+        for (size_t i = 0; i < m_Metrics.size(); i++)
+        {
+            if (m_Metrics[i].m_Name == name)
+            {
+                return (unsigned int)i;
+            }
+        }
+        return BENCHMARK_INVALID_INDEX;
+    }
+
+    void BenchmarkResults::BeginFrame()
+    {
+        m_FrameCount++;
+        for (size_t i = 0; i < m_Metrics.size(); i++)
+        {
+            m_Metrics[i].m_Samples.resize(m_FrameCount, 0.0);
+        }
+    }
+
+    void BenchmarkResults::Set(unsigned int metric, double value)
+    {
+        if (metric < m_Metrics.size() && m_FrameCount > 0)
+        {
+            m_Metrics[metric].m_Samples[m_FrameCount - 1] = value;
+        }
+    }
+
+    void BenchmarkResults::Add(unsigned int metric, double value)
+    {
+        if (metric < m_Metrics.size() && m_FrameCount > 0)
+        {
+            m_Metrics[metric].m_Samples[m_FrameCount - 1] += value;
+        }
+    }
+
+    double BenchmarkResults::Get(unsigned int frame, unsigned int metric) const
+    {
+        return metric < m_Metrics.size() && frame < m_FrameCount ? m_Metrics[metric].m_Samples[frame] : 0.0;
+    }
+
+    BenchmarkStats BenchmarkResults::GetStats(unsigned int metric) const
+    {
+        if (metric >= m_Metrics.size() || m_FrameCount == 0)
+        {
+            return GetBenchmarkStats(NULL, 0);
+        }
+        return GetBenchmarkStats(&m_Metrics[metric].m_Samples[0], m_FrameCount);
+    }
+
+    // a JSON string, or a CSV field: quoted, with the quotes inside escaped
+    static void WriteString(FILE * pFile, const std::string & text, bool json)
+    {
+        fputc('"', pFile);
+        for (size_t i = 0; i < text.size(); i++)
+        {
+            const unsigned char c = (unsigned char)text[i];
+            if (json == true && (c == '"' || c == '\\'))
+            {
+                fprintf(pFile, "\\%c", c);
+            }
+            else if (json == true && c < 0x20)
+            {
+                fprintf(pFile, "\\u%04x", c);
+            }
+            else if (json == false && c == '"')
+            {
+                fputs("\"\"", pFile);
+            }
+            else
+            {
+                fputc(c, pFile);
+            }
+        }
+        fputc('"', pFile);
+    }
+
+    bool BenchmarkResults::WriteJson(FILE * pFile, bool samples) const
+    {
+        fprintf(pFile, "{\n  \"settings\": {");
+        for (size_t i = 0; i < m_Settings.size(); i++)
+        {
+            fprintf(pFile, "%s\n    ", i == 0 ? "" : ",");
+            WriteString(pFile, m_Settings[i].m_Name, true);
+            fprintf(pFile, ": ");
+            WriteString(pFile, m_Settings[i].m_Value, true);
+        }
+        fprintf(pFile, "%s},\n  \"frames\": %u,\n  \"metrics\": [", m_Settings.empty() ? "" : "\n  ", m_FrameCount);
+
+        for (unsigned int metric = 0; metric < m_Metrics.size(); metric++)
+        {
+            const BenchmarkStats stats = GetStats(metric);
+
+            fprintf(pFile, "%s\n    { \"name\": ", metric == 0 ? "" : ",");
+            WriteString(pFile, m_Metrics[metric].m_Name, true);
+            fprintf(pFile, ", \"unit\": ");
+            WriteString(pFile, m_Metrics[metric].m_Unit, true);
+            fprintf(pFile, ",\n      \"mean\": %.9g, \"stddev\": %.9g, \"ci95\": %.9g, \"min\": %.9g, \"p50\": %.9g, \"p90\": %.9g, \"p95\": %.9g, \"p99\": %.9g, \"max\": %.9g",
+                    stats.m_Mean, stats.m_StdDev, GetBenchmarkConfidence95(stats), stats.m_Min, stats.m_P50, stats.m_P90, stats.m_P95, stats.m_P99, stats.m_Max);
+
+            if (samples == true)
+            {
+                fprintf(pFile, ",\n      \"samples\": [");
+                for (unsigned int frame = 0; frame < m_FrameCount; frame++)
+                {
+                    fprintf(pFile, "%s%.9g", frame == 0 ? "" : ", ", m_Metrics[metric].m_Samples[frame]);
+                }
+                fprintf(pFile, "]");
+            }
+            fprintf(pFile, " }");
+        }
+        fprintf(pFile, "%s]\n}\n", m_Metrics.empty() ? "" : "\n  ");
+
+        return ferror(pFile) == 0;
+    }
+
+    bool BenchmarkResults::WriteCsv(FILE * pFile) const
+    {
+        // the settings first, so that the rows of several runs can be told apart when concatenated
+        for (size_t i = 0; i < m_Settings.size(); i++)
+        {
+            WriteString(pFile, m_Settings[i].m_Name, false);
+            fputc(',', pFile);
+        }
+        fprintf(pFile, "metric,unit,frames,mean,stddev,ci95,min,p50,p90,p95,p99,max\n");
+
+        for (unsigned int metric = 0; metric < m_Metrics.size(); metric++)
+        {
+            const BenchmarkStats stats = GetStats(metric);
+
+            for (size_t i = 0; i < m_Settings.size(); i++)
+            {
+                WriteString(pFile, m_Settings[i].m_Value, false);
+                fputc(',', pFile);
+            }
+            WriteString(pFile, m_Metrics[metric].m_Name, false);
+            fputc(',', pFile);
+            WriteString(pFile, m_Metrics[metric].m_Unit, false);
+            fprintf(pFile, ",%u,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g\n", stats.m_Count,
+                    stats.m_Mean, stats.m_StdDev, GetBenchmarkConfidence95(stats), stats.m_Min, stats.m_P50, stats.m_P90, stats.m_P95, stats.m_P99, stats.m_Max);
+        }
+
+        return ferror(pFile) == 0;
+    }
+
+    bool BenchmarkResults::Save(const char * path) const
+    {
+        FILE * file = fopen(path, "w");
+        if (file == NULL)
+        {
+            return false;
+        }
+
+        const size_t length = strlen(path);
+        const bool   csv = length >= 4 && (strcmp(path + length - 4, ".csv") == 0 || strcmp(path + length - 4, ".CSV") == 0);
+
+        const bool written = csv == true ? WriteCsv(file) : WriteJson(file, true);
+        return fclose(file) == 0 && written == true;
+    }
+}
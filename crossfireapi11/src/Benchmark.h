@@ -0,0 +1,171 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//--------------------------------------------------------------------------------------
+// File: Benchmark.h
+//
+// The parts of the benchmark mode that don't need a device: the scripted camera and light
+// path, and the per frame samples of every measured value with their statistics, saved as
+// JSON or CSV.
+//
+// A path file has one key per line, a track name, the time in seconds and two points,
+// the eye and the point it looks at; '#' starts a comment:
+//
+//     # track   time   eye x y z        at x y z
+//     camera    0.0    0.0 20.0 -50.0   0.0 5.0 0.0
+//     light     0.0    30.0 40.0 -20.0  0.0 0.0 0.0
+//
+// The keys of a track are in increasing time, and between two keys the points are
+// interpolated linearly. A track repeats after its last key, and a track without keys
+// leaves its camera where it is.
+//
+// This code has no dependency on Windows, D3D11 or AGS.
+//--------------------------------------------------------------------------------------
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+namespace AMD
+{
+    static const unsigned int BENCHMARK_INVALID_INDEX = 0xffffffff;
+
+    typedef enum BENCHMARK_TRACK_t
+    {
+        BENCHMARK_TRACK_CAMERA = 0,
+        BENCHMARK_TRACK_LIGHT  = 1,
+        BENCHMARK_TRACK_COUNT  = 2,
+    } BENCHMARK_TRACK;
+
+    struct BenchmarkKey
+    {
+        float m_Time;                       // seconds from the start of the path
+        float m_Eye[3];
+        float m_At[3];
+    };
+
+    class BenchmarkPath
+    {
+    public:
+        BenchmarkPath();
+
+        // false if the file can't be read or a line is malformed, see GetErrorLine
+        bool         Load(const char * path);
+        bool         Parse(const char * text);
+        unsigned int GetErrorLine() const { return m_ErrorLine; }
+
+        void         Clear();
+        void         AddKey(BENCHMARK_TRACK track, const BenchmarkKey & key); // after the last key of the track
+
+        unsigned int GetKeyCount(BENCHMARK_TRACK track) const { return (unsigned int)m_Keys[track].size(); }
+        float        GetDuration() const;   // of the longest track
+
+        // the eye and the point it looks at, time seconds from the start; false if the track has no keys
+        bool         Sample(BENCHMARK_TRACK track, float time, float * pEye, float * pAt) const;
+
+    private:
+        std::vector<BenchmarkKey> m_Keys[BENCHMARK_TRACK_COUNT];
+        unsigned int              m_ErrorLine;  // 1 based, 0 without error
+    };
+
+    // percentiles interpolate linearly between the sorted samples
+    struct BenchmarkStats
+    {
+        unsigned int m_Count;
+        double       m_Mean;
+        double       m_StdDev;              // of the samples, n - 1
+        double       m_Min;
+        double       m_P50;
+        double       m_P90;
+        double       m_P95;
+        double       m_P99;
+        double       m_Max;
+    };
+
+    BenchmarkStats GetBenchmarkStats(const double * pValues, unsigned int count);
+
+    // the half width of the 95% confidence interval of the mean, Student's t with count - 1 degrees of freedom
+    double         GetBenchmarkConfidence95(const BenchmarkStats & stats);
+
+    //--------------------------------------------------------------------------------------
+    // A row of samples per measured frame, a column per metric. Metrics are added before
+    // the first frame or during it, the frames before have 0 for them.
+    //--------------------------------------------------------------------------------------
+    class BenchmarkResults
+    {
+    public:
+        BenchmarkResults();
+
+        void           Reset();             // drops the settings, the metrics and the frames
+
+        // name = value pairs that describe the run, written with the results; set again replaces
+        void           SetSetting(const char * name, const char * value);
+        unsigned int   GetSettingCount() const { return (unsigned int)m_Settings.size(); }
+        const char *   GetSettingName(unsigned int setting) const { return m_Settings[setting].m_Name.c_str(); }
+        const char *   GetSettingValue(unsigned int setting) const { return m_Settings[setting].m_Value.c_str(); }
+
+        // the index of the metric, added if there isn't one of that name yet
+        unsigned int   AddMetric(const char * name, const char * unit);
+        unsigned int   FindMetric(const char * name) const;
+        unsigned int   GetMetricCount() const { return (unsigned int)m_Metrics.size(); }
+        const char *   GetMetricName(unsigned int metric) const { return m_Metrics[metric].m_Name.c_str(); }
+        const char *   GetMetricUnit(unsigned int metric) const { return m_Metrics[metric].m_Unit.c_str(); }
+
+        // starts a frame with every metric at 0; Set and Add go to the last frame
+        void           BeginFrame();
+        void           Set(unsigned int metric, double value);
+        void           Add(unsigned int metric, double value);
+        unsigned int   GetFrameCount() const { return m_FrameCount; }
+        double         Get(unsigned int frame, unsigned int metric) const;
+
+        BenchmarkStats GetStats(unsigned int metric) const;
+
+        // JSON: the settings and the statistics of every metric, with the samples if samples is true.
+        // CSV: a row per metric with its statistics.
+        bool           WriteJson(FILE * pFile, bool samples) const;
+        bool           WriteCsv(FILE * pFile) const;
+
+        // JSON with samples, or CSV if the path ends with .csv
+        bool           Save(const char * path) const;
+
+    private:
+        struct Setting
+        {
+            std::string m_Name;
+            std::string m_Value;
+        };
+
+        struct Metric
+        {
+            std::string         m_Name;
+            std::string         m_Unit;
+            std::vector<double> m_Samples;  // per frame
+        };
+
+        std::vector<Setting> m_Settings;
+        std::vector<Metric>  m_Metrics;
+        unsigned int         m_FrameCount;
+    };
+}
+
+#endif // BENCHMARK_H
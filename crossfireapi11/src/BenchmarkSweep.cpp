@@ -0,0 +1,399 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//--------------------------------------------------------------------------------------
+// File: BenchmarkSweep.cpp
+//
+// The configurations of a benchmark sweep and their ranking.
+//--------------------------------------------------------------------------------------
+#include "BenchmarkSweep.h"
+
+#include <algorithm>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _MSC_VER
+#pragma warning( disable : 4996 ) // fopen/sprintf are fine for this use
+#endif
+
+namespace AMD
+{
+    static const char * BENCHMARK_SWEEP_AXIS_NAME[BENCHMARK_SWEEP_AXIS_COUNT] = { "texture", "transfer", "2step", "delay", "size", "update" };
+
+    static std::string Trim(const std::string & text)
+    {
+        const size_t first = text.find_first_not_of(" \t\r");
+        const size_t last = text.find_last_not_of(" \t\r");
+        return first == std::string::npos ? std::string() : text.substr(first, last - first + 1);
+    }
+
+    static bool ParseValue(BENCHMARK_SWEEP_AXIS axis, const std::string & name, int & value)
+    {
+        switch (axis)
+        {
+        case BENCHMARK_SWEEP_AXIS_TEXTURE:
+            if (name == "atlas") { value = 0; return true; }
+            if (name == "array") { value = 1; return true; }
+            return false;
+
+        case BENCHMARK_SWEEP_AXIS_TRANSFER:
+            for (int transfer = AFR_SIM_TRANSFER_DEFAULT; transfer <= AFR_SIM_TRANSFER_2STEP_WITH_BROADCAST; transfer++)
+            {
+                if (name == GetAfrSimTransferName(transfer)) { value = transfer; return true; }
+            }
+            return false;
+
+        case BENCHMARK_SWEEP_AXIS_2STEP:
+        case BENCHMARK_SWEEP_AXIS_DELAY_END_ALL_ACCESS:
+            if (name == "off") { value = 0; return true; }
+            if (name == "on") { value = 1; return true; }
+            return false;
+
+        case BENCHMARK_SWEEP_AXIS_SHADOW_MAP_SIZE:
+            {
+                char * pEnd = NULL;
+                const long size = strtol(name.c_str(), &pEnd, 10);
+                if (name.empty() == true || *pEnd != 0 || size <= 0 || size > 16384) { return false; }
+                value = (int)size;
+                return true;
+            }
+
+        case BENCHMARK_SWEEP_AXIS_UPDATE:
+            if (name == "all") { value = 0; return true; }
+            if (name == "single") { value = 1; return true; }
+            return false;
+
+        default:
+            return false;
+        }
+    }
+
+    void ApplyBenchmarkSweepConfig(const BenchmarkSweepConfig & config, AfrSimSampleSettings & settings)
+    {
+        settings.m_ShadowTextureType = config.m_ShadowTextureType;
+        settings.m_ResourceTransferType = config.m_TransferType;
+        settings.m_EnableCrossfireApiTransfers = config.m_TransferType != AFR_SIM_TRANSFER_DEFAULT;
+        settings.m_Enable2StepGpuTransfer = config.m_Enable2StepGpuTransfer;
+        settings.m_DelayEndAllAccess = config.m_DelayEndAllAccess;
+        settings.m_ShadowMapSize = config.m_ShadowMapSize;
+        settings.m_SingleFacePerFrame = config.m_SingleFacePerFrame;
+    }
+
+    BenchmarkSweep::BenchmarkSweep() :
+        m_ErrorLine(0)
+    {
+        Reset();
+    }
+
+    void BenchmarkSweep::Reset()
+    {
+        const AfrSimSampleSettings defaults;
+        const int                  values[BENCHMARK_SWEEP_AXIS_COUNT] =
+        {
+            defaults.m_ShadowTextureType, defaults.m_ResourceTransferType, defaults.m_Enable2StepGpuTransfer ? 1 : 0,
+            defaults.m_DelayEndAllAccess ? 1 : 0, (int)defaults.m_ShadowMapSize, defaults.m_SingleFacePerFrame ? 1 : 0,
+        };
+
+        for (unsigned int axis = 0; axis < BENCHMARK_SWEEP_AXIS_COUNT; axis++)
+        {
+            m_Values[axis].assign(1, values[axis]);
+        }
+        m_Metric = "Frame Time";
+        m_Results.clear();
+        m_ErrorLine = 0;
+    }
+
+    void BenchmarkSweep::SetAxis(BENCHMARK_SWEEP_AXIS axis, const int * pValues, unsigned int count)
+    {
+        if (count > 0)
+        {
+            m_Values[axis].assign(pValues, pValues + count);
+            m_Results.clear();
+        }
+    }
+
+    bool BenchmarkSweep::Load(const char * path)
+    {
+        Reset();
+
+        FILE * file = fopen(path, "rb");
+        if (file == NULL)
+        {
+            return false;
+        }
+
+        std::string text;
+        char        buffer[4096];
+        size_t      size = 0;
+        while ((size = fread(buffer, 1, sizeof(buffer), file)) > 0)
+        {
+            text.append(buffer, size);
+        }
+        fclose(file);
+
+        return Parse(text.c_str());
+    }
+
+    bool BenchmarkSweep::Parse(const char * text)
+    {
+        Reset();
+
+        unsigned int lineNumber = 0;
+        const char * pLine = text;
+
+        while (*pLine != 0)
+        {
+            const char * pEnd = pLine;
+            while (*pEnd != 0 && *pEnd != '\n')
+            {
+                pEnd++;
+            }
+            lineNumber++;
+
+            // the line up to its comment
+            std::string line(pLine, pEnd);
+            const size_t comment = line.find('#');
+            if (comment != std::string::npos)
+            {
+                line.resize(comment);
+            }
+            pLine = *pEnd == 0 ? pEnd : pEnd + 1;
+
+            if (Trim(line).empty() == true)
+            {
+                continue;
+            }
+
+            const size_t      equal = line.find('=');
+            const std::string name = Trim(line.substr(0, equal));
+            const std::string values = equal == std::string::npos ? std::string() : Trim(line.substr(equal + 1));
+
+            if (values.empty() == true)
+            {
+                m_ErrorLine = lineNumber;
+                return false;
+            }
+
+            if (name == "metric")
+            {
+                m_Metric = values;
+                continue;
+            }
+
+            unsigned int axis = 0;
+            while (axis < BENCHMARK_SWEEP_AXIS_COUNT && name != BENCHMARK_SWEEP_AXIS_NAME[axis])
+            {
+                axis++;
+            }
+
+            // a known axis and values it knows, separated by commas
+            std::vector<int> parsed;
+            size_t           start = 0;
+            while (axis < BENCHMARK_SWEEP_AXIS_COUNT && start <= values.size())
+            {
+                size_t comma = values.find(',', start);
+                comma = comma == std::string::npos ? values.size() : comma;
+
+                int value = 0;
+                if (ParseValue((BENCHMARK_SWEEP_AXIS)axis, Trim(values.substr(start, comma - start)), value) == false)
+                {
+                    break;
+                }
+                parsed.push_back(value);
+                start = comma + 1;
+            }
+
+            if (axis == BENCHMARK_SWEEP_AXIS_COUNT || start <= values.size())
+            {
+                m_ErrorLine = lineNumber;
+                return false;
+            }
+
+            m_Values[axis] = parsed;
+        }
+
+        return true;
+    }
+
+    unsigned int BenchmarkSweep::GetConfigCount() const
+    {
+        unsigned int count = 1;
+        for (unsigned int axis = 0; axis < BENCHMARK_SWEEP_AXIS_COUNT; axis++)
+        {
+            count *= (unsigned int)m_Values[axis].size();
+        }
+        return count;
+    }
+
+    BenchmarkSweepConfig BenchmarkSweep::GetConfig(unsigned int config) const
+    {
+        // the digits of config, the last axis the least significant
+        int value[BENCHMARK_SWEEP_AXIS_COUNT];
+        for (int axis = BENCHMARK_SWEEP_AXIS_COUNT - 1; axis >= 0; axis--)
+        {
+            const unsigned int count = (unsigned int)m_Values[axis].size();
+            value[axis] = m_Values[axis][config % count];
+            config /= count;
+        }
+
+        BenchmarkSweepConfig result;
+        result.m_ShadowTextureType = value[BENCHMARK_SWEEP_AXIS_TEXTURE];
+        result.m_TransferType = value[BENCHMARK_SWEEP_AXIS_TRANSFER];
+        result.m_Enable2StepGpuTransfer = value[BENCHMARK_SWEEP_AXIS_2STEP] != 0;
+        result.m_DelayEndAllAccess = value[BENCHMARK_SWEEP_AXIS_DELAY_END_ALL_ACCESS] != 0;
+        result.m_ShadowMapSize = (unsigned int)value[BENCHMARK_SWEEP_AXIS_SHADOW_MAP_SIZE];
+        result.m_SingleFacePerFrame = value[BENCHMARK_SWEEP_AXIS_UPDATE] != 0;
+        return result;
+    }
+
+    void BenchmarkSweep::GetSettings(const BenchmarkSweepConfig & config, BenchmarkResults & results)
+    {
+        char size[16];
+        sprintf(size, "%u", config.m_ShadowMapSize);
+
+        results.SetSetting("texture", config.m_ShadowTextureType == 0 ? "atlas" : "array");
+        results.SetSetting("transfer", GetAfrSimTransferName(config.m_TransferType));
+        results.SetSetting("api transfers", config.m_TransferType != AFR_SIM_TRANSFER_DEFAULT ? "on" : "off");
+        results.SetSetting("2-step", config.m_Enable2StepGpuTransfer ? "on" : "off");
+        results.SetSetting("delay EndAllAccess", config.m_DelayEndAllAccess ? "on" : "off");
+        results.SetSetting("update", config.m_SingleFacePerFrame ? "single face" : "all faces");
+        results.SetSetting("shadow map size", size);
+    }
+
+    void BenchmarkSweep::SetResult(unsigned int config, const BenchmarkStats & stats)
+    {
+        if (m_Results.size() != GetConfigCount())
+        {
+            BenchmarkStats none;
+            memset(&none, 0, sizeof(none));
+            m_Results.assign(GetConfigCount(), none);
+        }
+
+        if (config < m_Results.size())
+        {
+            m_Results[config] = stats;
+        }
+    }
+
+    struct BenchmarkSweepMeanLess
+    {
+        const std::vector<BenchmarkStats> * m_pResults;
+
+        bool operator()(unsigned int a, unsigned int b) const
+        {
+            const double meanA = (*m_pResults)[a].m_Mean;
+            const double meanB = (*m_pResults)[b].m_Mean;
+            return meanA < meanB || (meanA == meanB && a < b);
+        }
+    };
+
+    std::vector<unsigned int> BenchmarkSweep::GetRanking() const
+    {
+        std::vector<unsigned int> ranking;
+        for (unsigned int config = 0; config < (unsigned int)m_Results.size(); config++)
+        {
+            if (m_Results[config].m_Count > 0)
+            {
+                ranking.push_back(config);
+            }
+        }
+
+        BenchmarkSweepMeanLess less = { &m_Results };
+        std::sort(ranking.begin(), ranking.end(), less);
+        return ranking;
+    }
+
+    bool BenchmarkSweep::IsSlowerThanBest(unsigned int config) const
+    {
+        const std::vector<unsigned int> ranking = GetRanking();
+        if (ranking.empty() == true || config >= m_Results.size() || m_Results[config].m_Count == 0)
+        {
+            return false;
+        }
+
+        const BenchmarkStats & best = m_Results[ranking[0]];
+        const BenchmarkStats & stats = m_Results[config];
+        return stats.m_Mean - GetBenchmarkConfidence95(stats) > best.m_Mean + GetBenchmarkConfidence95(best);
+    }
+
+    bool BenchmarkSweep::WriteRanking(FILE * pFile) const
+    {
+        const std::vector<unsigned int> ranking = GetRanking();
+
+        fprintf(pFile, "%u of %u configurations, ranked by %s; '~' the best can't be told apart from\n\n",
+            (unsigned int)ranking.size(), GetConfigCount(), m_Metric.c_str());
+        fprintf(pFile, "%4s  %-7s %-9s %-5s %-5s %5s  %-6s %7s %10s %10s %10s %10s %9s\n",
+            "rank", "texture", "transfer", "2step", "delay", "size", "update", "frames", "mean", "ci95", "p95", "p99", "vs best");
+
+        for (unsigned int rank = 0; rank < (unsigned int)ranking.size(); rank++)
+        {
+            const BenchmarkSweepConfig config = GetConfig(ranking[rank]);
+            const BenchmarkStats &     stats = m_Results[ranking[rank]];
+            const double               best = m_Results[ranking[0]].m_Mean;
+
+            fprintf(pFile, "%4u  %-7s %-9s %-5s %-5s %5u  %-6s %7u %10.4f %10.4f %10.4f %10.4f %+8.1f%%%s\n",
+                rank + 1, config.m_ShadowTextureType == 0 ? "atlas" : "array", GetAfrSimTransferName(config.m_TransferType),
+                config.m_Enable2StepGpuTransfer ? "on" : "off", config.m_DelayEndAllAccess ? "on" : "off", config.m_ShadowMapSize,
+                config.m_SingleFacePerFrame ? "single" : "all", stats.m_Count, stats.m_Mean, GetBenchmarkConfidence95(stats),
+                stats.m_P95, stats.m_P99, best > 0.0 ? (stats.m_Mean / best - 1.0) * 100.0 : 0.0,
+                IsSlowerThanBest(ranking[rank]) ? "" : " ~");
+        }
+
+        return ferror(pFile) == 0;
+    }
+
+    bool BenchmarkSweep::WriteRankingCsv(FILE * pFile) const
+    {
+        const std::vector<unsigned int> ranking = GetRanking();
+
+        fprintf(pFile, "rank,config,texture,transfer,2step,delay,size,update,metric,frames,mean,stddev,ci95,min,p50,p90,p95,p99,max,tied\n");
+
+        for (unsigned int rank = 0; rank < (unsigned int)ranking.size(); rank++)
+        {
+            const BenchmarkSweepConfig config = GetConfig(ranking[rank]);
+            const BenchmarkStats &     stats = m_Results[ranking[rank]];
+
+            fprintf(pFile, "%u,%u,%s,%s,%s,%s,%u,%s,\"%s\",%u,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%d\n",
+                rank + 1, ranking[rank], config.m_ShadowTextureType == 0 ? "atlas" : "array", GetAfrSimTransferName(config.m_TransferType),
+                config.m_Enable2StepGpuTransfer ? "on" : "off", config.m_DelayEndAllAccess ? "on" : "off", config.m_ShadowMapSize,
+                config.m_SingleFacePerFrame ? "single" : "all", m_Metric.c_str(), stats.m_Count, stats.m_Mean, stats.m_StdDev,
+                GetBenchmarkConfidence95(stats), stats.m_Min, stats.m_P50, stats.m_P90, stats.m_P95, stats.m_P99, stats.m_Max,
+                IsSlowerThanBest(ranking[rank]) ? 0 : 1);
+        }
+
+        return ferror(pFile) == 0;
+    }
+
+    bool BenchmarkSweep::SaveRanking(const char * path) const
+    {
+        FILE * file = fopen(path, "w");
+        if (file == NULL)
+        {
+            return false;
+        }
+
+        const size_t length = strlen(path);
+        const bool   csv = length >= 4 && (strcmp(path + length - 4, ".csv") == 0 || strcmp(path + length - 4, ".CSV") == 0);
+
+        const bool written = csv == true ? WriteRankingCsv(file) : WriteRanking(file);
+        return fclose(file) == 0 && written == true;
+    }
+}
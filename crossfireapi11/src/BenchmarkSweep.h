@@ -0,0 +1,131 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//--------------------------------------------------------------------------------------
+// File: BenchmarkSweep.h
+//
+// The cartesian product of the settings the transfers of the sample depend on, run one
+// configuration after the other with the benchmark mode, and the configurations ranked
+// by a metric of their results.
+//
+// A sweep file has one line per axis, its name and its values; '#' starts a comment, and
+// an axis without a line keeps the default of the sample:
+//
+//     texture  = atlas, array                  # atlas
+//     transfer = 1step, 2step, broadcast       # 1step; also default and disable
+//     2step    = off, on                       # off
+//     delay    = off, on                       # off, EndAllAccess at the end of the frame
+//     size     = 1024, 2048                    # 1024
+//     update   = all, single                   # all faces every N frames, or a face a frame
+//     metric   = Frame Time                    # the metric the configurations are ranked by
+//
+// The configurations are numbered with the first axis changing the slowest. The ranking
+// is by increasing mean, and marks the configurations whose 95% confidence interval of
+// the mean overlaps the one of the first: the runs don't tell them apart from it.
+//
+// This code has no dependency on Windows, D3D11 or AGS.
+//--------------------------------------------------------------------------------------
+#ifndef BENCHMARK_SWEEP_H
+#define BENCHMARK_SWEEP_H
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+
+#include "AfrSimulator.h"
+#include "Benchmark.h"
+
+namespace AMD
+{
+    typedef enum BENCHMARK_SWEEP_AXIS_t
+    {
+        BENCHMARK_SWEEP_AXIS_TEXTURE              = 0, // 0 = atlas, 1 = array, as AfrSimSampleSettings::m_ShadowTextureType
+        BENCHMARK_SWEEP_AXIS_TRANSFER             = 1, // AFR_SIM_TRANSFER
+        BENCHMARK_SWEEP_AXIS_2STEP                = 2, // 0 = off, 1 = on
+        BENCHMARK_SWEEP_AXIS_DELAY_END_ALL_ACCESS = 3,
+        BENCHMARK_SWEEP_AXIS_SHADOW_MAP_SIZE      = 4, // texels
+        BENCHMARK_SWEEP_AXIS_UPDATE               = 5, // 0 = all faces, 1 = single face per frame
+        BENCHMARK_SWEEP_AXIS_COUNT                = 6,
+    } BENCHMARK_SWEEP_AXIS;
+
+    struct BenchmarkSweepConfig
+    {
+        int          m_ShadowTextureType;
+        int          m_TransferType;            // AFR_SIM_TRANSFER_DEFAULT is the driver tracking, without API transfers
+        bool         m_Enable2StepGpuTransfer;
+        bool         m_DelayEndAllAccess;
+        unsigned int m_ShadowMapSize;
+        bool         m_SingleFacePerFrame;
+    };
+
+    // the settings of the replay that match a configuration, the others left as they are
+    void ApplyBenchmarkSweepConfig(const BenchmarkSweepConfig & config, AfrSimSampleSettings & settings);
+
+    class BenchmarkSweep
+    {
+    public:
+        BenchmarkSweep();                       // a single configuration, the defaults of the sample
+
+        // false if the file can't be read or a line is malformed, see GetErrorLine
+        bool                 Load(const char * path);
+        bool                 Parse(const char * text);
+        unsigned int         GetErrorLine() const { return m_ErrorLine; }
+
+        void                 Reset();           // back to the defaults, without results
+
+        // replaces the values of an axis; at least one value
+        void                 SetAxis(BENCHMARK_SWEEP_AXIS axis, const int * pValues, unsigned int count);
+        unsigned int         GetAxisValueCount(BENCHMARK_SWEEP_AXIS axis) const { return (unsigned int)m_Values[axis].size(); }
+
+        void                 SetMetric(const char * metric) { m_Metric = metric; }
+        const char *         GetMetric() const { return m_Metric.c_str(); }
+
+        unsigned int         GetConfigCount() const;
+        BenchmarkSweepConfig GetConfig(unsigned int config) const;
+
+        // the settings of a configuration, as BenchmarkResults::SetSetting pairs
+        static void          GetSettings(const BenchmarkSweepConfig & config, BenchmarkResults & results);
+
+        // the statistics of the metric in the run of a configuration
+        void                 SetResult(unsigned int config, const BenchmarkStats & stats);
+
+        // the configurations that ran, by increasing mean of the metric
+        std::vector<unsigned int> GetRanking() const;
+
+        // false if the confidence interval of the configuration overlaps the one of the first of the ranking
+        bool                 IsSlowerThanBest(unsigned int config) const;
+
+        // a table of the ranking, as text or CSV
+        bool                 WriteRanking(FILE * pFile) const;
+        bool                 WriteRankingCsv(FILE * pFile) const;
+
+        // CSV if the path ends with .csv, text otherwise
+        bool                 SaveRanking(const char * path) const;
+
+    private:
+        std::vector<int>            m_Values[BENCHMARK_SWEEP_AXIS_COUNT];
+        std::string                 m_Metric;
+        std::vector<BenchmarkStats> m_Results;  // per configuration, m_Count 0 if it didn't run
+        unsigned int                m_ErrorLine;
+    };
+}
+
+#endif // BENCHMARK_SWEEP_H
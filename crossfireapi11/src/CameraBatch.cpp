@@ -0,0 +1,464 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//--------------------------------------------------------------------------------------
+// File: CameraBatch.cpp
+//
+// The matrices of S_CAMERA_DATA for a batch of cameras, without a general 4x4 inverse.
+//--------------------------------------------------------------------------------------
+#include "CameraBatch.h"
+
+#include <math.h>
+#include <string.h>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE__)
+#define CAMERA_BATCH_SSE 1
+#include <xmmintrin.h>
+#else
+#define CAMERA_BATCH_SSE 0
+#endif
+
+namespace AMD
+{
+    static const unsigned int LANE_COUNT = 4;
+
+    // float offsets into CameraBatchInput and CameraBatchMatrices
+    static const unsigned int INPUT_EYE = 0;
+    static const unsigned int INPUT_RIGHT = 3;
+    static const unsigned int INPUT_UP = 6;
+    static const unsigned int INPUT_AHEAD = 9;
+    static const unsigned int INPUT_PROJECTION = 12;
+
+    static const unsigned int OUTPUT_VIEW = 0;
+    static const unsigned int OUTPUT_PROJECTION = 16;
+    static const unsigned int OUTPUT_VIEW_INV = 32;
+    static const unsigned int OUTPUT_PROJECTION_INV = 48;
+    static const unsigned int OUTPUT_VIEW_PROJECTION = 64;
+    static const unsigned int OUTPUT_VIEW_PROJECTION_INV = 80;
+
+    static_assert(sizeof(CameraBatchInput) == (INPUT_PROJECTION + 16) * sizeof(float), "CameraBatchInput is read as floats");
+    static_assert(sizeof(CameraBatchMatrices) == (OUTPUT_VIEW_PROJECTION_INV + 16) * sizeof(float), "CameraBatchMatrices is written as floats");
+
+    // the look and up directions of the faces, as InitializeCubeCamera passes them to SetViewParams
+    static const float s_CubeFaceAhead[CAMERA_CUBE_FACE_COUNT][3] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+    static const float s_CubeFaceUp[CAMERA_CUBE_FACE_COUNT][3]    = { { 0, 1, 0 }, { 0, 1, 0 }, { 0, 0, -1 }, { 0, 0, 1 }, { 0, 1, 0 }, { 0, 1, 0 } };
+
+    void GetCubeFaceBasis(unsigned int face, float right[3], float up[3], float ahead[3])
+    {
+        face %= CAMERA_CUBE_FACE_COUNT;
+
+        const float * a = s_CubeFaceAhead[face];
+        const float * u = s_CubeFaceUp[face];
+
+        // right = up x ahead, exact for axis aligned vectors
+        right[0] = u[1] * a[2] - u[2] * a[1];
+        right[1] = u[2] * a[0] - u[0] * a[2];
+        right[2] = u[0] * a[1] - u[1] * a[0];
+
+        memcpy(up, u, 3 * sizeof(float));
+        memcpy(ahead, a, 3 * sizeof(float));
+    }
+
+    bool IsCameraProjectionSupported(const float * p)
+    {
+        return p[1] == 0.0f && p[2] == 0.0f && p[3] == 0.0f &&
+               p[4] == 0.0f && p[6] == 0.0f && p[7] == 0.0f &&
+               p[0] != 0.0f && p[5] != 0.0f &&
+               p[10] * p[15] - p[11] * p[14] != 0.0f;
+    }
+
+    // cofactor expansion, for the projections IsCameraProjectionSupported rejects
+    static void InvertGeneral(const float * m, float * inv)
+    {
+        float r[16];
+
+        r[0]  =  m[5] * m[10] * m[15] - m[5] * m[11] * m[14] - m[9] * m[6] * m[15] + m[9] * m[7] * m[14] + m[13] * m[6] * m[11] - m[13] * m[7] * m[10];
+        r[4]  = -m[4] * m[10] * m[15] + m[4] * m[11] * m[14] + m[8] * m[6] * m[15] - m[8] * m[7] * m[14] - m[12] * m[6] * m[11] + m[12] * m[7] * m[10];
+        r[8]  =  m[4] * m[9]  * m[15] - m[4] * m[11] * m[13] - m[8] * m[5] * m[15] + m[8] * m[7] * m[13] + m[12] * m[5] * m[11] - m[12] * m[7] * m[9];
+        r[12] = -m[4] * m[9]  * m[14] + m[4] * m[10] * m[13] + m[8] * m[5] * m[14] - m[8] * m[6] * m[13] - m[12] * m[5] * m[10] + m[12] * m[6] * m[9];
+        r[1]  = -m[1] * m[10] * m[15] + m[1] * m[11] * m[14] + m[9] * m[2] * m[15] - m[9] * m[3] * m[14] - m[13] * m[2] * m[11] + m[13] * m[3] * m[10];
+        r[5]  =  m[0] * m[10] * m[15] - m[0] * m[11] * m[14] - m[8] * m[2] * m[15] + m[8] * m[3] * m[14] + m[12] * m[2] * m[11] - m[12] * m[3] * m[10];
+        r[9]  = -m[0] * m[9]  * m[15] + m[0] * m[11] * m[13] + m[8] * m[1] * m[15] - m[8] * m[3] * m[13] - m[12] * m[1] * m[11] + m[12] * m[3] * m[9];
+        r[13] =  m[0] * m[9]  * m[14] - m[0] * m[10] * m[13] - m[8] * m[1] * m[14] + m[8] * m[2] * m[13] + m[12] * m[1] * m[10] - m[12] * m[2] * m[9];
+        r[2]  =  m[1] * m[6]  * m[15] - m[1] * m[7]  * m[14] - m[5] * m[2] * m[15] + m[5] * m[3] * m[14] + m[13] * m[2] * m[7]  - m[13] * m[3] * m[6];
+        r[6]  = -m[0] * m[6]  * m[15] + m[0] * m[7]  * m[14] + m[4] * m[2] * m[15] - m[4] * m[3] * m[14] - m[12] * m[2] * m[7]  + m[12] * m[3] * m[6];
+        r[10] =  m[0] * m[5]  * m[15] - m[0] * m[7]  * m[13] - m[4] * m[1] * m[15] + m[4] * m[3] * m[13] + m[12] * m[1] * m[7]  - m[12] * m[3] * m[5];
+        r[14] = -m[0] * m[5]  * m[14] + m[0] * m[6]  * m[13] + m[4] * m[1] * m[14] - m[4] * m[2] * m[13] - m[12] * m[1] * m[6]  + m[12] * m[2] * m[5];
+        r[3]  = -m[1] * m[6]  * m[11] + m[1] * m[7]  * m[10] + m[5] * m[2] * m[11] - m[5] * m[3] * m[10] - m[9]  * m[2] * m[7]  + m[9]  * m[3] * m[6];
+        r[7]  =  m[0] * m[6]  * m[11] - m[0] * m[7]  * m[10] - m[4] * m[2] * m[11] + m[4] * m[3] * m[10] + m[8]  * m[2] * m[7]  - m[8]  * m[3] * m[6];
+        r[11] = -m[0] * m[5]  * m[11] + m[0] * m[7]  * m[9]  + m[4] * m[1] * m[11] - m[4] * m[3] * m[9]  - m[8]  * m[1] * m[7]  + m[8]  * m[3] * m[5];
+        r[15] =  m[0] * m[5]  * m[10] - m[0] * m[6]  * m[9]  - m[4] * m[1] * m[10] + m[4] * m[2] * m[9]  + m[8]  * m[1] * m[6]  - m[8]  * m[2] * m[5];
+
+        const float det = m[0] * r[0] + m[1] * r[4] + m[2] * r[8] + m[3] * r[12];
+        const float invDet = det != 0.0f ? 1.0f / det : 0.0f;
+
+        for (int i = 0; i < 16; i++)
+        {
+            inv[i] = r[i] * invDet;
+        }
+    }
+
+    static void Multiply(const float * a, const float * b, float * r)
+    {
+        for (int row = 0; row < 4; row++)
+        {
+            for (int column = 0; column < 4; column++)
+            {
+                r[row * 4 + column] = a[row * 4 + 0] * b[0 * 4 + column] + a[row * 4 + 1] * b[1 * 4 + column] +
+                                      a[row * 4 + 2] * b[2 * 4 + column] + a[row * 4 + 3] * b[3 * 4 + column];
+            }
+        }
+    }
+
+    static void StoreTransposed(const float * m, float * pOutput)
+    {
+        for (int row = 0; row < 4; row++)
+        {
+            for (int column = 0; column < 4; column++)
+            {
+                pOutput[column * 4 + row] = m[row * 4 + column];
+            }
+        }
+    }
+
+    void ComputeCameraMatricesReference(const CameraBatchInput * pInputs, unsigned int count, void * pOutput, size_t stride)
+    {
+        if (pInputs == NULL || pOutput == NULL) { return; }
+
+        for (unsigned int i = 0; i < count; i++)
+        {
+            const CameraBatchInput & in = pInputs[i];
+            CameraBatchMatrices &    out = *(CameraBatchMatrices *)((char *)pOutput + i * stride);
+
+            const float * e = in.m_Eye;
+            const float * r = in.m_Right;
+            const float * u = in.m_Up;
+            const float * f = in.m_Ahead;
+            const float * p = in.m_Projection;
+
+            const float view[16] =
+            {
+                r[0], u[0], f[0], 0.0f,
+                r[1], u[1], f[1], 0.0f,
+                r[2], u[2], f[2], 0.0f,
+                -(r[0] * e[0] + r[1] * e[1] + r[2] * e[2]), -(u[0] * e[0] + u[1] * e[1] + u[2] * e[2]), -(f[0] * e[0] + f[1] * e[1] + f[2] * e[2]), 1.0f
+            };
+
+            // the rotation transposed, then the eye
+            const float viewInv[16] =
+            {
+                r[0], r[1], r[2], 0.0f,
+                u[0], u[1], u[2], 0.0f,
+                f[0], f[1], f[2], 0.0f,
+                e[0], e[1], e[2], 1.0f
+            };
+
+            float projInv[16];
+            if (IsCameraProjectionSupported(p) == true)
+            {
+                // | D 0 |-1   |  D^-1         0    |
+                // | C E |   = | -E^-1 C D^-1  E^-1 |
+                const float ia = 1.0f / p[0], ib = 1.0f / p[5];
+                const float invDet = 1.0f / (p[10] * p[15] - p[11] * p[14]);
+                const float ei00 = p[15] * invDet, ei01 = -p[11] * invDet, ei10 = -p[14] * invDet, ei11 = p[10] * invDet;
+
+                projInv[0]  = ia;   projInv[1]  = 0.0f; projInv[2]  = 0.0f; projInv[3]  = 0.0f;
+                projInv[4]  = 0.0f; projInv[5]  = ib;   projInv[6]  = 0.0f; projInv[7]  = 0.0f;
+                projInv[8]  = -(ei00 * p[8] + ei01 * p[12]) * ia;
+                projInv[9]  = -(ei00 * p[9] + ei01 * p[13]) * ib;
+                projInv[10] = ei00; projInv[11] = ei01;
+                projInv[12] = -(ei10 * p[8] + ei11 * p[12]) * ia;
+                projInv[13] = -(ei10 * p[9] + ei11 * p[13]) * ib;
+                projInv[14] = ei10; projInv[15] = ei11;
+            }
+            else
+            {
+                InvertGeneral(p, projInv);
+            }
+
+            float viewProj[16], viewProjInv[16];
+            Multiply(view, p, viewProj);
+            Multiply(projInv, viewInv, viewProjInv);
+
+            StoreTransposed(view, out.m_View);
+            StoreTransposed(p, out.m_Projection);
+            StoreTransposed(viewInv, out.m_ViewInv);
+            StoreTransposed(projInv, out.m_ProjectionInv);
+            StoreTransposed(viewProj, out.m_ViewProjection);
+            StoreTransposed(viewProjInv, out.m_ViewProjectionInv);
+        }
+    }
+
+    //--------------------------------------------------------------------------------------
+    // 4 cameras at a time, a value of every camera in a lane
+    //--------------------------------------------------------------------------------------
+#if CAMERA_BATCH_SSE
+    typedef __m128 Lanes;
+
+    static inline Lanes Splat(float x)          { return _mm_set1_ps(x); }
+    static inline Lanes Add(Lanes a, Lanes b)   { return _mm_add_ps(a, b); }
+    static inline Lanes Sub(Lanes a, Lanes b)   { return _mm_sub_ps(a, b); }
+    static inline Lanes Mul(Lanes a, Lanes b)   { return _mm_mul_ps(a, b); }
+    static inline Lanes Div(Lanes a, Lanes b)   { return _mm_div_ps(a, b); }
+
+    static inline Lanes Load(const float * const * ppLane, unsigned int index)
+    {
+        return _mm_set_ps(ppLane[3][index], ppLane[2][index], ppLane[1][index], ppLane[0][index]);
+    }
+
+    static inline void Store(Lanes a, float * const * ppLane, unsigned int index)
+    {
+        float v[LANE_COUNT];
+        _mm_storeu_ps(v, a);
+        ppLane[0][index] = v[0];
+        ppLane[1][index] = v[1];
+        ppLane[2][index] = v[2];
+        ppLane[3][index] = v[3];
+    }
+#else
+    struct Lanes { float v[LANE_COUNT]; };
+
+    static inline Lanes Splat(float x)          { Lanes r = { { x, x, x, x } }; return r; }
+    static inline Lanes Add(Lanes a, Lanes b)   { for (unsigned int i = 0; i < LANE_COUNT; i++) { a.v[i] += b.v[i]; } return a; }
+    static inline Lanes Sub(Lanes a, Lanes b)   { for (unsigned int i = 0; i < LANE_COUNT; i++) { a.v[i] -= b.v[i]; } return a; }
+    static inline Lanes Mul(Lanes a, Lanes b)   { for (unsigned int i = 0; i < LANE_COUNT; i++) { a.v[i] *= b.v[i]; } return a; }
+    static inline Lanes Div(Lanes a, Lanes b)   { for (unsigned int i = 0; i < LANE_COUNT; i++) { a.v[i] /= b.v[i]; } return a; }
+
+    static inline Lanes Load(const float * const * ppLane, unsigned int index)
+    {
+        Lanes r;
+        for (unsigned int i = 0; i < LANE_COUNT; i++) { r.v[i] = ppLane[i][index]; }
+        return r;
+    }
+
+    static inline void Store(Lanes a, float * const * ppLane, unsigned int index)
+    {
+        for (unsigned int i = 0; i < LANE_COUNT; i++) { ppLane[i][index] = a.v[i]; }
+    }
+#endif
+
+    static inline Lanes Dot3(const Lanes * a, const Lanes * b)
+    {
+        return Add(Add(Mul(a[0], b[0]), Mul(a[1], b[1])), Mul(a[2], b[2]));
+    }
+
+    // M[row][column] goes to column * 4 + row of the matrix at offset
+    static inline void StoreEntry(Lanes a, float * const * ppOut, unsigned int offset, unsigned int row, unsigned int column)
+    {
+        Store(a, ppOut, offset + column * 4 + row);
+    }
+
+    static void ComputeLanes(const float * const * ppIn, float * const * ppOut)
+    {
+        const Lanes zero = Splat(0.0f);
+        const Lanes one = Splat(1.0f);
+
+        Lanes e[3], r[3], u[3], f[3], p[16];
+        for (unsigned int i = 0; i < 3; i++)
+        {
+            e[i] = Load(ppIn, INPUT_EYE + i);
+            r[i] = Load(ppIn, INPUT_RIGHT + i);
+            u[i] = Load(ppIn, INPUT_UP + i);
+            f[i] = Load(ppIn, INPUT_AHEAD + i);
+        }
+        for (unsigned int i = 0; i < 16; i++)
+        {
+            p[i] = Load(ppIn, INPUT_PROJECTION + i);
+        }
+
+        // the entries of the projection, see CameraBatch.h
+        const Lanes & a = p[0];
+        const Lanes & b = p[5];
+        const Lanes & c = p[8];
+        const Lanes & d = p[9];
+        const Lanes & pe = p[10];
+        const Lanes & pf = p[11];
+        const Lanes & g = p[12];
+        const Lanes & h = p[13];
+        const Lanes & k = p[14];
+        const Lanes & l = p[15];
+
+        // view: the basis in the columns, the eye moved to the origin in the last row
+        const Lanes t[3] = { Sub(zero, Dot3(r, e)), Sub(zero, Dot3(u, e)), Sub(zero, Dot3(f, e)) };
+        for (unsigned int i = 0; i < 3; i++)
+        {
+            StoreEntry(r[i], ppOut, OUTPUT_VIEW, i, 0);
+            StoreEntry(u[i], ppOut, OUTPUT_VIEW, i, 1);
+            StoreEntry(f[i], ppOut, OUTPUT_VIEW, i, 2);
+            StoreEntry(zero, ppOut, OUTPUT_VIEW, i, 3);
+            StoreEntry(t[i], ppOut, OUTPUT_VIEW, 3, i);
+        }
+        StoreEntry(one, ppOut, OUTPUT_VIEW, 3, 3);
+
+        for (unsigned int row = 0; row < 4; row++)
+        {
+            for (unsigned int column = 0; column < 4; column++)
+            {
+                StoreEntry(p[row * 4 + column], ppOut, OUTPUT_PROJECTION, row, column);
+            }
+        }
+
+        // view inverse: the basis in the rows, then the eye
+        for (unsigned int i = 0; i < 3; i++)
+        {
+            StoreEntry(r[i], ppOut, OUTPUT_VIEW_INV, 0, i);
+            StoreEntry(u[i], ppOut, OUTPUT_VIEW_INV, 1, i);
+            StoreEntry(f[i], ppOut, OUTPUT_VIEW_INV, 2, i);
+            StoreEntry(e[i], ppOut, OUTPUT_VIEW_INV, 3, i);
+            StoreEntry(zero, ppOut, OUTPUT_VIEW_INV, i, 3);
+        }
+        StoreEntry(one, ppOut, OUTPUT_VIEW_INV, 3, 3);
+
+        // projection inverse: the diagonal block, the 2x2 block and -E^-1 C D^-1
+        const Lanes ia = Div(one, a);
+        const Lanes ib = Div(one, b);
+        const Lanes invDet = Div(one, Sub(Mul(pe, l), Mul(pf, k)));
+        const Lanes ei00 = Mul(l, invDet);
+        const Lanes ei01 = Sub(zero, Mul(pf, invDet));
+        const Lanes ei10 = Sub(zero, Mul(k, invDet));
+        const Lanes ei11 = Mul(pe, invDet);
+        const Lanes x00 = Sub(zero, Mul(Add(Mul(ei00, c), Mul(ei01, g)), ia));
+        const Lanes x01 = Sub(zero, Mul(Add(Mul(ei00, d), Mul(ei01, h)), ib));
+        const Lanes x10 = Sub(zero, Mul(Add(Mul(ei10, c), Mul(ei11, g)), ia));
+        const Lanes x11 = Sub(zero, Mul(Add(Mul(ei10, d), Mul(ei11, h)), ib));
+
+        const Lanes projInv[16] = { ia, zero, zero, zero, zero, ib, zero, zero, x00, x01, ei00, ei01, x10, x11, ei10, ei11 };
+        for (unsigned int row = 0; row < 4; row++)
+        {
+            for (unsigned int column = 0; column < 4; column++)
+            {
+                StoreEntry(projInv[row * 4 + column], ppOut, OUTPUT_PROJECTION_INV, row, column);
+            }
+        }
+
+        // view projection, without the products with the zeros of the projection
+        for (unsigned int i = 0; i < 3; i++)
+        {
+            StoreEntry(Add(Mul(r[i], a), Mul(f[i], c)), ppOut, OUTPUT_VIEW_PROJECTION, i, 0);
+            StoreEntry(Add(Mul(u[i], b), Mul(f[i], d)), ppOut, OUTPUT_VIEW_PROJECTION, i, 1);
+            StoreEntry(Mul(f[i], pe), ppOut, OUTPUT_VIEW_PROJECTION, i, 2);
+            StoreEntry(Mul(f[i], pf), ppOut, OUTPUT_VIEW_PROJECTION, i, 3);
+        }
+        StoreEntry(Add(Add(Mul(t[0], a), Mul(t[2], c)), g), ppOut, OUTPUT_VIEW_PROJECTION, 3, 0);
+        StoreEntry(Add(Add(Mul(t[1], b), Mul(t[2], d)), h), ppOut, OUTPUT_VIEW_PROJECTION, 3, 1);
+        StoreEntry(Add(Mul(t[2], pe), k), ppOut, OUTPUT_VIEW_PROJECTION, 3, 2);
+        StoreEntry(Add(Mul(t[2], pf), l), ppOut, OUTPUT_VIEW_PROJECTION, 3, 3);
+
+        // view projection inverse = projection inverse * view inverse
+        for (unsigned int i = 0; i < 3; i++)
+        {
+            StoreEntry(Mul(r[i], ia), ppOut, OUTPUT_VIEW_PROJECTION_INV, 0, i);
+            StoreEntry(Mul(u[i], ib), ppOut, OUTPUT_VIEW_PROJECTION_INV, 1, i);
+            StoreEntry(Add(Add(Mul(x00, r[i]), Mul(x01, u[i])), Add(Mul(ei00, f[i]), Mul(ei01, e[i]))), ppOut, OUTPUT_VIEW_PROJECTION_INV, 2, i);
+            StoreEntry(Add(Add(Mul(x10, r[i]), Mul(x11, u[i])), Add(Mul(ei10, f[i]), Mul(ei11, e[i]))), ppOut, OUTPUT_VIEW_PROJECTION_INV, 3, i);
+        }
+        StoreEntry(zero, ppOut, OUTPUT_VIEW_PROJECTION_INV, 0, 3);
+        StoreEntry(zero, ppOut, OUTPUT_VIEW_PROJECTION_INV, 1, 3);
+        StoreEntry(ei01, ppOut, OUTPUT_VIEW_PROJECTION_INV, 2, 3);
+        StoreEntry(ei11, ppOut, OUTPUT_VIEW_PROJECTION_INV, 3, 3);
+    }
+
+    void ComputeCameraMatrices(const CameraBatchInput * pInputs, unsigned int count, void * pOutput, size_t stride)
+    {
+        if (pInputs == NULL || pOutput == NULL) { return; }
+
+        const float *       ppIn[LANE_COUNT];
+        float *             ppOut[LANE_COUNT];
+        CameraBatchMatrices padding;
+        unsigned int        laneCount = 0;
+
+        for (unsigned int i = 0; i < count; i++)
+        {
+            CameraBatchMatrices * pMatrices = (CameraBatchMatrices *)((char *)pOutput + i * stride);
+
+            if (IsCameraProjectionSupported(pInputs[i].m_Projection) == false)
+            {
+                ComputeCameraMatricesReference(&pInputs[i], 1, pMatrices, stride);
+                continue;
+            }
+
+            ppIn[laneCount] = (const float *)&pInputs[i];
+            ppOut[laneCount] = (float *)pMatrices;
+            laneCount++;
+
+            if (laneCount == LANE_COUNT)
+            {
+                ComputeLanes(ppIn, ppOut);
+                laneCount = 0;
+            }
+        }
+
+        if (laneCount > 0)
+        {
+            // the lanes left repeat the last camera into a scratch output
+            for (unsigned int lane = laneCount; lane < LANE_COUNT; lane++)
+            {
+                ppIn[lane] = ppIn[laneCount - 1];
+                ppOut[lane] = (float *)&padding;
+            }
+            ComputeLanes(ppIn, ppOut);
+        }
+    }
+
+    void MultiplyCameraMatricesReference(const float * pLeft, const void * pRight, size_t rightStride, unsigned int count, void * pOutput, size_t outputStride)
+    {
+        if (pLeft == NULL || pRight == NULL || pOutput == NULL) { return; }
+
+        for (unsigned int i = 0; i < count; i++)
+        {
+            Multiply(pLeft, (const float *)((const char *)pRight + i * rightStride), (float *)((char *)pOutput + i * outputStride));
+        }
+    }
+
+    void MultiplyCameraMatrices(const float * pLeft, const void * pRight, size_t rightStride, unsigned int count, void * pOutput, size_t outputStride)
+    {
+#if CAMERA_BATCH_SSE
+        if (pLeft == NULL || pRight == NULL || pOutput == NULL) { return; }
+
+        // a row of the product is the rows of the right matrix weighted by a row of the left one
+        __m128 left[16];
+        for (unsigned int i = 0; i < 16; i++)
+        {
+            left[i] = _mm_set1_ps(pLeft[i]);
+        }
+
+        for (unsigned int i = 0; i < count; i++)
+        {
+            const float * r = (const float *)((const char *)pRight + i * rightStride);
+            float *       o = (float *)((char *)pOutput + i * outputStride);
+
+            const __m128 r0 = _mm_loadu_ps(r + 0);
+            const __m128 r1 = _mm_loadu_ps(r + 4);
+            const __m128 r2 = _mm_loadu_ps(r + 8);
+            const __m128 r3 = _mm_loadu_ps(r + 12);
+
+            for (unsigned int row = 0; row < 4; row++)
+            {
+                const __m128 sum = _mm_add_ps(_mm_add_ps(_mm_mul_ps(left[row * 4 + 0], r0), _mm_mul_ps(left[row * 4 + 1], r1)),
+                                              _mm_add_ps(_mm_mul_ps(left[row * 4 + 2], r2), _mm_mul_ps(left[row * 4 + 3], r3)));
+                _mm_storeu_ps(o + row * 4, sum);
+            }
+        }
+#else
+        MultiplyCameraMatricesReference(pLeft, pRight, rightStride, count, pOutput, outputStride);
+#endif
+    }
+}
@@ -0,0 +1,96 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//--------------------------------------------------------------------------------------
+// File: CameraBatch.h
+//
+// The matrices of S_CAMERA_DATA for a batch of cameras, without a general 4x4 inverse.
+//
+// A camera is an eye, the orthonormal left-handed basis XMMatrixLookAtLH builds, and a
+// projection that only has the entries of a perspective or an off-center orthographic
+// projection (row vectors, D3D convention):
+//
+//     | a 0 0 0 |
+//     | 0 b 0 0 |
+//     | c d e f |
+//     | g h k l |
+//
+// The view is rigid, so its inverse is the transposed rotation and the eye. The projection
+// is block lower triangular, so its inverse takes the inverse of the diagonal and of one
+// 2x2 block. The inverse of the view projection is the product of both inverses, which
+// the zeros of the projection inverse make cheap.
+//
+// ComputeCameraMatrices does 4 cameras at a time, one per SSE lane when SSE is available,
+// and writes every matrix transposed for HLSL straight into an array of structures of any
+// stride. ComputeCameraMatricesReference does the same math one camera at a time.
+// MultiplyCameraMatrices multiplies one matrix by those of many cameras, as the light
+// volumes of the shadow map masking pass need.
+//
+// This code has no dependency on Windows, D3D11 or AGS.
+//--------------------------------------------------------------------------------------
+#ifndef CAMERA_BATCH_H
+#define CAMERA_BATCH_H
+
+#include <stddef.h>
+
+namespace AMD
+{
+    static const unsigned int CAMERA_CUBE_FACE_COUNT = 6;
+
+    struct CameraBatchInput
+    {
+        float m_Eye[3];
+        float m_Right[3];
+        float m_Up[3];
+        float m_Ahead[3];
+        float m_Projection[16];             // row major, row vectors
+    };
+
+    // what ComputeCameraMatrices writes, in the order and layout of the start of S_CAMERA_DATA
+    struct CameraBatchMatrices
+    {
+        float m_View[16];
+        float m_Projection[16];
+        float m_ViewInv[16];
+        float m_ProjectionInv[16];
+        float m_ViewProjection[16];
+        float m_ViewProjectionInv[16];
+    };
+
+    // the basis of cube face +x, -x, +y, -y, +z or -z, the one XMMatrixLookAtLH builds from
+    // the eye, the eye plus the face direction, and the up vector of a D3D11 cube map face
+    void GetCubeFaceBasis(unsigned int face, float right[3], float up[3], float ahead[3]);
+
+    // false if the projection has entries the closed form inverse ignores; such a camera
+    // gets a general inverse of its projection, and is slower, but still right
+    bool IsCameraProjectionSupported(const float * pProjection);
+
+    // pOutput + i * stride receives the CameraBatchMatrices of camera i
+    void ComputeCameraMatrices(const CameraBatchInput * pInputs, unsigned int count, void * pOutput, size_t stride);
+    void ComputeCameraMatricesReference(const CameraBatchInput * pInputs, unsigned int count, void * pOutput, size_t stride);
+
+    // pOutput + i * outputStride receives pLeft * (pRight + i * rightStride), all 4x4 and
+    // in the same layout; one matrix against many, as the viewer against the light volumes
+    void MultiplyCameraMatrices(const float * pLeft, const void * pRight, size_t rightStride, unsigned int count, void * pOutput, size_t outputStride);
+    void MultiplyCameraMatricesReference(const float * pLeft, const void * pRight, size_t rightStride, unsigned int count, void * pOutput, size_t outputStride);
+}
+
+#endif // CAMERA_BATCH_H
@@ -0,0 +1,84 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//--------------------------------------------------------------------------------------
+// File: ConstantRing.cpp
+//
+// Sub-allocation of one large dynamic constant buffer for the per-draw constants of a frame.
+//--------------------------------------------------------------------------------------
+#include "ConstantRing.h"
+
+namespace AMD
+{
+    ConstantRing::ConstantRing()
+    {
+        Init(64 * 1024, 1);
+    }
+
+    void ConstantRing::Init(unsigned int regionSize, unsigned int gpuCount, unsigned int regionsPerGpu)
+    {
+        m_GpuCount = gpuCount == 0 ? 1 : gpuCount;
+        m_RegionSize = GetStride(regionSize);
+        m_RegionCount = m_GpuCount * (regionsPerGpu == 0 ? 1 : regionsPerGpu);
+
+        m_Region = 0;
+        m_Offset = 0;
+        m_Failures = 0;
+        m_Discard = true;
+    }
+
+    void ConstantRing::BeginFrame(unsigned int frame)
+    {
+        const unsigned int region = frame % m_RegionCount;
+
+        // back at or before the region of the last frame: this trip starts on fresh memory
+        if (region <= m_Region)
+        {
+            m_Discard = true;
+        }
+
+        m_Region = region;
+        m_Offset = region * m_RegionSize;
+        m_Failures = 0;
+    }
+
+    unsigned int ConstantRing::Allocate(unsigned int size, unsigned int count, bool & discard)
+    {
+        const unsigned long long bytes = (unsigned long long)GetStride(size) * count;
+        const unsigned int       regionEnd = (m_Region + 1) * m_RegionSize;
+
+        discard = false;
+
+        if (size == 0 || count == 0 || bytes > regionEnd - m_Offset)
+        {
+            m_Failures++;
+            return CONSTANT_RING_INVALID_OFFSET;
+        }
+
+        const unsigned int offset = m_Offset;
+        m_Offset += (unsigned int)bytes;
+
+        discard = m_Discard;
+        m_Discard = false;
+
+        return offset;
+    }
+}
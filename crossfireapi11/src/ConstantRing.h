@@ -0,0 +1,91 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//--------------------------------------------------------------------------------------
+// File: ConstantRing.h
+//
+// Sub-allocation of one large dynamic constant buffer for the per-draw constants of a frame.
+//
+// Mapping a small constant buffer with WRITE_DISCARD for every draw makes the driver rename
+// the buffer every time. Instead, a pass writes the constants of all its draws into the ring
+// with one Map(WRITE_NO_OVERWRITE) and every draw binds its part with the D3D11.1 constant
+// buffer offsets, which must be multiples of 16 constants, so parts are 256 byte aligned.
+//
+// The ring is split into regions and frame F allocates from region F % RegionCount. With AFR
+// frame F runs on GPU F % GpuCount and RegionCount is a multiple of GpuCount, so a region is
+// only ever read by one GPU. A region is written by one frame per trip around the ring, and
+// the first allocation of a trip maps with WRITE_DISCARD, so nothing is overwritten while a
+// GPU that lags behind may still read it. A frame that fills its region gets no more
+// allocations; the caller then maps its own constant buffer per draw, as before.
+//
+// This code has no dependency on Windows, D3D11 or AGS.
+//--------------------------------------------------------------------------------------
+#ifndef CONSTANT_RING_H
+#define CONSTANT_RING_H
+
+namespace AMD
+{
+    static const unsigned int CONSTANT_RING_INVALID_OFFSET = 0xffffffff;
+    static const unsigned int CONSTANT_RING_CONSTANT_SIZE = 16;                                  // bytes of a shader constant
+    static const unsigned int CONSTANT_RING_ALIGNMENT = 16 * CONSTANT_RING_CONSTANT_SIZE;        // D3D11.1 offsets are in 16 constant steps
+    static const unsigned int CONSTANT_RING_REGIONS_PER_GPU = 2;
+
+    class ConstantRing
+    {
+    public:
+        ConstantRing();
+
+        static unsigned int GetStride(unsigned int size) { return (size + CONSTANT_RING_ALIGNMENT - 1) / CONSTANT_RING_ALIGNMENT * CONSTANT_RING_ALIGNMENT; }
+
+        // regionSize is rounded up to CONSTANT_RING_ALIGNMENT; the next allocation discards
+        void         Init(unsigned int regionSize, unsigned int gpuCount, unsigned int regionsPerGpu = CONSTANT_RING_REGIONS_PER_GPU);
+
+        unsigned int GetSize() const { return m_RegionSize * m_RegionCount; }
+        unsigned int GetRegionSize() const { return m_RegionSize; }
+        unsigned int GetRegionCount() const { return m_RegionCount; }
+        unsigned int GetRegionGpu(unsigned int region) const { return region % m_GpuCount; }
+
+        // frame allocates from region frame % RegionCount from now on
+        void         BeginFrame(unsigned int frame);
+        unsigned int GetRegion() const { return m_Region; }
+
+        // count blocks of size bytes, GetStride(size) apart; the byte offset of the first block,
+        // or CONSTANT_RING_INVALID_OFFSET if the region is full. discard is true when the caller
+        // has to map the buffer with WRITE_DISCARD rather than WRITE_NO_OVERWRITE
+        unsigned int Allocate(unsigned int size, unsigned int count, bool & discard);
+
+        // bytes allocated from the region of the frame, and the allocations that didn't fit
+        unsigned int GetUsed() const { return m_Offset - m_Region * m_RegionSize; }
+        unsigned int GetFailures() const { return m_Failures; }
+
+    private:
+        unsigned int m_GpuCount;
+        unsigned int m_RegionSize;
+        unsigned int m_RegionCount;
+
+        unsigned int m_Region;
+        unsigned int m_Offset;          // of the next allocation, in bytes from the start of the ring
+        unsigned int m_Failures;
+        bool         m_Discard;         // the ring wrapped since the last allocation
+    };
+}
+
+#endif // CONSTANT_RING_H
@@ -37,6 +37,28 @@
 
 #include "AMD_ShadowFX.h"
 
+#include "TransferModeController.h"
+#include "TransferTrace.h"
+#include "TransferValidator.h"
+#include "ShadowFaceScheduler.h"
+#include "ShadowFaceCache.h"
+#include "ShadowFaceAffinity.h"
+#include "FrameGraph.h"
+#include "TransferRing.h"
+#include "ShadowAtlasAllocator.h"
+#include "ShadowFaceLod.h"
+#include "ShadowCasterCulling.h"
+#include "ShadowLightList.h"
+#include "ShadowCascades.h"
+#include "ConstantRing.h"
+#include "CameraBatch.h"
+#include "JobSystem.h"
+#include "Benchmark.h"
+#include "BenchmarkSweep.h"
+#include "AfrSimulator.h"
+#include "Scene.h"
+#include "InstanceBatcher.h"
+
 #include <DirectXMath.h>
 using namespace DirectX;
 
@@ -131,6 +153,73 @@ struct S_UNIT_CUBE_TRANSFORM
     float4      m_Color;
 };
 
+// a mesh and the cube faces it is drawn into by RenderShadowMapFacesInstanced
+__declspec(align(16))
+struct S_SHADOW_FACE_DATA
+{
+    float4x4     m_World;
+    float4x4     m_WorldViewProjection[6];  // per instance
+    unsigned int m_Target[6][4];            // per instance, x: viewport, y: render target array slice
+};
+
+// the unit cube of a cube light in the structured buffer of VS_RenderLightVolumeInstanced
+__declspec(align(16))
+struct S_LIGHT_VOLUME_DATA
+{
+    float4x4    m_Transform;        // as S_UNIT_CUBE_TRANSFORM::m_Transform
+    float4      m_Color;
+};
+
+// an instance of a mesh in the structured buffer of VS_RenderSceneInstanced
+__declspec(align(16))
+struct S_INSTANCE_DATA
+{
+    float4x4    m_World;            // transposed like S_MODEL_DATA::m_World
+};
+
+// a spot light of the structured buffer the scene shader loops over
+__declspec(align(16))
+struct S_SHADOW_LIGHT_DATA
+{
+    float4       m_Position;        // w: range
+    float4       m_Direction;       // w: cosine of half the cone angle
+    float4       m_Color;
+    unsigned int m_Mask;            // g_ShadowLightMask index, SHADOW_LIGHT_MASK_COUNT if the light has no shadow
+    unsigned int m_Channel;
+    float        m_Padding[2];
+};
+
+// frame graph passes of the current frame, FRAME_GRAPH_INVALID_INDEX if not declared
+struct S_FRAME_PASSES
+{
+    unsigned int m_DepthPrepass;
+    unsigned int m_ShadowMapReceive;
+    unsigned int m_StaticShadowMapRendering;
+    unsigned int m_ShadowMapRendering;
+    unsigned int m_ShadowMapSend;
+    unsigned int m_LightShadowMapRendering;
+    unsigned int m_ShadowMapMasking;
+    unsigned int m_ShadowMapFiltering;
+    unsigned int m_SceneRendering;
+};
+
+// the meshes of a cube face GetShadowCasters returns
+enum SHADOW_CASTER_SET
+{
+    SHADOW_CASTER_SET_ALL,
+    SHADOW_CASTER_SET_STATIC,       // rendered into the cached static layer
+    SHADOW_CASTER_SET_DYNAMIC,      // rendered on top of the static layer
+};
+
+// the shadow maps CreateTransferredShadowMaps recreates, they are the ones with a transfer flag
+enum TRANSFERRED_SHADOW_MAP
+{
+    TRANSFERRED_SHADOW_MAP_MAIN     = 0x1,  // g_ShadowMap
+    TRANSFERRED_SHADOW_MAP_TRANSFER = 0x2,  // the g_ShadowMapTransfer ring
+    TRANSFERRED_SHADOW_MAP_STATIC   = 0x4,  // g_ShadowMapStatic
+    TRANSFERRED_SHADOW_MAP_ALL      = 0x7,
+};
+
 AGSContext*                                      g_agsContext;
 
 CDXUTDialogResourceManager                       g_DialogResourceManager;    // Manager for shared resources of dialogs
@@ -138,17 +227,42 @@ CD3DSettingsDlg                                  g_SettingsDlg;              //
 CDXUTTextHelper*                                 g_pTxtHelper = NULL;
 
 #define CUBE_FACE_COUNT 6
+#define SHADOW_LIGHT_MAX_COUNT 16
+#define SHADOW_LIGHT_MASK_COUNT 4
+#define LIGHT_VOLUME_SLOT 8         // t8, g_LightVolume of VS_RenderLightVolumeInstanced
+#define INSTANCE_SLOT 9             // t9, g_Instance of VS_RenderSceneInstanced
 CFirstPersonCamera                               g_LightCamera;                // A model viewing camera for the light
 CFirstPersonCamera                               g_ViewerCamera;               // A first person viewing camera
 CFirstPersonCamera*                              g_pCurrentCamera = &g_ViewerCamera;
 int                                              g_CurrentLightCamera;
 CFirstPersonCamera                               g_CubeCamera[CUBE_FACE_COUNT];
-float4x4                                         g_LightOrtho[CUBE_FACE_COUNT];
+float4x4                                         g_LightOrtho[CUBE_FACE_COUNT];  // projections of the cascades, see GetShadowFaceProjection
+float4                                           g_CascadeLightDirection(-1.0f, -1.0f, -1.0f, 0.0f); // the sun of the cascades shines along it
 S_CAMERA_DATA                                    g_ViewerData, g_LightData[CUBE_FACE_COUNT];
 
 bool                                             g_EnableCrossfireApiTransfers = false;
 bool                                             g_Enable2StepGpuTransfer = false;
 bool                                             g_DelayEndAllAccess = false;
+bool                                             g_EnableAdaptiveTransfers = false;
+bool                                             g_SkipUnchangedFaces = false;
+bool                                             g_EnableAffineFaceUpdates = false;
+int                                              g_MaxAffineFaceAge = 2 * CUBE_FACE_COUNT; // in frames, enough for 2 GPUs to never transfer
+AMD::Slider*                                     g_pMaxAffineFaceAgeSlider = NULL;
+bool                                             g_EnableDynamicShadowAtlas = false;
+bool                                             g_EnableCasterCulling = false;
+bool                                             g_EnableStaticShadowCache = false;
+bool                                             g_EnableSinglePassShadowFaces = false; // every caster is drawn once into all its cube faces
+bool                                             g_EnableStateCache = false;    // drop the state calls that bind what is already bound
+bool                                             g_EnableConstantRing = false;  // per-draw constants go into g_ConstantRing when the device supports it
+bool                                             g_EnableInstancedLightVolumes = false; // the unit cubes of the cube lights in one draw
+bool                                             g_EnableInstancedMeshes = false; // the instances of a mesh in one draw per subset
+bool                                             g_EnableDeferredRecording = false; // the depth prepass and the cube faces are recorded on worker threads
+int                                              g_ShadowLightCount = 0;       // spot lights besides the cube light
+AMD::Slider*                                     g_pShadowLightCountSlider = NULL;
+int                                              g_FarCascadeInterval = 8;     // in frames, between two fits of the last cascade
+AMD::Slider*                                     g_pFarCascadeIntervalSlider = NULL;
+int                                              g_RecordThreadCount = 4;      // including the render thread, see AMD::JobSystem
+AMD::Slider*                                     g_pRecordThreadCountSlider = NULL;
 
 const float4                                     red(1.00f, 0.00f, 0.00f, 1.00f);
 const float4                                     orange(1.00f, 0.50f, 0.00f, 1.00f);
@@ -187,7 +301,10 @@ ID3D11BlendState*                                g_pOpaqueBS = NULL;
 ID3D11BlendState*                                g_pShadowMaskChannelBS[4] = { 0, 0, 0, 0 };
 
 ID3D11VertexShader*                              g_pSceneVS = NULL;
+ID3D11VertexShader*                              g_pSceneInstancedVS = NULL;
 ID3D11VertexShader*                              g_pShadowMapVS = NULL;
+ID3D11VertexShader*                              g_pShadowMapInstancedVS = NULL;
+ID3D11GeometryShader*                            g_pShadowMapInstancedGS = NULL;
 
 ID3D11PixelShader*                               g_pDepthPassScenePS = NULL;
 ID3D11PixelShader*                               g_pDepthAndNormalPassScenePS = NULL;
@@ -199,12 +316,56 @@ ID3D11VertexShader*                              g_pFullscreenVS = NULL;
 ID3D11VertexShader*                              g_pScreenQuadVS = NULL;
 ID3D11PixelShader*                               g_pUnitCubePS = NULL;
 ID3D11PixelShader*                               g_pFullscreenPS = NULL;
+ID3D11PixelShader*                               g_pCopyDepthPS = NULL;
+ID3D11VertexShader*                              g_pLightVolumeVS = NULL;
+ID3D11PixelShader*                               g_pLightVolumePS = NULL;
 
 // Constant Buffer
 ID3D11Buffer*                                    g_pModelCB = NULL;
 ID3D11Buffer*                                    g_pViewerCB = NULL;
 ID3D11Buffer*                                    g_pLightCB = NULL;
 ID3D11Buffer*                                    g_pUnitCubeCB = NULL;
+ID3D11Buffer*                                    g_pShadowFaceCB = NULL;
+
+// The per-draw constants of a pass in one Map, each draw binding its block with a D3D11.1
+// constant buffer offset; NULL when the device can't, and the buffers above are mapped per draw
+AMD::ConstantRing                                g_ConstantRing;
+ID3D11Buffer*                                    g_pConstantRingCB = NULL;
+
+// Structured buffer of the spot lights, created again when their count changes
+ID3D11Buffer*                                    g_pShadowLightSB = NULL;
+ID3D11ShaderResourceView*                        g_pShadowLightSRV = NULL;
+unsigned int                                     g_ShadowLightBufferCount = 0;
+
+// Structured buffer of the unit cubes of the cube lights, see UpdateLightVolumeBuffer
+ID3D11Buffer*                                    g_pLightVolumeSB = NULL;
+ID3D11ShaderResourceView*                        g_pLightVolumeSRV = NULL;
+
+// Structured buffer of the world matrices of the instances a RenderScene draws, as many
+// as the scene has; its batches come from the batcher of the context, see GetInstanceBatcher
+ID3D11Buffer*                                    g_pInstanceSB = NULL;
+ID3D11ShaderResourceView*                        g_pInstanceSRV = NULL;
+AMD::InstanceBatcher                             g_InstanceBatcher;
+
+// RenderScene, the fullscreen passes and the unit cubes bind their state through the cache;
+// whatever binds through the context itself is followed by an Invalidate
+AMD::StateCacheD3D11                             g_StateCacheTarget;
+AMD::StateCache                                  g_StateCache;
+
+// Deferred recording: job 0 records the depth prepass and job 1 + i the face pFaces[i] into
+// a deferred context of its own, on a worker of g_JobSystem. The command list of a face is
+// kept under 1 + face, and the immediate context executes the lists in the frame graph passes
+// they were taken from, so the Crossfire API notifications keep their place around them.
+#define RECORD_JOB_DEPTH_PREPASS 0
+#define RECORD_JOB_COUNT (1 + CUBE_FACE_COUNT)
+
+AMD::JobSystem                                   g_JobSystem;
+ID3D11DeviceContext*                             g_pRecordContext[RECORD_JOB_COUNT] = { NULL };
+AMD::StateCacheD3D11                             g_RecordStateCacheTarget[RECORD_JOB_COUNT];
+AMD::StateCache                                  g_RecordStateCache[RECORD_JOB_COUNT];
+AMD::InstanceBatcher                             g_RecordInstanceBatcher[RECORD_JOB_COUNT];
+std::vector<unsigned int>                        g_RecordShadowCasters[RECORD_JOB_COUNT];
+ID3D11CommandList*                               g_pRecordCommandList[RECORD_JOB_COUNT] = { NULL };
 
 ID3D11RasterizerState*                           g_pNoCullingSolidRS = NULL;
 ID3D11RasterizerState*                           g_pBackCullingSolidRS = NULL;
@@ -218,20 +379,55 @@ ID3D11DepthStencilState*                         g_pDepthTestLessEqualDSS = NULL
 ID3D11DepthStencilState*                         g_pDepthClearDSS = NULL;
 
 AMD::Texture2D                                   g_ShadowMask, g_AppDepth, g_AppNormal, g_LightColor, g_LightDepth;
-
-AMD::Mesh                                        g_Tree, g_Plane;
-AMD::Mesh*                                       g_MeshArray[] = { &g_Tree, &g_Plane, &g_Plane }; // TODO: rearrange this for a proper instanced rendering
-XMMATRIX                                         g_MeshModelMatrix[AMD_ARRAY_SIZE(g_MeshArray)];
+AMD::Texture2D                                   g_ShadowLightMask[SHADOW_LIGHT_MASK_COUNT]; // a shadow term of the spot lights per channel
+
+// The scene (-scene, media\scenes\default.txt otherwise) and a mesh per mesh asset. The
+// arrays below hold an element per instance of the scene; "mesh" in the passes means an
+// instance, and g_InstanceMesh is what tells the instances of the same asset apart
+AMD::Scene                                       g_Scene;
+std::vector<AMD::Mesh *>                         g_SceneMeshes;
+unsigned int                                     g_MeshCount = 0;             // instances of the scene
+std::vector<AMD::Mesh *>                         g_MeshArray;
+std::vector<unsigned int>                        g_InstanceMesh;              // index of g_SceneMeshes
+std::vector<unsigned int>                        g_AllInstances;              // 0 to g_MeshCount - 1, the instances of the viewer passes
+std::vector<unsigned int>                        g_ShadowCasters;             // GetShadowCasters scratch of the immediate context
+std::vector<XMMATRIX>                            g_MeshModelMatrix;
+std::vector<AMD::ShadowCasterBounds>             g_MeshBounds;                // model space
+std::vector<unsigned int>                        g_MeshFaceMask;              // the cube faces every mesh casts a shadow into
+std::vector<bool>                                g_MeshIsStatic;              // static meshes go into the cached static layer
 
 float                                            g_ShadowMapSize = 1024;
 int                                              g_ShadowMapAtlasScaleW = CUBE_FACE_COUNT / 2, g_ShadowMapAtlasScaleH = CUBE_FACE_COUNT / g_ShadowMapAtlasScaleW;
 
 AMD::Texture2D                                   g_ShadowMapSubregion;
 AMD::Texture2D                                   g_ShadowMap;
-AMD::Texture2D                                   g_ShadowMapTransfer;
+AMD::Texture2D                                   g_ShadowMapTransfer[AMD::TRANSFER_RING_MAX_SLOT_COUNT]; // one more "Transfer" shadow map than GPUs
+AMD::Texture2D                                   g_ShadowMapStatic;            // depth of the static casters only, same layout as the shadow map
+AMD::Texture2D                                   g_LightShadowMap;             // atlas of the spot lights, every GPU renders it every frame and it is never transferred
 AGSAfrTransferType                               g_ShadowMapCfxFlag = AGS_AFR_TRANSFER_DEFAULT;
 AGSAfrTransferType                               g_ShadowMapTransferCfxFlag = AGS_AFR_TRANSFER_DEFAULT;
+AGSAfrTransferType                               g_ShadowMapStaticCfxFlag = AGS_AFR_TRANSFER_DEFAULT;
 AGSAfrTransferType                               g_ResourceCfxTransferFlag = AGS_AFR_TRANSFER_1STEP_P2P;
+AMD::TransferModeController                      g_TransferModeController;     // picks g_ResourceCfxTransferFlag when adaptive transfers are enabled
+AMD::ShadowFaceScheduler                         g_ShadowFaceScheduler;        // picks the cube faces to render when prioritized face updates are enabled
+AMD::ShadowFaceCache                             g_ShadowFaceCache;            // which GPUs hold an up to date copy of each cube face
+AMD::ShadowFaceCache                             g_StaticShadowFaceCache;      // which GPUs hold an up to date static layer of each cube face
+AMD::ShadowFaceAffinity                          g_ShadowFaceAffinity;         // assigns cube faces to GPUs when GPU affine face updates are enabled
+AMD::FrameGraph                                  g_FrameGraph;                 // places the Crossfire API notifications of a frame
+AMD::TransferRing                                g_TransferRing;               // which faces each "Transfer" shadow map holds on each GPU
+AMD::ShadowAtlasAllocator                        g_ShadowAtlas;                // variable resolution regions of the atlas when the dynamic atlas is enabled
+unsigned int                                     g_ShadowAtlasRegion[CUBE_FACE_COUNT];
+AMD::ShadowFaceLod                               g_ShadowFaceLod;              // region size of every face of the dynamic atlas, from its screen coverage
+AMD::ShadowCasterCuller                          g_ShadowCasterCuller;         // finds the cube faces every mesh touches
+AMD::ShadowCasterCuller                          g_LightShadowCasterCuller;    // finds the spot light views every mesh touches
+AMD::ShadowAtlasAllocator                        g_LightShadowAtlas;           // regions of g_LightShadowMap
+AMD::ShadowLightList                             g_ShadowLightList;            // atlas regions and ShadowFX batches of the spot lights
+AMD::ShadowCascades                              g_ShadowCascades;             // the views of the cascades when the cascaded sun light is enabled
+unsigned int                                     g_ShadowLight[SHADOW_LIGHT_MAX_COUNT]; // the spot lights in g_ShadowLightList
+AMD::TransferTrace                               g_TransferTrace;              // records the Crossfire API notifications, toggled with 'T'
+#if ENABLE_TRANSFER_VALIDATION
+AMD::TransferValidator                           g_TransferValidator;          // checks the order of the Crossfire API notifications
+#endif
 int                                              g_ShadowTextureType = AMD::SHADOWFX_TEXTURE_2D;
 int                                              g_agsGpuCount = 0;
 
@@ -248,9 +444,31 @@ const bool                                       g_DisableCfx = false;
 float                                            g_ShadowRenderingTime = 0.0f;
 float                                            g_ShadowFilteringTime = 0.0f;
 float                                            g_DepthPrepassRenderingTime = 0.0f;
+float                                            g_CommandRecordingTime = 0.0f; // CPU
 float                                            g_ShadowMapMasking = 0.0f;
 float                                            g_SceneRendering = 0.0f;
 
+//--------------------------------------------------------------------------------------
+// Benchmark mode (-benchmark): the viewer and the light follow a path at a fixed time
+// step, every frame after the warmup is measured, and the results are saved on exit.
+// With -benchmarksweep every configuration of the sweep is run that way in turn
+//--------------------------------------------------------------------------------------
+#define BENCHMARK_TIME_STEP (1.0f / 60.0f)
+bool                                             g_Benchmark = false;
+AMD::BenchmarkPath                               g_BenchmarkPath;
+AMD::BenchmarkResults                            g_BenchmarkResults;
+char                                             g_BenchmarkOutput[MAX_PATH];
+int                                              g_BenchmarkWarmupFrames = 0;
+int                                              g_BenchmarkFrames = 0;
+int                                              g_BenchmarkFrame = 0;           // frames rendered, warmup included
+unsigned long long                               g_BenchmarkFrameStart = 0;      // GetTransferTraceTimestamp at the start of the frame
+AMD::BenchmarkSweep                              g_BenchmarkSweep;
+int                                              g_BenchmarkSweepConfig = -1;    // the configuration being run, -1 without a sweep
+unsigned int                                     g_FrameEndWritesCount = 0;      // Crossfire API calls of the frame
+unsigned int                                     g_FrameBeginAllAccessCount = 0;
+unsigned int                                     g_FrameEndAllAccessCount = 0;
+unsigned int                                     g_FrameTransferCopyCount = 0;
+
 //--------------------------------------------------------------------------------------
 // UI control IDs
 //--------------------------------------------------------------------------------------
@@ -277,8 +495,26 @@ enum CROSSFIRE_API_SAMPLE_IDC
     IDC_CHECKBOX_ENABLE_CROSSFIRE_API,
     IDC_CHECKBOX_ENABLE_2_STEP_GPU_TRANSFER,
     IDC_CHECKBOX_DELAY_END_ALL_ACCESS,
+    IDC_CHECKBOX_ENABLE_ADAPTIVE_TRANSFER,
 
     IDC_CHECKBOX_ENABLE_1_FACE_UPDATE_PER_FRAME,
+    IDC_CHECKBOX_ENABLE_PRIORITIZED_FACE_UPDATE,
+    IDC_CHECKBOX_ENABLE_AFFINE_FACE_UPDATE,
+    IDC_CHECKBOX_SKIP_UNCHANGED_FACES,
+    IDC_SLIDER_MAX_AFFINE_FACE_AGE,
+    IDC_CHECKBOX_ENABLE_DYNAMIC_SHADOW_ATLAS,
+    IDC_CHECKBOX_ENABLE_CASTER_CULLING,
+    IDC_CHECKBOX_ENABLE_STATIC_SHADOW_CACHE,
+    IDC_SLIDER_SHADOW_LIGHT_COUNT,
+    IDC_CHECKBOX_ENABLE_SHADOW_CASCADES,
+    IDC_SLIDER_FAR_CASCADE_INTERVAL,
+    IDC_CHECKBOX_ENABLE_SINGLE_PASS_SHADOW_FACES,
+    IDC_CHECKBOX_ENABLE_STATE_CACHE,
+    IDC_CHECKBOX_ENABLE_CONSTANT_RING,
+    IDC_CHECKBOX_ENABLE_INSTANCED_LIGHT_VOLUMES,
+    IDC_CHECKBOX_ENABLE_INSTANCED_MESHES,
+    IDC_CHECKBOX_ENABLE_DEFERRED_RECORDING,
+    IDC_SLIDER_RECORD_THREAD_COUNT,
 
     IDC_NUM_CONTROL_IDS
 };
@@ -304,11 +540,25 @@ void    CALLBACK OnD3D11FrameRender(ID3D11Device* pd3dDevice, ID3D11DeviceContex
 
 void             InitApplicationUI();
 void             InitTransferredResources(ID3D11Device * pDevice);
+void             CreateTransferredShadowMaps(ID3D11Device * pDevice, unsigned int shadowMaps);
+void             InitShadowLights();
+void             InitShadowCascades();
+AMD::ShadowCasterBounds GetMeshBounds(AMD::Mesh & mesh);
+void             UpdateTransferFlags();
+void             UpdateAdaptiveTransferMode(ID3D11Device * pDevice, float fElapsedTime);
 void             RenderText();
 
 void             CreateShaders(ID3D11Device * pDevice);
 void             InitializeCubeCamera(CFirstPersonCamera * pViewer, CFirstPersonCamera * pCubeCamera, S_CAMERA_DATA * pCubeCameraData);
-void             InitializeCascadeCamera(CFirstPersonCamera * pViewer, CFirstPersonCamera * pCubeCamera, S_CAMERA_DATA * pCubeCameraData, float4x4 * ortho);
+unsigned int     InitializeCascadeCamera(CFirstPersonCamera * pViewer, CFirstPersonCamera * pCascadeCamera, float4x4 * ortho, unsigned int frame, unsigned int * pCascades);
+bool             InitScene(const AMD::CmdLineParams & params);
+bool             InitBenchmark(const AMD::CmdLineParams & params);
+void             UpdateBenchmarkCameras();
+void             RecordBenchmarkFrame(unsigned int faceCount, float fElapsedTime);
+AMD::ShadowAtlasRect GetShadowAtlasRect(unsigned int face);
+#if ENABLE_TRANSFER_VALIDATION
+void             ReportTransferValidationError(const AMD::TransferValidationError & error, void * pUserData);
+#endif
 
 #include "CrossfireAPI11_UI.inl"
 
@@ -340,6 +590,17 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmdLi
 
     InitApplicationUI();
 
+    AMD::CmdLineParams params;
+    AMD::ParseCommandLine(&params);
+    if (InitScene(params) == false)
+    {
+        return 1;
+    }
+    if (params.bBenchmark == true && InitBenchmark(params) == false)
+    {
+        return 1;
+    }
+
     DXUTInit(true, true);                 // Use this line instead to try to create a hardware device
     DXUTSetCursorSettings(true, true);    // Show the cursor and clip it when in full screen
     DXUTCreateWindow(L"CrossfireAPI11 v1.0");
@@ -358,16 +619,150 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPWSTR lpCmdLi
 //--------------------------------------------------------------------------------------
 void CALLBACK OnFrameMove(double fTime, float fElapsedTime, void* pUserContext)
 {
+    if (g_Benchmark == true) // the path drives the cameras, not the input
+    {
+        if (g_BenchmarkFrame == 0 && g_BenchmarkSweepConfig >= 0) // the first frame of a configuration of the sweep
+        {
+            SetBenchmarkSweepConfig(g_BenchmarkSweep.GetConfig((unsigned int)g_BenchmarkSweepConfig));
+        }
+
+        UpdateBenchmarkCameras();
+        return;
+    }
 
     g_pCurrentCamera->FrameMove(fElapsedTime);
 
-    if (g_pCurrentCamera == &g_LightCamera)
+    if (g_pCurrentCamera == &g_LightCamera && g_ShadowsExecution == AMD::SHADOWFX_EXECUTION_CUBE) // the cascades follow the viewer, see InitializeCascadeCamera
     {
         InitializeCubeCamera(g_pCurrentCamera, g_CubeCamera, g_LightData);
     }
 }
 
 
+//--------------------------------------------------------------------------------------
+// Reads the scene and places its instances; their meshes are created with the device
+//--------------------------------------------------------------------------------------
+bool InitScene(const AMD::CmdLineParams & params)
+{
+    const WCHAR * pPath = params.strScene[0] != 0 ? params.strScene : L"..\\media\\scenes\\default.txt";
+
+    char path[MAX_PATH];
+    WideCharToMultiByte(CP_ACP, 0, pPath, -1, path, MAX_PATH, NULL, NULL);
+
+    if (g_Scene.Load(path) == false || g_Scene.GetInstanceCount() == 0)
+    {
+        WCHAR message[MAX_PATH + 64];
+        swprintf_s(message, L"Can't read the scene %s (line %u)\n", pPath, g_Scene.GetErrorLine());
+        OutputDebugString(message);
+        return false;
+    }
+
+    g_MeshCount = g_Scene.GetInstanceCount();
+    g_MeshArray.assign(g_MeshCount, NULL);
+    g_InstanceMesh.resize(g_MeshCount);
+    g_AllInstances.resize(g_MeshCount);
+    g_ShadowCasters.resize(g_MeshCount);
+    for (unsigned int job = 0; job < RECORD_JOB_COUNT; job++)
+    {
+        g_RecordShadowCasters[job].resize(g_MeshCount);
+    }
+    g_MeshModelMatrix.resize(g_MeshCount);
+    g_MeshBounds.resize(g_MeshCount);
+    g_MeshFaceMask.assign(g_MeshCount, (1u << CUBE_FACE_COUNT) - 1);
+    g_MeshIsStatic.resize(g_MeshCount);
+
+    for (unsigned int mesh = 0; mesh < g_MeshCount; mesh++)
+    {
+        const AMD::SceneInstance & instance = g_Scene.GetInstance(mesh);
+
+        g_InstanceMesh[mesh] = instance.m_Mesh;
+        g_AllInstances[mesh] = mesh;
+        g_MeshModelMatrix[mesh] = XMLoadFloat4x4((const XMFLOAT4X4 *)instance.m_World);
+        g_MeshIsStatic[mesh] = instance.m_Static;
+    }
+
+    // the spot lights of the scene take the place of the first ones of the ring, see InitShadowLights
+    if (g_Scene.GetLightCount() > 0)
+    {
+        g_pShadowLightCountSlider->SetValue((int)AMD::MIN(g_Scene.GetLightCount(), (unsigned int)SHADOW_LIGHT_MAX_COUNT));
+    }
+
+    return true;
+}
+
+//--------------------------------------------------------------------------------------
+// Loads the path of the benchmark mode; the HUD is hidden so that it isn't measured
+//--------------------------------------------------------------------------------------
+bool InitBenchmark(const AMD::CmdLineParams & params)
+{
+    const WCHAR * pPath = params.strBenchmarkPath[0] != 0 ? params.strBenchmarkPath : L"..\\media\\benchmark\\orbit.txt";
+
+    const bool    sweep = params.strBenchmarkSweep[0] != 0;
+    const WCHAR * pOutput = params.strBenchmarkOutput[0] != 0 ? params.strBenchmarkOutput : (sweep == true ? L"BenchmarkSweep.txt" : L"Benchmark.json");
+
+    char path[MAX_PATH];
+    WideCharToMultiByte(CP_ACP, 0, pPath, -1, path, MAX_PATH, NULL, NULL);
+    WideCharToMultiByte(CP_ACP, 0, pOutput, -1, g_BenchmarkOutput, MAX_PATH, NULL, NULL);
+
+    WCHAR message[MAX_PATH + 64];
+    if (g_BenchmarkPath.Load(path) == false)
+    {
+        swprintf_s(message, L"Can't read the benchmark path %s (line %u)\n", pPath, g_BenchmarkPath.GetErrorLine());
+        OutputDebugString(message);
+        return false;
+    }
+
+    g_BenchmarkSweepConfig = -1;
+    if (sweep == true)
+    {
+        char sweepPath[MAX_PATH];
+        WideCharToMultiByte(CP_ACP, 0, params.strBenchmarkSweep, -1, sweepPath, MAX_PATH, NULL, NULL);
+
+        if (g_BenchmarkSweep.Load(sweepPath) == false)
+        {
+            swprintf_s(message, L"Can't read the benchmark sweep %s (line %u)\n", params.strBenchmarkSweep, g_BenchmarkSweep.GetErrorLine());
+            OutputDebugString(message);
+            return false;
+        }
+        g_BenchmarkSweepConfig = 0; // set on the first frame, see OnFrameMove
+    }
+
+    g_Benchmark = true;
+    g_BenchmarkWarmupFrames = AMD::MAX(params.iBenchmarkWarmupFrames, 0);
+    g_BenchmarkFrames = AMD::MAX(params.iBenchmarkFrames, 1);
+    g_BenchmarkFrame = 0;
+    g_BenchmarkResults.Reset();
+    g_bRenderHUD = false;
+
+    return true;
+}
+
+//--------------------------------------------------------------------------------------
+// The viewer and the light where the path has them at this frame. The time only depends
+// on the frame, so every run renders the same frames however fast it runs
+//--------------------------------------------------------------------------------------
+void UpdateBenchmarkCameras()
+{
+    const float time = (float)g_BenchmarkFrame * BENCHMARK_TIME_STEP;
+    const float4 vecUp(0.0f, 1.0f, 0.0f);
+    float eye[3], at[3];
+
+    if (g_BenchmarkPath.Sample(AMD::BENCHMARK_TRACK_CAMERA, time, eye, at) == true)
+    {
+        g_ViewerCamera.SetViewParams(float4(eye[0], eye[1], eye[2], 1.0f), float4(at[0], at[1], at[2], 1.0f), vecUp);
+    }
+
+    if (g_BenchmarkPath.Sample(AMD::BENCHMARK_TRACK_LIGHT, time, eye, at) == true)
+    {
+        g_LightCamera.SetViewParams(float4(eye[0], eye[1], eye[2], 1.0f), float4(at[0], at[1], at[2], 1.0f), vecUp);
+
+        if (g_ShadowsExecution == AMD::SHADOWFX_EXECUTION_CUBE)
+        {
+            InitializeCubeCamera(&g_LightCamera, g_CubeCamera, g_LightData);
+        }
+    }
+}
+
 //--------------------------------------------------------------------------------------
 // Before handling window messages, DXUT passes incoming windows
 // messages to the application through this callback function. If the application sets
@@ -404,54 +799,205 @@ LRESULT CALLBACK MsgProc(HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam, boo
 }
 
 //--------------------------------------------------------------------------------------
-// Create any D3D11 resources that aren't dependant on the back buffer
+// (Re)create the shadow maps that carry a transfer flag. Only the bookkeeping of what the
+// recreated maps hold is reset, the lights, cascades and atlas layout stay as they are.
 //--------------------------------------------------------------------------------------
-void             InitTransferredResources(ID3D11Device * pDevice)
+void             CreateTransferredShadowMaps(ID3D11Device * pDevice, unsigned int shadowMaps)
 {
+    // while a GPU writes one "Transfer" shadow map, the transfers of the previous frames still use the others
+    const unsigned int slotCount = AMD::TransferRing::GetSlotCount((unsigned int)AMD::MAX(g_agsGpuCount, 1));
 
-    if (g_ShadowTextureType == AMD::SHADOWFX_TEXTURE_2D_ARRAY)
-    {
-        g_ShadowMapSubregion.Release(); // we won't need the subregion for the texture2d array resource
+    // the atlas packs the 6 faces into one slice, the "Transfer" atlas is written as a render target
+    const bool         isArray   = g_ShadowTextureType == AMD::SHADOWFX_TEXTURE_2D_ARRAY;
+    const unsigned int width     = isArray == true ? (unsigned int)g_ShadowMapSize : (unsigned int)g_ShadowMapSize * g_ShadowMapAtlasScaleW;
+    const unsigned int height    = isArray == true ? (unsigned int)g_ShadowMapSize : (unsigned int)g_ShadowMapSize * g_ShadowMapAtlasScaleH;
+    const unsigned int arraySize = isArray == true ? CUBE_FACE_COUNT : 1;
 
+    if ((shadowMaps & TRANSFERRED_SHADOW_MAP_MAIN) != 0)
+    {
         g_ShadowMap.Release();
-        g_ShadowMap.CreateSurface(DXUTGetD3D11Device(),
-                                  (unsigned int)g_ShadowMapSize, (unsigned int)g_ShadowMapSize, 1, 6, 1,
+        g_ShadowMap.CreateSurface(pDevice,
+                                  width, height, 1, arraySize, 1,
                                   DXGI_FORMAT_R32_TYPELESS, DXGI_FORMAT_R32_FLOAT,
                                   DXGI_FORMAT_UNKNOWN, DXGI_FORMAT_D32_FLOAT,
                                   DXGI_FORMAT_UNKNOWN, DXGI_FORMAT_UNKNOWN,
-                                  D3D11_USAGE_DEFAULT, true, 0, NULL, g_agsContext, g_ShadowMapCfxFlag);
+                                  D3D11_USAGE_DEFAULT, isArray, 0, NULL, g_agsContext, g_ShadowMapCfxFlag);
+
+        // all shadow maps are R32, the trace uses this to turn the notified regions into bytes
+        TRANSFER_VALIDATE_REGISTER_RESOURCE(g_TransferValidator, g_ShadowMap._t2d, "ShadowMap")
+        g_TransferTrace.RegisterResource(g_ShadowMap._t2d, "ShadowMap", g_ShadowMap._width, g_ShadowMap._height, g_ShadowMap._array, 4, g_ShadowMapCfxFlag);
+    }
 
-        if (g_Enable2StepGpuTransfer == true) // we'll need the "Transfer" shadow map, only if the UI checkbox is enbaled
+    if ((shadowMaps & TRANSFERRED_SHADOW_MAP_TRANSFER) != 0)
+    {
+        for (unsigned int slot = 0; slot < AMD::TRANSFER_RING_MAX_SLOT_COUNT; slot++)
         {
-            g_ShadowMapTransfer.Release();
-            g_ShadowMapTransfer.CreateSurface(DXUTGetD3D11Device(),
-                                              (unsigned int)g_ShadowMapSize, (unsigned int)g_ShadowMapSize, 1, 6, 1,
-                                              DXGI_FORMAT_R32_TYPELESS, DXGI_FORMAT_R32_FLOAT,
-                                              DXGI_FORMAT_UNKNOWN, DXGI_FORMAT_D32_FLOAT,
-                                              DXGI_FORMAT_UNKNOWN, DXGI_FORMAT_UNKNOWN,
-                                              D3D11_USAGE_DEFAULT, true, 0, NULL, g_agsContext, g_ShadowMapTransferCfxFlag);
+            g_ShadowMapTransfer[slot].Release();
+        }
+
+        for (unsigned int slot = 0; g_Enable2StepGpuTransfer == true && slot < slotCount; slot++) // we'll need the "Transfer" shadow maps, only if the UI checkbox is enbaled
+        {
+            g_ShadowMapTransfer[slot].CreateSurface(pDevice,
+                                                    width, height, 1, arraySize, 1,
+                                                    DXGI_FORMAT_R32_TYPELESS, DXGI_FORMAT_R32_FLOAT,
+                                                    isArray == true ? DXGI_FORMAT_UNKNOWN : DXGI_FORMAT_R32_FLOAT, isArray == true ? DXGI_FORMAT_D32_FLOAT : DXGI_FORMAT_UNKNOWN,
+                                                    DXGI_FORMAT_UNKNOWN, DXGI_FORMAT_UNKNOWN,
+                                                    D3D11_USAGE_DEFAULT, isArray, 0, NULL, g_agsContext, g_ShadowMapTransferCfxFlag);
+
+            char name[32];
+            sprintf_s(name, "ShadowMapTransfer%u", slot);
+
+            TRANSFER_VALIDATE_REGISTER_RESOURCE(g_TransferValidator, g_ShadowMapTransfer[slot]._t2d, name)
+            g_TransferTrace.RegisterResource(g_ShadowMapTransfer[slot]._t2d, name, g_ShadowMapTransfer[slot]._width, g_ShadowMapTransfer[slot]._height, g_ShadowMapTransfer[slot]._array, 4, g_ShadowMapTransferCfxFlag);
         }
     }
-    else // (g_ShadowTextureType == AMD::SHADOWFX_TEXTURE_2D)
+
+    if ((shadowMaps & TRANSFERRED_SHADOW_MAP_STATIC) != 0)
     {
-        g_ShadowMap.Release();
-        g_ShadowMap.CreateSurface(DXUTGetD3D11Device(),
-                                  (unsigned int)g_ShadowMapSize * g_ShadowMapAtlasScaleW, (unsigned int)g_ShadowMapSize * g_ShadowMapAtlasScaleH, 1, 1, 1,
-                                  DXGI_FORMAT_R32_TYPELESS, DXGI_FORMAT_R32_FLOAT,
-                                  DXGI_FORMAT_UNKNOWN, DXGI_FORMAT_D32_FLOAT,
-                                  DXGI_FORMAT_UNKNOWN, DXGI_FORMAT_UNKNOWN,
-                                  D3D11_USAGE_DEFAULT, false, 0, NULL, g_agsContext, g_ShadowMapCfxFlag);
+        g_ShadowMapStatic.Release();
 
-        if (g_Enable2StepGpuTransfer == true) // we'll need the "Transfer" shadow map, only if the UI checkbox is enbaled
+        if (g_EnableStaticShadowCache == true) // the static layer is only needed if the UI checkbox is enabled
         {
-            g_ShadowMapTransfer.Release();
-            g_ShadowMapTransfer.CreateSurface(DXUTGetD3D11Device(),
-                                              (unsigned int)g_ShadowMapSize * g_ShadowMapAtlasScaleW, (unsigned int)g_ShadowMapSize * g_ShadowMapAtlasScaleH, 1, 1, 1,
-                                              DXGI_FORMAT_R32_TYPELESS, DXGI_FORMAT_R32_FLOAT,
-                                              DXGI_FORMAT_R32_FLOAT, DXGI_FORMAT_UNKNOWN,
-                                              DXGI_FORMAT_UNKNOWN, DXGI_FORMAT_UNKNOWN,
-                                              D3D11_USAGE_DEFAULT, false, 0, NULL, g_agsContext, g_ShadowMapTransferCfxFlag);
+            g_ShadowMapStatic.CreateSurface(pDevice,
+                                            width, height, 1, arraySize, 1,
+                                            DXGI_FORMAT_R32_TYPELESS, DXGI_FORMAT_R32_FLOAT,
+                                            DXGI_FORMAT_UNKNOWN, DXGI_FORMAT_D32_FLOAT,
+                                            DXGI_FORMAT_UNKNOWN, DXGI_FORMAT_UNKNOWN,
+                                            D3D11_USAGE_DEFAULT, isArray, 0, NULL, g_agsContext, g_ShadowMapStaticCfxFlag);
+
+            TRANSFER_VALIDATE_REGISTER_RESOURCE(g_TransferValidator, g_ShadowMapStatic._t2d, "ShadowMapStatic")
+            g_TransferTrace.RegisterResource(g_ShadowMapStatic._t2d, "ShadowMapStatic", g_ShadowMapStatic._width, g_ShadowMapStatic._height, g_ShadowMapStatic._array, 4, g_ShadowMapStaticCfxFlag);
+        }
+
+        g_StaticShadowFaceCache.Reset(); // the new static layer has none of the faces yet
+    }
+
+    // the faces reach the other GPUs through the "Transfer" shadow maps, so both hold the GPUs' copies
+    if ((shadowMaps & (TRANSFERRED_SHADOW_MAP_MAIN | TRANSFERRED_SHADOW_MAP_TRANSFER)) != 0)
+    {
+        g_ShadowFaceScheduler.Reset(); // the new shadow map has none of the faces yet
+        g_ShadowFaceCache.Reset();
+        g_ShadowFaceAffinity.Reset();
+        g_TransferRing.Init((unsigned int)AMD::MAX(g_agsGpuCount, 1), CUBE_FACE_COUNT, slotCount);
+    }
+}
+
+//--------------------------------------------------------------------------------------
+// Create any D3D11 resources that aren't dependant on the back buffer
+//--------------------------------------------------------------------------------------
+void             InitTransferredResources(ID3D11Device * pDevice)
+{
+    if (g_ShadowTextureType == AMD::SHADOWFX_TEXTURE_2D_ARRAY)
+    {
+        g_ShadowMapSubregion.Release(); // we won't need the subregion for the texture2d array resource
+    }
+
+    g_ShadowFaceAffinity.Init((unsigned int)AMD::MAX(g_agsGpuCount, 1), CUBE_FACE_COUNT);
+    g_ShadowFaceAffinity.SetMaxAge((unsigned int)g_MaxAffineFaceAge);
+
+    CreateTransferredShadowMaps(DXUTGetD3D11Device(), TRANSFERRED_SHADOW_MAP_ALL);
+
+    // the spot lights always use an atlas, whatever the type of the shadow map
+    g_LightShadowMap.Release();
+    g_LightShadowMap.CreateSurface(DXUTGetD3D11Device(),
+                                   (unsigned int)g_ShadowMapSize * 2, (unsigned int)g_ShadowMapSize * 2, 1, 1, 1,
+                                   DXGI_FORMAT_R32_TYPELESS, DXGI_FORMAT_R32_FLOAT,
+                                   DXGI_FORMAT_UNKNOWN, DXGI_FORMAT_D32_FLOAT,
+                                   DXGI_FORMAT_UNKNOWN, DXGI_FORMAT_UNKNOWN,
+                                   D3D11_USAGE_DEFAULT, false, 0, NULL, g_agsContext, AGS_AFR_TRANSFER_DISABLE);
+
+    // the dynamic atlas has the size of the fixed 3x2 grid, its regions are placed on the next frame
+    g_ShadowFaceLod.Init(CUBE_FACE_COUNT, (unsigned int)g_ShadowMapSize / 8, (unsigned int)g_ShadowMapSize);
+    g_ShadowAtlas.Init((unsigned int)g_ShadowMapSize * g_ShadowMapAtlasScaleW, (unsigned int)g_ShadowMapSize * g_ShadowMapAtlasScaleH);
+    for (unsigned int face = 0; face < CUBE_FACE_COUNT; face++)
+    {
+        g_ShadowAtlasRegion[face] = AMD::SHADOW_ATLAS_INVALID_REGION;
+    }
+    InitShadowLights();
+    InitShadowCascades();
+}
+
+//--------------------------------------------------------------------------------------
+// Derive the flags of the shadow map and the "Transfer" shadow map from the UI settings.
+// The static layer changes rarely: it is broadcast once when it is rendered, unless
+// transfers are disabled, and then every GPU renders its own.
+//--------------------------------------------------------------------------------------
+void             UpdateTransferFlags()
+{
+    if (g_EnableCrossfireApiTransfers == false)
+    {
+        g_ShadowMapCfxFlag = g_ShadowMapTransferCfxFlag = g_ShadowMapStaticCfxFlag = AGS_AFR_TRANSFER_DEFAULT;
+    }
+    else
+    {
+        if (g_Enable2StepGpuTransfer == true)
+        {
+            g_ShadowMapCfxFlag = AGS_AFR_TRANSFER_DISABLE;
+            g_ShadowMapTransferCfxFlag = g_ResourceCfxTransferFlag;
+        }
+        else
+        {
+            g_ShadowMapCfxFlag = g_ResourceCfxTransferFlag;
+            g_ShadowMapTransferCfxFlag = AGS_AFR_TRANSFER_DISABLE;
+        }
+
+        g_ShadowMapStaticCfxFlag = g_ResourceCfxTransferFlag == AGS_AFR_TRANSFER_DISABLE ? AGS_AFR_TRANSFER_DISABLE : AGS_AFR_TRANSFER_2STEP_WITH_BROADCAST;
+    }
+}
+
+//--------------------------------------------------------------------------------------
+// Feed the frame time to the transfer mode controller and recreate the transferred
+// resources when it decides to switch. AGS_AFR_TRANSFER_DISABLE is only a candidate
+// when all cube faces are updated every frame, because every GPU then renders them itself.
+//--------------------------------------------------------------------------------------
+void             UpdateAdaptiveTransferMode(ID3D11Device * pDevice, float fElapsedTime)
+{
+    if (g_EnableAdaptiveTransfers == false || g_EnableCrossfireApiTransfers == false || g_agsGpuCount < 2)
+    {
+        return;
+    }
+
+    unsigned int candidateMask = TRANSFER_MODE_BIT(AGS_AFR_TRANSFER_1STEP_P2P) |
+                                 TRANSFER_MODE_BIT(AGS_AFR_TRANSFER_2STEP_NO_BROADCAST) |
+                                 TRANSFER_MODE_BIT(AGS_AFR_TRANSFER_2STEP_WITH_BROADCAST);
+
+    if (g_HUD.m_GUI.GetCheckBox(IDC_CHECKBOX_ENABLE_1_FACE_UPDATE_PER_FRAME)->GetChecked() == false &&
+        g_HUD.m_GUI.GetCheckBox(IDC_CHECKBOX_ENABLE_PRIORITIZED_FACE_UPDATE)->GetChecked() == false &&
+        g_EnableAffineFaceUpdates == false)
+    {
+        candidateMask |= TRANSFER_MODE_BIT(AGS_AFR_TRANSFER_DISABLE);
+    }
+
+    bool modeChanged = g_TransferModeController.SetCandidateMask(candidateMask);
+    modeChanged = g_TransferModeController.AddSample(fElapsedTime * 1000.0) || modeChanged; // frame interval includes transfer stalls and contention
+
+    if (modeChanged == true)
+    {
+        g_ResourceCfxTransferFlag = (AGSAfrTransferType)g_TransferModeController.GetMode();
+
+        switch (g_ResourceCfxTransferFlag)
+        {
+        case AGS_AFR_TRANSFER_1STEP_P2P:            g_HUD.m_GUI.GetRadioButton(IDC_RADIO_TRANSFER_FLAG_1STEP)->SetChecked(true); break;
+        case AGS_AFR_TRANSFER_2STEP_NO_BROADCAST:   g_HUD.m_GUI.GetRadioButton(IDC_RADIO_TRANSFER_FLAG_2STEP)->SetChecked(true); break;
+        case AGS_AFR_TRANSFER_2STEP_WITH_BROADCAST: g_HUD.m_GUI.GetRadioButton(IDC_RADIO_TRANSFER_FLAG_2STEP_BROADCAST)->SetChecked(true); break;
+        case AGS_AFR_TRANSFER_DISABLE:              g_HUD.m_GUI.ClearRadioButtonGroup(IDC_RADIO_BUTTON_GROUP_TRANSFER_FLAG); break; // no button for it, RenderText shows it
+        default: break;
         }
+
+        const AGSAfrTransferType shadowMapFlag         = g_ShadowMapCfxFlag;
+        const AGSAfrTransferType shadowMapTransferFlag = g_ShadowMapTransferCfxFlag;
+        const AGSAfrTransferType shadowMapStaticFlag   = g_ShadowMapStaticCfxFlag;
+
+        UpdateTransferFlags();
+
+        // the transfer flag is fixed at creation, so only the shadow maps whose flag changed are recreated;
+        // the controller ignores the frames after the switch that render their faces again
+        unsigned int shadowMaps = 0;
+        shadowMaps |= g_ShadowMapCfxFlag != shadowMapFlag ? TRANSFERRED_SHADOW_MAP_MAIN : 0;
+        shadowMaps |= g_ShadowMapTransferCfxFlag != shadowMapTransferFlag ? TRANSFERRED_SHADOW_MAP_TRANSFER : 0;
+        shadowMaps |= g_ShadowMapStaticCfxFlag != shadowMapStaticFlag ? TRANSFERRED_SHADOW_MAP_STATIC : 0;
+
+        CreateTransferredShadowMaps(pDevice, shadowMaps);
     }
 }
 
@@ -511,6 +1057,24 @@ HRESULT CALLBACK OnD3D11CreateDevice(ID3D11Device* pd3dDevice, const DXGI_SURFAC
     V_RETURN(g_DialogResourceManager.OnD3D11CreateDevice(pd3dDevice, pd3dContext));
     V_RETURN(g_SettingsDlg.OnD3D11CreateDevice(pd3dDevice));
     g_pTxtHelper = new CDXUTTextHelper(pd3dDevice, pd3dContext, &g_DialogResourceManager, 15);
+    g_StateCacheTarget.SetContext(pd3dContext);
+    g_StateCache.SetTarget(&g_StateCacheTarget);
+    g_StateCache.SetEnabled(g_EnableStateCache);
+
+    // without deferred contexts every pass is rendered on the immediate context
+    for (unsigned int job = 0; job < RECORD_JOB_COUNT; job++)
+    {
+        if (FAILED(pd3dDevice->CreateDeferredContext(0, &g_pRecordContext[job])))
+        {
+            g_pRecordContext[job] = NULL;
+            break;
+        }
+        g_RecordStateCacheTarget[job].SetContext(g_pRecordContext[job]);
+        g_RecordStateCache[job].SetTarget(&g_RecordStateCacheTarget[job]);
+        g_RecordStateCache[job].SetEnabled(g_EnableStateCache);
+    }
+    g_JobSystem.Init((unsigned int)g_RecordThreadCount);
+
     // Hooks to various AMD helper classes
     g_MagnifyTool.OnCreateDevice(pd3dDevice);
     g_HUD.OnCreateDevice(pd3dDevice);
@@ -520,23 +1084,15 @@ HRESULT CALLBACK OnD3D11CreateDevice(ID3D11Device* pd3dDevice, const DXGI_SURFAC
 
     CreateShaders(pd3dDevice);
 
-    if (g_EnableCrossfireApiTransfers == false)
-    {
-        g_ShadowMapCfxFlag = g_ShadowMapTransferCfxFlag = AGS_AFR_TRANSFER_DEFAULT;
-    }
-    else
-    {
-        if (g_Enable2StepGpuTransfer == true)
-        {
-            g_ShadowMapCfxFlag = AGS_AFR_TRANSFER_DISABLE;
-            g_ShadowMapTransferCfxFlag = g_ResourceCfxTransferFlag;
-        }
-        else
-        {
-            g_ShadowMapCfxFlag = g_ResourceCfxTransferFlag;
-            g_ShadowMapTransferCfxFlag = AGS_AFR_TRANSFER_DISABLE;
-        }
-    }
+    LARGE_INTEGER timerFrequency;
+    QueryPerformanceFrequency(&timerFrequency);
+    g_TransferTrace.Init(1 << 16, (unsigned int)AMD::MAX(g_agsGpuCount, 1), (unsigned long long)timerFrequency.QuadPart);
+
+#if ENABLE_TRANSFER_VALIDATION
+    g_TransferValidator.SetCallback(ReportTransferValidationError, NULL);
+#endif
+
+    UpdateTransferFlags();
     InitTransferredResources(pd3dDevice);
 
     g_LightDepth.Release();
@@ -589,14 +1145,76 @@ HRESULT CALLBACK OnD3D11CreateDevice(ID3D11Device* pd3dDevice, const DXGI_SURFAC
     V_RETURN(pd3dDevice->CreateBuffer(&b1dDesc, NULL, &g_pUnitCubeCB));
     DXUT_SetDebugName(g_pUnitCubeCB, "g_pUnitCubeCB");
 
-    // Load the meshes
+    b1dDesc.Usage = D3D11_USAGE_DYNAMIC;
+    b1dDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+    b1dDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    b1dDesc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+    b1dDesc.ByteWidth = sizeof(S_LIGHT_VOLUME_DATA) * CUBE_FACE_COUNT;
+    b1dDesc.StructureByteStride = sizeof(S_LIGHT_VOLUME_DATA);
+    V_RETURN(pd3dDevice->CreateBuffer(&b1dDesc, NULL, &g_pLightVolumeSB));
+    DXUT_SetDebugName(g_pLightVolumeSB, "g_pLightVolumeSB");
+
+    CD3D11_SHADER_RESOURCE_VIEW_DESC lightVolumeDesc(D3D11_SRV_DIMENSION_BUFFER, DXGI_FORMAT_UNKNOWN, 0, CUBE_FACE_COUNT);
+    V_RETURN(pd3dDevice->CreateShaderResourceView(g_pLightVolumeSB, &lightVolumeDesc, &g_pLightVolumeSRV));
+
+    b1dDesc.Usage = D3D11_USAGE_DYNAMIC;
+    b1dDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+    b1dDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    b1dDesc.MiscFlags = 0;
+    b1dDesc.ByteWidth = sizeof(S_SHADOW_FACE_DATA);
+    V_RETURN(pd3dDevice->CreateBuffer(&b1dDesc, NULL, &g_pShadowFaceCB));
+    DXUT_SetDebugName(g_pShadowFaceCB, "g_pShadowFaceCB");
+
+    // a region of the ring per frame in flight, and with AFR per GPU, see ConstantRing.h
+    D3D11_FEATURE_DATA_D3D11_OPTIONS options;
+    if (SUCCEEDED(pd3dDevice->CheckFeatureSupport(D3D11_FEATURE_D3D11_OPTIONS, &options, sizeof(options))) &&
+        options.ConstantBufferOffsetting == TRUE && options.MapNoOverwriteOnDynamicConstantBuffer == TRUE &&
+        g_StateCacheTarget.SupportsConstantBufferRanges() == true)
+    {
+        g_ConstantRing.Init(256 * 1024, (unsigned int)AMD::MAX(g_agsGpuCount, 1));
+
+        b1dDesc.Usage = D3D11_USAGE_DYNAMIC;
+        b1dDesc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+        b1dDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+        b1dDesc.MiscFlags = 0;
+        b1dDesc.ByteWidth = g_ConstantRing.GetSize();
+        V_RETURN(pd3dDevice->CreateBuffer(&b1dDesc, NULL, &g_pConstantRingCB));
+        DXUT_SetDebugName(g_pConstantRingCB, "g_pConstantRingCB");
+    }
+
+    // Load the meshes of the scene
+
+    std::vector<AMD::ShadowCasterBounds> meshBounds(g_Scene.GetMeshCount());
+    g_SceneMeshes.resize(g_Scene.GetMeshCount());
+
+    for (unsigned int asset = 0; asset < g_Scene.GetMeshCount(); asset++)
+    {
+        const AMD::SceneMesh & sceneMesh = g_Scene.GetMesh(asset);
+        const size_t           extension = sceneMesh.m_File.rfind('.');
+        const bool             sdkmesh = extension != std::string::npos && _stricmp(sceneMesh.m_File.c_str() + extension, ".sdkmesh") == 0;
+
+        g_SceneMeshes[asset] = new AMD::Mesh();
+        V_RETURN(g_SceneMeshes[asset]->Create(pd3dDevice, sceneMesh.m_Directory.c_str(), sceneMesh.m_File.c_str(), sdkmesh));
+        meshBounds[asset] = GetMeshBounds(*g_SceneMeshes[asset]);
+    }
+
+    for (unsigned int mesh = 0; mesh < g_MeshCount; mesh++)
+    {
+        g_MeshArray[mesh] = g_SceneMeshes[g_InstanceMesh[mesh]];
+        g_MeshBounds[mesh] = meshBounds[g_InstanceMesh[mesh]];
+    }
 
-    V_RETURN(g_Tree.Create(pd3dDevice, "..\\media\\coconuttree\\", "coconut.sdkmesh", true));
-    V_RETURN(g_Plane.Create(pd3dDevice, "..\\media\\plane\\", "plane.sdkmesh", true));
+    b1dDesc.Usage = D3D11_USAGE_DYNAMIC;
+    b1dDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+    b1dDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+    b1dDesc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+    b1dDesc.ByteWidth = sizeof(S_INSTANCE_DATA) * g_MeshCount;
+    b1dDesc.StructureByteStride = sizeof(S_INSTANCE_DATA);
+    V_RETURN(pd3dDevice->CreateBuffer(&b1dDesc, NULL, &g_pInstanceSB));
+    DXUT_SetDebugName(g_pInstanceSB, "g_pInstanceSB");
 
-    g_MeshModelMatrix[0] = XMMatrixScaling(0.01f, 0.01f, 0.01f) * XMMatrixTranslation(5, 0, 0);
-    g_MeshModelMatrix[1] = XMMatrixIdentity();
-    g_MeshModelMatrix[2] = XMMatrixScaling(1.0f, 10.0f, 0.001f) * XMMatrixTranslation(0, 10, -2.5);
+    CD3D11_SHADER_RESOURCE_VIEW_DESC instanceDesc(D3D11_SRV_DIMENSION_BUFFER, DXGI_FORMAT_UNKNOWN, 0, g_MeshCount);
+    V_RETURN(pd3dDevice->CreateShaderResourceView(g_pInstanceSB, &instanceDesc, &g_pInstanceSRV));
 
     g_ViewerData.m_Color = float4(1.0f, 1.0f, 1.0f, 1.0f);
 
@@ -726,6 +1344,18 @@ HRESULT CALLBACK OnD3D11ResizedSwapChain(ID3D11Device* pd3dDevice, IDXGISwapChai
                                DXGI_FORMAT_UNKNOWN, DXGI_FORMAT_UNKNOWN,
                                D3D11_USAGE_DEFAULT, false, 0, NULL, g_agsContext, AGS_AFR_TRANSFER_DEFAULT);
 
+    for (unsigned int mask = 0; mask < SHADOW_LIGHT_MASK_COUNT; mask++)
+    {
+        g_ShadowLightMask[mask].Release();
+        g_ShadowLightMask[mask].CreateSurface(DXUTGetD3D11Device(),
+                                              (unsigned int)pBackBufferSurfaceDesc->Width,
+                                              (unsigned int)pBackBufferSurfaceDesc->Height, 1, 1, 1,
+                                              DXGI_FORMAT_R8G8B8A8_UNORM, DXGI_FORMAT_R8G8B8A8_UNORM,
+                                              DXGI_FORMAT_R8G8B8A8_UNORM, DXGI_FORMAT_UNKNOWN,
+                                              DXGI_FORMAT_UNKNOWN, DXGI_FORMAT_UNKNOWN,
+                                              D3D11_USAGE_DEFAULT, false, 0, NULL, g_agsContext, AGS_AFR_TRANSFER_DEFAULT);
+    }
+
     g_AppDepth.Release();
     g_AppDepth.CreateSurface(DXUTGetD3D11Device(),
                              (unsigned int)pBackBufferSurfaceDesc->Width,
@@ -773,84 +1403,138 @@ HRESULT CALLBACK OnD3D11ResizedSwapChain(ID3D11Device* pd3dDevice, IDXGISwapChai
     return S_OK;
 }
 
-void InitializeCubeCamera(CFirstPersonCamera * pViewer, CFirstPersonCamera * pCubeCamera, S_CAMERA_DATA * pCubeCameraData)
+//--------------------------------------------------------------------------------------
+// The model space box around all the subsets of a mesh
+//--------------------------------------------------------------------------------------
+AMD::ShadowCasterBounds GetMeshBounds(AMD::Mesh & mesh)
 {
-    if (pViewer == NULL || pCubeCamera == NULL || pCubeCameraData == NULL)
-    {
-        return;
-    }
-
-    S_CAMERA_DATA camera;
-
-    float4 eye = pViewer->GetEyePt();
-    float4 dir_x(1.0f, 0.0f, 0.0f);
-    float4 dir_y(0.0f, 1.0f, 0.0f);
-    float4 dir_z(0.0f, 0.0f, 1.0f);
-
-    float aspect = 1.0f;
-    float znear = 0.01f;
-    float zfar = 25.0f;
-    float fov = AMD_PI / 2.0f;
+    AMD::ShadowCasterBounds bounds = { { 0.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 0.0f } };
+    bool                    empty = true;
 
-    float4 cube_look_at[6];
-    float4 cube_up[6];
+    for (UINT i = 0; mesh.m_isSdkMesh == true && i < mesh.m_sdkMesh.GetNumMeshes(); i++)
+    {
+        AMD::ShadowCasterBounds subset;
+        XMStoreFloat3((XMFLOAT3 *)subset.m_Center, mesh.m_sdkMesh.GetMeshBBoxCenter(i));
+        XMStoreFloat3((XMFLOAT3 *)subset.m_Extents, mesh.m_sdkMesh.GetMeshBBoxExtents(i));
 
-    cube_look_at[0] = eye + dir_x*(1.0f);
-    cube_up[0] = dir_y*(1.0f);
-    cube_look_at[1] = eye + dir_x*(-1.0f);
-    cube_up[1] = dir_y*(1.0f);
-    cube_look_at[2] = eye + dir_y*(1.0f);
-    cube_up[2] = dir_z*(-1.0f);
-    cube_look_at[3] = eye + dir_y*(-1.0f);
-    cube_up[3] = dir_z*(1.0f);
-    cube_look_at[4] = eye + dir_z*(1.0f);
-    cube_up[4] = dir_y*(1.0f);
-    cube_look_at[5] = eye + dir_z*(-1.0f);
-    cube_up[5] = dir_y*(1.0f);
+        bounds = empty ? subset : AMD::MergeShadowCasterBounds(bounds, subset);
+        empty = false;
+    }
 
-    for (int i = 0; i < 6; i++)
+    for (size_t i = 0; mesh.m_isSdkMesh == false && i < mesh._vertex.size(); i++)
     {
-        pCubeCamera[i].SetProjParams(fov, aspect, znear, zfar);
-
-        pCubeCamera[i].SetViewParams(eye, cube_look_at[i], cube_up[i]);
+        const float *                 position = mesh._vertex[i].position;
+        const AMD::ShadowCasterBounds point = { { position[0], position[1], position[2] }, { 0.0f, 0.0f, 0.0f } };
 
-        pCubeCamera[i].FrameMove(0.000001f);
+        bounds = empty ? point : AMD::MergeShadowCasterBounds(bounds, point);
+        empty = false;
     }
+
+    return bounds;
 }
 
-void InitializeCascadeCamera(CFirstPersonCamera * pViewer, CFirstPersonCamera * pCubeCamera, S_CAMERA_DATA * pCubeCameraData, float4x4 * ortho)
+void InitializeCubeCamera(CFirstPersonCamera * pViewer, CFirstPersonCamera * pCubeCamera, S_CAMERA_DATA * pCubeCameraData)
 {
     if (pViewer == NULL || pCubeCamera == NULL || pCubeCameraData == NULL)
     {
         return;
     }
 
-    S_CAMERA_DATA camera;
-
     float4 eye = pViewer->GetEyePt();
-    float4 direction = pViewer->GetWorldAhead();
-    float4 right = pViewer->GetWorldRight();
-    float4 up = pViewer->GetWorldUp();
-    float4 light(1.0f, 1.0f, 1.0f, 0.0f);
 
     float aspect = 1.0f;
     float znear = 0.01f;
     float zfar = 25.0f;
     float fov = AMD_PI / 2.0f;
 
-    for (int i = 0; i < 6; i++)
+    // no FrameMove: SetViewParams already builds the view, and SetCameraConstantBufferData
+    // takes everything else from it
+    for (unsigned int i = 0; i < AMD::CAMERA_CUBE_FACE_COUNT; i++)
     {
-        pCubeCamera[i].SetProjParams(fov, aspect, znear, zfar);
-        pCubeCamera[i].SetViewParams(eye + light * 2, eye, up);
+        float right[3], up[3], ahead[3];
+        AMD::GetCubeFaceBasis(i, right, up, ahead);
 
-        pCubeCamera[i].FrameMove(0.000001f);
+        pCubeCamera[i].SetProjParams(fov, aspect, znear, zfar);
 
-        ortho[i] = XMMatrixOrthographicOffCenterLH(-5.0f*(i + 0.5f), 5.0f*(i + 0.5f), -5.0f*(i + 0.5f), 5.0f*(i + 0.5f),
-            -5.0f*(i + 1.5f), 5.0f*(i + 1.5f)); // pLightCamera->GetProjMatrix(); // XMMatrixOrthographicOffCenterLH( -10.0, 10.0, -10.0, 10.0, -30.0, 30.0 );
+        pCubeCamera[i].SetViewParams(eye, eye + XMLoadFloat3((const XMFLOAT3 *)ahead), XMLoadFloat3((const XMFLOAT3 *)up));
     }
 }
 
-void SetCameraConstantBufferData(ID3D11DeviceContext* pd3dContext,
+//--------------------------------------------------------------------------------------
+// Fit the cascades of the sun to the view frustum of the viewer, see AMD::ShadowCascades,
+// and set their cameras and orthographic projections. Returns the cascades to render this
+// frame; the others keep the view they were rendered with
+//--------------------------------------------------------------------------------------
+unsigned int InitializeCascadeCamera(CFirstPersonCamera * pViewer, CFirstPersonCamera * pCascadeCamera, float4x4 * ortho, unsigned int frame, unsigned int * pCascades)
+{
+    if (pViewer == NULL || pCascadeCamera == NULL || ortho == NULL || pCascades == NULL)
+    {
+        return 0;
+    }
+
+    AMD::ShadowCascadeViewer viewer;
+    XMStoreFloat3((XMFLOAT3 *)viewer.m_Position, pViewer->GetEyePt());
+    XMStoreFloat3((XMFLOAT3 *)viewer.m_Direction, pViewer->GetWorldAhead());
+    viewer.m_Fov = pViewer->GetFOV();
+    viewer.m_Aspect = pViewer->GetAspect();
+
+    float light[3];
+    XMStoreFloat3((XMFLOAT3 *)light, XMVector3Normalize(g_CascadeLightDirection));
+
+    // the texel grid of a cascade is the one of its region
+    unsigned int resolution[CUBE_FACE_COUNT];
+    for (unsigned int cascade = 0; cascade < CUBE_FACE_COUNT; cascade++)
+    {
+        resolution[cascade] = GetShadowAtlasRect(cascade).m_Width;
+    }
+
+    const unsigned int count = g_ShadowCascades.Update(viewer, light, resolution, frame, pCascades);
+
+    for (unsigned int i = 0; i < count; i++)
+    {
+        const AMD::ShadowCascade & cascade = g_ShadowCascades.GetCascade(pCascades[i]);
+
+        // no FrameMove, it would rebuild the view from yaw and pitch, off the texel grid
+        pCascadeCamera[pCascades[i]].SetViewParams(XMLoadFloat3((const XMFLOAT3 *)cascade.m_Eye),
+                                                   XMLoadFloat3((const XMFLOAT3 *)cascade.m_LookAt),
+                                                   XMLoadFloat3((const XMFLOAT3 *)cascade.m_Up));
+        ortho[pCascades[i]] = XMLoadFloat4x4((const XMFLOAT4X4 *)cascade.m_Projection);
+    }
+
+    return count;
+}
+
+//--------------------------------------------------------------------------------------
+// The projection of a cube face, or of the cascade that takes its place
+//--------------------------------------------------------------------------------------
+XMMATRIX GetShadowFaceProjection(unsigned int face)
+{
+    return g_ShadowsExecution == AMD::SHADOWFX_EXECUTION_CASCADE ? g_LightOrtho[face] : g_CubeCamera[face].GetProjMatrix();
+}
+
+AMD_COMPILE_TIME_ASSERT(offsetof(S_CAMERA_DATA, m_ViewProjectionInv) == offsetof(AMD::CameraBatchMatrices, m_ViewProjectionInv), CameraBatchMatrices_matches_S_CAMERA_DATA)
+
+//--------------------------------------------------------------------------------------
+// The eye, basis and projection of a camera, the way AMD::ComputeCameraMatrices takes them
+//--------------------------------------------------------------------------------------
+void GetCameraBatchInput(CFirstPersonCamera & camera, const XMMATRIX & projection, AMD::CameraBatchInput & input)
+{
+    XMFLOAT4X4 view;
+    XMStoreFloat4x4(&view, camera.GetViewMatrix());
+
+    // the view has the basis in its columns
+    for (int i = 0; i < 3; i++)
+    {
+        input.m_Right[i] = view.m[i][0];
+        input.m_Up[i] = view.m[i][1];
+        input.m_Ahead[i] = view.m[i][2];
+    }
+
+    XMStoreFloat3((XMFLOAT3 *)input.m_Eye, camera.GetEyePt());
+    XMStoreFloat4x4((XMFLOAT4X4 *)input.m_Projection, projection);
+}
+
+void SetCameraConstantBufferData(ID3D11DeviceContext* pd3dContext,
                                  ID3D11Buffer*                                       pd3dCB,
                                  S_CAMERA_DATA*                                      pCameraData,
                                  CFirstPersonCamera*                                 pCamera,
@@ -864,32 +1548,34 @@ void SetCameraConstantBufferData(ID3D11DeviceContext* pd3dContext,
     if (pd3dContext == NULL) { OutputDebugString(AMD_FUNCTION_WIDE_NAME L" received a NULL D3D11 Context pointer \n");         return; }
     if (pd3dCB == NULL) { OutputDebugString(AMD_FUNCTION_WIDE_NAME L" received a NULL D3D11 Constant Buffer pointer \n"); return; }
 
-    for (unsigned int i = nStart; i < nEnd; i++)
+    // the matrices of up to a cube of cameras at a time, with closed form inverses
+    AMD::CameraBatchInput inputs[AMD::CAMERA_CUBE_FACE_COUNT];
+
+    for (unsigned int first = nStart; first < nEnd; first += AMD::CAMERA_CUBE_FACE_COUNT)
     {
-        CFirstPersonCamera & camera = pCamera[i];
-        S_CAMERA_DATA & cameraData = pCameraData[i];
+        const unsigned int count = nEnd - first < AMD::CAMERA_CUBE_FACE_COUNT ? nEnd - first : AMD::CAMERA_CUBE_FACE_COUNT;
 
-        XMMATRIX  view = camera.GetViewMatrix();
-        XMMATRIX  proj = pProjection != NULL ? pProjection[i] : camera.GetProjMatrix();
-        XMMATRIX  viewproj = view * proj;
-        XMMATRIX  view_inv = XMMatrixInverse(&XMMatrixDeterminant(view), view);
-        XMMATRIX  proj_inv = XMMatrixInverse(&XMMatrixDeterminant(proj), proj);
-        XMMATRIX  viewproj_inv = XMMatrixInverse(&XMMatrixDeterminant(viewproj), viewproj);
+        for (unsigned int i = 0; i < count; i++)
+        {
+            CFirstPersonCamera & camera = pCamera[first + i];
+            GetCameraBatchInput(camera, pProjection != NULL ? pProjection[first + i] : camera.GetProjMatrix(), inputs[i]);
+        }
 
-        cameraData.m_View = XMMatrixTranspose(view);
-        cameraData.m_Projection = XMMatrixTranspose(proj);
-        cameraData.m_ViewInv = XMMatrixTranspose(view_inv);
-        cameraData.m_ProjectionInv = XMMatrixTranspose(proj_inv);
-        cameraData.m_ViewProjection = XMMatrixTranspose(viewproj);
-        cameraData.m_ViewProjectionInv = XMMatrixTranspose(viewproj_inv);
+        AMD::ComputeCameraMatrices(inputs, count, &pCameraData[first], sizeof(S_CAMERA_DATA));
 
-        cameraData.m_Position = camera.GetEyePt();
-        cameraData.m_Direction = XMVector3Normalize(camera.GetLookAtPt() - camera.GetEyePt());
-        cameraData.m_Up = camera.GetWorldUp();
-        cameraData.m_Fov = camera.GetFOV();
-        cameraData.m_Aspect = camera.GetAspect();
-        cameraData.m_zNear = camera.GetNearClip();
-        cameraData.m_zFar = camera.GetFarClip();
+        for (unsigned int i = 0; i < count; i++)
+        {
+            CFirstPersonCamera & camera = pCamera[first + i];
+            S_CAMERA_DATA & cameraData = pCameraData[first + i];
+
+            cameraData.m_Position = camera.GetEyePt();
+            cameraData.m_Direction = XMVector3Normalize(camera.GetLookAtPt() - camera.GetEyePt());
+            cameraData.m_Up = XMLoadFloat3((const XMFLOAT3 *)inputs[i].m_Up);
+            cameraData.m_Fov = camera.GetFOV();
+            cameraData.m_Aspect = camera.GetAspect();
+            cameraData.m_zNear = camera.GetNearClip();
+            cameraData.m_zFar = camera.GetFarClip();
+        }
     }
 
     pd3dContext->Map(pd3dCB, 0, D3D11_MAP_WRITE_DISCARD, 0, &MappedResource);
@@ -900,34 +1586,237 @@ void SetCameraConstantBufferData(ID3D11DeviceContext* pd3dContext,
     pd3dContext->Unmap(pd3dCB, 0);
 }
 
-void SetModelMatrices(ID3D11DeviceContext*  pd3dContext,
-                      ID3D11Buffer*                              pd3dCB,
-                      const XMMATRIX&                            world,
-                      const XMMATRIX&                            viewProj)
+void GetModelData(S_MODEL_DATA&                              modelData,
+                  const XMMATRIX&                            world,
+                  const XMMATRIX&                            viewProj)
 {
-    D3D11_MAPPED_SUBRESOURCE MappedResource;
-
-    S_MODEL_DATA modelData;
     modelData.m_World = XMMatrixTranspose(world);
     modelData.m_WorldViewProjection = XMMatrixTranspose(world * viewProj);
     modelData.m_Ambient = float4(0.1f, 0.1f, 0.1f, 1.0f);
     modelData.m_Diffuse = float4(1.0f, 1.0f, 1.0f, 1.0f);
+}
+
+void SetConstantBufferData(ID3D11DeviceContext*  pd3dContext,
+                           ID3D11Buffer*                              pd3dCB,
+                           const void*                                pData,
+                           unsigned int                               size)
+{
+    D3D11_MAPPED_SUBRESOURCE MappedResource;
 
     pd3dContext->Map(pd3dCB, 0, D3D11_MAP_WRITE_DISCARD, 0, &MappedResource);
     if (MappedResource.pData)
     {
-        memcpy(MappedResource.pData, &modelData, sizeof(modelData));
+        memcpy(MappedResource.pData, pData, size);
     }
     pd3dContext->Unmap(pd3dCB, 0);
 }
 
+void SetModelMatrices(ID3D11DeviceContext*  pd3dContext,
+                      ID3D11Buffer*                              pd3dCB,
+                      const XMMATRIX&                            world,
+                      const XMMATRIX&                            viewProj)
+{
+    S_MODEL_DATA modelData;
+    GetModelData(modelData, world, viewProj);
+    SetConstantBufferData(pd3dContext, pd3dCB, &modelData, sizeof(modelData));
+}
+
+// the cache of the immediate context, or of the deferred context a job records into
+AMD::StateCache & GetStateCache(ID3D11DeviceContext * pd3dContext)
+{
+    for (unsigned int job = 0; job < RECORD_JOB_COUNT; job++)
+    {
+        if (g_pRecordContext[job] != NULL && g_pRecordContext[job] == pd3dContext)
+        {
+            return g_RecordStateCache[job];
+        }
+    }
+
+    return g_StateCache;
+}
+
+// the instance batcher of the context, see GetStateCache
+AMD::InstanceBatcher & GetInstanceBatcher(ID3D11DeviceContext * pd3dContext)
+{
+    for (unsigned int job = 0; job < RECORD_JOB_COUNT; job++)
+    {
+        if (g_pRecordContext[job] != NULL && g_pRecordContext[job] == pd3dContext)
+        {
+            return g_RecordInstanceBatcher[job];
+        }
+    }
+
+    return g_InstanceBatcher;
+}
+
+// the g_MeshCount instances GetShadowCasters fills for the context, see GetStateCache
+std::vector<unsigned int> & GetShadowCasterScratch(ID3D11DeviceContext * pd3dContext)
+{
+    for (unsigned int job = 0; job < RECORD_JOB_COUNT; job++)
+    {
+        if (g_pRecordContext[job] != NULL && g_pRecordContext[job] == pd3dContext)
+        {
+            return g_RecordShadowCasters[job];
+        }
+    }
+
+    return g_ShadowCasters;
+}
+
+//--------------------------------------------------------------------------------------
+// Copy count blocks of size bytes into g_ConstantRing with a single Map. The first block
+// starts at constant firstConstant and the next ones constantCount constants apart, the
+// way SetConstantRingBlock binds them. False when the ring is off or the region of this
+// frame is full, or on a deferred context: the allocations of the ring are made by the
+// frame in order and a deferred context can only map with WRITE_DISCARD. The caller then
+// maps its own constant buffer for every draw.
+//--------------------------------------------------------------------------------------
+bool WriteConstantRing(ID3D11DeviceContext*  pd3dContext,
+                       const void*                                pData,
+                       unsigned int                               size,
+                       unsigned int                               count,
+                       unsigned int&                              firstConstant,
+                       unsigned int&                              constantCount)
+{
+    if (g_EnableConstantRing == false || g_pConstantRingCB == NULL || pd3dContext->GetType() == D3D11_DEVICE_CONTEXT_DEFERRED)
+    {
+        return false;
+    }
+
+    bool               discard = false;
+    const unsigned int offset = g_ConstantRing.Allocate(size, count, discard);
+    const unsigned int stride = AMD::ConstantRing::GetStride(size);
+
+    D3D11_MAPPED_SUBRESOURCE MappedResource;
+    if (offset == AMD::CONSTANT_RING_INVALID_OFFSET ||
+        FAILED(pd3dContext->Map(g_pConstantRingCB, 0, discard ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE_NO_OVERWRITE, 0, &MappedResource)))
+    {
+        return false;
+    }
+
+    for (unsigned int i = 0; i < count; i++)
+    {
+        memcpy((unsigned char*)MappedResource.pData + offset + i * stride, (const unsigned char*)pData + i * size, size);
+    }
+    pd3dContext->Unmap(g_pConstantRingCB, 0);
+
+    firstConstant = offset / AMD::CONSTANT_RING_CONSTANT_SIZE;
+    constantCount = stride / AMD::CONSTANT_RING_CONSTANT_SIZE;
+    return true;
+}
+
+// binds a block of g_ConstantRing to the slot of every stage that has a shader
+void SetConstantRingBlock(unsigned int slot, unsigned int firstConstant, unsigned int constantCount, ID3D11DeviceChild* const* pStageShader)
+{
+    for (unsigned int stage = AMD::STATE_CACHE_STAGE_VS; stage <= AMD::STATE_CACHE_STAGE_PS; stage++)
+    {
+        if (pStageShader[stage] != NULL)
+        {
+            g_StateCache.SetConstantBuffers((AMD::STATE_CACHE_STAGE)stage, slot, 1, &g_pConstantRingCB, &firstConstant, &constantCount);
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------
+// Draw the unit cube of every cube light, its clip space as the viewer sees it. Instanced,
+// the transforms of all of them go into g_pLightVolumeSB with one Map and one product
+// per light, and a single draw renders them in order; otherwise every cube maps its own
+// constants and gets its own draw. Colored with the light colors if lightColor is true.
+//--------------------------------------------------------------------------------------
+void RenderLightVolumes(ID3D11DeviceContext*  pd3dContext,
+                        ID3D11RasterizerState*                     pRS,
+                        ID3D11DepthStencilState*                   pDSS,
+                        bool                                       lightColor,
+                        ID3D11RenderTargetView**                   ppRTV,
+                        unsigned int                               nRTVCount)
+{
+    D3D11_RECT*                pNullSR = NULL;
+    ID3D11HullShader*          pNullHS = NULL;
+    ID3D11DomainShader*        pNullDS = NULL;
+    ID3D11GeometryShader*      pNullGS = NULL;
+    ID3D11ShaderResourceView*  pNullSRV = NULL;
+    ID3D11SamplerState*        pNullSS = NULL;
+
+    const CD3D11_VIEWPORT      viewport(0.0f, 0.0f, (float)g_Width, (float)g_Height);
+
+    D3D11_MAPPED_SUBRESOURCE MappedResource;
+    if (g_EnableInstancedLightVolumes == true && g_pLightVolumeVS != NULL && g_pLightVolumePS != NULL && g_pLightVolumeSRV != NULL &&
+        SUCCEEDED(pd3dContext->Map(g_pLightVolumeSB, 0, D3D11_MAP_WRITE_DISCARD, 0, &MappedResource)))
+    {
+        S_LIGHT_VOLUME_DATA * pLightVolume = (S_LIGHT_VOLUME_DATA *)MappedResource.pData;
+
+        // the matrices are stored transposed, so this is the light's inverse, then the viewer
+        AMD::MultiplyCameraMatrices((const float *)&g_ViewerData.m_ViewProjection,
+                                    &g_LightData[0].m_ViewProjectionInv, sizeof(S_CAMERA_DATA), CUBE_FACE_COUNT,
+                                    &pLightVolume[0].m_Transform, sizeof(S_LIGHT_VOLUME_DATA));
+        for (int light = 0; light < CUBE_FACE_COUNT; light++)
+        {
+            pLightVolume[light].m_Color = lightColor == true ? g_LightData[light].m_Color : white;
+        }
+        pd3dContext->Unmap(g_pLightVolumeSB, 0);
+
+        AMD::RenderUnitCube(g_StateCache, pd3dContext,
+                            viewport,
+                            pNullSR, 0,
+                            pRS,
+                            g_pOpaqueBS, white.f,
+                            pDSS, 1,
+                            g_pLightVolumeVS, pNullHS, pNullDS, pNullGS, nRTVCount > 0 ? g_pLightVolumePS : NULL,
+                            &g_pUnitCubeCB, 0, 0,
+                            &pNullSS, 0, 0,
+                            &g_pLightVolumeSRV, LIGHT_VOLUME_SLOT, 1,
+                            ppRTV, nRTVCount, g_AppDepth._dsv,
+                            CUBE_FACE_COUNT);
+        return;
+    }
+
+    S_UNIT_CUBE_TRANSFORM cubeData[CUBE_FACE_COUNT];
+    for (int light = 0; light < CUBE_FACE_COUNT; light++)
+    {
+        cubeData[light].m_Transform = g_ViewerData.m_ViewProjection * g_LightData[light].m_ViewProjectionInv;
+        cubeData[light].m_Inverse = g_LightData[light].m_ViewProjectionInv;
+        cubeData[light].m_Forward = g_ViewerData.m_ViewProjection;
+        cubeData[light].m_Color = lightColor == true ? g_LightData[light].m_Color : white;
+    }
+
+    // the six transforms in one Map of g_ConstantRing, see RenderScene
+    ID3D11PixelShader *       pPS = nRTVCount > 0 ? g_pUnitCubePS : NULL;
+    ID3D11DeviceChild *       pStageShader[] = { g_pUnitCubeVS, pNullHS, pNullDS, pNullGS, pPS };
+    unsigned int              firstConstant = 0;
+    unsigned int              constantCount = 0;
+    const bool                ring = WriteConstantRing(pd3dContext, cubeData, sizeof(S_UNIT_CUBE_TRANSFORM), CUBE_FACE_COUNT, firstConstant, constantCount);
+
+    for (int light = 0; light < CUBE_FACE_COUNT; light++)
+    {
+        if (ring == true)
+        {
+            SetConstantRingBlock(0, firstConstant + light * constantCount, constantCount, pStageShader);
+        }
+        else
+        {
+            SetConstantBufferData(pd3dContext, g_pUnitCubeCB, &cubeData[light], sizeof(S_UNIT_CUBE_TRANSFORM));
+        }
+
+        AMD::RenderUnitCube(g_StateCache, pd3dContext,
+                            viewport,
+                            pNullSR, 0,
+                            pRS,
+                            g_pOpaqueBS, white.f,
+                            pDSS, 1,
+                            g_pUnitCubeVS, pNullHS, pNullDS, pNullGS, pPS,
+                            &g_pUnitCubeCB, 0, ring ? 0 : 1,
+                            &pNullSS, 0, 0,
+                            &pNullSRV, 0, 0,
+                            ppRTV, nRTVCount, g_AppDepth._dsv);
+    }
+}
+
 //--------------------------------------------------------------------------------------
 // Render the scene (either for the main scene or the shadow map scene)
 //--------------------------------------------------------------------------------------
 void RenderScene(ID3D11DeviceContext*  pd3dContext,
-                 AMD::Mesh**                          pMesh,
-                 XMMATRIX*                            pModelMatrix,
-                 unsigned int                         nMeshCount,
+                 const unsigned int*                  pInstances,    // instances of the scene
+                 unsigned int                         nInstanceCount,
 
                  D3D11_VIEWPORT*                      pVP,           // ViewPort array
                  unsigned int                         nVPCount,      // Viewport count
@@ -972,366 +1861,1764 @@ void RenderScene(ID3D11DeviceContext*  pd3dContext,
                  S_CAMERA_DATA*                       pViewerData,
                  CFirstPersonCamera*                  pCamera = NULL)
 {
-    ID3D11RenderTargetView *   const pNullRTV[8] = { 0 };
-    ID3D11ShaderResourceView * const pNullSRV[128] = { 0 };
-
-    // Unbind anything that could be still bound on input or output
-    // If this doesn't happen, DX Runtime will spam with warnings
-    pd3dContext->OMSetRenderTargets(AMD_ARRAY_SIZE(pNullRTV), pNullRTV, NULL);
-    pd3dContext->CSSetShaderResources(0, AMD_ARRAY_SIZE(pNullSRV), pNullSRV);
-    pd3dContext->VSSetShaderResources(0, AMD_ARRAY_SIZE(pNullSRV), pNullSRV);
-    pd3dContext->HSSetShaderResources(0, AMD_ARRAY_SIZE(pNullSRV), pNullSRV);
-    pd3dContext->DSSetShaderResources(0, AMD_ARRAY_SIZE(pNullSRV), pNullSRV);
-    pd3dContext->GSSetShaderResources(0, AMD_ARRAY_SIZE(pNullSRV), pNullSRV);
-    pd3dContext->PSSetShaderResources(0, AMD_ARRAY_SIZE(pNullSRV), pNullSRV);
-
-    pd3dContext->IASetInputLayout(pIL);
-
-    pd3dContext->VSSetShader(pVS, NULL, 0);
-    pd3dContext->HSSetShader(pHS, NULL, 0);
-    pd3dContext->DSSetShader(pDS, NULL, 0);
-    pd3dContext->GSSetShader(pGS, NULL, 0);
-    pd3dContext->PSSetShader(pPS, NULL, 0);
-
-    if (nSSCount)
+    // the cache drops what is already bound, and instead of unbinding every render target
+    // and shader resource first, it only unbinds the ones that conflict with the new bindings
+    AMD::StateCache & stateCache = GetStateCache(pd3dContext);
+
+    // the instances of a mesh are drawn at once by VS_RenderSceneInstanced, see below
+    const bool instanced = g_EnableInstancedMeshes == true && nInstanceCount > 0 && pVS == g_pSceneVS &&
+                           g_pSceneInstancedVS != NULL && g_pInstanceSRV != NULL;
+    if (instanced == true)
     {
-        pd3dContext->VSSetSamplers(nSSStart, nSSCount, ppSS);
-        pd3dContext->HSSetSamplers(nSSStart, nSSCount, ppSS);
-        pd3dContext->DSSetSamplers(nSSStart, nSSCount, ppSS);
-        pd3dContext->GSSetSamplers(nSSStart, nSSCount, ppSS);
-        pd3dContext->PSSetSamplers(nSSStart, nSSCount, ppSS);
+        pVS = g_pSceneInstancedVS;
     }
 
-    if (nSRVCount)
-    {
-        pd3dContext->VSSetShaderResources(nSRVStart, nSRVCount, ppSRV);
-        pd3dContext->HSSetShaderResources(nSRVStart, nSRVCount, ppSRV);
-        pd3dContext->DSSetShaderResources(nSRVStart, nSRVCount, ppSRV);
-        pd3dContext->GSSetShaderResources(nSRVStart, nSRVCount, ppSRV);
-        pd3dContext->PSSetShaderResources(nSRVStart, nSRVCount, ppSRV);
-    }
+    stateCache.SetInputLayout(pIL);
 
-    if (nCBCount)
+    stateCache.SetShader(pVS);
+    stateCache.SetShader(pHS);
+    stateCache.SetShader(pDS);
+    stateCache.SetShader(pGS);
+    stateCache.SetShader(pPS);
+
+    // only the stages that have a shader need the resources
+    ID3D11DeviceChild * pStageShader[] = { pVS, pHS, pDS, pGS, pPS };
+    for (unsigned int stage = AMD::STATE_CACHE_STAGE_VS; stage <= AMD::STATE_CACHE_STAGE_PS; stage++)
     {
-        pd3dContext->VSSetConstantBuffers(nCBStart, nCBCount, ppCB);
-        pd3dContext->HSSetConstantBuffers(nCBStart, nCBCount, ppCB);
-        pd3dContext->DSSetConstantBuffers(nCBStart, nCBCount, ppCB);
-        pd3dContext->GSSetConstantBuffers(nCBStart, nCBCount, ppCB);
-        pd3dContext->PSSetConstantBuffers(nCBStart, nCBCount, ppCB);
+        if (pStageShader[stage] != NULL)
+        {
+            stateCache.SetSamplers((AMD::STATE_CACHE_STAGE)stage, nSSStart, nSSCount, ppSS);
+            stateCache.SetShaderResources((AMD::STATE_CACHE_STAGE)stage, nSRVStart, nSRVCount, ppSRV);
+            stateCache.SetConstantBuffers((AMD::STATE_CACHE_STAGE)stage, nCBStart, nCBCount, ppCB);
+        }
     }
 
-    pd3dContext->OMSetRenderTargets(nRTVCount, ppRTV, pDSV);
-    pd3dContext->OMSetBlendState(pBS, pFactorBS, 0xf);
-    pd3dContext->OMSetDepthStencilState(pDSS, dssRef);
-    pd3dContext->RSSetState(pRS);
-    pd3dContext->RSSetScissorRects(nSRCount, pSR);
-    pd3dContext->RSSetViewports(nVPCount, pVP);
+    stateCache.SetRenderTargets(nRTVCount, ppRTV, pDSV);
+    stateCache.SetBlendState(pBS, pFactorBS, 0xf);
+    stateCache.SetDepthStencilState(pDSS, dssRef);
+    stateCache.SetRasterizerState(pRS);
+    stateCache.SetScissorRects(nSRCount, (const AMD::StateRect *)pSR);
+    stateCache.SetViewports(nVPCount, (const AMD::StateViewport *)pVP);
 
     // Setup the view matrices
     XMMATRIX view = pCamera != NULL ? pCamera->GetViewMatrix() : XMMatrixTranspose(pViewerData->m_View);
     XMMATRIX proj = pCamera != NULL ? pCamera->GetProjMatrix() : XMMatrixTranspose(pViewerData->m_Projection);
     XMMATRIX viewproj = view * proj;
 
-    for (unsigned int mesh = 0; mesh < nMeshCount; mesh++)
+    // Instanced, the instances are grouped by mesh: their world matrices go into g_pInstanceSB
+    // in the order of the groups with one Map, and a group is one DrawIndexedInstanced per
+    // subset of its mesh, its model constants holding the view projection and its first
+    // instance. Otherwise every instance has its own model constants and its own draws.
+    AMD::InstanceBatcher &    batcher = GetInstanceBatcher(pd3dContext);
+    D3D11_MAPPED_SUBRESOURCE  MappedResource;
+    const bool                batched = instanced == true && SUCCEEDED(pd3dContext->Map(g_pInstanceSB, 0, D3D11_MAP_WRITE_DISCARD, 0, &MappedResource));
+    unsigned int              drawCount = nInstanceCount;
+
+    if (batched == true)
     {
-        SetModelMatrices(pd3dContext, pModelCB,
-                         pModelMatrix[mesh], viewproj);
+        drawCount = batcher.Build(pInstances, nInstanceCount, &g_InstanceMesh[0], (unsigned int)g_SceneMeshes.size());
 
-        pMesh[mesh]->Render(pd3dContext);
-    }
-}
+        S_INSTANCE_DATA * pInstanceData = (S_INSTANCE_DATA *)MappedResource.pData;
+        for (unsigned int i = 0; i < nInstanceCount; i++)
+        {
+            pInstanceData[i].m_World = XMMatrixTranspose(g_MeshModelMatrix[batcher.GetInstance(i)]);
+        }
+        pd3dContext->Unmap(g_pInstanceSB, 0);
 
-void UpdateSingleCubeFacePerFrameAndTransfer(ID3D11DeviceContext * pd3dContext, int shadowMapFrameDelay)
-{
-    D3D11_RECT*                pNullSR = NULL;
-    ID3D11HullShader*          pNullHS = NULL;
-    ID3D11DomainShader*        pNullDS = NULL;
-    ID3D11GeometryShader*      pNullGS = NULL;
-    ID3D11ShaderResourceView*  pNullSRV = NULL;
-    ID3D11RenderTargetView*    pNullRTV = NULL;
-    CFirstPersonCamera*        pNullCamera = NULL;
+        stateCache.SetShaderResources(AMD::STATE_CACHE_STAGE_VS, INSTANCE_SLOT, 1, &g_pInstanceSRV);
+    }
+    else if (instanced == true) // without the buffer, one instance at a time
+    {
+        pVS = g_pSceneVS;
+        pStageShader[AMD::STATE_CACHE_STAGE_VS] = pVS;
+        stateCache.SetShader(pVS);
+    }
 
-    ID3D11Buffer             * pCB[] = { g_pModelCB, g_pViewerCB, g_pLightCB };
-    ID3D11SamplerState       * pSS[] = { g_pLinearWrapSS };
+    // the model constants of all the draws go into g_ConstantRing at once, and every draw binds
+    // its block; without the ring pModelCB is mapped for every draw
+    std::vector<S_MODEL_DATA> modelData(drawCount);
+    unsigned int              firstConstant = 0;
+    unsigned int              constantCount = 0;
+    bool                      ring = false;
 
-    if (g_EnableCrossfireApiTransfers == true) // if crossfire api is enabled in the UI
+    for (unsigned int draw = 0; draw < drawCount; draw++)
     {
-        if (g_Enable2StepGpuTransfer == false) // and 2-step-gpu transfer is disabled
+        if (batched == true)
         {
-            // so transfer will happen directly on the original shadow map
-            // let's wait until we get it updated from a previous GPU
-            agsDriverExtensions_NotifyResourceBeginAllAccess(g_agsContext, g_ShadowMap._t2d);
+            GetModelData(modelData[draw], XMMatrixIdentity(), viewproj);
+            modelData[draw].m_Parameter0 = float4((float)batcher.GetBatch(draw).m_FirstInstance, 0.0f, 0.0f, 0.0f);
         }
         else
         {
-            // so transfer will happen through a "Transfer" shadow map
-            // let's wait until we get it updated from a previous GPU and copy it into the original shadow map
-            agsDriverExtensions_NotifyResourceBeginAllAccess(g_agsContext, g_ShadowMapTransfer._t2d);
-            // if the shadow map is large it may be better to copy just a part of it that was recently updated
-            pd3dContext->CopyResource(g_ShadowMap._t2d, g_ShadowMapTransfer._t2d);
+            GetModelData(modelData[draw], g_MeshModelMatrix[pInstances[draw]], viewproj);
         }
     }
+    if (drawCount > 0)
+    {
+        ring = WriteConstantRing(pd3dContext, &modelData[0], sizeof(S_MODEL_DATA), drawCount, firstConstant, constantCount);
+    }
 
-    if (g_ShadowTextureType == AMD::SHADOWFX_TEXTURE_2D) // Render shadow map into a texture atlas subregion
+    for (unsigned int draw = 0; draw < drawCount; draw++)
     {
-        TIMER_Begin(0, L"Shadow Map Rendering");
+        if (ring == true)
         {
-            int light = shadowMapFrameDelay % CUBE_FACE_COUNT;
+            SetConstantRingBlock(nModelCBSlot, firstConstant + draw * constantCount, constantCount, pStageShader);
+        }
+        else
+        {
+            SetConstantBufferData(pd3dContext, pModelCB, &modelData[draw], sizeof(S_MODEL_DATA));
+        }
 
-            unsigned int dstOffsetX = (light % g_ShadowMapAtlasScaleW) * (unsigned int)g_ShadowMapSize;
-            unsigned int dstOffsetY = (light / g_ShadowMapAtlasScaleW) * (unsigned int)g_ShadowMapSize;
+        if (batched == true)
+        {
+            g_SceneMeshes[batcher.GetBatch(draw).m_Mesh]->Render(pd3dContext, batcher.GetBatch(draw).m_InstanceCount);
+        }
+        else
+        {
+            g_MeshArray[pInstances[draw]]->Render(pd3dContext);
+        }
+    }
 
-            CD3D11_BOX srcBox(dstOffsetX, dstOffsetY, 0, (LONG)(dstOffsetX + g_ShadowMapSize), (LONG)(dstOffsetY + g_ShadowMapSize), 1);
-            // when update happens on a single cube face, which is located inside a texture2d atlas
-            // an application (or in this case, this sample) needs to clear just that subregion to CLEAR_DEPTH
-            // this can be done via a custom compute or pixel shader that would populate the shadow atlas subregion with a CLEAR_DEPTH value
-            // this samples renders a quad over the area at CLEAR_DEPTH depth, with depth stencil state set to always pass depth test
-            AMD::RenderFullscreenInstancedPass(pd3dContext, CD3D11_VIEWPORT((float)dstOffsetX, (float)dstOffsetY, g_ShadowMapSize, g_ShadowMapSize),
-                                               g_pScreenQuadVS, NULL, NULL,
-                                               NULL, 0, NULL, 0,  NULL, 0, NULL, 0,  NULL, 0, NULL, 0, 0,
-                                               g_ShadowMap._dsv, g_pDepthClearDSS, 0,
-                                               NULL, g_pNoCullingSolidRS, 2);
+    if (nInstanceCount > 0)
+    {
+        stateCache.InvalidateShaderResources(AMD::STATE_CACHE_STAGE_PS, 0, 1); // AMD::Mesh::Render binds the diffuse textures itself
+    }
+}
 
-            RenderScene(pd3dContext,
-                        g_MeshArray, g_MeshModelMatrix, AMD_ARRAY_SIZE(g_MeshArray),
-                        &CD3D11_VIEWPORT((float)dstOffsetX, (float)dstOffsetY, g_ShadowMapSize, g_ShadowMapSize), 1,
-                        pNullSR, 0,
-                        g_pFrontCullingSolidRS, g_pOpaqueBS, white.f,
-                        g_pDepthTestLessDSS, 0, g_pSceneIL,
-                        g_pSceneVS, pNullHS, pNullDS, pNullGS, g_pDepthPassScenePS,
-                        g_pModelCB, 0, pCB, 0, AMD_ARRAY_SIZE(pCB),
-                        pSS, 0, AMD_ARRAY_SIZE(pSS), &pNullSRV, 1, 0,
-                        &pNullRTV, 0, g_ShadowMap._dsv,
-                        &g_LightData[light], pNullCamera);
+//--------------------------------------------------------------------------------------
+// Crossfire API notifications and copies into transferred resources go through these,
+// so that they can be recorded into g_TransferTrace and checked by g_TransferValidator
+//--------------------------------------------------------------------------------------
+unsigned long long GetTransferTraceTimestamp()
+{
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    return (unsigned long long)counter.QuadPart;
+}
 
-            if (g_EnableCrossfireApiTransfers == true) // Crossfire API is enabled in UI (otherwise the driver uses the settings in the application profile)
-            {
-                D3D11_RECT transferRect[] = // this is the subregion that has been updated, we only want to transfer it
-                {
-                    {(LONG)dstOffsetX, (LONG)dstOffsetY, (LONG)(dstOffsetX+g_ShadowMapSize), (LONG)(dstOffsetY+g_ShadowMapSize)}
-                };
+AMD_COMPILE_TIME_ASSERT(sizeof(AMD::TransferTraceRect) == sizeof(D3D11_RECT), TransferTraceRect_matches_D3D11_RECT)
 
-                if (g_Enable2StepGpuTransfer == true) // if 2-step-gpu-transfer is used
-                {
-                    // update the "Transfer" shadow map from current frame
-                    // if the texture atlas is large, but the updated area is small
-                    // it can be better to do a series of CopySubresourceRegion() calls
-                    // pd3dContext->CopySubresourceRegion(g_ShadowMapTransfer._t2d, 0, dstOffsetX, dstOffsetY, 0, g_ShadowMap._t2d, 0, &srcBox);
-                    // otherwise (if a large part of the resource was updated) a full copy may be better
-                    // according to d3d11 CopySubresourceRegion cannot be used to transfer a region of a depth buffer resources (or subresource)
-                    // CopySubresourceRegion can however be used to transfer a depth buffer subresource
-                    // for the atlas shadow map the naive solution is to use CopyResource to transfer all the atlas
-                    // pd3dContext->CopyResource(g_ShadowMapTransfer._t2d, g_ShadowMap._t2d);
-                    // a faster solution is ti use a blit shader to copy the updated region
-                    {
-                        AMD::C_SaveRestore_RS srs(pd3dContext);
-                        AMD::C_SaveRestore_OM som(pd3dContext);
-                        AMD::RenderFullscreenPass(pd3dContext, CD3D11_VIEWPORT(0.f, 0.f, g_ShadowMapSize * g_ShadowMapAtlasScaleW, g_ShadowMapSize * g_ShadowMapAtlasScaleH),
-                            g_pFullscreenVS, g_pFullscreenPS,
-                            transferRect, AMD_ARRAY_SIZE(transferRect), NULL, 0, NULL, 0,
-                            &g_ShadowMap._srv, 1,
-                            &g_ShadowMapTransfer._rtv, 1, NULL, 0, 0,
-                            NULL, g_pDepthClearDSS, 0, NULL, NULL);
-                    }
+void NotifyResourceEndWrites(ID3D11Resource * pResource, const D3D11_RECT * pTransferRegions, const unsigned int * pSubresourceArray, unsigned int numSubresources)
+{
+    if (g_TransferTrace.IsEnabled() == true)
+    {
+        g_TransferTrace.RecordEndWrites(pResource, (const AMD::TransferTraceRect*)pTransferRegions, pSubresourceArray, numSubresources, GetTransferTraceTimestamp());
+    }
+    g_FrameEndWritesCount++;
 
-                    if (g_ShadowMapTransferCfxFlag != AGS_AFR_TRANSFER_DISABLE && // if the "Transfer" shadow map actually requires a transfer
-                        g_ShadowMapTransferCfxFlag != AGS_AFR_TRANSFER_DEFAULT)   // i.e. it's flag isn't set to a Default or Disable value
-                    {
-                        agsDriverExtensions_NotifyResourceEndWrites(g_agsContext, g_ShadowMapTransfer._t2d, transferRect, NULL, AMD_ARRAY_SIZE(transferRect)); // intiate transfer of a subregion
-                    }
-                }
-                else
-                {
-                    if (g_ShadowMapCfxFlag != AGS_AFR_TRANSFER_DISABLE && // if the shadow map actually requires a transfer
-                        g_ShadowMapCfxFlag != AGS_AFR_TRANSFER_DEFAULT)   // i.e. it's flag isn't set to a Default or Disable value
-                    {
-                        // we can only tell the driver that shadow map is done updating this subresource
-                        agsDriverExtensions_NotifyResourceEndWrites(g_agsContext, g_ShadowMap._t2d, NULL, 0, 0); // we are not DONE with using the shadow map yet, so we can't call EndAllAccess!
-                    }
-                }
-            }
+    TRANSFER_VALIDATE_END_WRITES(g_TransferValidator, pResource)
+
+    agsDriverExtensions_NotifyResourceEndWrites(g_agsContext, pResource, pTransferRegions, pSubresourceArray, numSubresources);
+}
+
+void NotifyResourceBeginAllAccess(ID3D11Resource * pResource)
+{
+    if (g_TransferTrace.IsEnabled() == true)
+    {
+        g_TransferTrace.RecordBeginAllAccess(pResource, GetTransferTraceTimestamp());
+    }
+    g_FrameBeginAllAccessCount++;
+
+    TRANSFER_VALIDATE_BEGIN_ALL_ACCESS(g_TransferValidator, pResource)
+
+    agsDriverExtensions_NotifyResourceBeginAllAccess(g_agsContext, pResource);
+}
+
+void NotifyResourceEndAllAccess(ID3D11Resource * pResource)
+{
+    if (g_TransferTrace.IsEnabled() == true)
+    {
+        g_TransferTrace.RecordEndAllAccess(pResource, GetTransferTraceTimestamp());
+    }
+    g_FrameEndAllAccessCount++;
+
+    TRANSFER_VALIDATE_END_ALL_ACCESS(g_TransferValidator, pResource)
+
+    agsDriverExtensions_NotifyResourceEndAllAccess(g_agsContext, pResource);
+}
+
+void TraceTransferCopy(ID3D11Resource * pDst, ID3D11Resource * pSrc, const D3D11_RECT * pRegions, const unsigned int * pSubresourceArray, unsigned int numSubresources)
+{
+    if (g_TransferTrace.IsEnabled() == true)
+    {
+        g_TransferTrace.RecordCopy(pDst, pSrc, (const AMD::TransferTraceRect*)pRegions, pSubresourceArray, numSubresources, GetTransferTraceTimestamp());
+    }
+    g_FrameTransferCopyCount++;
+
+    TRANSFER_VALIDATE_READ(g_TransferValidator, pSrc)
+    TRANSFER_VALIDATE_WRITE(g_TransferValidator, pDst)
+}
+
+#if ENABLE_TRANSFER_VALIDATION
+//--------------------------------------------------------------------------------------
+// Print the first few occurrences of every validation error to the debugger output
+//--------------------------------------------------------------------------------------
+void ReportTransferValidationError(const AMD::TransferValidationError & error, void * pUserData)
+{
+    static unsigned int reported[AMD::TRANSFER_VALIDATION_ERROR_COUNT] = { 0 };
+
+    if (reported[error.m_Error]++ < 16)
+    {
+        char message[256];
+        sprintf_s(message, "Crossfire API validation: frame %u, %s (%p): %s\n",
+            error.m_Frame, error.m_Name, error.m_pResource, AMD::TransferValidator::GetErrorString(error.m_Error));
+        OutputDebugStringA(message);
+    }
+}
+#endif
+
+//--------------------------------------------------------------------------------------
+// Notify the driver about the regions of the texture that the other GPUs don't have yet.
+// Regions written this frame are accumulated per GPU, so with more than 2 GPUs and a
+// non broadcast transfer the next GPU also gets what it missed while other GPUs rendered.
+//--------------------------------------------------------------------------------------
+AMD_COMPILE_TIME_ASSERT(sizeof(AMD::DirtyRect) == sizeof(D3D11_RECT), DirtyRect_matches_D3D11_RECT)
+
+void NotifyDirtyRegionsEndWrites(AMD::Texture2D & texture, AGSAfrTransferType transferType, int frameIndex)
+{
+    const unsigned int gpuCount = (unsigned int)AMD::MAX(g_agsGpuCount, 1);
+    const unsigned int gpu = (unsigned int)frameIndex % gpuCount;
+    const unsigned int nextGpu = (gpu + 1) % gpuCount;
+
+    texture._dirty.EndFrame(gpu, gpuCount);
+
+    AMD::DirtyRegionList regions;
+    if (transferType == AGS_AFR_TRANSFER_2STEP_WITH_BROADCAST)
+    {
+        texture._dirty.GetBroadcastRegions(gpu, regions);
+    }
+    else
+    {
+        texture._dirty.GetPendingRegions(nextGpu, regions);
+    }
+
+    if (regions.IsEmpty() == true)
+    {
+        return;
+    }
+
+    NotifyResourceEndWrites(texture._t2d, (const D3D11_RECT*)regions.GetRects(), regions.GetSubresources(), regions.GetCount());
+
+    for (unsigned int i = 0; i < gpuCount; i++)
+    {
+        if (i == nextGpu || (i != gpu && transferType == AGS_AFR_TRANSFER_2STEP_WITH_BROADCAST))
+        {
+            texture._dirty.MarkReceived(i);
+
+            if (&texture == &g_ShadowMapStatic)
+            {
+                g_StaticShadowFaceCache.MarkReceived(i, gpu);
+            }
+            else if (g_EnableAffineFaceUpdates == false) // affine face updates send only some of the faces, see AddAffineShadowMapTransfers
+            {
+                g_ShadowFaceCache.MarkReceived(i, gpu); // only shadow maps are transferred
+            }
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------
+// Feed the face scheduler with what changed since the last frame and get the cube faces
+// to render this frame: faces the viewer can see, faces whose light or casters moved,
+// and faces that haven't been refreshed for a long time come first
+//--------------------------------------------------------------------------------------
+unsigned int ScheduleCubeFaceUpdates(unsigned int * pFaces)
+{
+    static XMVECTOR              lastLightPosition = XMVectorZero();
+    static std::vector<XMMATRIX> lastModelMatrix;
+    static bool                  hasLastFrame = false;
+    static unsigned int          lastFaceCount = 0;
+
+    const XMVECTOR lightPosition = g_CubeCamera[0].GetEyePt();
+
+    float motion = 0.0f;
+    if (hasLastFrame == true)
+    {
+        motion += XMVectorGetX(XMVector3Length(lightPosition - lastLightPosition));
+        for (unsigned int mesh = 0; mesh < g_MeshCount; mesh++)
+        {
+            motion += XMVectorGetX(XMVector3Length(g_MeshModelMatrix[mesh].r[3] - lastModelMatrix[mesh].r[3]));
+        }
+    }
+
+    lastLightPosition = lightPosition;
+    lastModelMatrix = g_MeshModelMatrix;
+    hasLastFrame = true;
+
+    XMFLOAT4X4 viewerViewProjection;
+    XMStoreFloat4x4(&viewerViewProjection, g_ViewerCamera.GetViewMatrix() * g_ViewerCamera.GetProjMatrix());
+
+    // the render cost is measured over all the faces rendered in a frame, the transfer cost is what the other GPUs receive
+    const float costMs = lastFaceCount > 0 ? g_ShadowRenderingTime / (float)lastFaceCount : 0.0f;
+    const bool  transfers = g_EnableCrossfireApiTransfers == true && g_ResourceCfxTransferFlag != AGS_AFR_TRANSFER_DISABLE;
+    const float costBytes = transfers ? g_ShadowMapSize * g_ShadowMapSize * 4.0f : 0.0f;
+
+    for (int face = 0; face < CUBE_FACE_COUNT; face++)
+    {
+        const XMMATRIX faceViewProjection = g_CubeCamera[face].GetViewMatrix() * GetShadowFaceProjection(face);
+
+        XMFLOAT4X4 faceViewProjectionInv;
+        XMStoreFloat4x4(&faceViewProjectionInv, XMMatrixInverse(&XMMatrixDeterminant(faceViewProjection), faceViewProjection));
+
+        const float visibility = AMD::GetFrustumOverlap(&faceViewProjectionInv._11, &viewerViewProjection._11);
+
+        g_ShadowFaceScheduler.SetFaceInputs(face, visibility, motion, costMs, costBytes);
+    }
+
+    lastFaceCount = g_ShadowFaceScheduler.Schedule(pFaces, CUBE_FACE_COUNT);
+
+    return lastFaceCount;
+}
+
+//--------------------------------------------------------------------------------------
+// The texels of the shadow atlas a cube face is rendered to: its region of the dynamic
+// atlas, or its cell of the fixed grid of g_ShadowMapSize squares
+//--------------------------------------------------------------------------------------
+AMD::ShadowAtlasRect GetShadowAtlasRect(unsigned int face)
+{
+    if (g_EnableDynamicShadowAtlas == true && g_ShadowAtlas.IsValid(g_ShadowAtlasRegion[face]))
+    {
+        return g_ShadowAtlas.GetRect(g_ShadowAtlasRegion[face]);
+    }
+
+    const AMD::ShadowAtlasRect rect =
+    {
+        (face % (unsigned int)g_ShadowMapAtlasScaleW) * (unsigned int)g_ShadowMapSize,
+        (face / (unsigned int)g_ShadowMapAtlasScaleW) * (unsigned int)g_ShadowMapSize,
+        (unsigned int)g_ShadowMapSize,
+        (unsigned int)g_ShadowMapSize
+    };
+    return rect;
+}
+
+//--------------------------------------------------------------------------------------
+// Size the regions of the dynamic atlas from the pixels every face covers on screen,
+// see AMD::ShadowFaceLod. Faces whose region is new or was moved by a defragmentation
+// are added to pFaces until every AFR GPU had a frame to render them at their new place
+//--------------------------------------------------------------------------------------
+unsigned int UpdateShadowAtlasRegions(unsigned int * pFaces, unsigned int faceCount)
+{
+    static unsigned int       pendingFrames[CUBE_FACE_COUNT] = {};
+    static unsigned int       lastRegion[CUBE_FACE_COUNT] = {};
+    static unsigned int       lastGeneration[CUBE_FACE_COUNT] = {};
+
+    const bool dynamic = g_EnableDynamicShadowAtlas == true && g_ShadowTextureType == AMD::SHADOWFX_TEXTURE_2D;
+
+    if (dynamic == false && g_ShadowAtlas.GetRegionCount() > 0) // back to the fixed grid
+    {
+        g_ShadowAtlas.Init(g_ShadowAtlas.GetWidth(), g_ShadowAtlas.GetHeight());
+        for (unsigned int face = 0; face < CUBE_FACE_COUNT; face++)
+        {
+            g_ShadowAtlasRegion[face] = AMD::SHADOW_ATLAS_INVALID_REGION;
+        }
+    }
+
+    // not normalized, the plane distances give the viewer clip space coordinates
+    const XMMATRIX viewerViewProjection = g_ViewerCamera.GetViewMatrix() * g_ViewerCamera.GetProjMatrix();
+    XMFLOAT4       viewerPlanes[6];
+    AMD::ExtractPlanesFromFrustum(viewerPlanes, &viewerViewProjection, false);
+
+    const unsigned int fullSize = (unsigned int)g_ShadowMapSize;
+
+    for (unsigned int face = 0; dynamic == true && face < CUBE_FACE_COUNT; face++)
+    {
+        const XMMATRIX faceViewProjection = g_CubeCamera[face].GetViewMatrix() * GetShadowFaceProjection(face);
+
+        XMFLOAT4X4 faceViewProjectionInv;
+        XMStoreFloat4x4(&faceViewProjectionInv, XMMatrixInverse(&XMMatrixDeterminant(faceViewProjection), faceViewProjection));
+
+        const float        coverage = AMD::GetShadowFaceCoverage(&faceViewProjectionInv._11, &viewerPlanes[0].x);
+        const unsigned int size = g_ShadowFaceLod.Update(face, coverage * (float)g_Width * (float)g_Height);
+
+        if (g_ShadowAtlas.IsValid(g_ShadowAtlasRegion[face]) && g_ShadowAtlas.GetRect(g_ShadowAtlasRegion[face]).m_Width == size)
+        {
+            continue;
+        }
+
+        g_ShadowAtlas.Free(g_ShadowAtlasRegion[face]);
+
+        // a defragmentation moves other faces too, their new generation gets them rendered below
+        unsigned int region = g_ShadowAtlas.Allocate(size, size);
+        if (region == AMD::SHADOW_ATLAS_INVALID_REGION && g_ShadowAtlas.Defragment() > 0)
+        {
+            region = g_ShadowAtlas.Allocate(size, size);
+        }
+        for (unsigned int smaller = size / 2; region == AMD::SHADOW_ATLAS_INVALID_REGION && smaller >= fullSize / 8; smaller /= 2)
+        {
+            region = g_ShadowAtlas.Allocate(smaller, smaller);
+        }
+        g_ShadowAtlasRegion[face] = region;
+    }
+
+    for (unsigned int face = 0; face < CUBE_FACE_COUNT; face++)
+    {
+        const unsigned int region = g_ShadowAtlasRegion[face];
+        const unsigned int generation = g_ShadowAtlas.GetGeneration(region);
+
+        if (region != lastRegion[face] || generation != lastGeneration[face])
+        {
+            lastRegion[face] = region;
+            lastGeneration[face] = generation;
+            pendingFrames[face] = (unsigned int)AMD::MAX(g_agsGpuCount, 1);
+        }
+
+        const AMD::ShadowAtlasRect rect = GetShadowAtlasRect(face);
+        g_LightData[face].m_BackBufferDim = float2((float)rect.m_Width, (float)rect.m_Height);
+        g_LightData[face].m_BackBufferDimRcp = float2(1.0f / (float)rect.m_Width, 1.0f / (float)rect.m_Height);
+
+        if (pendingFrames[face] == 0)
+        {
+            continue;
+        }
+        pendingFrames[face]--;
+
+        unsigned int i = 0;
+        while (i < faceCount && pFaces[i] != face)
+        {
+            i++;
+        }
+        if (i == faceCount)
+        {
+            pFaces[faceCount++] = face;
+        }
+    }
+
+    return faceCount;
+}
+
+//--------------------------------------------------------------------------------------
+// The world space bounds of every mesh
+//--------------------------------------------------------------------------------------
+void GetShadowCasterWorldBounds(AMD::ShadowCasterBounds * pBounds)
+{
+    for (unsigned int mesh = 0; mesh < g_MeshCount; mesh++)
+    {
+        XMFLOAT4X4 modelMatrix;
+        XMStoreFloat4x4(&modelMatrix, g_MeshModelMatrix[mesh]);
+        pBounds[mesh] = AMD::TransformShadowCasterBounds(g_MeshBounds[mesh], &modelMatrix._11);
+    }
+}
+
+//--------------------------------------------------------------------------------------
+// Find the cube faces every mesh casts a shadow into from the world space bounds of the
+// meshes and the planes of the faces. With culling disabled every mesh touches every face
+//--------------------------------------------------------------------------------------
+void CullShadowCasters()
+{
+    if (g_EnableCasterCulling == false)
+    {
+        g_MeshFaceMask.assign(g_MeshCount, (1u << CUBE_FACE_COUNT) - 1);
+        return;
+    }
+
+    XMFLOAT4 planes[CUBE_FACE_COUNT][6];
+    for (unsigned int face = 0; face < CUBE_FACE_COUNT; face++)
+    {
+        const XMMATRIX faceViewProjection = g_CubeCamera[face].GetViewMatrix() * GetShadowFaceProjection(face);
+        AMD::ExtractPlanesFromFrustum(planes[face], &faceViewProjection, false);
+    }
+    g_ShadowCasterCuller.SetFaces(&planes[0][0].x, CUBE_FACE_COUNT);
+
+    std::vector<AMD::ShadowCasterBounds> bounds(g_MeshCount);
+    GetShadowCasterWorldBounds(&bounds[0]);
+
+    g_ShadowCasterCuller.Cull(&bounds[0], g_MeshCount, &g_MeshFaceMask[0]);
+}
+
+//--------------------------------------------------------------------------------------
+// The meshes of the given set that cast a shadow into the given cube face, pInstances
+// having room for all of them
+//--------------------------------------------------------------------------------------
+unsigned int GetShadowCasters(unsigned int face, unsigned int * pInstances, SHADOW_CASTER_SET set = SHADOW_CASTER_SET_ALL)
+{
+    unsigned int count = 0;
+    for (unsigned int mesh = 0; mesh < g_MeshCount; mesh++)
+    {
+        const bool inSet = set == SHADOW_CASTER_SET_ALL ||
+                           (set == SHADOW_CASTER_SET_STATIC) == g_MeshIsStatic[mesh];
+
+        if (inSet == true && (g_MeshFaceMask[mesh] & (1u << face)) != 0)
+        {
+            pInstances[count++] = mesh;
+        }
+    }
+    return count;
+}
+
+// the fingerprint of the casters GetShadowCasters returns: their count, meshes and model matrices
+unsigned long long HashShadowCasters(const unsigned int * pInstances, unsigned int count)
+{
+    unsigned long long fingerprint = AMD::HashShadowFaceState(&count, sizeof(count));
+    for (unsigned int i = 0; i < count; i++)
+    {
+        fingerprint = AMD::HashShadowFaceState(&g_MeshArray[pInstances[i]], sizeof(AMD::Mesh *), fingerprint);
+        fingerprint = AMD::HashShadowFaceState(&g_MeshModelMatrix[pInstances[i]], sizeof(XMMATRIX), fingerprint);
+    }
+    return fingerprint;
+}
+
+//--------------------------------------------------------------------------------------
+// Fingerprint what every cube face depends on, and drop from pFaces the faces that are
+// unchanged and already held by every AFR GPU: they need neither a render nor a transfer
+//--------------------------------------------------------------------------------------
+unsigned int SkipUnchangedCubeFaces(unsigned int * pFaces, unsigned int faceCount)
+{
+    const unsigned int gpuCount = (unsigned int)AMD::MAX(g_agsGpuCount, 1);
+
+    std::vector<unsigned int> & instances = g_ShadowCasters;
+
+    for (unsigned int face = 0; face < CUBE_FACE_COUNT; face++)
+    {
+        const XMMATRIX view = g_CubeCamera[face].GetViewMatrix();
+        const XMMATRIX projection = GetShadowFaceProjection(face);
+
+        // only the casters of the face, a mesh moving elsewhere doesn't make it stale
+        unsigned int       meshCount = GetShadowCasters(face, &instances[0]);
+        unsigned long long fingerprint = HashShadowCasters(&instances[0], meshCount);
+
+        // a face without casters is cleared whatever the light does, once every GPU holds
+        // the cleared face it is neither cleared, rendered nor transferred again
+        if (meshCount > 0)
+        {
+            fingerprint = AMD::HashShadowFaceState(&view, sizeof(view), fingerprint);
+            fingerprint = AMD::HashShadowFaceState(&projection, sizeof(projection), fingerprint);
+        }
+
+        // a face that got another region of the dynamic atlas has to be rendered again
+        const AMD::ShadowAtlasRect rect = GetShadowAtlasRect(face);
+        fingerprint = AMD::HashShadowFaceState(&rect, sizeof(rect), fingerprint);
+
+        g_ShadowFaceCache.SetFingerprint(face, fingerprint);
+
+        // the static layer of the face only depends on the static casters, the light and the region
+        meshCount = GetShadowCasters(face, &instances[0], SHADOW_CASTER_SET_STATIC);
+
+        unsigned long long staticFingerprint = HashShadowCasters(&instances[0], meshCount);
+        if (meshCount > 0)
+        {
+            staticFingerprint = AMD::HashShadowFaceState(&view, sizeof(view), staticFingerprint);
+            staticFingerprint = AMD::HashShadowFaceState(&projection, sizeof(projection), staticFingerprint);
+        }
+        staticFingerprint = AMD::HashShadowFaceState(&rect, sizeof(rect), staticFingerprint);
+
+        g_StaticShadowFaceCache.SetFingerprint(face, staticFingerprint);
+    }
+
+    if (g_SkipUnchangedFaces == false)
+    {
+        return faceCount;
+    }
+
+    unsigned int count = 0;
+    for (unsigned int i = 0; i < faceCount; i++)
+    {
+        if (g_ShadowFaceCache.IsValidOnAllGpus(pFaces[i], gpuCount) == false)
+        {
+            pFaces[count++] = pFaces[i];
+        }
+    }
+
+    return count;
+}
+
+//--------------------------------------------------------------------------------------
+// Place the spot lights of the scene, then the others on a ring above the scene, looking
+// at its center. They start without a region of g_LightShadowAtlas, UpdateShadowLights
+// gives them one
+//--------------------------------------------------------------------------------------
+void InitShadowLights()
+{
+    g_LightShadowAtlas.Init((unsigned int)g_ShadowMapSize * 2, (unsigned int)g_ShadowMapSize * 2);
+    g_ShadowLightList.Init(SHADOW_LIGHT_MASK_COUNT, 0);
+
+    const float4 center(2.5f, 0.0f, 0.0f, 1.0f);
+
+    for (int i = 0; i < g_ShadowLightCount; i++)
+    {
+        const float angle = 2.0f * AMD_PI * (float)i / (float)g_ShadowLightCount;
+
+        AMD::ShadowLight light;
+        light.m_Type = AMD::SHADOW_LIGHT_TYPE_SPOT;
+        light.m_Priority = 0.0f;
+        light.m_Position[0] = center.x + 7.0f * cosf(angle);
+        light.m_Position[1] = center.y + 6.0f;
+        light.m_Position[2] = center.z + 7.0f * sinf(angle);
+        light.m_Direction[0] = center.x - light.m_Position[0];
+        light.m_Direction[1] = center.y - light.m_Position[1];
+        light.m_Direction[2] = center.z - light.m_Position[2];
+        light.m_ConeAngle = AMD_PI * 0.3f;
+        light.m_NearPlane = 0.01f;
+        light.m_FarPlane = 25.0f;
+        light.m_Size = (unsigned int)g_ShadowMapSize / 2;
+
+        if ((unsigned int)i < g_Scene.GetLightCount())
+        {
+            const AMD::SceneLight & sceneLight = g_Scene.GetLight((unsigned int)i);
+            for (int c = 0; c < 3; c++)
+            {
+                light.m_Position[c] = sceneLight.m_Position[c];
+                light.m_Direction[c] = sceneLight.m_At[c] - sceneLight.m_Position[c];
+            }
+            light.m_ConeAngle = sceneLight.m_ConeAngle;
+            light.m_FarPlane = sceneLight.m_Range;
+        }
+
+        g_ShadowLight[i] = g_ShadowLightList.AddLight(light);
+    }
+}
+
+//--------------------------------------------------------------------------------------
+// One cascade of the sun per cube face, so the cascades use the face regions, caches and
+// transfers of the cube light. The first cascade is fit every frame and the intervals
+// grow geometrically up to g_FarCascadeInterval frames for the last one
+//--------------------------------------------------------------------------------------
+void InitShadowCascades()
+{
+    g_ShadowCascades.Init(CUBE_FACE_COUNT, (unsigned int)AMD::MAX(g_agsGpuCount, 1));
+    g_ShadowCascades.SetRange(1.0f, 50.0f, 0.75f, 25.0f); // from the near plane of the viewer, casters as far as the range of the cube light
+
+    for (unsigned int cascade = 0; cascade < CUBE_FACE_COUNT; cascade++)
+    {
+        const float interval = powf((float)g_FarCascadeInterval, (float)cascade / (float)(CUBE_FACE_COUNT - 1));
+        g_ShadowCascades.SetUpdateInterval(cascade, (unsigned int)(interval + 0.5f));
+    }
+}
+
+//--------------------------------------------------------------------------------------
+// The spot lights closest to the viewer come first: they get the regions of the atlas
+// and the channels of the masks, the others are shaded without a shadow
+//--------------------------------------------------------------------------------------
+void UpdateShadowLights()
+{
+    const float4 eye = g_ViewerCamera.GetEyePt();
+
+    for (int i = 0; i < g_ShadowLightCount; i++)
+    {
+        AMD::ShadowLight light = g_ShadowLightList.GetLight(g_ShadowLight[i]);
+        const float4     position(light.m_Position[0], light.m_Position[1], light.m_Position[2], 1.0f);
+
+        light.m_Priority = -XMVectorGetX(XMVector3Length(position - eye));
+        light.m_Size = (unsigned int)g_ShadowMapSize / 2;
+        g_ShadowLightList.SetLight(g_ShadowLight[i], light);
+    }
+
+    g_ShadowLightList.Update(&g_LightShadowAtlas, (unsigned int)g_ShadowMapSize / 8);
+}
+
+//--------------------------------------------------------------------------------------
+// Upload the spot lights into the structured buffer of the scene shader, created again
+// to the size of the light list whenever that changes
+//--------------------------------------------------------------------------------------
+void UpdateShadowLightBuffer(ID3D11Device * pDevice, ID3D11DeviceContext * pd3dContext)
+{
+    const unsigned int count = (unsigned int)g_ShadowLightCount;
+
+    if (count != g_ShadowLightBufferCount)
+    {
+        SAFE_RELEASE(g_pShadowLightSRV);
+        SAFE_RELEASE(g_pShadowLightSB);
+        g_ShadowLightBufferCount = 0;
+
+        if (count > 0)
+        {
+            D3D11_BUFFER_DESC b1dDesc;
+            b1dDesc.Usage = D3D11_USAGE_DYNAMIC;
+            b1dDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+            b1dDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+            b1dDesc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+            b1dDesc.ByteWidth = sizeof(S_SHADOW_LIGHT_DATA) * count;
+            b1dDesc.StructureByteStride = sizeof(S_SHADOW_LIGHT_DATA);
+            pDevice->CreateBuffer(&b1dDesc, NULL, &g_pShadowLightSB);
+            DXUT_SetDebugName(g_pShadowLightSB, "g_pShadowLightSB");
+
+            CD3D11_SHADER_RESOURCE_VIEW_DESC srvDesc(D3D11_SRV_DIMENSION_BUFFER, DXGI_FORMAT_UNKNOWN, 0, count);
+            pDevice->CreateShaderResourceView(g_pShadowLightSB, &srvDesc, &g_pShadowLightSRV);
+
+            g_ShadowLightBufferCount = count;
+        }
+    }
+
+    if (g_pShadowLightSB == NULL)
+    {
+        return;
+    }
+
+    D3D11_MAPPED_SUBRESOURCE MappedResource;
+    pd3dContext->Map(g_pShadowLightSB, 0, D3D11_MAP_WRITE_DISCARD, 0, &MappedResource);
+    S_SHADOW_LIGHT_DATA* pShadowLight = (S_SHADOW_LIGHT_DATA*)MappedResource.pData;
+    for (unsigned int i = 0; pShadowLight != NULL && i < count; i++)
+    {
+        const AMD::ShadowLight & light = g_ShadowLightList.GetLight(g_ShadowLight[i]);
+        const unsigned int       batch = g_ShadowLightList.GetLightBatch(g_ShadowLight[i]);
+        const float4             direction = XMVector3Normalize(float4(light.m_Direction[0], light.m_Direction[1], light.m_Direction[2], 0.0f));
+
+        pShadowLight[i].m_Position = float4(light.m_Position[0], light.m_Position[1], light.m_Position[2], light.m_FarPlane);
+        pShadowLight[i].m_Direction = float4(direction, cosf(light.m_ConeAngle * 0.5f));
+        pShadowLight[i].m_Color = g_Color[(i + 1) % AMD_ARRAY_SIZE(g_Color)];
+        pShadowLight[i].m_Mask = batch != AMD::SHADOW_LIGHT_INVALID_INDEX ? g_ShadowLightList.GetBatch(batch).m_Target : SHADOW_LIGHT_MASK_COUNT;
+        pShadowLight[i].m_Channel = batch != AMD::SHADOW_LIGHT_INVALID_INDEX ? g_ShadowLightList.GetBatch(batch).m_Channel : 0;
+    }
+    pd3dContext->Unmap(g_pShadowLightSB, 0);
+}
+
+//--------------------------------------------------------------------------------------
+// The camera data of a view of g_ShadowLightList, what SetCameraConstantBufferData
+// fills from a CFirstPersonCamera for the cube faces
+//--------------------------------------------------------------------------------------
+void GetShadowLightViewData(const AMD::ShadowLightView & lightView, S_CAMERA_DATA * pCameraData)
+{
+    const AMD::ShadowLight &     light = g_ShadowLightList.GetLight(lightView.m_Light);
+    const AMD::ShadowAtlasRect & rect = g_LightShadowAtlas.GetRect(lightView.m_Region);
+
+    // the columns of the view matrix are the right, up and look directions
+    AMD::CameraBatchInput input;
+    for (int i = 0; i < 3; i++)
+    {
+        input.m_Eye[i] = light.m_Position[i];
+        input.m_Right[i] = lightView.m_View[i * 4 + 0];
+        input.m_Up[i] = lightView.m_View[i * 4 + 1];
+        input.m_Ahead[i] = lightView.m_View[i * 4 + 2];
+    }
+    memcpy(input.m_Projection, lightView.m_Projection, sizeof(input.m_Projection));
+
+    AMD::ComputeCameraMatrices(&input, 1, pCameraData, sizeof(S_CAMERA_DATA));
+
+    pCameraData->m_BackBufferDim = float2((float)rect.m_Width, (float)rect.m_Height);
+    pCameraData->m_BackBufferDimRcp = float2(1.0f / (float)rect.m_Width, 1.0f / (float)rect.m_Height);
+    pCameraData->m_Color = white;
+
+    pCameraData->m_Position = float4(light.m_Position[0], light.m_Position[1], light.m_Position[2], 1.0f);
+    pCameraData->m_Direction = float4(lightView.m_View[2], lightView.m_View[6], lightView.m_View[10], 0.0f);
+    pCameraData->m_Up = float4(lightView.m_View[1], lightView.m_View[5], lightView.m_View[9], 0.0f);
+    pCameraData->m_Fov = lightView.m_Fov;
+    pCameraData->m_Aspect = 1.0f;
+    pCameraData->m_zNear = light.m_NearPlane;
+    pCameraData->m_zFar = light.m_FarPlane;
+}
+
+//--------------------------------------------------------------------------------------
+// Issue the Crossfire API notifications placed by the frame graph. The user data of a
+// transferred resource is its AMD::Texture2D, the frame index is passed as user data.
+//--------------------------------------------------------------------------------------
+void NotifyFrameGraphStep(AMD::FRAME_GRAPH_STEP_TYPE type, unsigned int resource, void * pResourceUserData, void * pUserData)
+{
+    AMD::Texture2D * pTexture = (AMD::Texture2D *)pResourceUserData;
+    const int        frameIndex = *(const int *)pUserData;
+
+    (void)resource;
+
+    const AGSAfrTransferType transferType = pTexture == &g_ShadowMap ? g_ShadowMapCfxFlag :
+                                            pTexture == &g_ShadowMapStatic ? g_ShadowMapStaticCfxFlag : g_ShadowMapTransferCfxFlag;
+
+    switch (type)
+    {
+    case AMD::FRAME_GRAPH_STEP_BEGIN_ALL_ACCESS:
+        NotifyResourceBeginAllAccess(pTexture->_t2d); // wait until we get it updated from a previous GPU
+        break;
+
+    case AMD::FRAME_GRAPH_STEP_END_WRITES:
+        if (transferType != AGS_AFR_TRANSFER_DISABLE && // if the resource actually requires a transfer
+            transferType != AGS_AFR_TRANSFER_DEFAULT)   // i.e. it's flag isn't set to a Default or Disable value
+        {
+            NotifyDirtyRegionsEndWrites(*pTexture, transferType, frameIndex);
+        }
+        break;
+
+    case AMD::FRAME_GRAPH_STEP_END_ALL_ACCESS:
+        NotifyResourceEndAllAccess(pTexture->_t2d); // we won't be accessing this resource again in the frame!
+        break;
+
+    default:
+        break;
+    }
+}
+
+//--------------------------------------------------------------------------------------
+// Declare the passes of the frame and the resources they access. With 1-step transfers
+// the shadow map itself is notified to the driver, with 2-step transfers only the
+// "Transfer" shadow maps are: the one received from (if any) and the one sent with,
+// which may be the same. The cached static layer is notified whenever it is used, but
+// only written, and so broadcast, on the frames it is rendered. The spot lights are
+// rendered by every GPU every frame and never notified.
+//--------------------------------------------------------------------------------------
+void BuildFrameGraph(S_FRAME_PASSES * pPasses, unsigned int faceCount, unsigned int staticFaceCount, unsigned int lightViewCount, unsigned int readSlot, unsigned int writeSlot, int * pFrameIndex)
+{
+    const unsigned int notified = AMD::FRAME_GRAPH_RESOURCE_TRANSFERRED;
+    const unsigned int persistent = AMD::FRAME_GRAPH_RESOURCE_PERSISTENT;
+    const bool         oneStep = g_EnableCrossfireApiTransfers == true && g_Enable2StepGpuTransfer == false;
+    const bool         twoStep = g_EnableCrossfireApiTransfers == true && g_Enable2StepGpuTransfer == true;
+    const bool         staticTransfers = g_ShadowMapStaticCfxFlag != AGS_AFR_TRANSFER_DISABLE && g_ShadowMapStaticCfxFlag != AGS_AFR_TRANSFER_DEFAULT;
+
+    g_FrameGraph.Reset();
+    g_FrameGraph.SetNotifier(NotifyFrameGraphStep, pFrameIndex);
+    g_FrameGraph.SetDelayEndAllAccess(g_DelayEndAllAccess);
+
+    const unsigned int appDepth = g_FrameGraph.AddResource("AppDepth", 0, NULL);
+    const unsigned int appNormal = g_FrameGraph.AddResource("AppNormal", 0, NULL);
+    const unsigned int shadowMap = g_FrameGraph.AddResource("ShadowMap", oneStep ? notified : persistent, &g_ShadowMap);
+    const unsigned int shadowMapStatic = g_EnableStaticShadowCache ? g_FrameGraph.AddResource("ShadowMapStatic", staticTransfers ? notified : persistent, &g_ShadowMapStatic) : AMD::FRAME_GRAPH_INVALID_INDEX;
+    const unsigned int lightShadowMap = g_FrameGraph.AddResource("LightShadowMap", 0, NULL);
+    const unsigned int shadowMask = g_FrameGraph.AddResource("ShadowMask", 0, NULL);
+    const unsigned int shadowLightMask = g_FrameGraph.AddResource("ShadowLightMask", 0, NULL);
+    const unsigned int backBuffer = g_FrameGraph.AddResource("BackBuffer", persistent, NULL);
+    const bool         receive = twoStep == true && readSlot != AMD::TRANSFER_RING_INVALID_INDEX;
+    const unsigned int shadowMapTransferRead = receive ? g_FrameGraph.AddResource("ShadowMapTransferRead", notified, &g_ShadowMapTransfer[readSlot]) : AMD::FRAME_GRAPH_INVALID_INDEX;
+    const unsigned int shadowMapTransferWrite = twoStep == false ? AMD::FRAME_GRAPH_INVALID_INDEX :
+                                                (receive == true && readSlot == writeSlot) ? shadowMapTransferRead :
+                                                g_FrameGraph.AddResource("ShadowMapTransferWrite", notified, &g_ShadowMapTransfer[writeSlot]);
+
+    pPasses->m_ShadowMapReceive = pPasses->m_StaticShadowMapRendering = pPasses->m_ShadowMapRendering = pPasses->m_ShadowMapSend = AMD::FRAME_GRAPH_INVALID_INDEX;
+    pPasses->m_LightShadowMapRendering = AMD::FRAME_GRAPH_INVALID_INDEX;
+
+    pPasses->m_DepthPrepass = g_FrameGraph.AddPass("Depth Prepass Rendering");
+    g_FrameGraph.Write(pPasses->m_DepthPrepass, appDepth);
+    g_FrameGraph.Write(pPasses->m_DepthPrepass, appNormal);
+
+    if (receive == true)
+    {
+        pPasses->m_ShadowMapReceive = g_FrameGraph.AddPass("Shadow Map Receive");
+        g_FrameGraph.Read(pPasses->m_ShadowMapReceive, shadowMapTransferRead);
+        g_FrameGraph.Write(pPasses->m_ShadowMapReceive, shadowMap);
+    }
+
+    if (faceCount > 0)
+    {
+        if (staticFaceCount > 0)
+        {
+            pPasses->m_StaticShadowMapRendering = g_FrameGraph.AddPass("Static Shadow Map Rendering");
+            g_FrameGraph.Write(pPasses->m_StaticShadowMapRendering, shadowMapStatic);
+        }
+
+        pPasses->m_ShadowMapRendering = g_FrameGraph.AddPass("Shadow Map Rendering");
+        if (g_EnableStaticShadowCache == true)
+        {
+            g_FrameGraph.Read(pPasses->m_ShadowMapRendering, shadowMapStatic);
+        }
+        g_FrameGraph.Write(pPasses->m_ShadowMapRendering, shadowMap);
+
+        if (twoStep == true)
+        {
+            pPasses->m_ShadowMapSend = g_FrameGraph.AddPass("Shadow Map Send");
+            g_FrameGraph.Read(pPasses->m_ShadowMapSend, shadowMap);
+            g_FrameGraph.Write(pPasses->m_ShadowMapSend, shadowMapTransferWrite);
+        }
+    }
+
+    if (lightViewCount > 0)
+    {
+        pPasses->m_LightShadowMapRendering = g_FrameGraph.AddPass("Light Shadow Map Rendering");
+        g_FrameGraph.Write(pPasses->m_LightShadowMapRendering, lightShadowMap);
+    }
+
+    pPasses->m_ShadowMapMasking = g_FrameGraph.AddPass("Shadow Map Masking");
+    g_FrameGraph.Read(pPasses->m_ShadowMapMasking, appDepth);
+    g_FrameGraph.Write(pPasses->m_ShadowMapMasking, appDepth); // marks the stencil
+
+    pPasses->m_ShadowMapFiltering = g_FrameGraph.AddPass("Shadow Map Filtering");
+    g_FrameGraph.Read(pPasses->m_ShadowMapFiltering, shadowMap);
+    g_FrameGraph.Read(pPasses->m_ShadowMapFiltering, lightShadowMap);
+    g_FrameGraph.Read(pPasses->m_ShadowMapFiltering, appDepth);
+    g_FrameGraph.Read(pPasses->m_ShadowMapFiltering, appNormal);
+    g_FrameGraph.Write(pPasses->m_ShadowMapFiltering, shadowMask);
+    g_FrameGraph.Write(pPasses->m_ShadowMapFiltering, shadowLightMask);
+
+    pPasses->m_SceneRendering = g_FrameGraph.AddPass("Scene Rendering");
+    g_FrameGraph.Read(pPasses->m_SceneRendering, shadowMask);
+    g_FrameGraph.Read(pPasses->m_SceneRendering, shadowLightMask);
+    g_FrameGraph.Read(pPasses->m_SceneRendering, appDepth);
+    g_FrameGraph.Write(pPasses->m_SceneRendering, backBuffer);
+
+    g_FrameGraph.Compile();
+}
+
+//--------------------------------------------------------------------------------------
+// Get the shadow map updated by the other GPUs out of the newest "Transfer" shadow map
+//--------------------------------------------------------------------------------------
+void ReceiveShadowMapTransfer(ID3D11DeviceContext * pd3dContext, unsigned int slot, unsigned int gpu)
+{
+    unsigned int faces[CUBE_FACE_COUNT];
+    if (g_TransferRing.GetFacesToRead(gpu, slot, faces) == 0)
+    {
+        return; // this GPU already has everything the slot holds
+    }
+
+    // if the shadow map is large it may be better to copy just the faces that are newer
+    pd3dContext->CopyResource(g_ShadowMap._t2d, g_ShadowMapTransfer[slot]._t2d);
+    TRANSFER_VALIDATE_READ(g_TransferValidator, g_ShadowMapTransfer[slot]._t2d)
+    TRANSFER_VALIDATE_WRITE(g_TransferValidator, g_ShadowMap._t2d)
+}
+
+//--------------------------------------------------------------------------------------
+// Render the casters of the given set into all the given cube faces in one pass: the
+// state is bound once, and every caster is drawn once with an instance per face of
+// g_MeshFaceMask it touches. Faces are cleared (or copied from the static layer) first.
+//--------------------------------------------------------------------------------------
+void RenderShadowMapFacesInstanced(ID3D11DeviceContext * pd3dContext, const unsigned int * pFaces, unsigned int faceCount,
+                                   SHADOW_CASTER_SET set, ID3D11DepthStencilView * pDSV)
+{
+    D3D11_RECT*                pNullSR = NULL;
+    ID3D11HullShader*          pNullHS = NULL;
+    ID3D11DomainShader*        pNullDS = NULL;
+    ID3D11ShaderResourceView*  pNullSRV = NULL;
+    ID3D11RenderTargetView*    pNullRTV = NULL;
+    CFirstPersonCamera*        pNullCamera = NULL;
+
+    ID3D11Buffer             * pCB[] = { g_pModelCB, g_pViewerCB, g_pLightCB, g_pShadowFaceCB };
+    ID3D11SamplerState       * pSS[] = { g_pLinearWrapSS };
+
+    // an atlas face is selected by its viewport, an array face by its slice
+    const bool     atlas = g_ShadowTextureType == AMD::SHADOWFX_TEXTURE_2D;
+    D3D11_VIEWPORT viewport[CUBE_FACE_COUNT];
+    XMMATRIX       viewProjection[CUBE_FACE_COUNT];
+
+    for (unsigned int face = 0; face < CUBE_FACE_COUNT; face++)
+    {
+        const AMD::ShadowAtlasRect rect = GetShadowAtlasRect(face);
+        viewport[face] = atlas ? CD3D11_VIEWPORT((float)rect.m_X, (float)rect.m_Y, (float)rect.m_Width, (float)rect.m_Height) :
+                                 CD3D11_VIEWPORT(0.0f, 0.0f, g_ShadowMapSize, g_ShadowMapSize);
+        viewProjection[face] = XMMatrixTranspose(g_LightData[face].m_View) * XMMatrixTranspose(g_LightData[face].m_Projection);
+    }
+
+    // no meshes, this only binds the state of the pass
+    RenderScene(pd3dContext,
+                NULL, 0,
+                viewport, atlas ? CUBE_FACE_COUNT : 1,
+                pNullSR, 0,
+                g_pFrontCullingSolidRS, g_pOpaqueBS, white.f,
+                g_pDepthTestLessDSS, 0, g_pSceneIL,
+                g_pShadowMapInstancedVS, pNullHS, pNullDS, g_pShadowMapInstancedGS, g_pDepthPassScenePS,
+                g_pModelCB, 0, pCB, 0, AMD_ARRAY_SIZE(pCB),
+                pSS, 0, AMD_ARRAY_SIZE(pSS), &pNullSRV, 1, 0,
+                &pNullRTV, 0, pDSV,
+                &g_LightData[pFaces[0]], pNullCamera);
+
+    unsigned int faceMask = 0;
+    for (unsigned int face = 0; face < faceCount; face++)
+    {
+        faceMask |= 1u << pFaces[face];
+    }
+
+    std::vector<S_SHADOW_FACE_DATA> faceData(g_MeshCount);
+    std::vector<unsigned int>       instanceCount(g_MeshCount);
+    std::vector<unsigned int>       meshIndex(g_MeshCount);
+    unsigned int                    meshCount = 0;
+
+    for (unsigned int mesh = 0; mesh < g_MeshCount; mesh++)
+    {
+        const bool         inSet = set == SHADOW_CASTER_SET_ALL ||
+                                   (set == SHADOW_CASTER_SET_STATIC) == g_MeshIsStatic[mesh];
+        const unsigned int meshFaceMask = inSet ? g_MeshFaceMask[mesh] & faceMask : 0;
+
+        if (meshFaceMask == 0)
+        {
+            continue;
+        }
+
+        S_SHADOW_FACE_DATA & data = faceData[meshCount];
+        unsigned int &       instances = instanceCount[meshCount];
+        meshIndex[meshCount++] = mesh;
+
+        instances = 0;
+        data.m_World = XMMatrixTranspose(g_MeshModelMatrix[mesh]);
+
+        for (unsigned int face = 0; face < CUBE_FACE_COUNT; face++)
+        {
+            if ((meshFaceMask & (1u << face)) != 0)
+            {
+                data.m_WorldViewProjection[instances] = XMMatrixTranspose(g_MeshModelMatrix[mesh] * viewProjection[face]);
+                data.m_Target[instances][0] = atlas ? face : 0;
+                data.m_Target[instances][1] = atlas ? 0 : face;
+                instances++;
+            }
+        }
+    }
+
+    // the face data of all the meshes in one Map of g_ConstantRing, see RenderScene
+    ID3D11DeviceChild * pStageShader[] = { g_pShadowMapInstancedVS, pNullHS, pNullDS, g_pShadowMapInstancedGS, g_pDepthPassScenePS };
+    unsigned int        firstConstant = 0;
+    unsigned int        constantCount = 0;
+    const bool          ring = meshCount > 0 && WriteConstantRing(pd3dContext, &faceData[0], sizeof(S_SHADOW_FACE_DATA), meshCount, firstConstant, constantCount);
+
+    for (unsigned int i = 0; i < meshCount; i++)
+    {
+        if (ring == true)
+        {
+            SetConstantRingBlock(3, firstConstant + i * constantCount, constantCount, pStageShader);
+        }
+        else
+        {
+            SetConstantBufferData(pd3dContext, g_pShadowFaceCB, &faceData[i], sizeof(S_SHADOW_FACE_DATA));
+        }
+
+        g_MeshArray[meshIndex[i]]->Render(pd3dContext, instanceCount[i]);
+    }
+
+    g_StateCache.InvalidateShaderResources(AMD::STATE_CACHE_STAGE_PS, 0, 1); // see RenderScene
+}
+
+//--------------------------------------------------------------------------------------
+// Render the static casters of the given cube faces into the static layer. It has the
+// layout of the shadow map, so RenderShadowMapFaces starts a face from a copy of its
+// region instead of a clear, and then only draws the dynamic casters.
+//--------------------------------------------------------------------------------------
+void RenderStaticShadowMapFaces(ID3D11DeviceContext * pd3dContext, const unsigned int * pFaces, unsigned int faceCount)
+{
+    D3D11_RECT*                pNullSR = NULL;
+    ID3D11HullShader*          pNullHS = NULL;
+    ID3D11DomainShader*        pNullDS = NULL;
+    ID3D11GeometryShader*      pNullGS = NULL;
+    ID3D11ShaderResourceView*  pNullSRV = NULL;
+    ID3D11RenderTargetView*    pNullRTV = NULL;
+    CFirstPersonCamera*        pNullCamera = NULL;
+
+    ID3D11Buffer             * pCB[] = { g_pModelCB, g_pViewerCB, g_pLightCB };
+    ID3D11SamplerState       * pSS[] = { g_pLinearWrapSS };
+
+    const bool transfers = g_ShadowMapStaticCfxFlag != AGS_AFR_TRANSFER_DISABLE && // the static layer is broadcast once when it is rendered
+                           g_ShadowMapStaticCfxFlag != AGS_AFR_TRANSFER_DEFAULT;
+
+    TIMER_Begin(0, L"Static Shadow Map Rendering");
+
+    for (unsigned int face = 0; face < faceCount; face++)
+    {
+        int light = (int)pFaces[face];
+
+        const AMD::ShadowAtlasRect rect = GetShadowAtlasRect((unsigned int)light);
+        const bool                 atlas = g_ShadowTextureType == AMD::SHADOWFX_TEXTURE_2D;
+        const CD3D11_VIEWPORT      viewport = atlas ? CD3D11_VIEWPORT((float)rect.m_X, (float)rect.m_Y, (float)rect.m_Width, (float)rect.m_Height) :
+                                                      CD3D11_VIEWPORT(0.0f, 0.0f, g_ShadowMapSize, g_ShadowMapSize);
+        ID3D11DepthStencilView *   pDSV = atlas ? g_ShadowMapStatic._dsv : g_ShadowMapStatic._dsv_cube[light];
+
+        if (atlas == true) // see the clear of a single face in RenderShadowMapFaces
+        {
+            AMD::RenderFullscreenInstancedPass(g_StateCache, pd3dContext, viewport,
+                                               g_pScreenQuadVS, NULL, NULL,
+                                               NULL, 0, NULL, 0,  NULL, 0, NULL, 0,  NULL, 0, NULL, 0, 0,
+                                               pDSV, g_pDepthClearDSS, 0,
+                                               NULL, g_pNoCullingSolidRS, 2);
+        }
+        else
+        {
+            pd3dContext->ClearDepthStencilView(pDSV, D3D11_CLEAR_DEPTH, 1.0, 0);
+        }
+
+        std::vector<unsigned int> & instances = g_ShadowCasters;
+        const unsigned int          meshCount = g_EnableSinglePassShadowFaces ? 0 : GetShadowCasters((unsigned int)light, &instances[0], SHADOW_CASTER_SET_STATIC);
+
+        if (meshCount > 0)
+        {
+            RenderScene(pd3dContext,
+                        &instances[0], meshCount,
+                        &viewport, 1,
+                        pNullSR, 0,
+                        g_pFrontCullingSolidRS, g_pOpaqueBS, white.f,
+                        g_pDepthTestLessDSS, 0, g_pSceneIL,
+                        g_pSceneVS, pNullHS, pNullDS, pNullGS, g_pDepthPassScenePS,
+                        g_pModelCB, 0, pCB, 0, AMD_ARRAY_SIZE(pCB),
+                        pSS, 0, AMD_ARRAY_SIZE(pSS), &pNullSRV, 1, 0,
+                        &pNullRTV, 0, pDSV,
+                        &g_LightData[light], pNullCamera);
+        }
+        TRANSFER_VALIDATE_WRITE(g_TransferValidator, g_ShadowMapStatic._t2d)
+
+        if (transfers == true && atlas == true)
+        {
+            const AMD::DirtyRect dirtyRect = { (int)rect.m_X, (int)rect.m_Y, (int)(rect.m_X + rect.m_Width), (int)(rect.m_Y + rect.m_Height) };
+            g_ShadowMapStatic._dirty.AddRect(dirtyRect, 0);
+        }
+        else if (transfers == true)
+        {
+            g_ShadowMapStatic._dirty.AddSubresource((unsigned int)light);
+        }
+    }
+
+    if (g_EnableSinglePassShadowFaces == true && faceCount > 0)
+    {
+        RenderShadowMapFacesInstanced(pd3dContext, pFaces, faceCount, SHADOW_CASTER_SET_STATIC, g_ShadowMapStatic._dsv);
+    }
+
+    TIMER_End();
+}
+
+//--------------------------------------------------------------------------------------
+// The depth and normals of the scene as the viewer sees it, into g_AppDepth and g_AppNormal
+//--------------------------------------------------------------------------------------
+void RenderDepthPrepass(ID3D11DeviceContext * pd3dContext)
+{
+    D3D11_RECT*                pNullSR = NULL;
+    ID3D11HullShader*          pNullHS = NULL;
+    ID3D11DomainShader*        pNullDS = NULL;
+    ID3D11GeometryShader*      pNullGS = NULL;
+    ID3D11ShaderResourceView*  pNullSRV = NULL;
+    CFirstPersonCamera*        pNullCamera = NULL;
+
+    ID3D11Buffer             * pCB[] = { g_pModelCB, g_pViewerCB, g_pLightCB };
+    ID3D11SamplerState       * pSS[] = { g_pLinearWrapSS };
+    ID3D11RenderTargetView   * pRTV[] = { g_AppNormal._rtv };
+
+    RenderScene(pd3dContext,
+                &g_AllInstances[0], g_MeshCount,
+                &CD3D11_VIEWPORT(0.0f, 0.0f, (float)g_Width, (float)g_Height), 1,
+                pNullSR, 0,
+                g_pBackCullingSolidRS, g_pOpaqueBS, white.f,
+                g_pDepthTestLessDSS, 0, g_pSceneIL,
+                g_pSceneVS, pNullHS, pNullDS, pNullGS, g_pDepthAndNormalPassScenePS,
+                g_pModelCB, 0, pCB, 0, AMD_ARRAY_SIZE(pCB),
+                pSS, 0, AMD_ARRAY_SIZE(pSS), &pNullSRV, 1, 0,
+                pRTV, AMD_ARRAY_SIZE(pRTV), g_AppDepth._dsv,
+                &g_ViewerData, pNullCamera);
+}
+
+//--------------------------------------------------------------------------------------
+// The draws of one cube face: its clear or its copy of the static layer, unless allFaces
+// is true and the whole shadow map was cleared or copied before, then its casters. Only
+// touches pd3dContext, so the faces can be recorded on deferred contexts at the same time.
+//--------------------------------------------------------------------------------------
+void RenderShadowMapFace(ID3D11DeviceContext * pd3dContext, unsigned int light, bool allFaces, bool cached, SHADOW_CASTER_SET casters)
+{
+    D3D11_RECT*                pNullSR = NULL;
+    ID3D11HullShader*          pNullHS = NULL;
+    ID3D11DomainShader*        pNullDS = NULL;
+    ID3D11GeometryShader*      pNullGS = NULL;
+    ID3D11ShaderResourceView*  pNullSRV = NULL;
+    ID3D11RenderTargetView*    pNullRTV = NULL;
+    CFirstPersonCamera*        pNullCamera = NULL;
+
+    ID3D11Buffer             * pCB[] = { g_pModelCB, g_pViewerCB, g_pLightCB };
+    ID3D11SamplerState       * pSS[] = { g_pLinearWrapSS };
+
+    D3D11_VIEWPORT             viewport = CD3D11_VIEWPORT(0.0f, 0.0f, g_ShadowMapSize, g_ShadowMapSize);
+    ID3D11DepthStencilView   * pDSV = g_ShadowMap._dsv;
+
+    if (g_ShadowTextureType == AMD::SHADOWFX_TEXTURE_2D) // Render shadow map into a texture atlas subregion
+    {
+        const AMD::ShadowAtlasRect rect = GetShadowAtlasRect(light);
+
+        viewport = CD3D11_VIEWPORT((float)rect.m_X, (float)rect.m_Y, (float)rect.m_Width, (float)rect.m_Height);
+
+        if (allFaces == false && cached == true)
+        {
+            // CopySubresourceRegion can't copy a region of a depth resource, so the static layer
+            // is blitted: PS_CopyDepth writes the depth it loads, the viewport limits it to the face
+            ID3D11ShaderResourceView * pSRV[] = { NULL, NULL, g_ShadowMapStatic._srv }; // g_t2dDepth
+
+            AMD::RenderFullscreenPass(GetStateCache(pd3dContext), pd3dContext, viewport,
+                                      g_pFullscreenVS, g_pCopyDepthPS,
+                                      NULL, 0, NULL, 0, NULL, 0,
+                                      pSRV, AMD_ARRAY_SIZE(pSRV),
+                                      NULL, 0, NULL, 0, 0,
+                                      g_ShadowMap._dsv, g_pDepthClearDSS, 0,
+                                      NULL, g_pNoCullingSolidRS);
+        }
+        else if (allFaces == false)
+        {
+            // when update happens on a single cube face, which is located inside a texture2d atlas
+            // an application (or in this case, this sample) needs to clear just that subregion to CLEAR_DEPTH
+            // this can be done via a custom compute or pixel shader that would populate the shadow atlas subregion with a CLEAR_DEPTH value
+            // this samples renders a quad over the area at CLEAR_DEPTH depth, with depth stencil state set to always pass depth test
+            AMD::RenderFullscreenInstancedPass(GetStateCache(pd3dContext), pd3dContext, viewport,
+                                               g_pScreenQuadVS, NULL, NULL,
+                                               NULL, 0, NULL, 0,  NULL, 0, NULL, 0,  NULL, 0, NULL, 0, 0,
+                                               g_ShadowMap._dsv, g_pDepthClearDSS, 0,
+                                               NULL, g_pNoCullingSolidRS, 2);
+        }
+    }
+    else // Render shadow map into separate texture array slices
+    {
+        pDSV = g_ShadowMap._dsv_cube[light];
+
+        if (cached == true)
+        {
+            pd3dContext->CopySubresourceRegion(g_ShadowMap._t2d, light, 0, 0, 0, g_ShadowMapStatic._t2d, light, NULL); // copying a depth resource requires a NULL srcBox
+        }
+        else
+        {
+            pd3dContext->ClearDepthStencilView(g_ShadowMap._dsv_cube[light], D3D11_CLEAR_DEPTH, 1.0, 0);
+        }
+    }
+
+    std::vector<unsigned int> & instances = GetShadowCasterScratch(pd3dContext); // every recording thread has its own
+    const unsigned int          meshCount = g_EnableSinglePassShadowFaces ? 0 : GetShadowCasters(light, &instances[0], casters);
+
+    if (meshCount > 0) // a face without casters only needs the clear or the static layer
+    {
+        RenderScene(pd3dContext,
+                    &instances[0], meshCount,
+                    &viewport, 1,
+                    pNullSR, 0,
+                    g_pFrontCullingSolidRS, g_pOpaqueBS, white.f,
+                    g_pDepthTestLessDSS, 0, g_pSceneIL,
+                    g_pSceneVS, pNullHS, pNullDS, pNullGS, g_pDepthPassScenePS,
+                    g_pModelCB, 0, pCB, 0, AMD_ARRAY_SIZE(pCB),
+                    pSS, 0, AMD_ARRAY_SIZE(pSS), &pNullSRV, 1, 0,
+                    &pNullRTV, 0, pDSV,
+                    &g_LightData[light], pNullCamera);
+    }
+}
+
+// faces start from the static layer and only the dynamic casters are drawn when it is enabled
+SHADOW_CASTER_SET GetShadowMapFaceCasters()
+{
+    return g_EnableStaticShadowCache == true ? SHADOW_CASTER_SET_DYNAMIC : SHADOW_CASTER_SET_ALL;
+}
+
+void ReleaseRecordedCommandLists()
+{
+    for (unsigned int job = 0; job < RECORD_JOB_COUNT; job++)
+    {
+        SAFE_RELEASE(g_pRecordCommandList[job]);
+    }
+}
+
+// executes and releases the command list recorded under slot; false if there is none, and
+// the caller renders the pass itself
+bool ExecuteRecordedCommandList(ID3D11DeviceContext * pd3dContext, unsigned int slot)
+{
+    if (g_pRecordCommandList[slot] == NULL)
+    {
+        return false;
+    }
+
+    pd3dContext->ExecuteCommandList(g_pRecordCommandList[slot], FALSE);
+    SAFE_RELEASE(g_pRecordCommandList[slot]);
+
+    g_StateCache.Invalidate(); // without restoring it, the state of the context is back to the defaults
+    return true;
+}
+
+struct S_RECORD_JOBS
+{
+    const unsigned int * m_pFaces;
+    unsigned int         m_FaceCount;
+};
+
+void RecordJob(unsigned int job, unsigned int worker, void* pUserData)
+{
+    const S_RECORD_JOBS & jobs = *(const S_RECORD_JOBS *)pUserData;
+    ID3D11DeviceContext * pContext = g_pRecordContext[job];
+
+    (void)worker; // the contexts are per job, every job has its own
+
+    // FinishCommandList(FALSE) leaves the deferred context at the default state
+    g_RecordStateCache[job].Invalidate();
+
+    unsigned int slot = RECORD_JOB_DEPTH_PREPASS;
+    if (job == RECORD_JOB_DEPTH_PREPASS)
+    {
+        RenderDepthPrepass(pContext);
+    }
+    else
+    {
+        const unsigned int light = jobs.m_pFaces[job - 1];
+        RenderShadowMapFace(pContext, light, jobs.m_FaceCount == CUBE_FACE_COUNT, g_EnableStaticShadowCache, GetShadowMapFaceCasters());
+        slot = 1 + light;
+    }
+
+    if (FAILED(pContext->FinishCommandList(FALSE, &g_pRecordCommandList[slot])))
+    {
+        g_pRecordCommandList[slot] = NULL;
+    }
+}
+
+//--------------------------------------------------------------------------------------
+// Record the depth prepass and the given cube faces into command lists, in parallel on the
+// threads of g_JobSystem. g_LightData has to hold the cameras of the frame already, the
+// constants of the draws are computed while recording. The lists that are not executed by
+// the end of the frame are released with the next recording.
+//--------------------------------------------------------------------------------------
+void RecordCommandLists(const unsigned int * pFaces, unsigned int faceCount)
+{
+    ReleaseRecordedCommandLists();
+
+    if (g_EnableDeferredRecording == false)
+    {
+        return;
+    }
+
+    for (unsigned int job = 0; job < 1 + faceCount; job++)
+    {
+        if (g_pRecordContext[job] == NULL)
+        {
+            return;
+        }
+    }
+
+    S_RECORD_JOBS jobs = { pFaces, faceCount };
+
+    TIMER_Begin(0, L"Command Recording");
+    g_JobSystem.Run(1 + faceCount, RecordJob, &jobs);
+    TIMER_End();
+}
+
+//--------------------------------------------------------------------------------------
+// Render the given cube faces into the shadow map, and with 1-step transfers record the
+// regions they cover so that only those are transferred. A face recorded by
+// RecordCommandLists is executed instead, in the same order.
+//--------------------------------------------------------------------------------------
+void RenderShadowMapFaces(ID3D11DeviceContext * pd3dContext, const unsigned int * pFaces, unsigned int faceCount)
+{
+    const bool allFaces = faceCount == CUBE_FACE_COUNT;
+    const bool cached = g_EnableStaticShadowCache == true; // faces start from the static layer and only the dynamic casters are drawn
+    const SHADOW_CASTER_SET casters = GetShadowMapFaceCasters();
+    const bool transfers = g_EnableCrossfireApiTransfers == true && // Crossfire API is enabled in UI (otherwise the driver uses the settings in the application profile)
+                           g_Enable2StepGpuTransfer == false &&     // and the shadow map itself is transferred
+                           g_EnableAffineFaceUpdates == false &&    // and every rendered face is sent (see AddAffineShadowMapTransfers)
+                           g_ShadowMapCfxFlag != AGS_AFR_TRANSFER_DISABLE &&
+                           g_ShadowMapCfxFlag != AGS_AFR_TRANSFER_DEFAULT;
+
+    TIMER_Begin(0, L"Shadow Map Rendering");
+
+    if (g_ShadowTextureType == AMD::SHADOWFX_TEXTURE_2D && allFaces == true) // the whole atlas at once, the faces skip their own clear
+    {
+        if (cached == true)
+        {
+            pd3dContext->CopyResource(g_ShadowMap._t2d, g_ShadowMapStatic._t2d); // the static layer holds every face this frame
+        }
+        else
+        {
+            pd3dContext->ClearDepthStencilView(g_ShadowMap._dsv, D3D11_CLEAR_DEPTH, 1.0, 0);
+        }
+    }
+
+    for (unsigned int face = 0; face < faceCount; face++)
+    {
+        const unsigned int light = pFaces[face];
+
+        if (ExecuteRecordedCommandList(pd3dContext, 1 + light) == false)
+        {
+            RenderShadowMapFace(pd3dContext, light, allFaces, cached, casters);
+        }
+        TRANSFER_VALIDATE_WRITE(g_TransferValidator, g_ShadowMap._t2d)
+
+        if (transfers == true && allFaces == false && g_ShadowTextureType == AMD::SHADOWFX_TEXTURE_2D)
+        {
+            // this is the subregion that has been updated, we only want to transfer it
+            const AMD::ShadowAtlasRect rect = GetShadowAtlasRect(light);
+            const AMD::DirtyRect dirtyRect = { (int)rect.m_X, (int)rect.m_Y, (int)(rect.m_X + rect.m_Width), (int)(rect.m_Y + rect.m_Height) };
+            g_ShadowMap._dirty.AddRect(dirtyRect, 0);
+        }
+        else if (transfers == true && allFaces == false)
+        {
+            // only the subresources that have been modified are transferred to other GPUs
+            g_ShadowMap._dirty.AddSubresource(light);
+        }
+    }
+
+    if (g_EnableSinglePassShadowFaces == true && faceCount > 0) // the faces above were only cleared, or copied from the static layer
+    {
+        RenderShadowMapFacesInstanced(pd3dContext, pFaces, faceCount, casters, g_ShadowMap._dsv);
+    }
+
+    if (transfers == true && allFaces == true)
+    {
+        g_ShadowMap._dirty.AddAll();
+    }
+
+    TIMER_End();
+}
+
+//--------------------------------------------------------------------------------------
+// Render the views of the spot lights into their regions of g_LightShadowMap. Every GPU
+// renders them every frame, so unlike the cube faces they are never transferred.
+//--------------------------------------------------------------------------------------
+void RenderLightShadowMap(ID3D11DeviceContext * pd3dContext)
+{
+    D3D11_RECT*                pNullSR = NULL;
+    ID3D11HullShader*          pNullHS = NULL;
+    ID3D11DomainShader*        pNullDS = NULL;
+    ID3D11GeometryShader*      pNullGS = NULL;
+    ID3D11ShaderResourceView*  pNullSRV = NULL;
+    ID3D11RenderTargetView*    pNullRTV = NULL;
+    CFirstPersonCamera*        pNullCamera = NULL;
+
+    ID3D11Buffer             * pCB[] = { g_pModelCB, g_pViewerCB, g_pLightCB };
+    ID3D11SamplerState       * pSS[] = { g_pLinearWrapSS };
+
+    std::vector<AMD::ShadowCasterBounds> bounds(g_MeshCount);
+    std::vector<unsigned int>            viewMask(g_MeshCount);
+    std::vector<unsigned int>            instances(g_MeshCount);
+    GetShadowCasterWorldBounds(&bounds[0]);
+
+    TIMER_Begin(0, L"Light Shadow Map Rendering");
+
+    for (unsigned int view = 0; view < g_ShadowLightList.GetViewCount(); view++)
+    {
+        // the culler takes up to SHADOW_CASTER_CULLING_MAX_FACE_COUNT views at a time
+        const unsigned int bit = view % AMD::SHADOW_CASTER_CULLING_MAX_FACE_COUNT;
+
+        if (bit == 0 && g_EnableCasterCulling == true)
+        {
+            const unsigned int viewCount = AMD::MIN(g_ShadowLightList.GetViewCount() - view, AMD::SHADOW_CASTER_CULLING_MAX_FACE_COUNT);
+
+            XMFLOAT4 planes[AMD::SHADOW_CASTER_CULLING_MAX_FACE_COUNT][6];
+            for (unsigned int i = 0; i < viewCount; i++)
+            {
+                const AMD::ShadowLightView & lightView = g_ShadowLightList.GetView(view + i);
+                const XMMATRIX               viewProjection = XMLoadFloat4x4((const XMFLOAT4X4 *)lightView.m_View) * XMLoadFloat4x4((const XMFLOAT4X4 *)lightView.m_Projection);
+                AMD::ExtractPlanesFromFrustum(planes[i], &viewProjection, false);
+            }
+            g_LightShadowCasterCuller.SetFaces(&planes[0][0].x, viewCount);
+            g_LightShadowCasterCuller.Cull(&bounds[0], g_MeshCount, &viewMask[0]);
+        }
+        else if (bit == 0)
+        {
+            viewMask.assign(g_MeshCount, 0xffffffff);
+        }
+
+        const AMD::ShadowLightView & lightView = g_ShadowLightList.GetView(view);
+        const AMD::ShadowAtlasRect & rect = g_LightShadowAtlas.GetRect(lightView.m_Region);
+        const CD3D11_VIEWPORT        viewport((float)rect.m_X, (float)rect.m_Y, (float)rect.m_Width, (float)rect.m_Height);
+
+        S_CAMERA_DATA cameraData;
+        GetShadowLightViewData(lightView, &cameraData);
+
+        // see the clear of a single face in RenderShadowMapFaces
+        AMD::RenderFullscreenInstancedPass(g_StateCache, pd3dContext, viewport,
+                                           g_pScreenQuadVS, NULL, NULL,
+                                           NULL, 0, NULL, 0,  NULL, 0, NULL, 0,  NULL, 0, NULL, 0, 0,
+                                           g_LightShadowMap._dsv, g_pDepthClearDSS, 0,
+                                           NULL, g_pNoCullingSolidRS, 2);
+
+        unsigned int meshCount = 0;
+        for (unsigned int mesh = 0; mesh < g_MeshCount; mesh++)
+        {
+            if ((viewMask[mesh] & (1u << bit)) != 0)
+            {
+                instances[meshCount++] = mesh;
+            }
+        }
+
+        if (meshCount > 0)
+        {
+            RenderScene(pd3dContext,
+                        &instances[0], meshCount,
+                        &viewport, 1,
+                        pNullSR, 0,
+                        g_pFrontCullingSolidRS, g_pOpaqueBS, white.f,
+                        g_pDepthTestLessDSS, 0, g_pSceneIL,
+                        g_pSceneVS, pNullHS, pNullDS, pNullGS, g_pDepthPassScenePS,
+                        g_pModelCB, 0, pCB, 0, AMD_ARRAY_SIZE(pCB),
+                        pSS, 0, AMD_ARRAY_SIZE(pSS), &pNullSRV, 1, 0,
+                        &pNullRTV, 0, g_LightShadowMap._dsv,
+                        &cameraData, pNullCamera);
+        }
+    }
+
+    TIMER_End();
+}
+
+//--------------------------------------------------------------------------------------
+// Fill light i of g_ShadowsDesc; the region is the min and max uv of the light in the
+// shadow map
+//--------------------------------------------------------------------------------------
+void SetShadowsDescLight(unsigned int i, const S_CAMERA_DATA & cameraData, const float4 & shadowRegion, const float2 & shadowSize, unsigned int arraySlice,
+                         float fov, float aspect, float zNear, float zFar)
+{
+    g_ShadowsDesc.m_ArraySlice[i] = arraySlice;
+
+    memcpy(&g_ShadowsDesc.m_ShadowSize[i], &shadowSize, sizeof(g_ShadowsDesc.m_ShadowSize[i]));
+    memcpy(&g_ShadowsDesc.m_ShadowRegion[i], &shadowRegion, sizeof(g_ShadowsDesc.m_ShadowRegion[i]));
+    memcpy(&g_ShadowsDesc.m_Light[i].m_View, &cameraData.m_View, sizeof(g_ShadowsDesc.m_Light[i].m_View));
+    memcpy(&g_ShadowsDesc.m_Light[i].m_Projection, &cameraData.m_Projection, sizeof(g_ShadowsDesc.m_Light[i].m_Projection));
+    memcpy(&g_ShadowsDesc.m_Light[i].m_ViewProjection, &cameraData.m_ViewProjection, sizeof(g_ShadowsDesc.m_Light[i].m_ViewProjection));
+    memcpy(&g_ShadowsDesc.m_Light[i].m_View_Inv, &cameraData.m_ViewInv, sizeof(g_ShadowsDesc.m_Light[i].m_View_Inv));
+    memcpy(&g_ShadowsDesc.m_Light[i].m_Projection_Inv, &cameraData.m_ProjectionInv, sizeof(g_ShadowsDesc.m_Light[i].m_Projection_Inv));
+    memcpy(&g_ShadowsDesc.m_Light[i].m_ViewProjection_Inv, &cameraData.m_ViewProjectionInv, sizeof(g_ShadowsDesc.m_Light[i].m_ViewProjection_Inv));
+
+    memcpy(&g_ShadowsDesc.m_Light[i].m_Position, &cameraData.m_Position, sizeof(g_ShadowsDesc.m_Light[i].m_Position));
+    memcpy(&g_ShadowsDesc.m_Light[i].m_Up, &cameraData.m_Up, sizeof(g_ShadowsDesc.m_Light[i].m_Up));
+    memcpy(&g_ShadowsDesc.m_Light[i].m_Direction, &cameraData.m_Direction, sizeof(g_ShadowsDesc.m_Light[i].m_Direction));
+
+    g_ShadowsDesc.m_Light[i].m_Aspect = aspect;
+    g_ShadowsDesc.m_Light[i].m_Fov = fov;
+    g_ShadowsDesc.m_Light[i].m_FarPlane = zFar;
+    g_ShadowsDesc.m_Light[i].m_NearPlane = zNear;
+}
+
+//--------------------------------------------------------------------------------------
+// Filter the spot lights into the channels of g_ShadowLightMask, one ShadowFX_Render
+// per batch of g_ShadowLightList: ShadowFX takes at most 6 views at a time. The masks
+// are cleared to lit, and the MIN blend of a channel leaves the union of the shadows
+// of a batch. The rest of g_ShadowsDesc is the one of the cube light.
+//--------------------------------------------------------------------------------------
+void FilterShadowLights(ID3D11DeviceContext * pd3dContext)
+{
+    for (unsigned int mask = 0; mask < g_ShadowLightList.GetMaskCount(); mask++)
+    {
+        pd3dContext->ClearRenderTargetView(g_ShadowLightMask[mask]._rtv, white.f);
+    }
+
+    const float atlasWidth = (float)g_LightShadowAtlas.GetWidth();
+    const float atlasHeight = (float)g_LightShadowAtlas.GetHeight();
+
+    for (unsigned int b = 0; b < g_ShadowLightList.GetBatchCount(); b++)
+    {
+        const AMD::ShadowLightBatch & batch = g_ShadowLightList.GetBatch(b);
+
+        for (unsigned int i = 0; i < batch.m_ViewCount; i++)
+        {
+            const AMD::ShadowLightView & lightView = g_ShadowLightList.GetView(batch.m_FirstView + i);
+            const AMD::ShadowLight &     light = g_ShadowLightList.GetLight(lightView.m_Light);
+            const AMD::ShadowAtlasRect & rect = g_LightShadowAtlas.GetRect(lightView.m_Region);
+            const float4                 shadowRegion((float)rect.m_X / atlasWidth, (float)rect.m_Y / atlasHeight,
+                                                      (float)(rect.m_X + rect.m_Width) / atlasWidth, (float)(rect.m_Y + rect.m_Height) / atlasHeight);
+
+            S_CAMERA_DATA cameraData;
+            GetShadowLightViewData(lightView, &cameraData);
+            SetShadowsDescLight(i, cameraData, shadowRegion, float2((float)rect.m_Width, (float)rect.m_Height), 0,
+                                lightView.m_Fov, 1.0f, light.m_NearPlane, light.m_FarPlane);
+        }
+
+        g_ShadowsDesc.m_Execution = batch.m_Cube == true ? AMD::SHADOWFX_EXECUTION_CUBE : AMD::SHADOWFX_EXECUTION_UNION;
+        g_ShadowsDesc.m_ActiveLightCount = batch.m_ViewCount;
+        g_ShadowsDesc.m_pOutputRTV = g_ShadowLightMask[batch.m_Target]._rtv;
+        g_ShadowsDesc.m_pOutputBS = g_pShadowMaskChannelBS[batch.m_Channel];
+        g_ShadowsDesc.m_pShadowSRV = g_LightShadowMap._srv;
+        g_ShadowsDesc.m_TextureType = AMD::SHADOWFX_TEXTURE_2D;
+
+        AMD::ShadowFX_Render(g_ShadowsDesc);
+        g_StateCache.Invalidate(); // ShadowFX binds its state through the context
+    }
 
-        }
-        TIMER_End();
+    g_ShadowsDesc.m_pOutputBS = NULL; // back to the write mask of the cube light
+}
+
+//--------------------------------------------------------------------------------------
+// With GPU affine face updates every GPU refreshes its own copy of the shadow map, and
+// with 1-step transfers only the faces another GPU would otherwise sample older than
+// the max age are recorded for the EndWrites of the shadow map
+//--------------------------------------------------------------------------------------
+void AddAffineShadowMapTransfers(unsigned int gpu, unsigned int frame)
+{
+    const bool transfers = g_EnableCrossfireApiTransfers == true &&
+                           g_Enable2StepGpuTransfer == false &&
+                           g_ShadowMapCfxFlag != AGS_AFR_TRANSFER_DISABLE &&
+                           g_ShadowMapCfxFlag != AGS_AFR_TRANSFER_DEFAULT;
+
+    if (transfers == false)
+    {
+        return;
     }
 
-    if (g_ShadowTextureType == AMD::SHADOWFX_TEXTURE_2D_ARRAY) // Render shadow map into separate texture array slices
+    const unsigned int gpuCount = (unsigned int)AMD::MAX(g_agsGpuCount, 1);
+    const bool         broadcast = g_ShadowMapCfxFlag == AGS_AFR_TRANSFER_2STEP_WITH_BROADCAST;
+    unsigned int       faces[CUBE_FACE_COUNT];
+    const unsigned int faceCount = g_ShadowFaceAffinity.GetFacesToSend(gpu, frame, broadcast, faces);
+
+    for (unsigned int face = 0; face < faceCount; face++)
     {
-        TIMER_Begin(0, L"Shadow Map Rendering");
+        const unsigned int light = faces[face];
+
+        if (g_ShadowTextureType == AMD::SHADOWFX_TEXTURE_2D)
         {
-            int light = shadowMapFrameDelay % CUBE_FACE_COUNT;
+            const AMD::ShadowAtlasRect rect = GetShadowAtlasRect(light);
 
-            pd3dContext->ClearDepthStencilView(g_ShadowMap._dsv_cube[light], D3D11_CLEAR_DEPTH, 1.0, 0); // there is only 1 shadow map, so clear it every frame
+            const AMD::DirtyRect dirtyRect = { (int)rect.m_X, (int)rect.m_Y, (int)(rect.m_X + rect.m_Width), (int)(rect.m_Y + rect.m_Height) };
+            g_ShadowMap._dirty.AddRect(dirtyRect, 0);
+        }
+        else
+        {
+            g_ShadowMap._dirty.AddSubresource(light);
+        }
 
-            RenderScene(pd3dContext,
-                        g_MeshArray, g_MeshModelMatrix, AMD_ARRAY_SIZE(g_MeshArray),
-                        &CD3D11_VIEWPORT(0.0f, 0.0f, g_ShadowMapSize, g_ShadowMapSize), 1,
-                        pNullSR, 0,
-                        g_pFrontCullingSolidRS, g_pOpaqueBS, white.f,
-                        g_pDepthTestLessDSS, 0, g_pSceneIL,
-                        g_pSceneVS, pNullHS, pNullDS, pNullGS, g_pDepthPassScenePS,
-                        g_pModelCB, 0, pCB, 0, AMD_ARRAY_SIZE(pCB),
-                        pSS, 0, AMD_ARRAY_SIZE(pSS), &pNullSRV, 1, 0,
-                        &pNullRTV, 0, g_ShadowMap._dsv_cube[light],
-                        &g_LightData[light], pNullCamera);
+        // the receivers now hold whatever this GPU holds of the face
+        for (unsigned int i = 1; i < gpuCount && g_ShadowFaceCache.IsValid(light, gpu); i++)
+        {
+            g_ShadowFaceCache.MarkRendered(light, (gpu + i) % gpuCount);
 
-            if (g_EnableCrossfireApiTransfers == true) // Crossfire API is enabled in UI (otherwise the driver uses the settings in the application profile)
+            if (broadcast == false)
             {
-                const unsigned int transferSubresource[] = // this is the subresource index that has been updated, we only want to transfer it
-                {
-                    (unsigned int) light
-                };
-                if (g_Enable2StepGpuTransfer == true) // if 2-step-gpu-transfer is used
-                {
-                    // only the sub resource that has been updated needs to be copied to the transfer resource
-                    pd3dContext->CopySubresourceRegion(g_ShadowMapTransfer._t2d, light, 0, 0, 0, g_ShadowMap._t2d, light, NULL); // copying a depth resource requires a NULL srcBox
-                    // copying all the resource is not needed. it only negatively affects performance
-                    // pd3dContext->CopyResource(g_ShadowMapTransfer._t2d, g_ShadowMap._t2d);
-
-                    if (g_ShadowMapTransferCfxFlag != AGS_AFR_TRANSFER_DISABLE && // if the "Transfer" shadow map actually requires a transfer
-                        g_ShadowMapTransferCfxFlag != AGS_AFR_TRANSFER_DEFAULT)   // i.e. it's flag isn't set to a Default or Disable value
-                    {
-                        // only the subresource that has been modified is transferred to other GPUs
-                        agsDriverExtensions_NotifyResourceEndWrites(g_agsContext, g_ShadowMapTransfer._t2d, NULL, transferSubresource,
-                            AMD_ARRAY_SIZE(transferSubresource)); // intiate transfer of a subresource
-                    }
-                }
-                else
-                {
-                    if (g_ShadowMapCfxFlag != AGS_AFR_TRANSFER_DISABLE &&
-                        g_ShadowMapCfxFlag != AGS_AFR_TRANSFER_DEFAULT)
-                    {
-                        // only the subresource that has been modified is transferred to other GPUs
-                        agsDriverExtensions_NotifyResourceEndWrites(g_agsContext, g_ShadowMap._t2d, NULL, transferSubresource, AMD_ARRAY_SIZE(transferSubresource));
-                    }
-                }
+                break;
             }
         }
-        TIMER_End();
-    }
-
-    if (g_EnableCrossfireApiTransfers == true &&
-        g_Enable2StepGpuTransfer == true &&
-        g_DelayEndAllAccess == false)
-    {
-        // we are DONE with "Transfer" resource and we can call EndAllAccess right now!
-        agsDriverExtensions_NotifyResourceEndAllAccess(g_agsContext, g_ShadowMapTransfer._t2d); // we won't be accessing this resource again in the frame!
     }
 
+    g_ShadowFaceAffinity.MarkSent(gpu, broadcast, faces, faceCount);
 }
 
-void UpdateAllCubeFacesPerNFramesAndTransfer(ID3D11DeviceContext * pd3dContext,  int shadowMapFrameDelay, int maxShadowMapFrameDelay)
+//--------------------------------------------------------------------------------------
+// Copy the cube faces the "Transfer" shadow map of this frame is missing into it for
+// 2-step transfers; that's more than the faces rendered when it was last written a
+// few frames ago
+//--------------------------------------------------------------------------------------
+void SendShadowMapFaces(ID3D11DeviceContext * pd3dContext, unsigned int slot, unsigned int gpu, unsigned int frame)
 {
-    D3D11_RECT*                pNullSR = NULL;
-    ID3D11HullShader*          pNullHS = NULL;
-    ID3D11DomainShader*        pNullDS = NULL;
-    ID3D11GeometryShader*      pNullGS = NULL;
-    ID3D11ShaderResourceView*  pNullSRV = NULL;
-    ID3D11RenderTargetView*    pNullRTV = NULL;
-    CFirstPersonCamera*        pNullCamera = NULL;
+    const bool transfers = g_ShadowMapTransferCfxFlag != AGS_AFR_TRANSFER_DISABLE && // if the "Transfer" shadow map actually requires a transfer
+                           g_ShadowMapTransferCfxFlag != AGS_AFR_TRANSFER_DEFAULT;   // i.e. it's flag isn't set to a Default or Disable value
 
-    ID3D11Buffer             * pCB[] = { g_pModelCB, g_pViewerCB, g_pLightCB };
-    ID3D11SamplerState       * pSS[] = { g_pLinearWrapSS };
+    AMD::Texture2D & transfer = g_ShadowMapTransfer[slot];
+    unsigned int     faces[CUBE_FACE_COUNT];
+    unsigned int     faceCount = g_TransferRing.GetFacesToWrite(gpu, slot, faces);
 
+    if (faceCount > 0 && transfers == true)
+    {
+        g_TransferRing.MarkSent(gpu, slot, frame, g_ShadowMapTransferCfxFlag == AGS_AFR_TRANSFER_2STEP_WITH_BROADCAST);
+    }
 
-    if (g_EnableCrossfireApiTransfers == true)
+    if (faceCount == CUBE_FACE_COUNT)
     {
-        if (g_Enable2StepGpuTransfer == false)
-        {
-            agsDriverExtensions_NotifyResourceBeginAllAccess(g_agsContext, g_ShadowMap._t2d);
-        }
-        else
+        pd3dContext->CopyResource(transfer._t2d, g_ShadowMap._t2d); // update the shadow map copy from current frame
+        TraceTransferCopy(transfer._t2d, g_ShadowMap._t2d, NULL, NULL, 0);
+
+        if (transfers == true)
         {
-            agsDriverExtensions_NotifyResourceBeginAllAccess(g_agsContext, g_ShadowMapTransfer._t2d);
-            pd3dContext->CopyResource(g_ShadowMap._t2d, g_ShadowMapTransfer._t2d);
+            transfer._dirty.AddAll();
         }
+        return;
     }
 
-    if (shadowMapFrameDelay % maxShadowMapFrameDelay == 0)
+    for (unsigned int face = 0; face < faceCount; face++)
     {
+        int light = (int)faces[face];
+
         if (g_ShadowTextureType == AMD::SHADOWFX_TEXTURE_2D)
         {
-            pd3dContext->ClearDepthStencilView(g_ShadowMap._dsv, D3D11_CLEAR_DEPTH, 1.0, 0); // there is only 1 shadow map, so clear it every frame
+            const AMD::ShadowAtlasRect rect = GetShadowAtlasRect((unsigned int)light);
 
-            TIMER_Begin(0, L"Shadow Map Rendering"); // Render shadow map into separate texture array slices
+            D3D11_RECT transferRect[] = // this is the subregion that has been updated, we only want to transfer it
             {
-                for (int light = 0; light < CUBE_FACE_COUNT; light++)
-                {
-                    int lightIndexX = light % g_ShadowMapAtlasScaleW;
-                    int lightIndexY = light / g_ShadowMapAtlasScaleW;
-
-                    RenderScene(pd3dContext,
-                                g_MeshArray, g_MeshModelMatrix, AMD_ARRAY_SIZE(g_MeshArray),
-                                &CD3D11_VIEWPORT(g_ShadowMapSize*lightIndexX, g_ShadowMapSize*lightIndexY, g_ShadowMapSize, g_ShadowMapSize), 1,
-                                pNullSR, 0,
-                                g_pFrontCullingSolidRS, g_pOpaqueBS, white.f,
-                                g_pDepthTestLessDSS, 0, g_pSceneIL,
-                                g_pSceneVS, pNullHS, pNullDS, pNullGS, g_pDepthPassScenePS,
-                                g_pModelCB, 0, pCB, 0, AMD_ARRAY_SIZE(pCB),
-                                pSS, 0, AMD_ARRAY_SIZE(pSS), &pNullSRV, 1, 0,
-                                &pNullRTV, 0, g_ShadowMap._dsv,
-                                &g_LightData[light], pNullCamera);
+                {(LONG)rect.m_X, (LONG)rect.m_Y, (LONG)(rect.m_X + rect.m_Width), (LONG)(rect.m_Y + rect.m_Height)}
+            };
 
-                }
+            // according to d3d11 CopySubresourceRegion cannot be used to transfer a region of a depth buffer resources (or subresource)
+            // for the atlas shadow map the naive solution is to use CopyResource to transfer all the atlas
+            // a faster solution is to use a blit shader to copy the updated region
+            {
+                AMD::C_SaveRestore_RS srs(pd3dContext);
+                AMD::C_SaveRestore_OM som(pd3dContext);
+                AMD::RenderFullscreenPass(g_StateCache, pd3dContext, CD3D11_VIEWPORT(0.f, 0.f, g_ShadowMapSize * g_ShadowMapAtlasScaleW, g_ShadowMapSize * g_ShadowMapAtlasScaleH),
+                    g_pFullscreenVS, g_pFullscreenPS,
+                    transferRect, AMD_ARRAY_SIZE(transferRect), NULL, 0, NULL, 0,
+                    &g_ShadowMap._srv, 1,
+                    &transfer._rtv, 1, NULL, 0, 0,
+                    NULL, g_pDepthClearDSS, 0, NULL, NULL);
             }
-            TIMER_End();
-        }
+            TraceTransferCopy(transfer._t2d, g_ShadowMap._t2d, transferRect, NULL, 0);
 
-        if (g_ShadowTextureType == AMD::SHADOWFX_TEXTURE_2D_ARRAY)
-        {
-            TIMER_Begin(0, L"Shadow Map Rendering"); // Render shadow map into separate texture array slices
+            if (transfers == true)
             {
-                for (int light = 0; light < CUBE_FACE_COUNT; light++)
-                {
-                    pd3dContext->ClearDepthStencilView(g_ShadowMap._dsv_cube[light], D3D11_CLEAR_DEPTH, 1.0, 0); // there is only 1 shadow map, so clear it every frame
-
-                    RenderScene(pd3dContext,
-                                g_MeshArray, g_MeshModelMatrix, AMD_ARRAY_SIZE(g_MeshArray),
-                                &CD3D11_VIEWPORT(0.0f, 0.0f, g_ShadowMapSize, g_ShadowMapSize), 1,
-                                pNullSR, 0,
-                                g_pFrontCullingSolidRS, g_pOpaqueBS, white.f,
-                                g_pDepthTestLessDSS, 0, g_pSceneIL,
-                                g_pSceneVS, pNullHS, pNullDS, pNullGS, g_pDepthPassScenePS,
-                                g_pModelCB, 0, pCB, 0, AMD_ARRAY_SIZE(pCB),
-                                pSS, 0, AMD_ARRAY_SIZE(pSS), &pNullSRV, 1, 0,
-                                &pNullRTV, 0, g_ShadowMap._dsv_cube[light],
-                                &g_LightData[light], pNullCamera);
-
-                }
+                const AMD::DirtyRect dirtyRect = { (int)transferRect[0].left, (int)transferRect[0].top, (int)transferRect[0].right, (int)transferRect[0].bottom };
+                transfer._dirty.AddRect(dirtyRect, 0);
             }
-            TIMER_End();
         }
 
-        if (g_EnableCrossfireApiTransfers == true)
+        if (g_ShadowTextureType == AMD::SHADOWFX_TEXTURE_2D_ARRAY)
         {
-            if (g_Enable2StepGpuTransfer == true) // if experimental is enabled, then only shadow map Copy needs to notify access
+            const unsigned int transferSubresource[] = // this is the subresource index that has been updated, we only want to transfer it
             {
-                pd3dContext->CopyResource(g_ShadowMapTransfer._t2d, g_ShadowMap._t2d); // update the shadow map copy from current frame
-                if (g_ShadowMapTransferCfxFlag != AGS_AFR_TRANSFER_DISABLE &&
-                    g_ShadowMapTransferCfxFlag != AGS_AFR_TRANSFER_DEFAULT)
-                {
-                    agsDriverExtensions_NotifyResourceEndWrites(g_agsContext, g_ShadowMapTransfer._t2d, NULL, 0, 0); // intiate transfer
-                }
-            }
-            else
+                (unsigned int) light
+            };
+
+            // only the sub resource that has been updated needs to be copied to the transfer resource
+            pd3dContext->CopySubresourceRegion(transfer._t2d, light, 0, 0, 0, g_ShadowMap._t2d, light, NULL); // copying a depth resource requires a NULL srcBox
+            TraceTransferCopy(transfer._t2d, g_ShadowMap._t2d, NULL, transferSubresource, AMD_ARRAY_SIZE(transferSubresource));
+
+            if (transfers == true)
             {
-                if (g_ShadowMapCfxFlag != AGS_AFR_TRANSFER_DISABLE &&
-                    g_ShadowMapCfxFlag != AGS_AFR_TRANSFER_DEFAULT)
-                {
-                    // if experimental is disabled - we can only tell the driver that shadow map is done updating
-                    agsDriverExtensions_NotifyResourceEndWrites(g_agsContext, g_ShadowMap._t2d, NULL, 0, 0);
-                }
+                transfer._dirty.AddSubresource(transferSubresource[0]);
             }
         }
     }
+}
+
+//--------------------------------------------------------------------------------------
+// Adds the frame to the benchmark results after the warmup. After the last frame, saves
+// them and closes the window, or in a sweep moves on to the next configuration and
+// saves the ranking after the last one
+//--------------------------------------------------------------------------------------
+void RecordBenchmarkFrame(unsigned int faceCount, float fElapsedTime)
+{
+    static const WCHAR * passNames[] =
+    {
+        L"Depth Prepass Rendering", L"Static Shadow Map Rendering", L"Shadow Map Rendering", L"Light Shadow Map Rendering",
+        L"Shadow Map Masking", L"Shadow Map Filtering", L"Scene Rendering", L"Command Recording",
+    };
+
+    if (g_BenchmarkFrame++ < g_BenchmarkWarmupFrames)
+    {
+        return;
+    }
+
+    LARGE_INTEGER timerFrequency;
+    QueryPerformanceFrequency(&timerFrequency);
+    const double frameTime = (double)(GetTransferTraceTimestamp() - g_BenchmarkFrameStart) * 1000.0 / (double)timerFrequency.QuadPart;
+
+    AMD::BenchmarkResults & results = g_BenchmarkResults;
+    results.BeginFrame();
+
+    for (unsigned int pass = 0; pass < AMD_ARRAY_SIZE(passNames); pass++)
+    {
+        char name[128];
+        sprintf_s(name, "%ls (CPU)", passNames[pass]);
+        results.Set(results.AddMetric(name, "ms"), TIMER_GetTime(Cpu, passNames[pass]) * 1000.0);
+        sprintf_s(name, "%ls (GPU)", passNames[pass]);
+        results.Set(results.AddMetric(name, "ms"), TIMER_GetTime(Gpu, passNames[pass]) * 1000.0);
+    }
+
+    results.Set(results.AddMetric("Frame (CPU)", "ms"), frameTime);
+    results.Set(results.AddMetric("Frame Time", "ms"), fElapsedTime * 1000.0);
+    results.Set(results.AddMetric("EndWrites", "calls"), g_FrameEndWritesCount);
+    results.Set(results.AddMetric("BeginAllAccess", "calls"), g_FrameBeginAllAccessCount);
+    results.Set(results.AddMetric("EndAllAccess", "calls"), g_FrameEndAllAccessCount);
+    results.Set(results.AddMetric("Transfer Copies", "calls"), g_FrameTransferCopyCount);
+    results.Set(results.AddMetric("Shadow Faces", "faces"), faceCount);
+
+    if (g_BenchmarkFrame < g_BenchmarkWarmupFrames + g_BenchmarkFrames)
+    {
+        return;
+    }
+
+    if (g_BenchmarkSweepConfig >= 0)
+    {
+        const unsigned int metric = results.FindMetric(g_BenchmarkSweep.GetMetric());
+        if (metric != AMD::BENCHMARK_INVALID_INDEX)
+        {
+            g_BenchmarkSweep.SetResult((unsigned int)g_BenchmarkSweepConfig, results.GetStats(metric));
+        }
+
+        results.Reset();
+        g_BenchmarkFrame = 0;
+
+        if (++g_BenchmarkSweepConfig < (int)g_BenchmarkSweep.GetConfigCount())
+        {
+            return;
+        }
+
+        if (g_BenchmarkSweep.SaveRanking(g_BenchmarkOutput) == false)
+        {
+            OutputDebugStringA("Can't write the benchmark sweep ranking\n");
+        }
 
+        g_Benchmark = false;
+        PostMessage(DXUTGetHWND(), WM_CLOSE, 0, 0);
+        return;
+    }
 
-    if (g_EnableCrossfireApiTransfers == true &&
-        g_Enable2StepGpuTransfer == true &&  // if experimental is enabled, then only shadow map Copy needs to notify access
-        g_DelayEndAllAccess == false)
+    // the settings as they were during the run, in the names of tools/Benchmark
+    char value[64];
+    results.SetSetting("backend", "d3d11");
+    sprintf_s(value, "%d", AMD::MAX(g_agsGpuCount, 1));
+    results.SetSetting("gpus", value);
+    results.SetSetting("texture", g_ShadowTextureType == AMD::SHADOWFX_TEXTURE_2D ? "atlas" : "array");
+    results.SetSetting("transfer", AMD::GetAfrSimTransferName((int)g_ResourceCfxTransferFlag));
+    results.SetSetting("api transfers", g_EnableCrossfireApiTransfers ? "on" : "off");
+    results.SetSetting("2-step", g_Enable2StepGpuTransfer ? "on" : "off");
+    results.SetSetting("delay EndAllAccess", g_DelayEndAllAccess ? "on" : "off");
+    results.SetSetting("update", g_HUD.m_GUI.GetCheckBox(IDC_CHECKBOX_ENABLE_1_FACE_UPDATE_PER_FRAME)->GetChecked() ? "single face" : "all faces");
+    sprintf_s(value, "%u", (unsigned int)g_ShadowMapSize);
+    results.SetSetting("shadow map size", value);
+    sprintf_s(value, "%d", g_EnableDeferredRecording ? g_RecordThreadCount : 1);
+    results.SetSetting("threads", value);
+    sprintf_s(value, "%dx%d", g_Width, g_Height);
+    results.SetSetting("resolution", value);
+
+    if (results.Save(g_BenchmarkOutput) == false)
     {
-        agsDriverExtensions_NotifyResourceEndAllAccess(g_agsContext, g_ShadowMapTransfer._t2d); // we won't be accessing this resource again in the frame!
+        OutputDebugStringA("Can't write the benchmark results\n");
     }
+
+    g_Benchmark = false;
+    PostMessage(DXUTGetHWND(), WM_CLOSE, 0, 0);
 }
 
 //--------------------------------------------------------------------------------------
@@ -1343,16 +3630,11 @@ void CALLBACK OnD3D11FrameRender(ID3D11Device* pd3dDevice,
                                  float                                         fElapsedTime,
                                  void*                                         pUserContext)
 {
-    D3D11_MAPPED_SUBRESOURCE MappedResource;
-
     D3D11_RECT*                pNullSR = NULL;
     ID3D11HullShader*          pNullHS = NULL;
     ID3D11DomainShader*        pNullDS = NULL;
     ID3D11GeometryShader*      pNullGS = NULL;
-    ID3D11PixelShader*         pNullPS = NULL;
-    ID3D11ShaderResourceView*  pNullSRV = NULL;
     ID3D11RenderTargetView*    pNullRTV = NULL;
-    ID3D11SamplerState*        pNullSS = NULL;
     CFirstPersonCamera*        pNullCamera = NULL;
 
     ID3D11RenderTargetView*    pOriginalRTV = NULL;
@@ -1362,23 +3644,40 @@ void CALLBACK OnD3D11FrameRender(ID3D11Device* pd3dDevice,
     static float               fTimeShadowMap = 0.0f;
     static float               fTimeShadowMapFiltering = 0.0f;
     static float               fTimeDepthPrepass = 0.0f;
+    static float               fTimeRecording = 0.0f;
     static float               fSceneRendering = 0.0f;
     static float               fShadowMapMasking = 0.0f;
     static bool                bCapture = false;
 
     static int                 shadowMapFrameDelay = 0;
 
+    S_FRAME_PASSES             passes;
+    unsigned int               faces[CUBE_FACE_COUNT];
+    unsigned int               faceCount = 0;
+
     // if running on an MGPU PC, update shadow map once in two frames
     static int                 maxShadowMapFrameDelay = g_agsGpuCount > 1 ? 6 : 1;
 
+    // without transfers every GPU has to render all the cube faces itself
+    const int                  shadowMapUpdateInterval = (g_EnableCrossfireApiTransfers == true && g_ResourceCfxTransferFlag == AGS_AFR_TRANSFER_DISABLE) ? 1 : maxShadowMapFrameDelay;
+
     TIMER_Reset();
 
+    g_BenchmarkFrameStart = GetTransferTraceTimestamp();
+    g_FrameEndWritesCount = g_FrameBeginAllAccessCount = g_FrameEndAllAccessCount = g_FrameTransferCopyCount = 0;
+
+    shadowMapFrameDelay++; // every Present moves AFR to the next GPU, the settings dialog's too
+
     if (g_SettingsDlg.IsActive()) // If the settings dialog is being shown, then render it instead of rendering the app's scene
     {
         g_SettingsDlg.OnRender(fElapsedTime);
         return;
     }
 
+    // the HUD and DXUT bound their state through the context since the last frame
+    g_StateCache.Invalidate();
+    g_StateCache.ResetCounters();
+
     pd3dContext->OMGetRenderTargets(1, &pOriginalRTV, &pOriginalDSV); // Store the original render target and depth buffer so we can reset it at the end of the frame
 
     pd3dContext->ClearRenderTargetView(g_ShadowMask._rtv, black.f);
@@ -1390,233 +3689,277 @@ void CALLBACK OnD3D11FrameRender(ID3D11Device* pd3dDevice,
     pd3dContext->ClearDepthStencilView(g_LightDepth._dsv, D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 0);
 
     {
-        ID3D11ShaderResourceView * pSRV[] = { NULL, g_ShadowMask._srv, NULL };
+        ID3D11ShaderResourceView * pSRV[] = { NULL, g_ShadowMask._srv, NULL, NULL,  // g_t2dDiffuse, g_t2dShadowMask, g_t2dDepth, g_ShadowLight
+                                              g_ShadowLightMask[0]._srv, g_ShadowLightMask[1]._srv, g_ShadowLightMask[2]._srv, g_ShadowLightMask[3]._srv };
         ID3D11Buffer             * pCB[] = { g_pModelCB, g_pViewerCB, g_pLightCB };
         ID3D11SamplerState       * pSS[] = { g_pLinearWrapSS };
 
         SetCameraConstantBufferData(pd3dContext, g_pViewerCB, &g_ViewerData, &g_ViewerCamera, NULL, 0, 1, 1);
 
-        TIMER_Begin(0, L"Depth Prepass Rendering");
+        g_ConstantRing.BeginFrame((unsigned int)shadowMapFrameDelay);
+        g_TransferTrace.SetFrame((unsigned int)shadowMapFrameDelay);
+        TRANSFER_VALIDATE_BEGIN_FRAME(g_TransferValidator, (unsigned int)shadowMapFrameDelay)
+
+        if (g_ShadowsExecution == AMD::SHADOWFX_EXECUTION_CASCADE) // the cascades that are due this frame
+        {
+            faceCount = InitializeCascadeCamera(&g_ViewerCamera, g_CubeCamera, g_LightOrtho, (unsigned int)shadowMapFrameDelay, faces);
+        }
+        else if (g_HUD.m_GUI.GetCheckBox(IDC_CHECKBOX_ENABLE_PRIORITIZED_FACE_UPDATE)->GetChecked())
+        {
+            faceCount = ScheduleCubeFaceUpdates(faces);
+        }
+        else if (g_EnableAffineFaceUpdates == true)
+        {
+            faces[faceCount++] = g_ShadowFaceAffinity.GetFace((unsigned int)shadowMapFrameDelay);
+        }
+        else if (g_HUD.m_GUI.GetCheckBox(IDC_CHECKBOX_ENABLE_1_FACE_UPDATE_PER_FRAME)->GetChecked())
         {
-            ID3D11RenderTargetView* pRTV[] = { g_AppNormal._rtv };
+            faces[faceCount++] = (unsigned int)(shadowMapFrameDelay % CUBE_FACE_COUNT);
+        }
+        else if (shadowMapFrameDelay % shadowMapUpdateInterval == 0)
+        {
+            for (unsigned int face = 0; face < CUBE_FACE_COUNT; face++)
+            {
+                faces[faceCount++] = face;
+            }
+        }
 
-            RenderScene(pd3dContext,
-                        g_MeshArray, g_MeshModelMatrix, AMD_ARRAY_SIZE(g_MeshArray),
-                        &CD3D11_VIEWPORT(0.0f, 0.0f, (float)g_Width, (float)g_Height), 1,
-                        pNullSR, 0,
-                        g_pBackCullingSolidRS, g_pOpaqueBS, white.f,
-                        g_pDepthTestLessDSS, 0, g_pSceneIL,
-                        g_pSceneVS, pNullHS, pNullDS, pNullGS, g_pDepthAndNormalPassScenePS,
-                        g_pModelCB, 0, pCB, 0, AMD_ARRAY_SIZE(pCB),
-                        pSS, 0, AMD_ARRAY_SIZE(pSS), &pNullSRV, 1, 0,
-                        pRTV, AMD_ARRAY_SIZE(pRTV), g_AppDepth._dsv,
-                        &g_ViewerData, pNullCamera);
+        CullShadowCasters();
+        faceCount = UpdateShadowAtlasRegions(faces, faceCount);
+        faceCount = SkipUnchangedCubeFaces(faces, faceCount);
+
+        UpdateShadowLights();
+        UpdateShadowLightBuffer(pd3dDevice, pd3dContext);
+        pSRV[3] = g_pShadowLightSRV;
 
+        // the completion of a transfer can't be queried, so the newest "Transfer" shadow map sent to
+        // this GPU is read and BeginAllAccess waits for it; the others stay untouched by this frame
+        const unsigned int gpu = (unsigned int)shadowMapFrameDelay % (unsigned int)AMD::MAX(g_agsGpuCount, 1);
+        const unsigned int readSlot = g_TransferRing.GetReadSlot(gpu, (unsigned int)shadowMapFrameDelay);
+        const unsigned int writeSlot = g_TransferRing.GetWriteSlot((unsigned int)shadowMapFrameDelay);
+
+        // the faces rendered this frame whose static layer this GPU neither rendered nor received
+        unsigned int staticFaces[CUBE_FACE_COUNT];
+        unsigned int staticFaceCount = 0;
+        for (unsigned int face = 0; g_EnableStaticShadowCache == true && face < faceCount; face++)
+        {
+            if (g_StaticShadowFaceCache.IsValid(faces[face], gpu) == false)
+            {
+                staticFaces[staticFaceCount++] = faces[face];
+            }
         }
-        TIMER_End();
 
-        shadowMapFrameDelay++;
+        // the frame graph places BeginAllAccess, EndWrites and EndAllAccess around the passes below
+        BuildFrameGraph(&passes, faceCount, staticFaceCount, g_ShadowLightList.GetViewCount(), readSlot, writeSlot, &shadowMapFrameDelay);
+
+        float4x4 * pFaceProjection = g_ShadowsExecution == AMD::SHADOWFX_EXECUTION_CASCADE ? g_LightOrtho : NULL;
+
+        // the draws of the faces are computed from g_LightData while they are recorded, so the
+        // cameras are set first; the passes below set them again, as they do without recording
+        if (g_EnableDeferredRecording == true)
+        {
+            SetCameraConstantBufferData(pd3dContext, g_pLightCB, g_LightData, g_CubeCamera, pFaceProjection, 0, CUBE_FACE_COUNT, CUBE_FACE_COUNT);
+        }
+        RecordCommandLists(faces, faceCount);
 
-        if (g_HUD.m_GUI.GetCheckBox(IDC_CHECKBOX_ENABLE_1_FACE_UPDATE_PER_FRAME)->GetChecked())
+        if (g_FrameGraph.BeginPass(passes.m_DepthPrepass))
         {
-            int light = shadowMapFrameDelay % CUBE_FACE_COUNT;
-            SetCameraConstantBufferData(pd3dContext, g_pLightCB, g_LightData, g_CubeCamera, NULL, light, light + 1, CUBE_FACE_COUNT);
+            TIMER_Begin(0, L"Depth Prepass Rendering");
+            if (ExecuteRecordedCommandList(pd3dContext, RECORD_JOB_DEPTH_PREPASS) == false)
+            {
+                RenderDepthPrepass(pd3dContext);
+            }
+            TIMER_End();
 
-            UpdateSingleCubeFacePerFrameAndTransfer(pd3dContext, shadowMapFrameDelay);
+            g_FrameGraph.EndPass(passes.m_DepthPrepass);
         }
-        else
+
+        if (g_FrameGraph.BeginPass(passes.m_ShadowMapReceive))
+        {
+            ReceiveShadowMapTransfer(pd3dContext, readSlot, gpu);
+            g_FrameGraph.EndPass(passes.m_ShadowMapReceive);
+        }
+
+        if (g_FrameGraph.BeginPass(passes.m_StaticShadowMapRendering))
         {
-            if (shadowMapFrameDelay % maxShadowMapFrameDelay == 0)
+            SetCameraConstantBufferData(pd3dContext, g_pLightCB, g_LightData, g_CubeCamera, pFaceProjection, 0, CUBE_FACE_COUNT, CUBE_FACE_COUNT);
+
+            RenderStaticShadowMapFaces(pd3dContext, staticFaces, staticFaceCount);
+
+            for (unsigned int face = 0; face < staticFaceCount; face++)
             {
-                SetCameraConstantBufferData(pd3dContext, g_pLightCB, g_LightData, g_CubeCamera, NULL, 0, CUBE_FACE_COUNT, CUBE_FACE_COUNT);
+                g_StaticShadowFaceCache.MarkRendered(staticFaces[face], gpu);
             }
 
-            UpdateAllCubeFacesPerNFramesAndTransfer(pd3dContext, shadowMapFrameDelay, maxShadowMapFrameDelay);
+            g_FrameGraph.EndPass(passes.m_StaticShadowMapRendering);
         }
 
-        TIMER_Begin(0, L"Shadow Map Masking");
+        if (g_FrameGraph.BeginPass(passes.m_ShadowMapRendering))
         {
-            for (int light = 0; light < CUBE_FACE_COUNT; light++)
+            SetCameraConstantBufferData(pd3dContext, g_pLightCB, g_LightData, g_CubeCamera, pFaceProjection, 0, CUBE_FACE_COUNT, CUBE_FACE_COUNT);
+
+            RenderShadowMapFaces(pd3dContext, faces, faceCount);
+
+            for (unsigned int face = 0; face < faceCount; face++)
             {
-                pd3dContext->Map(g_pUnitCubeCB, 0, D3D11_MAP_WRITE_DISCARD, 0, &MappedResource);
-                S_UNIT_CUBE_TRANSFORM* pUnitCubeCB = (S_UNIT_CUBE_TRANSFORM*)MappedResource.pData;
-                {
-                    pUnitCubeCB->m_Transform = g_ViewerData.m_ViewProjection  * g_LightData[light].m_ViewProjectionInv;
-                    pUnitCubeCB->m_Inverse = g_LightData[light].m_ViewProjectionInv;
-                    pUnitCubeCB->m_Forward = g_ViewerData.m_ViewProjection;
-                    pUnitCubeCB->m_Color = white;
-                }
-                pd3dContext->Unmap(g_pUnitCubeCB, 0);
-
-                AMD::RenderUnitCube(pd3dContext,
-                                    CD3D11_VIEWPORT(0.0f, 0.0f, (float)g_Width, (float)g_Height),
-                                    pNullSR, 0,
-                                    g_pNoCullingSolidRS,
-                                    g_pOpaqueBS, white.f,
-                                    g_pDepthTestMarkStencilDSS, 1,
-                                    g_pUnitCubeVS, pNullHS, pNullDS, pNullGS, pNullPS,
-                                    &g_pUnitCubeCB, 0, 1,
-                                    &pNullSS, 0, 0,
-                                    &pNullSRV, 0, 0,
-                                    &pNullRTV, 0, g_AppDepth._dsv);
+                g_ShadowFaceCache.MarkRendered(faces[face], gpu);
+                g_ShadowFaceAffinity.MarkRendered(gpu, faces[face], (unsigned int)shadowMapFrameDelay);
+                g_TransferRing.MarkRendered(gpu, faces[face], (unsigned int)shadowMapFrameDelay);
             }
+
+            if (g_EnableAffineFaceUpdates == true)
+            {
+                AddAffineShadowMapTransfers(gpu, (unsigned int)shadowMapFrameDelay);
+            }
+
+            g_FrameGraph.EndPass(passes.m_ShadowMapRendering);
         }
-        TIMER_End();
+        ReleaseRecordedCommandLists(); // of passes the frame graph skipped
 
-        g_ShadowsDesc.m_Execution = g_ShadowsExecution;
+        if (g_FrameGraph.BeginPass(passes.m_ShadowMapSend))
+        {
+            SendShadowMapFaces(pd3dContext, writeSlot, gpu, (unsigned int)shadowMapFrameDelay);
+            g_FrameGraph.EndPass(passes.m_ShadowMapSend);
+        }
 
-        TIMER_Begin(0, L"Shadow Map Filtering");
+        if (g_FrameGraph.BeginPass(passes.m_LightShadowMapRendering))
         {
-            g_ShadowsDesc.m_NormalOption = AMD::SHADOWFX_NORMAL_OPTION_NONE;
-            g_ShadowsDesc.m_Filtering = AMD::SHADOWFX_FILTERING_DEBUG_POINT;
+            RenderLightShadowMap(pd3dContext);
+            g_FrameGraph.EndPass(passes.m_LightShadowMapRendering);
+        }
 
-            float2 backbufferDim((float)g_Width, (float)g_Height);
-            float2 shadowAtlasRegionDim(g_ShadowMapSize, g_ShadowMapSize);
+        if (g_FrameGraph.BeginPass(passes.m_ShadowMapMasking))
+        {
+            TIMER_Begin(0, L"Shadow Map Masking");
+            RenderLightVolumes(pd3dContext, g_pNoCullingSolidRS, g_pDepthTestMarkStencilDSS, false, &pNullRTV, 0);
+            TIMER_End();
 
-            g_ShadowsDesc.m_ActiveLightCount = CUBE_FACE_COUNT;
+            g_FrameGraph.EndPass(passes.m_ShadowMapMasking);
+        }
 
-            memcpy(&g_ShadowsDesc.m_Viewer.m_View, &g_ViewerData.m_View, sizeof(g_ShadowsDesc.m_Viewer.m_View));
-            memcpy(&g_ShadowsDesc.m_Viewer.m_Projection, &g_ViewerData.m_Projection, sizeof(g_ShadowsDesc.m_Viewer.m_Projection));
-            memcpy(&g_ShadowsDesc.m_Viewer.m_ViewProjection, &g_ViewerData.m_ViewProjection, sizeof(g_ShadowsDesc.m_Viewer.m_ViewProjection));
-            memcpy(&g_ShadowsDesc.m_Viewer.m_View_Inv, &g_ViewerData.m_ViewInv, sizeof(g_ShadowsDesc.m_Viewer.m_View_Inv));
-            memcpy(&g_ShadowsDesc.m_Viewer.m_Projection_Inv, &g_ViewerData.m_ProjectionInv, sizeof(g_ShadowsDesc.m_Viewer.m_Projection_Inv));
-            memcpy(&g_ShadowsDesc.m_Viewer.m_ViewProjection_Inv, &g_ViewerData.m_ViewProjectionInv, sizeof(g_ShadowsDesc.m_Viewer.m_ViewProjection_Inv));
-            memcpy(&g_ShadowsDesc.m_Viewer.m_Position, &g_ViewerData.m_Position, sizeof(g_ShadowsDesc.m_Viewer.m_Position));
-            memcpy(&g_ShadowsDesc.m_Viewer.m_Direction, &g_ViewerData.m_Direction, sizeof(g_ShadowsDesc.m_Viewer.m_Direction));
-            memcpy(&g_ShadowsDesc.m_Viewer.m_Up, &g_ViewerData.m_Up, sizeof(g_ShadowsDesc.m_Viewer.m_Up));
-            memcpy(&g_ShadowsDesc.m_Viewer.m_Color, &g_ViewerData.m_Color, sizeof(g_ShadowsDesc.m_Viewer.m_Color));
-            memcpy(&g_ShadowsDesc.m_DepthSize, &backbufferDim, sizeof(g_ShadowsDesc.m_DepthSize));
+        if (g_FrameGraph.BeginPass(passes.m_ShadowMapFiltering))
+        {
+            g_ShadowsDesc.m_Execution = g_ShadowsExecution;
 
-            for (int i = 0; i < CUBE_FACE_COUNT; i++)
+            TIMER_Begin(0, L"Shadow Map Filtering");
             {
-                int lightIndexX = i % g_ShadowMapAtlasScaleW;
-                int lightIndexY = i / g_ShadowMapAtlasScaleW;
+                g_ShadowsDesc.m_NormalOption = AMD::SHADOWFX_NORMAL_OPTION_NONE;
+                g_ShadowsDesc.m_Filtering = AMD::SHADOWFX_FILTERING_DEBUG_POINT;
+
+                float2 backbufferDim((float)g_Width, (float)g_Height);
+
+                g_ShadowsDesc.m_ActiveLightCount = CUBE_FACE_COUNT;
+
+                memcpy(&g_ShadowsDesc.m_Viewer.m_View, &g_ViewerData.m_View, sizeof(g_ShadowsDesc.m_Viewer.m_View));
+                memcpy(&g_ShadowsDesc.m_Viewer.m_Projection, &g_ViewerData.m_Projection, sizeof(g_ShadowsDesc.m_Viewer.m_Projection));
+                memcpy(&g_ShadowsDesc.m_Viewer.m_ViewProjection, &g_ViewerData.m_ViewProjection, sizeof(g_ShadowsDesc.m_Viewer.m_ViewProjection));
+                memcpy(&g_ShadowsDesc.m_Viewer.m_View_Inv, &g_ViewerData.m_ViewInv, sizeof(g_ShadowsDesc.m_Viewer.m_View_Inv));
+                memcpy(&g_ShadowsDesc.m_Viewer.m_Projection_Inv, &g_ViewerData.m_ProjectionInv, sizeof(g_ShadowsDesc.m_Viewer.m_Projection_Inv));
+                memcpy(&g_ShadowsDesc.m_Viewer.m_ViewProjection_Inv, &g_ViewerData.m_ViewProjectionInv, sizeof(g_ShadowsDesc.m_Viewer.m_ViewProjection_Inv));
+                memcpy(&g_ShadowsDesc.m_Viewer.m_Position, &g_ViewerData.m_Position, sizeof(g_ShadowsDesc.m_Viewer.m_Position));
+                memcpy(&g_ShadowsDesc.m_Viewer.m_Direction, &g_ViewerData.m_Direction, sizeof(g_ShadowsDesc.m_Viewer.m_Direction));
+                memcpy(&g_ShadowsDesc.m_Viewer.m_Up, &g_ViewerData.m_Up, sizeof(g_ShadowsDesc.m_Viewer.m_Up));
+                memcpy(&g_ShadowsDesc.m_Viewer.m_Color, &g_ViewerData.m_Color, sizeof(g_ShadowsDesc.m_Viewer.m_Color));
+                memcpy(&g_ShadowsDesc.m_DepthSize, &backbufferDim, sizeof(g_ShadowsDesc.m_DepthSize));
+
+                for (int i = 0; i < CUBE_FACE_COUNT; i++)
+                {
+                    float4 shadowRegion(0.0f, 0.0f, 0.0f, 0.0f);
+                    float2 shadowAtlasRegionDim(g_ShadowMapSize, g_ShadowMapSize);
 
-                float4 shadowRegion(0.0f, 0.0f, 0.0f, 0.0f);
+                    unsigned int arraySlice = 0;
 
-                if (g_ShadowTextureType == AMD::SHADOWFX_TEXTURE_2D)
-                {
-                    shadowRegion.x = 1.0f * lightIndexX / g_ShadowMapAtlasScaleW;
-                    shadowRegion.z = 1.0f * (lightIndexX + 1.0f) / g_ShadowMapAtlasScaleW;
-                    shadowRegion.y = 1.0f * lightIndexY / g_ShadowMapAtlasScaleH;
-                    shadowRegion.w = 1.0f * (lightIndexY + 1.0f) / g_ShadowMapAtlasScaleH;
+                    if (g_ShadowTextureType == AMD::SHADOWFX_TEXTURE_2D)
+                    {
+                        const AMD::ShadowAtlasRect rect = GetShadowAtlasRect((unsigned int)i);
+                        const float                atlasWidth = g_ShadowMapSize * g_ShadowMapAtlasScaleW;
+                        const float                atlasHeight = g_ShadowMapSize * g_ShadowMapAtlasScaleH;
+
+                        shadowRegion.x = (float)rect.m_X / atlasWidth;
+                        shadowRegion.z = (float)(rect.m_X + rect.m_Width) / atlasWidth;
+                        shadowRegion.y = (float)rect.m_Y / atlasHeight;
+                        shadowRegion.w = (float)(rect.m_Y + rect.m_Height) / atlasHeight;
+                        shadowAtlasRegionDim = float2((float)rect.m_Width, (float)rect.m_Height);
+                    }
 
-                    g_ShadowsDesc.m_ArraySlice[i] = 0;
-                }
+                    if (g_ShadowTextureType == AMD::SHADOWFX_TEXTURE_2D_ARRAY)
+                    {
+                        shadowRegion.x = 0.0f;
+                        shadowRegion.z = 1.0f;
+                        shadowRegion.y = 0.0f;
+                        shadowRegion.w = 1.0f;
 
-                if (g_ShadowTextureType == AMD::SHADOWFX_TEXTURE_2D_ARRAY)
-                {
-                    shadowRegion.x = 0.0f;
-                    shadowRegion.z = 1.0f;
-                    shadowRegion.y = 0.0f;
-                    shadowRegion.w = 1.0f;
+                        arraySlice = (unsigned int)i;
+                    }
 
-                    g_ShadowsDesc.m_ArraySlice[i] = i;
-                }
+                    float zNear = g_LightCamera.GetNearClip();
+                    float zFar = g_LightCamera.GetFarClip();
 
-                memcpy(&g_ShadowsDesc.m_ShadowSize[i], &shadowAtlasRegionDim, sizeof(g_ShadowsDesc.m_ShadowSize[i]));
-                memcpy(&g_ShadowsDesc.m_ShadowRegion[i], &shadowRegion, sizeof(g_ShadowsDesc.m_ShadowRegion[i]));
-                memcpy(&g_ShadowsDesc.m_Light[i].m_View, &g_LightData[i].m_View, sizeof(g_ShadowsDesc.m_Light[i].m_View));
-                memcpy(&g_ShadowsDesc.m_Light[i].m_Projection, &g_LightData[i].m_Projection, sizeof(g_ShadowsDesc.m_Light[i].m_Projection));
-                memcpy(&g_ShadowsDesc.m_Light[i].m_ViewProjection, &g_LightData[i].m_ViewProjection, sizeof(g_ShadowsDesc.m_Light[i].m_ViewProjection));
-                memcpy(&g_ShadowsDesc.m_Light[i].m_View_Inv, &g_LightData[i].m_ViewInv, sizeof(g_ShadowsDesc.m_Light[i].m_View_Inv));
-                memcpy(&g_ShadowsDesc.m_Light[i].m_Projection_Inv, &g_LightData[i].m_ProjectionInv, sizeof(g_ShadowsDesc.m_Light[i].m_Projection_Inv));
-                memcpy(&g_ShadowsDesc.m_Light[i].m_ViewProjection_Inv, &g_LightData[i].m_ViewProjectionInv, sizeof(g_ShadowsDesc.m_Light[i].m_ViewProjection_Inv));
-
-                memcpy(&g_ShadowsDesc.m_Light[i].m_Position, &g_LightData[i].m_Position, sizeof(g_ShadowsDesc.m_Light[i].m_Position));
-                memcpy(&g_ShadowsDesc.m_Light[i].m_Up, &g_LightData[i].m_Up, sizeof(g_ShadowsDesc.m_Light[i].m_Up));
-                memcpy(&g_ShadowsDesc.m_Light[i].m_Direction, &g_LightData[i].m_Direction, sizeof(g_ShadowsDesc.m_Light[i].m_Direction));
-
-                g_ShadowsDesc.m_Light[i].m_Aspect = g_LightCamera.GetAspect();
-                g_ShadowsDesc.m_Light[i].m_Fov = g_LightCamera.GetFOV();
-                g_ShadowsDesc.m_Light[i].m_FarPlane = g_LightCamera.GetFarClip();
-                g_ShadowsDesc.m_Light[i].m_NearPlane = g_LightCamera.GetNearClip();
-            }
+                    if (g_ShadowsExecution == AMD::SHADOWFX_EXECUTION_CASCADE) // the depth range of the orthographic projection
+                    {
+                        zNear = g_ShadowCascades.GetCascade((unsigned int)i).m_NearPlane;
+                        zFar = g_ShadowCascades.GetCascade((unsigned int)i).m_FarPlane;
+                    }
+
+                    SetShadowsDescLight((unsigned int)i, g_LightData[i], shadowRegion, shadowAtlasRegionDim, arraySlice,
+                                        g_LightCamera.GetFOV(), g_LightCamera.GetAspect(), zNear, zFar);
+                }
 
-            g_ShadowsDesc.m_pContext = pd3dContext;
-            g_ShadowsDesc.m_pDevice = pd3dDevice;
-            g_ShadowsDesc.m_pDepthSRV = g_AppDepth._srv;
-            g_ShadowsDesc.m_pNormalSRV = g_AppNormal._srv;
-            g_ShadowsDesc.m_pOutputRTV = g_ShadowMask._rtv;
-            g_ShadowsDesc.m_OutputChannels = 1;
-            g_ShadowsDesc.m_ReferenceDSS = 0;
-            g_ShadowsDesc.m_pOutputDSS = NULL;
-            g_ShadowsDesc.m_pOutputDSV = NULL;
-            g_ShadowsDesc.m_EnableCapture = false;
+                g_ShadowsDesc.m_pContext = pd3dContext;
+                g_ShadowsDesc.m_pDevice = pd3dDevice;
+                g_ShadowsDesc.m_pDepthSRV = g_AppDepth._srv;
+                g_ShadowsDesc.m_pNormalSRV = g_AppNormal._srv;
+                g_ShadowsDesc.m_pOutputRTV = g_ShadowMask._rtv;
+                g_ShadowsDesc.m_OutputChannels = 1;
+                g_ShadowsDesc.m_ReferenceDSS = 0;
+                g_ShadowsDesc.m_pOutputDSS = NULL;
+                g_ShadowsDesc.m_pOutputDSV = NULL;
+                g_ShadowsDesc.m_EnableCapture = false;
 
-            g_ShadowsDesc.m_pShadowSRV = g_ShadowMap._srv;
+                g_ShadowsDesc.m_pShadowSRV = g_ShadowMap._srv;
 
-            g_ShadowsDesc.m_TextureType = (AMD::SHADOWFX_TEXTURE_TYPE) g_ShadowTextureType;
+                g_ShadowsDesc.m_TextureType = (AMD::SHADOWFX_TEXTURE_TYPE) g_ShadowTextureType;
 
-            AMD::ShadowFX_Render(g_ShadowsDesc);
+                AMD::ShadowFX_Render(g_ShadowsDesc);
+                g_StateCache.Invalidate(); // see FilterShadowLights
+                TRANSFER_VALIDATE_READ(g_TransferValidator, g_ShadowMap._t2d)
 
-            if (g_EnableCrossfireApiTransfers == true &&
-                g_Enable2StepGpuTransfer == false && // this is really the last point after which
-                g_DelayEndAllAccess == false)        // we no longer need the shadow map
-            {
-                agsDriverExtensions_NotifyResourceEndAllAccess(g_agsContext, g_ShadowMap._t2d);
+                FilterShadowLights(pd3dContext);
             }
+            TIMER_End();
+
+            g_FrameGraph.EndPass(passes.m_ShadowMapFiltering);
         }
-        TIMER_End();
 
         bCapture = false;
 
-        TIMER_Begin(0, L"Scene Rendering");
-        RenderScene(pd3dContext,
-                    g_MeshArray, g_MeshModelMatrix, AMD_ARRAY_SIZE(g_MeshArray),
-                    &CD3D11_VIEWPORT(0.0f, 0.0f, (float)g_Width, (float)g_Height), 1,
-                    pNullSR, 0,
-                    g_pBackCullingSolidRS, g_pOpaqueBS, white.f,
-                    g_pDepthTestLessEqualDSS, 0, g_pSceneIL,
-                    g_pSceneVS, pNullHS, pNullDS, pNullGS, g_pShadowedScenePS,
-                    g_pModelCB, 0, pCB, 0, AMD_ARRAY_SIZE(pCB),
-                    pSS, 0, AMD_ARRAY_SIZE(pSS), pSRV, 0, AMD_ARRAY_SIZE(pSRV),
-                    &pOriginalRTV, 1, g_AppDepth._dsv,
-                    &g_ViewerData, pNullCamera);
-
-        for (int light = 0; light < CUBE_FACE_COUNT; light++)
+        if (g_FrameGraph.BeginPass(passes.m_SceneRendering))
         {
-            pd3dContext->Map(g_pUnitCubeCB, 0, D3D11_MAP_WRITE_DISCARD, 0, &MappedResource);
-            S_UNIT_CUBE_TRANSFORM* pUnitCubeCB = (S_UNIT_CUBE_TRANSFORM*)MappedResource.pData;
-            {
-                pUnitCubeCB->m_Transform = g_ViewerData.m_ViewProjection * g_LightData[light].m_ViewProjectionInv;
-                pUnitCubeCB->m_Inverse = g_LightData[light].m_ViewProjectionInv;
-                pUnitCubeCB->m_Forward = g_ViewerData.m_ViewProjection;
-                pUnitCubeCB->m_Color = g_LightData[light].m_Color;
-            }
-            pd3dContext->Unmap(g_pUnitCubeCB, 0);
+            TIMER_Begin(0, L"Scene Rendering");
+            RenderScene(pd3dContext,
+                        &g_AllInstances[0], g_MeshCount,
+                        &CD3D11_VIEWPORT(0.0f, 0.0f, (float)g_Width, (float)g_Height), 1,
+                        pNullSR, 0,
+                        g_pBackCullingSolidRS, g_pOpaqueBS, white.f,
+                        g_pDepthTestLessEqualDSS, 0, g_pSceneIL,
+                        g_pSceneVS, pNullHS, pNullDS, pNullGS, g_pShadowedScenePS,
+                        g_pModelCB, 0, pCB, 0, AMD_ARRAY_SIZE(pCB),
+                        pSS, 0, AMD_ARRAY_SIZE(pSS), pSRV, 0, AMD_ARRAY_SIZE(pSRV),
+                        &pOriginalRTV, 1, g_AppDepth._dsv,
+                        &g_ViewerData, pNullCamera);
 
-            AMD::RenderUnitCube(pd3dContext,
-                                CD3D11_VIEWPORT(0.0f, 0.0f, (float)g_Width, (float)g_Height),
-                                pNullSR, 0,
-                                g_pNoCullingWireframeRS,
-                                g_pOpaqueBS, white.f,
-                                g_pDepthTestLessDSS, 1,
-                                g_pUnitCubeVS, pNullHS, pNullDS, pNullGS, g_pUnitCubePS,
-                                &g_pUnitCubeCB, 0, 1,
-                                &pNullSS, 0, 0,
-                                &pNullSRV, 0, 0,
-                                &pOriginalRTV, 1, g_AppDepth._dsv);
-        }
+            RenderLightVolumes(pd3dContext, g_pNoCullingWireframeRS, g_pDepthTestLessDSS, true, &pOriginalRTV, 1);
 
-        TIMER_End();
-    }
+            TIMER_End();
 
-    // for experimental delay of end all access
-    if (g_EnableCrossfireApiTransfers == true &&
-        g_DelayEndAllAccess == true)
-    {
-        // this is roughly the end of the frame, let the driver know that we are done with the correct resource
-        if (g_Enable2StepGpuTransfer == true)
-        {
-            agsDriverExtensions_NotifyResourceEndAllAccess(g_agsContext, g_ShadowMapTransfer._t2d);
-        }
-        else
-        {
-            agsDriverExtensions_NotifyResourceEndAllAccess(g_agsContext, g_ShadowMap._t2d);
+            g_FrameGraph.EndPass(passes.m_SceneRendering);
         }
     }
 
+    g_FrameGraph.EndFrame(); // delayed EndAllAccess, roughly the end of the frame
+
+    TRANSFER_VALIDATE_END_FRAME(g_TransferValidator)
+
     pd3dContext->RSSetViewports(1, &CD3D11_VIEWPORT(0.0f, 0.0f, (float)g_Width, (float)g_Height));
 
     pd3dContext->OMSetRenderTargets(1, &pOriginalRTV, pOriginalDSV);
@@ -1641,9 +3984,13 @@ void CALLBACK OnD3D11FrameRender(ID3D11Device* pd3dDevice,
         DXUT_EndPerfEvent();
     }
 
-    fTimeShadowMap += (float)TIMER_GetTime(Gpu, L"Shadow Map Rendering") * 1000.0f;
+    UpdateAdaptiveTransferMode(pd3dDevice, fElapsedTime);
+
+    fTimeShadowMap += (float)(TIMER_GetTime(Gpu, L"Static Shadow Map Rendering") + TIMER_GetTime(Gpu, L"Shadow Map Rendering") +
+                              TIMER_GetTime(Gpu, L"Light Shadow Map Rendering")) * 1000.0f;
     fTimeShadowMapFiltering += (float)TIMER_GetTime(Gpu, L"Shadow Map Filtering") * 1000.0f;
     fTimeDepthPrepass += (float)TIMER_GetTime(Gpu, L"Depth Prepass Rendering") * 1000.0f;
+    fTimeRecording += (float)TIMER_GetTime(Cpu, L"Command Recording") * 1000.0f;
     fShadowMapMasking += (float)TIMER_GetTime(Gpu, L"Shadow Map Masking") * 1000.0f;
     fSceneRendering += (float)TIMER_GetTime(Gpu, L"Scene Rendering") * 1000.0f;
 
@@ -1652,13 +3999,19 @@ void CALLBACK OnD3D11FrameRender(ID3D11Device* pd3dDevice,
         g_ShadowRenderingTime = fTimeShadowMap / (float)nCount;
         g_ShadowFilteringTime = fTimeShadowMapFiltering / (float)nCount;
         g_DepthPrepassRenderingTime = fTimeDepthPrepass / (float)nCount;
+        g_CommandRecordingTime = fTimeRecording / (float)nCount;
 
         g_ShadowMapMasking = fShadowMapMasking / (float)nCount;
         g_SceneRendering = fSceneRendering / (float)nCount;
 
-        fShadowMapMasking = fSceneRendering = fTimeShadowMap = fTimeShadowMapFiltering = fTimeDepthPrepass = 0.0f;
+        fShadowMapMasking = fSceneRendering = fTimeShadowMap = fTimeShadowMapFiltering = fTimeDepthPrepass = fTimeRecording = 0.0f;
         nCount = 0;
     }
+
+    if (g_Benchmark == true)
+    {
+        RecordBenchmarkFrame(faceCount, fElapsedTime);
+    }
 }
 
 void CreateShaders(ID3D11Device * pDevice)
@@ -1680,6 +4033,12 @@ void CreateShaders(ID3D11Device * pDevice)
         SAFE_RELEASE(code_blob);
     }
 
+    if (AMD::CompileShaderFromFile(L"..\\src\\Shaders\\CrossfireAPI11.hlsl", "VS_RenderSceneInstanced", "vs_5_0", &code_blob, NULL) == S_OK)
+    {
+        pDevice->CreateVertexShader(code_blob->GetBufferPointer(), code_blob->GetBufferSize(), NULL, &g_pSceneInstancedVS);
+        SAFE_RELEASE(code_blob);
+    }
+
     if (AMD::CompileShaderFromFile(L"..\\src\\Shaders\\CrossfireAPI11.hlsl", "PS_RenderShadowMap", "ps_5_0", &code_blob, NULL) == S_OK)
     {
         pDevice->CreatePixelShader(code_blob->GetBufferPointer(), code_blob->GetBufferSize(), NULL, &g_pShadowMapPS);
@@ -1692,6 +4051,18 @@ void CreateShaders(ID3D11Device * pDevice)
         SAFE_RELEASE(code_blob);
     }
 
+    if (AMD::CompileShaderFromFile(L"..\\src\\Shaders\\CrossfireAPI11.hlsl", "VS_RenderShadowMapInstanced", "vs_5_0", &code_blob, NULL) == S_OK)
+    {
+        pDevice->CreateVertexShader(code_blob->GetBufferPointer(), code_blob->GetBufferSize(), NULL, &g_pShadowMapInstancedVS);
+        SAFE_RELEASE(code_blob);
+    }
+
+    if (AMD::CompileShaderFromFile(L"..\\src\\Shaders\\CrossfireAPI11.hlsl", "GS_RenderShadowMapInstanced", "gs_5_0", &code_blob, NULL) == S_OK)
+    {
+        pDevice->CreateGeometryShader(code_blob->GetBufferPointer(), code_blob->GetBufferSize(), NULL, &g_pShadowMapInstancedGS);
+        SAFE_RELEASE(code_blob);
+    }
+
     if (AMD::CompileShaderFromFile(L"..\\src\\Shaders\\CrossfireAPI11.hlsl", "PS_RenderShadowedScene", "ps_5_0", &code_blob, NULL) == S_OK)
     {
         pDevice->CreatePixelShader(code_blob->GetBufferPointer(), code_blob->GetBufferSize(), NULL, &g_pShadowedScenePS);
@@ -1710,6 +4081,24 @@ void CreateShaders(ID3D11Device * pDevice)
         SAFE_RELEASE(code_blob);
     }
 
+    if (AMD::CompileShaderFromFile(L"..\\src\\Shaders\\CrossfireAPI11.hlsl", "PS_CopyDepth", "ps_5_0", &code_blob, NULL) == S_OK)
+    {
+        pDevice->CreatePixelShader(code_blob->GetBufferPointer(), code_blob->GetBufferSize(), NULL, &g_pCopyDepthPS);
+        SAFE_RELEASE(code_blob);
+    }
+
+    if (AMD::CompileShaderFromFile(L"..\\src\\Shaders\\CrossfireAPI11.hlsl", "VS_RenderLightVolumeInstanced", "vs_5_0", &code_blob, NULL) == S_OK)
+    {
+        pDevice->CreateVertexShader(code_blob->GetBufferPointer(), code_blob->GetBufferSize(), NULL, &g_pLightVolumeVS);
+        SAFE_RELEASE(code_blob);
+    }
+
+    if (AMD::CompileShaderFromFile(L"..\\src\\Shaders\\CrossfireAPI11.hlsl", "PS_RenderLightVolumeInstanced", "ps_5_0", &code_blob, NULL) == S_OK)
+    {
+        pDevice->CreatePixelShader(code_blob->GetBufferPointer(), code_blob->GetBufferSize(), NULL, &g_pLightVolumePS);
+        SAFE_RELEASE(code_blob);
+    }
+
     AMD::CreateClipSpaceCube(&g_pUnitCubeVS, pDevice);
     AMD::CreateFullscreenPass(&g_pFullscreenVS, pDevice);
     AMD::CreateScreenQuadPass(&g_pScreenQuadVS, pDevice);
@@ -1734,17 +4123,36 @@ void CALLBACK OnD3D11DestroyDevice(void* pUserContext)
     agsDriverExtensions_DeInit(g_agsContext);
     agsDeInit(g_agsContext);
 
+    g_TransferTrace.Release();
+
+    g_JobSystem.Release();
+    ReleaseRecordedCommandLists();
+    for (unsigned int job = 0; job < RECORD_JOB_COUNT; job++)
+    {
+        SAFE_RELEASE(g_pRecordContext[job]);
+    }
+
     TIMER_Destroy();
 
-    g_Tree.Release();
-    g_Plane.Release();
+    for (unsigned int asset = 0; asset < g_SceneMeshes.size(); asset++)
+    {
+        g_SceneMeshes[asset]->Release();
+        delete g_SceneMeshes[asset];
+    }
+    g_SceneMeshes.clear();
 
     SAFE_RELEASE(g_pShadowMapVS);
+    SAFE_RELEASE(g_pShadowMapInstancedVS);
+    SAFE_RELEASE(g_pShadowMapInstancedGS);
     SAFE_RELEASE(g_pSceneVS);
+    SAFE_RELEASE(g_pSceneInstancedVS);
     SAFE_RELEASE(g_pShadowMapPS);
     SAFE_RELEASE(g_pShadowedScenePS);
     SAFE_RELEASE(g_pDepthPassScenePS);
     SAFE_RELEASE(g_pDepthAndNormalPassScenePS);
+    SAFE_RELEASE(g_pCopyDepthPS);
+    SAFE_RELEASE(g_pLightVolumeVS);
+    SAFE_RELEASE(g_pLightVolumePS);
 
 
     SAFE_RELEASE(g_pFullscreenVS);
@@ -1754,6 +4162,15 @@ void CALLBACK OnD3D11DestroyDevice(void* pUserContext)
     SAFE_RELEASE(g_pUnitCubeVS);
     SAFE_RELEASE(g_pUnitCubePS);
     SAFE_RELEASE(g_pUnitCubeCB);
+    SAFE_RELEASE(g_pShadowFaceCB);
+    SAFE_RELEASE(g_pConstantRingCB);
+    SAFE_RELEASE(g_pShadowLightSRV);
+    SAFE_RELEASE(g_pShadowLightSB);
+    g_ShadowLightBufferCount = 0;
+    SAFE_RELEASE(g_pLightVolumeSRV);
+    SAFE_RELEASE(g_pLightVolumeSB);
+    SAFE_RELEASE(g_pInstanceSRV);
+    SAFE_RELEASE(g_pInstanceSB);
 
     SAFE_RELEASE(g_pSceneIL);
 
@@ -1780,10 +4197,19 @@ void CALLBACK OnD3D11DestroyDevice(void* pUserContext)
     SAFE_RELEASE(g_pModelCB);
     SAFE_RELEASE(g_pLightCB);
 
-    g_ShadowMapTransfer.Release();
+    for (unsigned int slot = 0; slot < AMD::TRANSFER_RING_MAX_SLOT_COUNT; slot++)
+    {
+        g_ShadowMapTransfer[slot].Release();
+    }
     g_ShadowMapSubregion.Release();
+    g_ShadowMapStatic.Release();
     g_ShadowMap.Release();
+    g_LightShadowMap.Release();
     g_ShadowMask.Release();
+    for (unsigned int mask = 0; mask < SHADOW_LIGHT_MASK_COUNT; mask++)
+    {
+        g_ShadowLightMask[mask].Release();
+    }
     g_AppDepth.Release();
     g_AppNormal.Release();
     g_LightDepth.Release();
@@ -1801,6 +4227,10 @@ void CALLBACK OnD3D11ReleasingSwapChain(void* pUserContext)
     g_DialogResourceManager.OnD3D11ReleasingSwapChain();
 
     g_ShadowMask.Release();
+    for (unsigned int mask = 0; mask < SHADOW_LIGHT_MASK_COUNT; mask++)
+    {
+        g_ShadowLightMask[mask].Release();
+    }
     g_AppDepth.Release();
     g_AppNormal.Release();
 }
@@ -66,6 +66,7 @@ void UpdateCrossfireUI(CROSSFIRE_UI_MODE uiMode)
 
     g_HUD.m_GUI.GetCheckBox(IDC_CHECKBOX_ENABLE_2_STEP_GPU_TRANSFER)->SetEnabled(enableSubmenu);
     g_HUD.m_GUI.GetCheckBox(IDC_CHECKBOX_DELAY_END_ALL_ACCESS)->SetEnabled(enableSubmenu);
+    g_HUD.m_GUI.GetCheckBox(IDC_CHECKBOX_ENABLE_ADAPTIVE_TRANSFER)->SetEnabled(enableSubmenu);
 }
 
 //--------------------------------------------------------------------------------------
@@ -121,8 +122,27 @@ void InitApplicationUI()
 
     g_HUD.m_GUI.AddCheckBox(IDC_CHECKBOX_ENABLE_2_STEP_GPU_TRANSFER, L"Enable 2 Step Transfer", AMD::HUD::iElementOffset, iY += AMD::HUD::iElementDelta, 140, 24, g_Enable2StepGpuTransfer);
     g_HUD.m_GUI.AddCheckBox(IDC_CHECKBOX_DELAY_END_ALL_ACCESS, L"Delay EndAllAccess()", AMD::HUD::iElementOffset, iY += AMD::HUD::iElementDelta, 140, 24, g_DelayEndAllAccess);
+    g_HUD.m_GUI.AddCheckBox(IDC_CHECKBOX_ENABLE_ADAPTIVE_TRANSFER, L"Adaptive Transfer Flag", AMD::HUD::iElementOffset, iY += AMD::HUD::iElementDelta, 140, 24, g_EnableAdaptiveTransfers);
 
     g_HUD.m_GUI.AddCheckBox(IDC_CHECKBOX_ENABLE_1_FACE_UPDATE_PER_FRAME, L"Single face / frame", AMD::HUD::iElementOffset, iY += AMD::HUD::iElementDelta, 140, 24, false);
+    g_HUD.m_GUI.AddCheckBox(IDC_CHECKBOX_ENABLE_PRIORITIZED_FACE_UPDATE, L"Prioritized faces / frame", AMD::HUD::iElementOffset, iY += AMD::HUD::iElementDelta, 140, 24, false);
+    g_HUD.m_GUI.AddCheckBox(IDC_CHECKBOX_ENABLE_AFFINE_FACE_UPDATE, L"GPU affine face / frame", AMD::HUD::iElementOffset, iY += AMD::HUD::iElementDelta, 140, 24, g_EnableAffineFaceUpdates);
+    g_HUD.m_GUI.AddCheckBox(IDC_CHECKBOX_SKIP_UNCHANGED_FACES, L"Skip unchanged faces", AMD::HUD::iElementOffset, iY += AMD::HUD::iElementDelta, 140, 24, g_SkipUnchangedFaces);
+    g_HUD.m_GUI.AddCheckBox(IDC_CHECKBOX_ENABLE_DYNAMIC_SHADOW_ATLAS, L"Dynamic shadow atlas", AMD::HUD::iElementOffset, iY += AMD::HUD::iElementDelta, 140, 24, g_EnableDynamicShadowAtlas);
+    g_HUD.m_GUI.AddCheckBox(IDC_CHECKBOX_ENABLE_CASTER_CULLING, L"Cull shadow casters", AMD::HUD::iElementOffset, iY += AMD::HUD::iElementDelta, 140, 24, g_EnableCasterCulling);
+    g_HUD.m_GUI.AddCheckBox(IDC_CHECKBOX_ENABLE_STATIC_SHADOW_CACHE, L"Cache static casters", AMD::HUD::iElementOffset, iY += AMD::HUD::iElementDelta, 140, 24, g_EnableStaticShadowCache);
+    g_pMaxAffineFaceAgeSlider = new AMD::Slider(g_HUD.m_GUI, IDC_SLIDER_MAX_AFFINE_FACE_AGE, iY, L"Max face age", 0, 4 * CUBE_FACE_COUNT, g_MaxAffineFaceAge);
+    g_pShadowLightCountSlider = new AMD::Slider(g_HUD.m_GUI, IDC_SLIDER_SHADOW_LIGHT_COUNT, iY, L"Spot lights", 0, SHADOW_LIGHT_MAX_COUNT, g_ShadowLightCount);
+    g_HUD.m_GUI.AddCheckBox(IDC_CHECKBOX_ENABLE_SHADOW_CASCADES, L"Cascaded sun light", AMD::HUD::iElementOffset, iY += AMD::HUD::iElementDelta, 140, 24,
+                            g_ShadowsExecution == AMD::SHADOWFX_EXECUTION_CASCADE);
+    g_pFarCascadeIntervalSlider = new AMD::Slider(g_HUD.m_GUI, IDC_SLIDER_FAR_CASCADE_INTERVAL, iY, L"Far cascade interval", 1, 32, g_FarCascadeInterval);
+    g_HUD.m_GUI.AddCheckBox(IDC_CHECKBOX_ENABLE_SINGLE_PASS_SHADOW_FACES, L"Single pass shadow faces", AMD::HUD::iElementOffset, iY += AMD::HUD::iElementDelta, 140, 24, g_EnableSinglePassShadowFaces);
+    g_HUD.m_GUI.AddCheckBox(IDC_CHECKBOX_ENABLE_STATE_CACHE, L"Filter redundant state", AMD::HUD::iElementOffset, iY += AMD::HUD::iElementDelta, 140, 24, g_EnableStateCache);
+    g_HUD.m_GUI.AddCheckBox(IDC_CHECKBOX_ENABLE_CONSTANT_RING, L"Constant buffer ring", AMD::HUD::iElementOffset, iY += AMD::HUD::iElementDelta, 140, 24, g_EnableConstantRing);
+    g_HUD.m_GUI.AddCheckBox(IDC_CHECKBOX_ENABLE_INSTANCED_LIGHT_VOLUMES, L"Instanced light volumes", AMD::HUD::iElementOffset, iY += AMD::HUD::iElementDelta, 140, 24, g_EnableInstancedLightVolumes);
+    g_HUD.m_GUI.AddCheckBox(IDC_CHECKBOX_ENABLE_INSTANCED_MESHES, L"Instanced meshes", AMD::HUD::iElementOffset, iY += AMD::HUD::iElementDelta, 140, 24, g_EnableInstancedMeshes);
+    g_HUD.m_GUI.AddCheckBox(IDC_CHECKBOX_ENABLE_DEFERRED_RECORDING, L"Record on worker threads", AMD::HUD::iElementOffset, iY += AMD::HUD::iElementDelta, 140, 24, g_EnableDeferredRecording);
+    g_pRecordThreadCountSlider = new AMD::Slider(g_HUD.m_GUI, IDC_SLIDER_RECORD_THREAD_COUNT, iY, L"Recording threads", 1, AMD::JOB_SYSTEM_MAX_WORKER_COUNT, g_RecordThreadCount);
 
 
     // Add the magnify tool UI to our HUD
@@ -187,12 +207,45 @@ void RenderText()
     g_pTxtHelper->DrawTextLine(szTemp);
     swprintf_s(szTemp, L"Effect cost in milliseconds (Scene Rendering = %.3f, Shadow Map Masking = %.3f)", g_SceneRendering, g_ShadowMapMasking);
     g_pTxtHelper->DrawTextLine(szTemp);
+    const AMD::StateCacheCounters & stateCounters = g_StateCache.GetCounters();
+    swprintf_s(szTemp, L"State calls per frame (Made = %llu, Sent = %llu, Avoided = %llu, Conflict Unbinds = %llu)",
+        stateCounters.calls, stateCounters.forwarded, stateCounters.avoided, stateCounters.unbinds);
+    g_pTxtHelper->DrawTextLine(szTemp);
+    if (g_pConstantRingCB == NULL)
+    {
+        swprintf_s(szTemp, L"Constant buffer ring : Not supported (D3D11.1 constant buffer offsets)");
+    }
+    else
+    {
+        swprintf_s(szTemp, L"Constant buffer ring : %u of %u KB used (Region %u of %u, Passes mapped per draw = %u)",
+            g_ConstantRing.GetUsed() / 1024, g_ConstantRing.GetRegionSize() / 1024,
+            g_ConstantRing.GetRegion(), g_ConstantRing.GetRegionCount(), g_ConstantRing.GetFailures());
+    }
+    g_pTxtHelper->DrawTextLine(szTemp);
+    if (g_pRecordContext[RECORD_JOB_COUNT - 1] == NULL)
+    {
+        swprintf_s(szTemp, L"Command recording : Not supported (deferred contexts)");
+    }
+    else
+    {
+        swprintf_s(szTemp, L"Command recording : %s (Threads = %u, CPU = %.3f ms)",
+            g_EnableDeferredRecording ? L"Worker threads" : L"Immediate context", g_JobSystem.GetWorkerCount(), g_CommandRecordingTime);
+    }
+    g_pTxtHelper->DrawTextLine(szTemp);
+    if (g_EnableAdaptiveTransfers == true && g_EnableCrossfireApiTransfers == true && g_agsGpuCount > 1)
+    {
+        // indexed by AGSAfrTransferType, the controller may also pick the flag the radio buttons don't offer
+        const WCHAR * transferFlagNames[] = { L"Default", L"Disable (every GPU renders the shadow maps)", L"1 Step", L"2 Step", L"2 Step Broadcast" };
+        swprintf_s(szTemp, L"Adaptive transfer flag : %s", transferFlagNames[g_ResourceCfxTransferFlag]);
+        g_pTxtHelper->DrawTextLine(szTemp);
+    }
 
-    g_pTxtHelper->SetInsertionPos(10, DXUTGetDXGIBackBufferSurfaceDesc()->Height - 120);
+    g_pTxtHelper->SetInsertionPos(10, DXUTGetDXGIBackBufferSurfaceDesc()->Height - 135);
     g_pTxtHelper->DrawTextLine(L"Switch to Camera Camera   : Press '9' \n"
                                L"Switch to Light Camera    : Press 'l' or 'L' \n"
                                L"Switch to Light Frustum   : Press {1 | 2 | 3 | 4 | 5 | 6} \n"
                                L"View Filtered Shadow (on / off) : Press 'm' or 'M' \n"
+                               L"Record Transfer Trace (on / off) : Press 't' or 'T' \n"
                                L"Toggle GUI                : F1\n");
 
     g_pTxtHelper->SetInsertionPos(DXUTGetDXGIBackBufferSurfaceDesc()->Width / 2 - 90, DXUTGetDXGIBackBufferSurfaceDesc()->Height - 40);
@@ -227,6 +280,18 @@ void CALLBACK OnKeyboard(UINT nChar, bool bKeyDown, bool bAltDown, void* pUserCo
             break;
         case '9': g_pCurrentCamera = &g_ViewerCamera;
             break;
+        case 'T': case 't':
+            if (g_TransferTrace.IsEnabled() == false) // start recording a new trace
+            {
+                g_TransferTrace.Reset();
+                g_TransferTrace.SetEnabled(true);
+            }
+            else // stop and save it, read it with tools/TransferTraceAnalyzer
+            {
+                g_TransferTrace.SetEnabled(false);
+                g_TransferTrace.Save("CrossfireAPI11.cfxtrace");
+            }
+            break;
 
         }
     }
@@ -257,6 +322,7 @@ void CALLBACK OnGUIEvent(UINT nEvent, int nControlID, CDXUTControl* pControl, vo
             g_ResourceCfxTransferFlag = AGS_AFR_TRANSFER_2STEP_WITH_BROADCAST;
         }
 
+        UpdateTransferFlags();
         InitTransferredResources(DXUTGetD3D11Device());
         break;
 
@@ -275,25 +341,134 @@ void CALLBACK OnGUIEvent(UINT nEvent, int nControlID, CDXUTControl* pControl, vo
         g_Enable2StepGpuTransfer = g_HUD.m_GUI.GetCheckBox(IDC_CHECKBOX_ENABLE_2_STEP_GPU_TRANSFER)->GetChecked();
         g_DelayEndAllAccess = g_HUD.m_GUI.GetCheckBox(IDC_CHECKBOX_DELAY_END_ALL_ACCESS)->GetChecked();
 
-        if (g_EnableCrossfireApiTransfers == false)
+        UpdateTransferFlags();
+        InitTransferredResources(DXUTGetD3D11Device());
+        break;
+
+    case IDC_CHECKBOX_ENABLE_ADAPTIVE_TRANSFER:
+        g_EnableAdaptiveTransfers = g_HUD.m_GUI.GetCheckBox(IDC_CHECKBOX_ENABLE_ADAPTIVE_TRANSFER)->GetChecked();
+
+        if (g_EnableAdaptiveTransfers == true) // start measuring from the flag selected in the UI
         {
-            g_ShadowMapCfxFlag = g_ShadowMapTransferCfxFlag = AGS_AFR_TRANSFER_DEFAULT;
+            AMD::TransferModeControllerDesc desc;
+            desc.m_InitialMode = g_ResourceCfxTransferFlag;
+            g_TransferModeController.Init(desc);
         }
-        else
+        break;
+
+    case IDC_CHECKBOX_ENABLE_1_FACE_UPDATE_PER_FRAME:
+    case IDC_CHECKBOX_ENABLE_PRIORITIZED_FACE_UPDATE:
+    case IDC_CHECKBOX_ENABLE_AFFINE_FACE_UPDATE:
+
+        if (((CDXUTCheckBox*)pControl)->GetChecked()) // the face update policies are exclusive
         {
-            if (g_Enable2StepGpuTransfer == true)
+            const int policyControlIDs[] = { IDC_CHECKBOX_ENABLE_1_FACE_UPDATE_PER_FRAME, IDC_CHECKBOX_ENABLE_PRIORITIZED_FACE_UPDATE, IDC_CHECKBOX_ENABLE_AFFINE_FACE_UPDATE };
+            for (unsigned int i = 0; i < AMD_ARRAY_SIZE(policyControlIDs); i++)
             {
-                g_ShadowMapCfxFlag = AGS_AFR_TRANSFER_DISABLE;
-                g_ShadowMapTransferCfxFlag = g_ResourceCfxTransferFlag;
+                if (policyControlIDs[i] != nControlID)
+                {
+                    g_HUD.m_GUI.GetCheckBox(policyControlIDs[i])->SetChecked(false);
+                }
             }
-            else
+        }
+
+        g_EnableAffineFaceUpdates = g_HUD.m_GUI.GetCheckBox(IDC_CHECKBOX_ENABLE_AFFINE_FACE_UPDATE)->GetChecked();
+
+        if (g_HUD.m_GUI.GetCheckBox(IDC_CHECKBOX_ENABLE_PRIORITIZED_FACE_UPDATE)->GetChecked())
+        {
+            g_ShadowFaceScheduler.Reset(); // don't trust faces rendered while the scheduler wasn't running
+        }
+        break;
+
+    case IDC_CHECKBOX_SKIP_UNCHANGED_FACES:
+        g_SkipUnchangedFaces = g_HUD.m_GUI.GetCheckBox(IDC_CHECKBOX_SKIP_UNCHANGED_FACES)->GetChecked();
+        break;
+
+    case IDC_CHECKBOX_ENABLE_DYNAMIC_SHADOW_ATLAS: // the regions are placed on the next frame, see UpdateShadowAtlasRegions
+        g_EnableDynamicShadowAtlas = g_HUD.m_GUI.GetCheckBox(IDC_CHECKBOX_ENABLE_DYNAMIC_SHADOW_ATLAS)->GetChecked();
+        break;
+
+    case IDC_CHECKBOX_ENABLE_CASTER_CULLING: // the faces whose casters change are rendered again, see SkipUnchangedCubeFaces
+        g_EnableCasterCulling = g_HUD.m_GUI.GetCheckBox(IDC_CHECKBOX_ENABLE_CASTER_CULLING)->GetChecked();
+        break;
+
+    case IDC_CHECKBOX_ENABLE_STATIC_SHADOW_CACHE: // creates or releases the static layer, every face is rendered again
+        g_EnableStaticShadowCache = g_HUD.m_GUI.GetCheckBox(IDC_CHECKBOX_ENABLE_STATIC_SHADOW_CACHE)->GetChecked();
+        InitTransferredResources(DXUTGetD3D11Device());
+        break;
+
+    case IDC_SLIDER_MAX_AFFINE_FACE_AGE:
+        g_pMaxAffineFaceAgeSlider->OnGuiEvent();
+        g_ShadowFaceAffinity.SetMaxAge((unsigned int)g_MaxAffineFaceAge);
+        break;
+
+    case IDC_SLIDER_SHADOW_LIGHT_COUNT: // the lights are placed again, see InitShadowLights
+        g_pShadowLightCountSlider->OnGuiEvent();
+        InitShadowLights();
+        break;
+
+    case IDC_CHECKBOX_ENABLE_SHADOW_CASCADES:
+        {
+            const bool enableCascades = g_HUD.m_GUI.GetCheckBox(IDC_CHECKBOX_ENABLE_SHADOW_CASCADES)->GetChecked();
+            g_ShadowsExecution = enableCascades ? AMD::SHADOWFX_EXECUTION_CASCADE : AMD::SHADOWFX_EXECUTION_CUBE;
+
+            // the cascades pick the faces they render themselves, see InitializeCascadeCamera
+            const int policyControlIDs[] = { IDC_CHECKBOX_ENABLE_1_FACE_UPDATE_PER_FRAME, IDC_CHECKBOX_ENABLE_PRIORITIZED_FACE_UPDATE, IDC_CHECKBOX_ENABLE_AFFINE_FACE_UPDATE };
+            for (unsigned int i = 0; i < AMD_ARRAY_SIZE(policyControlIDs); i++)
+            {
+                if (enableCascades == true)
+                {
+                    g_HUD.m_GUI.GetCheckBox(policyControlIDs[i])->SetChecked(false);
+                }
+                g_HUD.m_GUI.GetCheckBox(policyControlIDs[i])->SetEnabled(enableCascades == false);
+            }
+            g_EnableAffineFaceUpdates = false;
+
+            if (enableCascades == false) // back to the cube around the light camera
             {
-                g_ShadowMapCfxFlag = g_ResourceCfxTransferFlag;
-                g_ShadowMapTransferCfxFlag = AGS_AFR_TRANSFER_DISABLE;
+                InitializeCubeCamera(&g_LightCamera, g_CubeCamera, g_LightData);
             }
+            InitShadowCascades(); // every cascade is fit again on the next frame
         }
+        break;
 
-        InitTransferredResources(DXUTGetD3D11Device());
+    case IDC_SLIDER_FAR_CASCADE_INTERVAL:
+        g_pFarCascadeIntervalSlider->OnGuiEvent();
+        InitShadowCascades();
+        break;
+
+    case IDC_CHECKBOX_ENABLE_SINGLE_PASS_SHADOW_FACES: // the faces are the same, only the draws that produce them differ
+        g_EnableSinglePassShadowFaces = g_HUD.m_GUI.GetCheckBox(IDC_CHECKBOX_ENABLE_SINGLE_PASS_SHADOW_FACES)->GetChecked();
+        break;
+
+    case IDC_CHECKBOX_ENABLE_STATE_CACHE: // disabled, every state call goes to the context
+        g_EnableStateCache = g_HUD.m_GUI.GetCheckBox(IDC_CHECKBOX_ENABLE_STATE_CACHE)->GetChecked();
+        g_StateCache.SetEnabled(g_EnableStateCache);
+        for (unsigned int job = 0; job < RECORD_JOB_COUNT; job++)
+        {
+            g_RecordStateCache[job].SetEnabled(g_EnableStateCache);
+        }
+        break;
+
+    case IDC_CHECKBOX_ENABLE_CONSTANT_RING: // disabled, every draw maps its own constant buffer
+        g_EnableConstantRing = g_HUD.m_GUI.GetCheckBox(IDC_CHECKBOX_ENABLE_CONSTANT_RING)->GetChecked();
+        break;
+
+    case IDC_CHECKBOX_ENABLE_INSTANCED_LIGHT_VOLUMES: // disabled, a draw per light volume
+        g_EnableInstancedLightVolumes = g_HUD.m_GUI.GetCheckBox(IDC_CHECKBOX_ENABLE_INSTANCED_LIGHT_VOLUMES)->GetChecked();
+        break;
+
+    case IDC_CHECKBOX_ENABLE_INSTANCED_MESHES: // disabled, a draw per instance
+        g_EnableInstancedMeshes = g_HUD.m_GUI.GetCheckBox(IDC_CHECKBOX_ENABLE_INSTANCED_MESHES)->GetChecked();
+        break;
+
+    case IDC_CHECKBOX_ENABLE_DEFERRED_RECORDING: // disabled, every pass is rendered on the immediate context
+        g_EnableDeferredRecording = g_HUD.m_GUI.GetCheckBox(IDC_CHECKBOX_ENABLE_DEFERRED_RECORDING)->GetChecked();
+        break;
+
+    case IDC_SLIDER_RECORD_THREAD_COUNT: // the workers are started again
+        g_pRecordThreadCountSlider->OnGuiEvent();
+        g_JobSystem.Init((unsigned int)g_RecordThreadCount);
         break;
 
 
@@ -340,3 +515,57 @@ void CALLBACK OnGUIEvent(UINT nEvent, int nControlID, CDXUTControl* pControl, vo
     // Call the MagnifyTool gui event handler
     g_MagnifyTool.OnGUIEvent(nEvent, nControlID, pControl, pUserContext);
 }
+
+//--------------------------------------------------------------------------------------
+// Sets the controls and the globals to a configuration of the benchmark sweep, the way
+// the handlers above do it, and creates the transferred resources once for all of them
+//--------------------------------------------------------------------------------------
+void SetBenchmarkSweepConfig(const AMD::BenchmarkSweepConfig & config)
+{
+    g_ShadowTextureType = config.m_ShadowTextureType == 0 ? AMD::SHADOWFX_TEXTURE_2D : AMD::SHADOWFX_TEXTURE_2D_ARRAY;
+    g_HUD.m_GUI.GetRadioButton(g_ShadowTextureType == AMD::SHADOWFX_TEXTURE_2D ? IDC_RADIO_SHADOW_MAP_T2D : IDC_RADIO_SHADOW_MAP_T2DA)->SetChecked(true);
+
+    // AGS_AFR_TRANSFER_DEFAULT is the driver tracking, without the Crossfire API
+    g_EnableCrossfireApiTransfers = config.m_TransferType != AGS_AFR_TRANSFER_DEFAULT;
+    g_HUD.m_GUI.GetCheckBox(IDC_CHECKBOX_ENABLE_CROSSFIRE_API)->SetChecked(g_EnableCrossfireApiTransfers);
+    if (g_EnableCrossfireApiTransfers == true)
+    {
+        g_ResourceCfxTransferFlag = (AGSAfrTransferType)config.m_TransferType;
+    }
+
+    const int transferControlIDs[] = { IDC_RADIO_TRANSFER_FLAG_1STEP, IDC_RADIO_TRANSFER_FLAG_2STEP, IDC_RADIO_TRANSFER_FLAG_2STEP_BROADCAST };
+    const AGSAfrTransferType transferFlags[] = { AGS_AFR_TRANSFER_1STEP_P2P, AGS_AFR_TRANSFER_2STEP_NO_BROADCAST, AGS_AFR_TRANSFER_2STEP_WITH_BROADCAST };
+    for (unsigned int i = 0; i < AMD_ARRAY_SIZE(transferControlIDs); i++)
+    {
+        g_HUD.m_GUI.GetRadioButton(transferControlIDs[i])->SetChecked(g_ResourceCfxTransferFlag == transferFlags[i], false);
+    }
+
+    g_Enable2StepGpuTransfer = config.m_Enable2StepGpuTransfer;
+    g_DelayEndAllAccess = config.m_DelayEndAllAccess;
+    g_HUD.m_GUI.GetCheckBox(IDC_CHECKBOX_ENABLE_2_STEP_GPU_TRANSFER)->SetChecked(g_Enable2StepGpuTransfer);
+    g_HUD.m_GUI.GetCheckBox(IDC_CHECKBOX_DELAY_END_ALL_ACCESS)->SetChecked(g_DelayEndAllAccess);
+
+    // the face update policies are exclusive
+    g_HUD.m_GUI.GetCheckBox(IDC_CHECKBOX_ENABLE_1_FACE_UPDATE_PER_FRAME)->SetChecked(config.m_SingleFacePerFrame);
+    g_HUD.m_GUI.GetCheckBox(IDC_CHECKBOX_ENABLE_PRIORITIZED_FACE_UPDATE)->SetChecked(false);
+    g_HUD.m_GUI.GetCheckBox(IDC_CHECKBOX_ENABLE_AFFINE_FACE_UPDATE)->SetChecked(false);
+    g_EnableAffineFaceUpdates = false;
+
+    g_ShadowMapSize = (float)config.m_ShadowMapSize;
+    for (int light = 0; light < CUBE_FACE_COUNT; light++)
+    {
+        g_LightData[light].m_BackBufferDim = float2(g_ShadowMapSize, g_ShadowMapSize);
+        g_LightData[light].m_BackBufferDimRcp = float2(1.0f / g_ShadowMapSize, 1.0f / g_ShadowMapSize);
+    }
+
+    for (UINT item = 0; item < g_HUD.m_GUI.GetComboBox(IDC_COMBOBOX_SHADOWMAP_SIZE)->GetNumItems(); item++)
+    {
+        if ((1u << (item + 9)) == config.m_ShadowMapSize)
+        {
+            g_HUD.m_GUI.GetComboBox(IDC_COMBOBOX_SHADOWMAP_SIZE)->SetSelectedByIndex(item);
+        }
+    }
+
+    UpdateTransferFlags();
+    InitTransferredResources(DXUTGetD3D11Device());
+}
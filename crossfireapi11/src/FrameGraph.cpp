@@ -0,0 +1,258 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: FrameGraph.cpp
+//
+// A small frame graph that places the Crossfire API notifications of a frame.
+//--------------------------------------------------------------------------------------
+#include "FrameGraph.h"
+
+#include <stddef.h>
+
+namespace AMD
+{
+    FrameGraph::FrameGraph()
+        : m_EndFrameStep(0)
+        , m_DelayEndAllAccess(false)
+        , m_Valid(false)
+        , m_pNotify(NULL)
+        , m_pNotifyUserData(NULL)
+    {
+    }
+
+    void FrameGraph::SetNotifier(FrameGraphNotifyFunction pNotify, void * pUserData)
+    {
+        m_pNotify = pNotify;
+        m_pNotifyUserData = pUserData;
+    }
+
+    void FrameGraph::Reset()
+    {
+        m_Resources.clear();
+        m_Passes.clear();
+        m_Accesses.clear();
+        m_Steps.clear();
+        m_EndFrameStep = 0;
+        m_Valid = false;
+    }
+
+    unsigned int FrameGraph::AddResource(const char * name, unsigned int flags, void * pUserData)
+    {
+        Resource resource;
+        resource.m_Name = name;
+        resource.m_Flags = flags;
+        resource.m_pUserData = pUserData;
+        resource.m_FirstAccess = resource.m_LastAccess = resource.m_LastWrite = FRAME_GRAPH_INVALID_INDEX;
+
+        if (flags & FRAME_GRAPH_RESOURCE_TRANSFERRED) { resource.m_Flags |= FRAME_GRAPH_RESOURCE_PERSISTENT; }
+
+        m_Resources.push_back(resource);
+        return (unsigned int)m_Resources.size() - 1;
+    }
+
+    unsigned int FrameGraph::AddPass(const char * name)
+    {
+        Pass pass;
+        pass.m_Name = name;
+        pass.m_Culled = false;
+        pass.m_FirstStep = pass.m_PassStep = pass.m_LastStep = 0;
+
+        m_Passes.push_back(pass);
+        return (unsigned int)m_Passes.size() - 1;
+    }
+
+    void FrameGraph::Read(unsigned int pass, unsigned int resource)
+    {
+        Access access = { pass, resource, false };
+        m_Accesses.push_back(access);
+    }
+
+    void FrameGraph::Write(unsigned int pass, unsigned int resource)
+    {
+        Access access = { pass, resource, true };
+        m_Accesses.push_back(access);
+    }
+
+    void FrameGraph::AddStep(FRAME_GRAPH_STEP_TYPE type, unsigned int index)
+    {
+        FrameGraphStep step = { type, index };
+        m_Steps.push_back(step);
+    }
+
+    bool FrameGraph::Compile()
+    {
+        m_Steps.clear();
+        m_Valid = false;
+
+        for (size_t i = 0; i < m_Accesses.size(); i++)
+        {
+            if (m_Accesses[i].m_Pass >= m_Passes.size() || m_Accesses[i].m_Resource >= m_Resources.size())
+            {
+                return false;
+            }
+        }
+
+        // walk the passes backwards: a pass is kept if it writes something persistent or read by a kept pass after it,
+        // and then what it reads is needed too (writes are assumed to be partial, so an earlier writer is never dead)
+        std::vector<bool> needed(m_Resources.size());
+        for (size_t r = 0; r < m_Resources.size(); r++)
+        {
+            needed[r] = (m_Resources[r].m_Flags & FRAME_GRAPH_RESOURCE_PERSISTENT) != 0;
+        }
+
+        for (size_t p = m_Passes.size(); p > 0; p--)
+        {
+            const unsigned int pass = (unsigned int)(p - 1);
+
+            bool kept = false;
+            for (size_t i = 0; i < m_Accesses.size() && kept == false; i++)
+            {
+                kept = m_Accesses[i].m_Pass == pass && m_Accesses[i].m_Write == true && needed[m_Accesses[i].m_Resource] == true;
+            }
+
+            m_Passes[pass].m_Culled = (kept == false);
+
+            if (kept == true)
+            {
+                for (size_t i = 0; i < m_Accesses.size(); i++)
+                {
+                    if (m_Accesses[i].m_Pass == pass && m_Accesses[i].m_Write == false) { needed[m_Accesses[i].m_Resource] = true; }
+                }
+            }
+        }
+
+        for (size_t r = 0; r < m_Resources.size(); r++)
+        {
+            Resource & resource = m_Resources[r];
+            resource.m_FirstAccess = resource.m_LastAccess = resource.m_LastWrite = FRAME_GRAPH_INVALID_INDEX;
+        }
+
+        for (size_t i = 0; i < m_Accesses.size(); i++)
+        {
+            const Access & access = m_Accesses[i];
+            if (m_Passes[access.m_Pass].m_Culled == true) { continue; }
+
+            Resource & resource = m_Resources[access.m_Resource];
+            if (resource.m_FirstAccess == FRAME_GRAPH_INVALID_INDEX || access.m_Pass < resource.m_FirstAccess) { resource.m_FirstAccess = access.m_Pass; }
+            if (resource.m_LastAccess == FRAME_GRAPH_INVALID_INDEX || access.m_Pass > resource.m_LastAccess) { resource.m_LastAccess = access.m_Pass; }
+            if (access.m_Write == true && (resource.m_LastWrite == FRAME_GRAPH_INVALID_INDEX || access.m_Pass > resource.m_LastWrite)) { resource.m_LastWrite = access.m_Pass; }
+        }
+
+        for (unsigned int pass = 0; pass < (unsigned int)m_Passes.size(); pass++)
+        {
+            Pass & p = m_Passes[pass];
+            p.m_FirstStep = (unsigned int)m_Steps.size();
+
+            if (p.m_Culled == true)
+            {
+                p.m_PassStep = p.m_LastStep = p.m_FirstStep;
+                continue;
+            }
+
+            for (unsigned int r = 0; r < (unsigned int)m_Resources.size(); r++)
+            {
+                const Resource & resource = m_Resources[r];
+                if ((resource.m_Flags & FRAME_GRAPH_RESOURCE_TRANSFERRED) && resource.m_FirstAccess == pass) { AddStep(FRAME_GRAPH_STEP_BEGIN_ALL_ACCESS, r); }
+            }
+
+            p.m_PassStep = (unsigned int)m_Steps.size();
+            AddStep(FRAME_GRAPH_STEP_PASS, pass);
+
+            // EndWrites as early as possible so that the transfer can overlap the rest of the frame
+            for (unsigned int r = 0; r < (unsigned int)m_Resources.size(); r++)
+            {
+                const Resource & resource = m_Resources[r];
+                if ((resource.m_Flags & FRAME_GRAPH_RESOURCE_TRANSFERRED) && resource.m_LastWrite == pass) { AddStep(FRAME_GRAPH_STEP_END_WRITES, r); }
+            }
+
+            // EndAllAccess right after the last reader, so that the next GPU doesn't wait for the end of the frame
+            for (unsigned int r = 0; r < (unsigned int)m_Resources.size() && m_DelayEndAllAccess == false; r++)
+            {
+                const Resource & resource = m_Resources[r];
+                if ((resource.m_Flags & FRAME_GRAPH_RESOURCE_TRANSFERRED) && resource.m_LastAccess == pass) { AddStep(FRAME_GRAPH_STEP_END_ALL_ACCESS, r); }
+            }
+
+            p.m_LastStep = (unsigned int)m_Steps.size();
+        }
+
+        m_EndFrameStep = (unsigned int)m_Steps.size();
+
+        for (unsigned int r = 0; r < (unsigned int)m_Resources.size() && m_DelayEndAllAccess == true; r++)
+        {
+            const Resource & resource = m_Resources[r];
+            if ((resource.m_Flags & FRAME_GRAPH_RESOURCE_TRANSFERRED) && resource.m_LastAccess != FRAME_GRAPH_INVALID_INDEX) { AddStep(FRAME_GRAPH_STEP_END_ALL_ACCESS, r); }
+        }
+
+        m_Valid = true;
+        return true;
+    }
+
+    void FrameGraph::Notify(unsigned int firstStep, unsigned int lastStep)
+    {
+        for (unsigned int i = firstStep; i < lastStep && i < (unsigned int)m_Steps.size(); i++)
+        {
+            const FrameGraphStep & step = m_Steps[i];
+            if (step.m_Type != FRAME_GRAPH_STEP_PASS && m_pNotify != NULL)
+            {
+                m_pNotify(step.m_Type, step.m_Index, m_Resources[step.m_Index].m_pUserData, m_pNotifyUserData);
+            }
+        }
+    }
+
+    bool FrameGraph::BeginPass(unsigned int pass)
+    {
+        if (m_Valid == false || pass >= m_Passes.size() || m_Passes[pass].m_Culled == true) { return false; }
+
+        Notify(m_Passes[pass].m_FirstStep, m_Passes[pass].m_PassStep);
+        return true;
+    }
+
+    void FrameGraph::EndPass(unsigned int pass)
+    {
+        if (m_Valid == false || pass >= m_Passes.size() || m_Passes[pass].m_Culled == true) { return; }
+
+        Notify(m_Passes[pass].m_PassStep + 1, m_Passes[pass].m_LastStep);
+    }
+
+    void FrameGraph::EndFrame()
+    {
+        if (m_Valid == false) { return; }
+
+        Notify(m_EndFrameStep, (unsigned int)m_Steps.size());
+    }
+
+    bool FrameGraph::IsCulled(unsigned int pass) const
+    {
+        return pass < m_Passes.size() ? m_Passes[pass].m_Culled : true;
+    }
+
+    const char * FrameGraph::GetPassName(unsigned int pass) const
+    {
+        return pass < m_Passes.size() && m_Passes[pass].m_Name != NULL ? m_Passes[pass].m_Name : "";
+    }
+
+    const char * FrameGraph::GetResourceName(unsigned int resource) const
+    {
+        return resource < m_Resources.size() && m_Resources[resource].m_Name != NULL ? m_Resources[resource].m_Name : "";
+    }
+}
@@ -0,0 +1,154 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: FrameGraph.h
+//
+// A small frame graph that places the Crossfire API notifications of a frame.
+//
+// Every frame the application declares its resources and, in execution order, its
+// passes with the resources they read and write. Compile() then:
+//     - culls the passes whose writes are never read by a kept pass, and don't go to a
+//       persistent resource (the back buffer, or anything read in a later frame)
+//     - for every transferred resource, schedules BeginAllAccess right before its first
+//       access, EndWrites right after its last writer, and EndAllAccess right after its
+//       last access (or at the end of the frame when EndAllAccess is delayed)
+//
+// The application keeps its rendering code in place and brackets every pass with
+// BeginPass() / EndPass(), which issue the scheduled notifications through the
+// notifier and tell whether the pass was culled; EndFrame() issues what is left.
+//
+// This code has no dependency on Windows, D3D11 or AGS, so the schedule can be built
+// and inspected without a GPU.
+//--------------------------------------------------------------------------------------
+#ifndef FRAME_GRAPH_H
+#define FRAME_GRAPH_H
+
+#include <vector>
+
+namespace AMD
+{
+    static const unsigned int FRAME_GRAPH_INVALID_INDEX = 0xffffffff;
+
+    typedef enum FRAME_GRAPH_RESOURCE_FLAG_t
+    {
+        FRAME_GRAPH_RESOURCE_PERSISTENT  = 0x1,      // read after the frame: writes to it are never culled
+        FRAME_GRAPH_RESOURCE_TRANSFERRED = 0x2,      // notified to the driver, implies persistent
+    } FRAME_GRAPH_RESOURCE_FLAG;
+
+    typedef enum FRAME_GRAPH_STEP_TYPE_t
+    {
+        FRAME_GRAPH_STEP_PASS,
+        FRAME_GRAPH_STEP_BEGIN_ALL_ACCESS,
+        FRAME_GRAPH_STEP_END_WRITES,
+        FRAME_GRAPH_STEP_END_ALL_ACCESS,
+
+        FRAME_GRAPH_STEP_COUNT,
+    } FRAME_GRAPH_STEP_TYPE;
+
+    struct FrameGraphStep
+    {
+        FRAME_GRAPH_STEP_TYPE m_Type;
+        unsigned int          m_Index;              // pass for FRAME_GRAPH_STEP_PASS, resource otherwise
+    };
+
+    // called by BeginPass / EndPass / EndFrame for the notification steps
+    typedef void (*FrameGraphNotifyFunction)(FRAME_GRAPH_STEP_TYPE type, unsigned int resource, void * pResourceUserData, void * pUserData);
+
+    class FrameGraph
+    {
+    public:
+        FrameGraph();
+
+        void         SetNotifier(FrameGraphNotifyFunction pNotify, void * pUserData);
+
+        // clears the declarations of the previous frame, keeps the allocations
+        void         Reset();
+
+        unsigned int AddResource(const char * name, unsigned int flags, void * pUserData);
+        unsigned int AddPass(const char * name);
+        void         Read(unsigned int pass, unsigned int resource);
+        void         Write(unsigned int pass, unsigned int resource);
+
+        void         SetDelayEndAllAccess(bool delay) { m_DelayEndAllAccess = delay; }
+
+        // returns false if a declaration referenced an unknown pass or resource
+        bool         Compile();
+
+        // issue the notifications scheduled around a pass; BeginPass returns false if the pass was culled
+        bool         BeginPass(unsigned int pass);
+        void         EndPass(unsigned int pass);
+        void         EndFrame();
+
+        bool         IsCulled(unsigned int pass) const;
+        unsigned int GetPassCount() const { return (unsigned int)m_Passes.size(); }
+        unsigned int GetResourceCount() const { return (unsigned int)m_Resources.size(); }
+        const char * GetPassName(unsigned int pass) const;
+        const char * GetResourceName(unsigned int resource) const;
+
+        // the whole frame in order: kept passes and the notifications around them
+        const std::vector<FrameGraphStep> & GetSteps() const { return m_Steps; }
+
+    private:
+        struct Resource
+        {
+            const char * m_Name;
+            unsigned int m_Flags;
+            void *       m_pUserData;
+            unsigned int m_FirstAccess;             // kept passes only, FRAME_GRAPH_INVALID_INDEX if none
+            unsigned int m_LastAccess;
+            unsigned int m_LastWrite;
+        };
+
+        struct Access
+        {
+            unsigned int m_Pass;
+            unsigned int m_Resource;
+            bool         m_Write;
+        };
+
+        struct Pass
+        {
+            const char * m_Name;
+            bool         m_Culled;
+            unsigned int m_FirstStep;               // steps issued by BeginPass start here
+            unsigned int m_PassStep;                // the FRAME_GRAPH_STEP_PASS step of this pass
+            unsigned int m_LastStep;                // steps issued by EndPass end before this one
+        };
+
+        void         AddStep(FRAME_GRAPH_STEP_TYPE type, unsigned int index);
+        void         Notify(unsigned int firstStep, unsigned int lastStep);
+
+        std::vector<Resource>       m_Resources;
+        std::vector<Pass>           m_Passes;
+        std::vector<Access>         m_Accesses;
+        std::vector<FrameGraphStep> m_Steps;
+        unsigned int                m_EndFrameStep; // steps issued by EndFrame start here
+        bool                        m_DelayEndAllAccess;
+        bool                        m_Valid;
+
+        FrameGraphNotifyFunction    m_pNotify;
+        void *                      m_pNotifyUserData;
+    };
+}
+
+#endif // FRAME_GRAPH_H
@@ -0,0 +1,76 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//--------------------------------------------------------------------------------------
+// File: InstanceBatcher.cpp
+//
+// Groups instances by mesh for instanced draws.
+//--------------------------------------------------------------------------------------
+#include "InstanceBatcher.h"
+
+namespace AMD
+{
+    InstanceBatcher::InstanceBatcher()
+    {
+    }
+
+    unsigned int InstanceBatcher::Build(const unsigned int * pInstances, unsigned int instanceCount,
+                                        const unsigned int * pInstanceMesh, unsigned int meshCount)
+    {
+        m_MeshStart.assign(meshCount + 1, 0);
+        m_Instances.resize(instanceCount);
+        m_Batches.clear();
+
+        // count the instances of every mesh, then turn the counts into the first instance of every mesh
+        for (unsigned int i = 0; i < instanceCount; i++)
+        {
+            m_MeshStart[pInstanceMesh[pInstances[i]] + 1]++;
+        }
+        for (unsigned int mesh = 0; mesh < meshCount; mesh++)
+        {
+            const unsigned int count = m_MeshStart[mesh + 1];
+            m_MeshStart[mesh + 1] = m_MeshStart[mesh] + count;
+
+            if (count > 0)
+            {
+                const InstanceBatch batch = { mesh, m_MeshStart[mesh], count };
+                m_Batches.push_back(batch);
+            }
+        }
+
+        for (unsigned int i = 0; i < instanceCount; i++)
+        {
+            m_Instances[m_MeshStart[pInstanceMesh[pInstances[i]]]++] = pInstances[i];
+        }
+
+        return (unsigned int)m_Batches.size();
+    }
+
+    unsigned int InstanceBatcher::GetDrawCount(const unsigned int * pSubsetCounts) const
+    {
+        unsigned int count = 0;
+        for (unsigned int batch = 0; batch < m_Batches.size(); batch++)
+        {
+            count += pSubsetCounts[m_Batches[batch].m_Mesh];
+        }
+        return count;
+    }
+}
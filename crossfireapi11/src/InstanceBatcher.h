@@ -0,0 +1,75 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//--------------------------------------------------------------------------------------
+// File: InstanceBatcher.h
+//
+// Groups the instances a pass draws by mesh, so that every group is drawn with one
+// DrawIndexedInstanced per subset of its mesh instead of one draw per instance and
+// subset. The instances of a group are contiguous in GetInstance() order, which is the
+// order their per-instance data is written in; a group starts at its m_FirstInstance.
+//
+// Groups come in increasing mesh order and keep the order of the instances within a
+// mesh, and a counting sort builds them in one pass over the instances.
+//
+// This code has no dependency on Windows, D3D11 or AGS.
+//--------------------------------------------------------------------------------------
+#ifndef INSTANCE_BATCHER_H
+#define INSTANCE_BATCHER_H
+
+#include <vector>
+
+namespace AMD
+{
+    struct InstanceBatch
+    {
+        unsigned int m_Mesh;
+        unsigned int m_FirstInstance;       // index of its first instance in GetInstance() order
+        unsigned int m_InstanceCount;
+    };
+
+    class InstanceBatcher
+    {
+    public:
+        InstanceBatcher();
+
+        // pInstances are indices into pInstanceMesh, the mesh of every instance of the scene,
+        // each mesh below meshCount; returns the number of batches
+        unsigned int         Build(const unsigned int * pInstances, unsigned int instanceCount,
+                                   const unsigned int * pInstanceMesh, unsigned int meshCount);
+
+        unsigned int         GetBatchCount() const { return (unsigned int)m_Batches.size(); }
+        const InstanceBatch & GetBatch(unsigned int batch) const { return m_Batches[batch]; }
+
+        unsigned int         GetInstanceCount() const { return (unsigned int)m_Instances.size(); }
+        unsigned int         GetInstance(unsigned int i) const { return m_Instances[i]; }
+
+        // the draws of the batches, pSubsetCounts holding the subset count of every mesh
+        unsigned int         GetDrawCount(const unsigned int * pSubsetCounts) const;
+
+    private:
+        std::vector<unsigned int>  m_MeshStart;   // first instance of every mesh, then where the next one goes
+        std::vector<unsigned int>  m_Instances;
+        std::vector<InstanceBatch> m_Batches;
+    };
+}
+
+#endif // INSTANCE_BATCHER_H
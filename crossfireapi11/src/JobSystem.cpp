@@ -0,0 +1,158 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//--------------------------------------------------------------------------------------
+// File: JobSystem.cpp
+//
+// A small pool of worker threads that runs a batch of independent jobs and waits for them.
+//--------------------------------------------------------------------------------------
+#include "JobSystem.h"
+
+namespace AMD
+{
+    JobSystem::JobSystem() :
+        m_WorkerCount(1),
+        m_Generation(0),
+        m_Pending(0),
+        m_Quit(false),
+        m_pFunction(nullptr),
+        m_pUserData(nullptr),
+        m_Count(0),
+        m_Next(0)
+    {
+    }
+
+    JobSystem::~JobSystem()
+    {
+        Release();
+    }
+
+    void JobSystem::Init(unsigned int threadCount)
+    {
+        Release();
+
+        m_WorkerCount = threadCount < 1 ? 1 : (threadCount > JOB_SYSTEM_MAX_WORKER_COUNT ? JOB_SYSTEM_MAX_WORKER_COUNT : threadCount);
+        m_Quit = false;
+
+        for (unsigned int i = 1; i < m_WorkerCount; i++)
+        {
+            m_Thread[i] = std::thread(&JobSystem::WorkerMain, this, i);
+        }
+    }
+
+    void JobSystem::Release()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_Quit = true;
+        }
+        m_Start.notify_all();
+
+        for (unsigned int i = 1; i < m_WorkerCount; i++)
+        {
+            if (m_Thread[i].joinable() == true)
+            {
+                m_Thread[i].join();
+            }
+        }
+
+        m_WorkerCount = 1;
+    }
+
+    void JobSystem::Run(unsigned int count, JobFunction pFunction, void* pUserData)
+    {
+        if (count == 0 || pFunction == nullptr)
+        {
+            return;
+        }
+
+        if (m_WorkerCount == 1 || count == 1)
+        {
+            for (unsigned int i = 0; i < count; i++)
+            {
+                pFunction(i, 0, pUserData);
+            }
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_Mutex);
+            m_pFunction = pFunction;
+            m_pUserData = pUserData;
+            m_Count = count;
+            m_Next.store(0);
+            m_Pending = m_WorkerCount - 1;
+            m_Generation++;
+        }
+        m_Start.notify_all();
+
+        Work(0);
+
+        // every worker takes part in every batch, even if it wakes up after the last job was
+        // handed out; so none of them can still look at this batch when the next one starts
+        std::unique_lock<std::mutex> lock(m_Mutex);
+        m_Done.wait(lock, [this] { return m_Pending == 0; });
+        m_pFunction = nullptr;
+        m_pUserData = nullptr;
+    }
+
+    void JobSystem::WorkerMain(unsigned int worker)
+    {
+        unsigned int generation = 0;
+
+        for (;;)
+        {
+            {
+                std::unique_lock<std::mutex> lock(m_Mutex);
+                m_Start.wait(lock, [this, generation] { return m_Quit == true || m_Generation != generation; });
+                if (m_Quit == true)
+                {
+                    return;
+                }
+                generation = m_Generation;
+            }
+
+            Work(worker);
+
+            {
+                std::lock_guard<std::mutex> lock(m_Mutex);
+                m_Pending--;
+                if (m_Pending == 0)
+                {
+                    m_Done.notify_all();
+                }
+            }
+        }
+    }
+
+    void JobSystem::Work(unsigned int worker)
+    {
+        for (;;)
+        {
+            const unsigned int job = m_Next.fetch_add(1);
+            if (job >= m_Count)
+            {
+                return;
+            }
+            m_pFunction(job, worker, m_pUserData);
+        }
+    }
+}
@@ -0,0 +1,92 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//--------------------------------------------------------------------------------------
+// File: JobSystem.h
+//
+// A small pool of worker threads that runs a batch of independent jobs and waits for them.
+//
+// The thread that calls Run works on the batch too, so a pool made for N threads spawns
+// N - 1 and Run(count) with N == 1 simply calls the jobs in order on the calling thread.
+// Jobs are handed out one at a time from a shared counter, so a slow job doesn't hold back
+// the others. Every job of a batch runs exactly once, and Run returns only when all of them
+// have finished, so a job may write results that the caller reads after Run.
+//
+// The worker index passed to a job is in [0, GetWorkerCount()) and is unique among the
+// jobs running at the same time; the calling thread is worker 0. It lets a job use
+// per-thread resources, e.g. scratch memory, without locking.
+//
+// This code has no dependency on Windows, D3D11 or AGS.
+//--------------------------------------------------------------------------------------
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+namespace AMD
+{
+    static const unsigned int JOB_SYSTEM_MAX_WORKER_COUNT = 16;
+
+    class JobSystem
+    {
+    public:
+        typedef void (*JobFunction)(unsigned int job, unsigned int worker, void* pUserData);
+
+        JobSystem();
+        ~JobSystem();
+
+        // threadCount is clamped to [1, JOB_SYSTEM_MAX_WORKER_COUNT]; releases the old threads first
+        void         Init(unsigned int threadCount);
+        void         Release();
+
+        unsigned int GetWorkerCount() const { return m_WorkerCount; }
+
+        // calls pFunction(job, worker, pUserData) for every job in [0, count), returns when all are done
+        void         Run(unsigned int count, JobFunction pFunction, void* pUserData);
+
+    private:
+        JobSystem(const JobSystem &);
+        JobSystem & operator=(const JobSystem &);
+
+        void         WorkerMain(unsigned int worker);
+        void         Work(unsigned int worker);
+
+        std::thread                 m_Thread[JOB_SYSTEM_MAX_WORKER_COUNT];
+        unsigned int                m_WorkerCount;      // including the thread that calls Run
+
+        std::mutex                  m_Mutex;
+        std::condition_variable     m_Start;            // a batch is ready, or the pool shuts down
+        std::condition_variable     m_Done;             // the last worker finished its part of the batch
+        unsigned int                m_Generation;       // of the current batch, guarded by m_Mutex
+        unsigned int                m_Pending;          // workers yet to finish the batch, guarded by m_Mutex
+        bool                        m_Quit;             // guarded by m_Mutex
+
+        JobFunction                 m_pFunction;
+        void*                       m_pUserData;
+        unsigned int                m_Count;
+        std::atomic<unsigned int>   m_Next;             // next job to hand out
+    };
+}
+
+#endif // JOB_SYSTEM_H
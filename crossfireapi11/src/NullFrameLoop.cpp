@@ -0,0 +1,339 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//--------------------------------------------------------------------------------------
+// File: NullFrameLoop.cpp
+//
+// The frame loop of the sample against a null render backend.
+//--------------------------------------------------------------------------------------
+#include "NullFrameLoop.h"
+
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _MSC_VER
+#pragma warning( disable : 4996 ) // sprintf is fine for this use
+#endif
+
+namespace AMD
+{
+    // the camera and the culling face of the viewer, after those of the cube faces
+    static const unsigned int NULL_FRAME_LOOP_VIEWER = CAMERA_CUBE_FACE_COUNT;
+
+    static const float NULL_FRAME_LOOP_PI = 3.14159265f;
+
+    static void Normalize(float * v)
+    {
+        const float length = sqrtf(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+        const float scale = length > 0.0f ? 1.0f / length : 0.0f;
+        v[0] *= scale; v[1] *= scale; v[2] *= scale;
+    }
+
+    static void Cross(const float * a, const float * b, float * c)
+    {
+        c[0] = a[1] * b[2] - a[2] * b[1];
+        c[1] = a[2] * b[0] - a[0] * b[2];
+        c[2] = a[0] * b[1] - a[1] * b[0];
+    }
+
+    // XMMatrixPerspectiveFovLH
+    static void SetPerspective(float * pProjection, float fov, float aspect, float zNear, float zFar)
+    {
+        const float yScale = 1.0f / tanf(fov * 0.5f);
+        const float range = zFar / (zFar - zNear);
+
+        memset(pProjection, 0, 16 * sizeof(float));
+        pProjection[0] = yScale / aspect;
+        pProjection[5] = yScale;
+        pProjection[10] = range;
+        pProjection[11] = 1.0f;
+        pProjection[14] = -range * zNear;
+    }
+
+    // the basis XMMatrixLookAtLH builds, up being +y
+    static void SetLookAt(CameraBatchInput & input, const float * pEye, const float * pAt)
+    {
+        const float worldUp[3] = { 0.0f, 1.0f, 0.0f };
+
+        for (unsigned int i = 0; i < 3; i++)
+        {
+            input.m_Eye[i] = pEye[i];
+            input.m_Ahead[i] = pAt[i] - pEye[i];
+        }
+        Normalize(input.m_Ahead);
+        Cross(worldUp, input.m_Ahead, input.m_Right);
+        Normalize(input.m_Right);
+        Cross(input.m_Ahead, input.m_Right, input.m_Up);
+    }
+
+    // ExtractPlanesFromFrustum on the view projection, from its transposed copy
+    static void ExtractPlanes(const float * pViewProjectionT, float * pPlanes)
+    {
+        const float * row0 = pViewProjectionT + 0;
+        const float * row1 = pViewProjectionT + 4;
+        const float * row2 = pViewProjectionT + 8;
+        const float * row3 = pViewProjectionT + 12;
+
+        for (unsigned int i = 0; i < 4; i++)
+        {
+            pPlanes[ 0 + i] = row3[i] + row0[i];    // left
+            pPlanes[ 4 + i] = row3[i] - row0[i];    // right
+            pPlanes[ 8 + i] = row3[i] - row1[i];    // top
+            pPlanes[12 + i] = row3[i] + row1[i];    // bottom
+            pPlanes[16 + i] = row2[i];              // near
+            pPlanes[20 + i] = row3[i] - row2[i];    // far
+        }
+    }
+
+    static double GetElapsedMs(const std::chrono::high_resolution_clock::time_point & start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+
+    NullFrameLoop::NullFrameLoop() :
+        m_pRecordFaces(nullptr),
+        m_FrameIndex(0)
+    {
+        memset(m_Cameras, 0, sizeof(m_Cameras));
+        memset(m_ViewerEye, 0, sizeof(m_ViewerEye));
+        memset(m_ViewerAt, 0, sizeof(m_ViewerAt));
+        memset(m_LightEye, 0, sizeof(m_LightEye));
+    }
+
+    void NullFrameLoop::Init(const NullFrameLoopDesc & desc, const BenchmarkPath & path)
+    {
+        Release();
+
+        m_Desc = desc;
+        m_Path = path;
+        m_FrameIndex = 0;
+
+        m_Simulator.Init(m_Desc.m_Simulator);
+        m_Replay.Init(m_Simulator, m_Desc.m_Sample);
+        m_Jobs.Init(m_Desc.m_ThreadCount);
+
+        // boxes resting on the ground, a unit cube scaled and moved by their model matrix
+        unsigned int state = m_Desc.m_Seed != 0 ? m_Desc.m_Seed : 1;
+        m_Casters.resize(m_Desc.m_CasterCount);
+        m_CasterModels.assign(m_Desc.m_CasterCount * 16, 0.0f);
+        m_CasterFaces.assign(m_Desc.m_CasterCount, 0);
+
+        for (unsigned int caster = 0; caster < m_Desc.m_CasterCount; caster++)
+        {
+            float random[6];
+            for (unsigned int i = 0; i < 6; i++)
+            {
+                state ^= state << 13; state ^= state >> 17; state ^= state << 5;
+                random[i] = (float)(state & 0xffffff) / (float)0x1000000;
+            }
+
+            ShadowCasterBounds & bounds = m_Casters[caster];
+            for (unsigned int i = 0; i < 3; i++)
+            {
+                bounds.m_Extents[i] = 0.25f + 1.75f * random[3 + i];
+            }
+            bounds.m_Center[0] = (random[0] - 0.5f) * m_Desc.m_SceneSize;
+            bounds.m_Center[1] = bounds.m_Extents[1];
+            bounds.m_Center[2] = (random[2] - 0.5f) * m_Desc.m_SceneSize;
+
+            float * pModelT = &m_CasterModels[caster * 16];
+            for (unsigned int i = 0; i < 3; i++)
+            {
+                pModelT[i * 5] = 2.0f * bounds.m_Extents[i];
+                pModelT[i * 4 + 3] = bounds.m_Center[i];
+            }
+            pModelT[15] = 1.0f;
+        }
+
+        for (unsigned int job = 0; job < 1 + CAMERA_CUBE_FACE_COUNT; job++)
+        {
+            m_Draws[job].m_Constants.assign(m_Desc.m_CasterCount * 16, 0.0f);
+            m_Draws[job].m_Count = 0;
+        }
+
+        // where the sample starts, for the tracks of the path without keys
+        const float viewerEye[3] = { 0.0f, 8.0f, -25.0f };
+        const float viewerAt[3] = { 0.0f, 2.0f, 0.0f };
+        const float lightEye[3] = { 5.0f, 10.0f, -5.0f };
+        memcpy(m_ViewerEye, viewerEye, sizeof(m_ViewerEye));
+        memcpy(m_ViewerAt, viewerAt, sizeof(m_ViewerAt));
+        memcpy(m_LightEye, lightEye, sizeof(m_LightEye));
+    }
+
+    void NullFrameLoop::Release()
+    {
+        if (m_Casters.empty() == false)
+        {
+            m_Replay.Release(m_Simulator);
+        }
+        m_Jobs.Release();
+
+        m_Casters.clear();
+        m_CasterModels.clear();
+        m_CasterFaces.clear();
+    }
+
+    void NullFrameLoop::UpdateCameras()
+    {
+        const float time = (float)m_FrameIndex * m_Desc.m_TimeStep;
+
+        float lightAt[3];
+        m_Path.Sample(BENCHMARK_TRACK_CAMERA, time, m_ViewerEye, m_ViewerAt);
+        m_Path.Sample(BENCHMARK_TRACK_LIGHT, time, m_LightEye, lightAt);
+
+        // the projections of g_LightCamera and g_ViewerCamera
+        CameraBatchInput inputs[CAMERA_CUBE_FACE_COUNT + 1];
+        for (unsigned int face = 0; face < CAMERA_CUBE_FACE_COUNT; face++)
+        {
+            CameraBatchInput & input = inputs[face];
+            memcpy(input.m_Eye, m_LightEye, sizeof(input.m_Eye));
+            GetCubeFaceBasis(face, input.m_Right, input.m_Up, input.m_Ahead);
+            SetPerspective(input.m_Projection, NULL_FRAME_LOOP_PI / 2.0f, 1.0f, 0.01f, 25.0f);
+        }
+
+        SetLookAt(inputs[NULL_FRAME_LOOP_VIEWER], m_ViewerEye, m_ViewerAt);
+        SetPerspective(inputs[NULL_FRAME_LOOP_VIEWER].m_Projection, NULL_FRAME_LOOP_PI / 4.0f, 16.0f / 9.0f, 1.0f, 200.0f);
+
+        ComputeCameraMatrices(inputs, CAMERA_CUBE_FACE_COUNT + 1, m_Cameras, sizeof(CameraBatchMatrices));
+    }
+
+    void NullFrameLoop::RecordJob(unsigned int job, unsigned int worker, void * pUserData)
+    {
+        (void)worker;
+
+        NullFrameLoop & loop = *(NullFrameLoop *)pUserData;
+        Draws &         draws = loop.m_Draws[job];
+
+        const unsigned int camera = job == 0 ? NULL_FRAME_LOOP_VIEWER : loop.m_pRecordFaces[job - 1];
+        const unsigned int mask = 1u << camera;
+        const float *      pViewProjectionT = loop.m_Cameras[camera].m_ViewProjection;
+
+        // transpose(model * view projection), as the sample writes m_WorldViewProjection
+        draws.m_Count = 0;
+        for (unsigned int caster = 0; caster < (unsigned int)loop.m_Casters.size(); caster++)
+        {
+            if ((loop.m_CasterFaces[caster] & mask) == 0)
+            {
+                continue;
+            }
+
+            MultiplyCameraMatrices(pViewProjectionT, &loop.m_CasterModels[caster * 16], 0, 1, &draws.m_Constants[draws.m_Count * 16], 0);
+            draws.m_Count++;
+        }
+    }
+
+    void NullFrameLoop::Record(const unsigned int * pFaces, unsigned int faceCount)
+    {
+        m_pRecordFaces = pFaces;
+        m_Jobs.Run(1 + faceCount, RecordJob, this);
+        m_pRecordFaces = nullptr;
+    }
+
+    void NullFrameLoop::RunFrame(BenchmarkResults * pResults)
+    {
+        const std::chrono::high_resolution_clock::time_point frameStart = std::chrono::high_resolution_clock::now();
+
+        std::chrono::high_resolution_clock::time_point start = frameStart;
+        UpdateCameras();
+        const double cameraTime = GetElapsedMs(start);
+
+        start = std::chrono::high_resolution_clock::now();
+        float planes[(CAMERA_CUBE_FACE_COUNT + 1) * 6 * 4];
+        for (unsigned int camera = 0; camera < CAMERA_CUBE_FACE_COUNT + 1; camera++)
+        {
+            ExtractPlanes(m_Cameras[camera].m_ViewProjection, &planes[camera * 6 * 4]);
+        }
+        m_Culler.SetFaces(planes, CAMERA_CUBE_FACE_COUNT + 1);
+        m_Culler.Cull(m_Casters.data(), (unsigned int)m_Casters.size(), m_CasterFaces.data());
+        const double cullingTime = GetElapsedMs(start);
+
+        start = std::chrono::high_resolution_clock::now();
+        unsigned int       faces[CAMERA_CUBE_FACE_COUNT];
+        const unsigned int faceCount = m_Replay.GetNextFrameFaces(faces);
+        Record(faces, faceCount);
+        const double recordingTime = GetElapsedMs(start);
+
+        start = std::chrono::high_resolution_clock::now();
+        m_Replay.RenderFrame(m_Simulator);
+        const double submissionTime = GetElapsedMs(start);
+
+        const double frameTime = GetElapsedMs(frameStart);
+
+        m_FrameIndex++;
+
+        if (pResults == NULL)
+        {
+            return;
+        }
+
+        unsigned int casterDraws = 0;
+        for (unsigned int job = 1; job < 1 + faceCount; job++)
+        {
+            casterDraws += m_Draws[job].m_Count;
+        }
+
+        const AfrSimFrameStats & stats = m_Simulator.GetFrameStats().back();
+
+        BenchmarkResults & results = *pResults;
+        results.BeginFrame();
+        results.Set(results.AddMetric("Camera Update (CPU)", "ms"), cameraTime);
+        results.Set(results.AddMetric("Caster Culling (CPU)", "ms"), cullingTime);
+        results.Set(results.AddMetric("Command Recording (CPU)", "ms"), recordingTime);
+        results.Set(results.AddMetric("Frame Submission (CPU)", "ms"), submissionTime);
+        results.Set(results.AddMetric("Frame (CPU)", "ms"), frameTime);
+        results.Set(results.AddMetric("Frame (GPU)", "ms"), stats.m_GpuTime);
+        results.Set(results.AddMetric("Frame Time", "ms"), stats.m_FrameTime);
+        results.Set(results.AddMetric("Transfer Stall (GPU)", "ms"), stats.m_StallTime);
+        results.Set(results.AddMetric("Transfer Contention (GPU)", "ms"), stats.m_ContentionTime);
+        results.Set(results.AddMetric("Transferred", "MB"), stats.m_TransferBytes / (1024.0 * 1024.0));
+        results.Set(results.AddMetric("EndWrites", "calls"), stats.m_EndWritesCount);
+        results.Set(results.AddMetric("BeginAllAccess", "calls"), stats.m_BeginAllAccessCount);
+        results.Set(results.AddMetric("EndAllAccess", "calls"), stats.m_EndAllAccessCount);
+        results.Set(results.AddMetric("Transfer Copies", "calls"), stats.m_CopyCount);
+        results.Set(results.AddMetric("Shadow Faces", "faces"), faceCount);
+        results.Set(results.AddMetric("Prepass Draws", "draws"), m_Draws[0].m_Count);
+        results.Set(results.AddMetric("Shadow Caster Draws", "draws"), casterDraws);
+    }
+
+    void NullFrameLoop::GetSettings(BenchmarkResults & results) const
+    {
+        const AfrSimSampleSettings & sample = m_Desc.m_Sample;
+        char                         value[64];
+
+        results.SetSetting("backend", "null");
+        sprintf(value, "%u", m_Desc.m_Simulator.m_GpuCount);
+        results.SetSetting("gpus", value);
+        results.SetSetting("texture", sample.m_ShadowTextureType == 0 ? "atlas" : "array");
+        results.SetSetting("transfer", GetAfrSimTransferName(sample.m_ResourceTransferType));
+        results.SetSetting("api transfers", sample.m_EnableCrossfireApiTransfers ? "on" : "off");
+        results.SetSetting("2-step", sample.m_Enable2StepGpuTransfer ? "on" : "off");
+        results.SetSetting("delay EndAllAccess", sample.m_DelayEndAllAccess ? "on" : "off");
+        results.SetSetting("update", sample.m_SingleFacePerFrame ? "single face" : "all faces");
+        sprintf(value, "%u", sample.m_ShadowMapSize);
+        results.SetSetting("shadow map size", value);
+        sprintf(value, "%u", m_Desc.m_CasterCount);
+        results.SetSetting("casters", value);
+        sprintf(value, "%u", m_Jobs.GetWorkerCount());
+        results.SetSetting("threads", value);
+    }
+}
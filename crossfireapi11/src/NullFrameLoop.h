@@ -0,0 +1,121 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//--------------------------------------------------------------------------------------
+// File: NullFrameLoop.h
+//
+// The frame loop of the sample against a null render backend, so that the CPU side of the
+// pipeline can be benchmarked on any platform: every frame moves the viewer and the light
+// along a BenchmarkPath, computes the camera matrices of the viewer and the cube faces,
+// culls the shadow casters against the faces and computes the per-draw constants of the
+// depth prepass and of the faces due this frame on the threads of a JobSystem, the way
+// OnD3D11FrameRender records them. The GPU side is AfrSimSampleReplay on an AfrSimulator,
+// which places the Crossfire API calls of the frame and predicts the GPU and frame times.
+//
+// The casters are boxes spread over the scene, in the place of the meshes of the sample.
+//
+// This code has no dependency on Windows, D3D11 or AGS.
+//--------------------------------------------------------------------------------------
+#ifndef NULL_FRAME_LOOP_H
+#define NULL_FRAME_LOOP_H
+
+#include <vector>
+
+#include "AfrSimulator.h"
+#include "Benchmark.h"
+#include "CameraBatch.h"
+#include "JobSystem.h"
+#include "ShadowCasterCulling.h"
+
+namespace AMD
+{
+    struct NullFrameLoopDesc
+    {
+        AfrSimulatorDesc     m_Simulator;
+        AfrSimSampleSettings m_Sample;
+        unsigned int         m_CasterCount;
+        float                m_SceneSize;       // casters are placed in [-size / 2, size / 2] around the origin
+        unsigned int         m_ThreadCount;     // recording threads, see JobSystem
+        unsigned int         m_Seed;            // of the caster placement
+        float                m_TimeStep;        // seconds of the path per frame
+
+        NullFrameLoopDesc()
+            : m_CasterCount(1000)
+            , m_SceneSize(40.0f)
+            , m_ThreadCount(4)
+            , m_Seed(1)
+            , m_TimeStep(1.0f / 60.0f)
+        {}
+    };
+
+    class NullFrameLoop
+    {
+    public:
+        NullFrameLoop();
+
+        void Init(const NullFrameLoopDesc & desc, const BenchmarkPath & path);
+        void Release();
+
+        // one frame; its samples go to a new frame of pResults, unless pResults is NULL (warmup)
+        void RunFrame(BenchmarkResults * pResults);
+
+        // the settings of the run, as BenchmarkResults::SetSetting pairs
+        void GetSettings(BenchmarkResults & results) const;
+
+        unsigned int GetFrameIndex() const { return m_FrameIndex; }
+
+    private:
+        // a job records the depth prepass (job 0) or a cube face of the frame
+        struct Draws
+        {
+            std::vector<float> m_Constants;     // a world view projection per caster drawn, transposed for HLSL
+            unsigned int       m_Count;
+        };
+
+        static void RecordJob(unsigned int job, unsigned int worker, void * pUserData);
+
+        void UpdateCameras();
+        void Record(const unsigned int * pFaces, unsigned int faceCount);
+
+        NullFrameLoopDesc                 m_Desc;
+        BenchmarkPath                     m_Path;
+        AfrSimulator                      m_Simulator;
+        AfrSimSampleReplay                m_Replay;
+        JobSystem                         m_Jobs;
+        ShadowCasterCuller                m_Culler;
+
+        std::vector<ShadowCasterBounds>   m_Casters;
+        std::vector<float>                m_CasterModels;   // a model matrix per caster, transposed for HLSL
+        std::vector<unsigned int>         m_CasterFaces;    // per caster, see ShadowCasterCuller::Cull; bit 6 is the viewer
+
+        CameraBatchMatrices               m_Cameras[CAMERA_CUBE_FACE_COUNT + 1];    // the cube faces, then the viewer
+        float                             m_ViewerEye[3];
+        float                             m_ViewerAt[3];
+        float                             m_LightEye[3];
+
+        const unsigned int *              m_pRecordFaces;   // of the frame being recorded
+        Draws                             m_Draws[1 + CAMERA_CUBE_FACE_COUNT];
+
+        unsigned int                      m_FrameIndex;
+    };
+}
+
+#endif // NULL_FRAME_LOOP_H
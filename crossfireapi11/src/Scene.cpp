@@ -0,0 +1,283 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//--------------------------------------------------------------------------------------
+// File: Scene.cpp
+//
+// Reads the scene of the sample: mesh assets, instances and spot lights.
+//--------------------------------------------------------------------------------------
+#include "Scene.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _MSC_VER
+#pragma warning( disable : 4996 ) // fopen/sscanf are fine for this use
+#endif
+
+namespace AMD
+{
+    static const float SCENE_DEGREES_TO_RADIANS = 3.14159265358979f / 180.0f;
+
+    void GetSceneInstanceWorld(const float * pPosition, float yaw, const float * pScale, float * pWorld)
+    {
+        const float c = cosf(yaw);
+        const float s = sinf(yaw);
+
+        // scale * rotation around y * translation, as XMMatrixRotationY turns row vectors
+        const float world[16] =
+        {
+            pScale[0] * c,  0.0f,           pScale[0] * -s, 0.0f,
+            0.0f,           pScale[1],      0.0f,           0.0f,
+            pScale[2] * s,  0.0f,           pScale[2] * c,  0.0f,
+            pPosition[0],   pPosition[1],   pPosition[2],   1.0f,
+        };
+        memcpy(pWorld, world, sizeof(world));
+    }
+
+    Scene::Scene()
+        : m_ErrorLine(0)
+    {
+    }
+
+    void Scene::Clear()
+    {
+        m_Meshes.clear();
+        m_Instances.clear();
+        m_Lights.clear();
+        m_ErrorLine = 0;
+    }
+
+    bool Scene::Load(const char * path)
+    {
+        Clear();
+
+        FILE * file = fopen(path, "rb");
+        if (file == NULL)
+        {
+            return false;
+        }
+
+        std::string text;
+        char        buffer[4096];
+        size_t      size = 0;
+        while ((size = fread(buffer, 1, sizeof(buffer), file)) > 0)
+        {
+            text.append(buffer, size);
+        }
+        fclose(file);
+
+        return Parse(text.c_str());
+    }
+
+    bool Scene::Parse(const char * text)
+    {
+        Clear();
+
+        unsigned int lineNumber = 0;
+        const char * pLine = text;
+
+        while (*pLine != 0)
+        {
+            const char * pEnd = pLine;
+            while (*pEnd != 0 && *pEnd != '\n')
+            {
+                pEnd++;
+            }
+            lineNumber++;
+
+            // the line up to its comment
+            std::string line(pLine, pEnd);
+            const size_t comment = line.find('#');
+            if (comment != std::string::npos)
+            {
+                line.resize(comment);
+            }
+
+            if (ParseLine(line) == false)
+            {
+                m_ErrorLine = lineNumber;
+                return false;
+            }
+
+            pLine = *pEnd == 0 ? pEnd : pEnd + 1;
+        }
+
+        return true;
+    }
+
+    // true for an empty line or a well formed entry; every entry ends with its last number
+    bool Scene::ParseLine(const std::string & line)
+    {
+        char         type[16] = { 0 };
+        int          consumed = 0;
+        if (sscanf(line.c_str(), " %15s %n", type, &consumed) < 1)
+        {
+            return true;
+        }
+
+        const char * pArgs = line.c_str() + consumed;
+        char         name[64] = { 0 };
+        char         flag[16] = { 0 };
+        int          end = 0;
+
+        if (strcmp(type, "mesh") == 0)
+        {
+            char directory[256] = { 0 };
+            char file[256] = { 0 };
+            if (sscanf(pArgs, "%63s %255s %255s %n", name, directory, file, &end) != 3 || pArgs[end] != 0)
+            {
+                return false;
+            }
+            return AddMesh(name, directory, file) != SCENE_INVALID_INDEX;
+        }
+
+        if (strcmp(type, "instance") == 0)
+        {
+            float position[3], yaw, scale[3];
+            if (sscanf(pArgs, "%63s %15s %f %f %f %f %f %f %f %n", name, flag,
+                       &position[0], &position[1], &position[2], &yaw, &scale[0], &scale[1], &scale[2], &end) != 9 || pArgs[end] != 0)
+            {
+                return false;
+            }
+
+            const bool isStatic = strcmp(flag, "static") == 0;
+            if (isStatic == false && strcmp(flag, "dynamic") != 0)
+            {
+                return false;
+            }
+            return AddInstance(FindMesh(name), isStatic, position, yaw * SCENE_DEGREES_TO_RADIANS, scale);
+        }
+
+        if (strcmp(type, "grid") == 0)
+        {
+            float first[3], spacing[2], yaw, scale[3];
+            int   columns, rows;
+            if (sscanf(pArgs, "%63s %15s %f %f %f %d %d %f %f %f %f %f %f %n", name, flag,
+                       &first[0], &first[1], &first[2], &columns, &rows, &spacing[0], &spacing[1], &yaw, &scale[0], &scale[1], &scale[2], &end) != 13 ||
+                pArgs[end] != 0 || columns <= 0 || rows <= 0)
+            {
+                return false;
+            }
+
+            const bool         isStatic = strcmp(flag, "static") == 0;
+            const unsigned int mesh = FindMesh(name);
+            if ((isStatic == false && strcmp(flag, "dynamic") != 0) ||
+                (unsigned long long)columns * (unsigned long long)rows > SCENE_MAX_INSTANCE_COUNT - GetInstanceCount())
+            {
+                return false;
+            }
+
+            for (int row = 0; row < rows; row++)
+            {
+                for (int column = 0; column < columns; column++)
+                {
+                    const float position[3] = { first[0] + spacing[0] * (float)column, first[1], first[2] + spacing[1] * (float)row };
+                    const float angle = yaw * (float)(row * columns + column);
+
+                    if (AddInstance(mesh, isStatic, position, fmodf(angle, 360.0f) * SCENE_DEGREES_TO_RADIANS, scale) == false)
+                    {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }
+
+        if (strcmp(type, "spot") == 0)
+        {
+            SceneLight light;
+            if (sscanf(pArgs, "%f %f %f %f %f %f %f %f %n",
+                       &light.m_Position[0], &light.m_Position[1], &light.m_Position[2], &light.m_At[0], &light.m_At[1], &light.m_At[2],
+                       &light.m_ConeAngle, &light.m_Range, &end) != 8 || pArgs[end] != 0 ||
+                light.m_ConeAngle <= 0.0f || light.m_ConeAngle >= 180.0f || light.m_Range <= 0.0f)
+            {
+                return false;
+            }
+
+            light.m_ConeAngle *= SCENE_DEGREES_TO_RADIANS;
+            AddLight(light);
+            return true;
+        }
+
+        return false;
+    }
+
+    unsigned int Scene::AddMesh(const char * name, const char * directory, const char * file)
+    {
+        if (FindMesh(name) != SCENE_INVALID_INDEX)
+        {
+            return SCENE_INVALID_INDEX;
+        }
+
+        SceneMesh mesh;
+        mesh.m_Name = name;
+        mesh.m_Directory = directory;
+        mesh.m_File = file;
+        m_Meshes.push_back(mesh);
+
+        return (unsigned int)m_Meshes.size() - 1;
+    }
+
+    unsigned int Scene::FindMesh(const char * name) const
+    {
+        for (unsigned int mesh = 0; mesh < m_Meshes.size(); mesh++)
+        {
+            if (m_Meshes[mesh].m_Name == name)
+            {
+                return mesh;
+            }
+        }
+        return SCENE_INVALID_INDEX;
+    }
+
+    bool Scene::AddInstance(unsigned int mesh, bool isStatic, const float * pPosition, float yaw, const float * pScale)
+    {
+        if (mesh >= m_Meshes.size() || m_Instances.size() >= SCENE_MAX_INSTANCE_COUNT)
+        {
+            return false;
+        }
+
+        SceneInstance instance;
+        instance.m_Mesh = mesh;
+        instance.m_Static = isStatic;
+        GetSceneInstanceWorld(pPosition, yaw, pScale, instance.m_World);
+        m_Instances.push_back(instance);
+
+        return true;
+    }
+
+    unsigned int Scene::GetStaticInstanceCount() const
+    {
+        unsigned int count = 0;
+        for (unsigned int instance = 0; instance < m_Instances.size(); instance++)
+        {
+            count += m_Instances[instance].m_Static ? 1 : 0;
+        }
+        return count;
+    }
+
+    void Scene::AddLight(const SceneLight & light)
+    {
+        m_Lights.push_back(light);
+    }
+}
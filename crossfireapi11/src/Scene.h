@@ -0,0 +1,122 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//--------------------------------------------------------------------------------------
+// File: Scene.h
+//
+// The scene of the sample as a text file: the mesh assets, their instances and the spot
+// lights, one per line. Everything after a '#' is a comment:
+//
+//     # mesh     name    directory                  file
+//     mesh       tree    ..\media\coconuttree\      coconut.sdkmesh
+//
+//     # instance mesh    static|dynamic   position x y z   yaw   scale x y z
+//     instance   tree    dynamic          5.0 0.0 0.0      0.0   0.01 0.01 0.01
+//
+//     # grid     mesh    static|dynamic   first x y z      columns rows   spacing x z   yaw   scale x y z
+//     grid       tree    static           -40 0 -40        32 32          2.5 2.5       0.0   0.01 0.01 0.01
+//
+//     # spot     position x y z    at x y z       cone angle   range
+//     spot       9.5 6.0 0.0       2.5 0.0 0.0    54.0         25.0
+//
+// A mesh is declared before its instances. An instance is scaled, turned by yaw degrees
+// around the y axis, then moved to its position. A grid is columns x rows instances on
+// the xz plane, starting at first and turned by yaw more degrees at every instance, so
+// that a large scene doesn't need a line per instance. Static instances go into the
+// cached static layer of the shadow map, dynamic ones are drawn every time.
+//
+// This code has no dependency on Windows, D3D11 or AGS.
+//--------------------------------------------------------------------------------------
+#ifndef SCENE_H
+#define SCENE_H
+
+#include <string>
+#include <vector>
+
+namespace AMD
+{
+    static const unsigned int SCENE_INVALID_INDEX = 0xffffffff;
+    static const unsigned int SCENE_MAX_INSTANCE_COUNT = 1 << 20;
+
+    struct SceneMesh
+    {
+        std::string  m_Name;
+        std::string  m_Directory;           // with its trailing separator
+        std::string  m_File;
+    };
+
+    struct SceneInstance
+    {
+        unsigned int m_Mesh;                // index of the mesh in the scene
+        bool         m_Static;
+        float        m_World[16];           // row major (D3D convention, row vectors)
+    };
+
+    struct SceneLight
+    {
+        float        m_Position[3];
+        float        m_At[3];
+        float        m_ConeAngle;           // radians, the whole cone
+        float        m_Range;
+    };
+
+    // the row major world matrix of an instance: scale, then yaw radians around y, then position
+    void GetSceneInstanceWorld(const float * pPosition, float yaw, const float * pScale, float * pWorld);
+
+    class Scene
+    {
+    public:
+        Scene();
+
+        // false if the file can't be read or a line is malformed, see GetErrorLine
+        bool                 Load(const char * path);
+        bool                 Parse(const char * text);
+        unsigned int         GetErrorLine() const { return m_ErrorLine; }
+
+        void                 Clear();
+
+        // SCENE_INVALID_INDEX if a mesh of that name exists already
+        unsigned int         AddMesh(const char * name, const char * directory, const char * file);
+        unsigned int         FindMesh(const char * name) const;
+        unsigned int         GetMeshCount() const { return (unsigned int)m_Meshes.size(); }
+        const SceneMesh &    GetMesh(unsigned int mesh) const { return m_Meshes[mesh]; }
+
+        // false if the mesh doesn't exist or the scene is full, see SCENE_MAX_INSTANCE_COUNT
+        bool                 AddInstance(unsigned int mesh, bool isStatic, const float * pPosition, float yaw, const float * pScale);
+        unsigned int         GetInstanceCount() const { return (unsigned int)m_Instances.size(); }
+        const SceneInstance & GetInstance(unsigned int instance) const { return m_Instances[instance]; }
+        unsigned int         GetStaticInstanceCount() const;
+
+        void                 AddLight(const SceneLight & light);
+        unsigned int         GetLightCount() const { return (unsigned int)m_Lights.size(); }
+        const SceneLight &   GetLight(unsigned int light) const { return m_Lights[light]; }
+
+    private:
+        bool                 ParseLine(const std::string & line);
+
+        std::vector<SceneMesh>     m_Meshes;
+        std::vector<SceneInstance> m_Instances;
+        std::vector<SceneLight>    m_Lights;
+        unsigned int               m_ErrorLine;
+    };
+}
+
+#endif // SCENE_H
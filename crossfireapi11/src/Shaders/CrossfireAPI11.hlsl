@@ -80,6 +80,42 @@ cbuffer CB_LIGHT_ARRAY_DATA  : register( b2 )
   S_CAMERA_DATA g_Light[6];
 }
 
+// a mesh drawn into all its cube faces in one pass, one instance per face it casts a
+// shadow into (see RenderShadowMapFacesInstanced)
+cbuffer CB_SHADOW_FACE_DATA  : register( b3 )
+{
+  float4x4    g_ShadowFaceWorld;
+  float4x4    g_ShadowFaceWorldViewProjection[6];
+  uint4       g_ShadowFaceTarget[6];        // x: viewport, y: render target array slice
+}
+
+// a spot light besides the cube light; as many as the application has, which a cbuffer
+// of a fixed size can't hold
+struct S_SHADOW_LIGHT_DATA
+{
+  float4      m_Position;     // w: range
+  float4      m_Direction;    // w: cosine of half the cone angle
+  float4      m_Color;
+  uint        m_Mask;         // index of g_t2dShadowLightMask, SHADOW_LIGHT_MASK_COUNT if the light has no shadow
+  uint        m_Channel;
+  float2      m_Padding;
+};
+
+#define SHADOW_LIGHT_MASK_COUNT 4
+
+// the unit cube of a cube light, drawn in clip space; all of them in one instanced draw
+struct S_LIGHT_VOLUME_DATA
+{
+  column_major float4x4 m_Transform;  // light clip space to viewer clip space, transposed like the cbuffers
+  float4      m_Color;
+};
+
+// an instance of a mesh, drawn with the other instances of the mesh (see RenderScene)
+struct S_INSTANCE_DATA
+{
+  column_major float4x4 m_World;      // transposed like the cbuffers
+};
+
 //--------------------------------------------------------------------------------------
 // Buffers, Textures and Samplers
 //--------------------------------------------------------------------------------------
@@ -89,6 +125,16 @@ Texture2D               g_t2dDiffuse         : register( t0 );
 Texture2D<float4>       g_t2dShadowMask      : register( t1 );
 Texture2D<float>        g_t2dDepth           : register( t2 );
 
+// Spot lights
+StructuredBuffer<S_SHADOW_LIGHT_DATA> g_ShadowLight : register( t3 );
+Texture2D<float4>       g_t2dShadowLightMask[SHADOW_LIGHT_MASK_COUNT] : register( t4 );
+
+// Light volumes
+StructuredBuffer<S_LIGHT_VOLUME_DATA> g_LightVolume : register( t8 );
+
+// Instances
+StructuredBuffer<S_INSTANCE_DATA> g_Instance : register( t9 );
+
 // Samplers
 SamplerState            g_SampleLinear      : register( s0 );
 
@@ -112,6 +158,30 @@ struct PS_RenderSceneInput
   float2 f2TexCoord     : TEXCOORD0;
 };
 
+struct GS_RenderShadowMapInput
+{
+  float4 f4Position     : SV_Position;
+  float3 f3Normal       : NORMAL;
+  float2 f2TexCoord     : TEXCOORD0;
+  nointerpolation uint uInstance : INSTANCE;
+};
+
+struct GS_RenderShadowMapOutput
+{
+  float4 f4Position     : SV_Position;
+  float3 f3PositionWS   : WS_POSITION;
+  float3 f3Normal       : NORMAL;
+  float2 f2TexCoord     : TEXCOORD0;
+  uint   uViewport      : SV_ViewportArrayIndex;
+  uint   uSlice         : SV_RenderTargetArrayIndex;
+};
+
+struct PS_RenderLightVolumeInput
+{
+  float4 f4Position                 : SV_Position;
+  nointerpolation float4 f4Color    : COLOR;
+};
+
 struct PS_RenderOutput
 {
   float4 m_Color      : SV_Target0;
@@ -138,6 +208,32 @@ PS_RenderSceneInput VS_RenderScene( VS_RenderSceneInput I )
 }
 
 
+//--------------------------------------------------------------------------------------
+// Render Scene, the instances of a mesh at once
+// The world matrix of the instance comes from g_Instance, starting at the first instance
+// of the group in g_Model.m_Parameter0.x; g_Model.m_WorldViewProjection is the view
+// projection alone
+//--------------------------------------------------------------------------------------
+PS_RenderSceneInput VS_RenderSceneInstanced( VS_RenderSceneInput I, uint uInstance : SV_InstanceID )
+{
+  PS_RenderSceneInput Output;
+
+  const float4x4 f4x4World = g_Instance[(uint)g_Model.m_Parameter0.x + uInstance].m_World;
+  const float4   f4PositionWS = mul( float4( I.f3Position, 1.0f ), f4x4World );
+
+  // Transform the position from object space to homogeneous projection space
+  Output.f4Position = mul( f4PositionWS, g_Model.m_WorldViewProjection );
+  Output.f3PositionWS = f4PositionWS.xyz;
+
+  // Transform the normal from object space to world space
+  Output.f3Normal = normalize( mul( I.f3Normal, (float3x3)f4x4World ) );
+
+  // Pass through texture coords
+  Output.f2TexCoord = I.f2TexCoord;
+
+  return Output;
+}
+
 //--------------------------------------------------------------------------------------
 // Render Shadow Map
 // Adjusts World Space Position by offsetting it along the normal
@@ -159,6 +255,41 @@ PS_RenderSceneInput VS_RenderShadowMap( VS_RenderSceneInput I )
   return Output;
 }
 
+//--------------------------------------------------------------------------------------
+// Render Shadow Map into several cube faces at once
+// Instance i goes into the face of g_ShadowFaceTarget[i]; D3D11 only lets a geometry
+// shader select the viewport and the array slice, so GS_RenderShadowMapInstanced does it
+//--------------------------------------------------------------------------------------
+GS_RenderShadowMapInput VS_RenderShadowMapInstanced( VS_RenderSceneInput I, uint uInstance : SV_InstanceID )
+{
+  GS_RenderShadowMapInput Output;
+
+  Output.f4Position = mul( float4( I.f3Position, 1.0f ), g_ShadowFaceWorldViewProjection[uInstance] );
+  Output.f3Normal = normalize( mul( I.f3Normal, (float3x3)g_ShadowFaceWorld ) );
+  Output.f2TexCoord = I.f2TexCoord;
+  Output.uInstance = uInstance;
+
+  return Output;
+}
+
+[maxvertexcount(3)]
+void GS_RenderShadowMapInstanced( triangle GS_RenderShadowMapInput I[3], inout TriangleStream<GS_RenderShadowMapOutput> Stream )
+{
+  GS_RenderShadowMapOutput Output;
+
+  for (uint v = 0; v < 3; v++)
+  {
+    Output.f4Position = I[v].f4Position;
+    Output.f3PositionWS = 0.0f;
+    Output.f3Normal = I[v].f3Normal;
+    Output.f2TexCoord = I[v].f2TexCoord;
+    Output.uViewport = g_ShadowFaceTarget[I[v].uInstance].x;
+    Output.uSlice = g_ShadowFaceTarget[I[v].uInstance].y;
+
+    Stream.Append( Output );
+  }
+}
+
 //--------------------------------------------------------------------------------------
 //
 //--------------------------------------------------------------------------------------
@@ -181,6 +312,55 @@ float4 PS_DepthAndNormalPassScene( PS_RenderSceneInput I ) : SV_Target0
   return float4( I.f3Normal, 1.0f );
 }
 
+//--------------------------------------------------------------------------------------
+// Copy the cached static layer into the region of the shadow map the viewport covers
+//--------------------------------------------------------------------------------------
+float PS_CopyDepth( float4 f4Position : SV_Position ) : SV_Depth
+{
+  return g_t2dDepth.Load( int3( f4Position.xy, 0 ) );
+}
+
+//--------------------------------------------------------------------------------------
+// The clip space cube of AMD::CreateClipSpaceCube, instance i transformed by light volume i
+//--------------------------------------------------------------------------------------
+PS_RenderLightVolumeInput VS_RenderLightVolumeInstanced( uint uVertex : SV_VertexID, uint uInstance : SV_InstanceID )
+{
+  const float4 vertex[] =
+  {
+    { -1.0f, -1.0f,  1.0f, 1.0f },
+    { -1.0f, -1.0f,  0.0f, 1.0f },
+    {  1.0f, -1.0f,  0.0f, 1.0f },
+    {  1.0f, -1.0f,  1.0f, 1.0f },
+    { -1.0f,  1.0f,  1.0f, 1.0f },
+    {  1.0f,  1.0f,  1.0f, 1.0f },
+    {  1.0f,  1.0f,  0.0f, 1.0f },
+    { -1.0f,  1.0f,  0.0f, 1.0f }
+  };
+
+  const uint index[] =
+  {
+    0, 1, 2,  2, 3, 0,
+    4, 5, 6,  6, 7, 4,
+    0, 3, 5,  5, 4, 0,
+    3, 2, 6,  6, 5, 3,
+    2, 1, 7,  7, 6, 2,
+    1, 0, 4,  4, 7, 1
+  };
+
+  S_LIGHT_VOLUME_DATA L = g_LightVolume[uInstance];
+
+  PS_RenderLightVolumeInput Output;
+  Output.f4Position = mul( vertex[index[uVertex]], L.m_Transform );
+  Output.f4Color = L.m_Color;
+
+  return Output;
+}
+
+float4 PS_RenderLightVolumeInstanced( PS_RenderLightVolumeInput I ) : SV_Target0
+{
+  return I.f4Color;
+}
+
 //--------------------------------------------------------------------------------------
 //
 //--------------------------------------------------------------------------------------
@@ -208,8 +388,9 @@ PS_RenderOutput PS_RenderShadowedScene( PS_RenderSceneInput I )
 
   float3 normal = normalize( I.f3Normal );
 
+  // an orthographic projection, _44 == 1, is a cascade of the sun: a directional light
   float3 LightDir;
-  LightDir = normalize(g_Light[0].m_Eye - I.f3PositionWS);
+  LightDir = g_Light[0].m_Projection._44 == 1.0 ? -g_Light[0].m_Direction.xyz : normalize(g_Light[0].m_Eye - I.f3PositionWS);
 
   float lightness;
   lightness = max(0, dot(normal, LightDir) );
@@ -217,6 +398,32 @@ PS_RenderOutput PS_RenderShadowedScene( PS_RenderSceneInput I )
   Output.m_Color.xyz  = g_Model.m_Ambient.xyz;
   Output.m_Color.xyz += lightness * g_Light[0].m_Color.xyz * g_Model.m_Diffuse.xyz * shadow.x;
 
+  // the spot lights; a texture array can't be indexed dynamically, so every mask is loaded
+  float4 lightMask[SHADOW_LIGHT_MASK_COUNT + 1];
+  [unroll] for (uint mask = 0; mask < SHADOW_LIGHT_MASK_COUNT; mask++)
+  {
+    lightMask[mask] = g_t2dShadowLightMask[mask].Load( int3(I.f4Position.xy, 0 ) );
+  }
+  lightMask[SHADOW_LIGHT_MASK_COUNT] = 1.0f;
+
+  uint lightCount, lightStride;
+  g_ShadowLight.GetDimensions( lightCount, lightStride );
+
+  for (uint light = 0; light < lightCount; light++)
+  {
+    S_SHADOW_LIGHT_DATA L = g_ShadowLight[light];
+
+    float3 toLight = L.m_Position.xyz - I.f3PositionWS;
+    float  distance = length( toLight );
+    float3 direction = toLight / distance;
+
+    float  cone = saturate( (dot( -direction, L.m_Direction.xyz ) - L.m_Direction.w) / (1.0f - L.m_Direction.w) );
+    float  falloff = saturate( 1.0f - distance / L.m_Position.w );
+    float  lightShadow = dot( lightMask[L.m_Mask], float4( L.m_Channel == uint4( 0, 1, 2, 3 ) ) ) * 0.4 + 0.6;
+
+    Output.m_Color.xyz += max( 0, dot( normal, direction ) ) * cone * falloff * falloff * L.m_Color.xyz * g_Model.m_Diffuse.xyz * lightShadow;
+  }
+
   Output.m_Color.w    = 1.0f;
   Output.m_Color     *= f4TextureColor;
 
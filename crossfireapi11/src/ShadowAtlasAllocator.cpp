@@ -0,0 +1,404 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//--------------------------------------------------------------------------------------
+// File: ShadowAtlasAllocator.cpp
+//
+// Skyline shadow atlas allocator with a guillotine free list and defragmentation.
+//--------------------------------------------------------------------------------------
+#include "ShadowAtlasAllocator.h"
+
+#include <algorithm>
+
+namespace AMD
+{
+    static const ShadowAtlasRect EMPTY_SHADOW_ATLAS_RECT = { 0, 0, 0, 0 };
+
+    ShadowAtlasAllocator::ShadowAtlasAllocator()
+    {
+        Init(0, 0);
+    }
+
+    void ShadowAtlasAllocator::Init(unsigned int width, unsigned int height)
+    {
+        m_Width = width;
+        m_Height = height;
+
+        m_Regions.clear();
+        m_FreeRegions.clear();
+        m_LiveCount = 0;
+        m_AllocatedTexels = 0;
+
+        Clear();
+    }
+
+    void ShadowAtlasAllocator::Clear()
+    {
+        m_Skyline.clear();
+        m_FreeRects.clear();
+
+        const SkylineNode node = { 0, 0, m_Width };
+        m_Skyline.push_back(node);
+    }
+
+    unsigned int ShadowAtlasAllocator::Allocate(unsigned int width, unsigned int height)
+    {
+        ShadowAtlasRect rect;
+        if (width == 0 || height == 0 || Place(width, height, rect) == false)
+        {
+            return SHADOW_ATLAS_INVALID_REGION;
+        }
+
+        unsigned int region;
+        if (m_FreeRegions.empty() == false)
+        {
+            region = m_FreeRegions.back();
+            m_FreeRegions.pop_back();
+        }
+        else
+        {
+            region = (unsigned int)m_Regions.size();
+            m_Regions.push_back(Region());
+            m_Regions[region].m_Generation = 0;
+        }
+
+        m_Regions[region].m_Rect = rect;
+        m_Regions[region].m_Generation++;
+        m_Regions[region].m_Live = true;
+
+        m_LiveCount++;
+        m_AllocatedTexels += (unsigned long long)width * height;
+
+        return region;
+    }
+
+    void ShadowAtlasAllocator::Free(unsigned int region)
+    {
+        if (IsValid(region) == false)
+        {
+            return;
+        }
+
+        Region & r = m_Regions[region];
+        AddFreeRect(r.m_Rect);
+
+        m_AllocatedTexels -= (unsigned long long)r.m_Rect.m_Width * r.m_Rect.m_Height;
+        m_LiveCount--;
+
+        r.m_Live = false;
+        m_FreeRegions.push_back(region);
+    }
+
+    static bool IsLargerRegion(const std::pair<ShadowAtlasRect, unsigned int> & a, const std::pair<ShadowAtlasRect, unsigned int> & b)
+    {
+        if (a.first.m_Height != b.first.m_Height) { return a.first.m_Height > b.first.m_Height; }
+        if (a.first.m_Width != b.first.m_Width)   { return a.first.m_Width > b.first.m_Width; }
+        return a.second < b.second; // keep the order stable
+    }
+
+    unsigned int ShadowAtlasAllocator::Defragment()
+    {
+        std::vector< std::pair<ShadowAtlasRect, unsigned int> > live;
+        for (unsigned int i = 0; i < (unsigned int)m_Regions.size(); i++)
+        {
+            if (m_Regions[i].m_Live == true)
+            {
+                live.push_back(std::make_pair(m_Regions[i].m_Rect, i));
+            }
+        }
+
+        std::sort(live.begin(), live.end(), IsLargerRegion);
+
+        const std::vector<SkylineNode>     skyline = m_Skyline;
+        const std::vector<ShadowAtlasRect> freeRects = m_FreeRects;
+
+        Clear();
+
+        std::vector<ShadowAtlasRect> packed(live.size());
+        for (size_t i = 0; i < live.size(); i++)
+        {
+            if (Place(live[i].first.m_Width, live[i].first.m_Height, packed[i]) == false)
+            {
+                m_Skyline = skyline;
+                m_FreeRects = freeRects;
+                return 0;
+            }
+        }
+
+        unsigned int moved = 0;
+        for (size_t i = 0; i < live.size(); i++)
+        {
+            Region & r = m_Regions[live[i].second];
+            if (r.m_Rect.m_X != packed[i].m_X || r.m_Rect.m_Y != packed[i].m_Y)
+            {
+                r.m_Rect = packed[i];
+                r.m_Generation++;
+                moved++;
+            }
+        }
+
+        return moved;
+    }
+
+    bool ShadowAtlasAllocator::IsValid(unsigned int region) const
+    {
+        return region < m_Regions.size() && m_Regions[region].m_Live == true;
+    }
+
+    const ShadowAtlasRect & ShadowAtlasAllocator::GetRect(unsigned int region) const
+    {
+        return IsValid(region) ? m_Regions[region].m_Rect : EMPTY_SHADOW_ATLAS_RECT;
+    }
+
+    unsigned int ShadowAtlasAllocator::GetGeneration(unsigned int region) const
+    {
+        return IsValid(region) ? m_Regions[region].m_Generation : 0;
+    }
+
+    float ShadowAtlasAllocator::GetOccupancy() const
+    {
+        const unsigned long long texels = (unsigned long long)m_Width * m_Height;
+        return texels > 0 ? (float)((double)m_AllocatedTexels / (double)texels) : 0.0f;
+    }
+
+    bool ShadowAtlasAllocator::Place(unsigned int width, unsigned int height, ShadowAtlasRect & rect)
+    {
+        // holes first, so the skyline only grows when nothing freed fits
+        return PlaceInFreeRects(width, height, rect) || PlaceOnSkyline(width, height, rect);
+    }
+
+    bool ShadowAtlasAllocator::PlaceInFreeRects(unsigned int width, unsigned int height, ShadowAtlasRect & rect)
+    {
+        // best short side fit
+        size_t       best = m_FreeRects.size();
+        unsigned int bestShortSide = 0xffffffff;
+        unsigned int bestLongSide = 0xffffffff;
+
+        for (size_t i = 0; i < m_FreeRects.size(); i++)
+        {
+            const ShadowAtlasRect & free = m_FreeRects[i];
+            if (free.m_Width < width || free.m_Height < height)
+            {
+                continue;
+            }
+
+            const unsigned int leftoverW = free.m_Width - width;
+            const unsigned int leftoverH = free.m_Height - height;
+            const unsigned int shortSide = std::min(leftoverW, leftoverH);
+            const unsigned int longSide = std::max(leftoverW, leftoverH);
+
+            if (shortSide < bestShortSide || (shortSide == bestShortSide && longSide < bestLongSide))
+            {
+                best = i;
+                bestShortSide = shortSide;
+                bestLongSide = longSide;
+            }
+        }
+
+        if (best == m_FreeRects.size())
+        {
+            return false;
+        }
+
+        const ShadowAtlasRect free = m_FreeRects[best];
+        m_FreeRects[best] = m_FreeRects.back();
+        m_FreeRects.pop_back();
+
+        rect.m_X = free.m_X;
+        rect.m_Y = free.m_Y;
+        rect.m_Width = width;
+        rect.m_Height = height;
+
+        // split along the shorter leftover axis, so the larger piece stays as big as possible
+        const unsigned int leftoverW = free.m_Width - width;
+        const unsigned int leftoverH = free.m_Height - height;
+
+        ShadowAtlasRect right = { free.m_X + width, free.m_Y, leftoverW, 0 };
+        ShadowAtlasRect top = { free.m_X, free.m_Y + height, 0, leftoverH };
+
+        if (leftoverW < leftoverH)
+        {
+            right.m_Height = height;
+            top.m_Width = free.m_Width;
+        }
+        else
+        {
+            right.m_Height = free.m_Height;
+            top.m_Width = width;
+        }
+
+        if (right.m_Width > 0 && right.m_Height > 0) { AddFreeRect(right); }
+        if (top.m_Width > 0 && top.m_Height > 0)     { AddFreeRect(top); }
+
+        return true;
+    }
+
+    bool ShadowAtlasAllocator::FitSkyline(size_t node, unsigned int width, unsigned int height, unsigned int & y) const
+    {
+        if (m_Skyline[node].m_X + width > m_Width)
+        {
+            return false;
+        }
+
+        // the rect rests on the highest node it spans
+        unsigned int left = width;
+        y = 0;
+        for (size_t i = node; left > 0; i++)
+        {
+            if (i == m_Skyline.size())
+            {
+                return false;
+            }
+
+            y = std::max(y, m_Skyline[i].m_Y);
+            if (y + height > m_Height)
+            {
+                return false;
+            }
+
+            left -= std::min(left, m_Skyline[i].m_Width);
+        }
+
+        return true;
+    }
+
+    bool ShadowAtlasAllocator::PlaceOnSkyline(unsigned int width, unsigned int height, ShadowAtlasRect & rect)
+    {
+        // bottom-left: lowest top edge, then narrowest node
+        size_t       best = m_Skyline.size();
+        unsigned int bestTop = 0xffffffff;
+        unsigned int bestWidth = 0xffffffff;
+        unsigned int bestY = 0;
+
+        for (size_t i = 0; i < m_Skyline.size(); i++)
+        {
+            unsigned int y;
+            if (FitSkyline(i, width, height, y) == false)
+            {
+                continue;
+            }
+
+            if (y + height < bestTop || (y + height == bestTop && m_Skyline[i].m_Width < bestWidth))
+            {
+                best = i;
+                bestTop = y + height;
+                bestWidth = m_Skyline[i].m_Width;
+                bestY = y;
+            }
+        }
+
+        if (best == m_Skyline.size())
+        {
+            return false;
+        }
+
+        rect.m_X = m_Skyline[best].m_X;
+        rect.m_Y = bestY;
+        rect.m_Width = width;
+        rect.m_Height = height;
+
+        // the gaps under the rect become free rects instead of being lost
+        const unsigned int right = rect.m_X + width;
+        size_t             last = best;
+        for (; last < m_Skyline.size() && m_Skyline[last].m_X < right; last++)
+        {
+            const SkylineNode & node = m_Skyline[last];
+            const unsigned int  gapRight = std::min(node.m_X + node.m_Width, right);
+
+            if (node.m_Y < bestY)
+            {
+                const ShadowAtlasRect gap = { node.m_X, node.m_Y, gapRight - node.m_X, bestY - node.m_Y };
+                AddFreeRect(gap);
+            }
+        }
+
+        // replace the covered nodes with the new one, keeping what sticks out of the last one
+        const SkylineNode & tail = m_Skyline[last - 1];
+        const unsigned int  tailRight = tail.m_X + tail.m_Width;
+        const SkylineNode   remainder = { right, tail.m_Y, tailRight > right ? tailRight - right : 0 };
+
+        const SkylineNode added = { rect.m_X, bestY + height, width };
+        m_Skyline.erase(m_Skyline.begin() + best, m_Skyline.begin() + last);
+        m_Skyline.insert(m_Skyline.begin() + best, added);
+        if (remainder.m_Width > 0)
+        {
+            m_Skyline.insert(m_Skyline.begin() + best + 1, remainder);
+        }
+
+        // merge neighbours at the same height
+        for (size_t i = 0; i + 1 < m_Skyline.size(); )
+        {
+            if (m_Skyline[i].m_Y == m_Skyline[i + 1].m_Y)
+            {
+                m_Skyline[i].m_Width += m_Skyline[i + 1].m_Width;
+                m_Skyline.erase(m_Skyline.begin() + i + 1);
+            }
+            else
+            {
+                i++;
+            }
+        }
+
+        return true;
+    }
+
+    void ShadowAtlasAllocator::AddFreeRect(const ShadowAtlasRect & rect)
+    {
+        ShadowAtlasRect merged = rect;
+
+        // glue free rects that share a full edge, so freeing neighbours gives back a large rect
+        for (bool found = true; found == true; )
+        {
+            found = false;
+            for (size_t i = 0; i < m_FreeRects.size(); i++)
+            {
+                const ShadowAtlasRect & free = m_FreeRects[i];
+
+                const bool sameColumn = free.m_X == merged.m_X && free.m_Width == merged.m_Width &&
+                                        (free.m_Y + free.m_Height == merged.m_Y || merged.m_Y + merged.m_Height == free.m_Y);
+                const bool sameRow = free.m_Y == merged.m_Y && free.m_Height == merged.m_Height &&
+                                     (free.m_X + free.m_Width == merged.m_X || merged.m_X + merged.m_Width == free.m_X);
+
+                if (sameColumn == true)
+                {
+                    merged.m_Y = std::min(merged.m_Y, free.m_Y);
+                    merged.m_Height += free.m_Height;
+                }
+                else if (sameRow == true)
+                {
+                    merged.m_X = std::min(merged.m_X, free.m_X);
+                    merged.m_Width += free.m_Width;
+                }
+                else
+                {
+                    continue;
+                }
+
+                m_FreeRects[i] = m_FreeRects.back();
+                m_FreeRects.pop_back();
+                found = true;
+                break;
+            }
+        }
+
+        m_FreeRects.push_back(merged);
+    }
+}
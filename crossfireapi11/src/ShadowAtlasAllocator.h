@@ -0,0 +1,117 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//--------------------------------------------------------------------------------------
+// File: ShadowAtlasAllocator.h
+//
+// Hands out variable size rectangles of a shadow atlas, one per light or cube face.
+//
+// New regions are placed on a skyline (bottom-left rule). The gaps a placement leaves
+// under it, and the rects of freed regions, go to a free list that later allocations
+// try first, splitting a free rect guillotine style. A region never moves while it
+// lives, so content cached in it and the transfer rects derived from it stay valid;
+// only Defragment() repacks the atlas, and it bumps the generation of every region it
+// moves so callers know to render those again.
+//
+// This code has no dependency on Windows, D3D11 or AGS.
+//--------------------------------------------------------------------------------------
+#ifndef SHADOW_ATLAS_ALLOCATOR_H
+#define SHADOW_ATLAS_ALLOCATOR_H
+
+#include <stddef.h>
+#include <vector>
+
+namespace AMD
+{
+    static const unsigned int SHADOW_ATLAS_INVALID_REGION = 0xffffffff;
+
+    struct ShadowAtlasRect
+    {
+        unsigned int m_X;
+        unsigned int m_Y;
+        unsigned int m_Width;
+        unsigned int m_Height;
+    };
+
+    class ShadowAtlasAllocator
+    {
+    public:
+        ShadowAtlasAllocator();
+
+        // forgets every region
+        void                    Init(unsigned int width, unsigned int height);
+
+        // SHADOW_ATLAS_INVALID_REGION if there is no room, Defragment() may make some
+        unsigned int            Allocate(unsigned int width, unsigned int height);
+        void                    Free(unsigned int region);
+
+        // repacks every region, largest first; returns the number of regions that moved,
+        // or 0 if the repacked layout wouldn't fit (the layout is then left as it was)
+        unsigned int            Defragment();
+
+        bool                    IsValid(unsigned int region) const;
+        const ShadowAtlasRect & GetRect(unsigned int region) const;
+
+        // bumped every time Defragment() moves the region
+        unsigned int            GetGeneration(unsigned int region) const;
+
+        unsigned int            GetWidth() const { return m_Width; }
+        unsigned int            GetHeight() const { return m_Height; }
+        unsigned int            GetRegionCount() const { return m_LiveCount; }
+
+        // allocated texels over atlas texels
+        float                   GetOccupancy() const;
+
+    private:
+        struct SkylineNode
+        {
+            unsigned int m_X;
+            unsigned int m_Y;
+            unsigned int m_Width;
+        };
+
+        struct Region
+        {
+            ShadowAtlasRect m_Rect;
+            unsigned int    m_Generation;
+            bool            m_Live;
+        };
+
+        void                    Clear();
+        bool                    Place(unsigned int width, unsigned int height, ShadowAtlasRect & rect);
+        bool                    PlaceInFreeRects(unsigned int width, unsigned int height, ShadowAtlasRect & rect);
+        bool                    PlaceOnSkyline(unsigned int width, unsigned int height, ShadowAtlasRect & rect);
+        bool                    FitSkyline(size_t node, unsigned int width, unsigned int height, unsigned int & y) const;
+        void                    AddFreeRect(const ShadowAtlasRect & rect);
+
+        unsigned int                 m_Width;
+        unsigned int                 m_Height;
+        unsigned int                 m_LiveCount;
+        unsigned long long           m_AllocatedTexels;
+
+        std::vector<SkylineNode>     m_Skyline;
+        std::vector<ShadowAtlasRect> m_FreeRects;
+        std::vector<Region>          m_Regions;
+        std::vector<unsigned int>    m_FreeRegions;  // unused entries of m_Regions
+    };
+}
+
+#endif // SHADOW_ATLAS_ALLOCATOR_H
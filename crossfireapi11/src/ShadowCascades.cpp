@@ -0,0 +1,254 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//--------------------------------------------------------------------------------------
+// File: ShadowCascades.cpp
+//
+// Split depths, bounding spheres and texel snapped views of stable cascaded shadow maps.
+//--------------------------------------------------------------------------------------
+#include "ShadowCascades.h"
+
+#include <math.h>
+#include <algorithm>
+
+namespace AMD
+{
+    static void Normalize(float v[3])
+    {
+        const float length = sqrtf(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+        if (length > 0.0f)
+        {
+            v[0] /= length; v[1] /= length; v[2] /= length;
+        }
+    }
+
+    static void Cross(const float a[3], const float b[3], float r[3])
+    {
+        r[0] = a[1] * b[2] - a[2] * b[1];
+        r[1] = a[2] * b[0] - a[0] * b[2];
+        r[2] = a[0] * b[1] - a[1] * b[0];
+    }
+
+    static float Dot(const float a[3], const float b[3])
+    {
+        return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+    }
+
+    // XMMatrixLookToLH
+    static void LookTo(const float eye[3], const float direction[3], const float up[3], float view[16])
+    {
+        float f[3] = { direction[0], direction[1], direction[2] };
+        Normalize(f);
+        float r[3];
+        Cross(up, f, r);
+        Normalize(r);
+        float u[3];
+        Cross(f, r, u);
+
+        view[0] = r[0]; view[1] = u[0]; view[2] = f[0];  view[3] = 0.0f;
+        view[4] = r[1]; view[5] = u[1]; view[6] = f[1];  view[7] = 0.0f;
+        view[8] = r[2]; view[9] = u[2]; view[10] = f[2]; view[11] = 0.0f;
+        view[12] = -Dot(r, eye);
+        view[13] = -Dot(u, eye);
+        view[14] = -Dot(f, eye);
+        view[15] = 1.0f;
+    }
+
+    // XMMatrixOrthographicLH, square
+    static void Orthographic(float width, float zNear, float zFar, float projection[16])
+    {
+        for (unsigned int i = 0; i < 16; i++)
+        {
+            projection[i] = 0.0f;
+        }
+        projection[0] = 2.0f / width;
+        projection[5] = 2.0f / width;
+        projection[10] = 1.0f / (zFar - zNear);
+        projection[14] = -zNear / (zFar - zNear);
+        projection[15] = 1.0f;
+    }
+
+    void ComputeShadowCascadeSplits(float zNear, float zFar, float lambda, unsigned int cascadeCount, float * pSplits)
+    {
+        for (unsigned int i = 0; i <= cascadeCount; i++)
+        {
+            const float t = (float)i / (float)cascadeCount;
+            const float logarithmic = zNear * powf(zFar / zNear, t);
+            const float uniform = zNear + (zFar - zNear) * t;
+            pSplits[i] = lambda * logarithmic + (1.0f - lambda) * uniform;
+        }
+
+        // exact ends, pow doesn't round trip
+        pSplits[0] = zNear;
+        pSplits[cascadeCount] = zFar;
+    }
+
+    ShadowCascadeSphere FitShadowCascadeSphere(const ShadowCascadeViewer & viewer, float zNear, float zFar)
+    {
+        // the corners of a slice are k * depth away from the view axis. The center is on the
+        // axis where the near and far corners are equally far, unless that's beyond the far
+        // plane: then the far corners alone set the sphere
+        const float tanY = tanf(viewer.m_Fov * 0.5f);
+        const float tanX = tanY * viewer.m_Aspect;
+        const float k2 = tanX * tanX + tanY * tanY;
+
+        float depth = (zFar + zNear) * (1.0f + k2) * 0.5f;
+        float radius = 0.0f;
+        if (depth >= zFar)
+        {
+            depth = zFar;
+            radius = zFar * sqrtf(k2);
+        }
+        else
+        {
+            radius = sqrtf((depth - zNear) * (depth - zNear) + zNear * zNear * k2);
+        }
+
+        float direction[3] = { viewer.m_Direction[0], viewer.m_Direction[1], viewer.m_Direction[2] };
+        Normalize(direction);
+
+        ShadowCascadeSphere sphere;
+        sphere.m_Center[0] = viewer.m_Position[0] + direction[0] * depth;
+        sphere.m_Center[1] = viewer.m_Position[1] + direction[1] * depth;
+        sphere.m_Center[2] = viewer.m_Position[2] + direction[2] * depth;
+        sphere.m_Radius = radius;
+        return sphere;
+    }
+
+    void PlaceShadowCascade(const ShadowCascadeSphere & sphere, const float * pLightDirection, unsigned int resolution,
+                            float casterDistance, ShadowCascade * pCascade)
+    {
+        float f[3] = { pLightDirection[0], pLightDirection[1], pLightDirection[2] };
+        Normalize(f);
+
+        float up[3] = { 0.0f, 1.0f, 0.0f };
+        if (fabsf(f[1]) > 0.99f) // straight down or up
+        {
+            up[1] = 0.0f;
+            up[2] = 1.0f;
+        }
+
+        // the light space basis doesn't depend on the viewer, only the eye moves
+        float r[3];
+        Cross(up, f, r);
+        Normalize(r);
+        float u[3];
+        Cross(f, r, u);
+
+        // resolution - 1 texels across the sphere leave half a texel on both sides for the
+        // snapping, which moves the eye by up to half a texel
+        const unsigned int texels = std::max(resolution, 2u);
+        const float        texel = 2.0f * sphere.m_Radius / (float)(texels - 1);
+        const float        x = floorf(Dot(r, sphere.m_Center) / texel + 0.5f) * texel;
+        const float        y = floorf(Dot(u, sphere.m_Center) / texel + 0.5f) * texel;
+        const float        z = Dot(f, sphere.m_Center) - sphere.m_Radius - casterDistance;
+
+        for (unsigned int i = 0; i < 3; i++)
+        {
+            pCascade->m_Eye[i] = r[i] * x + u[i] * y + f[i] * z;
+            pCascade->m_LookAt[i] = pCascade->m_Eye[i] + f[i];
+            pCascade->m_Up[i] = up[i];
+        }
+
+        pCascade->m_Sphere = sphere;
+        pCascade->m_Resolution = resolution;
+        pCascade->m_Width = texel * (float)texels;
+        pCascade->m_NearPlane = 0.0f;
+        pCascade->m_FarPlane = casterDistance + 2.0f * sphere.m_Radius;
+
+        LookTo(pCascade->m_Eye, f, up, pCascade->m_View);
+        Orthographic(pCascade->m_Width, pCascade->m_NearPlane, pCascade->m_FarPlane, pCascade->m_Projection);
+    }
+
+    ShadowCascades::ShadowCascades()
+    {
+        Init(4, 1);
+        SetRange(1.0f, 50.0f, 0.75f, 25.0f);
+    }
+
+    void ShadowCascades::Init(unsigned int cascadeCount, unsigned int gpuCount)
+    {
+        m_CascadeCount = std::min(std::max(cascadeCount, 1u), SHADOW_CASCADE_MAX_COUNT);
+        m_GpuCount = std::max(gpuCount, 1u);
+
+        for (unsigned int i = 0; i < SHADOW_CASCADE_MAX_COUNT; i++)
+        {
+            m_Interval[i] = 1;
+            m_PendingFrames[i] = 0;
+            m_Valid[i] = false;
+        }
+    }
+
+    void ShadowCascades::SetRange(float zNear, float zFar, float lambda, float casterDistance)
+    {
+        m_Near = zNear;
+        m_Far = zFar;
+        m_Lambda = lambda;
+        m_CasterDistance = casterDistance;
+
+        for (unsigned int i = 0; i < SHADOW_CASCADE_MAX_COUNT; i++)
+        {
+            m_Valid[i] = false;
+        }
+    }
+
+    void ShadowCascades::SetUpdateInterval(unsigned int cascade, unsigned int frames)
+    {
+        m_Interval[cascade] = std::max(frames, 1u);
+    }
+
+    unsigned int ShadowCascades::Update(const ShadowCascadeViewer & viewer, const float * pLightDirection, const unsigned int * pResolution,
+                                        unsigned int frame, unsigned int * pCascades)
+    {
+        float splits[SHADOW_CASCADE_MAX_COUNT + 1];
+        ComputeShadowCascadeSplits(m_Near, m_Far, m_Lambda, m_CascadeCount, splits);
+
+        unsigned int count = 0;
+        for (unsigned int i = 0; i < m_CascadeCount; i++)
+        {
+            ShadowCascade & cascade = m_Cascade[i];
+
+            // offset by the cascade, the cascades with the same interval aren't all fit in the same frame
+            const bool due = m_Valid[i] == false || cascade.m_Resolution != pResolution[i] || (frame + i) % m_Interval[i] == 0;
+
+            if (due == true)
+            {
+                const ShadowCascadeSphere sphere = FitShadowCascadeSphere(viewer, splits[i], splits[i + 1]);
+                PlaceShadowCascade(sphere, pLightDirection, pResolution[i], m_CasterDistance, &cascade);
+
+                cascade.m_SplitNear = splits[i];
+                cascade.m_SplitFar = splits[i + 1];
+                cascade.m_Frame = frame;
+
+                m_Valid[i] = true;
+                m_PendingFrames[i] = m_GpuCount;
+            }
+
+            if (m_PendingFrames[i] > 0)
+            {
+                m_PendingFrames[i]--;
+                pCascades[count++] = i;
+            }
+        }
+
+        return count;
+    }
+}
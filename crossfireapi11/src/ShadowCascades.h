@@ -0,0 +1,134 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//--------------------------------------------------------------------------------------
+// File: ShadowCascades.h
+//
+// Stable cascaded shadow maps of a directional light.
+//
+// The view depth range of the viewer is partitioned with the practical split scheme, a
+// blend of the logarithmic and the uniform splits. Every slice of the view frustum is
+// enclosed in its smallest bounding sphere, which only depends on the depths of the
+// slice and the field of view of the viewer: its radius doesn't change as the viewer
+// turns, and so neither does the size of the cascade texels. The orthographic view of a
+// cascade is then moved in whole texels of the light space grid, so a static caster is
+// rasterized the same way from one frame to the next and its shadow edges don't shimmer.
+//
+// Each cascade has its own update interval. The far cascades cover more of the scene at
+// a lower resolution, they can be fit and rendered less often, which saves shadow map
+// rendering and, with the Crossfire API, the transfers of their regions. A cascade keeps
+// its view between two fits, so it always matches the depth it was rendered with, and a
+// fitted cascade is rendered for one frame per AFR GPU.
+//
+// This code has no dependency on Windows, D3D11 or AGS.
+//--------------------------------------------------------------------------------------
+#ifndef SHADOW_CASCADES_H
+#define SHADOW_CASCADES_H
+
+namespace AMD
+{
+    static const unsigned int SHADOW_CASCADE_MAX_COUNT = 6;     // ShadowFX_Desc::m_MaxLightCount
+
+    // what the cascades depend on, not the roll of the viewer
+    struct ShadowCascadeViewer
+    {
+        float        m_Position[3];
+        float        m_Direction[3];
+        float        m_Fov;             // vertical, in radians
+        float        m_Aspect;          // width / height
+    };
+
+    struct ShadowCascadeSphere
+    {
+        float        m_Center[3];
+        float        m_Radius;
+    };
+
+    struct ShadowCascade
+    {
+        float               m_SplitNear;    // view depths of the slice of the viewer
+        float               m_SplitFar;
+        ShadowCascadeSphere m_Sphere;
+        unsigned int        m_Resolution;   // texels of the region, the size of the snapping grid
+        float               m_Eye[3];       // on the texel grid, behind the sphere
+        float               m_LookAt[3];
+        float               m_Up[3];
+        float               m_Width;        // of the orthographic projection, square
+        float               m_NearPlane;
+        float               m_FarPlane;
+        float               m_View[16];     // row major, left handed, row vectors (D3D convention)
+        float               m_Projection[16];
+        unsigned int        m_Frame;        // of the last fit
+    };
+
+    // the practical split scheme: lambda 1 is logarithmic, 0 is uniform. pSplits gets
+    // cascadeCount + 1 depths from zNear to zFar
+    void                ComputeShadowCascadeSplits(float zNear, float zFar, float lambda, unsigned int cascadeCount, float * pSplits);
+
+    // the smallest sphere around the slice of the view frustum between 2 view depths
+    ShadowCascadeSphere FitShadowCascadeSphere(const ShadowCascadeViewer & viewer, float zNear, float zFar);
+
+    // the orthographic view of the sphere along the light direction, its eye moved to the
+    // nearest texel of the light space grid. Casters up to casterDistance in front of the
+    // sphere, towards the light, are in the depth range
+    void                PlaceShadowCascade(const ShadowCascadeSphere & sphere, const float * pLightDirection, unsigned int resolution,
+                                           float casterDistance, ShadowCascade * pCascade);
+
+    class ShadowCascades
+    {
+    public:
+        ShadowCascades();                   // 4 cascades, 1 GPU
+
+        // every cascade is fit by the next Update() and rendered once per GPU
+        void                  Init(unsigned int cascadeCount, unsigned int gpuCount);
+
+        // the view depths the cascades cover, see ComputeShadowCascadeSplits
+        void                  SetRange(float zNear, float zFar, float lambda, float casterDistance);
+
+        // a cascade is fit again every frames frames, 1 is every frame
+        void                  SetUpdateInterval(unsigned int cascade, unsigned int frames);
+        unsigned int          GetUpdateInterval(unsigned int cascade) const { return m_Interval[cascade]; }
+
+        // fits the cascades whose interval elapsed or whose resolution changed, and returns
+        // the cascades to render this frame: the fitted ones, and the ones fitted in the
+        // last gpuCount - 1 frames for the other AFR GPUs
+        unsigned int          Update(const ShadowCascadeViewer & viewer, const float * pLightDirection, const unsigned int * pResolution,
+                                     unsigned int frame, unsigned int * pCascades);
+
+        unsigned int          GetCascadeCount() const { return m_CascadeCount; }
+        const ShadowCascade & GetCascade(unsigned int cascade) const { return m_Cascade[cascade]; }
+
+    private:
+        unsigned int          m_CascadeCount;
+        unsigned int          m_GpuCount;
+        float                 m_Near;
+        float                 m_Far;
+        float                 m_Lambda;
+        float                 m_CasterDistance;
+
+        ShadowCascade         m_Cascade[SHADOW_CASCADE_MAX_COUNT];
+        unsigned int          m_Interval[SHADOW_CASCADE_MAX_COUNT];
+        unsigned int          m_PendingFrames[SHADOW_CASCADE_MAX_COUNT];  // frames left to render a fitted cascade
+        bool                  m_Valid[SHADOW_CASCADE_MAX_COUNT];
+    };
+}
+
+#endif // SHADOW_CASCADES_H
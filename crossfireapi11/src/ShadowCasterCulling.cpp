@@ -0,0 +1,200 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//--------------------------------------------------------------------------------------
+// File: ShadowCasterCulling.cpp
+//
+// Culls shadow casters against the frustums of the shadow map faces.
+//--------------------------------------------------------------------------------------
+#include "ShadowCasterCulling.h"
+
+#include <stddef.h>
+#include <math.h>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE__)
+#define SHADOW_CASTER_CULLING_SSE 1
+#include <xmmintrin.h>
+#else
+#define SHADOW_CASTER_CULLING_SSE 0
+#endif
+
+namespace AMD
+{
+    static const unsigned int PLANES_PER_FACE = 6;
+    static const unsigned int PLANES_PER_GROUP = 4;
+
+    ShadowCasterBounds TransformShadowCasterBounds(const ShadowCasterBounds & bounds, const float * pModelMatrix)
+    {
+        const float * m = pModelMatrix;
+
+        ShadowCasterBounds result;
+        for (int c = 0; c < 3; c++)
+        {
+            result.m_Center[c] = bounds.m_Center[0] * m[c] + bounds.m_Center[1] * m[4 + c] + bounds.m_Center[2] * m[8 + c] + m[12 + c];
+            result.m_Extents[c] = bounds.m_Extents[0] * fabsf(m[c]) + bounds.m_Extents[1] * fabsf(m[4 + c]) + bounds.m_Extents[2] * fabsf(m[8 + c]);
+        }
+        return result;
+    }
+
+    ShadowCasterBounds MergeShadowCasterBounds(const ShadowCasterBounds & a, const ShadowCasterBounds & b)
+    {
+        ShadowCasterBounds result;
+        for (int c = 0; c < 3; c++)
+        {
+            const float aMin = a.m_Center[c] - a.m_Extents[c], aMax = a.m_Center[c] + a.m_Extents[c];
+            const float bMin = b.m_Center[c] - b.m_Extents[c], bMax = b.m_Center[c] + b.m_Extents[c];
+            const float minValue = aMin < bMin ? aMin : bMin;
+            const float maxValue = aMax > bMax ? aMax : bMax;
+
+            result.m_Center[c] = (minValue + maxValue) * 0.5f;
+            result.m_Extents[c] = (maxValue - minValue) * 0.5f;
+        }
+        return result;
+    }
+
+    ShadowCasterCuller::ShadowCasterCuller()
+        : m_FaceCount(0)
+        , m_GroupCount(0)
+    {
+    }
+
+    void ShadowCasterCuller::SetFaces(const float * pPlanes, unsigned int faceCount)
+    {
+        m_FaceCount = pPlanes == NULL ? 0 : (faceCount > SHADOW_CASTER_CULLING_MAX_FACE_COUNT ? SHADOW_CASTER_CULLING_MAX_FACE_COUNT : faceCount);
+
+        const unsigned int planeCount = m_FaceCount * PLANES_PER_FACE;
+        m_GroupCount = (planeCount + PLANES_PER_GROUP - 1) / PLANES_PER_GROUP;
+        m_Groups.assign(m_GroupCount * GROUP_FLOAT_COUNT, 0.0f);
+
+        for (unsigned int group = 0; group < m_GroupCount; group++)
+        {
+            float * g = &m_Groups[group * GROUP_FLOAT_COUNT];
+
+            for (unsigned int lane = 0; lane < PLANES_PER_GROUP; lane++)
+            {
+                const unsigned int plane = group * PLANES_PER_GROUP + lane;
+
+                // the padding planes keep everything: 0 * x + 0 * y + 0 * z + 1 >= 0
+                const float * p = plane < planeCount ? &pPlanes[plane * 4] : NULL;
+                g[0 + lane] = p != NULL ? p[0] : 0.0f;
+                g[4 + lane] = p != NULL ? p[1] : 0.0f;
+                g[8 + lane] = p != NULL ? p[2] : 0.0f;
+                g[12 + lane] = p != NULL ? p[3] : 1.0f;
+                g[16 + lane] = fabsf(g[0 + lane]);
+                g[20 + lane] = fabsf(g[4 + lane]);
+                g[24 + lane] = fabsf(g[8 + lane]);
+            }
+        }
+    }
+
+    unsigned int ShadowCasterCuller::GetFaceMask(unsigned long long outsidePlanes) const
+    {
+        unsigned int mask = 0;
+        for (unsigned int face = 0; face < m_FaceCount; face++)
+        {
+            if (((outsidePlanes >> (face * PLANES_PER_FACE)) & ((1ULL << PLANES_PER_FACE) - 1)) == 0)
+            {
+                mask |= 1u << face;
+            }
+        }
+        return mask;
+    }
+
+    void ShadowCasterCuller::CullReference(const ShadowCasterBounds * pCasters, unsigned int casterCount, unsigned int * pFaceMasks) const
+    {
+        if (pCasters == NULL || pFaceMasks == NULL) { return; }
+
+        for (unsigned int i = 0; i < casterCount; i++)
+        {
+            const ShadowCasterBounds & b = pCasters[i];
+            unsigned long long         outsidePlanes = 0;
+
+            for (unsigned int group = 0; group < m_GroupCount; group++)
+            {
+                const float * g = &m_Groups[group * GROUP_FLOAT_COUNT];
+
+                for (unsigned int lane = 0; lane < PLANES_PER_GROUP; lane++)
+                {
+                    // the distance of the box corner furthest along the plane normal
+                    float distance = g[12 + lane];
+                    distance += g[0 + lane] * b.m_Center[0];
+                    distance += g[4 + lane] * b.m_Center[1];
+                    distance += g[8 + lane] * b.m_Center[2];
+                    distance += g[16 + lane] * b.m_Extents[0];
+                    distance += g[20 + lane] * b.m_Extents[1];
+                    distance += g[24 + lane] * b.m_Extents[2];
+
+                    if (distance < 0.0f)
+                    {
+                        outsidePlanes |= 1ULL << (group * PLANES_PER_GROUP + lane);
+                    }
+                }
+            }
+
+            pFaceMasks[i] = GetFaceMask(outsidePlanes);
+        }
+    }
+
+#if SHADOW_CASTER_CULLING_SSE
+    void ShadowCasterCuller::Cull(const ShadowCasterBounds * pCasters, unsigned int casterCount, unsigned int * pFaceMasks) const
+    {
+        if (pCasters == NULL || pFaceMasks == NULL) { return; }
+
+        const __m128 zero = _mm_setzero_ps();
+
+        for (unsigned int i = 0; i < casterCount; i++)
+        {
+            const ShadowCasterBounds & b = pCasters[i];
+
+            const __m128 centerX = _mm_set1_ps(b.m_Center[0]);
+            const __m128 centerY = _mm_set1_ps(b.m_Center[1]);
+            const __m128 centerZ = _mm_set1_ps(b.m_Center[2]);
+            const __m128 extentX = _mm_set1_ps(b.m_Extents[0]);
+            const __m128 extentY = _mm_set1_ps(b.m_Extents[1]);
+            const __m128 extentZ = _mm_set1_ps(b.m_Extents[2]);
+
+            unsigned long long outsidePlanes = 0;
+
+            for (unsigned int group = 0; group < m_GroupCount; group++)
+            {
+                const float * g = &m_Groups[group * GROUP_FLOAT_COUNT];
+
+                __m128 distance = _mm_loadu_ps(g + 12);
+                distance = _mm_add_ps(distance, _mm_mul_ps(_mm_loadu_ps(g + 0), centerX));
+                distance = _mm_add_ps(distance, _mm_mul_ps(_mm_loadu_ps(g + 4), centerY));
+                distance = _mm_add_ps(distance, _mm_mul_ps(_mm_loadu_ps(g + 8), centerZ));
+                distance = _mm_add_ps(distance, _mm_mul_ps(_mm_loadu_ps(g + 16), extentX));
+                distance = _mm_add_ps(distance, _mm_mul_ps(_mm_loadu_ps(g + 20), extentY));
+                distance = _mm_add_ps(distance, _mm_mul_ps(_mm_loadu_ps(g + 24), extentZ));
+
+                outsidePlanes |= (unsigned long long)_mm_movemask_ps(_mm_cmplt_ps(distance, zero)) << (group * PLANES_PER_GROUP);
+            }
+
+            pFaceMasks[i] = GetFaceMask(outsidePlanes);
+        }
+    }
+#else
+    void ShadowCasterCuller::Cull(const ShadowCasterBounds * pCasters, unsigned int casterCount, unsigned int * pFaceMasks) const
+    {
+        CullReference(pCasters, casterCount, pFaceMasks);
+    }
+#endif
+}
@@ -0,0 +1,89 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//--------------------------------------------------------------------------------------
+// File: ShadowCasterCulling.h
+//
+// Finds the shadow map faces every caster touches, so that a face only draws the casters
+// inside its frustum and a face without casters doesn't draw at all.
+//
+// Casters are world space axis aligned boxes. The faces are given as the 6 plane
+// equations AMD::ExtractPlanesFromFrustum (amd_sdk) extracts from their view projection,
+// a point being inside where a * x + b * y + c * z + d >= 0; the planes don't have to be
+// normalized. A box is outside a face if it is entirely behind one of its planes, which
+// may keep a box that only comes close to a corner of the face.
+//
+// The planes of all the faces are laid out 4 at a time, so that Cull() tests a caster
+// against every plane of every face in one pass of SSE compares when SSE is available.
+//
+// This code has no dependency on Windows, D3D11 or AGS.
+//--------------------------------------------------------------------------------------
+#ifndef SHADOW_CASTER_CULLING_H
+#define SHADOW_CASTER_CULLING_H
+
+#include <vector>
+
+namespace AMD
+{
+    static const unsigned int SHADOW_CASTER_CULLING_MAX_FACE_COUNT = 8;
+
+    struct ShadowCasterBounds
+    {
+        float m_Center[3];
+        float m_Extents[3];                 // half of the size along each axis
+    };
+
+    // the world space box around a local box transformed by a row major model matrix
+    // (D3D convention, row vectors)
+    ShadowCasterBounds TransformShadowCasterBounds(const ShadowCasterBounds & bounds, const float * pModelMatrix);
+
+    // the box around both boxes
+    ShadowCasterBounds MergeShadowCasterBounds(const ShadowCasterBounds & a, const ShadowCasterBounds & b);
+
+    class ShadowCasterCuller
+    {
+    public:
+        ShadowCasterCuller();               // no faces
+
+        // pPlanes holds faceCount x 6 planes of 4 floats, in the order ExtractPlanesFromFrustum
+        // writes them; up to SHADOW_CASTER_CULLING_MAX_FACE_COUNT faces
+        void         SetFaces(const float * pPlanes, unsigned int faceCount);
+        unsigned int GetFaceCount() const { return m_FaceCount; }
+
+        // bit f of pFaceMasks[i] is set if caster i touches face f
+        void         Cull(const ShadowCasterBounds * pCasters, unsigned int casterCount, unsigned int * pFaceMasks) const;
+
+        // the same without SSE, the reference the SSE path is checked against
+        void         CullReference(const ShadowCasterBounds * pCasters, unsigned int casterCount, unsigned int * pFaceMasks) const;
+
+    private:
+        // a group of 4 planes: a[4] b[4] c[4] d[4] |a|[4] |b|[4] |c|[4]
+        static const unsigned int GROUP_FLOAT_COUNT = 28;
+
+        unsigned int GetFaceMask(unsigned long long outsidePlanes) const;
+
+        unsigned int       m_FaceCount;
+        unsigned int       m_GroupCount;
+        std::vector<float> m_Groups;
+    };
+}
+
+#endif // SHADOW_CASTER_CULLING_H
@@ -0,0 +1,166 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//--------------------------------------------------------------------------------------
+// File: ShadowFaceAffinity.cpp
+//
+// Assigns shadow map face updates to AFR GPUs and picks the faces worth transferring.
+//--------------------------------------------------------------------------------------
+#include "ShadowFaceAffinity.h"
+
+namespace AMD
+{
+    static const unsigned int MAX_TRACKED_GPU_COUNT = 32;
+
+    ShadowFaceAffinity::ShadowFaceAffinity()
+        : m_MaxAge(0)
+    {
+        Init(1, 6);
+    }
+
+    void ShadowFaceAffinity::Init(unsigned int gpuCount, unsigned int faceCount)
+    {
+        m_GpuCount = gpuCount == 0 ? 1 : (gpuCount > MAX_TRACKED_GPU_COUNT ? MAX_TRACKED_GPU_COUNT : gpuCount);
+        m_FaceCount = faceCount == 0 ? 1 : faceCount;
+
+        m_Version.resize(m_GpuCount * m_FaceCount);
+        Reset();
+    }
+
+    void ShadowFaceAffinity::Reset()
+    {
+        for (size_t i = 0; i < m_Version.size(); i++)
+        {
+            m_Version[i] = 0;
+        }
+    }
+
+    unsigned int ShadowFaceAffinity::GetFace(unsigned int frame) const
+    {
+        const unsigned int gpu = frame % m_GpuCount;
+        const unsigned int gpuFrame = frame / m_GpuCount;
+
+        // spread the starting faces of the GPUs evenly over the faces
+        return (gpuFrame + gpu * m_FaceCount / m_GpuCount) % m_FaceCount;
+    }
+
+    void ShadowFaceAffinity::MarkRendered(unsigned int gpu, unsigned int face, unsigned int frame)
+    {
+        if (gpu < m_GpuCount && face < m_FaceCount)
+        {
+            m_Version[gpu * m_FaceCount + face] = frame + 1;
+        }
+    }
+
+    bool ShadowFaceAffinity::NeedsFace(unsigned int gpu, unsigned int target, unsigned int face, unsigned int frame) const
+    {
+        const unsigned int version = m_Version[gpu * m_FaceCount + face];
+        const unsigned int targetVersion = m_Version[target * m_FaceCount + face];
+
+        if (version <= targetVersion)
+        {
+            return false; // nothing newer to give
+        }
+
+        // the next frame target renders, in which it renders one face itself
+        const unsigned int targetFrame = frame + (target + m_GpuCount - gpu) % m_GpuCount;
+        if (GetFace(targetFrame) == face)
+        {
+            return false;
+        }
+
+        const unsigned int age = GetAge(target, face, targetFrame);
+        return age == SHADOW_FACE_AGE_UNKNOWN || age > m_MaxAge;
+    }
+
+    unsigned int ShadowFaceAffinity::GetFacesToSend(unsigned int gpu, unsigned int frame, bool broadcast, unsigned int * pFaces) const
+    {
+        if (gpu >= m_GpuCount || m_GpuCount < 2)
+        {
+            return 0;
+        }
+
+        unsigned int count = 0;
+        for (unsigned int face = 0; face < m_FaceCount; face++)
+        {
+            bool needed = false;
+            for (unsigned int i = 1; i < m_GpuCount && needed == false; i++)
+            {
+                needed = NeedsFace(gpu, (gpu + i) % m_GpuCount, face, frame);
+
+                if (broadcast == false)
+                {
+                    break; // only the next GPU receives the transfer
+                }
+            }
+
+            if (needed == true)
+            {
+                pFaces[count++] = face;
+            }
+        }
+
+        return count;
+    }
+
+    void ShadowFaceAffinity::MarkSent(unsigned int gpu, bool broadcast, const unsigned int * pFaces, unsigned int faceCount)
+    {
+        if (gpu >= m_GpuCount)
+        {
+            return;
+        }
+
+        for (unsigned int i = 1; i < m_GpuCount; i++)
+        {
+            const unsigned int target = (gpu + i) % m_GpuCount;
+
+            for (unsigned int j = 0; j < faceCount; j++)
+            {
+                const unsigned int face = pFaces[j];
+                if (face < m_FaceCount && m_Version[target * m_FaceCount + face] < m_Version[gpu * m_FaceCount + face])
+                {
+                    m_Version[target * m_FaceCount + face] = m_Version[gpu * m_FaceCount + face];
+                }
+            }
+
+            if (broadcast == false)
+            {
+                break;
+            }
+        }
+    }
+
+    unsigned int ShadowFaceAffinity::GetAge(unsigned int gpu, unsigned int face, unsigned int frame) const
+    {
+        if (gpu >= m_GpuCount || face >= m_FaceCount)
+        {
+            return SHADOW_FACE_AGE_UNKNOWN;
+        }
+
+        const unsigned int version = m_Version[gpu * m_FaceCount + face];
+        if (version == 0 || version > frame + 1)
+        {
+            return SHADOW_FACE_AGE_UNKNOWN;
+        }
+
+        return frame + 1 - version;
+    }
+}
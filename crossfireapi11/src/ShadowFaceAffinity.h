@@ -0,0 +1,88 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//--------------------------------------------------------------------------------------
+// File: ShadowFaceAffinity.h
+//
+// Assigns shadow map face updates to AFR GPUs so that every GPU keeps its own copy of
+// the shadow map fresh by itself, and only sends a face to another GPU when that GPU's
+// copy would otherwise be older than a configurable age.
+//
+// In AFR, GPU k renders frames k, k + N, k + 2N, ... Each GPU walks the faces in its own
+// frames, starting at a different face: with 2 GPUs and 6 faces GPU 0 renders 0, 1, 2,
+// ... and GPU 1 renders 3, 4, 5, ..., so between them the GPUs refresh a face every
+// frame while each GPU refreshes its own copy of a face every 6 of its frames. With a
+// max age of at least 6N - 1 frames nothing is ever transferred.
+//
+// Ages are counted in frames between the frame that rendered a face and the frame that
+// samples it. Up to 32 GPUs are tracked. This code has no dependency on Windows, D3D11
+// or AGS.
+//--------------------------------------------------------------------------------------
+#ifndef SHADOW_FACE_AFFINITY_H
+#define SHADOW_FACE_AFFINITY_H
+
+#include <stddef.h>
+#include <vector>
+
+namespace AMD
+{
+    static const unsigned int SHADOW_FACE_AGE_UNKNOWN = 0xffffffff;
+
+    class ShadowFaceAffinity
+    {
+    public:
+        ShadowFaceAffinity();               // 1 GPU, 6 faces
+
+        void         Init(unsigned int gpuCount, unsigned int faceCount);
+
+        // no GPU holds any face, e.g. after the shadow map was recreated
+        void         Reset();
+
+        void         SetMaxAge(unsigned int maxAge) { m_MaxAge = maxAge; }
+        unsigned int GetMaxAge() const { return m_MaxAge; }
+
+        // the face the GPU that renders frame updates in it
+        unsigned int GetFace(unsigned int frame) const;
+
+        void         MarkRendered(unsigned int gpu, unsigned int face, unsigned int frame);
+
+        // faces gpu has to send in frame so that the next GPU (or, for broadcasts, no other
+        // GPU) samples a face older than the max age in its next frame, if gpu has a newer copy
+        unsigned int GetFacesToSend(unsigned int gpu, unsigned int frame, bool broadcast, unsigned int * pFaces) const;
+
+        // the GPUs GetFacesToSend picked the faces for now hold gpu's copies of them
+        void         MarkSent(unsigned int gpu, bool broadcast, const unsigned int * pFaces, unsigned int faceCount);
+
+        // frames between the frame that rendered gpu's copy of face and frame, SHADOW_FACE_AGE_UNKNOWN if it never did
+        unsigned int GetAge(unsigned int gpu, unsigned int face, unsigned int frame) const;
+
+    private:
+        bool         NeedsFace(unsigned int gpu, unsigned int target, unsigned int face, unsigned int frame) const;
+
+        unsigned int m_GpuCount;
+        unsigned int m_FaceCount;
+        unsigned int m_MaxAge;
+
+        std::vector<unsigned int> m_Version;    // per GPU, per face: frame + 1 of the rendering, 0 means never
+    };
+}
+
+#endif // SHADOW_FACE_AFFINITY_H
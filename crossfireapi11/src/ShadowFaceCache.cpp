@@ -0,0 +1,128 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: ShadowFaceCache.cpp
+//
+// Remembers which AFR GPUs hold an up to date copy of each shadow map face.
+//--------------------------------------------------------------------------------------
+#include "ShadowFaceCache.h"
+
+namespace AMD
+{
+    static const unsigned int MAX_TRACKED_GPU_COUNT = 32;
+
+    unsigned long long HashShadowFaceState(const void * pData, size_t size, unsigned long long hash)
+    {
+        const unsigned char * pBytes = (const unsigned char *)pData;
+
+        for (size_t i = 0; i < size; i++)
+        {
+            hash ^= pBytes[i];
+            hash *= 1099511628211ULL;
+        }
+
+        return hash;
+    }
+
+    ShadowFaceCache::ShadowFaceCache()
+    {
+        Init(6);
+    }
+
+    void ShadowFaceCache::Init(unsigned int faceCount)
+    {
+        m_Faces.resize(faceCount);
+        Reset();
+    }
+
+    void ShadowFaceCache::Reset()
+    {
+        for (size_t i = 0; i < m_Faces.size(); i++)
+        {
+            m_Faces[i].m_Fingerprint = 0;
+            m_Faces[i].m_ValidGpuMask = 0;
+            m_Faces[i].m_HasFingerprint = false;
+        }
+    }
+
+    bool ShadowFaceCache::SetFingerprint(unsigned int face, unsigned long long fingerprint)
+    {
+        if (face >= m_Faces.size())
+        {
+            return true;
+        }
+
+        Face & f = m_Faces[face];
+        if (f.m_HasFingerprint == true && f.m_Fingerprint == fingerprint)
+        {
+            return false;
+        }
+
+        f.m_Fingerprint = fingerprint;
+        f.m_HasFingerprint = true;
+        f.m_ValidGpuMask = 0;
+
+        return true;
+    }
+
+    void ShadowFaceCache::MarkRendered(unsigned int face, unsigned int gpu)
+    {
+        if (face < m_Faces.size() && gpu < MAX_TRACKED_GPU_COUNT)
+        {
+            m_Faces[face].m_ValidGpuMask |= 1u << gpu;
+        }
+    }
+
+    void ShadowFaceCache::MarkReceived(unsigned int dstGpu, unsigned int srcGpu)
+    {
+        if (dstGpu >= MAX_TRACKED_GPU_COUNT || srcGpu >= MAX_TRACKED_GPU_COUNT)
+        {
+            return;
+        }
+
+        for (size_t i = 0; i < m_Faces.size(); i++)
+        {
+            if (m_Faces[i].m_ValidGpuMask & (1u << srcGpu))
+            {
+                m_Faces[i].m_ValidGpuMask |= 1u << dstGpu;
+            }
+        }
+    }
+
+    bool ShadowFaceCache::IsValid(unsigned int face, unsigned int gpu) const
+    {
+        return face < m_Faces.size() && gpu < MAX_TRACKED_GPU_COUNT && (m_Faces[face].m_ValidGpuMask & (1u << gpu)) != 0;
+    }
+
+    bool ShadowFaceCache::IsValidOnAllGpus(unsigned int face, unsigned int gpuCount) const
+    {
+        if (face >= m_Faces.size() || gpuCount == 0 || gpuCount > MAX_TRACKED_GPU_COUNT)
+        {
+            return false;
+        }
+
+        const unsigned int allGpus = gpuCount == MAX_TRACKED_GPU_COUNT ? 0xffffffff : (1u << gpuCount) - 1;
+
+        return (m_Faces[face].m_ValidGpuMask & allGpus) == allGpus;
+    }
+}
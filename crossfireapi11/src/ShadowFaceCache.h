@@ -0,0 +1,86 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: ShadowFaceCache.h
+//
+// Remembers which AFR GPUs hold an up to date copy of each shadow map face, so that a
+// face whose light and casters haven't changed is neither rendered nor transferred again.
+//
+// Every frame the caller hashes what a face depends on (light camera, caster matrices,
+// mesh set) into a fingerprint. A face whose fingerprint changed is stale on every GPU.
+// A GPU gets a valid copy of a face by rendering it, or by receiving a transfer from a
+// GPU that holds one: a transfer carries every region the receiving GPU is missing (see
+// AMD::DirtyRegions), so the receiver ends up with whatever the sender has.
+//
+// Up to 32 GPUs are tracked. This code has no dependency on Windows, D3D11 or AGS.
+//--------------------------------------------------------------------------------------
+#ifndef SHADOW_FACE_CACHE_H
+#define SHADOW_FACE_CACHE_H
+
+#include <stddef.h>
+#include <vector>
+
+namespace AMD
+{
+    static const unsigned long long SHADOW_FACE_FINGERPRINT_SEED = 14695981039346656037ULL;
+
+    // FNV-1a, pass the previous result as hash to fingerprint several blocks of memory
+    unsigned long long HashShadowFaceState(const void * pData, size_t size, unsigned long long hash = SHADOW_FACE_FINGERPRINT_SEED);
+
+    class ShadowFaceCache
+    {
+    public:
+        ShadowFaceCache();                  // 6 faces, the cube faces of a point light
+
+        void         Init(unsigned int faceCount);
+
+        // no GPU holds any face, e.g. after the shadow map was recreated
+        void         Reset();
+
+        // returns true if the fingerprint differs from the one the face was last rendered
+        // with, in which case the face is stale on every GPU
+        bool         SetFingerprint(unsigned int face, unsigned long long fingerprint);
+
+        void         MarkRendered(unsigned int face, unsigned int gpu);
+
+        // dstGpu received a transfer from srcGpu: it now holds every face srcGpu holds
+        void         MarkReceived(unsigned int dstGpu, unsigned int srcGpu);
+
+        bool         IsValid(unsigned int face, unsigned int gpu) const;
+        bool         IsValidOnAllGpus(unsigned int face, unsigned int gpuCount) const;
+
+        unsigned int GetFaceCount() const { return (unsigned int)m_Faces.size(); }
+
+    private:
+        struct Face
+        {
+            unsigned long long m_Fingerprint;
+            unsigned int       m_ValidGpuMask;
+            bool               m_HasFingerprint;
+        };
+
+        std::vector<Face> m_Faces;
+    };
+}
+
+#endif // SHADOW_FACE_CACHE_H
@@ -0,0 +1,306 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//--------------------------------------------------------------------------------------
+// File: ShadowFaceLod.cpp
+//
+// Screen coverage of shadow map faces and the face resolutions derived from it.
+//--------------------------------------------------------------------------------------
+#include "ShadowFaceLod.h"
+
+#include <stddef.h>
+#include <math.h>
+#include <float.h>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE__)
+#define SHADOW_FACE_LOD_SSE 1
+#include <xmmintrin.h>
+#else
+#define SHADOW_FACE_LOD_SSE 0
+#endif
+
+namespace AMD
+{
+    static const unsigned int PLANE_COUNT = 6;
+
+    enum ViewerPlane
+    {
+        VIEWER_PLANE_LEFT,                  // w + x
+        VIEWER_PLANE_RIGHT,                 // w - x
+        VIEWER_PLANE_TOP,                   // w - y
+        VIEWER_PLANE_BOTTOM,                // w + y
+        VIEWER_PLANE_NEAR,                  // z
+        VIEWER_PLANE_FAR,                   // w - z
+    };
+
+    // The ends of the ray through a sample of the face on its near and far planes, and
+    // the distance of both ends to every viewer plane. The distances of the samples on
+    // the ray are interpolated from these, the ray being a straight line in world space.
+    struct FaceRay
+    {
+        float m_Near[PLANE_COUNT];
+        float m_Far[PLANE_COUNT];
+    };
+
+    // p * m for a row vector p and a row major 4x4 matrix m
+    static void TransformRowVector(const float p[4], const float * m, float out[4])
+    {
+        for (int c = 0; c < 4; c++)
+        {
+            out[c] = p[0] * m[c] + p[1] * m[4 + c] + p[2] * m[8 + c] + p[3] * m[12 + c];
+        }
+    }
+
+    static bool GetFaceRay(const float * pFaceViewProjectionInv, const float * pViewerPlanes, unsigned int x, unsigned int y, unsigned int gridSize, FaceRay & ray)
+    {
+        const float ndcX = ((float)x + 0.5f) / (float)gridSize * 2.0f - 1.0f;
+        const float ndcY = ((float)y + 0.5f) / (float)gridSize * 2.0f - 1.0f;
+
+        const float nearNdc[4] = { ndcX, ndcY, 0.0f, 1.0f };
+        const float farNdc[4] = { ndcX, ndcY, 1.0f, 1.0f };
+        float nearPos[4], farPos[4];
+        TransformRowVector(nearNdc, pFaceViewProjectionInv, nearPos);
+        TransformRowVector(farNdc, pFaceViewProjectionInv, farPos);
+
+        if (nearPos[3] == 0.0f || farPos[3] == 0.0f) { return false; }
+
+        for (unsigned int i = 0; i < PLANE_COUNT; i++)
+        {
+            const float * plane = &pViewerPlanes[i * 4];
+            ray.m_Near[i] = (plane[0] * nearPos[0] + plane[1] * nearPos[1] + plane[2] * nearPos[2]) / nearPos[3] + plane[3];
+            ray.m_Far[i] = (plane[0] * farPos[0] + plane[1] * farPos[1] + plane[2] * farPos[2]) / farPos[3] + plane[3];
+        }
+        return true;
+    }
+
+    static float GetCoverage(float minX, float minY, float maxX, float maxY)
+    {
+        if (minX > maxX || minY > maxY) { return 0.0f; }
+
+        // from [-1, 1]^2 to [0, 1]
+        return (maxX - minX) * (maxY - minY) * 0.25f;
+    }
+
+    static bool IsValidInput(const float * pFaceViewProjectionInv, const float * pViewerPlanes, unsigned int gridSize)
+    {
+        return pFaceViewProjectionInv != NULL && pViewerPlanes != NULL && gridSize != 0;
+    }
+
+    float GetShadowFaceCoverageReference(const float * pFaceViewProjectionInv, const float * pViewerPlanes, unsigned int gridSize)
+    {
+        if (IsValidInput(pFaceViewProjectionInv, pViewerPlanes, gridSize) == false) { return 0.0f; }
+
+        float minX = FLT_MAX, minY = FLT_MAX;
+        float maxX = -FLT_MAX, maxY = -FLT_MAX;
+
+        for (unsigned int y = 0; y < gridSize; y++)
+        {
+            for (unsigned int x = 0; x < gridSize; x++)
+            {
+                FaceRay ray;
+                if (GetFaceRay(pFaceViewProjectionInv, pViewerPlanes, x, y, gridSize, ray) == false) { continue; }
+
+                for (unsigned int z = 0; z < gridSize; z++)
+                {
+                    const float t = ((float)z + 0.5f) / (float)gridSize;
+
+                    float distance[PLANE_COUNT];
+                    bool  inside = true;
+                    for (unsigned int i = 0; i < PLANE_COUNT; i++)
+                    {
+                        distance[i] = ray.m_Near[i] + (ray.m_Far[i] - ray.m_Near[i]) * t;
+                        inside = inside && distance[i] >= 0.0f;
+                    }
+
+                    if (inside == false) { continue; }
+
+                    // left + right = 2w and left - right = 2x, the same for bottom and top
+                    const float w2 = distance[VIEWER_PLANE_LEFT] + distance[VIEWER_PLANE_RIGHT];
+                    if (w2 <= 0.0f) { continue; }
+
+                    const float screenX = (distance[VIEWER_PLANE_LEFT] - distance[VIEWER_PLANE_RIGHT]) / w2;
+                    const float screenY = (distance[VIEWER_PLANE_BOTTOM] - distance[VIEWER_PLANE_TOP]) / w2;
+
+                    minX = screenX < minX ? screenX : minX;
+                    maxX = screenX > maxX ? screenX : maxX;
+                    minY = screenY < minY ? screenY : minY;
+                    maxY = screenY > maxY ? screenY : maxY;
+                }
+            }
+        }
+
+        return GetCoverage(minX, minY, maxX, maxY);
+    }
+
+#if SHADOW_FACE_LOD_SSE
+    float GetShadowFaceCoverage(const float * pFaceViewProjectionInv, const float * pViewerPlanes, unsigned int gridSize)
+    {
+        if (IsValidInput(pFaceViewProjectionInv, pViewerPlanes, gridSize) == false) { return 0.0f; }
+
+        if (gridSize % 4 != 0)
+        {
+            return GetShadowFaceCoverageReference(pFaceViewProjectionInv, pViewerPlanes, gridSize);
+        }
+
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 maxValue = _mm_set1_ps(FLT_MAX);
+        const __m128 minValue = _mm_set1_ps(-FLT_MAX);
+        const __m128 tStep = _mm_set1_ps(4.0f / (float)gridSize);
+
+        __m128 minX = maxValue, minY = maxValue;
+        __m128 maxX = minValue, maxY = minValue;
+
+        for (unsigned int y = 0; y < gridSize; y++)
+        {
+            for (unsigned int x = 0; x < gridSize; x++)
+            {
+                FaceRay ray;
+                if (GetFaceRay(pFaceViewProjectionInv, pViewerPlanes, x, y, gridSize, ray) == false) { continue; }
+
+                __m128 nearDistance[PLANE_COUNT];
+                __m128 deltaDistance[PLANE_COUNT];
+                for (unsigned int i = 0; i < PLANE_COUNT; i++)
+                {
+                    nearDistance[i] = _mm_set1_ps(ray.m_Near[i]);
+                    deltaDistance[i] = _mm_set1_ps(ray.m_Far[i] - ray.m_Near[i]);
+                }
+
+                // 4 samples along the ray at a time
+                __m128 t = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+                t = _mm_mul_ps(t, _mm_set1_ps(1.0f / (float)gridSize));
+
+                for (unsigned int z = 0; z < gridSize; z += 4, t = _mm_add_ps(t, tStep))
+                {
+                    __m128 distance[PLANE_COUNT];
+                    __m128 inside = _mm_cmpeq_ps(zero, zero);
+                    for (unsigned int i = 0; i < PLANE_COUNT; i++)
+                    {
+                        distance[i] = _mm_add_ps(nearDistance[i], _mm_mul_ps(deltaDistance[i], t));
+                        inside = _mm_and_ps(inside, _mm_cmpge_ps(distance[i], zero));
+                    }
+
+                    const __m128 w2 = _mm_add_ps(distance[VIEWER_PLANE_LEFT], distance[VIEWER_PLANE_RIGHT]);
+                    inside = _mm_and_ps(inside, _mm_cmpgt_ps(w2, zero));
+
+                    if (_mm_movemask_ps(inside) == 0) { continue; }
+
+                    const __m128 screenX = _mm_div_ps(_mm_sub_ps(distance[VIEWER_PLANE_LEFT], distance[VIEWER_PLANE_RIGHT]), w2);
+                    const __m128 screenY = _mm_div_ps(_mm_sub_ps(distance[VIEWER_PLANE_BOTTOM], distance[VIEWER_PLANE_TOP]), w2);
+
+                    // the samples outside don't move the bounds
+                    minX = _mm_min_ps(minX, _mm_or_ps(_mm_and_ps(inside, screenX), _mm_andnot_ps(inside, maxValue)));
+                    minY = _mm_min_ps(minY, _mm_or_ps(_mm_and_ps(inside, screenY), _mm_andnot_ps(inside, maxValue)));
+                    maxX = _mm_max_ps(maxX, _mm_or_ps(_mm_and_ps(inside, screenX), _mm_andnot_ps(inside, minValue)));
+                    maxY = _mm_max_ps(maxY, _mm_or_ps(_mm_and_ps(inside, screenY), _mm_andnot_ps(inside, minValue)));
+                }
+            }
+        }
+
+        float lanes[4][4];
+        _mm_storeu_ps(lanes[0], minX);
+        _mm_storeu_ps(lanes[1], minY);
+        _mm_storeu_ps(lanes[2], maxX);
+        _mm_storeu_ps(lanes[3], maxY);
+
+        for (unsigned int i = 1; i < 4; i++)
+        {
+            lanes[0][0] = lanes[0][i] < lanes[0][0] ? lanes[0][i] : lanes[0][0];
+            lanes[1][0] = lanes[1][i] < lanes[1][0] ? lanes[1][i] : lanes[1][0];
+            lanes[2][0] = lanes[2][i] > lanes[2][0] ? lanes[2][i] : lanes[2][0];
+            lanes[3][0] = lanes[3][i] > lanes[3][0] ? lanes[3][i] : lanes[3][0];
+        }
+
+        return GetCoverage(lanes[0][0], lanes[1][0], lanes[2][0], lanes[3][0]);
+    }
+#else
+    float GetShadowFaceCoverage(const float * pFaceViewProjectionInv, const float * pViewerPlanes, unsigned int gridSize)
+    {
+        return GetShadowFaceCoverageReference(pFaceViewProjectionInv, pViewerPlanes, gridSize);
+    }
+#endif
+
+    static unsigned int RoundUpToPowerOfTwo(unsigned int value)
+    {
+        unsigned int result = 1;
+        while (result < value && result < 0x80000000)
+        {
+            result <<= 1;
+        }
+        return result;
+    }
+
+    ShadowFaceLod::ShadowFaceLod()
+        : m_MinSize(0)
+        , m_MaxSize(0)
+        , m_DownsizeDelay(30)
+    {
+        Init(6, 128, 1024);
+    }
+
+    void ShadowFaceLod::Init(unsigned int faceCount, unsigned int minSize, unsigned int maxSize)
+    {
+        m_MaxSize = RoundUpToPowerOfTwo(maxSize == 0 ? 1 : maxSize);
+        m_MinSize = RoundUpToPowerOfTwo(minSize == 0 ? 1 : minSize);
+        m_MinSize = m_MinSize > m_MaxSize ? m_MaxSize : m_MinSize;
+
+        m_Faces.resize(faceCount);
+        for (size_t i = 0; i < m_Faces.size(); i++)
+        {
+            m_Faces[i].m_Size = m_MaxSize;
+            m_Faces[i].m_DownsizeFrames = 0;
+        }
+    }
+
+    unsigned int ShadowFaceLod::GetTargetSize(float coveredPixels) const
+    {
+        const float side = coveredPixels > 0.0f ? sqrtf(coveredPixels) : 0.0f;
+        if (side >= (float)m_MaxSize) { return m_MaxSize; }
+
+        const unsigned int size = RoundUpToPowerOfTwo((unsigned int)ceilf(side));
+        return size < m_MinSize ? m_MinSize : size;
+    }
+
+    unsigned int ShadowFaceLod::Update(unsigned int face, float coveredPixels)
+    {
+        if (face >= m_Faces.size()) { return m_MaxSize; }
+
+        Face &             f = m_Faces[face];
+        const unsigned int target = GetTargetSize(coveredPixels);
+
+        if (target >= f.m_Size)
+        {
+            f.m_Size = target;
+            f.m_DownsizeFrames = 0;
+        }
+        else if (++f.m_DownsizeFrames >= m_DownsizeDelay)
+        {
+            f.m_Size = target;
+            f.m_DownsizeFrames = 0;
+        }
+
+        return f.m_Size;
+    }
+
+    unsigned int ShadowFaceLod::GetSize(unsigned int face) const
+    {
+        return face < m_Faces.size() ? m_Faces[face].m_Size : m_MaxSize;
+    }
+}
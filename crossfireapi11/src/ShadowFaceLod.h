@@ -0,0 +1,90 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//--------------------------------------------------------------------------------------
+// File: ShadowFaceLod.h
+//
+// Picks the resolution of every shadow map face from how much of the screen it covers.
+//
+// GetShadowFaceCoverage() samples the frustum of a face, keeps the samples inside the
+// viewer frustum and returns the part of the viewport their bounding rectangle covers.
+// The viewer frustum is given as the 6 plane equations AMD::ExtractPlanesFromFrustum
+// (amd_sdk) extracts from the viewer view projection, not normalized: their distances
+// are then the clip space x, y, z and w combinations, so a sample is projected on the
+// screen without the viewer matrix. The samples are tested 4 at a time with SSE when it
+// is available.
+//
+// ShadowFaceLod turns the covered pixels into a power of two size, about one texel per
+// covered pixel. A face gets a larger size at once, but a smaller one only after it
+// wanted it for a number of frames, so faces near a size boundary don't flip.
+//
+// This code has no dependency on Windows, D3D11 or AGS.
+//--------------------------------------------------------------------------------------
+#ifndef SHADOW_FACE_LOD_H
+#define SHADOW_FACE_LOD_H
+
+#include <vector>
+
+namespace AMD
+{
+    // Part (0..1) of the viewport covered by the face frustum inside the viewer frustum.
+    // pFaceViewProjectionInv is the row major inverse view projection of the face (D3D
+    // convention), pViewerPlanes the 6 x 4 floats of the viewer planes in the order of
+    // ExtractPlanesFromFrustum: left, right, top, bottom, near, far. The face frustum is
+    // sampled with gridSize^3 points.
+    float GetShadowFaceCoverage(const float * pFaceViewProjectionInv, const float * pViewerPlanes, unsigned int gridSize = 8);
+
+    // The same without SSE, the reference the SSE path is checked against
+    float GetShadowFaceCoverageReference(const float * pFaceViewProjectionInv, const float * pViewerPlanes, unsigned int gridSize = 8);
+
+    class ShadowFaceLod
+    {
+    public:
+        ShadowFaceLod();                    // 6 faces of 128 to 1024 texels
+
+        // every face starts at maxSize; sizes are powers of two
+        void         Init(unsigned int faceCount, unsigned int minSize, unsigned int maxSize);
+
+        // frames a face has to want a smaller size before it gets it
+        void         SetDownsizeDelay(unsigned int frames) { m_DownsizeDelay = frames; }
+        unsigned int GetDownsizeDelay() const { return m_DownsizeDelay; }
+
+        // once per face and frame, returns the size of the face
+        unsigned int Update(unsigned int face, float coveredPixels);
+
+        unsigned int GetSize(unsigned int face) const;
+        unsigned int GetTargetSize(float coveredPixels) const;
+
+    private:
+        struct Face
+        {
+            unsigned int m_Size;
+            unsigned int m_DownsizeFrames;
+        };
+
+        unsigned int      m_MinSize;
+        unsigned int      m_MaxSize;
+        unsigned int      m_DownsizeDelay;
+        std::vector<Face> m_Faces;
+    };
+}
+
+#endif // SHADOW_FACE_LOD_H
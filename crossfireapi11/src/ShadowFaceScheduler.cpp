@@ -0,0 +1,235 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: ShadowFaceScheduler.cpp
+//
+// Decides which shadow map faces are refreshed in a frame.
+//--------------------------------------------------------------------------------------
+#include "ShadowFaceScheduler.h"
+
+#include <stddef.h>
+#include <algorithm>
+
+namespace AMD
+{
+    ShadowFaceScheduler::ShadowFaceScheduler()
+    {
+        Init(ShadowFaceSchedulerDesc());
+    }
+
+    void ShadowFaceScheduler::Init(const ShadowFaceSchedulerDesc & desc)
+    {
+        m_Desc = desc;
+
+        if (m_Desc.m_MaxFacesPerFrame == 0) { m_Desc.m_MaxFacesPerFrame = 1; }
+        if (m_Desc.m_HiddenWeight < 0.0f) { m_Desc.m_HiddenWeight = 0.0f; }
+        if (m_Desc.m_HiddenWeight > 1.0f) { m_Desc.m_HiddenWeight = 1.0f; }
+
+        m_Faces.resize(m_Desc.m_FaceCount);
+        m_Rank.resize(m_Desc.m_FaceCount);
+
+        Reset();
+    }
+
+    void ShadowFaceScheduler::Reset()
+    {
+        for (size_t i = 0; i < m_Faces.size(); i++)
+        {
+            Face & face = m_Faces[i];
+            face.m_Visibility = 1.0f;
+            face.m_Motion = 0.0f;
+            face.m_CostMs = 0.0f;
+            face.m_CostBytes = 0.0f;
+            face.m_Score = 0.0f;
+            face.m_Age = 0;
+            face.m_Valid = false;
+        }
+    }
+
+    void ShadowFaceScheduler::SetFaceInputs(unsigned int face, float visibility, float motion, float costMs, float costBytes)
+    {
+        if (face >= m_Faces.size()) { return; }
+
+        Face & f = m_Faces[face];
+        f.m_Visibility = visibility < 0.0f ? 0.0f : (visibility > 1.0f ? 1.0f : visibility);
+        f.m_Motion += motion > 0.0f ? motion : 0.0f;
+        f.m_CostMs = costMs > 0.0f ? costMs : 0.0f;
+        f.m_CostBytes = costBytes > 0.0f ? costBytes : 0.0f;
+    }
+
+    unsigned int ShadowFaceScheduler::GetUrgency(const Face & face) const
+    {
+        if (face.m_Valid == false) { return 2; }
+        if (m_Desc.m_MaxAge > 0 && face.m_Age >= m_Desc.m_MaxAge) { return 1; }
+        return 0;
+    }
+
+    bool ShadowFaceScheduler::IsRankedBefore(unsigned int a, unsigned int b) const
+    {
+        const Face & fa = m_Faces[a];
+        const Face & fb = m_Faces[b];
+
+        const unsigned int urgencyA = GetUrgency(fa);
+        const unsigned int urgencyB = GetUrgency(fb);
+
+        if (urgencyA != urgencyB) { return urgencyA > urgencyB; }
+        if (fa.m_Score != fb.m_Score) { return fa.m_Score > fb.m_Score; }
+        return a < b;
+    }
+
+    unsigned int ShadowFaceScheduler::Schedule(unsigned int * pFaces, unsigned int maxFaces)
+    {
+        if (pFaces == NULL || maxFaces == 0) { return 0; }
+
+        for (size_t i = 0; i < m_Faces.size(); i++)
+        {
+            Face & face = m_Faces[i];
+            face.m_Age++;
+
+            const float importance = m_Desc.m_HiddenWeight + (1.0f - m_Desc.m_HiddenWeight) * face.m_Visibility;
+            const float staleness = m_Desc.m_AgeWeight * (float)face.m_Age + m_Desc.m_MotionWeight * face.m_Motion;
+            face.m_Score = importance * staleness;
+
+            m_Rank[i] = (unsigned int)i;
+        }
+
+        // insertion sort, there are only a few faces per light
+        for (size_t i = 1; i < m_Rank.size(); i++)
+        {
+            const unsigned int index = m_Rank[i];
+            size_t j = i;
+            while (j > 0 && IsRankedBefore(index, m_Rank[j - 1]))
+            {
+                m_Rank[j] = m_Rank[j - 1];
+                j--;
+            }
+            m_Rank[j] = index;
+        }
+
+        const unsigned int faceLimit = std::min(maxFaces, m_Desc.m_MaxFacesPerFrame);
+        float usedMs = 0.0f;
+        float usedBytes = 0.0f;
+        unsigned int count = 0;
+
+        for (size_t i = 0; i < m_Rank.size() && count < faceLimit; i++)
+        {
+            const unsigned int index = m_Rank[i];
+            Face & face = m_Faces[index];
+
+            if (GetUrgency(face) == 0 && face.m_Score < m_Desc.m_MinScore)
+            {
+                break; // not worth it for this face, nor for the ones ranked after it
+            }
+
+            // the first face is always refreshed so that a budget smaller than one face can't starve the schedule,
+            // the next ones only if they fit; a face that doesn't fit doesn't stop a cheaper one ranked after it
+            const bool fitsMs = m_Desc.m_BudgetMs <= 0.0f || usedMs + face.m_CostMs <= m_Desc.m_BudgetMs;
+            const bool fitsBytes = m_Desc.m_BudgetBytes <= 0.0f || usedBytes + face.m_CostBytes <= m_Desc.m_BudgetBytes;
+            if (count > 0 && (fitsMs == false || fitsBytes == false))
+            {
+                continue;
+            }
+
+            usedMs += face.m_CostMs;
+            usedBytes += face.m_CostBytes;
+
+            face.m_Age = 0;
+            face.m_Motion = 0.0f;
+            face.m_Valid = true;
+
+            pFaces[count++] = index;
+        }
+
+        return count;
+    }
+
+    // p * m for a row vector p and a row major 4x4 matrix m
+    static void TransformRowVector(const float p[4], const float * m, float out[4])
+    {
+        for (int c = 0; c < 4; c++)
+        {
+            out[c] = p[0] * m[c] + p[1] * m[4 + c] + p[2] * m[8 + c] + p[3] * m[12 + c];
+        }
+    }
+
+    float GetFrustumOverlap(const float * pFaceViewProjectionInv, const float * pViewerViewProjection, unsigned int gridSize)
+    {
+        if (pFaceViewProjectionInv == NULL || pViewerViewProjection == NULL || gridSize == 0) { return 0.0f; }
+
+        float inside = 0.0f;
+        float total = 0.0f;
+
+        for (unsigned int y = 0; y < gridSize; y++)
+        {
+            for (unsigned int x = 0; x < gridSize; x++)
+            {
+                const float ndcX = ((float)x + 0.5f) / (float)gridSize * 2.0f - 1.0f;
+                const float ndcY = ((float)y + 0.5f) / (float)gridSize * 2.0f - 1.0f;
+
+                // ends of the ray through this sample on the near and the far plane of the face
+                const float nearNdc[4] = { ndcX, ndcY, 0.0f, 1.0f };
+                const float farNdc[4] = { ndcX, ndcY, 1.0f, 1.0f };
+                float nearPos[4], farPos[4];
+                TransformRowVector(nearNdc, pFaceViewProjectionInv, nearPos);
+                TransformRowVector(farNdc, pFaceViewProjectionInv, farPos);
+
+                if (nearPos[3] == 0.0f || farPos[3] == 0.0f) { continue; }
+
+                for (int c = 0; c < 3; c++)
+                {
+                    nearPos[c] /= nearPos[3];
+                    farPos[c] /= farPos[3];
+                }
+
+                for (unsigned int z = 0; z < gridSize; z++)
+                {
+                    const float t = ((float)z + 0.5f) / (float)gridSize;
+                    const float weight = t * t; // slice area grows with the square of the distance
+
+                    const float pos[4] =
+                    {
+                        nearPos[0] + (farPos[0] - nearPos[0]) * t,
+                        nearPos[1] + (farPos[1] - nearPos[1]) * t,
+                        nearPos[2] + (farPos[2] - nearPos[2]) * t,
+                        1.0f
+                    };
+
+                    float clip[4];
+                    TransformRowVector(pos, pViewerViewProjection, clip);
+
+                    total += weight;
+
+                    if (clip[3] > 0.0f &&
+                        clip[0] >= -clip[3] && clip[0] <= clip[3] &&
+                        clip[1] >= -clip[3] && clip[1] <= clip[3] &&
+                        clip[2] >= 0.0f && clip[2] <= clip[3])
+                    {
+                        inside += weight;
+                    }
+                }
+            }
+        }
+
+        return total > 0.0f ? inside / total : 0.0f;
+    }
+}
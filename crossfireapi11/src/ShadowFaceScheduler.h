@@ -0,0 +1,126 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: ShadowFaceScheduler.h
+//
+// Decides which shadow map faces (the 6 cube faces of a point light, or the faces of
+// several lights) are refreshed in a frame.
+//
+// Every face gets a score each frame:
+//     importance = HiddenWeight + (1 - HiddenWeight) * visibility
+//     staleness  = AgeWeight * frames since refresh + MotionWeight * motion since refresh
+//     score      = importance * staleness
+// where visibility is how much of the face frustum overlaps the viewer frustum (see
+// GetFrustumOverlap) and motion is the light and caster motion reported by the caller.
+// Faces that were never rendered come first, then faces older than MaxAge, then the
+// rest by score. The ranked faces are taken in order, up to MaxFacesPerFrame and within
+// the per frame budgets in milliseconds and transferred bytes; faces scoring less than
+// MinScore are left alone, so a static face the viewer can't see is rarely rendered.
+//
+// The ranking only depends on the inputs (ties go to the lower face index), so a given
+// sequence of inputs always produces the same schedule. This code has no dependency on
+// Windows, D3D11 or AGS.
+//--------------------------------------------------------------------------------------
+#ifndef SHADOW_FACE_SCHEDULER_H
+#define SHADOW_FACE_SCHEDULER_H
+
+#include <vector>
+
+namespace AMD
+{
+    struct ShadowFaceSchedulerDesc
+    {
+        unsigned int m_FaceCount;
+        unsigned int m_MaxFacesPerFrame;
+        float        m_BudgetMs;            // render cost budget per frame, 0 disables it
+        float        m_BudgetBytes;         // transfer budget per frame, 0 disables it
+        float        m_HiddenWeight;        // importance of a face the viewer can't see
+        float        m_AgeWeight;           // staleness per frame since the last refresh
+        float        m_MotionWeight;        // staleness per unit of motion since the last refresh
+        float        m_MinScore;            // faces scoring less are not worth refreshing
+        unsigned int m_MaxAge;              // frames after which a face is refreshed whatever its score, 0 disables it
+
+        ShadowFaceSchedulerDesc()
+            : m_FaceCount(6)
+            , m_MaxFacesPerFrame(2)
+            , m_BudgetMs(0.0f)
+            , m_BudgetBytes(0.0f)
+            , m_HiddenWeight(0.05f)
+            , m_AgeWeight(0.1f)
+            , m_MotionWeight(10.0f)
+            , m_MinScore(0.1f)
+            , m_MaxAge(60)
+        {}
+    };
+
+    class ShadowFaceScheduler
+    {
+    public:
+        ShadowFaceScheduler();
+
+        void         Init(const ShadowFaceSchedulerDesc & desc);
+
+        // marks every face as never rendered, e.g. after the shadow map was recreated
+        void         Reset();
+
+        // inputs of a face for this frame; motion is accumulated until the face is refreshed
+        void         SetFaceInputs(unsigned int face, float visibility, float motion, float costMs, float costBytes);
+
+        // ranks the faces, writes the ones to refresh this frame into pFaces (in rank order)
+        // and returns their count; the returned faces are considered refreshed
+        unsigned int Schedule(unsigned int * pFaces, unsigned int maxFaces);
+
+        unsigned int GetFaceCount() const { return (unsigned int)m_Faces.size(); }
+        float        GetScore(unsigned int face) const { return face < m_Faces.size() ? m_Faces[face].m_Score : 0.0f; }
+        unsigned int GetAge(unsigned int face) const { return face < m_Faces.size() ? m_Faces[face].m_Age : 0; }
+
+    private:
+        struct Face
+        {
+            float        m_Visibility;
+            float        m_Motion;
+            float        m_CostMs;
+            float        m_CostBytes;
+            float        m_Score;
+            unsigned int m_Age;
+            bool         m_Valid;           // rendered at least once since Reset()
+        };
+
+        // 2 never rendered, 1 older than MaxAge, 0 otherwise
+        unsigned int GetUrgency(const Face & face) const;
+        bool         IsRankedBefore(unsigned int a, unsigned int b) const;
+
+        ShadowFaceSchedulerDesc   m_Desc;
+        std::vector<Face>         m_Faces;
+        std::vector<unsigned int> m_Rank;
+    };
+
+    // Fraction (0..1) of the volume of a face frustum that is inside the viewer frustum.
+    // Both matrices are row major and transform row vectors (D3D convention): the inverse
+    // view projection of the face and the view projection of the viewer. The face frustum
+    // is sampled with gridSize^3 points spread linearly in depth and weighted by the area
+    // of their depth slice.
+    float GetFrustumOverlap(const float * pFaceViewProjectionInv, const float * pViewerViewProjection, unsigned int gridSize = 4);
+}
+
+#endif // SHADOW_FACE_SCHEDULER_H
@@ -0,0 +1,480 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//--------------------------------------------------------------------------------------
+// File: ShadowLightList.cpp
+//
+// Priority ordered shadow atlas regions and ShadowFX batches of point and spot lights.
+//--------------------------------------------------------------------------------------
+#include "ShadowLightList.h"
+
+#include <math.h>
+#include <algorithm>
+
+namespace AMD
+{
+    static const float SHADOW_LIGHT_PI = 3.14159265f;
+
+    // same faces and up vectors as the cube camera of the sample
+    static const float CUBE_FACE_DIRECTION[6][3] =
+    {
+        {  1.0f,  0.0f,  0.0f }, { -1.0f,  0.0f,  0.0f },
+        {  0.0f,  1.0f,  0.0f }, {  0.0f, -1.0f,  0.0f },
+        {  0.0f,  0.0f,  1.0f }, {  0.0f,  0.0f, -1.0f },
+    };
+
+    static const float CUBE_FACE_UP[6][3] =
+    {
+        {  0.0f,  1.0f,  0.0f }, {  0.0f,  1.0f,  0.0f },
+        {  0.0f,  0.0f, -1.0f }, {  0.0f,  0.0f,  1.0f },
+        {  0.0f,  1.0f,  0.0f }, {  0.0f,  1.0f,  0.0f },
+    };
+
+    static void Normalize(float v[3])
+    {
+        const float length = sqrtf(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+        if (length > 0.0f)
+        {
+            v[0] /= length; v[1] /= length; v[2] /= length;
+        }
+    }
+
+    static void Cross(const float a[3], const float b[3], float r[3])
+    {
+        r[0] = a[1] * b[2] - a[2] * b[1];
+        r[1] = a[2] * b[0] - a[0] * b[2];
+        r[2] = a[0] * b[1] - a[1] * b[0];
+    }
+
+    // XMMatrixLookToLH
+    static void LookTo(const float eye[3], const float direction[3], const float up[3], float view[16])
+    {
+        float f[3] = { direction[0], direction[1], direction[2] };
+        Normalize(f);
+        float r[3];
+        Cross(up, f, r);
+        Normalize(r);
+        float u[3];
+        Cross(f, r, u);
+
+        view[0] = r[0]; view[1] = u[0]; view[2] = f[0];  view[3] = 0.0f;
+        view[4] = r[1]; view[5] = u[1]; view[6] = f[1];  view[7] = 0.0f;
+        view[8] = r[2]; view[9] = u[2]; view[10] = f[2]; view[11] = 0.0f;
+        view[12] = -(r[0] * eye[0] + r[1] * eye[1] + r[2] * eye[2]);
+        view[13] = -(u[0] * eye[0] + u[1] * eye[1] + u[2] * eye[2]);
+        view[14] = -(f[0] * eye[0] + f[1] * eye[1] + f[2] * eye[2]);
+        view[15] = 1.0f;
+    }
+
+    // XMMatrixPerspectiveFovLH, square
+    static void Perspective(float fov, float zNear, float zFar, float projection[16])
+    {
+        const float scale = 1.0f / tanf(fov * 0.5f);
+        const float range = zFar / (zFar - zNear);
+
+        for (unsigned int i = 0; i < 16; i++)
+        {
+            projection[i] = 0.0f;
+        }
+        projection[0] = scale;
+        projection[5] = scale;
+        projection[10] = range;
+        projection[11] = 1.0f;
+        projection[14] = -range * zNear;
+    }
+
+    unsigned int GetShadowLightViewCount(SHADOW_LIGHT_TYPE type)
+    {
+        return type == SHADOW_LIGHT_TYPE_POINT ? 6 : 1;
+    }
+
+    ShadowLightList::ShadowLightList()
+    {
+        Init(1, 0);
+    }
+
+    void ShadowLightList::Init(unsigned int maskCount, unsigned int reservedChannelCount)
+    {
+        m_MaskCount = maskCount;
+        m_ReservedChannelCount = std::min(reservedChannelCount, maskCount * SHADOW_LIGHT_MASK_CHANNEL_COUNT);
+        m_UsedMaskCount = 0;
+        m_ShadowedCount = 0;
+
+        m_Lights.clear();
+        m_Order.clear();
+        m_Shadowed.clear();
+        m_Views.clear();
+        m_Batches.clear();
+    }
+
+    unsigned int ShadowLightList::AddLight(const ShadowLight & light)
+    {
+        // reuse a removed light once Update() has given its regions back
+        unsigned int index = (unsigned int)m_Lights.size();
+        for (unsigned int i = 0; i < m_Lights.size(); i++)
+        {
+            if (m_Lights[i].m_Live == false && m_Lights[i].m_RequestedSize == 0)
+            {
+                index = i;
+                break;
+            }
+        }
+
+        if (index == m_Lights.size())
+        {
+            m_Lights.push_back(Light());
+        }
+
+        Light & entry = m_Lights[index];
+        entry.m_Desc = light;
+        for (unsigned int face = 0; face < 6; face++)
+        {
+            entry.m_Region[face] = SHADOW_ATLAS_INVALID_REGION;
+        }
+        entry.m_RequestedSize = 0;
+        entry.m_RegionSize = 0;
+        entry.m_Batch = SHADOW_LIGHT_INVALID_INDEX;
+        entry.m_Live = true;
+
+        return index;
+    }
+
+    void ShadowLightList::RemoveLight(unsigned int light)
+    {
+        if (IsValid(light) == true)
+        {
+            // the regions are freed by the next Update()
+            m_Lights[light].m_Live = false;
+            m_Lights[light].m_Batch = SHADOW_LIGHT_INVALID_INDEX;
+        }
+    }
+
+    void ShadowLightList::SetLight(unsigned int light, const ShadowLight & desc)
+    {
+        if (IsValid(light) == true)
+        {
+            m_Lights[light].m_Desc = desc;
+        }
+    }
+
+    const ShadowLight & ShadowLightList::GetLight(unsigned int light) const
+    {
+        return m_Lights[light].m_Desc;
+    }
+
+    bool ShadowLightList::IsValid(unsigned int light) const
+    {
+        return light < m_Lights.size() && m_Lights[light].m_Live == true;
+    }
+
+    unsigned int ShadowLightList::GetLightBatch(unsigned int light) const
+    {
+        return IsValid(light) == true ? m_Lights[light].m_Batch : SHADOW_LIGHT_INVALID_INDEX;
+    }
+
+    void ShadowLightList::ForgetRegions()
+    {
+        for (unsigned int i = 0; i < m_Lights.size(); i++)
+        {
+            for (unsigned int face = 0; face < 6; face++)
+            {
+                m_Lights[i].m_Region[face] = SHADOW_ATLAS_INVALID_REGION;
+            }
+            m_Lights[i].m_RequestedSize = 0;
+            m_Lights[i].m_RegionSize = 0;
+        }
+    }
+
+    void ShadowLightList::FreeRegions(Light & light, ShadowAtlasAllocator & atlas)
+    {
+        for (unsigned int face = 0; face < 6; face++)
+        {
+            if (light.m_Region[face] != SHADOW_ATLAS_INVALID_REGION)
+            {
+                atlas.Free(light.m_Region[face]);
+                light.m_Region[face] = SHADOW_ATLAS_INVALID_REGION;
+            }
+        }
+        light.m_RequestedSize = 0;
+        light.m_RegionSize = 0;
+    }
+
+    // all the views of the light or none, at the largest size from m_Size down to minSize
+    bool ShadowLightList::PlaceRegions(Light & light, ShadowAtlasAllocator & atlas, unsigned int minSize)
+    {
+        const unsigned int viewCount = GetShadowLightViewCount(light.m_Desc.m_Type);
+
+        for (unsigned int size = light.m_Desc.m_Size; size >= std::max(minSize, 1u); size /= 2)
+        {
+            unsigned int region[6];
+            unsigned int placed = 0;
+            while (placed < viewCount)
+            {
+                region[placed] = atlas.Allocate(size, size);
+                if (region[placed] == SHADOW_ATLAS_INVALID_REGION)
+                {
+                    break;
+                }
+                placed++;
+            }
+
+            if (placed == viewCount)
+            {
+                FreeRegions(light, atlas);
+                for (unsigned int face = 0; face < viewCount; face++)
+                {
+                    light.m_Region[face] = region[face];
+                }
+                light.m_RequestedSize = light.m_Desc.m_Size;
+                light.m_RegionSize = size;
+                return true;
+            }
+
+            for (unsigned int face = 0; face < placed; face++)
+            {
+                atlas.Free(region[face]);
+            }
+        }
+
+        return false;
+    }
+
+    void ShadowLightList::Update(ShadowAtlasAllocator * pAtlas, unsigned int minSize)
+    {
+        m_Order.clear();
+        m_Shadowed.clear();
+        m_Views.clear();
+        m_Batches.clear();
+        m_UsedMaskCount = 0;
+        m_ShadowedCount = 0;
+
+        for (unsigned int i = 0; i < m_Lights.size(); i++)
+        {
+            m_Lights[i].m_Batch = SHADOW_LIGHT_INVALID_INDEX;
+        }
+
+        if (pAtlas == NULL)
+        {
+            ForgetRegions();
+            return;
+        }
+
+        ShadowAtlasAllocator & atlas = *pAtlas;
+
+        // regions of removed lights, and of lights that now ask for another size
+        for (unsigned int i = 0; i < m_Lights.size(); i++)
+        {
+            Light & light = m_Lights[i];
+            if (light.m_RequestedSize != 0 && (light.m_Live == false || light.m_RequestedSize != light.m_Desc.m_Size))
+            {
+                FreeRegions(light, atlas);
+            }
+            if (light.m_Live == true)
+            {
+                m_Order.push_back(i);
+            }
+        }
+
+        struct HigherPriority
+        {
+            const std::vector<Light> & m_Lights;
+            HigherPriority(const std::vector<Light> & lights) : m_Lights(lights) {}
+            bool operator()(unsigned int a, unsigned int b) const
+            {
+                return m_Lights[a].m_Desc.m_Priority > m_Lights[b].m_Desc.m_Priority;
+            }
+        };
+        std::stable_sort(m_Order.begin(), m_Order.end(), HigherPriority(m_Lights));
+
+        for (unsigned int i = 0; i < m_Order.size(); i++)
+        {
+            Light & light = m_Lights[m_Order[i]];
+
+            // a light that was shrunk to fit gets its requested size back once there is room
+            if (light.m_RegionSize != 0)
+            {
+                if (light.m_RegionSize < light.m_RequestedSize)
+                {
+                    Light grown = light;
+                    for (unsigned int face = 0; face < 6; face++)
+                    {
+                        grown.m_Region[face] = SHADOW_ATLAS_INVALID_REGION;
+                    }
+                    if (PlaceRegions(grown, atlas, light.m_Desc.m_Size) == true)
+                    {
+                        FreeRegions(light, atlas);
+                        light = grown;
+                    }
+                }
+                continue;
+            }
+
+            // otherwise take the regions of the lowest priority lights, one at a time
+            unsigned int victim = (unsigned int)m_Order.size();
+            while (PlaceRegions(light, atlas, minSize) == false)
+            {
+                while (victim > i + 1 && m_Lights[m_Order[victim - 1]].m_RegionSize == 0)
+                {
+                    victim--;
+                }
+                if (victim <= i + 1 || m_Lights[m_Order[victim - 1]].m_Desc.m_Priority >= light.m_Desc.m_Priority)
+                {
+                    break;
+                }
+                victim--;
+                FreeRegions(m_Lights[m_Order[victim]], atlas);
+            }
+        }
+
+        for (unsigned int i = 0; i < m_Order.size(); i++)
+        {
+            if (m_Lights[m_Order[i]].m_RegionSize != 0)
+            {
+                m_Shadowed.push_back(m_Order[i]);
+            }
+        }
+
+        // the lowest priority lights that don't fit the channels lose their shadows
+        unsigned int lightCount = (unsigned int)m_Shadowed.size();
+        unsigned int ownChannelCount = 0;
+        while (lightCount > 0 && FitBatches(lightCount, ownChannelCount) == false)
+        {
+            lightCount--;
+            FreeRegions(m_Lights[m_Shadowed[lightCount]], atlas);
+        }
+        m_Shadowed.resize(lightCount);
+        m_ShadowedCount = lightCount;
+
+        // a batch and a channel for each of the first lights
+        unsigned int channel = 0;
+        for (unsigned int i = 0; i < ownChannelCount; i++)
+        {
+            AddBatch(i, 1, channel++);
+        }
+
+        // then a cube batch for every point light left, and union batches of up to 6 spot lights
+        unsigned int spotCount = 0;
+        for (unsigned int i = ownChannelCount; i < lightCount; i++)
+        {
+            if (m_Lights[m_Shadowed[i]].m_Desc.m_Type == SHADOW_LIGHT_TYPE_POINT)
+            {
+                AddBatch(i, 1, channel++);
+            }
+            else
+            {
+                m_Shadowed[ownChannelCount + spotCount++] = m_Shadowed[i];
+            }
+        }
+        for (unsigned int i = 0; i < spotCount; i += SHADOW_LIGHT_MAX_BATCH_VIEW_COUNT)
+        {
+            AddBatch(ownChannelCount + i, std::min(spotCount - i, SHADOW_LIGHT_MAX_BATCH_VIEW_COUNT), channel++);
+        }
+    }
+
+    // the number of lights, from the first, that get a channel of their own when the first
+    // lightCount lights are shadowed; false if there aren't enough channels for them
+    bool ShadowLightList::FitBatches(unsigned int lightCount, unsigned int & ownChannelCount) const
+    {
+        const unsigned int channelCount = m_MaskCount * SHADOW_LIGHT_MASK_CHANNEL_COUNT - m_ReservedChannelCount;
+
+        for (unsigned int own = std::min(lightCount, channelCount) + 1; own-- > 0;)
+        {
+            unsigned int pointCount = 0;
+            unsigned int spotCount = 0;
+            for (unsigned int i = own; i < lightCount; i++)
+            {
+                if (m_Lights[m_Shadowed[i]].m_Desc.m_Type == SHADOW_LIGHT_TYPE_POINT)
+                {
+                    pointCount++;
+                }
+                else
+                {
+                    spotCount++;
+                }
+            }
+
+            const unsigned int groupCount = pointCount + (spotCount + SHADOW_LIGHT_MAX_BATCH_VIEW_COUNT - 1) / SHADOW_LIGHT_MAX_BATCH_VIEW_COUNT;
+            if (own + groupCount <= channelCount)
+            {
+                ownChannelCount = own;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void ShadowLightList::AddBatch(unsigned int firstLight, unsigned int lightCount, unsigned int channel)
+    {
+        ShadowLightBatch batch;
+        batch.m_FirstView = (unsigned int)m_Views.size();
+        batch.m_Cube = m_Lights[m_Shadowed[firstLight]].m_Desc.m_Type == SHADOW_LIGHT_TYPE_POINT;
+        batch.m_Target = (channel + m_ReservedChannelCount) / SHADOW_LIGHT_MASK_CHANNEL_COUNT;
+        batch.m_Channel = (channel + m_ReservedChannelCount) % SHADOW_LIGHT_MASK_CHANNEL_COUNT;
+
+        for (unsigned int i = firstLight; i < firstLight + lightCount; i++)
+        {
+            m_Lights[m_Shadowed[i]].m_Batch = (unsigned int)m_Batches.size();
+            AddViews(m_Shadowed[i]);
+        }
+
+        batch.m_ViewCount = (unsigned int)m_Views.size() - batch.m_FirstView;
+        m_Batches.push_back(batch);
+        m_UsedMaskCount = std::max(m_UsedMaskCount, batch.m_Target + 1);
+    }
+
+    void ShadowLightList::AddViews(unsigned int light)
+    {
+        const Light & entry = m_Lights[light];
+        const ShadowLight & desc = entry.m_Desc;
+
+        ShadowLightView view;
+        view.m_Light = light;
+
+        if (desc.m_Type == SHADOW_LIGHT_TYPE_POINT)
+        {
+            view.m_Fov = SHADOW_LIGHT_PI / 2.0f;
+            Perspective(view.m_Fov, desc.m_NearPlane, desc.m_FarPlane, view.m_Projection);
+
+            for (unsigned int face = 0; face < 6; face++)
+            {
+                view.m_Face = face;
+                view.m_Region = entry.m_Region[face];
+                LookTo(desc.m_Position, CUBE_FACE_DIRECTION[face], CUBE_FACE_UP[face], view.m_View);
+                m_Views.push_back(view);
+            }
+        }
+        else
+        {
+            static const float up[3] = { 0.0f, 1.0f, 0.0f };
+            static const float alternateUp[3] = { 0.0f, 0.0f, 1.0f };
+            const float * direction = desc.m_Direction;
+            const bool vertical = fabsf(direction[1]) > 0.99f * sqrtf(direction[0] * direction[0] + direction[1] * direction[1] + direction[2] * direction[2]);
+
+            view.m_Face = 0;
+            view.m_Region = entry.m_Region[0];
+            view.m_Fov = desc.m_ConeAngle;
+            Perspective(view.m_Fov, desc.m_NearPlane, desc.m_FarPlane, view.m_Projection);
+            LookTo(desc.m_Position, direction, vertical == true ? alternateUp : up, view.m_View);
+            m_Views.push_back(view);
+        }
+    }
+}
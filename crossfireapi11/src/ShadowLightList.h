@@ -0,0 +1,167 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//--------------------------------------------------------------------------------------
+// File: ShadowLightList.h
+//
+// A list of shadowed point and spot lights, on top of the single cube light of the
+// sample.
+//
+// Every frame Update() orders the lights by priority and expands them into shadow
+// views: 6 cube faces for a point light, 1 for a spot light, each with its view and
+// projection matrices. The views are given regions of a ShadowAtlasAllocator, highest
+// priority first. A light that doesn't fit at its requested size tries smaller ones,
+// and then takes the regions of the lowest priority lights. A region is kept from one
+// frame to the next while the light keeps its size, and Update() never moves the
+// regions of anything else in the atlas.
+//
+// ShadowFX filters at most ShadowFX_Desc::m_MaxLightCount (6) views per invocation, and
+// an invocation writes one shadow term to the channels of its output. So the shadowed
+// lights are split into batches, one ShadowFX_Render each, and every batch gets one
+// channel of a RGBA shadow mask. The highest priority lights get a batch and a channel
+// of their own. When there are more lights than channels, the lowest priority spot
+// lights share the last channels, up to 6 views in a union batch, and their shading
+// uses the union of their shadows.
+//
+// This code has no dependency on Windows, D3D11 or AGS.
+//--------------------------------------------------------------------------------------
+#ifndef SHADOW_LIGHT_LIST_H
+#define SHADOW_LIGHT_LIST_H
+
+#include <vector>
+
+#include "ShadowAtlasAllocator.h"
+
+namespace AMD
+{
+    static const unsigned int SHADOW_LIGHT_INVALID_INDEX = 0xffffffff;
+    static const unsigned int SHADOW_LIGHT_MAX_BATCH_VIEW_COUNT = 6;    // ShadowFX_Desc::m_MaxLightCount
+    static const unsigned int SHADOW_LIGHT_MASK_CHANNEL_COUNT = 4;      // RGBA
+
+    typedef enum SHADOW_LIGHT_TYPE_t
+    {
+        SHADOW_LIGHT_TYPE_POINT                      = 0,
+        SHADOW_LIGHT_TYPE_SPOT                       = 1,
+        SHADOW_LIGHT_TYPE_COUNT                      = 2,
+    } SHADOW_LIGHT_TYPE;
+
+    // 6 cube faces for a point light, 1 for a spot light
+    unsigned int GetShadowLightViewCount(SHADOW_LIGHT_TYPE type);
+
+    struct ShadowLight
+    {
+        SHADOW_LIGHT_TYPE m_Type;
+        float             m_Priority;       // higher priority lights get regions and channels first
+        float             m_Position[3];
+        float             m_Direction[3];   // spot lights only
+        float             m_ConeAngle;      // full angle in radians, spot lights only
+        float             m_NearPlane;
+        float             m_FarPlane;
+        unsigned int      m_Size;           // texels of every region the light asks for
+    };
+
+    struct ShadowLightView
+    {
+        unsigned int      m_Light;
+        unsigned int      m_Face;           // cube face of a point light, 0 for a spot light
+        unsigned int      m_Region;         // of the atlas
+        float             m_Fov;
+        float             m_View[16];       // row major, left handed, row vectors (D3D convention)
+        float             m_Projection[16];
+    };
+
+    // the views of a single ShadowFX_Render, they write one channel of a shadow mask
+    struct ShadowLightBatch
+    {
+        unsigned int      m_FirstView;
+        unsigned int      m_ViewCount;
+        bool              m_Cube;           // the 6 faces of one point light, otherwise a union
+        unsigned int      m_Target;         // shadow mask
+        unsigned int      m_Channel;        // 0..3, SHADOWFX_OUTPUT_CHANNEL is 1 << m_Channel
+    };
+
+    class ShadowLightList
+    {
+    public:
+        ShadowLightList();                  // 1 shadow mask, no reserved channel
+
+        // forgets every light; the first reservedChannelCount channels of the first mask
+        // are left to the caller
+        void                     Init(unsigned int maskCount, unsigned int reservedChannelCount);
+
+        unsigned int             AddLight(const ShadowLight & light);
+        void                     RemoveLight(unsigned int light);
+        void                     SetLight(unsigned int light, const ShadowLight & desc);
+        const ShadowLight &      GetLight(unsigned int light) const;
+        bool                     IsValid(unsigned int light) const;
+
+        // all lights ever added, removed ones are invalid
+        unsigned int             GetLightCount() const { return (unsigned int)m_Lights.size(); }
+
+        // the regions are lost, e.g. after the atlas was initialized again
+        void                     ForgetRegions();
+
+        // places the views in the atlas and batches them; without an atlas no light is shadowed
+        void                     Update(ShadowAtlasAllocator * pAtlas, unsigned int minSize);
+
+        unsigned int             GetViewCount() const { return (unsigned int)m_Views.size(); }
+        const ShadowLightView &  GetView(unsigned int view) const { return m_Views[view]; }
+        unsigned int             GetBatchCount() const { return (unsigned int)m_Batches.size(); }
+        const ShadowLightBatch & GetBatch(unsigned int batch) const { return m_Batches[batch]; }
+
+        // SHADOW_LIGHT_INVALID_INDEX if the light isn't shadowed this frame
+        unsigned int             GetLightBatch(unsigned int light) const;
+
+        // shadow masks written by the batches
+        unsigned int             GetMaskCount() const { return m_UsedMaskCount; }
+        unsigned int             GetShadowedLightCount() const { return m_ShadowedCount; }
+
+    private:
+        struct Light
+        {
+            ShadowLight  m_Desc;
+            unsigned int m_Region[6];
+            unsigned int m_RequestedSize;   // m_Size when the regions were placed, 0 if there are none
+            unsigned int m_RegionSize;      // m_RequestedSize, or less if the atlas was full
+            unsigned int m_Batch;
+            bool         m_Live;
+        };
+
+        void                     FreeRegions(Light & light, ShadowAtlasAllocator & atlas);
+        bool                     PlaceRegions(Light & light, ShadowAtlasAllocator & atlas, unsigned int minSize);
+        bool                     FitBatches(unsigned int lightCount, unsigned int & ownChannelCount) const;
+        void                     AddBatch(unsigned int firstLight, unsigned int lightCount, unsigned int channel);
+        void                     AddViews(unsigned int light);
+
+        unsigned int             m_MaskCount;
+        unsigned int             m_ReservedChannelCount;
+        unsigned int             m_UsedMaskCount;
+        unsigned int             m_ShadowedCount;
+
+        std::vector<Light>            m_Lights;
+        std::vector<unsigned int>     m_Order;          // live lights, highest priority first
+        std::vector<unsigned int>     m_Shadowed;       // the lights of m_Order that have regions
+        std::vector<ShadowLightView>  m_Views;
+        std::vector<ShadowLightBatch> m_Batches;
+    };
+}
+
+#endif // SHADOW_LIGHT_LIST_H
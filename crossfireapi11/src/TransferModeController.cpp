@@ -0,0 +1,237 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: TransferModeController.cpp
+//
+// Picks the AFR transfer mode of a resource at runtime from measured frame costs.
+//--------------------------------------------------------------------------------------
+#include "TransferModeController.h"
+
+namespace AMD
+{
+    TransferModeController::TransferModeController()
+    {
+        Init(TransferModeControllerDesc());
+    }
+
+    void TransferModeController::Init(const TransferModeControllerDesc & desc)
+    {
+        m_Desc = desc;
+
+        if (m_Desc.m_WindowFrames == 0) { m_Desc.m_WindowFrames = 1; }
+        if (m_Desc.m_ConfirmWindows == 0) { m_Desc.m_ConfirmWindows = 1; }
+
+        for (int i = 0; i < TRANSFER_MODE_COUNT; i++)
+        {
+            m_Estimate[i] = 0.0;
+            m_EstimateAge[i] = 0;
+            m_HasEstimate[i] = false;
+        }
+
+        m_Mode = m_SteadyMode = m_Desc.m_InitialMode;
+        m_Probing = false;
+        m_Warmup = m_Desc.m_WarmupFrames;
+        m_WindowCount = 0;
+        m_WindowSum = 0.0;
+        m_Confirm = 0;
+        m_ConfirmMode = -1;
+        m_WindowsSinceProbe = 0;
+        m_ProbeWindows = 0;
+        m_SwitchCount = 0;
+    }
+
+    bool TransferModeController::IsCandidate(int mode) const
+    {
+        return mode >= 0 && mode < TRANSFER_MODE_COUNT && (m_Desc.m_CandidateMask & TRANSFER_MODE_BIT(mode)) != 0;
+    }
+
+    bool TransferModeController::IsFresh(int mode) const
+    {
+        return m_HasEstimate[mode] && m_EstimateAge[mode] <= m_Desc.m_MaxEstimateAge;
+    }
+
+    bool TransferModeController::GetEstimate(int mode, double & cost) const
+    {
+        if (mode < 0 || mode >= TRANSFER_MODE_COUNT || m_HasEstimate[mode] == false) { return false; }
+
+        cost = m_Estimate[mode];
+        return true;
+    }
+
+    int TransferModeController::FindBestOtherMode() const
+    {
+        int best = -1;
+
+        for (int i = 0; i < TRANSFER_MODE_COUNT; i++)
+        {
+            if (i == m_Mode || IsCandidate(i) == false || IsFresh(i) == false) { continue; }
+
+            if (best < 0 || m_Estimate[i] < m_Estimate[best]) { best = i; }
+        }
+
+        return best;
+    }
+
+    int TransferModeController::FindModeToProbe() const
+    {
+        int oldest = -1;
+
+        for (int i = 0; i < TRANSFER_MODE_COUNT; i++)
+        {
+            if (i == m_Mode || IsCandidate(i) == false) { continue; }
+
+            if (m_HasEstimate[i] == false) { return i; } // never measured, probe it first
+
+            if (oldest < 0 || m_EstimateAge[i] > m_EstimateAge[oldest]) { oldest = i; }
+        }
+
+        return oldest;
+    }
+
+    void TransferModeController::Switch(int mode)
+    {
+        m_Mode = mode;
+        m_Warmup = m_Desc.m_WarmupFrames;
+        m_WindowCount = 0;
+        m_WindowSum = 0.0;
+        m_Confirm = 0;
+        m_ConfirmMode = -1;
+        m_ProbeWindows = 0;
+        m_SwitchCount++;
+    }
+
+    bool TransferModeController::SetCandidateMask(unsigned int candidateMask)
+    {
+        if (candidateMask == 0 || candidateMask == m_Desc.m_CandidateMask) { return false; }
+
+        m_Desc.m_CandidateMask = candidateMask;
+
+        if (IsCandidate(m_SteadyMode) == false) { m_SteadyMode = m_Mode; }
+
+        if (IsCandidate(m_Mode) == true) { return false; }
+
+        // the current mode was removed: go back to the best known mode (or the first allowed one)
+        int mode = IsCandidate(m_SteadyMode) ? m_SteadyMode : FindBestOtherMode();
+        for (int i = 0; mode < 0 && i < TRANSFER_MODE_COUNT; i++)
+        {
+            if (IsCandidate(i)) { mode = i; }
+        }
+
+        m_Probing = false;
+        m_SteadyMode = mode;
+        Switch(mode);
+
+        return true;
+    }
+
+    bool TransferModeController::AddSample(double cost)
+    {
+        if (m_Warmup > 0)
+        {
+            m_Warmup--;
+            return false;
+        }
+
+        m_WindowSum += cost;
+        m_WindowCount++;
+
+        if (m_WindowCount < m_Desc.m_WindowFrames)
+        {
+            return false;
+        }
+
+        const double average = m_WindowSum / (double)m_WindowCount;
+        m_WindowSum = 0.0;
+        m_WindowCount = 0;
+
+        return EndWindow(average);
+    }
+
+    bool TransferModeController::EndWindow(double average)
+    {
+        for (int i = 0; i < TRANSFER_MODE_COUNT; i++)
+        {
+            if (m_EstimateAge[i] < 0xffffffff) { m_EstimateAge[i]++; }
+        }
+
+        m_Estimate[m_Mode] = average;
+        m_EstimateAge[m_Mode] = 0;
+        m_HasEstimate[m_Mode] = true;
+
+        const double threshold = 1.0 - (double)m_Desc.m_Hysteresis;
+
+        if (m_Probing == true)
+        {
+            // a probe only sticks if it clearly beats the mode it interrupted, for as many
+            // windows in a row as a switch needs, so one noisy window can't move to a worse mode
+            if (IsFresh(m_SteadyMode) && average < m_Estimate[m_SteadyMode] * threshold)
+            {
+                if (++m_ProbeWindows < m_Desc.m_ConfirmWindows)
+                {
+                    return false;
+                }
+
+                m_Probing = false;
+                m_WindowsSinceProbe = 0;
+                m_ProbeWindows = 0;
+                m_SteadyMode = m_Mode;
+                return false;
+            }
+
+            m_Probing = false;
+            m_WindowsSinceProbe = 0;
+            Switch(m_SteadyMode);
+            return true;
+        }
+
+        const int best = FindBestOtherMode();
+        if (best >= 0 && m_Estimate[best] < average * threshold)
+        {
+            m_Confirm = (best == m_ConfirmMode) ? m_Confirm + 1 : 1;
+            m_ConfirmMode = best;
+
+            if (m_Confirm >= m_Desc.m_ConfirmWindows)
+            {
+                m_SteadyMode = best;
+                Switch(best);
+                return true;
+            }
+        }
+        else
+        {
+            m_Confirm = 0;
+            m_ConfirmMode = -1;
+        }
+
+        const int probe = FindModeToProbe();
+        if (probe >= 0 && (m_HasEstimate[probe] == false || ++m_WindowsSinceProbe >= m_Desc.m_ProbeInterval))
+        {
+            m_SteadyMode = m_Mode;
+            m_Probing = true;
+            Switch(probe);
+            return true;
+        }
+
+        return false;
+    }
+}
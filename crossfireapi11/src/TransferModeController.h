@@ -0,0 +1,122 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: TransferModeController.h
+//
+// Picks the AFR transfer mode of a resource at runtime from measured frame costs.
+//
+// The controller is fed one cost sample per frame (the cost of the frame with the
+// current mode) and averages them over windows. After every window it compares the
+// current mode against the last measurement of every other candidate mode, and only
+// switches when a candidate is better by more than the hysteresis for several windows
+// in a row. Candidates that were never measured, or were measured a long time ago,
+// are re-measured by probing them; a probe becomes the current mode only if it wins
+// for as many windows in a row, otherwise the probe ends after its first window.
+//
+// This code has no dependency on Windows, D3D11 or AGS; modes are AGSAfrTransferType
+// values stored as int.
+//--------------------------------------------------------------------------------------
+#ifndef TRANSFER_MODE_CONTROLLER_H
+#define TRANSFER_MODE_CONTROLLER_H
+
+// candidate mask bit of a mode
+#define TRANSFER_MODE_BIT(mode) (1u << (unsigned int)(mode))
+
+namespace AMD
+{
+    static const int TRANSFER_MODE_COUNT = 5; // AGS_AFR_TRANSFER_DEFAULT .. AGS_AFR_TRANSFER_2STEP_WITH_BROADCAST
+
+    struct TransferModeControllerDesc
+    {
+        int          m_InitialMode;
+        unsigned int m_CandidateMask;       // TRANSFER_MODE_BIT() of the modes the controller may pick
+        unsigned int m_WarmupFrames;        // samples ignored after a switch (resource recreation, pipeline refill)
+        unsigned int m_WindowFrames;        // samples averaged into one measurement
+        float        m_Hysteresis;          // a candidate must be this fraction cheaper than the current mode
+        unsigned int m_ConfirmWindows;      // ... for this many windows in a row
+        unsigned int m_ProbeInterval;       // windows between two probes of another mode
+        unsigned int m_MaxEstimateAge;      // windows after which a measurement is too old to switch on
+
+        TransferModeControllerDesc()
+            : m_InitialMode(2) // AGS_AFR_TRANSFER_1STEP_P2P
+            , m_CandidateMask(TRANSFER_MODE_BIT(1) | TRANSFER_MODE_BIT(2) | TRANSFER_MODE_BIT(3) | TRANSFER_MODE_BIT(4))
+            , m_WarmupFrames(16)
+            , m_WindowFrames(60)
+            , m_Hysteresis(0.05f)
+            , m_ConfirmWindows(2)
+            , m_ProbeInterval(30)
+            , m_MaxEstimateAge(120)
+        {}
+    };
+
+    class TransferModeController
+    {
+    public:
+        TransferModeController();
+
+        void         Init(const TransferModeControllerDesc & desc);
+
+        // restricts the modes the controller may pick, switches right away if the current mode isn't allowed anymore
+        // returns true if the mode changed
+        bool         SetCandidateMask(unsigned int candidateMask);
+
+        // cost (ms) of the last frame rendered with GetMode(), returns true if the mode changed
+        bool         AddSample(double cost);
+
+        int          GetMode() const { return m_Mode; }
+        bool         IsProbing() const { return m_Probing; }
+        unsigned int GetSwitchCount() const { return m_SwitchCount; }
+
+        // last window average of a mode, returns false if it was never measured
+        bool         GetEstimate(int mode, double & cost) const;
+
+    private:
+        bool         IsCandidate(int mode) const;
+        bool         IsFresh(int mode) const;
+        int          FindBestOtherMode() const;
+        int          FindModeToProbe() const;
+        void         Switch(int mode);
+        bool         EndWindow(double average);
+
+        TransferModeControllerDesc m_Desc;
+
+        int          m_Mode;
+        int          m_SteadyMode;          // mode to return to after a probe
+        bool         m_Probing;
+
+        double       m_Estimate[TRANSFER_MODE_COUNT];
+        unsigned int m_EstimateAge[TRANSFER_MODE_COUNT];
+        bool         m_HasEstimate[TRANSFER_MODE_COUNT];
+
+        unsigned int m_Warmup;
+        unsigned int m_WindowCount;
+        double       m_WindowSum;
+        unsigned int m_Confirm;
+        int          m_ConfirmMode;
+        unsigned int m_WindowsSinceProbe;
+        unsigned int m_ProbeWindows;        // windows in a row the probe beat the mode it interrupted
+        unsigned int m_SwitchCount;
+    };
+}
+
+#endif // TRANSFER_MODE_CONTROLLER_H
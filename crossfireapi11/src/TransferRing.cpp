@@ -0,0 +1,150 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: TransferRing.cpp
+//
+// Bookkeeping for a ring of intermediate transfer surfaces used by 2-step transfers.
+//--------------------------------------------------------------------------------------
+#include "TransferRing.h"
+
+namespace AMD
+{
+    TransferRing::TransferRing()
+    {
+        Init(1, 6);
+    }
+
+    void TransferRing::Init(unsigned int gpuCount, unsigned int faceCount, unsigned int slotCount)
+    {
+        m_GpuCount = gpuCount == 0 ? 1 : (gpuCount > TRANSFER_RING_MAX_GPU_COUNT ? TRANSFER_RING_MAX_GPU_COUNT : gpuCount);
+        m_SlotCount = slotCount > 0 ? (slotCount > TRANSFER_RING_MAX_SLOT_COUNT ? TRANSFER_RING_MAX_SLOT_COUNT : slotCount) : GetSlotCount(m_GpuCount);
+        m_FaceCount = faceCount;
+
+        m_ShadowMapVersion.assign(m_GpuCount * m_FaceCount, 0);
+        m_SlotVersion.assign(m_GpuCount * m_SlotCount * m_FaceCount, 0);
+        m_Fence.assign(m_SlotCount, 0);
+        m_Targets.assign(m_SlotCount, 0);
+    }
+
+    void TransferRing::MarkRendered(unsigned int gpu, unsigned int face, unsigned int frame)
+    {
+        if (gpu < m_GpuCount && face < m_FaceCount)
+        {
+            ShadowMapVersion(gpu, face) = frame + 1;
+        }
+    }
+
+    unsigned int TransferRing::GetFacesToWrite(unsigned int gpu, unsigned int slot, unsigned int * pFaces)
+    {
+        if (gpu >= m_GpuCount || slot >= m_SlotCount) { return 0; }
+
+        unsigned int count = 0;
+        for (unsigned int face = 0; face < m_FaceCount; face++)
+        {
+            if (SlotVersion(gpu, slot, face) != ShadowMapVersion(gpu, face))
+            {
+                SlotVersion(gpu, slot, face) = ShadowMapVersion(gpu, face);
+                pFaces[count++] = face;
+            }
+        }
+
+        return count;
+    }
+
+    void TransferRing::MarkSent(unsigned int gpu, unsigned int slot, unsigned int frame, bool broadcast)
+    {
+        if (gpu >= m_GpuCount || slot >= m_SlotCount || m_GpuCount < 2) { return; }
+
+        m_Fence[slot] = frame + 1;
+        m_Targets[slot] = 0;
+
+        for (unsigned int i = 1; i < m_GpuCount; i++)
+        {
+            const unsigned int dst = (gpu + i) % m_GpuCount;
+            if (i > 1 && broadcast == false) { break; }
+
+            // the transfer carries every region dst is missing, so dst's copy ends up matching ours
+            for (unsigned int face = 0; face < m_FaceCount; face++)
+            {
+                SlotVersion(dst, slot, face) = SlotVersion(gpu, slot, face);
+            }
+
+            m_Targets[slot] |= 1u << dst;
+        }
+    }
+
+    unsigned int TransferRing::GetReadSlot(unsigned int gpu, unsigned int frame, const bool * pCompleted) const
+    {
+        if (gpu >= m_GpuCount) { return TRANSFER_RING_INVALID_INDEX; }
+
+        unsigned int newest = TRANSFER_RING_INVALID_INDEX;
+        unsigned int newestCompleted = TRANSFER_RING_INVALID_INDEX;
+
+        for (unsigned int slot = 0; slot < m_SlotCount; slot++)
+        {
+            if (m_Fence[slot] == 0 || m_Fence[slot] > frame || (m_Targets[slot] & (1u << gpu)) == 0) { continue; }
+
+            bool older = false;
+            for (unsigned int face = 0; face < m_FaceCount && older == false; face++)
+            {
+                older = SlotVersion(gpu, slot, face) < m_ShadowMapVersion[gpu * m_FaceCount + face];
+            }
+            if (older == true) { continue; }
+
+            if (newest == TRANSFER_RING_INVALID_INDEX || m_Fence[slot] > m_Fence[newest])
+            {
+                newest = slot;
+            }
+
+            if (pCompleted != NULL && pCompleted[slot] == true &&
+                (newestCompleted == TRANSFER_RING_INVALID_INDEX || m_Fence[slot] > m_Fence[newestCompleted]))
+            {
+                newestCompleted = slot;
+            }
+        }
+
+        return pCompleted != NULL ? newestCompleted : newest;
+    }
+
+    unsigned int TransferRing::GetFacesToRead(unsigned int gpu, unsigned int slot, unsigned int * pFaces)
+    {
+        if (gpu >= m_GpuCount || slot >= m_SlotCount) { return 0; }
+
+        unsigned int count = 0;
+        for (unsigned int face = 0; face < m_FaceCount; face++)
+        {
+            if (SlotVersion(gpu, slot, face) > ShadowMapVersion(gpu, face))
+            {
+                ShadowMapVersion(gpu, face) = SlotVersion(gpu, slot, face);
+                pFaces[count++] = face;
+            }
+        }
+
+        return count;
+    }
+
+    unsigned int TransferRing::GetFence(unsigned int slot) const
+    {
+        return slot < m_SlotCount && m_Fence[slot] > 0 ? m_Fence[slot] - 1 : TRANSFER_RING_INVALID_INDEX;
+    }
+}
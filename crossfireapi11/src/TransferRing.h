@@ -0,0 +1,105 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: TransferRing.h
+//
+// Bookkeeping for a ring of intermediate transfer surfaces used by 2-step transfers.
+//
+// With a single transfer surface, a GPU copying its shadow map into the surface can
+// collide with the transfer of its previous frame still reading the surface, and a GPU
+// reading the surface has to wait for the newest transfer to land. With a ring, frame F
+// writes slot F % SlotCount, and SlotCount = GpuCount + 1 guarantees that slot is
+// neither the source of a recent outgoing transfer nor the target of a pending incoming
+// one. The reader picks the newest slot sent to its GPU, or, when the caller can tell
+// which transfers have landed, the newest completed one.
+//
+// Every face of the shadow map and of every GPU's copy of every slot carries a version
+// (the frame that rendered it), so the writer only copies the faces its slot is missing
+// and the reader never picks a slot older than what its GPU already has.
+//
+// This code has no dependency on Windows, D3D11 or AGS.
+//--------------------------------------------------------------------------------------
+#ifndef TRANSFER_RING_H
+#define TRANSFER_RING_H
+
+#include <stddef.h>
+#include <vector>
+
+namespace AMD
+{
+    static const unsigned int TRANSFER_RING_INVALID_INDEX = 0xffffffff;
+    static const unsigned int TRANSFER_RING_MAX_GPU_COUNT = 32;     // GPUs are tracked in a 32 bit mask
+    static const unsigned int TRANSFER_RING_MAX_SLOT_COUNT = TRANSFER_RING_MAX_GPU_COUNT + 1;
+
+    class TransferRing
+    {
+    public:
+        TransferRing();
+
+        static unsigned int GetSlotCount(unsigned int gpuCount) { return gpuCount > 1 ? gpuCount + 1 : 1; }
+
+        // forgets every version and fence, e.g. after the surfaces were recreated;
+        // slotCount 0 picks GetSlotCount(gpuCount), 1 models a single transfer surface
+        void         Init(unsigned int gpuCount, unsigned int faceCount, unsigned int slotCount = 0);
+
+        unsigned int GetSlotCount() const { return m_SlotCount; }
+        unsigned int GetWriteSlot(unsigned int frame) const { return frame % m_SlotCount; }
+
+        // gpu rendered face into its shadow map in frame
+        void         MarkRendered(unsigned int gpu, unsigned int face, unsigned int frame);
+
+        // faces the slot is missing on gpu; the caller copies them from the shadow map
+        unsigned int GetFacesToWrite(unsigned int gpu, unsigned int slot, unsigned int * pFaces);
+
+        // gpu notified EndWrites on slot in frame, the slot now travels to the next GPU or to all of them
+        void         MarkSent(unsigned int gpu, unsigned int slot, unsigned int frame, bool broadcast);
+
+        // the newest slot sent to gpu before frame that holds nothing older than its shadow map;
+        // if pCompleted is given (per slot, for this gpu), only completed slots are considered
+        // so the reader keeps its shadow map for another frame instead of waiting
+        unsigned int GetReadSlot(unsigned int gpu, unsigned int frame, const bool * pCompleted = NULL) const;
+
+        // faces of the slot newer than gpu's shadow map; the caller copies the slot into the shadow map
+        unsigned int GetFacesToRead(unsigned int gpu, unsigned int slot, unsigned int * pFaces);
+
+        // frame of the last EndWrites on slot, or TRANSFER_RING_INVALID_INDEX if it was never sent
+        unsigned int GetFence(unsigned int slot) const;
+
+    private:
+        unsigned int & ShadowMapVersion(unsigned int gpu, unsigned int face) { return m_ShadowMapVersion[gpu * m_FaceCount + face]; }
+        unsigned int & SlotVersion(unsigned int gpu, unsigned int slot, unsigned int face) { return m_SlotVersion[(gpu * m_SlotCount + slot) * m_FaceCount + face]; }
+        unsigned int   SlotVersion(unsigned int gpu, unsigned int slot, unsigned int face) const { return m_SlotVersion[(gpu * m_SlotCount + slot) * m_FaceCount + face]; }
+
+        unsigned int              m_GpuCount;
+        unsigned int              m_SlotCount;
+        unsigned int              m_FaceCount;
+
+        // versions are frame + 1, 0 means never written
+        std::vector<unsigned int> m_ShadowMapVersion;   // per GPU, per face
+        std::vector<unsigned int> m_SlotVersion;        // per GPU, per slot, per face
+        std::vector<unsigned int> m_Fence;              // per slot: frame + 1 of the last EndWrites
+        std::vector<unsigned int> m_Targets;            // per slot: mask of the GPUs the last EndWrites went to
+    };
+}
+
+#endif // TRANSFER_RING_H
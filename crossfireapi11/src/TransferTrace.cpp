@@ -0,0 +1,325 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: TransferTrace.cpp
+//
+// Ring buffer recorder and reader for Crossfire API transfer traces.
+//
+// File layout (little endian):
+//   "CFXT", version, gpu count, timer frequency, dropped record count,
+//   resource count, record count, resources, records (variable length: only the
+//   rects and subresources that were recorded are stored)
+//--------------------------------------------------------------------------------------
+#include "TransferTrace.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#ifdef _MSC_VER
+#pragma warning( disable : 4996 ) // fopen/strncpy are fine for this use
+#endif
+
+namespace AMD
+{
+    static const char         TRANSFER_TRACE_MAGIC[4] = { 'C', 'F', 'X', 'T' };
+    static const unsigned int TRANSFER_TRACE_VERSION = 1;
+
+    static bool Write(FILE * file, const void * data, size_t size) { return fwrite(data, size, 1, file) == 1; }
+    static bool Read(FILE * file, void * data, size_t size) { return fread(data, size, 1, file) == 1; }
+
+    unsigned long long GetTransferRegionBytes(const TransferTraceResource & resource, const TransferTraceRect * pRects, const unsigned int * pSubresources, unsigned int numSubresources)
+    {
+        const unsigned long long slice = (unsigned long long)resource.m_Width * resource.m_Height;
+        unsigned long long texels = 0;
+
+        const unsigned int count = numSubresources > 0 ? numSubresources : 1;
+        for (unsigned int i = 0; i < count; i++)
+        {
+            if (pSubresources != NULL && numSubresources > 0 && pSubresources[i] >= resource.m_ArraySize) { continue; }
+
+            unsigned long long area = slice;
+            if (pRects != NULL)
+            {
+                const int left = pRects[i].left > 0 ? pRects[i].left : 0;
+                const int top = pRects[i].top > 0 ? pRects[i].top : 0;
+                const int right = pRects[i].right < (int)resource.m_Width ? pRects[i].right : (int)resource.m_Width;
+                const int bottom = pRects[i].bottom < (int)resource.m_Height ? pRects[i].bottom : (int)resource.m_Height;
+
+                area = (right > left && bottom > top) ? (unsigned long long)(right - left) * (unsigned long long)(bottom - top) : 0;
+            }
+
+            // without a subresource list the region applies to every subresource
+            texels += (pSubresources == NULL || numSubresources == 0) ? area * resource.m_ArraySize : area;
+        }
+
+        return texels * resource.m_BytesPerTexel;
+    }
+
+    TransferTrace::TransferTrace()
+        : m_Enabled(false)
+        , m_GpuCount(1)
+        , m_TimerFrequency(1)
+        , m_Frame(0)
+        , m_Head(0)
+        , m_Count(0)
+        , m_Dropped(0)
+    {
+    }
+
+    void TransferTrace::Init(unsigned int recordCapacity, unsigned int gpuCount, unsigned long long timerFrequency)
+    {
+        Release();
+
+        m_Ring.resize(recordCapacity > 0 ? recordCapacity : 1);
+        m_GpuCount = gpuCount;
+        m_TimerFrequency = timerFrequency > 0 ? timerFrequency : 1;
+    }
+
+    void TransferTrace::Release()
+    {
+        m_Ring.clear();
+        m_Resources.clear();
+        m_ResourcePointers.clear();
+        m_Enabled = false;
+        m_Frame = 0;
+
+        Reset();
+    }
+
+    void TransferTrace::Reset()
+    {
+        m_Head = 0;
+        m_Count = 0;
+        m_Dropped = 0;
+    }
+
+    unsigned int TransferTrace::RegisterResource(const void * pResource, const char * name, unsigned int width, unsigned int height, unsigned int arraySize, unsigned int bytesPerTexel, int transferType)
+    {
+        TransferTraceResource resource;
+        memset(&resource, 0, sizeof(resource));
+        resource.m_Id = (unsigned int)m_Resources.size();
+        resource.m_Width = width;
+        resource.m_Height = height;
+        resource.m_ArraySize = arraySize > 0 ? arraySize : 1;
+        resource.m_BytesPerTexel = bytesPerTexel;
+        resource.m_TransferType = transferType;
+        strncpy(resource.m_Name, name != NULL ? name : "", sizeof(resource.m_Name) - 1);
+
+        // a recreated resource gets a new id so old records keep their description,
+        // but a stale pointer must not resolve to it anymore
+        for (size_t i = 0; i < m_ResourcePointers.size(); i++)
+        {
+            if (m_ResourcePointers[i] == pResource) { m_ResourcePointers[i] = NULL; }
+        }
+
+        m_Resources.push_back(resource);
+        m_ResourcePointers.push_back(pResource);
+
+        return resource.m_Id;
+    }
+
+    unsigned int TransferTrace::FindResource(const void * pResource) const
+    {
+        for (size_t i = m_ResourcePointers.size(); i > 0; i--)
+        {
+            if (m_ResourcePointers[i - 1] == pResource && pResource != NULL) { return (unsigned int)(i - 1); }
+        }
+
+        return TRANSFER_TRACE_INVALID_RESOURCE;
+    }
+
+    void TransferTrace::Record(TRANSFER_TRACE_EVENT event, const void * pResource, const void * pSource, const TransferTraceRect * pRects, const unsigned int * pSubresources, unsigned int numSubresources, unsigned long long timestamp)
+    {
+        if (m_Enabled == false || m_Ring.empty()) { return; }
+
+        const unsigned int resource = FindResource(pResource);
+        if (resource == TRANSFER_TRACE_INVALID_RESOURCE) { return; }
+
+        unsigned int slot;
+        if (m_Count < (unsigned int)m_Ring.size())
+        {
+            slot = (m_Head + m_Count) % (unsigned int)m_Ring.size();
+            m_Count++;
+        }
+        else
+        {
+            slot = m_Head;
+            m_Head = (m_Head + 1) % (unsigned int)m_Ring.size();
+            m_Dropped++;
+        }
+
+        TransferTraceRecord & record = m_Ring[slot];
+        record.m_Frame = m_Frame;
+        record.m_Resource = resource;
+        record.m_Source = pSource != NULL ? FindResource(pSource) : TRANSFER_TRACE_INVALID_RESOURCE;
+        record.m_Timestamp = timestamp;
+        record.m_Event = (unsigned char)event;
+        record.m_Flags = 0;
+        record.m_RegionCount = (unsigned short)numSubresources;
+        record.m_Bytes = (event == TRANSFER_TRACE_EVENT_END_WRITES || event == TRANSFER_TRACE_EVENT_COPY) ?
+                         GetTransferRegionBytes(m_Resources[resource], pRects, pSubresources, numSubresources) : 0;
+
+        const unsigned int rectCount = pRects != NULL ? (numSubresources > 0 ? numSubresources : 1) : 0;
+        const unsigned int subresourceCount = pSubresources != NULL ? numSubresources : 0;
+
+        record.m_RectCount = (unsigned short)(rectCount < TRANSFER_TRACE_MAX_REGIONS ? rectCount : TRANSFER_TRACE_MAX_REGIONS);
+        record.m_SubresourceCount = (unsigned short)(subresourceCount < TRANSFER_TRACE_MAX_REGIONS ? subresourceCount : TRANSFER_TRACE_MAX_REGIONS);
+
+        if (rectCount > TRANSFER_TRACE_MAX_REGIONS || subresourceCount > TRANSFER_TRACE_MAX_REGIONS)
+        {
+            record.m_Flags |= TRANSFER_TRACE_FLAG_TRUNCATED;
+        }
+
+        for (unsigned int i = 0; i < record.m_RectCount; i++)        { record.m_Rects[i] = pRects[i]; }
+        for (unsigned int i = 0; i < record.m_SubresourceCount; i++) { record.m_Subresources[i] = pSubresources[i]; }
+    }
+
+    void TransferTrace::RecordEndWrites(const void * pResource, const TransferTraceRect * pRects, const unsigned int * pSubresources, unsigned int numSubresources, unsigned long long timestamp)
+    {
+        Record(TRANSFER_TRACE_EVENT_END_WRITES, pResource, NULL, pRects, pSubresources, numSubresources, timestamp);
+    }
+
+    void TransferTrace::RecordBeginAllAccess(const void * pResource, unsigned long long timestamp)
+    {
+        Record(TRANSFER_TRACE_EVENT_BEGIN_ALL_ACCESS, pResource, NULL, NULL, NULL, 0, timestamp);
+    }
+
+    void TransferTrace::RecordEndAllAccess(const void * pResource, unsigned long long timestamp)
+    {
+        Record(TRANSFER_TRACE_EVENT_END_ALL_ACCESS, pResource, NULL, NULL, NULL, 0, timestamp);
+    }
+
+    void TransferTrace::RecordCopy(const void * pDst, const void * pSrc, const TransferTraceRect * pRects, const unsigned int * pSubresources, unsigned int numSubresources, unsigned long long timestamp)
+    {
+        Record(TRANSFER_TRACE_EVENT_COPY, pDst, pSrc, pRects, pSubresources, numSubresources, timestamp);
+    }
+
+    bool TransferTrace::Save(const char * path) const
+    {
+        FILE * file = fopen(path, "wb");
+        if (file == NULL) { return false; }
+
+        const unsigned int resourceCount = (unsigned int)m_Resources.size();
+        bool ok = Write(file, TRANSFER_TRACE_MAGIC, sizeof(TRANSFER_TRACE_MAGIC)) &&
+                  Write(file, &TRANSFER_TRACE_VERSION, sizeof(TRANSFER_TRACE_VERSION)) &&
+                  Write(file, &m_GpuCount, sizeof(m_GpuCount)) &&
+                  Write(file, &m_TimerFrequency, sizeof(m_TimerFrequency)) &&
+                  Write(file, &m_Dropped, sizeof(m_Dropped)) &&
+                  Write(file, &resourceCount, sizeof(resourceCount)) &&
+                  Write(file, &m_Count, sizeof(m_Count));
+
+        for (unsigned int i = 0; ok && i < resourceCount; i++)
+        {
+            const TransferTraceResource & r = m_Resources[i];
+            ok = Write(file, &r.m_Id, sizeof(r.m_Id)) &&
+                 Write(file, &r.m_Width, sizeof(r.m_Width)) &&
+                 Write(file, &r.m_Height, sizeof(r.m_Height)) &&
+                 Write(file, &r.m_ArraySize, sizeof(r.m_ArraySize)) &&
+                 Write(file, &r.m_BytesPerTexel, sizeof(r.m_BytesPerTexel)) &&
+                 Write(file, &r.m_TransferType, sizeof(r.m_TransferType)) &&
+                 Write(file, r.m_Name, sizeof(r.m_Name));
+        }
+
+        for (unsigned int i = 0; ok && i < m_Count; i++)
+        {
+            const TransferTraceRecord & r = m_Ring[(m_Head + i) % (unsigned int)m_Ring.size()];
+            ok = Write(file, &r.m_Frame, sizeof(r.m_Frame)) &&
+                 Write(file, &r.m_Resource, sizeof(r.m_Resource)) &&
+                 Write(file, &r.m_Source, sizeof(r.m_Source)) &&
+                 Write(file, &r.m_Timestamp, sizeof(r.m_Timestamp)) &&
+                 Write(file, &r.m_Bytes, sizeof(r.m_Bytes)) &&
+                 Write(file, &r.m_Event, sizeof(r.m_Event)) &&
+                 Write(file, &r.m_Flags, sizeof(r.m_Flags)) &&
+                 Write(file, &r.m_RectCount, sizeof(r.m_RectCount)) &&
+                 Write(file, &r.m_SubresourceCount, sizeof(r.m_SubresourceCount)) &&
+                 Write(file, &r.m_RegionCount, sizeof(r.m_RegionCount)) &&
+                 (r.m_RectCount == 0 || Write(file, r.m_Rects, sizeof(r.m_Rects[0]) * r.m_RectCount)) &&
+                 (r.m_SubresourceCount == 0 || Write(file, r.m_Subresources, sizeof(r.m_Subresources[0]) * r.m_SubresourceCount));
+        }
+
+        fclose(file);
+
+        return ok;
+    }
+
+    bool TransferTraceReader::Load(const char * path)
+    {
+        m_Resources.clear();
+        m_Records.clear();
+
+        FILE * file = fopen(path, "rb");
+        if (file == NULL) { return false; }
+
+        char magic[4];
+        unsigned int version = 0, resourceCount = 0, recordCount = 0;
+
+        bool ok = Read(file, magic, sizeof(magic)) && memcmp(magic, TRANSFER_TRACE_MAGIC, sizeof(magic)) == 0 &&
+                  Read(file, &version, sizeof(version)) && version == TRANSFER_TRACE_VERSION &&
+                  Read(file, &m_GpuCount, sizeof(m_GpuCount)) &&
+                  Read(file, &m_TimerFrequency, sizeof(m_TimerFrequency)) &&
+                  Read(file, &m_Dropped, sizeof(m_Dropped)) &&
+                  Read(file, &resourceCount, sizeof(resourceCount)) &&
+                  Read(file, &recordCount, sizeof(recordCount));
+
+        for (unsigned int i = 0; ok && i < resourceCount; i++)
+        {
+            TransferTraceResource r;
+            ok = Read(file, &r.m_Id, sizeof(r.m_Id)) &&
+                 Read(file, &r.m_Width, sizeof(r.m_Width)) &&
+                 Read(file, &r.m_Height, sizeof(r.m_Height)) &&
+                 Read(file, &r.m_ArraySize, sizeof(r.m_ArraySize)) &&
+                 Read(file, &r.m_BytesPerTexel, sizeof(r.m_BytesPerTexel)) &&
+                 Read(file, &r.m_TransferType, sizeof(r.m_TransferType)) &&
+                 Read(file, r.m_Name, sizeof(r.m_Name));
+
+            r.m_Name[sizeof(r.m_Name) - 1] = '\0';
+            if (ok) { m_Resources.push_back(r); }
+        }
+
+        for (unsigned int i = 0; ok && i < recordCount; i++)
+        {
+            TransferTraceRecord r;
+            memset(&r, 0, sizeof(r));
+            ok = Read(file, &r.m_Frame, sizeof(r.m_Frame)) &&
+                 Read(file, &r.m_Resource, sizeof(r.m_Resource)) &&
+                 Read(file, &r.m_Source, sizeof(r.m_Source)) &&
+                 Read(file, &r.m_Timestamp, sizeof(r.m_Timestamp)) &&
+                 Read(file, &r.m_Bytes, sizeof(r.m_Bytes)) &&
+                 Read(file, &r.m_Event, sizeof(r.m_Event)) &&
+                 Read(file, &r.m_Flags, sizeof(r.m_Flags)) &&
+                 Read(file, &r.m_RectCount, sizeof(r.m_RectCount)) &&
+                 Read(file, &r.m_SubresourceCount, sizeof(r.m_SubresourceCount)) &&
+                 Read(file, &r.m_RegionCount, sizeof(r.m_RegionCount)) &&
+                 r.m_RectCount <= TRANSFER_TRACE_MAX_REGIONS && r.m_SubresourceCount <= TRANSFER_TRACE_MAX_REGIONS &&
+                 r.m_Resource < resourceCount && r.m_Event < TRANSFER_TRACE_EVENT_COUNT &&
+                 (r.m_RectCount == 0 || Read(file, r.m_Rects, sizeof(r.m_Rects[0]) * r.m_RectCount)) &&
+                 (r.m_SubresourceCount == 0 || Read(file, r.m_Subresources, sizeof(r.m_Subresources[0]) * r.m_SubresourceCount));
+
+            if (ok) { m_Records.push_back(r); }
+        }
+
+        fclose(file);
+
+        return ok;
+    }
+}
@@ -0,0 +1,152 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: TransferTrace.h
+//
+// Records the Crossfire API notifications (EndWrites, BeginAllAccess, EndAllAccess) and
+// the copies into transferred resources into a fixed size ring buffer, and saves them
+// as a compact binary trace that tools/TransferTraceAnalyzer reads offline.
+//
+// Recording is a copy into a preallocated ring, nothing is allocated per event. When
+// the ring is full the oldest records are overwritten.
+//
+// This code has no dependency on Windows, D3D11 or AGS, so the reader can be used on
+// any platform; timestamps are raw CPU timer ticks and the caller sets their frequency.
+//--------------------------------------------------------------------------------------
+#ifndef TRANSFER_TRACE_H
+#define TRANSFER_TRACE_H
+
+#include <vector>
+
+namespace AMD
+{
+    typedef enum TRANSFER_TRACE_EVENT_t
+    {
+        TRANSFER_TRACE_EVENT_END_WRITES,
+        TRANSFER_TRACE_EVENT_BEGIN_ALL_ACCESS,
+        TRANSFER_TRACE_EVENT_END_ALL_ACCESS,
+        TRANSFER_TRACE_EVENT_COPY,                  // copy into a transferred resource, m_Source is the copy source
+
+        TRANSFER_TRACE_EVENT_COUNT,
+    } TRANSFER_TRACE_EVENT;
+
+    static const unsigned int TRANSFER_TRACE_MAX_REGIONS = 8;
+    static const unsigned int TRANSFER_TRACE_INVALID_RESOURCE = 0xffffffff;
+    static const unsigned int TRANSFER_TRACE_FLAG_TRUNCATED = 0x1; // more regions than TRANSFER_TRACE_MAX_REGIONS, m_Bytes is still exact
+
+    struct TransferTraceRect // same layout as D3D11_RECT
+    {
+        int left, top, right, bottom;
+    };
+
+    struct TransferTraceResource
+    {
+        unsigned int m_Id;
+        unsigned int m_Width;
+        unsigned int m_Height;
+        unsigned int m_ArraySize;
+        unsigned int m_BytesPerTexel;
+        int          m_TransferType;                // AGSAfrTransferType
+        char         m_Name[32];
+    };
+
+    struct TransferTraceRecord
+    {
+        unsigned int       m_Frame;
+        unsigned int       m_Resource;
+        unsigned int       m_Source;                // TRANSFER_TRACE_EVENT_COPY only
+        unsigned long long m_Timestamp;
+        unsigned long long m_Bytes;                 // bytes covered by the regions
+        unsigned char      m_Event;
+        unsigned char      m_Flags;
+        unsigned short     m_RectCount;
+        unsigned short     m_SubresourceCount;
+        unsigned short     m_RegionCount;           // numSubresources as passed to the API
+        TransferTraceRect  m_Rects[TRANSFER_TRACE_MAX_REGIONS];
+        unsigned int       m_Subresources[TRANSFER_TRACE_MAX_REGIONS];
+    };
+
+    class TransferTrace
+    {
+    public:
+        TransferTrace();
+
+        void         Init(unsigned int recordCapacity, unsigned int gpuCount, unsigned long long timerFrequency);
+        void         Release();
+
+        void         Reset();                       // drops the records, keeps the resources
+        void         SetEnabled(bool enabled) { m_Enabled = enabled; }
+        bool         IsEnabled() const { return m_Enabled; }
+
+        // resources are keyed by an opaque pointer (the ID3D11Resource), registering the same pointer again replaces it
+        unsigned int RegisterResource(const void * pResource, const char * name, unsigned int width, unsigned int height, unsigned int arraySize, unsigned int bytesPerTexel, int transferType);
+
+        void         SetFrame(unsigned int frame) { m_Frame = frame; }
+
+        // same arguments as the agsDriverExtensions_NotifyResource* calls
+        void         RecordEndWrites(const void * pResource, const TransferTraceRect * pRects, const unsigned int * pSubresources, unsigned int numSubresources, unsigned long long timestamp);
+        void         RecordBeginAllAccess(const void * pResource, unsigned long long timestamp);
+        void         RecordEndAllAccess(const void * pResource, unsigned long long timestamp);
+        void         RecordCopy(const void * pDst, const void * pSrc, const TransferTraceRect * pRects, const unsigned int * pSubresources, unsigned int numSubresources, unsigned long long timestamp);
+
+        unsigned int GetRecordCount() const { return m_Count; }
+        unsigned long long GetDroppedCount() const { return m_Dropped; }
+
+        bool         Save(const char * path) const;
+
+    private:
+        unsigned int FindResource(const void * pResource) const;
+        void         Record(TRANSFER_TRACE_EVENT event, const void * pResource, const void * pSource, const TransferTraceRect * pRects, const unsigned int * pSubresources, unsigned int numSubresources, unsigned long long timestamp);
+
+        bool                                m_Enabled;
+        unsigned int                        m_GpuCount;
+        unsigned long long                  m_TimerFrequency;
+        unsigned int                        m_Frame;
+
+        std::vector<TransferTraceResource>  m_Resources;
+        std::vector<const void *>           m_ResourcePointers;
+
+        std::vector<TransferTraceRecord>    m_Ring;
+        unsigned int                        m_Head;     // oldest record
+        unsigned int                        m_Count;
+        unsigned long long                  m_Dropped;  // records overwritten because the ring was full
+    };
+
+    class TransferTraceReader
+    {
+    public:
+        bool Load(const char * path);
+
+        unsigned int                        m_GpuCount;
+        unsigned long long                  m_TimerFrequency;
+        unsigned long long                  m_Dropped;
+        std::vector<TransferTraceResource>  m_Resources;
+        std::vector<TransferTraceRecord>    m_Records;
+    };
+
+    // bytes covered by a region list, with the agsDriverExtensions_NotifyResourceEndWrites conventions
+    // (numSubresources == 0 means all subresources and at most one rect, NULL rects mean the whole area)
+    unsigned long long GetTransferRegionBytes(const TransferTraceResource & resource, const TransferTraceRect * pRects, const unsigned int * pSubresources, unsigned int numSubresources);
+}
+
+#endif // TRANSFER_TRACE_H
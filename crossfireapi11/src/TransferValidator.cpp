@@ -0,0 +1,217 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: TransferValidator.cpp
+//
+// Validates the order of the Crossfire API notifications the sample issues.
+//--------------------------------------------------------------------------------------
+#include "TransferValidator.h"
+
+#include <stddef.h>
+#include <string.h>
+
+#ifdef _MSC_VER
+#pragma warning( disable : 4996 ) // strncpy is fine for this use
+#endif
+
+namespace AMD
+{
+    TransferValidator::TransferValidator()
+        : m_Frame(0)
+        , m_pCallback(NULL)
+        , m_pUserData(NULL)
+    {
+        ClearErrors();
+    }
+
+    void TransferValidator::SetCallback(TransferValidationCallback pCallback, void * pUserData)
+    {
+        m_pCallback = pCallback;
+        m_pUserData = pUserData;
+    }
+
+    TransferValidator::Resource & TransferValidator::FindResource(const void * pResource)
+    {
+        for (size_t i = 0; i < m_Resources.size(); i++)
+        {
+            if (m_Resources[i].m_pResource == pResource) { return m_Resources[i]; }
+        }
+
+        Resource resource;
+        memset(&resource, 0, sizeof(resource));
+        resource.m_pResource = pResource;
+        m_Resources.push_back(resource);
+
+        return m_Resources.back();
+    }
+
+    void TransferValidator::RegisterResource(const void * pResource, const char * name)
+    {
+        Resource & resource = FindResource(pResource);
+        memset(resource.m_Name, 0, sizeof(resource.m_Name));
+        strncpy(resource.m_Name, name != NULL ? name : "", sizeof(resource.m_Name) - 1);
+    }
+
+    void TransferValidator::Report(TRANSFER_VALIDATION_ERROR error, const Resource & resource)
+    {
+        m_ErrorCount[error]++;
+
+        if (m_pCallback != NULL)
+        {
+            TransferValidationError e;
+            e.m_Error = error;
+            e.m_Frame = m_Frame;
+            e.m_pResource = resource.m_pResource;
+            e.m_Name = resource.m_Name;
+            m_pCallback(e, m_pUserData);
+        }
+    }
+
+    void TransferValidator::BeginFrame(unsigned int frame)
+    {
+        m_Frame = frame;
+
+        for (size_t i = 0; i < m_Resources.size(); i++)
+        {
+            Resource & resource = m_Resources[i];
+            resource.m_Notified = false;
+            resource.m_Begun = false;
+            resource.m_Ended = false;
+        }
+    }
+
+    void TransferValidator::EndFrame()
+    {
+        for (size_t i = 0; i < m_Resources.size(); i++)
+        {
+            const Resource & resource = m_Resources[i];
+            if (resource.m_Notified == true && resource.m_Ended == false)
+            {
+                Report(TRANSFER_VALIDATION_ERROR_MISSING_END_ALL_ACCESS, resource);
+            }
+        }
+    }
+
+    void TransferValidator::BeginAllAccess(const void * pResource)
+    {
+        Resource & resource = FindResource(pResource);
+
+        if (resource.m_Ended == true)
+        {
+            Report(TRANSFER_VALIDATION_ERROR_BEGIN_ALL_ACCESS_AFTER_END_ALL_ACCESS, resource);
+        }
+        else if (resource.m_Begun == true)
+        {
+            Report(TRANSFER_VALIDATION_ERROR_DOUBLE_BEGIN_ALL_ACCESS, resource);
+        }
+
+        resource.m_Notified = true;
+        resource.m_Begun = true;
+    }
+
+    void TransferValidator::EndWrites(const void * pResource)
+    {
+        Resource & resource = FindResource(pResource);
+
+        if (resource.m_Ended == true)
+        {
+            Report(TRANSFER_VALIDATION_ERROR_END_WRITES_AFTER_END_ALL_ACCESS, resource);
+        }
+        else if (resource.m_WritesSinceEndWrites == 0)
+        {
+            Report(TRANSFER_VALIDATION_ERROR_END_WRITES_WITHOUT_WRITES, resource);
+        }
+
+        resource.m_Notified = true;
+        resource.m_WritesSinceEndWrites = 0;
+    }
+
+    void TransferValidator::EndAllAccess(const void * pResource)
+    {
+        Resource & resource = FindResource(pResource);
+
+        if (resource.m_Ended == true)
+        {
+            Report(TRANSFER_VALIDATION_ERROR_DOUBLE_END_ALL_ACCESS, resource);
+        }
+
+        resource.m_Notified = true;
+        resource.m_Ended = true;
+    }
+
+    void TransferValidator::Write(const void * pResource)
+    {
+        Resource & resource = FindResource(pResource);
+
+        if (resource.m_Ended == true)
+        {
+            Report(TRANSFER_VALIDATION_ERROR_WRITE_AFTER_END_ALL_ACCESS, resource);
+        }
+
+        resource.m_WritesSinceEndWrites++;
+    }
+
+    void TransferValidator::Read(const void * pResource)
+    {
+        Resource & resource = FindResource(pResource);
+
+        if (resource.m_Ended == true)
+        {
+            Report(TRANSFER_VALIDATION_ERROR_READ_AFTER_END_ALL_ACCESS, resource);
+        }
+    }
+
+    unsigned int TransferValidator::GetErrorCount() const
+    {
+        unsigned int count = 0;
+        for (int i = 0; i < TRANSFER_VALIDATION_ERROR_COUNT; i++)
+        {
+            count += m_ErrorCount[i];
+        }
+        return count;
+    }
+
+    void TransferValidator::ClearErrors()
+    {
+        for (int i = 0; i < TRANSFER_VALIDATION_ERROR_COUNT; i++)
+        {
+            m_ErrorCount[i] = 0;
+        }
+    }
+
+    const char * TransferValidator::GetErrorString(TRANSFER_VALIDATION_ERROR error)
+    {
+        switch (error)
+        {
+        case TRANSFER_VALIDATION_ERROR_WRITE_AFTER_END_ALL_ACCESS:           return "write after EndAllAccess";
+        case TRANSFER_VALIDATION_ERROR_READ_AFTER_END_ALL_ACCESS:            return "read after EndAllAccess";
+        case TRANSFER_VALIDATION_ERROR_END_WRITES_WITHOUT_WRITES:            return "EndWrites without a write since the previous EndWrites";
+        case TRANSFER_VALIDATION_ERROR_END_WRITES_AFTER_END_ALL_ACCESS:      return "EndWrites after EndAllAccess";
+        case TRANSFER_VALIDATION_ERROR_DOUBLE_BEGIN_ALL_ACCESS:              return "BeginAllAccess called twice in a frame";
+        case TRANSFER_VALIDATION_ERROR_BEGIN_ALL_ACCESS_AFTER_END_ALL_ACCESS: return "BeginAllAccess after EndAllAccess";
+        case TRANSFER_VALIDATION_ERROR_DOUBLE_END_ALL_ACCESS:                return "EndAllAccess called twice in a frame";
+        case TRANSFER_VALIDATION_ERROR_MISSING_END_ALL_ACCESS:               return "no EndAllAccess before the end of the frame";
+        default:                                                             return "unknown error";
+        }
+    }
+}
@@ -0,0 +1,149 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: TransferValidator.h
+//
+// Validates the order of the Crossfire API notifications the sample issues. Every
+// resource that receives a notification gets a small state machine per frame:
+//
+//     BeginAllAccess -> (reads / writes -> EndWrites)* -> reads -> EndAllAccess
+//
+// and the following mistakes are reported:
+//     - a write or a read after EndAllAccess (the driver may already transfer into it)
+//     - EndWrites without a write since the previous EndWrites (a redundant transfer)
+//     - BeginAllAccess twice in a frame, or after EndAllAccess
+//     - EndWrites or EndAllAccess after EndAllAccess
+//     - no EndAllAccess at the end of a frame that notified the resource (the driver
+//       then has to wait for the end of the frame, which serializes the GPUs)
+//
+// The validator is compiled into the sample only when ENABLE_TRANSFER_VALIDATION is 1
+// (define it in the project settings or before including this header); otherwise the
+// TRANSFER_VALIDATE_* macros expand to nothing. The class itself has no
+// dependency on Windows, D3D11 or AGS.
+//--------------------------------------------------------------------------------------
+#ifndef TRANSFER_VALIDATOR_H
+#define TRANSFER_VALIDATOR_H
+
+#ifndef ENABLE_TRANSFER_VALIDATION
+#define ENABLE_TRANSFER_VALIDATION 0
+#endif
+
+#include <vector>
+
+namespace AMD
+{
+    typedef enum TRANSFER_VALIDATION_ERROR_t
+    {
+        TRANSFER_VALIDATION_ERROR_WRITE_AFTER_END_ALL_ACCESS,
+        TRANSFER_VALIDATION_ERROR_READ_AFTER_END_ALL_ACCESS,
+        TRANSFER_VALIDATION_ERROR_END_WRITES_WITHOUT_WRITES,
+        TRANSFER_VALIDATION_ERROR_END_WRITES_AFTER_END_ALL_ACCESS,
+        TRANSFER_VALIDATION_ERROR_DOUBLE_BEGIN_ALL_ACCESS,
+        TRANSFER_VALIDATION_ERROR_BEGIN_ALL_ACCESS_AFTER_END_ALL_ACCESS,
+        TRANSFER_VALIDATION_ERROR_DOUBLE_END_ALL_ACCESS,
+        TRANSFER_VALIDATION_ERROR_MISSING_END_ALL_ACCESS,
+
+        TRANSFER_VALIDATION_ERROR_COUNT,
+    } TRANSFER_VALIDATION_ERROR;
+
+    struct TransferValidationError
+    {
+        TRANSFER_VALIDATION_ERROR m_Error;
+        unsigned int              m_Frame;
+        const void *              m_pResource;
+        const char *              m_Name;           // name given to RegisterResource, or ""
+    };
+
+    typedef void (*TransferValidationCallback)(const TransferValidationError & error, void * pUserData);
+
+    class TransferValidator
+    {
+    public:
+        TransferValidator();
+
+        // errors are counted, and passed to the callback if there is one
+        void         SetCallback(TransferValidationCallback pCallback, void * pUserData);
+
+        // optional, only used to name the resource in the errors
+        void         RegisterResource(const void * pResource, const char * name);
+
+        void         BeginFrame(unsigned int frame);
+        void         EndFrame();
+
+        void         BeginAllAccess(const void * pResource);
+        void         EndWrites(const void * pResource);
+        void         EndAllAccess(const void * pResource);
+
+        // the application rendered into, copied into or read from the resource
+        void         Write(const void * pResource);
+        void         Read(const void * pResource);
+
+        unsigned int GetErrorCount() const;
+        unsigned int GetErrorCount(TRANSFER_VALIDATION_ERROR error) const { return error < TRANSFER_VALIDATION_ERROR_COUNT ? m_ErrorCount[error] : 0; }
+        void         ClearErrors();
+
+        static const char * GetErrorString(TRANSFER_VALIDATION_ERROR error);
+
+    private:
+        struct Resource
+        {
+            const void * m_pResource;
+            char         m_Name[32];
+            unsigned int m_WritesSinceEndWrites;
+            bool         m_Notified;                // received a notification this frame
+            bool         m_Begun;
+            bool         m_Ended;
+        };
+
+        Resource &   FindResource(const void * pResource);
+        void         Report(TRANSFER_VALIDATION_ERROR error, const Resource & resource);
+
+        std::vector<Resource>      m_Resources;
+        unsigned int               m_Frame;
+        unsigned int               m_ErrorCount[TRANSFER_VALIDATION_ERROR_COUNT];
+        TransferValidationCallback m_pCallback;
+        void *                     m_pUserData;
+    };
+}
+
+#if ENABLE_TRANSFER_VALIDATION
+#define TRANSFER_VALIDATE_REGISTER_RESOURCE( validator, res, name ) (validator).RegisterResource( res, name );
+#define TRANSFER_VALIDATE_BEGIN_FRAME( validator, frame )       (validator).BeginFrame( frame );
+#define TRANSFER_VALIDATE_END_FRAME( validator )                (validator).EndFrame( );
+#define TRANSFER_VALIDATE_BEGIN_ALL_ACCESS( validator, res )    (validator).BeginAllAccess( res );
+#define TRANSFER_VALIDATE_END_WRITES( validator, res )          (validator).EndWrites( res );
+#define TRANSFER_VALIDATE_END_ALL_ACCESS( validator, res )      (validator).EndAllAccess( res );
+#define TRANSFER_VALIDATE_WRITE( validator, res )               (validator).Write( res );
+#define TRANSFER_VALIDATE_READ( validator, res )                (validator).Read( res );
+#else
+#define TRANSFER_VALIDATE_REGISTER_RESOURCE( validator, res, name )
+#define TRANSFER_VALIDATE_BEGIN_FRAME( validator, frame )
+#define TRANSFER_VALIDATE_END_FRAME( validator )
+#define TRANSFER_VALIDATE_BEGIN_ALL_ACCESS( validator, res )
+#define TRANSFER_VALIDATE_END_WRITES( validator, res )
+#define TRANSFER_VALIDATE_END_ALL_ACCESS( validator, res )
+#define TRANSFER_VALIDATE_WRITE( validator, res )
+#define TRANSFER_VALIDATE_READ( validator, res )
+#endif
+
+#endif // TRANSFER_VALIDATOR_H
@@ -0,0 +1,308 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: AfrSimulatorMain.cpp
+//
+// Headless driver for AfrSimulator: replays the CrossfireAPI11 transfer call sequence on
+// a simulated N GPU AFR system and prints per frame statistics, so transfer strategies
+// can be compared without Crossfire hardware.
+//
+// Build (any C++11 compiler, no Windows/D3D11/AGS dependency):
+//     g++ -std=c++11 -O2 -I../../src AfrSimulatorMain.cpp ../../src/AfrSimulator.cpp ../../src/TransferRing.cpp -o AfrSimulator
+//     cl /EHsc /O2 /I..\..\src AfrSimulatorMain.cpp ..\..\src\AfrSimulator.cpp ..\..\src\TransferRing.cpp
+//
+// Examples:
+//     AfrSimulator --gpus 2 --texture atlas --transfer 1step --frames 120 --csv
+//     AfrSimulator --gpus 4 --compare
+//     AfrSimulator --ring-test
+//--------------------------------------------------------------------------------------
+#include "AfrSimulator.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace AMD;
+
+struct Summary
+{
+    double m_AvgFrameTime;
+    double m_AvgStall;
+    double m_AvgContention;
+    double m_AvgWriteWait;
+    double m_AvgTransferMB;
+};
+
+static bool ParseTransfer(const char * name, int & transfer)
+{
+    for (int i = AFR_SIM_TRANSFER_DEFAULT; i <= AFR_SIM_TRANSFER_2STEP_WITH_BROADCAST; i++)
+    {
+        if (strcmp(name, GetAfrSimTransferName(i)) == 0) { transfer = i; return true; }
+    }
+    return false;
+}
+
+static void PrintUsage()
+{
+    printf("usage: AfrSimulator [options]\n"
+           "  --gpus N                   GPUs in AFR order (2)\n"
+           "  --p2p-bw GBs               GPU to GPU bandwidth (6)\n"
+           "  --p2p-latency ms           GPU to GPU latency (0.05)\n"
+           "  --sysmem-bw GBs            GPU to system memory bandwidth (10)\n"
+           "  --sysmem-latency ms        system memory latency (0.02)\n"
+           "  --contention f             fraction of speed lost while receiving (0.3)\n"
+           "  --cpu-frame ms             CPU time between submissions (2)\n"
+           "  --frames N                 frames to simulate (120)\n"
+           "  --texture atlas|array      shadow map layout (atlas)\n"
+           "  --transfer default|disable|1step|2step|broadcast (1step)\n"
+           "  --api 0|1                  use the Crossfire API (1)\n"
+           "  --two-step 0|1             copy to a transfer shadow map first (0)\n"
+           "  --delay-end-all-access 0|1 call EndAllAccess at the end of the frame (0)\n"
+           "  --single-face 0|1          update one cube face per frame (0)\n"
+           "  --size N                   shadow map size (1024)\n"
+           "  --slots N                  transfer shadow maps in the ring, 0 derives it from --gpus (0)\n"
+           "  --csv                      print per frame statistics\n"
+           "  --compare                  run every transfer mode and print a table\n"
+           "  --ring-test                check the transfer ring removes write stalls on 2, 3 and 4 GPUs\n");
+}
+
+static Summary Run(const AfrSimulatorDesc & desc, const AfrSimSampleSettings & settings, int frames, bool csv)
+{
+    AfrSimulator sim;
+    sim.Init(desc);
+
+    AfrSimSampleReplay replay;
+    replay.Init(sim, settings);
+
+    for (int i = 0; i < frames; i++)
+    {
+        replay.RenderFrame(sim);
+    }
+
+    replay.Release(sim);
+
+    const std::vector<AfrSimFrameStats> & stats = sim.GetFrameStats();
+
+    if (csv)
+    {
+        printf("frame,gpu,start_ms,end_ms,gpu_ms,frame_ms,stall_ms,contention_ms,write_wait_ms,transfer_bytes\n");
+        for (size_t i = 0; i < stats.size(); i++)
+        {
+            const AfrSimFrameStats & s = stats[i];
+            printf("%u,%u,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.4f,%.0f\n",
+                s.m_FrameIndex, s.m_Gpu, s.m_Start, s.m_End, s.m_GpuTime, s.m_FrameTime, s.m_StallTime, s.m_ContentionTime, s.m_WriteWaitTime, s.m_TransferBytes);
+        }
+    }
+
+    // skip the first frames so the pipeline is full
+    const size_t warmup = stats.size() > (size_t)desc.m_GpuCount * 2 ? (size_t)desc.m_GpuCount * 2 : 0;
+
+    Summary summary = { 0.0, 0.0, 0.0, 0.0, 0.0 };
+    for (size_t i = warmup; i < stats.size(); i++)
+    {
+        summary.m_AvgFrameTime += stats[i].m_FrameTime;
+        summary.m_AvgStall += stats[i].m_StallTime;
+        summary.m_AvgContention += stats[i].m_ContentionTime;
+        summary.m_AvgWriteWait += stats[i].m_WriteWaitTime;
+        summary.m_AvgTransferMB += stats[i].m_TransferBytes / (1024.0 * 1024.0);
+    }
+
+    const double count = stats.size() > warmup ? (double)(stats.size() - warmup) : 1.0;
+    summary.m_AvgFrameTime /= count;
+    summary.m_AvgStall /= count;
+    summary.m_AvgContention /= count;
+    summary.m_AvgWriteWait /= count;
+    summary.m_AvgTransferMB /= count;
+
+    return summary;
+}
+
+static void PrintSummaryHeader()
+{
+    printf("%-10s %-9s %-6s %-9s %10s %8s %10s %10s %10s %8s\n", "transfer", "two-step", "delay", "texture", "frame_ms", "fps", "stall_ms", "cont_ms", "wait_ms", "MB/frame");
+}
+
+static void PrintSummary(const AfrSimSampleSettings & settings, const Summary & summary)
+{
+    printf("%-10s %-9s %-6s %-9s %10.3f %8.1f %10.3f %10.3f %10.3f %8.2f\n",
+        settings.m_EnableCrossfireApiTransfers ? GetAfrSimTransferName(settings.m_ResourceTransferType) : "no-api",
+        settings.m_Enable2StepGpuTransfer ? "yes" : "no",
+        settings.m_DelayEndAllAccess ? "yes" : "no",
+        settings.m_ShadowTextureType == 1 ? "array" : "atlas",
+        summary.m_AvgFrameTime,
+        summary.m_AvgFrameTime > 0.0 ? 1000.0 / summary.m_AvgFrameTime : 0.0,
+        summary.m_AvgStall,
+        summary.m_AvgContention,
+        summary.m_AvgWriteWait,
+        summary.m_AvgTransferMB);
+}
+
+// Every GPU sends the whole shadow map every frame through system memory. With a
+// single transfer shadow map, a GPU has to wait for the incoming transfer before
+// it can read the surface or overwrite it with its own faces. With one slot more
+// than GPUs it reads the newest slot that has landed and never waits.
+// The system memory hop is slow enough that on 2 GPUs too a transfer is still in
+// flight when the other GPU reaches the slot, so the single slot has to stall on
+// every GPU count, and the test fails if it doesn't: the ring would have nothing
+// to remove.
+static int RunRingTest(const AfrSimulatorDesc & baseDesc, const AfrSimSampleSettings & baseSettings, int frames)
+{
+    AfrSimulatorDesc desc = baseDesc;
+    desc.m_SysMemBandwidth = 3.0;
+
+    AfrSimSampleSettings settings = baseSettings;
+    settings.m_EnableCrossfireApiTransfers = true;
+    settings.m_Enable2StepGpuTransfer = true;
+    settings.m_SingleFacePerFrame = false;
+    settings.m_MaxShadowMapFrameDelay = 1;
+    settings.m_ShadowMapSize = 512;
+
+    printf("# sysmem %.1f GB/s, contention %.2f, %d frames, all faces every frame\n", desc.m_SysMemBandwidth, desc.m_Contention, frames);
+    printf("%-5s %-10s %5s %10s %10s %10s\n", "gpus", "transfer", "slots", "frame_ms", "stall_ms", "wait_ms");
+
+    int failures = 0;
+    for (unsigned int gpuCount = 2; gpuCount <= 4; gpuCount++)
+    {
+        desc.m_GpuCount = gpuCount;
+
+        for (int transfer = AFR_SIM_TRANSFER_2STEP_NO_BROADCAST; transfer <= AFR_SIM_TRANSFER_2STEP_WITH_BROADCAST; transfer++)
+        {
+            settings.m_ResourceTransferType = transfer;
+
+            settings.m_TransferSlotCount = 1;
+            const Summary single = Run(desc, settings, frames, false);
+
+            settings.m_TransferSlotCount = TransferRing::GetSlotCount(gpuCount);
+            const Summary ring = Run(desc, settings, frames, false);
+
+            const bool pass = single.m_AvgWriteWait + single.m_AvgStall >= 0.01 &&
+                              ring.m_AvgWriteWait + ring.m_AvgStall < 0.01 &&
+                              ring.m_AvgFrameTime < single.m_AvgFrameTime;
+
+            printf("%-5u %-10s %5u %10.3f %10.3f %10.3f\n", gpuCount, GetAfrSimTransferName(transfer), 1u, single.m_AvgFrameTime, single.m_AvgStall, single.m_AvgWriteWait);
+            printf("%-5u %-10s %5u %10.3f %10.3f %10.3f %s\n", gpuCount, GetAfrSimTransferName(transfer), settings.m_TransferSlotCount, ring.m_AvgFrameTime, ring.m_AvgStall, ring.m_AvgWriteWait, pass ? "PASS" : "FAIL");
+
+            failures += pass ? 0 : 1;
+        }
+    }
+
+    return failures;
+}
+
+int main(int argc, char * argv[])
+{
+    AfrSimulatorDesc desc;
+    AfrSimSampleSettings settings;
+    settings.m_MaxShadowMapFrameDelay = 0; // pick the sample's default from the GPU count
+
+    int frames = 120;
+    bool csv = false;
+    bool compare = false;
+    bool ringTest = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char * arg = argv[i];
+        const char * value = i + 1 < argc ? argv[i + 1] : NULL;
+
+        if (strcmp(arg, "--csv") == 0) { csv = true; continue; }
+        if (strcmp(arg, "--compare") == 0) { compare = true; continue; }
+        if (strcmp(arg, "--ring-test") == 0) { ringTest = true; continue; }
+        if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0) { PrintUsage(); return 0; }
+
+        if (value == NULL) { fprintf(stderr, "missing value for %s\n", arg); PrintUsage(); return 1; }
+        i++;
+
+        if      (strcmp(arg, "--gpus") == 0)                 { desc.m_GpuCount = (unsigned int)atoi(value); }
+        else if (strcmp(arg, "--p2p-bw") == 0)               { desc.m_P2PBandwidth = atof(value); }
+        else if (strcmp(arg, "--p2p-latency") == 0)          { desc.m_P2PLatency = atof(value); }
+        else if (strcmp(arg, "--sysmem-bw") == 0)            { desc.m_SysMemBandwidth = atof(value); }
+        else if (strcmp(arg, "--sysmem-latency") == 0)       { desc.m_SysMemLatency = atof(value); }
+        else if (strcmp(arg, "--contention") == 0)           { desc.m_Contention = atof(value); }
+        else if (strcmp(arg, "--cpu-frame") == 0)            { desc.m_CpuFrameTime = atof(value); }
+        else if (strcmp(arg, "--frames") == 0)               { frames = atoi(value); }
+        else if (strcmp(arg, "--size") == 0)                 { settings.m_ShadowMapSize = (unsigned int)atoi(value); }
+        else if (strcmp(arg, "--slots") == 0)                { settings.m_TransferSlotCount = (unsigned int)atoi(value); }
+        else if (strcmp(arg, "--api") == 0)                  { settings.m_EnableCrossfireApiTransfers = atoi(value) != 0; }
+        else if (strcmp(arg, "--two-step") == 0)             { settings.m_Enable2StepGpuTransfer = atoi(value) != 0; }
+        else if (strcmp(arg, "--delay-end-all-access") == 0) { settings.m_DelayEndAllAccess = atoi(value) != 0; }
+        else if (strcmp(arg, "--single-face") == 0)          { settings.m_SingleFacePerFrame = atoi(value) != 0; }
+        else if (strcmp(arg, "--texture") == 0)
+        {
+            if      (strcmp(value, "atlas") == 0) { settings.m_ShadowTextureType = 0; }
+            else if (strcmp(value, "array") == 0) { settings.m_ShadowTextureType = 1; }
+            else { fprintf(stderr, "unknown texture type %s\n", value); return 1; }
+        }
+        else if (strcmp(arg, "--transfer") == 0)
+        {
+            if (ParseTransfer(value, settings.m_ResourceTransferType) == false) { fprintf(stderr, "unknown transfer type %s\n", value); return 1; }
+        }
+        else
+        {
+            fprintf(stderr, "unknown option %s\n", arg);
+            PrintUsage();
+            return 1;
+        }
+    }
+
+    if (desc.m_GpuCount == 0 || frames <= 0)
+    {
+        fprintf(stderr, "--gpus and --frames must be positive\n");
+        return 1;
+    }
+
+    if (ringTest == true)
+    {
+        return RunRingTest(desc, settings, frames) == 0 ? 0 : 1;
+    }
+
+    printf("# %u GPUs, p2p %.1f GB/s, sysmem %.1f GB/s, contention %.2f, %d frames\n",
+        desc.m_GpuCount, desc.m_P2PBandwidth, desc.m_SysMemBandwidth, desc.m_Contention, frames);
+
+    if (compare == false)
+    {
+        const Summary summary = Run(desc, settings, frames, csv);
+        PrintSummaryHeader();
+        PrintSummary(settings, summary);
+        return 0;
+    }
+
+    PrintSummaryHeader();
+
+    AfrSimSampleSettings run = settings;
+    run.m_EnableCrossfireApiTransfers = false;
+    PrintSummary(run, Run(desc, run, frames, false));
+
+    run.m_EnableCrossfireApiTransfers = true;
+    for (int transfer = AFR_SIM_TRANSFER_1STEP_P2P; transfer <= AFR_SIM_TRANSFER_2STEP_WITH_BROADCAST; transfer++)
+    {
+        for (int twoStep = 0; twoStep < 2; twoStep++)
+        {
+            run.m_ResourceTransferType = transfer;
+            run.m_Enable2StepGpuTransfer = twoStep != 0;
+            PrintSummary(run, Run(desc, run, frames, false));
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,487 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//--------------------------------------------------------------------------------------
+// File: BenchmarkMain.cpp
+//
+// The benchmark mode of the sample on the null render backend (NullFrameLoop): the viewer
+// and the light follow a path, every frame after the warmup is measured, and the results
+// are printed as a table and saved as JSON or CSV, in the same format the sample writes
+// with -benchmark. The CPU times are those of this machine; the GPU times, the transfers
+// and the frame time are those AfrSimulator predicts.
+//
+// --sweep runs the benchmark once per configuration of a sweep file (see BenchmarkSweep.h)
+// and ranks the configurations by their mean, with its 95% confidence interval; --output
+// then saves the ranking, as text or CSV.
+//
+// --check instead checks the parts of the benchmark that don't time anything: path parsing
+// and interpolation, the statistics and the confidence interval, the JSON/CSV output, and
+// the configurations and the ranking of a sweep. Exits nonzero if a check fails.
+//
+// Build (any C++11 compiler, no Windows/D3D11/AGS dependency):
+//     g++ -std=c++11 -O2 -pthread -I../../src BenchmarkMain.cpp ../../src/Benchmark.cpp ../../src/BenchmarkSweep.cpp ../../src/NullFrameLoop.cpp ../../src/AfrSimulator.cpp ../../src/TransferRing.cpp ../../src/CameraBatch.cpp ../../src/ShadowCasterCulling.cpp ../../src/JobSystem.cpp -o Benchmark
+//     cl /EHsc /O2 /I..\..\src BenchmarkMain.cpp ..\..\src\Benchmark.cpp ..\..\src\BenchmarkSweep.cpp ..\..\src\NullFrameLoop.cpp ..\..\src\AfrSimulator.cpp ..\..\src\TransferRing.cpp ..\..\src\CameraBatch.cpp ..\..\src\ShadowCasterCulling.cpp ..\..\src\JobSystem.cpp
+//
+// Usage:
+//     Benchmark [--path file] [--warmup N] [--frames N] [--output file.json|file.csv]
+//               [--gpus N] [--texture atlas|array] [--transfer default|disable|1step|2step|broadcast]
+//               [--2step 0|1] [--delay-end-all-access 0|1] [--single-face 0|1] [--size N]
+//               [--casters N] [--threads N] [--seed N]
+//     Benchmark --sweep file [--path file] [--warmup N] [--frames N] [--output file.txt|file.csv] ...
+//     Benchmark --check [--seed N]
+//--------------------------------------------------------------------------------------
+#include "Benchmark.h"
+#include "BenchmarkSweep.h"
+#include "NullFrameLoop.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+#ifdef _MSC_VER
+#pragma warning( disable : 4996 ) // tmpfile is fine for this use
+#endif
+
+using namespace AMD;
+
+// xorshift32, so every platform checks the same sequence
+static unsigned int g_RandomState = 1;
+
+static unsigned int Random(unsigned int count)
+{
+    g_RandomState ^= g_RandomState << 13;
+    g_RandomState ^= g_RandomState >> 17;
+    g_RandomState ^= g_RandomState << 5;
+    return g_RandomState % count;
+}
+
+static int g_Failures = 0;
+
+static void Check(bool condition, const char * name, float value)
+{
+    printf("%-48s %10.4g %s\n", name, value, condition ? "ok" : "FAIL");
+    g_Failures += condition ? 0 : 1;
+}
+
+// an orbit of the viewer around the scene and a light circling over it, for runs without --path
+static const char * DEFAULT_PATH =
+    "# track  time   eye x y z          at x y z\n"
+    "camera   0.0    0.0  8.0 -25.0     0.0 2.0 0.0\n"
+    "camera   5.0    25.0 8.0  0.0      0.0 2.0 0.0\n"
+    "camera   10.0   0.0  8.0  25.0     0.0 2.0 0.0\n"
+    "camera   15.0   -25.0 8.0 0.0      0.0 2.0 0.0\n"
+    "camera   20.0   0.0  8.0 -25.0     0.0 2.0 0.0\n"
+    "light    0.0    5.0  10.0 -5.0     0.0 0.0 0.0\n"
+    "light    10.0   -5.0 10.0 5.0      0.0 0.0 0.0\n"
+    "light    20.0   5.0  10.0 -5.0     0.0 0.0 0.0\n";
+
+static bool IsNear(double a, double b, double tolerance)
+{
+    return fabs(a - b) <= tolerance;
+}
+
+static void CheckPath()
+{
+    BenchmarkPath path;
+    const bool parsedDefault = path.Parse(DEFAULT_PATH);
+    Check(parsedDefault == true, "default path parses", (float)path.GetErrorLine());
+    Check(path.GetKeyCount(BENCHMARK_TRACK_CAMERA) == 5 && path.GetKeyCount(BENCHMARK_TRACK_LIGHT) == 3, "default path keys", (float)path.GetKeyCount(BENCHMARK_TRACK_CAMERA));
+    Check(IsNear(path.GetDuration(), 20.0, 1e-6), "default path duration", path.GetDuration());
+
+    float eye[3], at[3];
+    path.Sample(BENCHMARK_TRACK_CAMERA, 2.5f, eye, at);
+    Check(IsNear(eye[0], 12.5, 1e-4) && IsNear(eye[2], -12.5, 1e-4) && IsNear(at[1], 2.0, 1e-6), "interpolated between keys", eye[0]);
+
+    path.Sample(BENCHMARK_TRACK_CAMERA, 22.5f, eye, at);
+    Check(IsNear(eye[0], 12.5, 1e-3) && IsNear(eye[2], -12.5, 1e-3), "repeats after the last key", eye[0]);
+
+    path.Sample(BENCHMARK_TRACK_LIGHT, 10.0f, eye, at);
+    Check(IsNear(eye[0], -5.0, 1e-5) && IsNear(eye[2], 5.0, 1e-5), "exact at a key", eye[0]);
+
+    // random times stay between the extremes of the keys
+    unsigned int outside = 0;
+    for (unsigned int i = 0; i < 1000; i++)
+    {
+        const float time = (float)Random(100000) / 1000.0f;
+        path.Sample(BENCHMARK_TRACK_CAMERA, time, eye, at);
+        outside += (eye[0] < -25.0001f || eye[0] > 25.0001f || eye[2] < -25.0001f || eye[2] > 25.0001f) ? 1 : 0;
+    }
+    Check(outside == 0, "random times inside the keys", (float)outside);
+
+    BenchmarkPath empty;
+    Check(empty.Parse("# nothing\n\n") == true && empty.Sample(BENCHMARK_TRACK_LIGHT, 1.0f, eye, at) == false, "empty track leaves the camera", 0.0f);
+
+    BenchmarkPath bad;
+    bool parsed = bad.Parse("camera 0 0 0 0 0 0 0\nsun 1 0 0 0 0 0 0\n");
+    Check(parsed == false && bad.GetErrorLine() == 2, "unknown track rejected", (float)bad.GetErrorLine());
+    parsed = bad.Parse("camera 0 0 0 0 0 0\n");
+    Check(parsed == false && bad.GetErrorLine() == 1, "short line rejected", (float)bad.GetErrorLine());
+    parsed = bad.Parse("camera 1 0 0 0 0 0 0\ncamera 0 0 0 0 0 0 0\n");
+    Check(parsed == false && bad.GetErrorLine() == 2, "decreasing time rejected", (float)bad.GetErrorLine());
+    Check(bad.Load("no/such/path.txt") == false, "missing file rejected", 0.0f);
+}
+
+static void CheckStats()
+{
+    // 1..100: known percentiles with linear interpolation
+    std::vector<double> values;
+    for (unsigned int i = 0; i < 100; i++)
+    {
+        values.push_back((double)(100 - i));
+    }
+    BenchmarkStats stats = GetBenchmarkStats(values.data(), (unsigned int)values.size());
+    Check(IsNear(stats.m_Mean, 50.5, 1e-9) && IsNear(stats.m_Min, 1.0, 0.0) && IsNear(stats.m_Max, 100.0, 0.0), "mean, min, max", (float)stats.m_Mean);
+    Check(IsNear(stats.m_P50, 50.5, 1e-9) && IsNear(stats.m_P90, 90.1, 1e-9) && IsNear(stats.m_P99, 99.01, 1e-9), "percentiles", (float)stats.m_P90);
+    Check(IsNear(stats.m_StdDev, 29.011491975882016, 1e-9), "standard deviation", (float)stats.m_StdDev);
+
+    // t(0.975, 99) = 1.984217
+    const double ci = GetBenchmarkConfidence95(stats);
+    Check(IsNear(ci, 1.984217 * stats.m_StdDev / 10.0, 1e-3), "95% confidence, 99 degrees of freedom", (float)ci);
+
+    const double two[2] = { 1.0, 3.0 };
+    stats = GetBenchmarkStats(two, 2);
+    Check(IsNear(GetBenchmarkConfidence95(stats), 12.7062 * stats.m_StdDev / sqrt(2.0), 1e-3), "95% confidence, 1 degree of freedom", (float)GetBenchmarkConfidence95(stats));
+
+    const double one = 4.0;
+    stats = GetBenchmarkStats(&one, 1);
+    Check(stats.m_P99 == 4.0 && stats.m_StdDev == 0.0 && GetBenchmarkConfidence95(stats) == 0.0, "single sample", (float)stats.m_P99);
+
+    stats = GetBenchmarkStats(NULL, 0);
+    Check(stats.m_Count == 0 && stats.m_Mean == 0.0, "no samples", 0.0f);
+}
+
+static std::string ReadAll(FILE * pFile)
+{
+    std::string text;
+    char        buffer[4096];
+    size_t      size = 0;
+    rewind(pFile);
+    while ((size = fread(buffer, 1, sizeof(buffer), pFile)) > 0)
+    {
+        text.append(buffer, size);
+    }
+    return text;
+}
+
+static void CheckResults()
+{
+    BenchmarkResults results;
+    results.SetSetting("transfer", "1step");
+    results.SetSetting("transfer", "2step");
+    const unsigned int time = results.AddMetric("Frame (CPU)", "ms");
+    Check(results.AddMetric("Frame (CPU)", "ms") == time && results.GetSettingCount() == 1, "metrics and settings are unique", (float)results.GetSettingCount());
+
+    for (unsigned int frame = 0; frame < 10; frame++)
+    {
+        results.BeginFrame();
+        results.Set(time, (double)frame);
+        if (frame == 5)
+        {
+            results.Add(results.AddMetric("Late \"Metric\"", "calls"), 2.0);
+            results.Add(results.FindMetric("Late \"Metric\""), 1.0);
+        }
+    }
+
+    const unsigned int late = results.FindMetric("Late \"Metric\"");
+    Check(results.GetFrameCount() == 10 && results.Get(4, late) == 0.0 && results.Get(5, late) == 3.0, "late metric is 0 before it was added", (float)results.Get(5, late));
+    Check(results.FindMetric("Missing") == BENCHMARK_INVALID_INDEX, "missing metric", 0.0f);
+
+    FILE * pFile = tmpfile();
+    if (pFile == NULL)
+    {
+        Check(false, "temporary file", 0.0f);
+        return;
+    }
+
+    const bool json = results.WriteJson(pFile, true);
+    const std::string text = ReadAll(pFile);
+    Check(json == true && text.find("\"transfer\": \"2step\"") != std::string::npos && text.find("Late \\\"Metric\\\"") != std::string::npos, "JSON settings and escaping", (float)text.size());
+    fclose(pFile);
+
+    pFile = tmpfile();
+    if (pFile != NULL)
+    {
+        const bool csv = results.WriteCsv(pFile);
+        const std::string lines = ReadAll(pFile);
+        unsigned int count = 0;
+        for (size_t i = 0; i < lines.size(); i++)
+        {
+            count += lines[i] == '\n' ? 1 : 0;
+        }
+        Check(csv == true && count == 1 + results.GetMetricCount(), "CSV has a row per metric", (float)count);
+        fclose(pFile);
+    }
+}
+
+static void CheckSweep()
+{
+    BenchmarkSweep sweep;
+    Check(sweep.GetConfigCount() == 1 && strcmp(sweep.GetMetric(), "Frame Time") == 0, "default sweep is the sample", (float)sweep.GetConfigCount());
+
+    const char * text =
+        "# the transfers of a 2D atlas\n"
+        "texture  = atlas\n"
+        "transfer = 1step, 2step ,broadcast\n"
+        "2step    = off, on\n"
+        "delay    = off,on   # EndAllAccess\n"
+        "size     = 1024, 2048\n"
+        "update   = all, single\n"
+        "metric   = Frame (GPU)\n";
+    const bool parsed = sweep.Parse(text);
+    Check(parsed == true && sweep.GetConfigCount() == 48 && strcmp(sweep.GetMetric(), "Frame (GPU)") == 0, "sweep file parses", (float)sweep.GetConfigCount());
+
+    // every configuration is a different point of the product, the last axis changing the fastest
+    unsigned int duplicates = 0;
+    for (unsigned int a = 0; a < sweep.GetConfigCount(); a++)
+    {
+        const BenchmarkSweepConfig ca = sweep.GetConfig(a);
+        for (unsigned int b = a + 1; b < sweep.GetConfigCount(); b++)
+        {
+            const BenchmarkSweepConfig cb = sweep.GetConfig(b);
+            duplicates += (ca.m_TransferType == cb.m_TransferType && ca.m_Enable2StepGpuTransfer == cb.m_Enable2StepGpuTransfer &&
+                           ca.m_DelayEndAllAccess == cb.m_DelayEndAllAccess && ca.m_ShadowMapSize == cb.m_ShadowMapSize &&
+                           ca.m_SingleFacePerFrame == cb.m_SingleFacePerFrame) ? 1 : 0;
+        }
+    }
+    Check(duplicates == 0, "configurations are unique", (float)duplicates);
+
+    const BenchmarkSweepConfig second = sweep.GetConfig(1);
+    const BenchmarkSweepConfig last = sweep.GetConfig(47);
+    Check(second.m_SingleFacePerFrame == true && second.m_ShadowMapSize == 1024 && second.m_TransferType == AFR_SIM_TRANSFER_1STEP_P2P &&
+          last.m_TransferType == AFR_SIM_TRANSFER_2STEP_WITH_BROADCAST && last.m_ShadowMapSize == 2048 && last.m_Enable2StepGpuTransfer == true,
+          "configuration order", (float)last.m_ShadowMapSize);
+
+    AfrSimSampleSettings settings;
+    ApplyBenchmarkSweepConfig(last, settings);
+    Check(settings.m_ResourceTransferType == AFR_SIM_TRANSFER_2STEP_WITH_BROADCAST && settings.m_EnableCrossfireApiTransfers == true &&
+          settings.m_ShadowMapSize == 2048 && settings.m_SingleFacePerFrame == true, "configuration to replay settings", 0.0f);
+
+    BenchmarkSweep bad;
+    bool failed = bad.Parse("texture = atlas\ntransfer = 1step, 3step\n") == false;
+    Check(failed == true && bad.GetErrorLine() == 2, "unknown value rejected", (float)bad.GetErrorLine());
+    failed = bad.Parse("size = 1024,\n") == false;
+    Check(failed == true && bad.GetErrorLine() == 1, "empty value rejected", (float)bad.GetErrorLine());
+    failed = bad.Parse("\nfilter = pcf\n") == false;
+    Check(failed == true && bad.GetErrorLine() == 2, "unknown axis rejected", (float)bad.GetErrorLine());
+    failed = bad.Parse("size\n") == false;
+    Check(failed == true && bad.GetErrorLine() == 1, "axis without values rejected", (float)bad.GetErrorLine());
+
+    // ranking: random means in random order, one slow configuration far from the others
+    std::vector<double> means(sweep.GetConfigCount());
+    for (unsigned int config = 0; config < sweep.GetConfigCount(); config++)
+    {
+        means[config] = config == 7 ? 100.0 : 10.0 + (double)Random(1000) / 1000.0;
+        BenchmarkStats stats;
+        memset(&stats, 0, sizeof(stats));
+        stats.m_Count = 100;
+        stats.m_Mean = means[config];
+        stats.m_StdDev = 1.0;
+        if (config != 5) // a configuration that didn't run isn't ranked
+        {
+            sweep.SetResult(config, stats);
+        }
+    }
+
+    const std::vector<unsigned int> ranking = sweep.GetRanking();
+    unsigned int unordered = 0;
+    for (unsigned int rank = 1; rank < (unsigned int)ranking.size(); rank++)
+    {
+        unordered += means[ranking[rank - 1]] > means[ranking[rank]] ? 1 : 0;
+    }
+    Check(ranking.size() == 47 && unordered == 0 && ranking.back() == 7, "ranked by increasing mean", (float)ranking.size());
+    Check(sweep.IsSlowerThanBest(7) == true && sweep.IsSlowerThanBest(ranking[0]) == false && sweep.IsSlowerThanBest(ranking[1]) == false,
+          "confidence intervals against the best", 0.0f);
+}
+
+static bool ParseTransfer(const char * name, int & transfer)
+{
+    for (int i = AFR_SIM_TRANSFER_DEFAULT; i <= AFR_SIM_TRANSFER_2STEP_WITH_BROADCAST; i++)
+    {
+        if (strcmp(name, GetAfrSimTransferName(i)) == 0) { transfer = i; return true; }
+    }
+    return false;
+}
+
+// one benchmark of the null frame loop; Init creates the resources again, as InitTransferredResources does
+static void Run(const NullFrameLoopDesc & desc, const BenchmarkPath & path, unsigned int warmup, unsigned int frames, BenchmarkResults & results)
+{
+    NullFrameLoop loop;
+    loop.Init(desc, path);
+
+    results.Reset();
+    loop.GetSettings(results);
+
+    for (unsigned int frame = 0; frame < warmup + frames; frame++)
+    {
+        loop.RunFrame(frame < warmup ? NULL : &results);
+    }
+
+    loop.Release();
+}
+
+static void PrintResults(const BenchmarkResults & results)
+{
+    for (unsigned int setting = 0; setting < results.GetSettingCount(); setting++)
+    {
+        printf("%-20s %s\n", results.GetSettingName(setting), results.GetSettingValue(setting));
+    }
+    printf("%u frames\n\n", results.GetFrameCount());
+
+    printf("%-28s %-6s %10s %10s %10s %10s %10s %10s\n", "metric", "unit", "mean", "ci95", "p50", "p95", "p99", "max");
+    for (unsigned int metric = 0; metric < results.GetMetricCount(); metric++)
+    {
+        const BenchmarkStats stats = results.GetStats(metric);
+        printf("%-28s %-6s %10.4f %10.4f %10.4f %10.4f %10.4f %10.4f\n",
+            results.GetMetricName(metric), results.GetMetricUnit(metric),
+            stats.m_Mean, GetBenchmarkConfidence95(stats), stats.m_P50, stats.m_P95, stats.m_P99, stats.m_Max);
+    }
+}
+
+int main(int argc, char * argv[])
+{
+    NullFrameLoopDesc desc;
+    const char *      pathFile = NULL;
+    const char *      output = NULL;
+    const char *      sweepFile = NULL;
+    unsigned int      warmup = 60;
+    unsigned int      frames = 600;
+    bool              check = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char * arg = argv[i];
+        if (strcmp(arg, "--check") == 0) { check = true; continue; }
+
+        if (i + 1 >= argc) { fprintf(stderr, "missing value for %s\n", arg); return 1; }
+        const char * value = argv[++i];
+
+        if      (strcmp(arg, "--path") == 0)                 { pathFile = value; }
+        else if (strcmp(arg, "--output") == 0)               { output = value; }
+        else if (strcmp(arg, "--sweep") == 0)                { sweepFile = value; }
+        else if (strcmp(arg, "--warmup") == 0)               { warmup = (unsigned int)atoi(value); }
+        else if (strcmp(arg, "--frames") == 0)               { frames = (unsigned int)atoi(value); }
+        else if (strcmp(arg, "--gpus") == 0)                 { desc.m_Simulator.m_GpuCount = (unsigned int)atoi(value); }
+        else if (strcmp(arg, "--2step") == 0)                { desc.m_Sample.m_Enable2StepGpuTransfer = atoi(value) != 0; }
+        else if (strcmp(arg, "--delay-end-all-access") == 0) { desc.m_Sample.m_DelayEndAllAccess = atoi(value) != 0; }
+        else if (strcmp(arg, "--single-face") == 0)          { desc.m_Sample.m_SingleFacePerFrame = atoi(value) != 0; }
+        else if (strcmp(arg, "--size") == 0)                 { desc.m_Sample.m_ShadowMapSize = (unsigned int)atoi(value); }
+        else if (strcmp(arg, "--casters") == 0)              { desc.m_CasterCount = (unsigned int)atoi(value); }
+        else if (strcmp(arg, "--threads") == 0)              { desc.m_ThreadCount = (unsigned int)atoi(value); }
+        else if (strcmp(arg, "--seed") == 0)                 { g_RandomState = (unsigned int)atoi(value); desc.m_Seed = g_RandomState; }
+        else if (strcmp(arg, "--texture") == 0)
+        {
+            if      (strcmp(value, "atlas") == 0) { desc.m_Sample.m_ShadowTextureType = 0; }
+            else if (strcmp(value, "array") == 0) { desc.m_Sample.m_ShadowTextureType = 1; }
+            else { fprintf(stderr, "unknown texture type %s\n", value); return 1; }
+        }
+        else if (strcmp(arg, "--transfer") == 0)
+        {
+            if (ParseTransfer(value, desc.m_Sample.m_ResourceTransferType) == false) { fprintf(stderr, "unknown transfer type %s\n", value); return 1; }
+        }
+        else
+        {
+            fprintf(stderr, "unknown option %s\n", arg);
+            return 1;
+        }
+    }
+
+    if (g_RandomState == 0)
+    {
+        fprintf(stderr, "--seed must be positive\n");
+        return 1;
+    }
+
+    if (check == true)
+    {
+        CheckPath();
+        CheckStats();
+        CheckResults();
+        CheckSweep();
+
+        printf("%s\n", g_Failures == 0 ? "PASS" : "FAIL");
+        return g_Failures == 0 ? 0 : 1;
+    }
+
+    desc.m_Simulator.m_GpuCount = desc.m_Simulator.m_GpuCount == 0 ? 1 : desc.m_Simulator.m_GpuCount;
+    frames = frames == 0 ? 1 : frames;
+
+    BenchmarkPath path;
+    const bool    loaded = pathFile != NULL ? path.Load(pathFile) : path.Parse(DEFAULT_PATH);
+    if (loaded == false)
+    {
+        fprintf(stderr, "can't read the path %s (line %u)\n", pathFile != NULL ? pathFile : "(default)", path.GetErrorLine());
+        return 1;
+    }
+
+    BenchmarkResults results;
+
+    if (sweepFile != NULL)
+    {
+        BenchmarkSweep sweep;
+        if (sweep.Load(sweepFile) == false)
+        {
+            fprintf(stderr, "can't read the sweep %s (line %u)\n", sweepFile, sweep.GetErrorLine());
+            return 1;
+        }
+
+        for (unsigned int config = 0; config < sweep.GetConfigCount(); config++)
+        {
+            NullFrameLoopDesc configDesc = desc;
+            ApplyBenchmarkSweepConfig(sweep.GetConfig(config), configDesc.m_Sample);
+
+            Run(configDesc, path, warmup, frames, results);
+
+            const unsigned int metric = results.FindMetric(sweep.GetMetric());
+            if (metric == BENCHMARK_INVALID_INDEX)
+            {
+                fprintf(stderr, "no metric %s\n", sweep.GetMetric());
+                return 1;
+            }
+            sweep.SetResult(config, results.GetStats(metric));
+        }
+
+        sweep.WriteRanking(stdout);
+
+        if (output != NULL && sweep.SaveRanking(output) == false)
+        {
+            fprintf(stderr, "can't write %s\n", output);
+            return 1;
+        }
+
+        return 0;
+    }
+
+    Run(desc, path, warmup, frames, results);
+
+    PrintResults(results);
+
+
+    if (output != NULL && results.Save(output) == false)
+    {
+        fprintf(stderr, "can't write %s\n", output);
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,590 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//--------------------------------------------------------------------------------------
+// File: CameraBatchMain.cpp
+//
+// CPU checks of the batched camera matrices: random viewer cameras, the six faces of
+// cube cameras and orthographic cascade cameras, each compared against double precision
+// matrices and against the path SetCameraConstantBufferData used before, a view from
+// XMMatrixLookAtLH and three general inverses; then the cost per camera of both paths,
+// and the products of the viewer with the light volumes of the shadow map masking pass.
+// Exits nonzero if a check fails.
+//
+// Build (any C++11 compiler, no Windows/D3D11/AGS dependency):
+//     g++ -std=c++11 -O2 -I../../src CameraBatchMain.cpp ../../src/CameraBatch.cpp -o CameraBatch
+//     cl /EHsc /O2 /I..\..\src CameraBatchMain.cpp ..\..\src\CameraBatch.cpp
+//
+// Usage:
+//     CameraBatch [--cameras N] [--seed N]
+//--------------------------------------------------------------------------------------
+#include "CameraBatch.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+
+using namespace AMD;
+
+// xorshift32, so every platform checks the same sequence
+static unsigned int g_RandomState = 1;
+
+static unsigned int Random(unsigned int count)
+{
+    g_RandomState ^= g_RandomState << 13;
+    g_RandomState ^= g_RandomState >> 17;
+    g_RandomState ^= g_RandomState << 5;
+    return g_RandomState % count;
+}
+
+static float RandomFloat(float minimum, float maximum)
+{
+    return minimum + (maximum - minimum) * (float)Random(1 << 20) / (float)(1 << 20);
+}
+
+static int g_Failures = 0;
+
+static void Check(bool condition, const char * name, float value)
+{
+    printf("%-48s %10.4g %s\n", name, value, condition ? "ok" : "FAIL");
+    g_Failures += condition ? 0 : 1;
+}
+
+// the camera part of S_CAMERA_DATA followed by the rest of the structure, to check the stride
+struct CameraData
+{
+    CameraBatchMatrices m_Matrices;
+    float               m_Rest[12];
+};
+
+//--------------------------------------------------------------------------------------
+// Cameras, built the way DirectXMath builds them
+//--------------------------------------------------------------------------------------
+static void Normalize(float v[3])
+{
+    const float length = sqrtf(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+    v[0] /= length; v[1] /= length; v[2] /= length;
+}
+
+static void Cross(const float a[3], const float b[3], float r[3])
+{
+    r[0] = a[1] * b[2] - a[2] * b[1];
+    r[1] = a[2] * b[0] - a[0] * b[2];
+    r[2] = a[0] * b[1] - a[1] * b[0];
+}
+
+// XMMatrixLookAtLH
+static void LookAt(const float eye[3], const float at[3], const float up[3], CameraBatchInput & input)
+{
+    float ahead[3] = { at[0] - eye[0], at[1] - eye[1], at[2] - eye[2] };
+    Normalize(ahead);
+    float right[3];
+    Cross(up, ahead, right);
+    Normalize(right);
+
+    memcpy(input.m_Eye, eye, sizeof(input.m_Eye));
+    memcpy(input.m_Right, right, sizeof(input.m_Right));
+    Cross(ahead, right, input.m_Up);
+    memcpy(input.m_Ahead, ahead, sizeof(input.m_Ahead));
+}
+
+// XMMatrixPerspectiveFovLH
+static void Perspective(float fov, float aspect, float zNear, float zFar, float * p)
+{
+    memset(p, 0, 16 * sizeof(float));
+    const float height = 1.0f / tanf(0.5f * fov);
+    const float range = zFar / (zFar - zNear);
+    p[0] = height / aspect;
+    p[5] = height;
+    p[10] = range;
+    p[11] = 1.0f;
+    p[14] = -range * zNear;
+}
+
+// XMMatrixOrthographicOffCenterLH
+static void Orthographic(float l, float r, float b, float t, float zNear, float zFar, float * p)
+{
+    memset(p, 0, 16 * sizeof(float));
+    p[0] = 2.0f / (r - l);
+    p[5] = 2.0f / (t - b);
+    p[10] = 1.0f / (zFar - zNear);
+    p[12] = (l + r) / (l - r);
+    p[13] = (t + b) / (b - t);
+    p[14] = -zNear / (zFar - zNear);
+    p[15] = 1.0f;
+}
+
+static void RandomViewer(CameraBatchInput & input)
+{
+    const float eye[3] = { RandomFloat(-50, 50), RandomFloat(1, 20), RandomFloat(-50, 50) };
+    const float at[3] = { RandomFloat(-50, 50), RandomFloat(-5, 5), RandomFloat(-50, 50) };
+    const float up[3] = { 0, 1, 0 };
+    LookAt(eye, at, up, input);
+    Perspective(RandomFloat(0.5f, 1.5f), RandomFloat(1.0f, 2.4f), RandomFloat(0.05f, 1.0f), RandomFloat(100, 2000), input.m_Projection);
+}
+
+static void RandomCube(CameraBatchInput * pInputs)
+{
+    const float eye[3] = { RandomFloat(-50, 50), RandomFloat(1, 20), RandomFloat(-50, 50) };
+    const float zNear = RandomFloat(0.05f, 1.0f);
+    const float zFar = RandomFloat(100, 500);
+
+    for (unsigned int face = 0; face < CAMERA_CUBE_FACE_COUNT; face++)
+    {
+        memcpy(pInputs[face].m_Eye, eye, sizeof(eye));
+        GetCubeFaceBasis(face, pInputs[face].m_Right, pInputs[face].m_Up, pInputs[face].m_Ahead);
+        Perspective(3.14159265f / 2.0f, 1.0f, zNear, zFar, pInputs[face].m_Projection);
+    }
+}
+
+static void RandomCascade(CameraBatchInput & input)
+{
+    const float eye[3] = { RandomFloat(-50, 50), RandomFloat(50, 100), RandomFloat(-50, 50) };
+    const float at[3] = { eye[0] + RandomFloat(-20, 20), 0, eye[2] + RandomFloat(-20, 20) };
+    const float up[3] = { 0, 1, 0 };
+    LookAt(eye, at, up, input);
+    const float x = RandomFloat(-30, 30), y = RandomFloat(-30, 30), size = RandomFloat(5, 60);
+    Orthographic(x, x + size, y, y + size, RandomFloat(0, 10), RandomFloat(100, 300), input.m_Projection);
+}
+
+// a projection with every entry set, which the batch hands to the general inverse
+static void RandomGeneral(CameraBatchInput & input)
+{
+    RandomViewer(input);
+    for (unsigned int i = 0; i < 16; i++)
+    {
+        input.m_Projection[i] += RandomFloat(-0.5f, 0.5f);
+    }
+}
+
+//--------------------------------------------------------------------------------------
+// The path SetCameraConstantBufferData used before: the view, then three general inverses
+//--------------------------------------------------------------------------------------
+template <typename T>
+static void Multiply(const T * a, const T * b, T * r)
+{
+    for (int row = 0; row < 4; row++)
+    {
+        for (int column = 0; column < 4; column++)
+        {
+            r[row * 4 + column] = a[row * 4 + 0] * b[0 * 4 + column] + a[row * 4 + 1] * b[1 * 4 + column] +
+                                  a[row * 4 + 2] * b[2 * 4 + column] + a[row * 4 + 3] * b[3 * 4 + column];
+        }
+    }
+}
+
+// Gauss-Jordan with partial pivoting
+template <typename T>
+static void Invert(const T * m, T * inv)
+{
+    T a[4][8];
+    for (int row = 0; row < 4; row++)
+    {
+        for (int column = 0; column < 4; column++)
+        {
+            a[row][column] = m[row * 4 + column];
+            a[row][column + 4] = row == column ? (T)1 : (T)0;
+        }
+    }
+
+    for (int column = 0; column < 4; column++)
+    {
+        int pivot = column;
+        for (int row = column + 1; row < 4; row++)
+        {
+            pivot = fabs((double)a[row][column]) > fabs((double)a[pivot][column]) ? row : pivot;
+        }
+        for (int i = 0; i < 8; i++)
+        {
+            const T t = a[column][i]; a[column][i] = a[pivot][i]; a[pivot][i] = t;
+        }
+
+        const T scale = (T)1 / a[column][column];
+        for (int i = 0; i < 8; i++)
+        {
+            a[column][i] *= scale;
+        }
+
+        for (int row = 0; row < 4; row++)
+        {
+            if (row == column) { continue; }
+            const T factor = a[row][column];
+            for (int i = 0; i < 8; i++)
+            {
+                a[row][i] -= factor * a[column][i];
+            }
+        }
+    }
+
+    for (int row = 0; row < 4; row++)
+    {
+        for (int column = 0; column < 4; column++)
+        {
+            inv[row * 4 + column] = a[row][column + 4];
+        }
+    }
+}
+
+template <typename T>
+static void BuildView(const CameraBatchInput & input, T * view)
+{
+    const float * e = input.m_Eye;
+    const float * r = input.m_Right;
+    const float * u = input.m_Up;
+    const float * f = input.m_Ahead;
+
+    for (int i = 0; i < 3; i++)
+    {
+        view[i * 4 + 0] = r[i];
+        view[i * 4 + 1] = u[i];
+        view[i * 4 + 2] = f[i];
+        view[i * 4 + 3] = 0;
+    }
+    view[12] = -((T)r[0] * e[0] + (T)r[1] * e[1] + (T)r[2] * e[2]);
+    view[13] = -((T)u[0] * e[0] + (T)u[1] * e[1] + (T)u[2] * e[2]);
+    view[14] = -((T)f[0] * e[0] + (T)f[1] * e[1] + (T)f[2] * e[2]);
+    view[15] = 1;
+}
+
+template <typename T>
+static void ComputeGeneral(const CameraBatchInput & input, T * pMatrices)
+{
+    T * view = pMatrices + 0;
+    T * proj = pMatrices + 16;
+    T * viewInv = pMatrices + 32;
+    T * projInv = pMatrices + 48;
+    T * viewProj = pMatrices + 64;
+    T * viewProjInv = pMatrices + 80;
+
+    BuildView(input, view);
+    for (int i = 0; i < 16; i++)
+    {
+        proj[i] = input.m_Projection[i];
+    }
+    Multiply(view, proj, viewProj);
+    Invert(view, viewInv);
+    Invert(proj, projInv);
+    Invert(viewProj, viewProjInv);
+
+    // transposed for HLSL, as CameraBatchMatrices
+    for (int matrix = 0; matrix < 6; matrix++)
+    {
+        T * m = pMatrices + matrix * 16;
+        for (int row = 0; row < 4; row++)
+        {
+            for (int column = row + 1; column < 4; column++)
+            {
+                const T t = m[row * 4 + column]; m[row * 4 + column] = m[column * 4 + row]; m[column * 4 + row] = t;
+            }
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------
+// Errors against double precision, relative to the largest entry of each matrix
+//--------------------------------------------------------------------------------------
+struct Errors
+{
+    double m_Matrix;        // largest error of any matrix
+    double m_Identity;      // largest error of M * M^-1 for the view, projection and view projection
+};
+
+static void Measure(const CameraBatchMatrices & matrices, const double * pTruth, Errors & errors)
+{
+    const float * pOutput = (const float *)&matrices;
+
+    for (int matrix = 0; matrix < 6; matrix++)
+    {
+        double largest = 0.0, error = 0.0;
+        for (int i = 0; i < 16; i++)
+        {
+            largest = fmax(largest, fabs(pTruth[matrix * 16 + i]));
+            error = fmax(error, fabs((double)pOutput[matrix * 16 + i] - pTruth[matrix * 16 + i]));
+        }
+        errors.m_Matrix = fmax(errors.m_Matrix, error / largest);
+    }
+
+    // M at 0, 16, 64 and its inverse at 32, 48, 80; transposes multiply the same way
+    const int pairs[3][2] = { { 0, 32 }, { 16, 48 }, { 64, 80 } };
+    for (int pair = 0; pair < 3; pair++)
+    {
+        double m[16], inv[16], product[16];
+        for (int i = 0; i < 16; i++)
+        {
+            m[i] = pOutput[pairs[pair][0] + i];
+            inv[i] = pOutput[pairs[pair][1] + i];
+        }
+        Multiply(m, inv, product);
+        for (int i = 0; i < 16; i++)
+        {
+            errors.m_Identity = fmax(errors.m_Identity, fabs(product[i] - (i % 5 == 0 ? 1.0 : 0.0)));
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------
+// One kind of camera through the batch, the reference and the old path; with the closed
+// form inverses, the batch has to be at least as close to double precision as the old
+// path. Other projections only have to get the same general inverse in both paths.
+//--------------------------------------------------------------------------------------
+static void RunPrecision(const char * kind, const std::vector<CameraBatchInput> & inputs, bool closedForm)
+{
+    const unsigned int count = (unsigned int)inputs.size();
+
+    std::vector<CameraData> batch(count), reference(count);
+    memset(&batch[0], 0xCD, count * sizeof(CameraData));
+    ComputeCameraMatrices(&inputs[0], count, &batch[0], sizeof(CameraData));
+    ComputeCameraMatricesReference(&inputs[0], count, &reference[0], sizeof(CameraData));
+
+    Errors batchErrors = {}, referenceErrors = {}, generalErrors = {}, differences = {};
+    unsigned int overwrites = 0;
+
+    for (unsigned int i = 0; i < count; i++)
+    {
+        double truth[96];
+        ComputeGeneral(inputs[i], truth);
+
+        CameraBatchMatrices general;
+        ComputeGeneral(inputs[i], (float *)&general);
+
+        Measure(batch[i].m_Matrices, truth, batchErrors);
+        Measure(reference[i].m_Matrices, truth, referenceErrors);
+        Measure(general, truth, generalErrors);
+
+        const float * pReference = (const float *)&reference[i].m_Matrices;
+        double        referenceMatrices[96];
+        for (unsigned int j = 0; j < 96; j++)
+        {
+            referenceMatrices[j] = pReference[j];
+        }
+        Measure(batch[i].m_Matrices, referenceMatrices, differences);
+
+        const unsigned char * pRest = (const unsigned char *)batch[i].m_Rest;
+        for (unsigned int byte = 0; byte < sizeof(batch[i].m_Rest); byte++)
+        {
+            overwrites += pRest[byte] != 0xCD ? 1 : 0;
+        }
+    }
+
+    char name[64];
+    snprintf(name, sizeof(name), "%s: batch error", kind);
+    Check(closedForm == false || batchErrors.m_Matrix < 1e-5, name, (float)batchErrors.m_Matrix);
+    snprintf(name, sizeof(name), "%s: reference error", kind);
+    Check(closedForm == false || referenceErrors.m_Matrix < 1e-5, name, (float)referenceErrors.m_Matrix);
+    snprintf(name, sizeof(name), "%s: batch against reference", kind);
+    Check(differences.m_Matrix < 1e-5, name, (float)differences.m_Matrix);
+    snprintf(name, sizeof(name), "%s: old path error", kind);
+    Check(closedForm == false || batchErrors.m_Matrix <= generalErrors.m_Matrix, name, (float)generalErrors.m_Matrix);
+    snprintf(name, sizeof(name), "%s: batch M * M^-1 error", kind);
+    Check(closedForm == false || batchErrors.m_Identity <= generalErrors.m_Identity, name, (float)batchErrors.m_Identity);
+    snprintf(name, sizeof(name), "%s: old path M * M^-1 error", kind);
+    Check(true, name, (float)generalErrors.m_Identity);
+    snprintf(name, sizeof(name), "%s: bytes written past the matrices", kind);
+    Check(overwrites == 0, name, (float)overwrites);
+}
+
+//--------------------------------------------------------------------------------------
+// The cube face basis against XMMatrixLookAtLH and the up vectors of InitializeCubeCamera
+//--------------------------------------------------------------------------------------
+static void RunCubeFaces()
+{
+    static const float s_Ahead[CAMERA_CUBE_FACE_COUNT][3] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+    static const float s_Up[CAMERA_CUBE_FACE_COUNT][3]    = { { 0, 1, 0 }, { 0, 1, 0 }, { 0, 0, -1 }, { 0, 0, 1 }, { 0, 1, 0 }, { 0, 1, 0 } };
+
+    float error = 0.0f;
+    for (unsigned int face = 0; face < CAMERA_CUBE_FACE_COUNT; face++)
+    {
+        const float eye[3] = { 3, 4, 5 };
+        const float at[3] = { eye[0] + s_Ahead[face][0], eye[1] + s_Ahead[face][1], eye[2] + s_Ahead[face][2] };
+
+        CameraBatchInput lookAt, cube;
+        LookAt(eye, at, s_Up[face], lookAt);
+        GetCubeFaceBasis(face, cube.m_Right, cube.m_Up, cube.m_Ahead);
+
+        for (int i = 0; i < 3; i++)
+        {
+            error = fmaxf(error, fabsf(lookAt.m_Right[i] - cube.m_Right[i]));
+            error = fmaxf(error, fabsf(lookAt.m_Up[i] - cube.m_Up[i]));
+            error = fmaxf(error, fabsf(lookAt.m_Ahead[i] - cube.m_Ahead[i]));
+        }
+    }
+    Check(error == 0.0f, "cube faces: basis against XMMatrixLookAtLH", error);
+}
+
+//--------------------------------------------------------------------------------------
+// The cost per camera of the batch, the reference and the old path
+//--------------------------------------------------------------------------------------
+static void RunTiming(const std::vector<CameraBatchInput> & inputs)
+{
+    const unsigned int count = (unsigned int)inputs.size();
+    const unsigned int repeats = 200;
+    std::vector<CameraData> output(count);
+    float sum = 0.0f;
+
+    std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+    for (unsigned int repeat = 0; repeat < repeats; repeat++)
+    {
+        ComputeCameraMatrices(&inputs[0], count, &output[0], sizeof(CameraData));
+        sum += output[repeat % count].m_Matrices.m_ViewProjectionInv[0];
+    }
+    const double batchNs = std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - start).count() / (double)(count * repeats);
+
+    start = std::chrono::high_resolution_clock::now();
+    for (unsigned int repeat = 0; repeat < repeats; repeat++)
+    {
+        ComputeCameraMatricesReference(&inputs[0], count, &output[0], sizeof(CameraData));
+        sum += output[repeat % count].m_Matrices.m_ViewProjectionInv[0];
+    }
+    const double referenceNs = std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - start).count() / (double)(count * repeats);
+
+    start = std::chrono::high_resolution_clock::now();
+    for (unsigned int repeat = 0; repeat < repeats; repeat++)
+    {
+        for (unsigned int i = 0; i < count; i++)
+        {
+            ComputeGeneral(inputs[i], (float *)&output[i].m_Matrices);
+        }
+        sum += output[repeat % count].m_Matrices.m_ViewProjectionInv[0];
+    }
+    const double generalNs = std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - start).count() / (double)(count * repeats);
+
+    Check(sum == sum, "timing: old path ns per camera", (float)generalNs);
+    Check(referenceNs < generalNs, "timing: reference ns per camera", (float)referenceNs);
+    Check(batchNs < generalNs, "timing: batch ns per camera", (float)batchNs);
+}
+
+//--------------------------------------------------------------------------------------
+// The viewer view projection times the view projection inverse of every light, as the
+// light volumes of the shadow map masking pass, against the scalar products
+//--------------------------------------------------------------------------------------
+static void RunMultiply(const std::vector<CameraBatchInput> & viewers, const std::vector<CameraBatchInput> & lights)
+{
+    const unsigned int count = (unsigned int)lights.size();
+
+    CameraBatchMatrices viewer;
+    ComputeCameraMatrices(&viewers[0], 1, &viewer, sizeof(viewer));
+
+    std::vector<CameraData> lightMatrices(count);
+    ComputeCameraMatrices(&lights[0], count, &lightMatrices[0], sizeof(CameraData));
+
+    // the light volume of CrossfireAPI11: the transform, then a color the product must not touch
+    std::vector<CameraData> batch(count), reference(count);
+    memset(&batch[0], 0xCD, count * sizeof(CameraData));
+    MultiplyCameraMatrices(viewer.m_ViewProjection, lightMatrices[0].m_Matrices.m_ViewProjectionInv, sizeof(CameraData), count, &batch[0], sizeof(CameraData));
+    MultiplyCameraMatricesReference(viewer.m_ViewProjection, lightMatrices[0].m_Matrices.m_ViewProjectionInv, sizeof(CameraData), count, &reference[0], sizeof(CameraData));
+
+    double       error = 0.0;
+    unsigned int overwrites = 0;
+    for (unsigned int i = 0; i < count; i++)
+    {
+        const float * pBatch = (const float *)&batch[i];
+        const float * pReference = (const float *)&reference[i];
+        double        largest = 0.0, difference = 0.0;
+        for (unsigned int j = 0; j < 16; j++)
+        {
+            largest = fmax(largest, fabs((double)pReference[j]));
+            difference = fmax(difference, fabs((double)pBatch[j] - (double)pReference[j]));
+        }
+        error = fmax(error, difference / largest);
+
+        const unsigned char * pRest = (const unsigned char *)(pBatch + 16);
+        for (unsigned int byte = 0; byte < sizeof(CameraData) - 16 * sizeof(float); byte++)
+        {
+            overwrites += pRest[byte] != 0xCD ? 1 : 0;
+        }
+    }
+    Check(error < 1e-5, "light volumes: batch against reference", (float)error);
+    Check(overwrites == 0, "light volumes: bytes written past the transforms", (float)overwrites);
+
+    const unsigned int repeats = 200;
+    float              sum = 0.0f;
+
+    std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+    for (unsigned int repeat = 0; repeat < repeats; repeat++)
+    {
+        MultiplyCameraMatrices(viewer.m_ViewProjection, lightMatrices[0].m_Matrices.m_ViewProjectionInv, sizeof(CameraData), count, &batch[0], sizeof(CameraData));
+        sum += batch[repeat % count].m_Matrices.m_View[0];
+    }
+    const double batchNs = std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - start).count() / (double)(count * repeats);
+
+    start = std::chrono::high_resolution_clock::now();
+    for (unsigned int repeat = 0; repeat < repeats; repeat++)
+    {
+        MultiplyCameraMatricesReference(viewer.m_ViewProjection, lightMatrices[0].m_Matrices.m_ViewProjectionInv, sizeof(CameraData), count, &reference[0], sizeof(CameraData));
+        sum += reference[repeat % count].m_Matrices.m_View[0];
+    }
+    const double referenceNs = std::chrono::duration<double, std::nano>(std::chrono::high_resolution_clock::now() - start).count() / (double)(count * repeats);
+
+    Check(sum == sum, "light volumes: reference ns per light", (float)referenceNs);
+    Check(batchNs <= referenceNs, "light volumes: batch ns per light", (float)batchNs);
+}
+
+int main(int argc, char * argv[])
+{
+    unsigned int cameras = 6000;
+
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if      (strcmp(argv[i], "--cameras") == 0) { cameras = (unsigned int)atoi(argv[i + 1]); }
+        else if (strcmp(argv[i], "--seed") == 0)    { g_RandomState = (unsigned int)atoi(argv[i + 1]); }
+        else
+        {
+            printf("usage: CameraBatch [--cameras N] [--seed N]\n");
+            return 1;
+        }
+    }
+
+    if (g_RandomState == 0)
+    {
+        fprintf(stderr, "--seed must be positive\n");
+        return 1;
+    }
+
+    // whole cubes, plus a few cameras so the last batch of 4 is partial
+    cameras = (cameras / CAMERA_CUBE_FACE_COUNT + 1) * CAMERA_CUBE_FACE_COUNT;
+
+    std::vector<CameraBatchInput> viewers(cameras + 1), cubes(cameras), cascades(cameras + 3), general(cameras / 8 + 2), mixed;
+    for (unsigned int i = 0; i < viewers.size(); i++)                       { RandomViewer(viewers[i]); }
+    for (unsigned int i = 0; i < cubes.size(); i += CAMERA_CUBE_FACE_COUNT) { RandomCube(&cubes[i]); }
+    for (unsigned int i = 0; i < cascades.size(); i++)                      { RandomCascade(cascades[i]); }
+    for (unsigned int i = 0; i < general.size(); i++)                       { RandomGeneral(general[i]); }
+    for (unsigned int i = 0; i < general.size(); i++)
+    {
+        mixed.push_back(viewers[i]);
+        mixed.push_back(general[i]);
+        mixed.push_back(cascades[i]);
+    }
+
+    RunCubeFaces();
+    RunPrecision("viewers", viewers, true);
+    RunPrecision("cube faces", cubes, true);
+    RunPrecision("cascades", cascades, true);
+    RunPrecision("general", general, false);
+    RunPrecision("mixed", mixed, false);
+    RunTiming(cubes);
+    RunMultiply(viewers, cubes);
+
+    printf("%s\n", g_Failures == 0 ? "PASS" : "FAIL");
+    return g_Failures == 0 ? 0 : 1;
+}
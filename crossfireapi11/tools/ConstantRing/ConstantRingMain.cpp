@@ -0,0 +1,243 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//--------------------------------------------------------------------------------------
+// File: ConstantRingMain.cpp
+//
+// CPU checks of the constant ring: random passes of per-draw constants over many frames
+// on 1 to 4 AFR GPUs, checking that no part of the ring is written twice between two
+// WRITE_DISCARD maps, that every frame only allocates from the regions of its GPU, and
+// that the offsets are ones the D3D11.1 offset binding accepts; then the maps saved over
+// one map per draw, and the cost of an allocation. Exits nonzero if a check fails.
+//
+// Build (any C++11 compiler, no Windows/D3D11/AGS dependency):
+//     g++ -std=c++11 -O2 -I../../src ConstantRingMain.cpp ../../src/ConstantRing.cpp -o ConstantRing
+//     cl /EHsc /O2 /I..\..\src ConstantRingMain.cpp ..\..\src\ConstantRing.cpp
+//
+// Usage:
+//     ConstantRing [--frames N] [--seed N]
+//--------------------------------------------------------------------------------------
+#include "ConstantRing.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+
+using namespace AMD;
+
+// xorshift32, so every platform checks the same sequence
+static unsigned int g_RandomState = 1;
+
+static unsigned int Random(unsigned int count)
+{
+    g_RandomState ^= g_RandomState << 13;
+    g_RandomState ^= g_RandomState >> 17;
+    g_RandomState ^= g_RandomState << 5;
+    return g_RandomState % count;
+}
+
+static int g_Failures = 0;
+
+static void Check(bool condition, const char * name, float value)
+{
+    printf("%-48s %10.4f %s\n", name, value, condition ? "ok" : "FAIL");
+    g_Failures += condition ? 0 : 1;
+}
+
+// the per-draw constants of CrossfireAPI11: S_MODEL_DATA, S_UNIT_CUBE_TRANSFORM, S_SHADOW_FACE_DATA
+static const unsigned int g_ConstantSizes[] = { 240, 208, 544 };
+
+//--------------------------------------------------------------------------------------
+// Frames of random passes, each pass allocating the constants of its draws in one block
+// and mapping the ring once, the way RenderScene does
+//--------------------------------------------------------------------------------------
+static void RunFrames(unsigned int gpuCount, unsigned int frames)
+{
+    ConstantRing ring;
+    ring.Init(32 * 1024, gpuCount);    // a busy frame doesn't fit
+
+    // per 256 byte block of the ring, the discard generation that last wrote it; 0 is never
+    std::vector<unsigned int> blockGeneration(ring.GetSize() / CONSTANT_RING_ALIGNMENT, 0);
+    unsigned int generation = 0;
+
+    unsigned int overwrites = 0;
+    unsigned int misplaced = 0;
+    unsigned int misaligned = 0;
+    unsigned int discards = 0;
+    unsigned int fallbacks = 0;
+    unsigned int ringMaps = 0;
+    unsigned int drawMaps = 0;
+
+    for (unsigned int frame = 0; frame < frames; frame++)
+    {
+        ring.BeginFrame(frame);
+
+        const unsigned int passCount = 1 + Random(24);
+        for (unsigned int pass = 0; pass < passCount; pass++)
+        {
+            const unsigned int size = g_ConstantSizes[Random(3)];
+            const unsigned int draws = 1 + Random(8);
+            bool               discard = false;
+
+            const unsigned int offset = ring.Allocate(size, draws, discard);
+
+            drawMaps += draws;
+            if (offset == CONSTANT_RING_INVALID_OFFSET)
+            {
+                fallbacks++;
+                ringMaps += draws;      // the pass maps its own buffer per draw
+                continue;
+            }
+            ringMaps++;
+
+            if (discard == true)
+            {
+                generation++;
+                discards++;
+            }
+            else if (generation == 0)
+            {
+                overwrites++;           // D3D11 wants a dynamic buffer's first map to discard
+            }
+
+            const unsigned int stride = ConstantRing::GetStride(size);
+            const unsigned int end = offset + stride * draws;
+
+            misaligned += (offset % CONSTANT_RING_ALIGNMENT != 0 || stride % CONSTANT_RING_ALIGNMENT != 0) ? 1 : 0;
+            misplaced += (end > ring.GetSize() ||
+                          offset / ring.GetRegionSize() != ring.GetRegion() ||
+                          (end - 1) / ring.GetRegionSize() != ring.GetRegion() ||
+                          ring.GetRegionGpu(ring.GetRegion()) != frame % gpuCount) ? 1 : 0;
+
+            for (unsigned int block = offset / CONSTANT_RING_ALIGNMENT; block < end / CONSTANT_RING_ALIGNMENT && block < blockGeneration.size(); block++)
+            {
+                overwrites += blockGeneration[block] == generation ? 1 : 0;
+                blockGeneration[block] = generation;
+            }
+        }
+    }
+
+    char name[64];
+    snprintf(name, sizeof(name), "%u GPU: blocks written twice between discards", gpuCount);
+    Check(overwrites == 0, name, (float)overwrites);
+    snprintf(name, sizeof(name), "%u GPU: allocations outside the frame's region", gpuCount);
+    Check(misplaced == 0, name, (float)misplaced);
+    snprintf(name, sizeof(name), "%u GPU: misaligned allocations", gpuCount);
+    Check(misaligned == 0, name, (float)misaligned);
+    snprintf(name, sizeof(name), "%u GPU: discards per trip around the ring", gpuCount);
+    Check(discards > 0 && discards <= frames / ring.GetRegionCount() + 1, name, (float)discards * (float)ring.GetRegionCount() / (float)frames);
+    snprintf(name, sizeof(name), "%u GPU: passes falling back", gpuCount);
+    Check(fallbacks > 0, name, (float)fallbacks);
+    snprintf(name, sizeof(name), "%u GPU: maps, ring / one per draw", gpuCount);
+    Check(ringMaps < drawMaps / 2, name, (float)ringMaps / (float)drawMaps);
+}
+
+//--------------------------------------------------------------------------------------
+// A frame without allocations, a region filled exactly, and the same frame begun twice
+//--------------------------------------------------------------------------------------
+static void RunEdges()
+{
+    ConstantRing ring;
+    ring.Init(1000, 2, 1);
+    bool discard = false;
+
+    Check(ring.GetRegionSize() == 1024 && ring.GetSize() == 2048, "edges: sizes rounded up", (float)ring.GetSize());
+
+    ring.BeginFrame(0);
+    ring.BeginFrame(1);
+    unsigned int offset = ring.Allocate(256, 4, discard);
+    Check(offset == 1024 && discard == true, "edges: first allocation discards", (float)offset);
+    offset = ring.Allocate(1, 1, discard);
+    Check(offset == CONSTANT_RING_INVALID_OFFSET && ring.GetFailures() == 1, "edges: full region fails", (float)ring.GetFailures());
+
+    ring.BeginFrame(2);
+    offset = ring.Allocate(16, 1, discard);
+    Check(offset == 0 && discard == true, "edges: wrap discards", (float)offset);
+
+    ring.BeginFrame(2);
+    offset = ring.Allocate(16, 1, discard);
+    Check(offset == 0 && discard == true && ring.GetUsed() == 256, "edges: frame begun twice discards", (float)ring.GetUsed());
+
+    offset = ring.Allocate(0, 1, discard);
+    Check(offset == CONSTANT_RING_INVALID_OFFSET && discard == false, "edges: empty allocation fails", (float)ring.GetFailures());
+}
+
+//--------------------------------------------------------------------------------------
+// The cost of an allocation
+//--------------------------------------------------------------------------------------
+static void RunTiming()
+{
+    ConstantRing ring;
+    ring.Init(1024 * 1024, 2);
+
+    const unsigned int frames = 4096;
+    const unsigned int allocations = 256;
+    unsigned int       sum = 0;
+    bool               discard = false;
+
+    const std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+    for (unsigned int frame = 0; frame < frames; frame++)
+    {
+        ring.BeginFrame(frame);
+        for (unsigned int i = 0; i < allocations; i++)
+        {
+            sum += ring.Allocate(g_ConstantSizes[i % 3], 1 + (i & 3), discard);
+        }
+    }
+    const std::chrono::high_resolution_clock::time_point end = std::chrono::high_resolution_clock::now();
+
+    const double ns = std::chrono::duration<double, std::nano>(end - start).count() / (double)(frames * allocations);
+    Check(ns < 100.0 && sum != 0, "timing: nanoseconds per allocation", (float)ns);
+}
+
+int main(int argc, char * argv[])
+{
+    unsigned int frames = 10000;
+
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if      (strcmp(argv[i], "--frames") == 0) { frames = (unsigned int)atoi(argv[i + 1]); }
+        else if (strcmp(argv[i], "--seed") == 0)   { g_RandomState = (unsigned int)atoi(argv[i + 1]); }
+        else
+        {
+            printf("usage: ConstantRing [--frames N] [--seed N]\n");
+            return 1;
+        }
+    }
+
+    if (g_RandomState == 0)
+    {
+        fprintf(stderr, "--seed must be positive\n");
+        return 1;
+    }
+
+    for (unsigned int gpuCount = 1; gpuCount <= 4; gpuCount++)
+    {
+        RunFrames(gpuCount, frames);
+    }
+    RunEdges();
+    RunTiming();
+
+    printf("%s\n", g_Failures == 0 ? "PASS" : "FAIL");
+    return g_Failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,526 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//--------------------------------------------------------------------------------------
+// File: DirtyRegionsMain.cpp
+//
+// CPU checks of AMD::MergeDirtyRects and AMD::DirtyRegions: overlapping, adjacent and
+// distant rects, the maxWaste bound, random rect lists against a texel bitmap, writes
+// that collapse to a whole subresource, the layouts of the resolved region lists, then
+// random AFR frames on 2, 3 and 4 GPUs where the pending and broadcast regions of every
+// GPU are compared against a model of what each GPU is missing. Exits nonzero if a check
+// fails.
+//
+// Build (any C++11 compiler, no Windows/D3D11/AGS dependency):
+//     g++ -std=c++11 -O2 -I../../../amd_lib/inc -I../../../amd_lib/src DirtyRegionsMain.cpp ../../../amd_lib/src/AMD_DirtyRegions.cpp -o DirtyRegions
+//     cl /EHsc /O2 /I..\..\..\amd_lib\inc /I..\..\..\amd_lib\src DirtyRegionsMain.cpp ..\..\..\amd_lib\src\AMD_DirtyRegions.cpp
+//
+// Usage:
+//     DirtyRegions [--lists N] [--frames N] [--seed N]
+//--------------------------------------------------------------------------------------
+#include "AMD_DirtyRegions.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+using namespace AMD;
+
+// xorshift32, so every platform checks the same sequence
+static unsigned int g_RandomState = 1;
+
+static unsigned int Random(unsigned int count)
+{
+    g_RandomState ^= g_RandomState << 13;
+    g_RandomState ^= g_RandomState >> 17;
+    g_RandomState ^= g_RandomState << 5;
+    return g_RandomState % count;
+}
+
+static int g_Failures = 0;
+
+static void Check(bool condition, const char * name, float value)
+{
+    printf("%-48s %10.4g %s\n", name, value, condition ? "ok" : "FAIL");
+    g_Failures += condition ? 0 : 1;
+}
+
+static DirtyRect Rect(int left, int top, int right, int bottom)
+{
+    const DirtyRect rect = { left, top, right, bottom };
+    return rect;
+}
+
+static unsigned long long Area(const DirtyRect & rect)
+{
+    return (unsigned long long)(rect.right - rect.left) * (unsigned long long)(rect.bottom - rect.top);
+}
+
+static DirtyRect RandomRect(int width, int height)
+{
+    const int left = (int)Random((unsigned int)width);
+    const int top = (int)Random((unsigned int)height);
+    return Rect(left, top, left + 1 + (int)Random((unsigned int)(width - left)), top + 1 + (int)Random((unsigned int)(height - top)));
+}
+
+//--------------------------------------------------------------------------------------
+// Texels of a resource, one byte per texel and subresource
+//--------------------------------------------------------------------------------------
+struct Bitmap
+{
+    int                        m_Width;
+    int                        m_Height;
+    unsigned int               m_Array;
+    std::vector<unsigned char> m_Texels;
+
+    void Init(int width, int height, unsigned int arraySize)
+    {
+        m_Width = width;
+        m_Height = height;
+        m_Array = arraySize;
+        m_Texels.assign((size_t)width * height * arraySize, 0);
+    }
+
+    void Fill(const DirtyRect & rect, unsigned int subresource, unsigned char value)
+    {
+        for (int y = rect.top; y < rect.bottom; y++)
+        {
+            for (int x = rect.left; x < rect.right; x++)
+            {
+                m_Texels[((size_t)subresource * m_Height + y) * m_Width + x] = value;
+            }
+        }
+    }
+
+    // the texels set in this bitmap and not in covering, then the texels set in covering
+    void Compare(const Bitmap & covering, unsigned long long & missed, unsigned long long & covered) const
+    {
+        missed = covered = 0;
+        for (size_t i = 0; i < m_Texels.size(); i++)
+        {
+            missed += m_Texels[i] != 0 && covering.m_Texels[i] == 0 ? 1 : 0;
+            covered += covering.m_Texels[i] != 0 ? 1 : 0;
+        }
+    }
+};
+
+// the texels of a resolved list, read with the layouts agsDriverExtensions_NotifyResourceEndWrites knows
+static void Rasterize(const DirtyRegionList & list, Bitmap & bitmap)
+{
+    const DirtyRect whole = Rect(0, 0, bitmap.m_Width, bitmap.m_Height);
+
+    bitmap.Init(bitmap.m_Width, bitmap.m_Height, bitmap.m_Array);
+    if (list.IsEmpty() == true)
+    {
+        return;
+    }
+
+    if (list.GetCount() == 0) // all subresources, the whole area or a single rect
+    {
+        for (unsigned int subresource = 0; subresource < bitmap.m_Array; subresource++)
+        {
+            bitmap.Fill(list.GetRects() == NULL ? whole : list.GetRects()[0], subresource, 1);
+        }
+        return;
+    }
+
+    for (unsigned int i = 0; i < list.GetCount(); i++)
+    {
+        const unsigned int subresource = list.GetSubresources() == NULL ? 0 : list.GetSubresources()[i];
+        bitmap.Fill(list.GetRects() == NULL ? whole : list.GetRects()[i], subresource, 1);
+    }
+}
+
+//--------------------------------------------------------------------------------------
+// MergeDirtyRects
+//--------------------------------------------------------------------------------------
+static void RunMerge(unsigned int lists)
+{
+    std::vector<DirtyRect> rects;
+
+    rects.clear();
+    rects.push_back(Rect(0, 0, 10, 10));
+    rects.push_back(Rect(5, 0, 15, 10));
+    MergeDirtyRects(rects, 0.0f);
+    Check(rects.size() == 1 && Area(rects[0]) == 150, "merge: overlapping rects", (float)rects.size());
+
+    rects.clear();
+    rects.push_back(Rect(0, 0, 10, 10));
+    rects.push_back(Rect(10, 0, 20, 10));
+    rects.push_back(Rect(0, 10, 20, 30));
+    MergeDirtyRects(rects, 0.0f);
+    Check(rects.size() == 1 && rects[0].right == 20 && rects[0].bottom == 30, "merge: adjacent rects", (float)rects.size());
+
+    rects.clear();
+    rects.push_back(Rect(0, 0, 10, 10));
+    rects.push_back(Rect(50, 50, 60, 60));
+    MergeDirtyRects(rects, 0.25f);
+    Check(rects.size() == 2, "merge: distant rects stay apart", (float)rects.size());
+
+    rects.clear();
+    rects.push_back(Rect(0, 0, 10, 10));
+    rects.push_back(Rect(10, 10, 20, 20));
+    MergeDirtyRects(rects, 0.25f);
+    Check(rects.size() == 2, "merge: rects touching at a corner stay apart", (float)rects.size());
+
+    rects.clear();
+    rects.push_back(Rect(0, 0, 10, 10));
+    rects.push_back(Rect(4, 4, 4, 9));
+    rects.push_back(Rect(7, 3, 2, 8));
+    MergeDirtyRects(rects, 0.0f);
+    Check(rects.size() == 1 && Area(rects[0]) == 100, "merge: empty rects are dropped", (float)rects.size());
+
+    // 10x10 and 5x8 side by side: 140 texels, 150 in their bounding rect, 7.1% wasted
+    rects.clear();
+    rects.push_back(Rect(0, 0, 10, 10));
+    rects.push_back(Rect(10, 0, 15, 8));
+    MergeDirtyRects(rects, 0.05f);
+    Check(rects.size() == 2, "merge: waste above maxWaste stays apart", (float)rects.size());
+
+    rects.clear();
+    rects.push_back(Rect(0, 0, 10, 10));
+    rects.push_back(Rect(10, 0, 15, 8));
+    MergeDirtyRects(rects, 0.08f);
+    Check(rects.size() == 1 && Area(rects[0]) == 150, "merge: waste below maxWaste merges", (float)rects.size());
+
+    // random lists: every texel stays covered, no pair that can merge is left, and with
+    // maxWaste 0 nothing outside the rects is covered
+    const int          size = 64;
+    unsigned long long missed = 0, leftPairs = 0, wasted = 0;
+    unsigned int       inputCount = 0, outputCount = 0;
+    for (unsigned int list = 0; list < lists; list++)
+    {
+        const float maxWaste = list % 2 == 0 ? 0.0f : 0.25f;
+
+        rects.clear();
+        const unsigned int count = 1 + Random(12);
+        for (unsigned int i = 0; i < count; i++)
+        {
+            rects.push_back(RandomRect(size, size));
+        }
+
+        Bitmap written, merged;
+        written.Init(size, size, 1);
+        merged.Init(size, size, 1);
+        for (unsigned int i = 0; i < rects.size(); i++)
+        {
+            written.Fill(rects[i], 0, 1);
+        }
+
+        MergeDirtyRects(rects, maxWaste);
+        for (unsigned int i = 0; i < rects.size(); i++)
+        {
+            merged.Fill(rects[i], 0, 1);
+        }
+
+        unsigned long long lost, extra, mergedTexels, writtenTexels;
+        written.Compare(merged, lost, mergedTexels);
+        merged.Compare(written, extra, writtenTexels);
+        missed += lost;
+        wasted += maxWaste == 0.0f ? extra : 0;
+
+        for (unsigned int i = 0; i < rects.size(); i++)
+        {
+            for (unsigned int j = i + 1; j < rects.size(); j++)
+            {
+                std::vector<DirtyRect> pair(1, rects[i]);
+                pair.push_back(rects[j]);
+                MergeDirtyRects(pair, maxWaste);
+                leftPairs += pair.size() == 1 ? 1 : 0;
+            }
+        }
+
+        inputCount += count;
+        outputCount += (unsigned int)rects.size();
+    }
+    Check(missed == 0, "merge: random lists, texels lost", (float)missed);
+    Check(wasted == 0, "merge: random lists, texels added at maxWaste 0", (float)wasted);
+    Check(leftPairs == 0, "merge: random lists, mergeable pairs left", (float)leftPairs);
+    Check(outputCount <= inputCount, "merge: random lists, rects out per rect in", (float)outputCount / (float)inputCount);
+}
+
+//--------------------------------------------------------------------------------------
+// Collapse to whole subresources, and the layouts of the resolved lists
+//--------------------------------------------------------------------------------------
+static void RunResolve()
+{
+    DirtyRegions    dirty;
+    DirtyRegionList list;
+
+    // the four quarters of a slice become the whole slice
+    dirty.Init(64, 32, 1);
+    dirty.SetMaxWaste(0.0f);
+    dirty.AddRect(Rect(0, 0, 32, 16), 0);
+    dirty.AddRect(Rect(32, 16, 64, 32), 0);
+    dirty.AddRect(Rect(32, 0, 64, 16), 0);
+    dirty.AddRect(Rect(0, 16, 32, 32), 0);
+    dirty.GetFrameRegions(list);
+    Check(list.IsEmpty() == false && list.GetCount() == 0 && list.GetRects() == NULL && list.GetTexelCount() == 64 * 32,
+          "resolve: quarters collapse to the whole slice", (float)list.GetCount());
+
+    // a rect past the edges is clipped to the whole slice, and replaces the rects before it
+    dirty.Init(64, 32, 6);
+    dirty.AddRect(Rect(1, 1, 5, 5), 2);
+    dirty.AddRect(Rect(40, 20, 50, 30), 2);
+    dirty.AddRect(Rect(-10, -10, 100, 100), 2);
+    dirty.GetFrameRegions(list);
+    Check(list.GetCount() == 1 && list.GetRects() == NULL && list.GetSubresources() != NULL && list.GetSubresources()[0] == 2 &&
+          list.GetTexelCount() == 64 * 32, "resolve: clipped rect collapses to a subresource", (float)list.GetCount());
+
+    dirty.Init(64, 32, 6);
+    dirty.GetFrameRegions(list);
+    Check(list.IsEmpty() == true && list.GetCount() == 0 && list.GetTexelCount() == 0, "resolve: nothing written", (float)list.GetCount());
+
+    dirty.AddRect(Rect(10, 10, 10, 20), 0);
+    dirty.AddRect(Rect(0, 0, 8, 8), 6);
+    dirty.GetFrameRegions(list);
+    Check(list.IsEmpty() == true, "resolve: empty rect and bad subresource ignored", (float)list.GetTexelCount());
+
+    // NULL, NULL, 0: the whole resource
+    dirty.AddAll();
+    dirty.GetFrameRegions(list);
+    Check(list.IsEmpty() == false && list.GetCount() == 0 && list.GetRects() == NULL && list.GetSubresources() == NULL &&
+          list.GetTexelCount() == 6 * 64 * 32, "resolve: layout of the whole resource", (float)list.GetCount());
+
+    // rect, NULL, 0: the same rect in every subresource
+    dirty.Init(64, 32, 6);
+    for (unsigned int subresource = 0; subresource < 6; subresource++)
+    {
+        dirty.AddRect(Rect(8, 4, 24, 12), subresource);
+    }
+    dirty.GetFrameRegions(list);
+    Check(list.GetCount() == 0 && list.GetRects() != NULL && list.GetSubresources() == NULL && list.GetRects()[0].left == 8 &&
+          list.GetTexelCount() == 6 * 16 * 8, "resolve: layout of one rect in every subresource", (float)list.GetCount());
+
+    // NULL, subresources, count: whole subresources only
+    dirty.Init(64, 32, 6);
+    dirty.AddSubresource(1);
+    dirty.AddSubresource(4);
+    dirty.GetFrameRegions(list);
+    Check(list.GetCount() == 2 && list.GetRects() == NULL && list.GetSubresources() != NULL &&
+          list.GetSubresources()[0] == 1 && list.GetSubresources()[1] == 4, "resolve: layout of whole subresources", (float)list.GetCount());
+
+    // rects, subresources, count
+    dirty.Init(64, 32, 6);
+    dirty.SetMaxWaste(0.0f);
+    dirty.AddRect(Rect(0, 0, 8, 8), 0);
+    dirty.AddRect(Rect(30, 20, 40, 30), 0);
+    dirty.AddSubresource(3);
+    dirty.GetFrameRegions(list);
+    Check(list.GetCount() == 3 && list.GetRects() != NULL && list.GetSubresources() != NULL && list.GetSubresources()[2] == 3 &&
+          list.GetRects()[2].right == 64 && list.GetTexelCount() == 64 + 100 + 64 * 32, "resolve: layout of rects per subresource", (float)list.GetCount());
+
+    // rects, NULL, count: a single subresource
+    dirty.Init(64, 32, 1);
+    dirty.SetMaxWaste(0.0f);
+    dirty.AddRect(Rect(0, 0, 8, 8), 0);
+    dirty.AddRect(Rect(30, 20, 40, 30), 0);
+    dirty.GetFrameRegions(list);
+    Check(list.GetCount() == 2 && list.GetRects() != NULL && list.GetSubresources() == NULL, "resolve: layout of rects in one subresource", (float)list.GetCount());
+
+    // the layouts read back as the texels that were written
+    unsigned long long missed = 0, extra = 0;
+    for (unsigned int round = 0; round < 200; round++)
+    {
+        const unsigned int arraySize = 1 + Random(6);
+        Bitmap             written, resolved;
+        written.Init(32, 16, arraySize);
+        resolved.Init(32, 16, arraySize);
+
+        dirty.Init(32, 16, arraySize);
+        dirty.SetMaxWaste(0.0f);
+        const unsigned int count = Random(8);
+        for (unsigned int i = 0; i < count; i++)
+        {
+            const unsigned int subresource = Random(arraySize);
+            const DirtyRect    rect = Random(4) == 0 ? Rect(0, 0, 32, 16) : RandomRect(32, 16);
+            dirty.AddRect(rect, subresource);
+            written.Fill(rect, subresource, 1);
+        }
+        dirty.GetFrameRegions(list);
+        Rasterize(list, resolved);
+
+        unsigned long long lost, added, resolvedTexels, writtenTexels;
+        written.Compare(resolved, lost, resolvedTexels);
+        resolved.Compare(written, added, writtenTexels);
+        missed += lost;
+        extra += added;
+    }
+    Check(missed == 0 && extra == 0, "resolve: random lists read back as written", (float)(missed + extra));
+}
+
+//--------------------------------------------------------------------------------------
+// AFR: every frame the next GPU writes random regions, then sends what the GPU after it
+// is missing, or what all the others are missing for a broadcast
+//--------------------------------------------------------------------------------------
+static void RunAfr(unsigned int gpuCount, unsigned int frames, bool broadcast)
+{
+    const int          width = 48, height = 32;
+    const unsigned int arraySize = 6;
+
+    DirtyRegions dirty;
+    dirty.Init(width, height, arraySize);
+    dirty.SetMaxWaste(0.25f);
+
+    // what each GPU is missing
+    std::vector<Bitmap> missing(gpuCount);
+    for (unsigned int gpu = 0; gpu < gpuCount; gpu++)
+    {
+        missing[gpu].Init(width, height, arraySize);
+    }
+
+    unsigned long long missed = 0, sent = 0;
+    DirtyRegionList    list;
+    Bitmap             regions;
+    regions.Init(width, height, arraySize);
+
+    for (unsigned int frame = 0; frame < frames; frame++)
+    {
+        const unsigned int gpu = frame % gpuCount;
+        const unsigned int nextGpu = (gpu + 1) % gpuCount;
+
+        const unsigned int count = Random(4);
+        for (unsigned int i = 0; i < count; i++)
+        {
+            const unsigned int subresource = Random(arraySize);
+            const DirtyRect    rect = Random(8) == 0 ? Rect(0, 0, width, height) : RandomRect(width, height);
+            dirty.AddRect(rect, subresource);
+            for (unsigned int other = 0; other < gpuCount; other++)
+            {
+                if (other != gpu) { missing[other].Fill(rect, subresource, 1); }
+            }
+        }
+        dirty.EndFrame(gpu, gpuCount);
+
+        // what a receiver misses is in the regions sent to it
+        if (broadcast == true)
+        {
+            dirty.GetBroadcastRegions(gpu, list);
+        }
+        else
+        {
+            dirty.GetPendingRegions(nextGpu, list);
+        }
+        Rasterize(list, regions);
+
+        for (unsigned int receiver = 0; receiver < gpuCount; receiver++)
+        {
+            if (receiver == gpu || (broadcast == false && receiver != nextGpu))
+            {
+                continue;
+            }
+
+            unsigned long long receiverMissed, covered;
+            missing[receiver].Compare(regions, receiverMissed, covered);
+            missed += receiverMissed;
+
+            dirty.MarkReceived(receiver);
+            missing[receiver].Init(width, height, arraySize);
+        }
+        sent += list.GetTexelCount();
+
+        // and every GPU still has what it misses in its pending regions
+        for (unsigned int receiver = 0; receiver < gpuCount; receiver++)
+        {
+            DirtyRegionList pending;
+            dirty.GetPendingRegions(receiver, pending);
+            Rasterize(pending, regions);
+
+            unsigned long long receiverMissed, covered;
+            missing[receiver].Compare(regions, receiverMissed, covered);
+            missed += receiverMissed;
+        }
+    }
+
+    char name[64];
+    sprintf(name, "afr: %u GPUs%s, texels missed", gpuCount, broadcast ? " broadcast" : "");
+    Check(missed == 0, name, (float)missed);
+    sprintf(name, "afr: %u GPUs%s, texels sent per frame", gpuCount, broadcast ? " broadcast" : "");
+    Check(sent < (unsigned long long)frames * width * height * arraySize, name, (float)sent / (float)frames);
+}
+
+// 3 GPUs: the GPU after next also gets what the next GPU wrote before it received anything
+static void RunAfrThreeGpus()
+{
+    DirtyRegions    dirty;
+    DirtyRegionList list;
+    dirty.Init(64, 64, 1);
+    dirty.SetMaxWaste(0.0f);
+
+    dirty.AddRect(Rect(0, 0, 8, 8), 0);             // GPU 0 writes A, sends it to GPU 1
+    dirty.EndFrame(0, 3);
+    dirty.GetPendingRegions(1, list);
+    Check(list.GetCount() == 1 && list.GetTexelCount() == 64, "afr: 3 GPUs, GPU 1 gets A", (float)list.GetTexelCount());
+    dirty.MarkReceived(1);
+
+    dirty.AddRect(Rect(32, 32, 40, 40), 0);         // GPU 1 writes B, sends it to GPU 2
+    dirty.EndFrame(1, 3);
+    dirty.GetPendingRegions(2, list);
+    Check(list.GetCount() == 2 && list.GetTexelCount() == 128, "afr: 3 GPUs, GPU 2 gets A and B", (float)list.GetTexelCount());
+    dirty.MarkReceived(2);
+
+    dirty.GetPendingRegions(0, list);
+    Check(list.GetCount() == 1 && list.GetTexelCount() == 64 && list.GetRects()[0].left == 32, "afr: 3 GPUs, GPU 0 misses only B",
+          (float)list.GetTexelCount());
+
+    dirty.GetPendingRegions(1, list);
+    Check(list.IsEmpty() == true, "afr: 3 GPUs, GPU 1 misses nothing", (float)list.GetTexelCount());
+
+    dirty.GetPendingRegions(3, list);
+    Check(list.IsEmpty() == true, "afr: 3 GPUs, GPU out of range", (float)list.GetTexelCount());
+}
+
+int main(int argc, char * argv[])
+{
+    unsigned int lists = 2000;
+    unsigned int frames = 600;
+
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if      (strcmp(argv[i], "--lists") == 0)  { lists = (unsigned int)atoi(argv[i + 1]); }
+        else if (strcmp(argv[i], "--frames") == 0) { frames = (unsigned int)atoi(argv[i + 1]); }
+        else if (strcmp(argv[i], "--seed") == 0)   { g_RandomState = (unsigned int)atoi(argv[i + 1]); }
+        else
+        {
+            printf("usage: DirtyRegions [--lists N] [--frames N] [--seed N]\n");
+            return 1;
+        }
+    }
+
+    if (lists == 0 || frames == 0 || g_RandomState == 0)
+    {
+        fprintf(stderr, "--lists, --frames and --seed must be positive\n");
+        return 1;
+    }
+
+    RunMerge(lists);
+    RunResolve();
+    RunAfrThreeGpus();
+    for (unsigned int gpuCount = 2; gpuCount <= 4; gpuCount++)
+    {
+        RunAfr(gpuCount, frames, false);
+        RunAfr(gpuCount, frames, true);
+    }
+
+    printf("%s\n", g_Failures == 0 ? "PASS" : "FAIL");
+    return g_Failures == 0 ? 0 : 1;
+}
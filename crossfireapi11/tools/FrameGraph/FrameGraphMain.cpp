@@ -0,0 +1,414 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//--------------------------------------------------------------------------------------
+// File: FrameGraphMain.cpp
+//
+// CPU checks of AMD::FrameGraph: the compiled steps of the 1-step and 2-step frames of
+// CrossfireAPI11 against the expected order, the culling of passes whose writes are
+// never read, the delayed EndAllAccess, the notifications issued by BeginPass, EndPass
+// and EndFrame, then random frames checked against the placement rules. Exits nonzero
+// if a check fails.
+//
+// Build (any C++11 compiler, no Windows/D3D11/AGS dependency):
+//     g++ -std=c++11 -O2 -I../../src FrameGraphMain.cpp ../../src/FrameGraph.cpp -o FrameGraph
+//     cl /EHsc /O2 /I..\..\src FrameGraphMain.cpp ..\..\src\FrameGraph.cpp
+//
+// Usage:
+//     FrameGraph [--frames N] [--seed N]
+//--------------------------------------------------------------------------------------
+#include "FrameGraph.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+using namespace AMD;
+
+// xorshift32, so every platform checks the same sequence
+static unsigned int g_RandomState = 1;
+
+static unsigned int Random(unsigned int count)
+{
+    g_RandomState ^= g_RandomState << 13;
+    g_RandomState ^= g_RandomState >> 17;
+    g_RandomState ^= g_RandomState << 5;
+    return g_RandomState % count;
+}
+
+static int g_Failures = 0;
+
+static void Check(bool condition, const char * name, float value)
+{
+    printf("%-48s %10.4g %s\n", name, value, condition ? "ok" : "FAIL");
+    g_Failures += condition ? 0 : 1;
+}
+
+// the steps as text: a pass by its name, a notification as Begin/EndWrites/End(resource)
+static std::string GetStepString(const FrameGraph & graph, FRAME_GRAPH_STEP_TYPE type, unsigned int index)
+{
+    switch (type)
+    {
+    case FRAME_GRAPH_STEP_PASS:             return graph.GetPassName(index);
+    case FRAME_GRAPH_STEP_BEGIN_ALL_ACCESS: return std::string("Begin(") + graph.GetResourceName(index) + ")";
+    case FRAME_GRAPH_STEP_END_WRITES:       return std::string("EndWrites(") + graph.GetResourceName(index) + ")";
+    case FRAME_GRAPH_STEP_END_ALL_ACCESS:   return std::string("End(") + graph.GetResourceName(index) + ")";
+    default:                                return "?";
+    }
+}
+
+static std::string GetSteps(const FrameGraph & graph)
+{
+    std::string steps;
+    for (size_t i = 0; i < graph.GetSteps().size(); i++)
+    {
+        steps += (i > 0 ? " " : "") + GetStepString(graph, graph.GetSteps()[i].m_Type, graph.GetSteps()[i].m_Index);
+    }
+    return steps;
+}
+
+static void CheckSteps(const FrameGraph & graph, const char * name, const char * expected)
+{
+    const std::string steps = GetSteps(graph);
+    Check(steps == expected, name, (float)graph.GetSteps().size());
+    if (steps != expected)
+    {
+        printf("    expected %s\n    got      %s\n", expected, steps.c_str());
+    }
+}
+
+//--------------------------------------------------------------------------------------
+// The frames of CrossfireAPI11
+//--------------------------------------------------------------------------------------
+
+// 1-step: the shadow map is transferred itself; the debug view writes a texture nobody reads
+static void BuildOneStepFrame(FrameGraph & graph)
+{
+    graph.Reset();
+    const unsigned int shadowMap = graph.AddResource("ShadowMap", FRAME_GRAPH_RESOURCE_TRANSFERRED, NULL);
+    const unsigned int depth = graph.AddResource("Depth", 0, NULL);
+    const unsigned int mask = graph.AddResource("ShadowMask", 0, NULL);
+    const unsigned int debug = graph.AddResource("Debug", 0, NULL);
+    const unsigned int backBuffer = graph.AddResource("BackBuffer", FRAME_GRAPH_RESOURCE_PERSISTENT, NULL);
+
+    const unsigned int shadow = graph.AddPass("Shadow");
+    graph.Write(shadow, shadowMap);
+    const unsigned int prepass = graph.AddPass("Prepass");
+    graph.Write(prepass, depth);
+    const unsigned int debugView = graph.AddPass("DebugView");
+    graph.Read(debugView, depth);
+    graph.Read(debugView, shadowMap);
+    graph.Write(debugView, debug);
+    const unsigned int masking = graph.AddPass("Masking");
+    graph.Read(masking, shadowMap);
+    graph.Read(masking, depth);
+    graph.Write(masking, mask);
+    const unsigned int scene = graph.AddPass("Scene");
+    graph.Read(scene, mask);
+    graph.Write(scene, backBuffer);
+    const unsigned int hud = graph.AddPass("Hud");
+    graph.Write(hud, backBuffer);
+}
+
+// 2-step: the shadow map is copied from the transfer shadow map received from the previous
+// GPU, re-rendered, and copied into the transfer shadow map sent to the next GPU
+static void BuildTwoStepFrame(FrameGraph & graph)
+{
+    graph.Reset();
+    const unsigned int shadowMap = graph.AddResource("ShadowMap", FRAME_GRAPH_RESOURCE_PERSISTENT, NULL);
+    const unsigned int transfer = graph.AddResource("Transfer", FRAME_GRAPH_RESOURCE_TRANSFERRED, NULL);
+    const unsigned int backBuffer = graph.AddResource("BackBuffer", FRAME_GRAPH_RESOURCE_PERSISTENT, NULL);
+
+    const unsigned int receive = graph.AddPass("Receive");
+    graph.Read(receive, transfer);
+    graph.Write(receive, shadowMap);
+    const unsigned int shadow = graph.AddPass("Shadow");
+    graph.Write(shadow, shadowMap);
+    const unsigned int send = graph.AddPass("Send");
+    graph.Read(send, shadowMap);
+    graph.Write(send, transfer);
+    const unsigned int scene = graph.AddPass("Scene");
+    graph.Read(scene, shadowMap);
+    graph.Write(scene, backBuffer);
+}
+
+struct Notifications
+{
+    std::vector<std::string> m_Steps;
+    const FrameGraph *       m_pGraph;
+};
+
+static void OnNotify(FRAME_GRAPH_STEP_TYPE type, unsigned int resource, void * pResourceUserData, void * pUserData)
+{
+    Notifications * pNotifications = (Notifications *)pUserData;
+    (void)pResourceUserData;
+    pNotifications->m_Steps.push_back(GetStepString(*pNotifications->m_pGraph, type, resource));
+}
+
+// runs the frame as the application does and returns the passes run and the notifications issued
+static std::string RunFrame(FrameGraph & graph)
+{
+    Notifications notifications;
+    notifications.m_pGraph = &graph;
+    graph.SetNotifier(OnNotify, &notifications);
+
+    for (unsigned int pass = 0; pass < graph.GetPassCount(); pass++)
+    {
+        if (graph.BeginPass(pass) == true)
+        {
+            notifications.m_Steps.push_back(graph.GetPassName(pass));
+            graph.EndPass(pass);
+        }
+    }
+    graph.EndFrame();
+    graph.SetNotifier(NULL, NULL);
+
+    std::string steps;
+    for (size_t i = 0; i < notifications.m_Steps.size(); i++)
+    {
+        steps += (i > 0 ? " " : "") + notifications.m_Steps[i];
+    }
+    return steps;
+}
+
+static void RunKnownFrames()
+{
+    FrameGraph graph;
+
+    BuildOneStepFrame(graph);
+    Check(graph.Compile() == true, "known: 1-step compiles", 0.0f);
+    Check(graph.IsCulled(2) == true && graph.IsCulled(0) == false && graph.IsCulled(5) == false, "known: pass whose writes nobody reads is culled", 2.0f);
+    CheckSteps(graph, "known: 1-step steps",
+               "Begin(ShadowMap) Shadow EndWrites(ShadowMap) Prepass Masking End(ShadowMap) Scene Hud");
+    Check(RunFrame(graph) == GetSteps(graph), "known: 1-step notifications issued in order", 0.0f);
+    Check(graph.BeginPass(2) == false, "known: BeginPass of a culled pass", 0.0f);
+
+    graph.SetDelayEndAllAccess(true);
+    Check(graph.Compile() == true, "known: 1-step delayed compiles", 0.0f);
+    CheckSteps(graph, "known: 1-step steps, EndAllAccess delayed",
+               "Begin(ShadowMap) Shadow EndWrites(ShadowMap) Prepass Masking Scene Hud End(ShadowMap)");
+    Check(RunFrame(graph) == GetSteps(graph), "known: delayed EndAllAccess issued by EndFrame", 0.0f);
+    graph.SetDelayEndAllAccess(false);
+
+    BuildTwoStepFrame(graph);
+    Check(graph.Compile() == true, "known: 2-step compiles", 0.0f);
+    CheckSteps(graph, "known: 2-step steps",
+               "Begin(Transfer) Receive Shadow Send EndWrites(Transfer) End(Transfer) Scene");
+    Check(RunFrame(graph) == GetSteps(graph), "known: 2-step notifications issued in order", 0.0f);
+
+    // a chain that ends in a resource nobody reads is culled as a whole, and a transferred
+    // resource only accessed by culled passes gets no notification
+    graph.Reset();
+    const unsigned int shadowMap = graph.AddResource("ShadowMap", FRAME_GRAPH_RESOURCE_TRANSFERRED, NULL);
+    const unsigned int a = graph.AddResource("A", 0, NULL);
+    const unsigned int b = graph.AddResource("B", 0, NULL);
+    const unsigned int backBuffer = graph.AddResource("BackBuffer", FRAME_GRAPH_RESOURCE_PERSISTENT, NULL);
+    const unsigned int first = graph.AddPass("First");
+    graph.Write(first, a);
+    const unsigned int second = graph.AddPass("Second");
+    graph.Read(second, a);
+    graph.Read(second, shadowMap);
+    graph.Write(second, b);
+    const unsigned int scene = graph.AddPass("Scene");
+    graph.Write(scene, backBuffer);
+    Check(graph.Compile() == true, "culling: chain compiles", 0.0f);
+    CheckSteps(graph, "culling: chain of unread writes culled", "Scene");
+
+    // a pass declared against an unknown resource doesn't compile, and issues nothing
+    graph.Read(scene, 17);
+    Check(graph.Compile() == false && graph.BeginPass(scene) == false, "culling: unknown resource fails", 0.0f);
+}
+
+//--------------------------------------------------------------------------------------
+// Random frames against the rules
+//--------------------------------------------------------------------------------------
+static void RunRandomFrames(unsigned int frames)
+{
+    FrameGraph   graph;
+    unsigned int wrongCulling = 0, wrongBegin = 0, wrongEndWrites = 0, wrongEnd = 0, wrongDelayedEnd = 0, wrongNotifications = 0;
+
+    for (unsigned int frame = 0; frame < frames; frame++)
+    {
+        const unsigned int resourceCount = 1 + Random(6);
+        const unsigned int passCount = 1 + Random(8);
+        const bool         delay = Random(2) == 0;
+
+        static const char * s_ResourceNames[] = { "R0", "R1", "R2", "R3", "R4", "R5" };
+        static const char * s_PassNames[] = { "P0", "P1", "P2", "P3", "P4", "P5", "P6", "P7" };
+
+        graph.Reset();
+        graph.SetDelayEndAllAccess(delay);
+
+        std::vector<unsigned int> flags(resourceCount);
+        for (unsigned int r = 0; r < resourceCount; r++)
+        {
+            const unsigned int kind = Random(3);
+            flags[r] = kind == 0 ? FRAME_GRAPH_RESOURCE_TRANSFERRED : (kind == 1 ? FRAME_GRAPH_RESOURCE_PERSISTENT : 0);
+            graph.AddResource(s_ResourceNames[r], flags[r], NULL);
+        }
+
+        // reads[pass][resource], writes[pass][resource]
+        std::vector< std::vector<bool> > reads(passCount, std::vector<bool>(resourceCount)), writes(passCount, std::vector<bool>(resourceCount));
+        for (unsigned int p = 0; p < passCount; p++)
+        {
+            graph.AddPass(s_PassNames[p]);
+            for (unsigned int r = 0; r < resourceCount; r++)
+            {
+                const unsigned int access = Random(5);
+                if (access == 0) { graph.Read(p, r); reads[p][r] = true; }
+                if (access == 1) { graph.Write(p, r); writes[p][r] = true; }
+                if (access == 2) { graph.Read(p, r); graph.Write(p, r); reads[p][r] = writes[p][r] = true; }
+            }
+        }
+
+        if (graph.Compile() == false)
+        {
+            wrongCulling++;
+            continue;
+        }
+
+        // kept: writes something persistent, or something a later kept pass reads
+        std::vector<bool> kept(passCount);
+        for (unsigned int p = passCount; p > 0; p--)
+        {
+            bool keep = false;
+            for (unsigned int r = 0; r < resourceCount && keep == false; r++)
+            {
+                if (writes[p - 1][r] == false) { continue; }
+
+                keep = flags[r] != 0;
+                for (unsigned int later = p; later < passCount && keep == false; later++)
+                {
+                    keep = kept[later] && reads[later][r];
+                }
+            }
+            kept[p - 1] = keep;
+            wrongCulling += graph.IsCulled(p - 1) == keep ? 1 : 0;
+        }
+
+        // where every pass step is, and the notifications of every resource
+        const std::vector<FrameGraphStep> & steps = graph.GetSteps();
+        std::vector<unsigned int>           passStep(passCount, FRAME_GRAPH_INVALID_INDEX);
+        for (unsigned int i = 0; i < steps.size(); i++)
+        {
+            if (steps[i].m_Type == FRAME_GRAPH_STEP_PASS) { passStep[steps[i].m_Index] = i; }
+        }
+
+        for (unsigned int r = 0; r < resourceCount; r++)
+        {
+            unsigned int firstAccess = FRAME_GRAPH_INVALID_INDEX, lastAccess = FRAME_GRAPH_INVALID_INDEX, lastWrite = FRAME_GRAPH_INVALID_INDEX;
+            for (unsigned int p = 0; p < passCount; p++)
+            {
+                if (kept[p] == false || (reads[p][r] == false && writes[p][r] == false)) { continue; }
+
+                firstAccess = firstAccess == FRAME_GRAPH_INVALID_INDEX ? p : firstAccess;
+                lastAccess = p;
+                lastWrite = writes[p][r] ? p : lastWrite;
+            }
+
+            unsigned int beginCount = 0, endWritesCount = 0, endCount = 0;
+            unsigned int beginStep = 0, endWritesStep = 0, endStep = 0;
+            for (unsigned int i = 0; i < steps.size(); i++)
+            {
+                if (steps[i].m_Type == FRAME_GRAPH_STEP_PASS || steps[i].m_Index != r) { continue; }
+                if (steps[i].m_Type == FRAME_GRAPH_STEP_BEGIN_ALL_ACCESS) { beginCount++; beginStep = i; }
+                if (steps[i].m_Type == FRAME_GRAPH_STEP_END_WRITES)       { endWritesCount++; endWritesStep = i; }
+                if (steps[i].m_Type == FRAME_GRAPH_STEP_END_ALL_ACCESS)   { endCount++; endStep = i; }
+            }
+
+            const bool notified = flags[r] == FRAME_GRAPH_RESOURCE_TRANSFERRED && firstAccess != FRAME_GRAPH_INVALID_INDEX;
+            const bool written = notified && lastWrite != FRAME_GRAPH_INVALID_INDEX;
+
+            // BeginAllAccess before the first access, with no pass in between
+            bool begin = beginCount == (notified ? 1u : 0u);
+            for (unsigned int i = beginStep + 1; begin == true && notified == true && i < passStep[firstAccess]; i++)
+            {
+                begin = steps[i].m_Type != FRAME_GRAPH_STEP_PASS;
+            }
+            begin = begin && (notified == false || beginStep < passStep[firstAccess]);
+            wrongBegin += begin ? 0 : 1;
+
+            // EndWrites right after the last writer, with no pass in between
+            bool endWrites = endWritesCount == (written ? 1u : 0u);
+            for (unsigned int i = written ? passStep[lastWrite] + 1 : 0; endWrites == true && written == true && i < endWritesStep; i++)
+            {
+                endWrites = steps[i].m_Type != FRAME_GRAPH_STEP_PASS;
+            }
+            endWrites = endWrites && (written == false || endWritesStep > passStep[lastWrite]);
+            wrongEndWrites += endWrites ? 0 : 1;
+
+            // EndAllAccess after the last access, and after EndWrites; delayed: after every pass
+            bool end = endCount == (notified ? 1u : 0u);
+            if (end == true && notified == true)
+            {
+                end = endStep > passStep[lastAccess] && (written == false || endStep > endWritesStep);
+                for (unsigned int i = passStep[lastAccess] + 1; end == true && delay == false && i < endStep; i++)
+                {
+                    end = steps[i].m_Type != FRAME_GRAPH_STEP_PASS;
+                }
+                for (unsigned int i = endStep + 1; end == true && delay == true && i < steps.size(); i++)
+                {
+                    end = steps[i].m_Type != FRAME_GRAPH_STEP_PASS;
+                }
+            }
+            (delay ? wrongDelayedEnd : wrongEnd) += end ? 0 : 1;
+        }
+
+        wrongNotifications += RunFrame(graph) == GetSteps(graph) ? 0 : 1;
+    }
+
+    Check(wrongCulling == 0, "random: passes culled wrongly", (float)wrongCulling);
+    Check(wrongBegin == 0, "random: BeginAllAccess misplaced", (float)wrongBegin);
+    Check(wrongEndWrites == 0, "random: EndWrites misplaced", (float)wrongEndWrites);
+    Check(wrongEnd == 0, "random: EndAllAccess misplaced", (float)wrongEnd);
+    Check(wrongDelayedEnd == 0, "random: delayed EndAllAccess misplaced", (float)wrongDelayedEnd);
+    Check(wrongNotifications == 0, "random: notifications out of order", (float)wrongNotifications);
+}
+
+int main(int argc, char * argv[])
+{
+    unsigned int frames = 5000;
+
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if      (strcmp(argv[i], "--frames") == 0) { frames = (unsigned int)atoi(argv[i + 1]); }
+        else if (strcmp(argv[i], "--seed") == 0)   { g_RandomState = (unsigned int)atoi(argv[i + 1]); }
+        else
+        {
+            printf("usage: FrameGraph [--frames N] [--seed N]\n");
+            return 1;
+        }
+    }
+
+    if (frames == 0 || g_RandomState == 0)
+    {
+        fprintf(stderr, "--frames and --seed must be positive\n");
+        return 1;
+    }
+
+    RunKnownFrames();
+    RunRandomFrames(frames);
+
+    printf("%s\n", g_Failures == 0 ? "PASS" : "FAIL");
+    return g_Failures == 0 ? 0 : 1;
+}
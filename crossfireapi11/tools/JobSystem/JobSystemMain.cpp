@@ -0,0 +1,304 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//--------------------------------------------------------------------------------------
+// File: JobSystemMain.cpp
+//
+// CPU checks of the job system that records the shadow map faces on worker threads: every
+// job of a batch runs exactly once, worker indices stay in range and are never shared by
+// two jobs at the same time, and Run returns only after the last job. Then the scalability
+// of the recording: batches of one depth prepass job and six jobs per light, each standing
+// in for recording the draws of one face, timed with 1 to 16 threads.
+// Exits nonzero if a check fails; the timings are only reported.
+//
+// Build (any C++11 compiler, no Windows/D3D11/AGS dependency):
+//     g++ -std=c++11 -O2 -pthread -I../../src JobSystemMain.cpp ../../src/JobSystem.cpp -o JobSystem
+//     cl /EHsc /O2 /I..\..\src JobSystemMain.cpp ..\..\src\JobSystem.cpp
+//
+// Usage:
+//     JobSystem [--lights N] [--draws N] [--batches N] [--seed N]
+//--------------------------------------------------------------------------------------
+#include "JobSystem.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+using namespace AMD;
+
+// xorshift32, so every platform checks the same sequence
+static unsigned int g_RandomState = 1;
+
+static unsigned int Random(unsigned int count)
+{
+    g_RandomState ^= g_RandomState << 13;
+    g_RandomState ^= g_RandomState >> 17;
+    g_RandomState ^= g_RandomState << 5;
+    return g_RandomState % count;
+}
+
+static int g_Failures = 0;
+
+static void Check(bool condition, const char * name, float value)
+{
+    printf("%-48s %10.4g %s\n", name, value, condition ? "ok" : "FAIL");
+    g_Failures += condition ? 0 : 1;
+}
+
+struct CountData
+{
+    std::vector<std::atomic<unsigned int>>  m_Runs;         // per job
+    std::atomic<unsigned int>               m_Busy[JOB_SYSTEM_MAX_WORKER_COUNT];
+    std::atomic<unsigned int>               m_BadWorker;    // out of range, or used by two jobs at once
+    std::atomic<unsigned int>               m_Finished;
+    unsigned int                            m_WorkerCount;
+    unsigned int                            m_Spin;         // busy work per job, to make jobs overlap
+};
+
+static void CountJob(unsigned int job, unsigned int worker, void* pUserData)
+{
+    CountData & data = *(CountData*)pUserData;
+
+    if (worker >= data.m_WorkerCount)
+    {
+        data.m_BadWorker++;
+    }
+    else if (data.m_Busy[worker].exchange(1) != 0)
+    {
+        data.m_BadWorker++;
+    }
+
+    volatile unsigned int sum = 0;
+    for (unsigned int i = 0; i < (job * 7919 + data.m_Spin) % (data.m_Spin + 1); i++)
+    {
+        sum += i;
+    }
+
+    if (worker < data.m_WorkerCount)
+    {
+        data.m_Busy[worker].store(0);
+    }
+
+    data.m_Runs[job]++;
+    data.m_Finished++;
+}
+
+// many batches of random size with every thread count; jobs of 0 and 1 included
+static void RunExactlyOnce(unsigned int batches)
+{
+    unsigned int missed = 0, repeated = 0, badWorkers = 0, early = 0;
+
+    for (unsigned int threads = 1; threads <= JOB_SYSTEM_MAX_WORKER_COUNT; threads++)
+    {
+        JobSystem jobs;
+        jobs.Init(threads);
+        if (jobs.GetWorkerCount() != threads)
+        {
+            badWorkers++;
+        }
+
+        for (unsigned int batch = 0; batch < batches; batch++)
+        {
+            const unsigned int count = batch < 2 ? batch : Random(200);
+
+            CountData data;
+            data.m_Runs = std::vector<std::atomic<unsigned int>>(count);
+            for (unsigned int i = 0; i < count; i++)                        { data.m_Runs[i].store(0); }
+            for (unsigned int i = 0; i < JOB_SYSTEM_MAX_WORKER_COUNT; i++)  { data.m_Busy[i].store(0); }
+            data.m_BadWorker.store(0);
+            data.m_Finished.store(0);
+            data.m_WorkerCount = threads;
+            data.m_Spin = Random(2000);
+
+            jobs.Run(count, CountJob, &data);
+
+            // read right after Run: a job still running would show up here
+            early += data.m_Finished.load() != count ? 1 : 0;
+            badWorkers += data.m_BadWorker.load();
+            for (unsigned int i = 0; i < count; i++)
+            {
+                const unsigned int runs = data.m_Runs[i].load();
+                missed += runs == 0 ? 1 : 0;
+                repeated += runs > 1 ? 1 : 0;
+            }
+        }
+
+        jobs.Release();
+    }
+
+    Check(missed == 0, "exactly once: jobs that didn't run", (float)missed);
+    Check(repeated == 0, "exactly once: jobs that ran twice", (float)repeated);
+    Check(badWorkers == 0, "worker index out of range or shared", (float)badWorkers);
+    Check(early == 0, "Run returned before the last job", (float)early);
+
+    // re-initialization, clamping and a pool that is released twice
+    JobSystem jobs;
+    jobs.Init(0);
+    Check(jobs.GetWorkerCount() == 1, "Init(0) clamps to one thread", (float)jobs.GetWorkerCount());
+    jobs.Init(JOB_SYSTEM_MAX_WORKER_COUNT + 5);
+    Check(jobs.GetWorkerCount() == JOB_SYSTEM_MAX_WORKER_COUNT, "Init clamps to the maximum", (float)jobs.GetWorkerCount());
+    jobs.Init(4);
+    Check(jobs.GetWorkerCount() == 4, "Init again", (float)jobs.GetWorkerCount());
+    jobs.Release();
+    jobs.Release();
+    Check(jobs.GetWorkerCount() == 1, "Release leaves the calling thread", (float)jobs.GetWorkerCount());
+}
+
+// stands in for recording one face: per draw, a model matrix times the light matrix, written
+// to the constants of the draw, the way RenderScene fills S_MODEL_DATA
+struct RecordData
+{
+    unsigned int        m_Draws;
+    std::vector<float>  m_Models;                       // 16 per draw
+    std::vector<float>  m_Lights;                       // 16 per job
+    std::vector<float>  m_Constants;                    // 16 per draw, per job
+    std::vector<float>  m_Checksum;                     // per job
+};
+
+static void RecordJob(unsigned int job, unsigned int worker, void* pUserData)
+{
+    (void)worker;
+
+    RecordData & data = *(RecordData*)pUserData;
+    const float * light = &data.m_Lights[job * 16];
+    float * constants = &data.m_Constants[(size_t)job * data.m_Draws * 16];
+    float checksum = 0.0f;
+
+    for (unsigned int draw = 0; draw < data.m_Draws; draw++)
+    {
+        const float * model = &data.m_Models[draw * 16];
+        float * out = &constants[draw * 16];
+        for (unsigned int r = 0; r < 4; r++)
+        {
+            for (unsigned int c = 0; c < 4; c++)
+            {
+                float sum = 0.0f;
+                for (unsigned int k = 0; k < 4; k++)
+                {
+                    sum += model[r * 4 + k] * light[k * 4 + c];
+                }
+                out[r * 4 + c] = sum;
+                checksum += sum;
+            }
+        }
+    }
+
+    data.m_Checksum[job] = checksum;
+}
+
+static void RunScalability(unsigned int lights, unsigned int draws, unsigned int batches)
+{
+    const unsigned int jobCount = 1 + 6 * lights;
+
+    RecordData data;
+    data.m_Draws = draws;
+    data.m_Models.resize(draws * 16);
+    data.m_Lights.resize(jobCount * 16);
+    data.m_Constants.resize((size_t)jobCount * draws * 16);
+    data.m_Checksum.resize(jobCount);
+    for (size_t i = 0; i < data.m_Models.size(); i++) { data.m_Models[i] = (float)Random(1000) / 1000.0f; }
+    for (size_t i = 0; i < data.m_Lights.size(); i++) { data.m_Lights[i] = (float)Random(1000) / 1000.0f; }
+
+    // the serial result, which every thread count has to reproduce
+    std::vector<float> reference(jobCount);
+    for (unsigned int i = 0; i < jobCount; i++)
+    {
+        RecordJob(i, 0, &data);
+        reference[i] = data.m_Checksum[i];
+    }
+
+    printf("\n%u jobs (depth prepass + %u lights x 6 faces), %u draws each, %u batches\n", jobCount, lights, draws, batches);
+    printf("%8s %14s %10s %12s\n", "threads", "us per batch", "speedup", "efficiency");
+
+    unsigned int mismatches = 0;
+    double serial = 0.0;
+
+    for (unsigned int threads = 1; threads <= JOB_SYSTEM_MAX_WORKER_COUNT; threads++)
+    {
+        JobSystem jobs;
+        jobs.Init(threads);
+
+        // warm up the threads and the caches
+        jobs.Run(jobCount, RecordJob, &data);
+
+        const std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+        for (unsigned int batch = 0; batch < batches; batch++)
+        {
+            jobs.Run(jobCount, RecordJob, &data);
+        }
+        const double us = std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - start).count() / batches;
+
+        for (unsigned int i = 0; i < jobCount; i++)
+        {
+            mismatches += data.m_Checksum[i] != reference[i] ? 1 : 0;
+        }
+
+        if (threads == 1)
+        {
+            serial = us;
+        }
+        printf("%8u %14.1f %9.2fx %11.0f%%\n", threads, us, serial / us, 100.0 * serial / us / threads);
+
+        jobs.Release();
+    }
+    printf("%u hardware threads\n\n", std::thread::hardware_concurrency());
+
+    Check(mismatches == 0, "recorded constants match the serial recording", (float)mismatches);
+}
+
+int main(int argc, char * argv[])
+{
+    unsigned int lights = 8;
+    unsigned int draws = 2000;
+    unsigned int batches = 50;
+
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if      (strcmp(argv[i], "--lights") == 0)  { lights = (unsigned int)atoi(argv[i + 1]); }
+        else if (strcmp(argv[i], "--draws") == 0)   { draws = (unsigned int)atoi(argv[i + 1]); }
+        else if (strcmp(argv[i], "--batches") == 0) { batches = (unsigned int)atoi(argv[i + 1]); }
+        else if (strcmp(argv[i], "--seed") == 0)    { g_RandomState = (unsigned int)atoi(argv[i + 1]); }
+        else
+        {
+            printf("usage: JobSystem [--lights N] [--draws N] [--batches N] [--seed N]\n");
+            return 1;
+        }
+    }
+
+    if (g_RandomState == 0)
+    {
+        fprintf(stderr, "--seed must be positive\n");
+        return 1;
+    }
+
+    lights = lights == 0 ? 1 : lights;
+    draws = draws == 0 ? 1 : draws;
+    batches = batches == 0 ? 1 : batches;
+
+    RunExactlyOnce(300);
+    RunScalability(lights, draws, batches);
+
+    printf("%s\n", g_Failures == 0 ? "PASS" : "FAIL");
+    return g_Failures == 0 ? 0 : 1;
+}
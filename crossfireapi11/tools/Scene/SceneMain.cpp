@@ -0,0 +1,383 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//--------------------------------------------------------------------------------------
+// File: SceneMain.cpp
+//
+// CPU checks of the scene file and of the instance batching: a scene with every kind of
+// line parsed and compared against the expected instances and lights, malformed lines
+// reported at their line, the world matrix of an instance against scale * rotation *
+// translation, then random subsets of instances grouped by mesh and compared against a
+// stable sort, with the draws of both paths and the cost of a build. Exits nonzero if a
+// check fails.
+//
+// Build (any C++11 compiler, no Windows/D3D11/AGS dependency):
+//     g++ -std=c++11 -O2 -I../../src SceneMain.cpp ../../src/Scene.cpp ../../src/InstanceBatcher.cpp -o Scene
+//     cl /EHsc /O2 /I..\..\src SceneMain.cpp ..\..\src\Scene.cpp ..\..\src\InstanceBatcher.cpp
+//
+// Usage:
+//     Scene [--scene ../../media/scenes/forest.txt] [--subsets N] [--seed N]
+//--------------------------------------------------------------------------------------
+#include "Scene.h"
+#include "InstanceBatcher.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+using namespace AMD;
+
+// xorshift32, so every platform checks the same sequence
+static unsigned int g_RandomState = 1;
+
+static unsigned int Random(unsigned int count)
+{
+    g_RandomState ^= g_RandomState << 13;
+    g_RandomState ^= g_RandomState >> 17;
+    g_RandomState ^= g_RandomState << 5;
+    return g_RandomState % count;
+}
+
+static int g_Failures = 0;
+
+static void Check(bool condition, const char * name, float value)
+{
+    printf("%-48s %10.4g %s\n", name, value, condition ? "ok" : "FAIL");
+    g_Failures += condition ? 0 : 1;
+}
+
+static const float PI = 3.14159265358979f;
+
+//--------------------------------------------------------------------------------------
+// The world matrix: a point through the matrix against the point scaled, turned and moved
+//--------------------------------------------------------------------------------------
+static float TransformError(const float * pWorld, const float * pPosition, float yaw, const float * pScale, const float * pPoint)
+{
+    // XMMatrixRotationY turns x towards -z: x' = x cos + z sin, z' = -x sin + z cos
+    const float scaled[3] = { pPoint[0] * pScale[0], pPoint[1] * pScale[1], pPoint[2] * pScale[2] };
+    const float expected[3] =
+    {
+        scaled[0] * cosf(yaw) + scaled[2] * sinf(yaw) + pPosition[0],
+        scaled[1] + pPosition[1],
+        -scaled[0] * sinf(yaw) + scaled[2] * cosf(yaw) + pPosition[2],
+    };
+
+    float error = 0.0f;
+    for (unsigned int j = 0; j < 3; j++)
+    {
+        const float result = pPoint[0] * pWorld[j] + pPoint[1] * pWorld[4 + j] + pPoint[2] * pWorld[8 + j] + pWorld[12 + j];
+        error = fmaxf(error, fabsf(result - expected[j]));
+    }
+    error = fmaxf(error, fabsf(pPoint[0] * pWorld[3] + pPoint[1] * pWorld[7] + pPoint[2] * pWorld[11] + pWorld[15] - 1.0f));
+    return error;
+}
+
+static void RunWorld()
+{
+    float error = 0.0f;
+    for (unsigned int i = 0; i < 1000; i++)
+    {
+        const float position[3] = { (float)Random(2001) * 0.1f - 100.0f, (float)Random(2001) * 0.1f - 100.0f, (float)Random(2001) * 0.1f - 100.0f };
+        const float scale[3] = { (float)(Random(1000) + 1) * 0.01f, (float)(Random(1000) + 1) * 0.01f, (float)(Random(1000) + 1) * 0.01f };
+        const float point[3] = { (float)Random(201) * 0.1f - 10.0f, (float)Random(201) * 0.1f - 10.0f, (float)Random(201) * 0.1f - 10.0f };
+        const float yaw = (float)Random(3600) * 0.1f * PI / 180.0f;
+
+        float world[16];
+        GetSceneInstanceWorld(position, yaw, scale, world);
+        error = fmaxf(error, TransformError(world, position, yaw, scale, point));
+    }
+    Check(error < 1e-3f, "world: largest error of a transformed point", error);
+}
+
+//--------------------------------------------------------------------------------------
+// Parsing
+//--------------------------------------------------------------------------------------
+static void RunParse()
+{
+    // CRLF line ends, comments, blank lines and every kind of entry
+    const char * text =
+        "# a scene\r\n"
+        "mesh tree ..\\media\\coconuttree\\ coconut.sdkmesh\r\n"
+        "\r\n"
+        "mesh plane ..\\media\\plane\\ plane.sdkmesh   # the ground\r\n"
+        "instance tree dynamic 5 0 0 90 0.01 0.02 0.03\r\n"
+        "   instance plane static 0 0 0 0 1 1 1\r\n"
+        "grid tree static -10 0 -20 3 2 2.5 4 45 1 1 1\r\n"
+        "spot 9.5 6 0 2.5 0 0 54 25\r\n";
+
+    Scene scene;
+    const bool parsed = scene.Parse(text);
+    Check(parsed == true, "parse: scene with every entry", (float)scene.GetErrorLine());
+    if (parsed == false)
+    {
+        return;
+    }
+
+    Check(scene.GetMeshCount() == 2, "parse: meshes", (float)scene.GetMeshCount());
+    Check(scene.FindMesh("plane") == 1 && scene.FindMesh("rock") == SCENE_INVALID_INDEX, "parse: mesh lookup", (float)scene.FindMesh("plane"));
+    Check(scene.GetMesh(0).m_Directory == "..\\media\\coconuttree\\" && scene.GetMesh(1).m_File == "plane.sdkmesh", "parse: mesh directory and file", 0.0f);
+    Check(scene.GetInstanceCount() == 8, "parse: instances", (float)scene.GetInstanceCount());
+    Check(scene.GetStaticInstanceCount() == 7, "parse: static instances", (float)scene.GetStaticInstanceCount());
+
+    const float position[3] = { 5.0f, 0.0f, 0.0f };
+    const float scale[3] = { 0.01f, 0.02f, 0.03f };
+    const float point[3] = { 100.0f, 50.0f, -30.0f };
+    const SceneInstance & tree = scene.GetInstance(0);
+    Check(tree.m_Mesh == 0 && tree.m_Static == false, "parse: instance mesh and flag", (float)tree.m_Mesh);
+    Check(TransformError(tree.m_World, position, 0.5f * PI, scale, point) < 1e-5f, "parse: instance world",
+          TransformError(tree.m_World, position, 0.5f * PI, scale, point));
+
+    // grid: columns along x, rows along z, yaw growing by 45 degrees and wrapping at 360
+    float        gridError = 0.0f;
+    unsigned int gridMeshes = 0;
+    for (unsigned int i = 0; i < 6; i++)
+    {
+        const SceneInstance & instance = scene.GetInstance(2 + i);
+        const float           gridPosition[3] = { -10.0f + 2.5f * (float)(i % 3), 0.0f, -20.0f + 4.0f * (float)(i / 3) };
+        const float           gridScale[3] = { 1.0f, 1.0f, 1.0f };
+        gridError = fmaxf(gridError, TransformError(instance.m_World, gridPosition, 45.0f * (float)i * PI / 180.0f, gridScale, point));
+        gridMeshes += instance.m_Mesh == 0 && instance.m_Static == true ? 1 : 0;
+    }
+    Check(gridError < 1e-3f, "parse: grid positions and yaw", gridError);
+    Check(gridMeshes == 6, "parse: grid mesh and flag", (float)gridMeshes);
+
+    Check(scene.GetLightCount() == 1, "parse: lights", (float)scene.GetLightCount());
+    const SceneLight & light = scene.GetLight(0);
+    Check(light.m_Position[0] == 9.5f && light.m_Position[1] == 6.0f && light.m_At[0] == 2.5f && light.m_Range == 25.0f, "parse: light position, at and range", light.m_Range);
+    Check(fabsf(light.m_ConeAngle - 54.0f * PI / 180.0f) < 1e-6f, "parse: light cone in radians", light.m_ConeAngle);
+
+    Check(scene.Parse("") == true && scene.GetMeshCount() == 0 && scene.GetInstanceCount() == 0, "parse: empty scene", 0.0f);
+}
+
+static void RunErrors()
+{
+    struct Malformed
+    {
+        const char * m_Name;
+        const char * m_Text;
+        unsigned int m_Line;
+    };
+
+    const Malformed malformed[] =
+    {
+        { "errors: unknown entry",              "mesh a d f\nrock a static 0 0 0 0 1 1 1\n", 2 },
+        { "errors: instance of an unknown mesh","mesh a d f\n\ninstance b static 0 0 0 0 1 1 1\n", 3 },
+        { "errors: instance before its mesh",   "instance a static 0 0 0 0 1 1 1\nmesh a d f\n", 1 },
+        { "errors: neither static nor dynamic", "mesh a d f\ninstance a moving 0 0 0 0 1 1 1\n", 2 },
+        { "errors: missing number",             "mesh a d f\ninstance a static 0 0 0 0 1 1\n", 2 },
+        { "errors: text after the last number", "mesh a d f\ninstance a static 0 0 0 0 1 1 1 1\n", 2 },
+        { "errors: not a number",               "mesh a d f\ninstance a static 0 zero 0 0 1 1 1\n", 2 },
+        { "errors: mesh without a file",        "# meshes\nmesh a d\n", 2 },
+        { "errors: mesh declared twice",        "mesh a d f\nmesh a e g\n", 2 },
+        { "errors: grid without columns",       "mesh a d f\ngrid a static 0 0 0 0 4 1 1 0 1 1 1\n", 2 },
+        { "errors: grid past the instance limit","mesh a d f\ngrid a static 0 0 0 1024 1025 1 1 0 1 1 1\n", 2 },
+        { "errors: cone of 180 degrees",        "spot 0 0 0 1 0 0 180 10\n", 1 },
+        { "errors: light without range",        "spot 0 0 0 1 0 0 45 0\n", 1 },
+    };
+
+    for (unsigned int i = 0; i < sizeof(malformed) / sizeof(malformed[0]); i++)
+    {
+        Scene      scene;
+        const bool parsed = scene.Parse(malformed[i].m_Text);
+        Check(parsed == false && scene.GetErrorLine() == malformed[i].m_Line, malformed[i].m_Name, (float)scene.GetErrorLine());
+    }
+
+    Scene scene;
+    Check(scene.Load("missing/scene.txt") == false && scene.GetErrorLine() == 0, "errors: missing file", (float)scene.GetErrorLine());
+}
+
+//--------------------------------------------------------------------------------------
+// Batching: random subsets of the instances, as the shadow casters of a face would be
+//--------------------------------------------------------------------------------------
+struct MeshOrder
+{
+    const unsigned int * m_pInstanceMesh;
+    bool operator()(unsigned int a, unsigned int b) const { return m_pInstanceMesh[a] < m_pInstanceMesh[b]; }
+};
+
+static void RunBatching(const Scene & scene, unsigned int subsets)
+{
+    const unsigned int instanceCount = scene.GetInstanceCount();
+    const unsigned int meshCount = scene.GetMeshCount();
+
+    std::vector<unsigned int> instanceMesh(instanceCount), subsetCounts(meshCount);
+    for (unsigned int i = 0; i < instanceCount; i++)
+    {
+        instanceMesh[i] = scene.GetInstance(i).m_Mesh;
+    }
+    for (unsigned int mesh = 0; mesh < meshCount; mesh++)
+    {
+        subsetCounts[mesh] = 1 + Random(4);
+    }
+
+    InstanceBatcher batcher;
+    unsigned int    mismatches = 0, badBatches = 0, instancedDraws = 0, instanceDraws = 0;
+    for (unsigned int subset = 0; subset < subsets; subset++)
+    {
+        // a random subset in random order, sometimes empty, sometimes everything
+        std::vector<unsigned int> instances;
+        const unsigned int        keep = subset % 8 == 0 ? 0 : (subset % 8 == 1 ? 8 : Random(8));
+        for (unsigned int i = 0; i < instanceCount; i++)
+        {
+            if (Random(8) < keep)
+            {
+                instances.push_back(i);
+            }
+        }
+        for (unsigned int i = 1; i < instances.size(); i++)
+        {
+            std::swap(instances[i], instances[Random(i + 1)]);
+        }
+
+        const unsigned int * pInstances = instances.empty() ? NULL : &instances[0];
+        const unsigned int   batchCount = batcher.Build(pInstances, (unsigned int)instances.size(), instanceMesh.empty() ? NULL : &instanceMesh[0], meshCount);
+
+        std::vector<unsigned int> reference(instances);
+        MeshOrder                 order = { instanceMesh.empty() ? NULL : &instanceMesh[0] };
+        std::stable_sort(reference.begin(), reference.end(), order);
+
+        mismatches += batcher.GetInstanceCount() != reference.size() ? 1 : 0;
+        for (unsigned int i = 0; i < reference.size() && i < batcher.GetInstanceCount(); i++)
+        {
+            mismatches += batcher.GetInstance(i) != reference[i] ? 1 : 0;
+        }
+
+        // batches in increasing mesh order, back to back, each holding only its mesh
+        unsigned int next = 0;
+        for (unsigned int batch = 0; batch < batchCount; batch++)
+        {
+            const InstanceBatch & b = batcher.GetBatch(batch);
+            bool                  good = b.m_FirstInstance == next && b.m_InstanceCount > 0 && (batch == 0 || b.m_Mesh > batcher.GetBatch(batch - 1).m_Mesh);
+            for (unsigned int i = 0; good == true && i < b.m_InstanceCount; i++)
+            {
+                good = instanceMesh[batcher.GetInstance(b.m_FirstInstance + i)] == b.m_Mesh;
+            }
+            badBatches += good ? 0 : 1;
+            next += b.m_InstanceCount;
+        }
+        badBatches += next != instances.size() ? 1 : 0;
+
+        instancedDraws += batcher.GetDrawCount(subsetCounts.empty() ? NULL : &subsetCounts[0]);
+        for (unsigned int i = 0; i < instances.size(); i++)
+        {
+            instanceDraws += subsetCounts[instanceMesh[instances[i]]];
+        }
+    }
+    Check(mismatches == 0, "batching: order against a stable sort", (float)mismatches);
+    Check(badBatches == 0, "batching: malformed batches", (float)badBatches);
+    Check(instancedDraws <= instanceDraws, "batching: draws per subset, instanced", (float)instancedDraws / (float)subsets);
+    Check(instancedDraws <= instanceDraws, "batching: draws per subset, one per instance", (float)instanceDraws / (float)subsets);
+
+    // the cost of a build over every instance, as the scene pass does it every frame
+    std::vector<unsigned int> all(instanceCount);
+    for (unsigned int i = 0; i < instanceCount; i++)
+    {
+        all[i] = i;
+    }
+
+    const unsigned int repeats = 200;
+    unsigned int       sum = 0;
+
+    std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+    for (unsigned int repeat = 0; repeat < repeats; repeat++)
+    {
+        sum += batcher.Build(all.empty() ? NULL : &all[0], instanceCount, instanceMesh.empty() ? NULL : &instanceMesh[0], meshCount);
+    }
+    const double buildUs = std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - start).count() / (double)repeats;
+
+    Check(sum <= repeats * meshCount, "batching: us per build of every instance", (float)buildUs);
+}
+
+// a scene as large as the forest, but built without a file
+static void BuildGeneratedScene(Scene & scene)
+{
+    scene.Clear();
+    scene.AddMesh("plane", "..\\media\\plane\\", "plane.sdkmesh");
+    scene.AddMesh("tree", "..\\media\\coconuttree\\", "coconut.sdkmesh");
+    scene.AddMesh("rock", "..\\media\\rock\\", "rock.sdkmesh");
+
+    const float scale[3] = { 1.0f, 1.0f, 1.0f };
+    for (unsigned int i = 0; i < 4096 + 64; i++)
+    {
+        const float position[3] = { (float)(i % 64), 0.0f, (float)(i / 64) };
+        scene.AddInstance(i == 0 ? 0 : 1 + Random(2), i < 4096, position, 0.0f, scale);
+    }
+}
+
+int main(int argc, char * argv[])
+{
+    const char * path = NULL;
+    unsigned int subsets = 256;
+
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if      (strcmp(argv[i], "--scene") == 0)   { path = argv[i + 1]; }
+        else if (strcmp(argv[i], "--subsets") == 0) { subsets = (unsigned int)atoi(argv[i + 1]); }
+        else if (strcmp(argv[i], "--seed") == 0)    { g_RandomState = (unsigned int)atoi(argv[i + 1]); }
+        else
+        {
+            printf("usage: Scene [--scene file] [--subsets N] [--seed N]\n");
+            return 1;
+        }
+    }
+
+    if (g_RandomState == 0 || subsets == 0)
+    {
+        fprintf(stderr, "--seed and --subsets must be positive\n");
+        return 1;
+    }
+
+    RunWorld();
+    RunParse();
+    RunErrors();
+
+    Scene scene;
+    if (path != NULL)
+    {
+        const std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+        const bool loaded = scene.Load(path);
+        const double loadMs = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+        Check(loaded == true, "scene: loaded, else the line of the error", (float)scene.GetErrorLine());
+        Check(loaded == true, "scene: ms to load", (float)loadMs);
+        if (loaded == false)
+        {
+            printf("FAIL\n");
+            return 1;
+        }
+        Check(scene.GetMeshCount() > 0, "scene: meshes", (float)scene.GetMeshCount());
+        Check(scene.GetInstanceCount() > 0, "scene: instances", (float)scene.GetInstanceCount());
+        Check(true, "scene: static instances", (float)scene.GetStaticInstanceCount());
+        Check(true, "scene: lights", (float)scene.GetLightCount());
+    }
+    else
+    {
+        BuildGeneratedScene(scene);
+    }
+    RunBatching(scene, subsets);
+
+    printf("%s\n", g_Failures == 0 ? "PASS" : "FAIL");
+    return g_Failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,319 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: ShadowAtlasBenchmarkMain.cpp
+//
+// Packing efficiency benchmarks for ShadowAtlasAllocator: how much of an atlas the
+// allocator fills with variable size shadow regions compared to a fixed grid, and how
+// it holds up when lights keep changing resolution (with defragmentation).
+//
+// Build (any C++11 compiler, no Windows/D3D11/AGS dependency):
+//     g++ -std=c++11 -O2 -I../../src ShadowAtlasBenchmarkMain.cpp ../../src/ShadowAtlasAllocator.cpp -o ShadowAtlasBenchmark
+//     cl /EHsc /O2 /I..\..\src ShadowAtlasBenchmarkMain.cpp ..\..\src\ShadowAtlasAllocator.cpp
+//
+// Examples:
+//     ShadowAtlasBenchmark
+//     ShadowAtlasBenchmark --atlas 8192 --lights 48 --steps 20000 --seed 7
+//--------------------------------------------------------------------------------------
+#include "ShadowAtlasAllocator.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+
+using namespace AMD;
+
+static const unsigned int CUBE_FACE_COUNT = 6;
+
+// xorshift32, so every platform packs the same sequence
+struct Random
+{
+    unsigned int m_State;
+
+    explicit Random(unsigned int seed) : m_State(seed != 0 ? seed : 1) {}
+
+    unsigned int Next()
+    {
+        m_State ^= m_State << 13;
+        m_State ^= m_State >> 17;
+        m_State ^= m_State << 5;
+        return m_State;
+    }
+
+    unsigned int Range(unsigned int count) { return Next() % count; }
+};
+
+typedef unsigned int (*SizeDistribution)(Random & random, unsigned int maxSize);
+
+// every region at full resolution, what the fixed 3x2 grid of the sample holds
+static unsigned int FullSize(Random & random, unsigned int maxSize)
+{
+    (void)random;
+    return maxSize;
+}
+
+// power of two sizes from maxSize / 8 to maxSize, equally likely
+static unsigned int PowerOfTwo(Random & random, unsigned int maxSize)
+{
+    return maxSize >> random.Range(4);
+}
+
+// a few near lights at full resolution, most of them distant and small
+static unsigned int DistanceFalloff(Random & random, unsigned int maxSize)
+{
+    const unsigned int r = random.Range(100);
+    if (r < 10) { return maxSize; }
+    if (r < 30) { return maxSize / 2; }
+    if (r < 60) { return maxSize / 4; }
+    return maxSize / 8;
+}
+
+// arbitrary sizes, multiples of 16 texels
+static unsigned int Arbitrary(Random & random, unsigned int maxSize)
+{
+    const unsigned int minSize = maxSize / 8;
+    return (minSize + random.Range(maxSize - minSize + 1)) & ~15u;
+}
+
+struct Distribution
+{
+    const char *     m_Name;
+    SizeDistribution m_Size;
+};
+
+static const Distribution g_Distributions[] =
+{
+    { "full",      FullSize },
+    { "pow2",      PowerOfTwo },
+    { "distance",  DistanceFalloff },
+    { "arbitrary", Arbitrary },
+};
+
+static bool Overlaps(const ShadowAtlasRect & a, const ShadowAtlasRect & b)
+{
+    return a.m_X < b.m_X + b.m_Width && b.m_X < a.m_X + a.m_Width &&
+           a.m_Y < b.m_Y + b.m_Height && b.m_Y < a.m_Y + a.m_Height;
+}
+
+// every live region inside the atlas and disjoint from the others
+static bool Validate(const ShadowAtlasAllocator & atlas, const std::vector<unsigned int> & regions)
+{
+    for (size_t i = 0; i < regions.size(); i++)
+    {
+        if (regions[i] == SHADOW_ATLAS_INVALID_REGION) { continue; }
+        if (atlas.IsValid(regions[i]) == false) { return false; }
+
+        const ShadowAtlasRect & a = atlas.GetRect(regions[i]);
+        if (a.m_X + a.m_Width > atlas.GetWidth() || a.m_Y + a.m_Height > atlas.GetHeight()) { return false; }
+
+        for (size_t j = i + 1; j < regions.size(); j++)
+        {
+            if (regions[j] != SHADOW_ATLAS_INVALID_REGION && Overlaps(a, atlas.GetRect(regions[j]))) { return false; }
+        }
+    }
+    return true;
+}
+
+// Allocate cube faces of lights of random resolution until a whole light doesn't fit,
+// and compare with a grid of maxSize cells, which is what the sample's fixed atlas is
+static bool RunFill(const Distribution & distribution, unsigned int atlasSize, unsigned int maxSize, unsigned int seed)
+{
+    Random random(seed);
+
+    ShadowAtlasAllocator atlas;
+    atlas.Init(atlasSize, atlasSize);
+
+    std::vector<unsigned int> regions;
+    unsigned int              lights = 0;
+
+    for (;;)
+    {
+        const unsigned int size = distribution.m_Size(random, maxSize);
+
+        unsigned int faces[CUBE_FACE_COUNT];
+        unsigned int placed = 0;
+        for (; placed < CUBE_FACE_COUNT; placed++)
+        {
+            faces[placed] = atlas.Allocate(size, size);
+            if (faces[placed] == SHADOW_ATLAS_INVALID_REGION) { break; }
+        }
+
+        if (placed < CUBE_FACE_COUNT)
+        {
+            for (unsigned int i = 0; i < placed; i++) { atlas.Free(faces[i]); }
+            break;
+        }
+
+        regions.insert(regions.end(), faces, faces + CUBE_FACE_COUNT);
+        lights++;
+    }
+
+    const unsigned int gridCells = (atlasSize / maxSize) * (atlasSize / maxSize);
+    const unsigned int gridLights = gridCells / CUBE_FACE_COUNT;
+    const bool         valid = Validate(atlas, regions);
+
+    printf("%-10s %8u %10.1f%% %10u %10u %8s\n",
+        distribution.m_Name, lights, atlas.GetOccupancy() * 100.0f, gridLights, lights > gridLights ? lights - gridLights : 0, valid ? "ok" : "OVERLAP");
+
+    return valid;
+}
+
+// Lights keep changing resolution (e.g. with their distance to the viewer). A light that
+// doesn't fit triggers a defragmentation; regions of other lights stay put otherwise.
+static bool RunChurn(const Distribution & distribution, unsigned int atlasSize, unsigned int maxSize, unsigned int lightCount, unsigned int steps, unsigned int seed, bool validate)
+{
+    Random random(seed);
+
+    ShadowAtlasAllocator atlas;
+    atlas.Init(atlasSize, atlasSize);
+
+    std::vector<unsigned int> regions(lightCount * CUBE_FACE_COUNT, SHADOW_ATLAS_INVALID_REGION);
+
+    unsigned int       failures = 0;
+    unsigned int       defrags = 0;
+    unsigned int       moved = 0;
+    unsigned int       stableSteps = 0;
+    double             occupancy = 0.0;
+    bool               valid = true;
+
+    const std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+    for (unsigned int step = 0; step < steps; step++)
+    {
+        const unsigned int light = random.Range(lightCount);
+        const unsigned int size = distribution.m_Size(random, maxSize);
+        unsigned int *     faces = &regions[light * CUBE_FACE_COUNT];
+
+        for (unsigned int i = 0; i < CUBE_FACE_COUNT; i++)
+        {
+            atlas.Free(faces[i]);
+            faces[i] = SHADOW_ATLAS_INVALID_REGION;
+        }
+
+        bool defragmented = false;
+        for (unsigned int i = 0; i < CUBE_FACE_COUNT; i++)
+        {
+            faces[i] = atlas.Allocate(size, size);
+            if (faces[i] == SHADOW_ATLAS_INVALID_REGION && defragmented == false)
+            {
+                const unsigned int count = atlas.Defragment();
+                defrags += count > 0 ? 1 : 0;
+                moved += count;
+                defragmented = true;
+
+                faces[i] = atlas.Allocate(size, size);
+            }
+
+            failures += faces[i] == SHADOW_ATLAS_INVALID_REGION ? 1 : 0;
+        }
+
+        stableSteps += defragmented ? 0 : 1;
+        occupancy += atlas.GetOccupancy();
+
+        if (validate == true && valid == true)
+        {
+            valid = Validate(atlas, regions);
+        }
+    }
+
+    const double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+    const double usPerFace = steps > 0 ? seconds * 1.0e6 / (steps * (double)CUBE_FACE_COUNT) : 0.0;
+
+    printf("%-10s %8u %10.1f%% %10.3f%% %8u %10.1f %10.1f%% %10.3f %8s\n",
+        distribution.m_Name, steps,
+        steps > 0 ? occupancy / steps * 100.0 : 0.0,
+        steps > 0 ? 100.0 * failures / (steps * (double)CUBE_FACE_COUNT) : 0.0,
+        defrags,
+        defrags > 0 ? (double)moved / defrags : 0.0,
+        steps > 0 ? 100.0 * stableSteps / steps : 0.0,
+        usPerFace,
+        validate ? (valid ? "ok" : "OVERLAP") : "-");
+
+    return valid;
+}
+
+static void PrintUsage()
+{
+    printf("usage: ShadowAtlasBenchmark [options]\n"
+           "  --atlas N      atlas width and height (4096)\n"
+           "  --max-size N   full resolution of a cube face (1024)\n"
+           "  --lights N     point lights in the churn benchmark, 6 faces each (16)\n"
+           "  --steps N      resolution changes in the churn benchmark (5000)\n"
+           "  --seed N       random seed (1)\n"
+           "  --no-validate  skip the overlap check after every churn step\n");
+}
+
+int main(int argc, char * argv[])
+{
+    unsigned int atlasSize = 4096;
+    unsigned int maxSize = 1024;
+    unsigned int lightCount = 16;
+    unsigned int steps = 5000;
+    unsigned int seed = 1;
+    bool         validate = true;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const char * arg = argv[i];
+        const char * value = i + 1 < argc ? argv[i + 1] : NULL;
+
+        if (strcmp(arg, "--no-validate") == 0) { validate = false; continue; }
+        if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0) { PrintUsage(); return 0; }
+
+        if (value == NULL) { PrintUsage(); return 1; }
+        i++;
+
+        if      (strcmp(arg, "--atlas") == 0)    { atlasSize = (unsigned int)atoi(value); }
+        else if (strcmp(arg, "--max-size") == 0) { maxSize = (unsigned int)atoi(value); }
+        else if (strcmp(arg, "--lights") == 0)   { lightCount = (unsigned int)atoi(value); }
+        else if (strcmp(arg, "--steps") == 0)    { steps = (unsigned int)atoi(value); }
+        else if (strcmp(arg, "--seed") == 0)     { seed = (unsigned int)atoi(value); }
+        else { PrintUsage(); return 1; }
+    }
+
+    if (atlasSize == 0 || maxSize < 8 || maxSize > atlasSize || lightCount == 0)
+    {
+        fprintf(stderr, "--atlas, --max-size and --lights must be positive, and --max-size at least 8 and at most --atlas\n");
+        return 1;
+    }
+
+    bool valid = true;
+
+    printf("# fill: %ux%u atlas, faces up to %u, lights of 6 faces until one doesn't fit\n", atlasSize, atlasSize, maxSize);
+    printf("%-10s %8s %11s %10s %10s %8s\n", "sizes", "lights", "occupancy", "grid", "extra", "check");
+    for (size_t i = 0; i < sizeof(g_Distributions) / sizeof(g_Distributions[0]); i++)
+    {
+        valid = RunFill(g_Distributions[i], atlasSize, maxSize, seed) && valid;
+    }
+
+    printf("\n# churn: %u lights change resolution %u times\n", lightCount, steps);
+    printf("%-10s %8s %11s %11s %8s %10s %11s %10s %8s\n", "sizes", "steps", "occupancy", "failed", "defrags", "moved", "stable", "us/face", "check");
+    for (size_t i = 0; i < sizeof(g_Distributions) / sizeof(g_Distributions[0]); i++)
+    {
+        valid = RunChurn(g_Distributions[i], atlasSize, maxSize, lightCount, steps, seed, validate) && valid;
+    }
+
+    return valid ? 0 : 1;
+}
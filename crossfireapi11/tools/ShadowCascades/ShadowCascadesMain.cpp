@@ -0,0 +1,423 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//--------------------------------------------------------------------------------------
+// File: ShadowCascadesMain.cpp
+//
+// CPU checks of the stable cascaded shadow maps: the practical split scheme, the
+// bounding spheres of random view frustum slices, the texel snapping of a moving viewer,
+// the per cascade update intervals with AFR, and the cost of an Update(). Exits nonzero
+// if a check fails.
+//
+// Build (any C++11 compiler, no Windows/D3D11/AGS dependency):
+//     g++ -std=c++11 -O2 -I../../src ShadowCascadesMain.cpp ../../src/ShadowCascades.cpp -o ShadowCascades
+//     cl /EHsc /O2 /I..\..\src ShadowCascadesMain.cpp ..\..\src\ShadowCascades.cpp
+//
+// Usage:
+//     ShadowCascades [--viewers N] [--seed N]
+//--------------------------------------------------------------------------------------
+#include "ShadowCascades.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+using namespace AMD;
+
+static const float PI = 3.14159265f;
+
+// xorshift32, so every platform checks the same sequence
+static unsigned int g_RandomState = 1;
+
+static float Random(float minValue, float maxValue)
+{
+    g_RandomState ^= g_RandomState << 13;
+    g_RandomState ^= g_RandomState >> 17;
+    g_RandomState ^= g_RandomState << 5;
+    return minValue + (maxValue - minValue) * (float)(g_RandomState & 0xffffff) / (float)0xffffff;
+}
+
+static int g_Failures = 0;
+
+static void Check(bool condition, const char * name, float value)
+{
+    printf("%-48s %10.4f %s\n", name, value, condition ? "ok" : "FAIL");
+    g_Failures += condition ? 0 : 1;
+}
+
+static void Normalize(float v[3])
+{
+    const float length = sqrtf(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+    v[0] /= length; v[1] /= length; v[2] /= length;
+}
+
+static void Cross(const float a[3], const float b[3], float r[3])
+{
+    r[0] = a[1] * b[2] - a[2] * b[1];
+    r[1] = a[2] * b[0] - a[0] * b[2];
+    r[2] = a[0] * b[1] - a[1] * b[0];
+}
+
+static ShadowCascadeViewer RandomViewer()
+{
+    ShadowCascadeViewer viewer;
+    for (int i = 0; i < 3; i++)
+    {
+        viewer.m_Position[i] = Random(-50.0f, 50.0f);
+        viewer.m_Direction[i] = Random(-1.0f, 1.0f);
+    }
+    viewer.m_Direction[0] += 0.01f; // never 0
+    Normalize(viewer.m_Direction);
+    viewer.m_Fov = Random(PI / 8.0f, PI / 2.0f);
+    viewer.m_Aspect = Random(0.5f, 2.5f);
+    return viewer;
+}
+
+// the 8 corners of the slice, with a random roll of the viewer around its axis
+static void GetSliceCorners(const ShadowCascadeViewer & viewer, float zNear, float zFar, float corners[8][3])
+{
+    float side[3] = { Random(-1.0f, 1.0f), Random(-1.0f, 1.0f), Random(-1.0f, 1.0f) };
+    float right[3], up[3];
+    Cross(side, viewer.m_Direction, right);
+    Normalize(right);
+    Cross(viewer.m_Direction, right, up);
+
+    const float tanY = tanf(viewer.m_Fov * 0.5f);
+    const float tanX = tanY * viewer.m_Aspect;
+
+    for (int corner = 0; corner < 8; corner++)
+    {
+        const float depth = (corner & 4) ? zFar : zNear;
+        const float x = (corner & 1) ? tanX : -tanX;
+        const float y = (corner & 2) ? tanY : -tanY;
+        for (int i = 0; i < 3; i++)
+        {
+            corners[corner][i] = viewer.m_Position[i] + (viewer.m_Direction[i] + right[i] * x + up[i] * y) * depth;
+        }
+    }
+}
+
+// p * view * projection, orthographic: no divide
+static void Project(const ShadowCascade & cascade, const float p[3], float clip[3])
+{
+    float v[4];
+    for (int col = 0; col < 4; col++)
+    {
+        v[col] = p[0] * cascade.m_View[col] + p[1] * cascade.m_View[4 + col] + p[2] * cascade.m_View[8 + col] + cascade.m_View[12 + col];
+    }
+    for (int col = 0; col < 3; col++)
+    {
+        clip[col] = v[0] * cascade.m_Projection[col] + v[1] * cascade.m_Projection[4 + col] + v[2] * cascade.m_Projection[8 + col] + v[3] * cascade.m_Projection[12 + col];
+    }
+}
+
+static void RunSplits()
+{
+    float splits[SHADOW_CASCADE_MAX_COUNT + 1];
+
+    ComputeShadowCascadeSplits(1.0f, 100.0f, 0.0f, 4, splits);
+    Check(fabsf(splits[1] - 25.75f) < 1e-4f && fabsf(splits[2] - 50.5f) < 1e-4f, "lambda 0 is uniform", splits[1]);
+
+    ComputeShadowCascadeSplits(1.0f, 100.0f, 1.0f, 4, splits);
+    Check(fabsf(splits[2] - 10.0f) < 1e-3f && fabsf(splits[1] * splits[1] - splits[2]) < 1e-3f, "lambda 1 is logarithmic", splits[2]);
+
+    ComputeShadowCascadeSplits(0.5f, 200.0f, 0.75f, SHADOW_CASCADE_MAX_COUNT, splits);
+    bool increasing = splits[0] == 0.5f && splits[SHADOW_CASCADE_MAX_COUNT] == 200.0f;
+    for (unsigned int i = 0; i < SHADOW_CASCADE_MAX_COUNT; i++)
+    {
+        increasing = increasing && splits[i] < splits[i + 1];
+    }
+    Check(increasing, "splits from near to far, increasing", splits[1]);
+}
+
+static void RunSpheres(unsigned int viewers)
+{
+    float worstOutside = 0.0f;  // corner distance beyond the radius, relative
+    float worstSlack = 0.0f;    // radius beyond the farthest corner, relative
+    float worstTurn = 0.0f;     // radius change when only the viewer direction changes
+
+    for (unsigned int i = 0; i < viewers; i++)
+    {
+        ShadowCascadeViewer viewer = RandomViewer();
+        const float zNear = Random(0.1f, 50.0f);
+        const float zFar = zNear + Random(0.1f, 100.0f);
+
+        const ShadowCascadeSphere sphere = FitShadowCascadeSphere(viewer, zNear, zFar);
+
+        float corners[8][3];
+        GetSliceCorners(viewer, zNear, zFar, corners);
+
+        float farthest = 0.0f;
+        for (int corner = 0; corner < 8; corner++)
+        {
+            const float dx = corners[corner][0] - sphere.m_Center[0];
+            const float dy = corners[corner][1] - sphere.m_Center[1];
+            const float dz = corners[corner][2] - sphere.m_Center[2];
+            farthest = fmaxf(farthest, sqrtf(dx * dx + dy * dy + dz * dz));
+        }
+        worstOutside = fmaxf(worstOutside, (farthest - sphere.m_Radius) / sphere.m_Radius);
+        worstSlack = fmaxf(worstSlack, (sphere.m_Radius - farthest) / sphere.m_Radius);
+
+        viewer.m_Direction[1] += 0.5f;
+        Normalize(viewer.m_Direction);
+        worstTurn = fmaxf(worstTurn, fabsf(FitShadowCascadeSphere(viewer, zNear, zFar).m_Radius - sphere.m_Radius));
+    }
+
+    Check(worstOutside < 1e-4f, "corners inside the sphere", worstOutside);
+    Check(worstSlack < 1e-4f, "sphere touches the farthest corners", worstSlack);
+    Check(worstTurn == 0.0f, "radius independent of the view direction", worstTurn);
+}
+
+static void RunSnapping(unsigned int viewers)
+{
+    const float        light[3] = { -1.0f, -2.0f, 0.5f };
+    const float        point[3] = { 3.3f, 0.7f, -1.9f };    // a static caster
+    const unsigned int resolution = 1024;
+
+    ShadowCascadeViewer viewer;
+    viewer.m_Position[0] = 0.0f; viewer.m_Position[1] = 2.0f; viewer.m_Position[2] = 0.0f;
+    viewer.m_Direction[0] = 1.0f; viewer.m_Direction[1] = 0.0f; viewer.m_Direction[2] = 0.0f;
+    viewer.m_Fov = PI / 4.0f;
+    viewer.m_Aspect = 16.0f / 9.0f;
+
+    float firstFraction[2] = { 0.0f, 0.0f };
+    float worstFraction = 0.0f;     // change of the position of the caster within its texel
+    float worstOutside = 0.0f;      // sphere beyond the clip space of the cascade
+    float worstWidth = 0.0f;
+
+    ShadowCascade first = ShadowCascade();
+    for (unsigned int i = 0; i < viewers; i++)
+    {
+        // a walk and a look around
+        viewer.m_Position[0] += Random(-0.1f, 0.1f);
+        viewer.m_Position[2] += Random(-0.1f, 0.1f);
+        viewer.m_Direction[0] = cosf(0.01f * (float)i);
+        viewer.m_Direction[2] = sinf(0.01f * (float)i);
+
+        ShadowCascade cascade;
+        PlaceShadowCascade(FitShadowCascadeSphere(viewer, 1.0f, 10.0f), light, resolution, 25.0f, &cascade);
+        if (i == 0)
+        {
+            first = cascade;
+        }
+        worstWidth = fmaxf(worstWidth, fabsf(cascade.m_Width - first.m_Width));
+
+        float clip[3];
+        Project(cascade, point, clip);
+        for (int axis = 0; axis < 2; axis++)
+        {
+            const float texel = (clip[axis] * 0.5f + 0.5f) * (float)resolution;
+            const float fraction = texel - floorf(texel);
+            if (i == 0)
+            {
+                firstFraction[axis] = fraction;
+            }
+            const float change = fabsf(fraction - firstFraction[axis]);
+            worstFraction = fmaxf(worstFraction, fminf(change, 1.0f - change));
+        }
+
+        // the 6 extreme points of the sphere along the light space axes
+        for (int axis = 0; axis < 3; axis++)
+        {
+            for (float side = -1.0f; side <= 1.0f; side += 2.0f)
+            {
+                float p[3] = { cascade.m_Sphere.m_Center[0], cascade.m_Sphere.m_Center[1], cascade.m_Sphere.m_Center[2] };
+                for (int j = 0; j < 3; j++)
+                {
+                    // the light space axis is a column of the view matrix
+                    p[j] += side * cascade.m_Sphere.m_Radius * cascade.m_View[j * 4 + axis];
+                }
+                Project(cascade, p, clip);
+                worstOutside = fmaxf(worstOutside, fmaxf(fabsf(clip[0]), fabsf(clip[1])) - 1.0f);
+                worstOutside = fmaxf(worstOutside, fmaxf(-clip[2], clip[2] - 1.0f));
+            }
+        }
+    }
+
+    Check(worstWidth == 0.0f, "same texel size for the whole walk", worstWidth);
+    Check(worstFraction < 0.01f, "caster stays at the same place in its texel", worstFraction);
+    Check(worstOutside <= 1e-5f, "sphere inside the cascade", worstOutside);
+
+    // without the snapping, the fraction would wander
+    ShadowCascade moved;
+    ShadowCascadeSphere sphere = first.m_Sphere;
+    sphere.m_Center[0] += 0.3f * first.m_Width / (float)resolution;
+    PlaceShadowCascade(sphere, light, resolution, 25.0f, &moved);
+    float a[3], b[3];
+    Project(first, point, a);
+    Project(moved, point, b);
+    const float shift = (a[0] - b[0]) * 0.5f * (float)resolution;
+    Check(fabsf(shift - floorf(shift + 0.5f)) < 0.01f, "sub texel move is snapped to whole texels", shift);
+}
+
+static void RunIntervals()
+{
+    ShadowCascadeViewer viewer;
+    viewer.m_Position[0] = 0.0f; viewer.m_Position[1] = 2.0f; viewer.m_Position[2] = 0.0f;
+    viewer.m_Direction[0] = 0.0f; viewer.m_Direction[1] = 0.0f; viewer.m_Direction[2] = 1.0f;
+    viewer.m_Fov = PI / 4.0f;
+    viewer.m_Aspect = 1.5f;
+
+    const float        light[3] = { -1.0f, -1.0f, -1.0f };
+    const unsigned int intervals[4] = { 1, 2, 4, 8 };
+    unsigned int       resolution[4] = { 1024, 1024, 1024, 1024 };
+
+    for (unsigned int gpuCount = 1; gpuCount <= 2; gpuCount++)
+    {
+        ShadowCascades cascades;
+        cascades.Init(4, gpuCount);
+        for (unsigned int i = 0; i < 4; i++)
+        {
+            cascades.SetUpdateInterval(i, intervals[i]);
+        }
+
+        unsigned int list[SHADOW_CASCADE_MAX_COUNT];
+        unsigned int rendered[4] = {};
+        unsigned int fits[4] = {};
+        unsigned int lastFrame[4] = {};
+        unsigned int expected = 0;      // renders of interval / gpuCount fits, 1 per frame at most
+        bool         stale = false;     // a cascade whose view changed without a render on some GPU
+
+        // the first frame fits everything, the checks start once the cascades follow their intervals
+        unsigned int count = 0;
+        for (unsigned int frame = 1; frame <= 8; frame++)
+        {
+            count = cascades.Update(viewer, light, resolution, frame, list);
+        }
+        for (unsigned int i = 0; i < 4; i++)
+        {
+            lastFrame[i] = cascades.GetCascade(i).m_Frame;
+        }
+
+        const unsigned int frames = 64;
+        for (unsigned int frame = 9; frame < 9 + frames; frame++)
+        {
+            viewer.m_Position[2] += 0.05f;
+
+            count = cascades.Update(viewer, light, resolution, frame, list);
+
+            for (unsigned int i = 0; i < count; i++)
+            {
+                rendered[list[i]]++;
+            }
+            for (unsigned int i = 0; i < 4; i++)
+            {
+                if (cascades.GetCascade(i).m_Frame != lastFrame[i])
+                {
+                    fits[i]++;
+                    lastFrame[i] = cascades.GetCascade(i).m_Frame;
+                }
+
+                // in AFR frame f runs on GPU f % gpuCount: the frames since the last fit, up
+                // to the gpuCount - 1 previous ones, all have to render the cascade
+                const unsigned int age = frame - cascades.GetCascade(i).m_Frame;
+                bool listed = false;
+                for (unsigned int j = 0; j < count; j++)
+                {
+                    listed = listed || list[j] == i;
+                }
+                stale = stale || (age < gpuCount && listed == false);
+            }
+        }
+
+        for (unsigned int i = 0; i < 4; i++)
+        {
+            expected += intervals[i] <= gpuCount ? frames : frames / intervals[i] * gpuCount;
+        }
+
+        char name[64];
+        sprintf(name, "%u GPU: far cascade fits every 8 frames", gpuCount);
+        Check(fits[3] == frames / 8, name, (float)fits[3]);
+        sprintf(name, "%u GPU: near cascade fits every frame", gpuCount);
+        Check(fits[0] == frames, name, (float)fits[0]);
+        sprintf(name, "%u GPU: every fit rendered on every GPU", gpuCount);
+        Check(stale == false, name, (float)rendered[3]);
+        sprintf(name, "%u GPU: cascades rendered per frame", gpuCount);
+        Check(rendered[0] + rendered[1] + rendered[2] + rendered[3] == expected, name,
+              (float)(rendered[0] + rendered[1] + rendered[2] + rendered[3]) / (float)frames);
+    }
+
+    // a new region size is a new texel grid
+    ShadowCascades cascades;
+    cascades.Init(2, 1);
+    cascades.SetUpdateInterval(1, 100);
+    unsigned int list[SHADOW_CASCADE_MAX_COUNT];
+    cascades.Update(viewer, light, resolution, 1, list);
+    resolution[1] = 512;
+    const unsigned int count = cascades.Update(viewer, light, resolution, 2, list);
+    Check(count == 2 && cascades.GetCascade(1).m_Resolution == 512, "resolution change fits again", (float)count);
+}
+
+static void RunTiming()
+{
+    ShadowCascades cascades;
+    cascades.Init(SHADOW_CASCADE_MAX_COUNT, 2);
+
+    const float        light[3] = { -1.0f, -1.0f, -1.0f };
+    const unsigned int resolution[SHADOW_CASCADE_MAX_COUNT] = { 1024, 1024, 1024, 1024, 1024, 1024 };
+    unsigned int       list[SHADOW_CASCADE_MAX_COUNT];
+    unsigned int       total = 0;
+
+    const unsigned int frames = 100000;
+    const std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+    for (unsigned int frame = 0; frame < frames; frame++)
+    {
+        const ShadowCascadeViewer viewer = RandomViewer();
+        total += cascades.Update(viewer, light, resolution, frame, list);
+    }
+    const double us = std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - start).count() / frames;
+
+    printf("%-48s %10.4f\n", "Update() of 6 cascades (us)", us);
+    Check(total == frames * SHADOW_CASCADE_MAX_COUNT, "every cascade every frame at interval 1", (float)total / (float)frames);
+}
+
+int main(int argc, char * argv[])
+{
+    unsigned int viewers = 10000;
+
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if      (strcmp(argv[i], "--viewers") == 0) { viewers = (unsigned int)atoi(argv[i + 1]); }
+        else if (strcmp(argv[i], "--seed") == 0)    { g_RandomState = (unsigned int)atoi(argv[i + 1]); }
+        else
+        {
+            printf("usage: ShadowCascades [--viewers N] [--seed N]\n");
+            return 1;
+        }
+    }
+
+    if (g_RandomState == 0)
+    {
+        fprintf(stderr, "--seed must be positive\n");
+        return 1;
+    }
+
+    RunSplits();
+    RunSpheres(viewers);
+    RunSnapping(viewers);
+    RunIntervals();
+    RunTiming();
+
+    printf("%s\n", g_Failures == 0 ? "PASS" : "FAIL");
+    return g_Failures == 0 ? 0 : 1;
+}
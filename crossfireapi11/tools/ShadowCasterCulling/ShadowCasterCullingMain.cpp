@@ -0,0 +1,341 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: ShadowCasterCullingMain.cpp
+//
+// CPU checks of the shadow caster culling: known casters against the cube faces of a
+// point light, and the SSE path against the scalar reference on random casters inside
+// a face, outside every face, straddling two faces and with degenerate (flat, line,
+// point) extents, for every face count. The two paths do the same operations in the
+// same order, so their masks must be equal, not close. Exits nonzero if a check fails.
+//
+// Build (any C++11 compiler, no Windows/D3D11/AGS dependency):
+//     g++ -std=c++11 -O2 -I../../src ShadowCasterCullingMain.cpp ../../src/ShadowCasterCulling.cpp -o ShadowCasterCulling
+//     cl /EHsc /O2 /I..\..\src ShadowCasterCullingMain.cpp ..\..\src\ShadowCasterCulling.cpp
+//
+// Usage:
+//     ShadowCasterCulling [--casters N] [--seed N]
+//--------------------------------------------------------------------------------------
+#include "ShadowCasterCulling.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+
+using namespace AMD;
+
+static const unsigned int FACE_COUNT = SHADOW_CASTER_CULLING_MAX_FACE_COUNT;
+static const float        LIGHT[3] = { 3.0f, -1.0f, 2.0f };
+static const float        NEAR_PLANE = 0.1f;
+static const float        FAR_PLANE = 20.0f;
+
+// Faces 0 to 5 are the +x, -x, +y, -y, +z, -z faces of a point light at LIGHT, the
+// layout of the sample's cube map; faces 6 and 7 are the +x and -x faces again with half
+// the range, so that the padding lanes and the faces past 6 are covered too. A point p is
+// inside face (axis, sign) where sign * p[axis] lies in [near, far] and is at least
+// |p[other axis]| for both other axes, relative to the light. The planes are written
+// unnormalized, the way ExtractPlanesFromFrustum leaves them.
+static void MakeFacePlanes(float planes[FACE_COUNT][6][4])
+{
+    for (unsigned int face = 0; face < FACE_COUNT; face++)
+    {
+        const int   axis = (face % 6) / 2;
+        const float sign = (face % 2) == 0 ? 1.0f : -1.0f;
+        const float range = face < 6 ? FAR_PLANE : FAR_PLANE * 0.5f;
+
+        for (int plane = 0; plane < 6; plane++)
+        {
+            float * p = planes[face][plane];
+            p[0] = p[1] = p[2] = 0.0f;
+
+            if (plane < 4)
+            {
+                // sign * p[axis] - (+-p[other]) >= 0
+                const int other = (axis + 1 + plane / 2) % 3;
+                p[axis] = sign;
+                p[other] = (plane % 2) == 0 ? -1.0f : 1.0f;
+            }
+            else
+            {
+                // near: sign * p[axis] - near >= 0, far: far - sign * p[axis] >= 0
+                p[axis] = plane == 4 ? sign : -sign;
+            }
+
+            // move the planes from the light to the world origin
+            const float offset = plane == 4 ? -NEAR_PLANE : (plane == 5 ? range : 0.0f);
+            p[3] = offset - (p[0] * LIGHT[0] + p[1] * LIGHT[1] + p[2] * LIGHT[2]);
+        }
+    }
+}
+
+static ShadowCasterBounds MakeBounds(float x, float y, float z, float ex, float ey, float ez)
+{
+    const ShadowCasterBounds bounds = {{ LIGHT[0] + x, LIGHT[1] + y, LIGHT[2] + z }, { ex, ey, ez }};
+    return bounds;
+}
+
+// xorshift32, so every platform checks the same casters
+static unsigned int g_RandomState = 1;
+
+static float Random(float minValue, float maxValue)
+{
+    g_RandomState ^= g_RandomState << 13;
+    g_RandomState ^= g_RandomState >> 17;
+    g_RandomState ^= g_RandomState << 5;
+    return minValue + (maxValue - minValue) * (float)(g_RandomState & 0xffffff) / (float)0xffffff;
+}
+
+static int g_Failures = 0;
+
+static void Check(bool condition, const char * name, float value)
+{
+    printf("%-48s %10.4g %s\n", name, value, condition ? "ok" : "FAIL");
+    g_Failures += condition ? 0 : 1;
+}
+
+static unsigned int CullOne(const ShadowCasterCuller & culler, const ShadowCasterBounds & bounds)
+{
+    unsigned int simd = 0, reference = 0;
+    culler.Cull(&bounds, 1, &simd);
+    culler.CullReference(&bounds, 1, &reference);
+    return simd == reference ? simd : 0xffffffff;
+}
+
+//--------------------------------------------------------------------------------------
+// Known casters
+//--------------------------------------------------------------------------------------
+static void RunKnownCasters(const ShadowCasterCuller & culler)
+{
+    unsigned int mask = CullOne(culler, MakeBounds(5.0f, 0.5f, -0.5f, 0.5f, 0.5f, 0.5f));
+    Check(mask == 0x41, "box on the +x axis: +x faces", (float)mask);
+
+    mask = CullOne(culler, MakeBounds(0.0f, 0.0f, -15.0f, 1.0f, 1.0f, 1.0f));
+    Check(mask == 0x20, "box on the -z axis past the short faces", (float)mask);
+
+    mask = CullOne(culler, MakeBounds(25.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f));
+    Check(mask == 0, "box past the far plane", (float)mask);
+
+    mask = CullOne(culler, MakeBounds(0.0f, 0.0f, 0.0f, 0.05f, 0.05f, 0.05f));
+    Check(mask == 0, "box inside the near planes", (float)mask);
+
+    mask = CullOne(culler, MakeBounds(4.0f, 4.0f, 0.0f, 0.5f, 0.5f, 0.5f));
+    Check(mask == 0x45, "box on the +x/+y edge", (float)mask);
+
+    mask = CullOne(culler, MakeBounds(0.0f, 0.0f, 0.0f, 2.0f, 2.0f, 2.0f));
+    Check(mask == 0xff, "box around the light", (float)mask);
+
+    mask = CullOne(culler, MakeBounds(0.0f, 0.0f, 0.0f, 100.0f, 100.0f, 100.0f));
+    Check(mask == 0xff, "box around the whole scene", (float)mask);
+
+    // a point exactly on a plane is inside, both of the faces it separates keep it
+    mask = CullOne(culler, MakeBounds(0.0f, -6.0f, 6.0f, 0.0f, 0.0f, 0.0f));
+    Check(mask == 0x18, "point on the -y/+z edge", (float)mask);
+
+    mask = CullOne(culler, MakeBounds(0.0f, 8.0f, 1.0f, 0.0f, 0.0f, 0.0f));
+    Check(mask == 0x04, "point inside +y", (float)mask);
+
+    mask = CullOne(culler, MakeBounds(-8.0f, 1.0f, 0.0f, 0.0f, 3.0f, 3.0f));
+    Check(mask == 0x82, "flat box inside -x", (float)mask);
+
+    mask = CullOne(culler, MakeBounds(6.0f, 6.0f, 6.0f, 0.0f, 0.0f, 10.0f));
+    Check(mask == 0x55, "line through +x, +y and +z", (float)mask);
+
+    ShadowCasterCuller none;
+    mask = 0x1234;
+    none.Cull(NULL, 1, &mask);
+    Check(mask == 0x1234, "no casters leaves the masks alone", (float)mask);
+
+    const ShadowCasterBounds bounds = MakeBounds(5.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f);
+    none.Cull(&bounds, 1, &mask);
+    Check(mask == 0, "no faces: empty mask", (float)mask);
+}
+
+//--------------------------------------------------------------------------------------
+// Random casters: every face count, SSE == reference
+//--------------------------------------------------------------------------------------
+enum CasterKind
+{
+    CASTER_INSIDE,                          // well inside one of the 6 long faces
+    CASTER_OUTSIDE,                         // past the far plane of every face
+    CASTER_STRADDLING,                      // centered on the edge between two faces
+    CASTER_DEGENERATE,                      // zero extent along 1, 2 or 3 axes
+    CASTER_KIND_COUNT
+};
+
+static const char * const g_KindNames[CASTER_KIND_COUNT] = { "inside", "outside", "straddling", "degenerate" };
+
+// the face the caster is expected in (inside) or the first of the two (straddling)
+static ShadowCasterBounds MakeRandomCaster(CasterKind kind, unsigned int & face, unsigned int & otherFace)
+{
+    float center[3] = { Random(-FAR_PLANE, FAR_PLANE), Random(-FAR_PLANE, FAR_PLANE), Random(-FAR_PLANE, FAR_PLANE) };
+    float extents[3] = { Random(0.0f, 2.0f), Random(0.0f, 2.0f), Random(0.0f, 2.0f) };
+
+    face = (unsigned int)Random(0.0f, 5.999f);
+    const int   axis = face / 2;
+    const float sign = (face % 2) == 0 ? 1.0f : -1.0f;
+
+    if (kind == CASTER_INSIDE)
+    {
+        // at least 2 units from the side planes and 1 from the near and far planes
+        const float depth = Random(4.0f, FAR_PLANE - 2.0f);
+        center[axis] = sign * depth;
+        center[(axis + 1) % 3] = Random(-(depth - 2.0f), depth - 2.0f);
+        center[(axis + 2) % 3] = Random(-(depth - 2.0f), depth - 2.0f);
+        for (int c = 0; c < 3; c++) { extents[c] = Random(0.0f, 0.9f); }
+    }
+    else if (kind == CASTER_OUTSIDE)
+    {
+        center[axis] = sign * Random(FAR_PLANE + 3.0f, FAR_PLANE * 3.0f);
+    }
+    else if (kind == CASTER_STRADDLING)
+    {
+        // on the plane between face and a face of the next axis, inside both ranges
+        const int   other = (axis + 1) % 3;
+        const float otherSign = Random(-1.0f, 1.0f) < 0.0f ? -1.0f : 1.0f;
+        const float depth = Random(4.0f, FAR_PLANE - 2.0f);
+        otherFace = other * 2 + (otherSign > 0.0f ? 0 : 1);
+        center[axis] = sign * depth;
+        center[other] = otherSign * depth;
+        center[(axis + 2) % 3] = Random(-(depth - 2.0f), depth - 2.0f);
+        for (int c = 0; c < 3; c++) { extents[c] = Random(0.1f, 0.9f); }
+    }
+    else
+    {
+        // 1 flat, 2 line, 3 point
+        const int zeroCount = 1 + (int)Random(0.0f, 2.999f);
+        for (int c = 0; c < zeroCount; c++) { extents[(axis + c) % 3] = 0.0f; }
+    }
+
+    return MakeBounds(center[0], center[1], center[2], extents[0], extents[1], extents[2]);
+}
+
+static void RunRandomCasters(const float * pPlanes, unsigned int casterCount)
+{
+    std::vector<ShadowCasterBounds> casters(casterCount);
+    std::vector<unsigned int>       kinds(casterCount);
+    std::vector<unsigned int>       faces(casterCount), otherFaces(casterCount);
+
+    for (unsigned int i = 0; i < casterCount; i++)
+    {
+        kinds[i] = i % CASTER_KIND_COUNT;
+        casters[i] = MakeRandomCaster((CasterKind)kinds[i], faces[i], otherFaces[i]);
+    }
+
+    std::vector<unsigned int> simd(casterCount), reference(casterCount);
+    unsigned int              expectedMisses[CASTER_KIND_COUNT] = {};
+    unsigned int              culled[CASTER_KIND_COUNT] = {};
+    unsigned int              mismatches = 0, overflows = 0;
+    double                    simdSeconds = 0.0, referenceSeconds = 0.0;
+
+    for (unsigned int faceCount = 1; faceCount <= FACE_COUNT; faceCount++)
+    {
+        ShadowCasterCuller culler;
+        culler.SetFaces(pPlanes, faceCount);
+
+        std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+        culler.Cull(&casters[0], casterCount, &simd[0]);
+        simdSeconds += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+        start = std::chrono::high_resolution_clock::now();
+        culler.CullReference(&casters[0], casterCount, &reference[0]);
+        referenceSeconds += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+        const unsigned int allFaces = (1u << faceCount) - 1;
+
+        for (unsigned int i = 0; i < casterCount; i++)
+        {
+            mismatches += simd[i] != reference[i] ? 1 : 0;
+            overflows += (simd[i] & ~allFaces) != 0 ? 1 : 0;
+
+            // the faces every kind has to keep, or drop
+            const unsigned int face = 1u << faces[i];
+            const unsigned int otherFace = 1u << otherFaces[i];
+            bool               expected = true;
+            switch (kinds[i])
+            {
+            case CASTER_INSIDE:     expected = (simd[i] & face & allFaces) == (face & allFaces); break;
+            case CASTER_OUTSIDE:    expected = simd[i] == 0; break;
+            case CASTER_STRADDLING: expected = (simd[i] & (face | otherFace) & allFaces) == ((face | otherFace) & allFaces); break;
+            default:                break;
+            }
+
+            expectedMisses[kinds[i]] += expected ? 0 : 1;
+            culled[kinds[i]] += simd[i] == 0 ? 1 : 0;
+        }
+    }
+
+    Check(mismatches == 0, "sse == reference, different masks", (float)mismatches);
+    Check(overflows == 0, "masks within the face count", (float)overflows);
+
+    for (unsigned int kind = 0; kind < CASTER_KIND_COUNT; kind++)
+    {
+        char name[64];
+        sprintf(name, "%s casters with a wrong mask", g_KindNames[kind]);
+        Check(expectedMisses[kind] == 0, name, (float)expectedMisses[kind]);
+    }
+
+    // the degenerate casters are spread over the whole range, some have to fall in no face
+    Check(culled[CASTER_DEGENERATE] > 0 && culled[CASTER_DEGENERATE] < FACE_COUNT * (casterCount / CASTER_KIND_COUNT),
+        "degenerate casters culled", (float)culled[CASTER_DEGENERATE]);
+
+    const double count = (double)casterCount * FACE_COUNT;
+    printf("%u casters x %u face counts, %.2f ns/caster sse, %.2f ns/caster reference\n",
+        casterCount, FACE_COUNT, simdSeconds * 1.0e9 / count, referenceSeconds * 1.0e9 / count);
+}
+
+int main(int argc, char * argv[])
+{
+    unsigned int casterCount = 10000;
+
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if      (strcmp(argv[i], "--casters") == 0) { casterCount = (unsigned int)atoi(argv[i + 1]); }
+        else if (strcmp(argv[i], "--seed") == 0)    { g_RandomState = (unsigned int)atoi(argv[i + 1]); }
+        else
+        {
+            printf("usage: ShadowCasterCulling [--casters N] [--seed N]\n");
+            return 1;
+        }
+    }
+
+    if (casterCount < CASTER_KIND_COUNT || g_RandomState == 0)
+    {
+        fprintf(stderr, "--casters must be at least %u and --seed positive\n", (unsigned int)CASTER_KIND_COUNT);
+        return 1;
+    }
+
+    float planes[FACE_COUNT][6][4];
+    MakeFacePlanes(planes);
+
+    ShadowCasterCuller culler;
+    culler.SetFaces(&planes[0][0][0], FACE_COUNT);
+
+    RunKnownCasters(culler);
+    RunRandomCasters(&planes[0][0][0], casterCount);
+
+    printf("%s\n", g_Failures == 0 ? "PASS" : "FAIL");
+    return g_Failures == 0 ? 0 : 1;
+}
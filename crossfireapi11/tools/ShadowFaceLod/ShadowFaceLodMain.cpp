@@ -0,0 +1,352 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: ShadowFaceLodMain.cpp
+//
+// CPU checks of the shadow face screen coverage and resolution LOD: known viewer and
+// face frustums, the SSE path against the scalar reference on random cube cameras, the
+// LOD hysteresis, and the cost of a coverage query. Exits nonzero if a check fails.
+//
+// Build (any C++11 compiler, no Windows/D3D11/AGS dependency):
+//     g++ -std=c++11 -O2 -I../../src ShadowFaceLodMain.cpp ../../src/ShadowFaceLod.cpp -o ShadowFaceLod
+//     cl /EHsc /O2 /I..\..\src ShadowFaceLodMain.cpp ..\..\src\ShadowFaceLod.cpp
+//
+// Usage:
+//     ShadowFaceLod [--grid N] [--cameras N] [--seed N]
+//--------------------------------------------------------------------------------------
+#include "ShadowFaceLod.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+using namespace AMD;
+
+static const float PI = 3.14159265f;
+
+// row major, row vectors (D3D convention)
+struct Matrix
+{
+    float m[16];
+};
+
+static Matrix Multiply(const Matrix & a, const Matrix & b)
+{
+    Matrix r;
+    for (int row = 0; row < 4; row++)
+    {
+        for (int col = 0; col < 4; col++)
+        {
+            r.m[row * 4 + col] = a.m[row * 4 + 0] * b.m[0 + col] + a.m[row * 4 + 1] * b.m[4 + col] +
+                                 a.m[row * 4 + 2] * b.m[8 + col] + a.m[row * 4 + 3] * b.m[12 + col];
+        }
+    }
+    return r;
+}
+
+// Gauss-Jordan with partial pivoting
+static Matrix Inverse(const Matrix & a)
+{
+    float work[4][8];
+    for (int row = 0; row < 4; row++)
+    {
+        for (int col = 0; col < 4; col++)
+        {
+            work[row][col] = a.m[row * 4 + col];
+            work[row][col + 4] = row == col ? 1.0f : 0.0f;
+        }
+    }
+
+    for (int col = 0; col < 4; col++)
+    {
+        int pivot = col;
+        for (int row = col + 1; row < 4; row++)
+        {
+            if (fabsf(work[row][col]) > fabsf(work[pivot][col])) { pivot = row; }
+        }
+        for (int i = 0; i < 8; i++)
+        {
+            const float t = work[col][i]; work[col][i] = work[pivot][i]; work[pivot][i] = t;
+        }
+
+        const float scale = 1.0f / work[col][col];
+        for (int i = 0; i < 8; i++) { work[col][i] *= scale; }
+
+        for (int row = 0; row < 4; row++)
+        {
+            if (row == col) { continue; }
+            const float factor = work[row][col];
+            for (int i = 0; i < 8; i++) { work[row][i] -= factor * work[col][i]; }
+        }
+    }
+
+    Matrix r;
+    for (int row = 0; row < 4; row++)
+    {
+        for (int col = 0; col < 4; col++) { r.m[row * 4 + col] = work[row][col + 4]; }
+    }
+    return r;
+}
+
+static void Normalize(float v[3])
+{
+    const float length = sqrtf(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+    v[0] /= length; v[1] /= length; v[2] /= length;
+}
+
+static void Cross(const float a[3], const float b[3], float r[3])
+{
+    r[0] = a[1] * b[2] - a[2] * b[1];
+    r[1] = a[2] * b[0] - a[0] * b[2];
+    r[2] = a[0] * b[1] - a[1] * b[0];
+}
+
+// XMMatrixLookToLH
+static Matrix LookTo(const float eye[3], const float direction[3], const float up[3])
+{
+    float f[3] = { direction[0], direction[1], direction[2] };
+    Normalize(f);
+    float r[3];
+    Cross(up, f, r);
+    Normalize(r);
+    float u[3];
+    Cross(f, r, u);
+
+    const Matrix view =
+    {{
+        r[0], u[0], f[0], 0.0f,
+        r[1], u[1], f[1], 0.0f,
+        r[2], u[2], f[2], 0.0f,
+        -(r[0] * eye[0] + r[1] * eye[1] + r[2] * eye[2]),
+        -(u[0] * eye[0] + u[1] * eye[1] + u[2] * eye[2]),
+        -(f[0] * eye[0] + f[1] * eye[1] + f[2] * eye[2]), 1.0f
+    }};
+    return view;
+}
+
+// XMMatrixPerspectiveFovLH
+static Matrix Perspective(float fovY, float aspect, float zNear, float zFar)
+{
+    const float yScale = 1.0f / tanf(fovY * 0.5f);
+    const float xScale = yScale / aspect;
+    const float range = zFar / (zFar - zNear);
+
+    const Matrix projection =
+    {{
+        xScale, 0.0f,   0.0f,            0.0f,
+        0.0f,   yScale, 0.0f,            0.0f,
+        0.0f,   0.0f,   range,           1.0f,
+        0.0f,   0.0f,   -range * zNear,  0.0f
+    }};
+    return projection;
+}
+
+// what AMD::ExtractPlanesFromFrustum(planes, &viewProjection, false) returns; the amd_sdk
+// version needs DirectXMath, which isn't there on every platform this tool builds on
+static void ExtractPlanes(const Matrix & viewProjection, float planes[6][4])
+{
+    const float * m = viewProjection.m;
+    for (int i = 0; i < 4; i++)
+    {
+        const float column1 = m[i * 4 + 0], column2 = m[i * 4 + 1], column3 = m[i * 4 + 2], column4 = m[i * 4 + 3];
+        planes[0][i] = column4 + column1;   // left
+        planes[1][i] = column4 - column1;   // right
+        planes[2][i] = column4 - column2;   // top
+        planes[3][i] = column4 + column2;   // bottom
+        planes[4][i] = column3;             // near
+        planes[5][i] = column4 - column3;   // far
+    }
+}
+
+struct Camera
+{
+    Matrix m_ViewProjection;
+    Matrix m_ViewProjectionInv;
+};
+
+static Camera MakeCamera(const float eye[3], const float direction[3], float fovY, float aspect, float zNear, float zFar)
+{
+    const float up[3] = { 0.0f, 1.0f, 0.0f };
+    const float alternateUp[3] = { 0.0f, 0.0f, 1.0f };
+    const bool  vertical = fabsf(direction[1]) > 0.99f * sqrtf(direction[0] * direction[0] + direction[1] * direction[1] + direction[2] * direction[2]);
+
+    Camera camera;
+    camera.m_ViewProjection = Multiply(LookTo(eye, direction, vertical ? alternateUp : up), Perspective(fovY, aspect, zNear, zFar));
+    camera.m_ViewProjectionInv = Inverse(camera.m_ViewProjection);
+    return camera;
+}
+
+// xorshift32, so every platform checks the same cameras
+static unsigned int g_RandomState = 1;
+
+static float Random(float minValue, float maxValue)
+{
+    g_RandomState ^= g_RandomState << 13;
+    g_RandomState ^= g_RandomState >> 17;
+    g_RandomState ^= g_RandomState << 5;
+    return minValue + (maxValue - minValue) * (float)(g_RandomState & 0xffffff) / (float)0xffffff;
+}
+
+static int g_Failures = 0;
+
+static void Check(bool condition, const char * name, float value)
+{
+    printf("%-48s %10.4f %s\n", name, value, condition ? "ok" : "FAIL");
+    g_Failures += condition ? 0 : 1;
+}
+
+static void RunKnownFrustums(unsigned int gridSize)
+{
+    const float origin[3] = { 0.0f, 0.0f, 0.0f };
+    const float forward[3] = { 0.0f, 0.0f, 1.0f };
+    const float backward[3] = { 0.0f, 0.0f, -1.0f };
+    const float right[3] = { 1.0f, 0.0f, 0.0f };
+
+    const Camera viewer = MakeCamera(origin, forward, PI / 2.0f, 1.0f, 0.1f, 100.0f);
+    float planes[6][4];
+    ExtractPlanes(viewer.m_ViewProjection, planes);
+
+    // the face samples cell centers, so its own frustum covers (1 - 1/grid)^2 of the screen
+    const float expected = (1.0f - 1.0f / gridSize) * (1.0f - 1.0f / gridSize);
+    const float same = GetShadowFaceCoverage(MakeCamera(origin, forward, PI / 2.0f, 1.0f, 0.1f, 100.0f).m_ViewProjectionInv.m, &planes[0][0], gridSize);
+    Check(fabsf(same - expected) < 0.01f, "face == viewer frustum", same);
+
+    const float behind = GetShadowFaceCoverage(MakeCamera(origin, backward, PI / 2.0f, 1.0f, 0.1f, 100.0f).m_ViewProjectionInv.m, &planes[0][0], gridSize);
+    Check(behind == 0.0f, "face behind the viewer", behind);
+
+    // a light 10 units ahead, its +x face only sees the right part of the screen
+    const float light[3] = { 0.0f, 0.0f, 10.0f };
+    const float side = GetShadowFaceCoverage(MakeCamera(light, right, PI / 2.0f, 1.0f, 0.1f, 5.0f).m_ViewProjectionInv.m, &planes[0][0], gridSize);
+    Check(side > 0.0f && side < 0.5f, "side face of a light ahead", side);
+
+    // the same face, further away covers less
+    const float farLight[3] = { 0.0f, 0.0f, 40.0f };
+    const float farSide = GetShadowFaceCoverage(MakeCamera(farLight, right, PI / 2.0f, 1.0f, 0.1f, 5.0f).m_ViewProjectionInv.m, &planes[0][0], gridSize);
+    Check(farSide > 0.0f && farSide < side, "same face 4x further", farSide);
+}
+
+static void RunRandomCameras(unsigned int gridSize, unsigned int cameraCount)
+{
+    static const float faceDirections[6][3] =
+    {
+        { 1.0f, 0.0f, 0.0f }, { -1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f },
+        { 0.0f, -1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f }, { 0.0f, 0.0f, -1.0f },
+    };
+
+    const unsigned int faceCount = cameraCount * 6;
+    float              worstError = 0.0f;
+    unsigned int       covered = 0;
+    double             simdSeconds = 0.0, referenceSeconds = 0.0;
+
+    for (unsigned int i = 0; i < cameraCount; i++)
+    {
+        const float eye[3] = { Random(-5.0f, 5.0f), Random(-5.0f, 5.0f), Random(-5.0f, 5.0f) };
+        float       direction[3] = { Random(-1.0f, 1.0f), Random(-1.0f, 1.0f), Random(-1.0f, 1.0f) };
+        if (fabsf(direction[0]) + fabsf(direction[1]) + fabsf(direction[2]) < 0.1f) { direction[2] = 1.0f; }
+
+        const Camera viewer = MakeCamera(eye, direction, Random(0.5f, 1.5f), 16.0f / 9.0f, 0.1f, 100.0f);
+        float planes[6][4];
+        ExtractPlanes(viewer.m_ViewProjection, planes);
+
+        const float light[3] = { Random(-20.0f, 20.0f), Random(-5.0f, 5.0f), Random(-20.0f, 20.0f) };
+        for (unsigned int face = 0; face < 6; face++)
+        {
+            const Camera cube = MakeCamera(light, faceDirections[face], PI / 2.0f, 1.0f, 0.1f, Random(5.0f, 50.0f));
+
+            std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+            const float simd = GetShadowFaceCoverage(cube.m_ViewProjectionInv.m, &planes[0][0], gridSize);
+            simdSeconds += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+            start = std::chrono::high_resolution_clock::now();
+            const float reference = GetShadowFaceCoverageReference(cube.m_ViewProjectionInv.m, &planes[0][0], gridSize);
+            referenceSeconds += std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+
+            const float error = fabsf(simd - reference);
+            worstError = error > worstError ? error : worstError;
+            covered += simd > 0.0f ? 1 : 0;
+        }
+    }
+
+    Check(worstError < 1.0e-3f, "sse == reference, worst difference", worstError);
+    printf("%u faces, %u on screen, %.2f us/face sse, %.2f us/face reference\n",
+        faceCount, covered, simdSeconds * 1.0e6 / faceCount, referenceSeconds * 1.0e6 / faceCount);
+}
+
+static void RunLod()
+{
+    ShadowFaceLod lod;
+    lod.Init(1, 128, 1024);
+    lod.SetDownsizeDelay(30);
+
+    Check(lod.GetTargetSize(1920.0f * 1080.0f) == 1024, "target of a full screen face", (float)lod.GetTargetSize(1920.0f * 1080.0f));
+    Check(lod.GetTargetSize(300.0f * 300.0f) == 512, "target of 300x300 pixels", (float)lod.GetTargetSize(300.0f * 300.0f));
+    Check(lod.GetTargetSize(0.0f) == 128, "target of an off screen face", (float)lod.GetTargetSize(0.0f));
+
+    // down after the delay only
+    unsigned int size = 0;
+    for (unsigned int frame = 0; frame < 29; frame++) { size = lod.Update(0, 100.0f); }
+    Check(size == 1024, "smaller target, 29 frames", (float)size);
+    size = lod.Update(0, 100.0f);
+    Check(size == 128, "smaller target, 30 frames", (float)size);
+
+    // up at once
+    size = lod.Update(0, 600.0f * 600.0f);
+    Check(size == 1024, "larger target, 1 frame", (float)size);
+
+    // a face flickering around a boundary keeps its size
+    for (unsigned int frame = 0; frame < 100; frame++) { size = lod.Update(0, frame % 2 == 0 ? 500.0f * 500.0f : 520.0f * 520.0f); }
+    Check(size == 1024, "flickering target", (float)size);
+}
+
+int main(int argc, char * argv[])
+{
+    unsigned int gridSize = 8;
+    unsigned int cameraCount = 1000;
+
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if      (strcmp(argv[i], "--grid") == 0)    { gridSize = (unsigned int)atoi(argv[i + 1]); }
+        else if (strcmp(argv[i], "--cameras") == 0) { cameraCount = (unsigned int)atoi(argv[i + 1]); }
+        else if (strcmp(argv[i], "--seed") == 0)    { g_RandomState = (unsigned int)atoi(argv[i + 1]); }
+        else
+        {
+            printf("usage: ShadowFaceLod [--grid N] [--cameras N] [--seed N]\n");
+            return 1;
+        }
+    }
+
+    if (gridSize == 0 || cameraCount == 0 || g_RandomState == 0)
+    {
+        fprintf(stderr, "--grid, --cameras and --seed must be positive\n");
+        return 1;
+    }
+
+    RunKnownFrustums(gridSize);
+    RunRandomCameras(gridSize, cameraCount);
+    RunLod();
+
+    printf("%s\n", g_Failures == 0 ? "PASS" : "FAIL");
+    return g_Failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,407 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//--------------------------------------------------------------------------------------
+// File: ShadowFaceSchedulerMain.cpp
+//
+// CPU checks of AMD::ShadowFaceScheduler: never rendered faces first, the ranking by
+// visibility and motion and its tie-breaks, the promotion of faces older than MaxAge,
+// the millisecond and the byte budgets each on their own, MinScore, and the same
+// schedule from two schedulers fed the same random inputs. Exits nonzero if a check
+// fails.
+//
+// Build (any C++11 compiler, no Windows/D3D11/AGS dependency):
+//     g++ -std=c++11 -O2 -I../../src ShadowFaceSchedulerMain.cpp ../../src/ShadowFaceScheduler.cpp -o ShadowFaceScheduler
+//     cl /EHsc /O2 /I..\..\src ShadowFaceSchedulerMain.cpp ..\..\src\ShadowFaceScheduler.cpp
+//
+// Usage:
+//     ShadowFaceScheduler [--frames N] [--seed N]
+//--------------------------------------------------------------------------------------
+#include "ShadowFaceScheduler.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+using namespace AMD;
+
+// xorshift32, so every platform checks the same sequence
+static unsigned int g_RandomState = 1;
+
+static unsigned int Random(unsigned int count)
+{
+    g_RandomState ^= g_RandomState << 13;
+    g_RandomState ^= g_RandomState >> 17;
+    g_RandomState ^= g_RandomState << 5;
+    return g_RandomState % count;
+}
+
+static float RandomFloat(float minimum, float maximum)
+{
+    return minimum + (maximum - minimum) * (float)Random(1 << 20) / (float)(1 << 20);
+}
+
+static int g_Failures = 0;
+
+static void Check(bool condition, const char * name, float value)
+{
+    printf("%-48s %10.4g %s\n", name, value, condition ? "ok" : "FAIL");
+    g_Failures += condition ? 0 : 1;
+}
+
+static const unsigned int FACE_COUNT = 6;
+
+// true if the schedule is exactly the faces given, in that order
+static bool IsSchedule(const unsigned int * pFaces, unsigned int count, const unsigned int * pExpected, unsigned int expectedCount)
+{
+    return count == expectedCount && (count == 0 || memcmp(pFaces, pExpected, count * sizeof(unsigned int)) == 0);
+}
+
+// every face rendered once, all in the same frame when MaxFacesPerFrame allows it, so
+// that the faces then only differ by what the test sets
+static void RenderAllFaces(ShadowFaceScheduler & scheduler)
+{
+    unsigned int faces[FACE_COUNT];
+    for (unsigned int rendered = 0; rendered < FACE_COUNT; )
+    {
+        rendered += scheduler.Schedule(faces, FACE_COUNT);
+    }
+}
+
+static void SetAllFaceInputs(ShadowFaceScheduler & scheduler, float visibility, float motion, float costMs, float costBytes)
+{
+    for (unsigned int face = 0; face < FACE_COUNT; face++)
+    {
+        scheduler.SetFaceInputs(face, visibility, motion, costMs, costBytes);
+    }
+}
+
+//--------------------------------------------------------------------------------------
+// Ranking
+//--------------------------------------------------------------------------------------
+static void RunRanking()
+{
+    ShadowFaceSchedulerDesc desc;
+    desc.m_FaceCount = FACE_COUNT;
+    desc.m_MaxFacesPerFrame = FACE_COUNT;
+    desc.m_MinScore = 0.0f;
+    desc.m_MaxAge = 0;
+
+    ShadowFaceScheduler scheduler;
+    scheduler.Init(desc);
+
+    // never rendered faces come first, by index when they tie
+    unsigned int faces[FACE_COUNT];
+    SetAllFaceInputs(scheduler, 0.0f, 0.0f, 0.0f, 0.0f);
+    unsigned int count = scheduler.Schedule(faces, 3);
+    const unsigned int neverRendered[] = { 0, 1, 2 };
+    Check(IsSchedule(faces, count, neverRendered, 3), "ranking: never rendered faces, by index", (float)count);
+
+    // and before a rendered face, whatever its score
+    scheduler.SetFaceInputs(0, 1.0f, 100.0f, 0.0f, 0.0f);
+    count = scheduler.Schedule(faces, 3);
+    const unsigned int neverRenderedFirst[] = { 3, 4, 5 };
+    Check(IsSchedule(faces, count, neverRenderedFirst, 3), "ranking: never rendered faces before any score", (float)count);
+
+    count = scheduler.Schedule(faces, 1);
+    Check(count == 1 && faces[0] == 0, "ranking: then the highest score", (float)faces[0]);
+
+    // every face rendered in the same frame: same age, so equal inputs tie and go by index
+    scheduler.Init(desc);
+    RenderAllFaces(scheduler);
+    SetAllFaceInputs(scheduler, 0.5f, 0.0f, 0.0f, 0.0f);
+    count = scheduler.Schedule(faces, 2);
+    const unsigned int ties[] = { 0, 1 };
+    Check(IsSchedule(faces, count, ties, 2), "ranking: equal scores go to the lower index", (float)count);
+
+    // visibility: the visible faces beat the hidden ones, the more visible first
+    scheduler.Init(desc);
+    RenderAllFaces(scheduler);
+    SetAllFaceInputs(scheduler, 0.0f, 0.0f, 0.0f, 0.0f);
+    scheduler.SetFaceInputs(3, 1.0f, 0.0f, 0.0f, 0.0f);
+    scheduler.SetFaceInputs(5, 0.5f, 0.0f, 0.0f, 0.0f);
+    count = scheduler.Schedule(faces, 2);
+    const unsigned int visible[] = { 3, 5 };
+    Check(IsSchedule(faces, count, visible, 2), "ranking: by visibility", (float)count);
+
+    // motion: a hidden face whose casters moved beats a visible still face
+    scheduler.Init(desc);
+    RenderAllFaces(scheduler);
+    SetAllFaceInputs(scheduler, 0.0f, 0.0f, 0.0f, 0.0f);
+    scheduler.SetFaceInputs(4, 0.0f, 1.0f, 0.0f, 0.0f);
+    scheduler.SetFaceInputs(1, 1.0f, 0.0f, 0.0f, 0.0f);
+    count = scheduler.Schedule(faces, 2);
+    const unsigned int moved[] = { 4, 1 };
+    Check(IsSchedule(faces, count, moved, 2), "ranking: by motion, then visibility", (float)count);
+    Check(scheduler.GetScore(4) > scheduler.GetScore(1) && scheduler.GetScore(1) > scheduler.GetScore(0), "ranking: scores in rank order", scheduler.GetScore(4));
+
+    // motion accumulates until the face is refreshed: 0.15 twice beats 0.2 once
+    desc.m_MinScore = 0.15f;
+    scheduler.Init(desc);
+    RenderAllFaces(scheduler);
+    SetAllFaceInputs(scheduler, 0.0f, 0.0f, 0.0f, 0.0f);
+    scheduler.SetFaceInputs(0, 0.0f, 0.2f, 0.0f, 0.0f);
+    scheduler.SetFaceInputs(2, 0.0f, 0.15f, 0.0f, 0.0f);
+    count = scheduler.Schedule(faces, FACE_COUNT);
+    Check(count == 0, "ranking: motion below MinScore", (float)count);
+
+    SetAllFaceInputs(scheduler, 0.0f, 0.0f, 0.0f, 0.0f);
+    scheduler.SetFaceInputs(2, 0.0f, 0.15f, 0.0f, 0.0f);
+    count = scheduler.Schedule(faces, FACE_COUNT);
+    Check(count == 1 && faces[0] == 2, "ranking: motion accumulates until refreshed", (float)count);
+
+    // the count asked for and MaxFacesPerFrame both limit the schedule
+    desc.m_MinScore = 0.0f;
+    desc.m_MaxFacesPerFrame = 2;
+    scheduler.Init(desc);
+    count = scheduler.Schedule(faces, 1);
+    Check(count == 1, "ranking: limited by the count asked for", (float)count);
+    count = scheduler.Schedule(faces, FACE_COUNT);
+    Check(count == 2, "ranking: limited by MaxFacesPerFrame", (float)count);
+    count = scheduler.Schedule(faces, 0);
+    Check(count == 0, "ranking: nothing asked for", (float)count);
+}
+
+//--------------------------------------------------------------------------------------
+// MaxAge and MinScore
+//--------------------------------------------------------------------------------------
+static void RunMaxAge(unsigned int frames)
+{
+    // a visible moving face would be refreshed every frame; the others are hidden and still
+    ShadowFaceSchedulerDesc desc;
+    desc.m_FaceCount = FACE_COUNT;
+    desc.m_MaxFacesPerFrame = 1;
+    desc.m_MinScore = 0.0f;
+    desc.m_MaxAge = 12;
+
+    ShadowFaceScheduler scheduler;
+    scheduler.Init(desc);
+    RenderAllFaces(scheduler);
+
+    unsigned int promotedMisses = 0, oldest = 0, movingRefreshes = 0;
+    for (unsigned int frame = 0; frame < frames; frame++)
+    {
+        bool due[FACE_COUNT];
+        bool anyDue = false;
+        for (unsigned int face = 0; face < FACE_COUNT; face++)
+        {
+            due[face] = scheduler.GetAge(face) + 1 >= desc.m_MaxAge;
+            anyDue = anyDue || due[face];
+        }
+
+        SetAllFaceInputs(scheduler, 0.0f, 0.0f, 0.0f, 0.0f);
+        scheduler.SetFaceInputs(5, 1.0f, 1.0f, 0.0f, 0.0f);
+
+        unsigned int face;
+        if (scheduler.Schedule(&face, 1) != 1)
+        {
+            promotedMisses++;
+            continue;
+        }
+
+        promotedMisses += anyDue == true && due[face] == false ? 1 : 0;
+        movingRefreshes += face == 5 ? 1 : 0;
+        for (unsigned int i = 0; i < FACE_COUNT; i++)
+        {
+            oldest = scheduler.GetAge(i) > oldest ? scheduler.GetAge(i) : oldest;
+        }
+    }
+    Check(promotedMisses == 0, "max age: a due face beats a higher score", (float)promotedMisses);
+    Check(oldest <= desc.m_MaxAge + FACE_COUNT, "max age: oldest face", (float)oldest);
+    Check(movingRefreshes > frames / 2, "max age: refreshes of the moving face", (float)movingRefreshes / (float)frames);
+
+    // with MinScore above every score only the due faces are refreshed, on the frame they are due
+    desc.m_MaxFacesPerFrame = FACE_COUNT;
+    desc.m_MinScore = 1e9f;
+    scheduler.Init(desc);
+    RenderAllFaces(scheduler);
+
+    unsigned int firstFrame = 0, firstCount = 0;
+    for (unsigned int frame = 1; frame <= 2 * desc.m_MaxAge && firstCount == 0; frame++)
+    {
+        unsigned int faces[FACE_COUNT];
+        SetAllFaceInputs(scheduler, 1.0f, 1.0f, 0.0f, 0.0f);
+        firstCount = scheduler.Schedule(faces, FACE_COUNT);
+        firstFrame = frame;
+    }
+    Check(firstFrame == desc.m_MaxAge && firstCount == FACE_COUNT, "max age: promoted on the frame they are due", (float)firstFrame);
+
+    // without MaxAge a hidden still face below MinScore waits until its age lifts its score
+    desc.m_MaxAge = 0;
+    desc.m_MinScore = 0.1f;
+    scheduler.Init(desc);
+    RenderAllFaces(scheduler);
+
+    unsigned int hiddenRefreshes = 0;
+    for (unsigned int frame = 0; frame < frames; frame++)
+    {
+        unsigned int faces[FACE_COUNT];
+        SetAllFaceInputs(scheduler, 0.0f, 0.0f, 0.0f, 0.0f);
+        hiddenRefreshes += scheduler.Schedule(faces, FACE_COUNT);
+    }
+    // score = HiddenWeight * AgeWeight * age reaches MinScore after 20 frames
+    Check(hiddenRefreshes <= (frames / 20 + 1) * FACE_COUNT, "min score: refreshes per hidden face per frame",
+          (float)hiddenRefreshes / (float)(frames * FACE_COUNT));
+}
+
+//--------------------------------------------------------------------------------------
+// Budgets: equal scores, so the faces come in index order
+//--------------------------------------------------------------------------------------
+static unsigned int ScheduleWithBudget(float budgetMs, float budgetBytes, const float * pCostMs, const float * pCostBytes, unsigned int * pFaces)
+{
+    ShadowFaceSchedulerDesc desc;
+    desc.m_FaceCount = FACE_COUNT;
+    desc.m_MaxFacesPerFrame = FACE_COUNT;
+    desc.m_MinScore = 0.0f;
+    desc.m_MaxAge = 0;
+
+    desc.m_BudgetMs = budgetMs;
+    desc.m_BudgetBytes = budgetBytes;
+
+    ShadowFaceScheduler scheduler;
+    scheduler.Init(desc);
+    RenderAllFaces(scheduler);
+
+    for (unsigned int face = 0; face < FACE_COUNT; face++)
+    {
+        scheduler.SetFaceInputs(face, 1.0f, 0.0f, pCostMs[face], pCostBytes[face]);
+    }
+    return scheduler.Schedule(pFaces, FACE_COUNT);
+}
+
+static void RunBudgets()
+{
+    const float  costs[FACE_COUNT] = { 1.0f, 1.5f, 0.5f, 1.0f, 0.25f, 1.0f };
+    const float  none[FACE_COUNT] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };
+    const float  bytes[FACE_COUNT] = { 1024.0f, 1536.0f, 512.0f, 1024.0f, 256.0f, 1024.0f };
+    unsigned int faces[FACE_COUNT];
+
+    // 1.0, then 1.5 doesn't fit in 2.0 but the cheaper faces after it do
+    unsigned int count = ScheduleWithBudget(2.0f, 0.0f, costs, none, faces);
+    const unsigned int withinMs[] = { 0, 2, 4 };
+    Check(IsSchedule(faces, count, withinMs, 3), "budget: ms", (float)count);
+
+    count = ScheduleWithBudget(2.0f, 0.0f, costs, bytes, faces);
+    Check(IsSchedule(faces, count, withinMs, 3), "budget: ms ignores the bytes", (float)count);
+
+    count = ScheduleWithBudget(0.0f, 2048.0f, none, bytes, faces);
+    Check(IsSchedule(faces, count, withinMs, 3), "budget: bytes", (float)count);
+
+    count = ScheduleWithBudget(0.0f, 2048.0f, costs, bytes, faces);
+    Check(IsSchedule(faces, count, withinMs, 3), "budget: bytes ignore the ms", (float)count);
+
+    // a tight ms budget and a loose byte budget: the ms decide, and the other way around
+    count = ScheduleWithBudget(1.25f, 1e6f, costs, bytes, faces);
+    const unsigned int tightMs[] = { 0, 4 };
+    Check(IsSchedule(faces, count, tightMs, 2), "budget: both, ms is the limit", (float)count);
+
+    count = ScheduleWithBudget(100.0f, 1280.0f, costs, bytes, faces);
+    Check(IsSchedule(faces, count, tightMs, 2), "budget: both, bytes are the limit", (float)count);
+
+    // the first face is refreshed even when it alone is over the budget
+    count = ScheduleWithBudget(0.5f, 0.0f, costs, none, faces);
+    const unsigned int first[] = { 0 };
+    Check(IsSchedule(faces, count, first, 1), "budget: first face over the budget", (float)count);
+
+    count = ScheduleWithBudget(0.0f, 0.0f, costs, bytes, faces);
+    Check(count == FACE_COUNT, "budget: disabled", (float)count);
+}
+
+//--------------------------------------------------------------------------------------
+// Determinism: the same random inputs give the same schedule
+//--------------------------------------------------------------------------------------
+static void RunDeterminism(unsigned int frames)
+{
+    ShadowFaceSchedulerDesc desc;
+    desc.m_FaceCount = 4 * FACE_COUNT;
+    desc.m_MaxFacesPerFrame = 3;
+    desc.m_BudgetMs = 1.5f;
+    desc.m_BudgetBytes = 3.0f * 1024.0f * 1024.0f;
+    desc.m_MaxAge = 30;
+
+    ShadowFaceScheduler a, b;
+    a.Init(desc);
+    b.Init(desc);
+
+    unsigned int differences = 0, overLimit = 0, scheduled = 0;
+    for (unsigned int frame = 0; frame < frames; frame++)
+    {
+        if (frame == frames / 2)
+        {
+            a.Reset();
+            b.Reset();
+        }
+
+        for (unsigned int face = 0; face < desc.m_FaceCount; face++)
+        {
+            // coarse values so that ties happen
+            const float visibility = (float)Random(4) / 3.0f;
+            const float motion = Random(4) == 0 ? RandomFloat(0.0f, 0.1f) : 0.0f;
+            const float costMs = 0.25f * (float)(1 + Random(4));
+            const float costBytes = 512.0f * 1024.0f * (float)(1 + Random(4));
+            a.SetFaceInputs(face, visibility, motion, costMs, costBytes);
+            b.SetFaceInputs(face, visibility, motion, costMs, costBytes);
+        }
+
+        std::vector<unsigned int> facesA(desc.m_FaceCount), facesB(desc.m_FaceCount);
+        const unsigned int        maxFaces = 1 + Random(desc.m_FaceCount);
+        const unsigned int        countA = a.Schedule(&facesA[0], maxFaces);
+        const unsigned int        countB = b.Schedule(&facesB[0], maxFaces);
+
+        differences += IsSchedule(&facesA[0], countA, &facesB[0], countB) ? 0 : 1;
+        overLimit += countA > maxFaces || countA > desc.m_MaxFacesPerFrame ? 1 : 0;
+        scheduled += countA;
+    }
+    Check(differences == 0, "determinism: frames that differ", (float)differences);
+    Check(overLimit == 0, "determinism: frames over the face limit", (float)overLimit);
+    Check(scheduled > 0, "determinism: faces per frame", (float)scheduled / (float)frames);
+}
+
+int main(int argc, char * argv[])
+{
+    unsigned int frames = 1000;
+
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if      (strcmp(argv[i], "--frames") == 0) { frames = (unsigned int)atoi(argv[i + 1]); }
+        else if (strcmp(argv[i], "--seed") == 0)   { g_RandomState = (unsigned int)atoi(argv[i + 1]); }
+        else
+        {
+            printf("usage: ShadowFaceScheduler [--frames N] [--seed N]\n");
+            return 1;
+        }
+    }
+
+    if (frames == 0 || g_RandomState == 0)
+    {
+        fprintf(stderr, "--frames and --seed must be positive\n");
+        return 1;
+    }
+
+    RunRanking();
+    RunMaxAge(frames);
+    RunBudgets();
+    RunDeterminism(frames);
+
+    printf("%s\n", g_Failures == 0 ? "PASS" : "FAIL");
+    return g_Failures == 0 ? 0 : 1;
+}
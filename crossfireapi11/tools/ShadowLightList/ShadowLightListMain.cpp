@@ -0,0 +1,453 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: ShadowLightListMain.cpp
+//
+// CPU checks of the shadowed light list: atlas regions by priority, eviction and region
+// stability, the ShadowFX batch and channel limits, the view matrices of point and spot
+// lights, random add/remove/resize sequences, and the cost of an Update(). Exits nonzero
+// if a check fails.
+//
+// Build (any C++11 compiler, no Windows/D3D11/AGS dependency):
+//     g++ -std=c++11 -O2 -I../../src ShadowLightListMain.cpp ../../src/ShadowLightList.cpp ../../src/ShadowAtlasAllocator.cpp -o ShadowLightList
+//     cl /EHsc /O2 /I..\..\src ShadowLightListMain.cpp ..\..\src\ShadowLightList.cpp ..\..\src\ShadowAtlasAllocator.cpp
+//
+// Usage:
+//     ShadowLightList [--steps N] [--seed N]
+//--------------------------------------------------------------------------------------
+#include "ShadowLightList.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+
+using namespace AMD;
+
+static const float PI = 3.14159265f;
+
+// xorshift32, so every platform checks the same sequence
+static unsigned int g_RandomState = 1;
+
+static float Random(float minValue, float maxValue)
+{
+    g_RandomState ^= g_RandomState << 13;
+    g_RandomState ^= g_RandomState >> 17;
+    g_RandomState ^= g_RandomState << 5;
+    return minValue + (maxValue - minValue) * (float)(g_RandomState & 0xffffff) / (float)0xffffff;
+}
+
+static int g_Failures = 0;
+
+static void Check(bool condition, const char * name, float value)
+{
+    printf("%-48s %10.4f %s\n", name, value, condition ? "ok" : "FAIL");
+    g_Failures += condition ? 0 : 1;
+}
+
+static ShadowLight MakeSpotLight(float priority, unsigned int size)
+{
+    ShadowLight light;
+    light.m_Type = SHADOW_LIGHT_TYPE_SPOT;
+    light.m_Priority = priority;
+    light.m_Position[0] = 0.0f; light.m_Position[1] = 5.0f; light.m_Position[2] = 0.0f;
+    light.m_Direction[0] = 0.0f; light.m_Direction[1] = -1.0f; light.m_Direction[2] = 0.0f;
+    light.m_ConeAngle = PI / 3.0f;
+    light.m_NearPlane = 0.01f;
+    light.m_FarPlane = 25.0f;
+    light.m_Size = size;
+    return light;
+}
+
+static ShadowLight MakePointLight(float priority, unsigned int size)
+{
+    ShadowLight light = MakeSpotLight(priority, size);
+    light.m_Type = SHADOW_LIGHT_TYPE_POINT;
+    return light;
+}
+
+// p * view * projection, divided by w
+static void Project(const ShadowLightView & view, const float p[3], float clip[3])
+{
+    float v[4], c[4];
+    for (int col = 0; col < 4; col++)
+    {
+        v[col] = p[0] * view.m_View[col] + p[1] * view.m_View[4 + col] + p[2] * view.m_View[8 + col] + view.m_View[12 + col];
+    }
+    for (int col = 0; col < 4; col++)
+    {
+        c[col] = v[0] * view.m_Projection[col] + v[1] * view.m_Projection[4 + col] + v[2] * view.m_Projection[8 + col] + v[3] * view.m_Projection[12 + col];
+    }
+    clip[0] = c[0] / c[3]; clip[1] = c[1] / c[3]; clip[2] = c[2] / c[3];
+}
+
+static bool Overlaps(const ShadowAtlasRect & a, const ShadowAtlasRect & b)
+{
+    return a.m_X < b.m_X + b.m_Width && b.m_X < a.m_X + a.m_Width &&
+           a.m_Y < b.m_Y + b.m_Height && b.m_Y < a.m_Y + a.m_Height;
+}
+
+// the invariants every Update() keeps; returns the name of the first one broken
+static const char * Validate(const ShadowLightList & list, const ShadowAtlasAllocator & atlas, unsigned int maskCount, unsigned int reservedChannelCount)
+{
+    // the atlas holds exactly the regions of the views, inside it and disjoint
+    if (atlas.GetRegionCount() != list.GetViewCount()) { return "atlas regions == views"; }
+    for (unsigned int i = 0; i < list.GetViewCount(); i++)
+    {
+        const ShadowLightView & view = list.GetView(i);
+        if (atlas.IsValid(view.m_Region) == false) { return "view region valid"; }
+        const ShadowAtlasRect & a = atlas.GetRect(view.m_Region);
+        if (a.m_X + a.m_Width > atlas.GetWidth() || a.m_Y + a.m_Height > atlas.GetHeight()) { return "view region in the atlas"; }
+        for (unsigned int j = i + 1; j < list.GetViewCount(); j++)
+        {
+            if (Overlaps(a, atlas.GetRect(list.GetView(j).m_Region))) { return "view regions disjoint"; }
+        }
+    }
+
+    // batches within the ShadowFX limit, each on a channel of its own
+    std::vector<bool> used(maskCount * SHADOW_LIGHT_MASK_CHANNEL_COUNT, false);
+    unsigned int viewCount = 0;
+    for (unsigned int i = 0; i < list.GetBatchCount(); i++)
+    {
+        const ShadowLightBatch & batch = list.GetBatch(i);
+        const unsigned int channel = batch.m_Target * SHADOW_LIGHT_MASK_CHANNEL_COUNT + batch.m_Channel;
+        if (batch.m_ViewCount == 0 || batch.m_ViewCount > SHADOW_LIGHT_MAX_BATCH_VIEW_COUNT) { return "batch view count"; }
+        if (batch.m_FirstView != viewCount) { return "batch views contiguous"; }
+        if (batch.m_Channel >= SHADOW_LIGHT_MASK_CHANNEL_COUNT || channel >= used.size()) { return "batch channel in range"; }
+        if (channel < reservedChannelCount || used[channel] == true) { return "batch channel unique"; }
+        if (batch.m_Target >= list.GetMaskCount()) { return "batch target < mask count"; }
+        used[channel] = true;
+        viewCount += batch.m_ViewCount;
+
+        for (unsigned int v = batch.m_FirstView; v < batch.m_FirstView + batch.m_ViewCount; v++)
+        {
+            const ShadowLight & light = list.GetLight(list.GetView(v).m_Light);
+            if (list.GetLightBatch(list.GetView(v).m_Light) != i) { return "view light in its batch"; }
+            if ((light.m_Type == SHADOW_LIGHT_TYPE_POINT) != batch.m_Cube) { return "cube batches are point lights"; }
+        }
+        if (batch.m_Cube == true && batch.m_ViewCount != 6) { return "cube batch has 6 faces"; }
+    }
+    if (viewCount != list.GetViewCount()) { return "every view in a batch"; }
+
+    // shadowed lights all outrank the unshadowed ones
+    unsigned int shadowedCount = 0;
+    float lowestShadowed = 1e30f;
+    float highestUnshadowed = -1e30f;
+    for (unsigned int i = 0; i < list.GetLightCount(); i++)
+    {
+        if (list.IsValid(i) == false)
+        {
+            if (list.GetLightBatch(i) != SHADOW_LIGHT_INVALID_INDEX) { return "removed lights have no batch"; }
+            continue;
+        }
+        if (list.GetLightBatch(i) != SHADOW_LIGHT_INVALID_INDEX)
+        {
+            shadowedCount++;
+            lowestShadowed = fminf(lowestShadowed, list.GetLight(i).m_Priority);
+        }
+        else
+        {
+            highestUnshadowed = fmaxf(highestUnshadowed, list.GetLight(i).m_Priority);
+        }
+    }
+    if (shadowedCount != list.GetShadowedLightCount()) { return "shadowed light count"; }
+    if (shadowedCount > 0 && highestUnshadowed > lowestShadowed) { return "shadowed lights have the priority"; }
+
+    return NULL;
+}
+
+static void CheckValid(const ShadowLightList & list, const ShadowAtlasAllocator & atlas, unsigned int maskCount, unsigned int reservedChannelCount, const char * name)
+{
+    const char * error = Validate(list, atlas, maskCount, reservedChannelCount);
+    if (error != NULL)
+    {
+        printf("    %s\n", error);
+    }
+    Check(error == NULL, name, (float)list.GetViewCount());
+}
+
+static void RunChannels()
+{
+    ShadowAtlasAllocator atlas;
+    atlas.Init(8192, 8192);
+
+    // 3 spot lights and 2 masks, 1 channel reserved: every light gets a channel
+    ShadowLightList list;
+    list.Init(2, 1);
+    for (unsigned int i = 0; i < 3; i++)
+    {
+        list.AddLight(MakeSpotLight((float)i, 512));
+    }
+    list.Update(&atlas, 64);
+    CheckValid(list, atlas, 2, 1, "3 spot lights valid");
+    Check(list.GetBatchCount() == 3, "3 spot lights, a batch each", (float)list.GetBatchCount());
+    Check(list.GetBatch(0).m_Target == 0 && list.GetBatch(0).m_Channel == 1, "first channel after the reserved one", (float)list.GetBatch(0).m_Channel);
+    Check(list.GetBatch(0).m_FirstView == 0 && list.GetView(0).m_Light == 2, "highest priority light first", (float)list.GetView(0).m_Light);
+    Check(list.GetMaskCount() == 1, "3 spot lights fit 1 mask", (float)list.GetMaskCount());
+
+    // 20 spot lights on 7 channels: the lowest priority ones share union batches
+    for (unsigned int i = 3; i < 20; i++)
+    {
+        list.AddLight(MakeSpotLight((float)i, 256));
+    }
+    list.Update(&atlas, 64);
+    CheckValid(list, atlas, 2, 1, "20 spot lights valid");
+    Check(list.GetShadowedLightCount() == 20, "20 spot lights all shadowed", (float)list.GetShadowedLightCount());
+    Check(list.GetBatchCount() == 7, "20 spot lights on 7 channels", (float)list.GetBatchCount());
+    Check(list.GetMaskCount() == 2, "20 spot lights use 2 masks", (float)list.GetMaskCount());
+    Check(list.GetBatch(0).m_ViewCount == 1 && list.GetView(0).m_Light == 19, "highest priority keeps its channel", (float)list.GetView(0).m_Light);
+
+    // 50 spot lights can't fit 7 channels of 6: the lowest priority lose their shadows
+    for (unsigned int i = 20; i < 50; i++)
+    {
+        list.AddLight(MakeSpotLight((float)i, 128));
+    }
+    list.Update(&atlas, 64);
+    CheckValid(list, atlas, 2, 1, "50 spot lights valid");
+    Check(list.GetShadowedLightCount() == 42, "50 spot lights, 7 * 6 shadowed", (float)list.GetShadowedLightCount());
+
+    // point lights need a cube batch each
+    atlas.Init(8192, 8192);
+    ShadowLightList points;
+    points.Init(1, 0);
+    for (unsigned int i = 0; i < 6; i++)
+    {
+        points.AddLight(MakePointLight((float)i, 256));
+    }
+    points.Update(&atlas, 64);
+    CheckValid(points, atlas, 1, 0, "6 point lights valid");
+    Check(points.GetShadowedLightCount() == 4, "6 point lights, 4 shadowed", (float)points.GetShadowedLightCount());
+    Check(points.GetBatch(0).m_Cube == true && points.GetBatch(0).m_ViewCount == 6, "point light batch is a cube", (float)points.GetBatch(0).m_ViewCount);
+}
+
+static void RunPriority()
+{
+    // room for 4 spot lights of 1024, none smaller than that
+    ShadowAtlasAllocator atlas;
+    atlas.Init(2048, 2048);
+
+    ShadowLightList list;
+    list.Init(4, 0);
+    unsigned int light[8];
+    for (unsigned int i = 0; i < 8; i++)
+    {
+        light[i] = list.AddLight(MakeSpotLight((float)i, 1024));
+    }
+    list.Update(&atlas, 1024);
+    CheckValid(list, atlas, 4, 0, "full atlas valid");
+    Check(list.GetShadowedLightCount() == 4, "full atlas, 4 shadowed", (float)list.GetShadowedLightCount());
+    Check(list.GetLightBatch(light[0]) == SHADOW_LIGHT_INVALID_INDEX && list.GetLightBatch(light[7]) != SHADOW_LIGHT_INVALID_INDEX, "full atlas, priority wins", 0.0f);
+
+    // unchanged lights keep their regions
+    std::vector<unsigned int> regions;
+    for (unsigned int i = 0; i < list.GetViewCount(); i++) { regions.push_back(list.GetView(i).m_Region); }
+    list.Update(&atlas, 1024);
+    bool stable = list.GetViewCount() == regions.size();
+    for (unsigned int i = 0; i < list.GetViewCount() && stable == true; i++) { stable = list.GetView(i).m_Region == regions[i]; }
+    Check(stable == true, "regions kept from frame to frame", (float)list.GetViewCount());
+
+    // a light that becomes the most important takes the regions of the least important
+    ShadowLight desc = list.GetLight(light[0]);
+    desc.m_Priority = 100.0f;
+    list.SetLight(light[0], desc);
+    list.Update(&atlas, 1024);
+    CheckValid(list, atlas, 4, 0, "eviction valid");
+    Check(list.GetLightBatch(light[0]) != SHADOW_LIGHT_INVALID_INDEX, "promoted light shadowed", 0.0f);
+    Check(list.GetLightBatch(light[4]) == SHADOW_LIGHT_INVALID_INDEX && list.GetLightBatch(light[5]) != SHADOW_LIGHT_INVALID_INDEX, "lowest priority light evicted", 0.0f);
+
+    // a 1536 light leaves a 512 wide strip: with a smaller minimum the others shrink into it
+    atlas.Init(2048, 2048);
+    list.Init(4, 0);
+    const unsigned int big = list.AddLight(MakeSpotLight(10.0f, 1536));
+    for (unsigned int i = 0; i < 4; i++)
+    {
+        light[i] = list.AddLight(MakeSpotLight((float)i, 1024));
+    }
+    list.Update(&atlas, 1024);
+    Check(list.GetShadowedLightCount() == 1, "no room for the minimum, 1 shadowed", (float)list.GetShadowedLightCount());
+    list.Update(&atlas, 256);
+    CheckValid(list, atlas, 4, 0, "shrunk lights valid");
+    Check(list.GetShadowedLightCount() == 5, "shrunk lights, 5 shadowed", (float)list.GetShadowedLightCount());
+
+    // and get their size back once there is room, highest priority first
+    list.RemoveLight(big);
+    list.Update(&atlas, 256);
+    CheckValid(list, atlas, 4, 0, "removed light valid");
+    const unsigned int width = atlas.GetRect(list.GetView(0).m_Region).m_Width;
+    Check(list.GetView(0).m_Light == light[3] && width == 1024, "shrunk light grows back", (float)width);
+
+    // without an atlas nothing is shadowed
+    list.Update(NULL, 256);
+    Check(list.GetBatchCount() == 0 && list.GetViewCount() == 0, "no atlas, no batch", (float)list.GetBatchCount());
+}
+
+static void RunViews()
+{
+    ShadowAtlasAllocator atlas;
+    atlas.Init(4096, 4096);
+
+    ShadowLightList list;
+    list.Init(1, 0);
+
+    ShadowLight spot = MakeSpotLight(1.0f, 512);
+    spot.m_Position[0] = 3.0f; spot.m_Position[1] = 6.0f; spot.m_Position[2] = -2.0f;
+    spot.m_Direction[0] = -1.0f; spot.m_Direction[1] = -1.0f; spot.m_Direction[2] = 0.5f;
+    list.AddLight(spot);
+    list.AddLight(MakeSpotLight(0.5f, 512));    // straight down
+    list.AddLight(MakePointLight(0.0f, 256));
+    list.Update(&atlas, 64);
+    CheckValid(list, atlas, 1, 0, "views valid");
+
+    float worst = 0.0f;
+    for (unsigned int i = 0; i < list.GetViewCount(); i++)
+    {
+        const ShadowLightView & view = list.GetView(i);
+        const ShadowLight & light = list.GetLight(view.m_Light);
+
+        // 5 units along the view direction lands in the middle of the view
+        static const float faceDirection[6][3] = { { 1, 0, 0 }, { -1, 0, 0 }, { 0, 1, 0 }, { 0, -1, 0 }, { 0, 0, 1 }, { 0, 0, -1 } };
+        const float * direction = light.m_Type == SHADOW_LIGHT_TYPE_POINT ? faceDirection[view.m_Face] : light.m_Direction;
+        const float length = sqrtf(direction[0] * direction[0] + direction[1] * direction[1] + direction[2] * direction[2]);
+        float p[3], clip[3];
+        for (int c = 0; c < 3; c++) { p[c] = light.m_Position[c] + 5.0f * direction[c] / length; }
+        Project(view, p, clip);
+        worst = fmaxf(worst, fmaxf(fabsf(clip[0]), fabsf(clip[1])));
+        worst = fmaxf(worst, clip[2] > 0.0f && clip[2] < 1.0f ? 0.0f : 1.0f);
+    }
+    Check(worst < 1e-4f, "view direction at the view center", worst);
+
+    // a point half the cone angle off the axis is on the edge of a spot view
+    const ShadowLightView & down = list.GetView(1);
+    const float offset = 5.0f * tanf(PI / 6.0f);
+    const float edge[3] = { offset, 0.0f, 0.0f };
+    float clip[3];
+    Project(down, edge, clip);
+    Check(fabsf(fabsf(clip[0]) + fabsf(clip[1]) - 1.0f) < 1e-4f, "spot cone edge at the view edge", fabsf(clip[0]) + fabsf(clip[1]));
+}
+
+static void RunRandom(unsigned int steps)
+{
+    ShadowAtlasAllocator atlas;
+    atlas.Init(4096, 4096);
+
+    ShadowLightList list;
+    list.Init(3, 1);
+    std::vector<unsigned int> lights;
+
+    unsigned int failedStep = 0;
+    const char * error = NULL;
+    for (unsigned int step = 0; step < steps && error == NULL; step++)
+    {
+        const float action = Random(0.0f, 1.0f);
+        if (lights.empty() == true || (action < 0.4f && lights.size() < 64))
+        {
+            const unsigned int size = 64u << (unsigned int)Random(0.0f, 4.99f);
+            lights.push_back(list.AddLight(Random(0.0f, 1.0f) < 0.2f ? MakePointLight(Random(0.0f, 10.0f), size) : MakeSpotLight(Random(0.0f, 10.0f), size)));
+        }
+        else if (action < 0.6f)
+        {
+            const unsigned int i = (unsigned int)Random(0.0f, (float)lights.size() - 0.01f);
+            list.RemoveLight(lights[i]);
+            lights[i] = lights.back();
+            lights.pop_back();
+        }
+        else
+        {
+            const unsigned int i = (unsigned int)Random(0.0f, (float)lights.size() - 0.01f);
+            ShadowLight desc = list.GetLight(lights[i]);
+            desc.m_Priority = Random(0.0f, 10.0f);
+            if (Random(0.0f, 1.0f) < 0.3f) { desc.m_Size = 64u << (unsigned int)Random(0.0f, 4.99f); }
+            list.SetLight(lights[i], desc);
+        }
+
+        list.Update(&atlas, 64);
+        error = Validate(list, atlas, 3, 1);
+        failedStep = step;
+    }
+    if (error != NULL)
+    {
+        printf("    step %u: %s\n", failedStep, error);
+    }
+    Check(error == NULL, "random add, remove and resize", (float)steps);
+}
+
+static void RunTiming()
+{
+    ShadowAtlasAllocator atlas;
+    atlas.Init(8192, 8192);
+
+    ShadowLightList list;
+    list.Init(4, 1);
+    for (unsigned int i = 0; i < 32; i++)
+    {
+        list.AddLight(i % 8 == 0 ? MakePointLight((float)i, 512) : MakeSpotLight((float)i, 512));
+    }
+
+    const unsigned int frames = 10000;
+    const std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+    for (unsigned int frame = 0; frame < frames; frame++)
+    {
+        // the priorities change every frame, as the viewer moves
+        ShadowLight desc = list.GetLight(frame % 32);
+        desc.m_Priority = Random(0.0f, 32.0f);
+        list.SetLight(frame % 32, desc);
+        list.Update(&atlas, 64);
+    }
+    const double us = std::chrono::duration<double, std::micro>(std::chrono::high_resolution_clock::now() - start).count() / frames;
+
+    printf("%-48s %10.4f\n", "Update() of 32 lights (us)", us);
+    CheckValid(list, atlas, 4, 1, "32 lights valid");
+}
+
+int main(int argc, char * argv[])
+{
+    unsigned int steps = 2000;
+
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if      (strcmp(argv[i], "--steps") == 0) { steps = (unsigned int)atoi(argv[i + 1]); }
+        else if (strcmp(argv[i], "--seed") == 0)  { g_RandomState = (unsigned int)atoi(argv[i + 1]); }
+        else
+        {
+            printf("usage: ShadowLightList [--steps N] [--seed N]\n");
+            return 1;
+        }
+    }
+
+    if (g_RandomState == 0)
+    {
+        fprintf(stderr, "--seed must be positive\n");
+        return 1;
+    }
+
+    RunChannels();
+    RunPriority();
+    RunViews();
+    RunRandom(steps);
+    RunTiming();
+
+    printf("%s\n", g_Failures == 0 ? "PASS" : "FAIL");
+    return g_Failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,727 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//--------------------------------------------------------------------------------------
+// File: StateCacheMain.cpp
+//
+// CPU checks of AMD::StateCache against a recording target that models what D3D11 binds,
+// including the runtime forcing a shader resource to NULL when its resource is an output
+// (and the other way around): repeated passes, constant buffer ranges, shadow map and
+// scene passes that read and write the same resources, random passes with state bound
+// behind the cache's back, the disabled cache, and the cost of a pass. Exits nonzero if a
+// check fails.
+//
+// Build (any C++11 compiler, no Windows/D3D11/AGS dependency):
+//     g++ -std=c++11 -O2 -I../../../amd_lib/inc -I../../../amd_lib/src StateCacheMain.cpp ../../../amd_lib/src/AMD_StateCache.cpp -o StateCache
+//     cl /EHsc /O2 /I..\..\..\amd_lib\inc /I..\..\..\amd_lib\src StateCacheMain.cpp ..\..\..\amd_lib\src\AMD_StateCache.cpp
+//
+// Usage:
+//     StateCache [--passes N] [--seed N]
+//--------------------------------------------------------------------------------------
+#include "AMD_StateCache.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+
+// Stand-ins for the interfaces AMD_StateCache.h only declares: a view knows its resource
+struct ID3D11Resource            { int m_Id; };
+struct ID3D11ShaderResourceView  { ID3D11Resource * m_pResource; };
+struct ID3D11RenderTargetView    { ID3D11Resource * m_pResource; };
+struct ID3D11DepthStencilView    { ID3D11Resource * m_pResource; };
+struct ID3D11UnorderedAccessView { ID3D11Resource * m_pResource; };
+struct ID3D11SamplerState        { int m_Id; };
+struct ID3D11Buffer              { int m_Id; };
+struct ID3D11InputLayout         { int m_Id; };
+struct ID3D11BlendState          { int m_Id; };
+struct ID3D11DepthStencilState   { int m_Id; };
+struct ID3D11RasterizerState     { int m_Id; };
+struct ID3D11VertexShader        { int m_Id; };
+struct ID3D11HullShader          { int m_Id; };
+struct ID3D11DomainShader        { int m_Id; };
+struct ID3D11GeometryShader      { int m_Id; };
+struct ID3D11PixelShader         { int m_Id; };
+struct ID3D11ComputeShader       { int m_Id; };
+
+using namespace AMD;
+
+// xorshift32, so every platform checks the same sequence
+static unsigned int g_RandomState = 1;
+
+static unsigned int Random(unsigned int count)
+{
+    g_RandomState ^= g_RandomState << 13;
+    g_RandomState ^= g_RandomState >> 17;
+    g_RandomState ^= g_RandomState << 5;
+    return g_RandomState % count;
+}
+
+static int g_Failures = 0;
+
+static void Check(bool condition, const char * name, float value)
+{
+    printf("%-48s %10.4f %s\n", name, value, condition ? "ok" : "FAIL");
+    g_Failures += condition ? 0 : 1;
+}
+
+//--------------------------------------------------------------------------------------
+// What a D3D11 context has bound after the calls it was given. Like the runtime, it binds
+// NULL instead of a shader resource whose resource is an output, and unbinds the shader
+// resources whose resource becomes an output; every time it does is a hazard.
+//--------------------------------------------------------------------------------------
+class RecordingContext : public StateCacheTarget
+{
+public:
+    RecordingContext() { Reset(); }
+
+    void Reset()
+    {
+        memset(m_Shader, 0, sizeof(m_Shader));
+        memset(m_Srv, 0, sizeof(m_Srv));
+        memset(m_Sampler, 0, sizeof(m_Sampler));
+        memset(m_CB, 0, sizeof(m_CB));
+        memset(m_CBFirstConstant, 0, sizeof(m_CBFirstConstant));
+        memset(m_Rtv, 0, sizeof(m_Rtv));
+        memset(m_Uav, 0, sizeof(m_Uav));
+        memset(m_Viewport, 0, sizeof(m_Viewport));
+        memset(m_Scissor, 0, sizeof(m_Scissor));
+        m_Dsv = NULL;
+        m_InputLayout = NULL;
+        m_BlendState = NULL;
+        m_DepthStencilState = NULL;
+        m_StencilRef = 0;
+        m_RasterizerState = NULL;
+        m_ViewportCount = 0;
+        m_ScissorCount = 0;
+        m_Calls = 0;
+        m_Hazards = 0;
+    }
+
+    virtual void SetShader(ID3D11VertexShader * pShader)   { m_Calls++; m_Shader[STATE_CACHE_STAGE_VS] = pShader; }
+    virtual void SetShader(ID3D11HullShader * pShader)     { m_Calls++; m_Shader[STATE_CACHE_STAGE_HS] = pShader; }
+    virtual void SetShader(ID3D11DomainShader * pShader)   { m_Calls++; m_Shader[STATE_CACHE_STAGE_DS] = pShader; }
+    virtual void SetShader(ID3D11GeometryShader * pShader) { m_Calls++; m_Shader[STATE_CACHE_STAGE_GS] = pShader; }
+    virtual void SetShader(ID3D11PixelShader * pShader)    { m_Calls++; m_Shader[STATE_CACHE_STAGE_PS] = pShader; }
+    virtual void SetShader(ID3D11ComputeShader * pShader)  { m_Calls++; m_Shader[STATE_CACHE_STAGE_CS] = pShader; }
+
+    virtual void SetShaderResources(STATE_CACHE_STAGE stage, uint start, uint count, ID3D11ShaderResourceView * const * ppSRV)
+    {
+        m_Calls++;
+        for (uint i = 0; i < count; i++)
+        {
+            const bool hazard = ppSRV[i] != NULL && IsOutput(ppSRV[i]->m_pResource) == true;
+            m_Srv[stage][start + i] = hazard ? NULL : ppSRV[i];
+            m_Hazards += hazard ? 1 : 0;
+        }
+    }
+
+    virtual void SetSamplers(STATE_CACHE_STAGE stage, uint start, uint count, ID3D11SamplerState * const * ppSampler)
+    {
+        m_Calls++;
+        memcpy(&m_Sampler[stage][start], ppSampler, count * sizeof(*ppSampler));
+    }
+
+    virtual void SetConstantBuffers(STATE_CACHE_STAGE stage, uint start, uint count, ID3D11Buffer * const * ppCB)
+    {
+        m_Calls++;
+        memcpy(&m_CB[stage][start], ppCB, count * sizeof(*ppCB));
+        memset(&m_CBFirstConstant[stage][start], 0, count * sizeof(uint));
+    }
+
+    virtual void SetConstantBuffers(STATE_CACHE_STAGE stage, uint start, uint count, ID3D11Buffer * const * ppCB,
+                                    const uint * pFirstConstant, const uint *)
+    {
+        m_Calls++;
+        memcpy(&m_CB[stage][start], ppCB, count * sizeof(*ppCB));
+        memcpy(&m_CBFirstConstant[stage][start], pFirstConstant, count * sizeof(uint));
+    }
+
+    virtual void SetOutputs(uint rtvCount, ID3D11RenderTargetView * const * ppRTV, ID3D11DepthStencilView * pDSV,
+                            uint uavStart, uint uavCount, ID3D11UnorderedAccessView * const * ppUAV)
+    {
+        m_Calls++;
+        memset(m_Rtv, 0, sizeof(m_Rtv));
+        memset(m_Uav, 0, sizeof(m_Uav));
+        for (uint i = 0; i < rtvCount; i++)
+        {
+            m_Rtv[i] = ppRTV != NULL ? ppRTV[i] : NULL;
+        }
+        for (uint i = 0; i < uavCount; i++)
+        {
+            m_Uav[uavStart + i] = ppUAV != NULL ? ppUAV[i] : NULL;
+        }
+        m_Dsv = pDSV;
+
+        for (uint stage = 0; stage < STATE_CACHE_STAGE_COUNT; stage++)
+        {
+            for (uint slot = 0; slot < STATE_CACHE_SRV_SLOT_COUNT; slot++)
+            {
+                if (m_Srv[stage][slot] != NULL && IsOutput(m_Srv[stage][slot]->m_pResource) == true)
+                {
+                    m_Srv[stage][slot] = NULL;
+                    m_Hazards++;
+                }
+            }
+        }
+    }
+
+    virtual void SetInputLayout(ID3D11InputLayout * pInputLayout)                                  { m_Calls++; m_InputLayout = pInputLayout; }
+    virtual void SetBlendState(ID3D11BlendState * pBlendState, const float [4], uint)              { m_Calls++; m_BlendState = pBlendState; }
+    virtual void SetDepthStencilState(ID3D11DepthStencilState * pDepthStencilState, uint stencilRef) { m_Calls++; m_DepthStencilState = pDepthStencilState; m_StencilRef = stencilRef; }
+    virtual void SetRasterizerState(ID3D11RasterizerState * pRasterizerState)                      { m_Calls++; m_RasterizerState = pRasterizerState; }
+
+    virtual void SetViewports(uint count, const StateViewport * pViewports)
+    {
+        m_Calls++;
+        m_ViewportCount = count;
+        memcpy(m_Viewport, pViewports, count * sizeof(*pViewports));
+    }
+
+    virtual void SetScissorRects(uint count, const StateRect * pRects)
+    {
+        m_Calls++;
+        m_ScissorCount = count;
+        memcpy(m_Scissor, pRects, count * sizeof(*pRects));
+    }
+
+    virtual ID3D11Resource * GetResource(ID3D11ShaderResourceView * pView)  { return pView->m_pResource; }
+    virtual ID3D11Resource * GetResource(ID3D11RenderTargetView * pView)    { return pView->m_pResource; }
+    virtual ID3D11Resource * GetResource(ID3D11DepthStencilView * pView)    { return pView->m_pResource; }
+    virtual ID3D11Resource * GetResource(ID3D11UnorderedAccessView * pView) { return pView->m_pResource; }
+
+    bool IsOutput(const ID3D11Resource * pResource) const
+    {
+        for (uint i = 0; i < STATE_CACHE_RTV_SLOT_COUNT; i++)
+        {
+            if (m_Rtv[i] != NULL && m_Rtv[i]->m_pResource == pResource) { return true; }
+        }
+        for (uint i = 0; i < STATE_CACHE_UAV_SLOT_COUNT; i++)
+        {
+            if (m_Uav[i] != NULL && m_Uav[i]->m_pResource == pResource) { return true; }
+        }
+        return m_Dsv != NULL && m_Dsv->m_pResource == pResource;
+    }
+
+    const void *                m_Shader[STATE_CACHE_STAGE_COUNT];
+    ID3D11ShaderResourceView *  m_Srv[STATE_CACHE_STAGE_COUNT][STATE_CACHE_SRV_SLOT_COUNT];
+    ID3D11SamplerState *        m_Sampler[STATE_CACHE_STAGE_COUNT][STATE_CACHE_SAMPLER_SLOT_COUNT];
+    ID3D11Buffer *              m_CB[STATE_CACHE_STAGE_COUNT][STATE_CACHE_CB_SLOT_COUNT];
+    uint                        m_CBFirstConstant[STATE_CACHE_STAGE_COUNT][STATE_CACHE_CB_SLOT_COUNT];
+    ID3D11RenderTargetView *    m_Rtv[STATE_CACHE_RTV_SLOT_COUNT];
+    ID3D11DepthStencilView *    m_Dsv;
+    ID3D11UnorderedAccessView * m_Uav[STATE_CACHE_UAV_SLOT_COUNT];
+    ID3D11InputLayout *         m_InputLayout;
+    ID3D11BlendState *          m_BlendState;
+    ID3D11DepthStencilState *   m_DepthStencilState;
+    uint                        m_StencilRef;
+    ID3D11RasterizerState *     m_RasterizerState;
+    uint                        m_ViewportCount;
+    StateViewport               m_Viewport[STATE_CACHE_VIEWPORT_COUNT];
+    uint                        m_ScissorCount;
+    StateRect                   m_Scissor[STATE_CACHE_VIEWPORT_COUNT];
+
+    unsigned long long          m_Calls;
+    unsigned long long          m_Hazards;
+};
+
+//--------------------------------------------------------------------------------------
+// The objects passes pick from: textures with a view of every kind, and a few states
+//--------------------------------------------------------------------------------------
+static const uint TEXTURE_COUNT = 8;
+static const uint OBJECT_COUNT = 4;
+
+static ID3D11Resource            g_Texture[TEXTURE_COUNT];
+static ID3D11ShaderResourceView  g_Srv[TEXTURE_COUNT];
+static ID3D11RenderTargetView    g_Rtv[TEXTURE_COUNT];
+static ID3D11DepthStencilView    g_Dsv[TEXTURE_COUNT];
+static ID3D11UnorderedAccessView g_Uav[TEXTURE_COUNT];
+static ID3D11SamplerState        g_Sampler[OBJECT_COUNT];
+static ID3D11Buffer              g_Buffer[OBJECT_COUNT];
+static ID3D11InputLayout         g_InputLayout[OBJECT_COUNT];
+static ID3D11BlendState          g_BlendState[OBJECT_COUNT];
+static ID3D11DepthStencilState   g_DepthStencilState[OBJECT_COUNT];
+static ID3D11RasterizerState     g_RasterizerState[OBJECT_COUNT];
+static ID3D11VertexShader        g_VertexShader[OBJECT_COUNT];
+static ID3D11GeometryShader      g_GeometryShader[OBJECT_COUNT];
+static ID3D11PixelShader         g_PixelShader[OBJECT_COUNT];
+
+static void InitObjects()
+{
+    for (uint i = 0; i < TEXTURE_COUNT; i++)
+    {
+        g_Texture[i].m_Id = (int)i;
+        g_Srv[i].m_pResource = &g_Texture[i];
+        g_Rtv[i].m_pResource = &g_Texture[i];
+        g_Dsv[i].m_pResource = &g_Texture[i];
+        g_Uav[i].m_pResource = &g_Texture[i];
+    }
+}
+
+// the state of a pass, the way RenderScene takes it
+struct Pass
+{
+    ID3D11InputLayout *         m_pInputLayout;
+    ID3D11VertexShader *        m_pVS;
+    ID3D11GeometryShader *      m_pGS;
+    ID3D11PixelShader *         m_pPS;
+    uint                        m_SrvCount;
+    ID3D11ShaderResourceView *  m_pSrv[4];
+    ID3D11SamplerState *        m_pSampler[1];
+    ID3D11Buffer *              m_pCB[3];
+    uint                        m_RtvCount;
+    ID3D11RenderTargetView *    m_pRtv[2];
+    ID3D11DepthStencilView *    m_pDsv;
+    uint                        m_UavCount;
+    ID3D11UnorderedAccessView * m_pUav[1];
+    ID3D11BlendState *          m_pBlendState;
+    ID3D11DepthStencilState *   m_pDepthStencilState;
+    ID3D11RasterizerState *     m_pRasterizerState;
+    StateViewport               m_Viewport;
+};
+
+static bool StageUsed(const Pass & pass, uint stage)
+{
+    return stage == STATE_CACHE_STAGE_VS || stage == STATE_CACHE_STAGE_PS || (stage == STATE_CACHE_STAGE_GS && pass.m_pGS != NULL);
+}
+
+// a pass that never reads what it writes; the objects come from a small set, so that
+// consecutive passes share some of their state
+static Pass RandomPass()
+{
+    Pass pass;
+    memset(&pass, 0, sizeof(pass));
+
+    bool written[TEXTURE_COUNT] = { false };
+
+    pass.m_RtvCount = Random(3);
+    for (uint i = 0; i < pass.m_RtvCount; i++)
+    {
+        const uint texture = Random(TEXTURE_COUNT);
+        pass.m_pRtv[i] = &g_Rtv[texture];
+        written[texture] = true;
+    }
+    if (pass.m_RtvCount == 0 || Random(2) == 0)
+    {
+        const uint texture = Random(TEXTURE_COUNT);
+        pass.m_pDsv = &g_Dsv[texture];
+        written[texture] = true;
+    }
+    if (Random(4) == 0)
+    {
+        const uint texture = Random(TEXTURE_COUNT);
+        pass.m_UavCount = 1;
+        pass.m_pUav[0] = &g_Uav[texture];
+        written[texture] = true;
+    }
+
+    pass.m_SrvCount = Random(5);
+    for (uint i = 0; i < pass.m_SrvCount; i++)
+    {
+        const uint texture = Random(TEXTURE_COUNT);
+        pass.m_pSrv[i] = (written[texture] == true || Random(4) == 0) ? NULL : &g_Srv[texture];
+    }
+
+    pass.m_pInputLayout = &g_InputLayout[Random(2)];
+    pass.m_pVS = &g_VertexShader[Random(2)];
+    pass.m_pGS = Random(3) == 0 ? &g_GeometryShader[Random(OBJECT_COUNT)] : NULL;
+    pass.m_pPS = &g_PixelShader[Random(OBJECT_COUNT)];
+    pass.m_pSampler[0] = &g_Sampler[Random(2)];
+    pass.m_pCB[0] = &g_Buffer[0];
+    pass.m_pCB[1] = &g_Buffer[1];
+    pass.m_pCB[2] = &g_Buffer[2 + Random(2)];
+    pass.m_pBlendState = &g_BlendState[Random(2)];
+    pass.m_pDepthStencilState = &g_DepthStencilState[Random(OBJECT_COUNT)];
+    pass.m_pRasterizerState = &g_RasterizerState[Random(2)];
+
+    const float sizes[] = { 512.0f, 1024.0f };
+    const StateViewport viewport = { 0.0f, 0.0f, sizes[Random(2)], sizes[Random(2)], 0.0f, 1.0f };
+    pass.m_Viewport = viewport;
+
+    return pass;
+}
+
+// the calls of RenderScene
+static void ApplyPass(StateCache & cache, const Pass & pass)
+{
+    cache.SetInputLayout(pass.m_pInputLayout);
+    cache.SetShader(pass.m_pVS);
+    cache.SetShader((ID3D11HullShader *)NULL);
+    cache.SetShader((ID3D11DomainShader *)NULL);
+    cache.SetShader(pass.m_pGS);
+    cache.SetShader(pass.m_pPS);
+
+    for (uint stage = STATE_CACHE_STAGE_VS; stage <= STATE_CACHE_STAGE_PS; stage++)
+    {
+        if (StageUsed(pass, stage) == true)
+        {
+            cache.SetSamplers((STATE_CACHE_STAGE)stage, 0, 1, pass.m_pSampler);
+            cache.SetShaderResources((STATE_CACHE_STAGE)stage, 0, pass.m_SrvCount, pass.m_pSrv);
+            cache.SetConstantBuffers((STATE_CACHE_STAGE)stage, 0, 3, pass.m_pCB);
+        }
+    }
+
+    if (pass.m_UavCount > 0)
+    {
+        cache.SetRenderTargetsAndUnorderedAccessViews(pass.m_RtvCount, pass.m_pRtv, pass.m_pDsv, pass.m_RtvCount, pass.m_UavCount, pass.m_pUav);
+    }
+    else
+    {
+        cache.SetRenderTargets(pass.m_RtvCount, pass.m_pRtv, pass.m_pDsv);
+    }
+    cache.SetBlendState(pass.m_pBlendState, NULL, 0xf);
+    cache.SetDepthStencilState(pass.m_pDepthStencilState, 0);
+    cache.SetRasterizerState(pass.m_pRasterizerState);
+    cache.SetScissorRects(0, NULL);
+    cache.SetViewports(1, &pass.m_Viewport);
+}
+
+// the calls RenderScene made before the cache: unbind every output and shader resource,
+// then bind everything to every graphics stage
+static void ApplyPassUncached(RecordingContext & context, const Pass & pass)
+{
+    ID3D11ShaderResourceView * const pNullSRV[STATE_CACHE_SRV_SLOT_COUNT] = { NULL };
+
+    context.SetOutputs(0, NULL, NULL, 0, 0, NULL);
+    for (uint stage = 0; stage < STATE_CACHE_STAGE_COUNT; stage++)
+    {
+        context.SetShaderResources((STATE_CACHE_STAGE)stage, 0, STATE_CACHE_SRV_SLOT_COUNT, pNullSRV);
+    }
+
+    context.SetInputLayout(pass.m_pInputLayout);
+    context.SetShader(pass.m_pVS);
+    context.SetShader((ID3D11HullShader *)NULL);
+    context.SetShader((ID3D11DomainShader *)NULL);
+    context.SetShader(pass.m_pGS);
+    context.SetShader(pass.m_pPS);
+
+    for (uint stage = STATE_CACHE_STAGE_VS; stage <= STATE_CACHE_STAGE_PS; stage++)
+    {
+        context.SetSamplers((STATE_CACHE_STAGE)stage, 0, 1, pass.m_pSampler);
+        if (pass.m_SrvCount > 0)
+        {
+            context.SetShaderResources((STATE_CACHE_STAGE)stage, 0, pass.m_SrvCount, pass.m_pSrv);
+        }
+        context.SetConstantBuffers((STATE_CACHE_STAGE)stage, 0, 3, pass.m_pCB);
+    }
+
+    context.SetOutputs(pass.m_RtvCount, pass.m_pRtv, pass.m_pDsv, pass.m_RtvCount, pass.m_UavCount, pass.m_pUav);
+    context.SetBlendState(pass.m_pBlendState, NULL, 0xf);
+    context.SetDepthStencilState(pass.m_pDepthStencilState, 0);
+    context.SetRasterizerState(pass.m_pRasterizerState);
+    context.SetScissorRects(0, NULL);
+    context.SetViewports(1, &pass.m_Viewport);
+}
+
+// everything the pass reads and writes is bound to the context
+static bool IsBound(const RecordingContext & context, const Pass & pass)
+{
+    bool bound = context.m_InputLayout == pass.m_pInputLayout &&
+                 context.m_Shader[STATE_CACHE_STAGE_VS] == pass.m_pVS &&
+                 context.m_Shader[STATE_CACHE_STAGE_HS] == NULL &&
+                 context.m_Shader[STATE_CACHE_STAGE_DS] == NULL &&
+                 context.m_Shader[STATE_CACHE_STAGE_GS] == pass.m_pGS &&
+                 context.m_Shader[STATE_CACHE_STAGE_PS] == pass.m_pPS &&
+                 context.m_Dsv == pass.m_pDsv &&
+                 context.m_BlendState == pass.m_pBlendState &&
+                 context.m_DepthStencilState == pass.m_pDepthStencilState &&
+                 context.m_RasterizerState == pass.m_pRasterizerState &&
+                 context.m_ViewportCount == 1 &&
+                 memcmp(&context.m_Viewport[0], &pass.m_Viewport, sizeof(pass.m_Viewport)) == 0 &&
+                 context.m_ScissorCount == 0;
+
+    for (uint i = 0; i < STATE_CACHE_RTV_SLOT_COUNT; i++)
+    {
+        bound = bound && context.m_Rtv[i] == (i < pass.m_RtvCount ? pass.m_pRtv[i] : NULL);
+    }
+    for (uint i = 0; i < pass.m_UavCount; i++)
+    {
+        bound = bound && context.m_Uav[pass.m_RtvCount + i] == pass.m_pUav[i];
+    }
+
+    for (uint stage = STATE_CACHE_STAGE_VS; stage <= STATE_CACHE_STAGE_PS; stage++)
+    {
+        if (StageUsed(pass, stage) == false)
+        {
+            continue;
+        }
+        for (uint i = 0; i < pass.m_SrvCount; i++)
+        {
+            bound = bound && context.m_Srv[stage][i] == pass.m_pSrv[i];
+        }
+        bound = bound && context.m_Sampler[stage][0] == pass.m_pSampler[0];
+        for (uint i = 0; i < 3; i++)
+        {
+            bound = bound && context.m_CB[stage][i] == pass.m_pCB[i];
+        }
+    }
+    return bound;
+}
+
+//--------------------------------------------------------------------------------------
+// The same pass twice: the second one sends nothing
+//--------------------------------------------------------------------------------------
+static void RunRepeatedPass()
+{
+    RecordingContext context;
+    StateCache       cache;
+    cache.SetTarget(&context);
+
+    const Pass pass = RandomPass();
+    ApplyPass(cache, pass);
+    const unsigned long long firstCalls = context.m_Calls;
+
+    cache.ResetCounters();
+    ApplyPass(cache, pass);
+
+    Check(IsBound(context, pass) == true, "repeated pass: bound", 1.0f);
+    Check(context.m_Calls == firstCalls, "repeated pass: calls sent the second time", (float)(context.m_Calls - firstCalls));
+    Check(cache.GetCounters().forwarded == 0 && cache.GetCounters().avoided > 0, "repeated pass: calls avoided the second time", (float)cache.GetCounters().avoided);
+}
+
+//--------------------------------------------------------------------------------------
+// Ranges of one constant buffer, the way a constant ring binds them: a slot changes with
+// its range, and binding the whole buffer again isn't mistaken for the last range
+//--------------------------------------------------------------------------------------
+static void RunConstantBufferRanges()
+{
+    RecordingContext context;
+    StateCache       cache;
+    cache.SetTarget(&context);
+
+    ID3D11Buffer * pRing = &g_Buffer[0];
+    const uint     constantCount = 16;
+    uint           sent = 0;
+    bool           bound = true;
+
+    for (uint draw = 0; draw < 8; draw++)
+    {
+        const uint firstConstant = draw * constantCount;
+        const unsigned long long calls = context.m_Calls;
+
+        cache.SetConstantBuffers(STATE_CACHE_STAGE_VS, 0, 1, &pRing, &firstConstant, &constantCount);
+        cache.SetConstantBuffers(STATE_CACHE_STAGE_VS, 0, 1, &pRing, &firstConstant, &constantCount);
+        sent += (uint)(context.m_Calls - calls);
+        bound = bound && context.m_CB[STATE_CACHE_STAGE_VS][0] == pRing && context.m_CBFirstConstant[STATE_CACHE_STAGE_VS][0] == firstConstant;
+    }
+
+    const unsigned long long calls = context.m_Calls;
+    cache.SetConstantBuffers(STATE_CACHE_STAGE_VS, 0, 1, &pRing);
+    bound = bound && context.m_Calls == calls + 1 && context.m_CBFirstConstant[STATE_CACHE_STAGE_VS][0] == 0;
+
+    Check(bound == true, "constant buffer ranges: bound", 1.0f);
+    Check(sent == 8, "constant buffer ranges: calls sent for 8 draws", (float)sent);
+}
+
+//--------------------------------------------------------------------------------------
+// A shadow map rendered, read by the scene, rendered again: only the conflicting slots
+// and outputs are unbound, and the context never sees a hazard
+//--------------------------------------------------------------------------------------
+static void RunShadowMapPasses()
+{
+    RecordingContext context;
+    StateCache       cache;
+    cache.SetTarget(&context);
+
+    Pass shadowMap = RandomPass();
+    shadowMap.m_RtvCount = 0;
+    shadowMap.m_UavCount = 0;
+    shadowMap.m_pDsv = &g_Dsv[0];
+    shadowMap.m_SrvCount = 1;
+    shadowMap.m_pSrv[0] = NULL;
+
+    Pass scene = shadowMap;
+    scene.m_RtvCount = 1;
+    scene.m_pRtv[0] = &g_Rtv[1];
+    scene.m_pDsv = &g_Dsv[2];
+    scene.m_SrvCount = 3;
+    scene.m_pSrv[0] = &g_Srv[3];    // diffuse
+    scene.m_pSrv[1] = &g_Srv[4];    // another texture
+    scene.m_pSrv[2] = &g_Srv[0];    // the shadow map
+
+    Pass mask = scene;              // writes the texture the scene reads in slot 1
+    mask.m_pRtv[0] = &g_Rtv[4];
+    mask.m_SrvCount = 1;
+    mask.m_pSrv[0] = &g_Srv[3];
+
+    bool               bound = true;
+    unsigned long long unbinds = 0;
+    for (int frame = 0; frame < 4; frame++)
+    {
+        const Pass * pPasses[] = { &shadowMap, &mask, &scene };
+        for (int i = 0; i < 3; i++)
+        {
+            ApplyPass(cache, *pPasses[i]);
+            bound = bound && IsBound(context, *pPasses[i]);
+        }
+
+        if (frame == 0)
+        {
+            cache.ResetCounters();
+        }
+        unbinds = cache.GetCounters().unbinds;
+    }
+
+    Check(bound == true, "shadow map passes: bound", 1.0f);
+    Check(context.m_Hazards == 0, "shadow map passes: hazards", (float)context.m_Hazards);
+
+    // per frame after the first: the shadow map SRV on VS and PS before the shadow map pass,
+    // the slot 1 SRV on VS and PS before the mask pass, the mask RTV before the scene binds it
+    Check(unbinds == 3 * 5, "shadow map passes: conflict unbinds in 3 frames", (float)unbinds);
+}
+
+//--------------------------------------------------------------------------------------
+// Random passes, through the cache and the way RenderScene bound them before, with a
+// library binding behind the cache's back now and then (followed by an Invalidate) and
+// a mesh binding its texture to slot 0 (followed by InvalidateShaderResources)
+//--------------------------------------------------------------------------------------
+static void RunRandomPasses(uint passCount, bool enabled)
+{
+    RecordingContext cached, uncached;
+    StateCache       cache;
+    cache.SetTarget(&cached);
+    cache.SetEnabled(enabled);
+
+    uint invalidates = 0;
+    uint wrong = 0;
+
+    for (uint i = 0; i < passCount; i++)
+    {
+        const Pass pass = RandomPass();
+
+        ApplyPass(cache, pass);
+        ApplyPassUncached(uncached, pass);
+
+        wrong += IsBound(cached, pass) ? 0 : 1;
+        wrong += IsBound(uncached, pass) ? 0 : 1;
+
+        // the hazards of these calls are their own, not the cache's
+        const unsigned long long hazards = cached.m_Hazards;
+
+        if (Random(8) == 0)
+        {
+            // a draw binding its texture itself
+            ID3D11ShaderResourceView * pDiffuse = &g_Srv[Random(TEXTURE_COUNT)];
+            if (cached.IsOutput(pDiffuse->m_pResource) == false)
+            {
+                cached.SetShaderResources(STATE_CACHE_STAGE_PS, 0, 1, &pDiffuse);
+                cache.InvalidateShaderResources(STATE_CACHE_STAGE_PS, 0, 1);
+            }
+        }
+        if (Random(32) == 0)
+        {
+            // a library binding whatever it wants
+            ID3D11ShaderResourceView * pSRV = &g_Srv[Random(TEXTURE_COUNT)];
+            ID3D11RenderTargetView *   pRTV = &g_Rtv[Random(TEXTURE_COUNT)];
+            cached.SetOutputs(1, &pRTV, NULL, 1, 0, NULL);
+            cached.SetShaderResources((STATE_CACHE_STAGE)Random(STATE_CACHE_STAGE_COUNT), Random(16), 1, &pSRV);
+            cached.SetShader(&g_PixelShader[Random(OBJECT_COUNT)]);
+            cached.SetRasterizerState(&g_RasterizerState[Random(OBJECT_COUNT)]);
+            cache.Invalidate();
+            invalidates++;
+        }
+
+        cached.m_Hazards = hazards;
+    }
+
+    const float ratio = (float)cached.m_Calls / (float)uncached.m_Calls;
+
+    if (enabled == true)
+    {
+        Check(wrong == 0, "random passes: passes not bound", (float)wrong);
+        Check(cached.m_Hazards == 0, "random passes: hazards", (float)cached.m_Hazards);
+        Check(invalidates > 0, "random passes: invalidates", (float)invalidates);
+        Check(ratio < 0.5f, "random passes: calls sent / calls before", ratio);
+        Check(cache.GetCounters().avoided > 0, "random passes: calls avoided per pass", (float)cache.GetCounters().avoided / (float)passCount);
+    }
+    else
+    {
+        Check(wrong == 0, "disabled: passes not bound", (float)wrong);
+        Check(cached.m_Hazards == 0, "disabled: hazards", (float)cached.m_Hazards);
+        Check(cache.GetCounters().avoided == 0, "disabled: calls avoided", (float)cache.GetCounters().avoided);
+    }
+}
+
+//--------------------------------------------------------------------------------------
+// The cost of a pass through the cache
+//--------------------------------------------------------------------------------------
+static void RunTiming()
+{
+    static const uint PASS_COUNT = 1024;
+
+    Pass passes[PASS_COUNT];
+    for (uint i = 0; i < PASS_COUNT; i++)
+    {
+        passes[i] = RandomPass();
+    }
+
+    RecordingContext context;
+    StateCache       cache;
+    cache.SetTarget(&context);
+
+    const int repeat = 64;
+    const std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+    for (int r = 0; r < repeat; r++)
+    {
+        for (uint i = 0; i < PASS_COUNT; i++)
+        {
+            ApplyPass(cache, passes[i]);
+        }
+    }
+    const std::chrono::high_resolution_clock::time_point end = std::chrono::high_resolution_clock::now();
+
+    const double us = std::chrono::duration<double, std::micro>(end - start).count() / (double)(repeat * PASS_COUNT);
+    Check(us < 20.0, "timing: microseconds per pass", (float)us);
+}
+
+int main(int argc, char * argv[])
+{
+    unsigned int passes = 100000;
+
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if      (strcmp(argv[i], "--passes") == 0) { passes = (unsigned int)atoi(argv[i + 1]); }
+        else if (strcmp(argv[i], "--seed") == 0)   { g_RandomState = (unsigned int)atoi(argv[i + 1]); }
+        else
+        {
+            printf("usage: StateCache [--passes N] [--seed N]\n");
+            return 1;
+        }
+    }
+
+    if (g_RandomState == 0)
+    {
+        fprintf(stderr, "--seed must be positive\n");
+        return 1;
+    }
+
+    InitObjects();
+
+    RunRepeatedPass();
+    RunConstantBufferRanges();
+    RunShadowMapPasses();
+    RunRandomPasses(passes, true);
+    RunRandomPasses(passes / 10, false);
+    RunTiming();
+
+    printf("%s\n", g_Failures == 0 ? "PASS" : "FAIL");
+    return g_Failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,358 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//--------------------------------------------------------------------------------------
+// File: TransferModeControllerMain.cpp
+//
+// CPU checks of AMD::TransferModeController fed with modelled frame costs: two modes a
+// few percent apart under noise don't flap, a candidate only wins past the hysteresis,
+// a stale estimate is not switched on but probed again, a mode that became cheaper is
+// found by its next probe, probes alternate between the oldest estimates, a probe is
+// only kept after ConfirmWindows cheaper windows, and a candidate mask that removes
+// the current mode switches right away. Exits nonzero if a check fails.
+//
+// Build (any C++11 compiler, no Windows/D3D11/AGS dependency):
+//     g++ -std=c++11 -O2 -I../../src TransferModeControllerMain.cpp ../../src/TransferModeController.cpp -o TransferModeController
+//     cl /EHsc /O2 /I..\..\src TransferModeControllerMain.cpp ..\..\src\TransferModeController.cpp
+//
+// Usage:
+//     TransferModeController [--frames N] [--seed N]
+//--------------------------------------------------------------------------------------
+#include "TransferModeController.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace AMD;
+
+// xorshift32, so every platform checks the same sequence
+static unsigned int g_RandomState = 1;
+
+static unsigned int Random(unsigned int count)
+{
+    g_RandomState ^= g_RandomState << 13;
+    g_RandomState ^= g_RandomState >> 17;
+    g_RandomState ^= g_RandomState << 5;
+    return g_RandomState % count;
+}
+
+static double RandomDouble(double minimum, double maximum)
+{
+    return minimum + (maximum - minimum) * (double)Random(1 << 20) / (double)(1 << 20);
+}
+
+static int g_Failures = 0;
+
+static void Check(bool condition, const char * name, float value)
+{
+    printf("%-48s %10.4g %s\n", name, value, condition ? "ok" : "FAIL");
+    g_Failures += condition ? 0 : 1;
+}
+
+// AGSAfrTransferType values
+static const int MODE_1STEP_P2P = 2;
+static const int MODE_2STEP_NO_BROADCAST = 3;
+static const int MODE_2STEP_WITH_BROADCAST = 4;
+
+// short windows so that a run covers many decisions
+static TransferModeControllerDesc GetDesc(unsigned int candidateMask, int initialMode)
+{
+    TransferModeControllerDesc desc;
+    desc.m_InitialMode = initialMode;
+    desc.m_CandidateMask = candidateMask;
+    desc.m_WarmupFrames = 2;
+    desc.m_WindowFrames = 10;
+    desc.m_Hysteresis = 0.05f;
+    desc.m_ConfirmWindows = 2;
+    desc.m_ProbeInterval = 5;
+    desc.m_MaxEstimateAge = 12;
+    return desc;
+}
+
+// what a run did: the steady mode is the mode outside of probes
+struct RunResult
+{
+    int          m_SteadyMode;
+    unsigned int m_SteadyChanges;           // changes of the steady mode after the first one
+    unsigned int m_Probes[TRANSFER_MODE_COUNT];
+    unsigned int m_LastSteadyChangeFrame;
+};
+
+static void ResetResult(const TransferModeController & controller, RunResult & result)
+{
+    memset(&result, 0, sizeof(result));
+    result.m_SteadyMode = controller.GetMode();
+}
+
+// feeds the controller the cost of its mode, plus or minus noise, for a number of frames
+static void Run(TransferModeController & controller, const double * pCosts, double noise, unsigned int frames, unsigned int firstFrame, RunResult & result)
+{
+    for (unsigned int frame = firstFrame; frame < firstFrame + frames; frame++)
+    {
+        const bool wasProbing = controller.IsProbing();
+
+        controller.AddSample(pCosts[controller.GetMode()] + (noise > 0.0 ? RandomDouble(-noise, noise) : 0.0));
+
+        if (controller.IsProbing() == true && wasProbing == false)
+        {
+            result.m_Probes[controller.GetMode()]++;
+        }
+        if (controller.IsProbing() == false && controller.GetMode() != result.m_SteadyMode)
+        {
+            result.m_SteadyMode = controller.GetMode();
+            result.m_SteadyChanges++;
+            result.m_LastSteadyChangeFrame = frame;
+        }
+    }
+}
+
+//--------------------------------------------------------------------------------------
+// Hysteresis: modes 2% apart under noise
+//--------------------------------------------------------------------------------------
+static void RunHysteresis(unsigned int frames)
+{
+    double costs[TRANSFER_MODE_COUNT] = { 0.0, 0.0, 10.2, 10.0, 0.0 };
+
+    TransferModeController controller;
+    RunResult              result;
+    controller.Init(GetDesc(TRANSFER_MODE_BIT(MODE_1STEP_P2P) | TRANSFER_MODE_BIT(MODE_2STEP_NO_BROADCAST), MODE_1STEP_P2P));
+    ResetResult(controller, result);
+    Run(controller, costs, 0.3, frames, 0, result);
+    Check(result.m_SteadyChanges == 0, "hysteresis: steady mode changes, 2% apart", (float)result.m_SteadyChanges);
+    Check(result.m_Probes[MODE_2STEP_NO_BROADCAST] > 1, "hysteresis: the other mode is still probed", (float)result.m_Probes[MODE_2STEP_NO_BROADCAST]);
+
+    // the same run without hysteresis nor confirmation follows the noise
+    TransferModeControllerDesc desc = GetDesc(TRANSFER_MODE_BIT(MODE_1STEP_P2P) | TRANSFER_MODE_BIT(MODE_2STEP_NO_BROADCAST), MODE_1STEP_P2P);
+    desc.m_Hysteresis = 0.0f;
+    desc.m_ConfirmWindows = 1;
+    RunResult flapping;
+    controller.Init(desc);
+    ResetResult(controller, flapping);
+    Run(controller, costs, 0.3, frames, 0, flapping);
+    Check(flapping.m_SteadyChanges > result.m_SteadyChanges, "hysteresis: changes without hysteresis", (float)flapping.m_SteadyChanges);
+}
+
+//--------------------------------------------------------------------------------------
+// The switch threshold: 6% cheaper wins, 4% cheaper doesn't
+//--------------------------------------------------------------------------------------
+static void RunThreshold(unsigned int frames)
+{
+    const unsigned int mask = TRANSFER_MODE_BIT(MODE_1STEP_P2P) | TRANSFER_MODE_BIT(MODE_2STEP_NO_BROADCAST);
+
+    TransferModeController controller;
+    RunResult              result;
+    double                 costs[TRANSFER_MODE_COUNT] = { 0.0, 0.0, 10.0, 9.6, 0.0 };
+
+    controller.Init(GetDesc(mask, MODE_1STEP_P2P));
+    ResetResult(controller, result);
+    Run(controller, costs, 0.0, frames, 0, result);
+    Check(result.m_SteadyMode == MODE_1STEP_P2P && result.m_SteadyChanges == 0, "threshold: 4% cheaper stays", (float)result.m_SteadyChanges);
+
+    double     estimate = 0.0;
+    const bool measured = controller.GetEstimate(MODE_2STEP_NO_BROADCAST, estimate);
+    Check(measured == true && fabs(estimate - 9.6) < 1e-9, "threshold: estimate of the probed mode", (float)estimate);
+    Check(controller.GetEstimate(MODE_2STEP_WITH_BROADCAST, estimate) == false, "threshold: no estimate of a mode never run", 0.0f);
+
+    costs[MODE_2STEP_NO_BROADCAST] = 9.4;
+    controller.Init(GetDesc(mask, MODE_1STEP_P2P));
+    ResetResult(controller, result);
+    Run(controller, costs, 0.0, frames, 0, result);
+    Check(result.m_SteadyMode == MODE_2STEP_NO_BROADCAST && result.m_SteadyChanges == 1, "threshold: 6% cheaper switches once", (float)result.m_SteadyChanges);
+
+    // the current mode getting 10% dearer: the fresh estimate of the other mode wins after
+    // the window in progress and ConfirmWindows more, or earlier if its probe comes first
+    costs[MODE_1STEP_P2P] = 10.0;
+    costs[MODE_2STEP_NO_BROADCAST] = 10.0;
+    controller.Init(GetDesc(mask, MODE_1STEP_P2P));
+    ResetResult(controller, result);
+    Run(controller, costs, 0.0, 200, 0, result);
+    const bool steady = result.m_SteadyMode == MODE_1STEP_P2P && result.m_SteadyChanges == 0;
+
+    costs[MODE_1STEP_P2P] = 11.0;
+    Run(controller, costs, 0.0, 200, 200, result);
+    const unsigned int delay = result.m_LastSteadyChangeFrame - 200;
+    const TransferModeControllerDesc desc = GetDesc(mask, MODE_1STEP_P2P);
+    Check(steady && result.m_SteadyMode == MODE_2STEP_NO_BROADCAST && delay <= (desc.m_ConfirmWindows + 2) * (desc.m_WindowFrames + desc.m_WarmupFrames),
+          "threshold: frames to leave a mode 10% dearer", (float)delay);
+}
+
+//--------------------------------------------------------------------------------------
+// Probing: stale estimates are measured again
+//--------------------------------------------------------------------------------------
+static void RunProbing()
+{
+    const unsigned int mask = TRANSFER_MODE_BIT(MODE_1STEP_P2P) | TRANSFER_MODE_BIT(MODE_2STEP_NO_BROADCAST) | TRANSFER_MODE_BIT(MODE_2STEP_WITH_BROADCAST);
+    const TransferModeControllerDesc desc = GetDesc(mask, MODE_1STEP_P2P);
+
+    // the never measured modes are probed first, then the oldest estimate every ProbeInterval windows
+    double                 costs[TRANSFER_MODE_COUNT] = { 0.0, 0.0, 8.0, 10.0, 12.0 };
+    TransferModeController controller;
+    RunResult              result;
+    controller.Init(desc);
+    ResetResult(controller, result);
+
+    const unsigned int windowFrames = desc.m_WindowFrames + desc.m_WarmupFrames;
+    const unsigned int frames = 40 * windowFrames;
+    Run(controller, costs, 0.0, frames, 0, result);
+    Check(result.m_SteadyMode == MODE_1STEP_P2P && result.m_SteadyChanges == 0, "probing: cheapest mode stays", (float)result.m_SteadyChanges);
+
+    const unsigned int probes = result.m_Probes[MODE_2STEP_NO_BROADCAST] + result.m_Probes[MODE_2STEP_WITH_BROADCAST];
+    const int          difference = (int)result.m_Probes[MODE_2STEP_NO_BROADCAST] - (int)result.m_Probes[MODE_2STEP_WITH_BROADCAST];
+    Check(difference >= -1 && difference <= 1, "probing: both other modes probed in turn", (float)difference);
+    Check(probes >= 2 + (frames / windowFrames - 4) / (desc.m_ProbeInterval + 2), "probing: probes in the run", (float)probes);
+
+    // the current mode getting twice as dear: a fresh estimate of the other mode is switched
+    // on, a stale one isn't, and is probed again instead when probes are due
+    const unsigned int twoModes = TRANSFER_MODE_BIT(MODE_1STEP_P2P) | TRANSFER_MODE_BIT(MODE_2STEP_NO_BROADCAST);
+    const unsigned int settle = 10 * windowFrames;
+    const unsigned int after = 10 * windowFrames;
+    const unsigned int maxAges[] = { 100, 3, 3 };
+    const unsigned int probeIntervals[] = { 100, 100, 6 };
+    const char *       names[] = { "probing: fresh estimate switched on", "probing: stale estimate not switched on", "probing: stale estimate probed again" };
+    const bool         switches[] = { true, false, true };
+    for (unsigned int i = 0; i < 3; i++)
+    {
+        TransferModeControllerDesc staleDesc = GetDesc(twoModes, MODE_1STEP_P2P);
+        staleDesc.m_MaxEstimateAge = maxAges[i];
+        staleDesc.m_ProbeInterval = probeIntervals[i];
+
+        double staleCosts[TRANSFER_MODE_COUNT] = { 0.0, 0.0, 10.0, 10.0, 0.0 };
+        controller.Init(staleDesc);
+        ResetResult(controller, result);
+        Run(controller, staleCosts, 0.0, settle, 0, result);
+        const unsigned int probesBefore = result.m_Probes[MODE_2STEP_NO_BROADCAST];
+
+        staleCosts[MODE_1STEP_P2P] = 20.0;
+        Run(controller, staleCosts, 0.0, after, settle, result);
+        const bool switched = result.m_SteadyMode == MODE_2STEP_NO_BROADCAST;
+        const bool probed = result.m_Probes[MODE_2STEP_NO_BROADCAST] > probesBefore;
+        Check(switched == switches[i] && (i != 2 || probed == true), names[i], (float)result.m_SteadyChanges);
+    }
+
+    // a mode that got cheaper since it was last measured is found by its next probe
+    costs[MODE_2STEP_WITH_BROADCAST] = 4.0;
+    controller.Init(desc);
+    ResetResult(controller, result);
+    Run(controller, costs, 0.0, frames, 0, result);
+    const unsigned int before = result.m_SteadyChanges;
+    Check(before == 1 && result.m_SteadyMode == MODE_2STEP_WITH_BROADCAST, "probing: cheapest of three found", (float)before);
+
+    costs[MODE_2STEP_WITH_BROADCAST] = 20.0;
+    costs[MODE_2STEP_NO_BROADCAST] = 5.0;
+    Run(controller, costs, 0.0, frames, frames, result);
+    const unsigned int delay = result.m_LastSteadyChangeFrame - frames;
+    Check(result.m_SteadyMode == MODE_2STEP_NO_BROADCAST, "probing: mode that got cheaper is found", (float)result.m_SteadyMode);
+    Check(delay <= 2 * (desc.m_ProbeInterval + 2) * windowFrames, "probing: frames to find it", (float)delay);
+
+    // removing the current mode from the candidates switches right away, to the best known one
+    const bool changed = controller.SetCandidateMask(TRANSFER_MODE_BIT(MODE_1STEP_P2P) | TRANSFER_MODE_BIT(MODE_2STEP_WITH_BROADCAST));
+    Check(changed == true && controller.GetMode() != MODE_2STEP_NO_BROADCAST && controller.IsProbing() == false, "probing: mask removes the current mode",
+          (float)controller.GetMode());
+}
+
+//--------------------------------------------------------------------------------------
+// Probe confirmation: a probe is only kept if it is cheaper for ConfirmWindows windows
+//--------------------------------------------------------------------------------------
+static void RunProbeConfirmation()
+{
+    const unsigned int               mask = TRANSFER_MODE_BIT(MODE_1STEP_P2P) | TRANSFER_MODE_BIT(MODE_2STEP_NO_BROADCAST);
+    const TransferModeControllerDesc desc = GetDesc(mask, MODE_1STEP_P2P);
+    const unsigned int               windowFrames = desc.m_WindowFrames + desc.m_WarmupFrames;
+    const unsigned int               frames = 40 * windowFrames;
+
+    // first run: both modes cost the same, but the first window of every probe of the
+    // other mode is 20% cheaper (noise); second run: the other mode is 20% cheaper
+    const char * names[] = { "probe: one cheap window is not kept", "probe: cheaper in every window is kept" };
+    for (unsigned int i = 0; i < 2; i++)
+    {
+        TransferModeController controller;
+        RunResult              result;
+        controller.Init(desc);
+        ResetResult(controller, result);
+
+        unsigned int probeSamples = 0;
+        unsigned int probeWindowsAtSwitch = 0;
+        for (unsigned int frame = 0; frame < frames; frame++)
+        {
+            const bool wasProbing = controller.IsProbing();
+            const bool cheap = i == 1 || (wasProbing == true && probeSamples < desc.m_WarmupFrames + desc.m_WindowFrames);
+
+            const double cost = controller.GetMode() == MODE_2STEP_NO_BROADCAST && cheap == true ? 8.0 : 10.0;
+
+            controller.AddSample(cost);
+            probeSamples = wasProbing == true ? probeSamples + 1 : 0;
+
+            if (controller.IsProbing() == true && wasProbing == false)
+            {
+                result.m_Probes[controller.GetMode()]++;
+            }
+            if (controller.IsProbing() == false && controller.GetMode() != result.m_SteadyMode)
+            {
+                result.m_SteadyMode = controller.GetMode();
+                result.m_SteadyChanges++;
+                probeWindowsAtSwitch = (probeSamples - desc.m_WarmupFrames) / desc.m_WindowFrames;
+            }
+        }
+
+        if (i == 0)
+        {
+            Check(result.m_SteadyMode == MODE_1STEP_P2P && result.m_SteadyChanges == 0 && result.m_Probes[MODE_2STEP_NO_BROADCAST] > 1, names[i],
+                  (float)result.m_SteadyChanges);
+        }
+        else
+        {
+            Check(result.m_SteadyMode == MODE_2STEP_NO_BROADCAST && result.m_SteadyChanges == 1 && probeWindowsAtSwitch == desc.m_ConfirmWindows, names[i],
+                  (float)probeWindowsAtSwitch);
+        }
+    }
+}
+
+int main(int argc, char * argv[])
+{
+    unsigned int frames = 20000;
+
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if      (strcmp(argv[i], "--frames") == 0) { frames = (unsigned int)atoi(argv[i + 1]); }
+        else if (strcmp(argv[i], "--seed") == 0)   { g_RandomState = (unsigned int)atoi(argv[i + 1]); }
+        else
+        {
+            printf("usage: TransferModeController [--frames N] [--seed N]\n");
+            return 1;
+        }
+    }
+
+    if (frames == 0 || g_RandomState == 0)
+    {
+        fprintf(stderr, "--frames and --seed must be positive\n");
+        return 1;
+    }
+
+    RunHysteresis(frames);
+    RunThreshold(frames);
+    RunProbing();
+    RunProbeConfirmation();
+
+    printf("%s\n", g_Failures == 0 ? "PASS" : "FAIL");
+    return g_Failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,357 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+
+//--------------------------------------------------------------------------------------
+// File: TransferTraceAnalyzerMain.cpp
+//
+// Offline analyzer for the binary traces written by the sample (press 'T' to start and
+// stop recording, the trace is saved next to the executable as CrossfireAPI11.cfxtrace).
+//
+// Reports:
+//   - bytes sent per frame by agsDriverExtensions_NotifyResourceEndWrites
+//   - redundant transfers: repeated EndWrites in a frame, EndWrites on resources that
+//     don't transfer, and EndWrites covering more than what was copied into a transfer
+//     resource in that frame
+//   - the CPU time between EndWrites and EndAllAccess (see g_DelayEndAllAccess) and the
+//     frames that never call EndAllAccess
+//   - the frames whose BeginAllAccess waits for data written by the previous frame, which
+//     serializes the GPUs
+//
+// Build (any C++11 compiler, no Windows/D3D11/AGS dependency):
+//     g++ -std=c++11 -O2 -I../../src TransferTraceAnalyzerMain.cpp ../../src/TransferTrace.cpp -o TransferTraceAnalyzer
+//     cl /EHsc /O2 /I..\..\src TransferTraceAnalyzerMain.cpp ..\..\src\TransferTrace.cpp
+//
+// Usage:
+//     TransferTraceAnalyzer [--csv] [--list] trace.cfxtrace
+//--------------------------------------------------------------------------------------
+#include "TransferTrace.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace AMD;
+
+// AGSAfrTransferType values
+enum
+{
+    TRANSFER_DEFAULT = 0,
+    TRANSFER_DISABLE = 1,
+    TRANSFER_1STEP_P2P = 2,
+    TRANSFER_2STEP_NO_BROADCAST = 3,
+    TRANSFER_2STEP_WITH_BROADCAST = 4,
+};
+
+static const char * TransferName(int transfer)
+{
+    switch (transfer)
+    {
+    case TRANSFER_DEFAULT:              return "DEFAULT";
+    case TRANSFER_DISABLE:              return "DISABLE";
+    case TRANSFER_1STEP_P2P:            return "1STEP_P2P";
+    case TRANSFER_2STEP_NO_BROADCAST:   return "2STEP_NO_BROADCAST";
+    case TRANSFER_2STEP_WITH_BROADCAST: return "2STEP_WITH_BROADCAST";
+    }
+    return "UNKNOWN";
+}
+
+// what one resource did in one frame
+struct ResourceFrame
+{
+    unsigned int       m_EndWritesCount;
+    unsigned long long m_EndWritesBytes;
+    unsigned long long m_CopiedBytes;
+    unsigned long long m_LastEndWrites;
+    unsigned long long m_EndAllAccess;
+    unsigned long long m_BeginAllAccess;
+    bool               m_HasEndAllAccess;
+    bool               m_HasBeginAllAccess;
+    bool               m_HasCopy;
+
+    ResourceFrame() { memset(this, 0, sizeof(*this)); }
+};
+
+struct FrameInfo
+{
+    unsigned long long m_Start;
+    unsigned long long m_End;
+    unsigned long long m_SentBytes;         // bytes passed to EndWrites
+    unsigned long long m_DeliveredBytes;    // bytes landing on other GPUs
+    unsigned long long m_RedundantBytes;
+    bool               m_Serialized;
+    double             m_EndWritesPosition; // of the data this frame waits for, 0 = start of the producing frame, 1 = end
+
+    std::map<unsigned int, ResourceFrame> m_Resources; // keyed by resource name index, so recreated resources stay together
+
+    FrameInfo() : m_Start(~0ull), m_End(0), m_SentBytes(0), m_DeliveredBytes(0), m_RedundantBytes(0), m_Serialized(false), m_EndWritesPosition(0.0) {}
+};
+
+int main(int argc, char * argv[])
+{
+    const char * path = NULL;
+    bool csv = false;
+    bool list = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if      (strcmp(argv[i], "--csv") == 0)  { csv = true; }
+        else if (strcmp(argv[i], "--list") == 0) { list = true; }
+        else                                     { path = argv[i]; }
+    }
+
+    if (path == NULL)
+    {
+        printf("usage: TransferTraceAnalyzer [--csv] [--list] trace.cfxtrace\n");
+        return 1;
+    }
+
+    TransferTraceReader trace;
+    if (trace.Load(path) == false)
+    {
+        fprintf(stderr, "failed to read %s (not a trace or truncated)\n", path);
+        return 1;
+    }
+
+    const double ticksToMs = 1000.0 / (double)trace.m_TimerFrequency;
+    const unsigned int gpuCount = trace.m_GpuCount > 0 ? trace.m_GpuCount : 1;
+
+    // resources recreated by InitTransferredResources keep their name, group them by it
+    std::vector<unsigned int> nameIndex(trace.m_Resources.size());
+    std::vector<std::string> names;
+    for (size_t i = 0; i < trace.m_Resources.size(); i++)
+    {
+        const std::string name = trace.m_Resources[i].m_Name;
+        size_t n = 0;
+        while (n < names.size() && names[n] != name) { n++; }
+        if (n == names.size()) { names.push_back(name); }
+        nameIndex[i] = (unsigned int)n;
+    }
+
+    std::map<unsigned int, FrameInfo> frames;
+
+    unsigned int repeatedEndWrites = 0;
+    unsigned int ineffectiveEndWrites = 0;
+    unsigned int truncatedRecords = 0;
+
+    for (size_t i = 0; i < trace.m_Records.size(); i++)
+    {
+        const TransferTraceRecord & record = trace.m_Records[i];
+        const TransferTraceResource & resource = trace.m_Resources[record.m_Resource];
+
+        FrameInfo & frame = frames[record.m_Frame];
+        frame.m_Start = record.m_Timestamp < frame.m_Start ? record.m_Timestamp : frame.m_Start;
+        frame.m_End = record.m_Timestamp > frame.m_End ? record.m_Timestamp : frame.m_End;
+
+        ResourceFrame & rf = frame.m_Resources[nameIndex[record.m_Resource]];
+
+        if (record.m_Flags & TRANSFER_TRACE_FLAG_TRUNCATED) { truncatedRecords++; }
+
+        switch (record.m_Event)
+        {
+        case TRANSFER_TRACE_EVENT_END_WRITES:
+            {
+                const bool transfers = resource.m_TransferType != TRANSFER_DEFAULT && resource.m_TransferType != TRANSFER_DISABLE;
+                const unsigned int destinations = resource.m_TransferType == TRANSFER_2STEP_WITH_BROADCAST ? gpuCount - 1 : 1;
+
+                if (transfers == false)
+                {
+                    ineffectiveEndWrites++;
+                }
+                else
+                {
+                    if (rf.m_EndWritesCount > 0)
+                    {
+                        repeatedEndWrites++;
+                        frame.m_RedundantBytes += record.m_Bytes;
+                    }
+
+                    frame.m_SentBytes += record.m_Bytes;
+                    frame.m_DeliveredBytes += record.m_Bytes * destinations;
+                }
+
+                rf.m_EndWritesCount++;
+                rf.m_EndWritesBytes += transfers ? record.m_Bytes : 0;
+                rf.m_LastEndWrites = record.m_Timestamp;
+            }
+            break;
+
+        case TRANSFER_TRACE_EVENT_BEGIN_ALL_ACCESS:
+            if (rf.m_HasBeginAllAccess == false)
+            {
+                rf.m_BeginAllAccess = record.m_Timestamp;
+                rf.m_HasBeginAllAccess = true;
+            }
+            break;
+
+        case TRANSFER_TRACE_EVENT_END_ALL_ACCESS:
+            rf.m_EndAllAccess = record.m_Timestamp;
+            rf.m_HasEndAllAccess = true;
+            break;
+
+        case TRANSFER_TRACE_EVENT_COPY:
+            rf.m_CopiedBytes += record.m_Bytes;
+            rf.m_HasCopy = true;
+            break;
+        }
+    }
+
+    if (frames.empty())
+    {
+        printf("%s: no records\n", path);
+        return 0;
+    }
+
+    // transfer resources that get copies: anything sent beyond what was copied in was already on the other GPUs
+    unsigned long long overSentBytes = 0;
+
+    // EndWrites -> EndAllAccess distance
+    double distanceSum = 0.0, distanceMax = 0.0;
+    unsigned int distanceCount = 0, missingEndAllAccess = 0;
+
+    unsigned int serializedFrames = 0;
+    double serializedPositionSum = 0.0;
+
+    for (std::map<unsigned int, FrameInfo>::iterator it = frames.begin(); it != frames.end(); ++it)
+    {
+        FrameInfo & frame = it->second;
+
+        for (std::map<unsigned int, ResourceFrame>::iterator r = frame.m_Resources.begin(); r != frame.m_Resources.end(); ++r)
+        {
+            const ResourceFrame & rf = r->second;
+
+            if (rf.m_HasCopy && rf.m_EndWritesBytes > rf.m_CopiedBytes)
+            {
+                overSentBytes += rf.m_EndWritesBytes - rf.m_CopiedBytes;
+                frame.m_RedundantBytes += rf.m_EndWritesBytes - rf.m_CopiedBytes;
+            }
+
+            if (rf.m_EndWritesCount > 0)
+            {
+                if (rf.m_HasEndAllAccess && rf.m_EndAllAccess >= rf.m_LastEndWrites)
+                {
+                    const double distance = (double)(rf.m_EndAllAccess - rf.m_LastEndWrites) * ticksToMs;
+                    distanceSum += distance;
+                    distanceMax = distance > distanceMax ? distance : distanceMax;
+                    distanceCount++;
+                }
+                else if (rf.m_HasEndAllAccess == false)
+                {
+                    missingEndAllAccess++;
+                }
+            }
+
+            // BeginAllAccess waits for the transfer issued by the previous frame, i.e. the previous GPU
+            if (rf.m_HasBeginAllAccess && it->first > 0)
+            {
+                std::map<unsigned int, FrameInfo>::const_iterator prev = frames.find(it->first - 1);
+                if (prev != frames.end())
+                {
+                    std::map<unsigned int, ResourceFrame>::const_iterator p = prev->second.m_Resources.find(r->first);
+                    if (p != prev->second.m_Resources.end() && p->second.m_EndWritesBytes > 0 && frame.m_Serialized == false)
+                    {
+                        const FrameInfo & producer = prev->second;
+                        const double length = (double)(producer.m_End - producer.m_Start);
+
+                        frame.m_Serialized = true;
+                        frame.m_EndWritesPosition = length > 0.0 ? (double)(p->second.m_LastEndWrites - producer.m_Start) / length : 0.0;
+
+                        serializedFrames++;
+                        serializedPositionSum += frame.m_EndWritesPosition;
+                    }
+                }
+            }
+        }
+    }
+
+    if (csv)
+    {
+        printf("frame,cpu_ms,sent_bytes,delivered_bytes,redundant_bytes,serialized,end_writes_position\n");
+        for (std::map<unsigned int, FrameInfo>::const_iterator it = frames.begin(); it != frames.end(); ++it)
+        {
+            const FrameInfo & f = it->second;
+            printf("%u,%.4f,%llu,%llu,%llu,%d,%.3f\n", it->first, (double)(f.m_End - f.m_Start) * ticksToMs,
+                f.m_SentBytes, f.m_DeliveredBytes, f.m_RedundantBytes, f.m_Serialized ? 1 : 0, f.m_EndWritesPosition);
+        }
+        return 0;
+    }
+
+    unsigned long long sentSum = 0, deliveredSum = 0, redundantSum = 0, sentMax = 0;
+    unsigned int framesWithTransfers = 0;
+    for (std::map<unsigned int, FrameInfo>::const_iterator it = frames.begin(); it != frames.end(); ++it)
+    {
+        sentSum += it->second.m_SentBytes;
+        deliveredSum += it->second.m_DeliveredBytes;
+        redundantSum += it->second.m_RedundantBytes;
+        sentMax = it->second.m_SentBytes > sentMax ? it->second.m_SentBytes : sentMax;
+        framesWithTransfers += it->second.m_SentBytes > 0 ? 1 : 0;
+    }
+
+    const double frameCount = (double)frames.size();
+    const double MB = 1024.0 * 1024.0;
+
+    printf("trace            : %s\n", path);
+    printf("gpus             : %u\n", gpuCount);
+    printf("frames           : %u .. %u (%u frames, %zu records, %llu dropped, %u truncated)\n",
+        frames.begin()->first, frames.rbegin()->first, (unsigned int)frames.size(), trace.m_Records.size(), trace.m_Dropped, truncatedRecords);
+
+    printf("\nresources\n");
+    for (size_t i = 0; i < trace.m_Resources.size(); i++)
+    {
+        const TransferTraceResource & r = trace.m_Resources[i];
+        printf("  [%u] %-24s %5ux%-5u x%u %ubpp %s\n", r.m_Id, r.m_Name, r.m_Width, r.m_Height, r.m_ArraySize, r.m_BytesPerTexel * 8, TransferName(r.m_TransferType));
+    }
+
+    printf("\nbytes per frame\n");
+    printf("  sent (EndWrites)        : %8.3f MB avg, %8.3f MB max, %u of %u frames transfer\n", sentSum / frameCount / MB, sentMax / MB, framesWithTransfers, (unsigned int)frames.size());
+    printf("  delivered (all GPUs)    : %8.3f MB avg\n", deliveredSum / frameCount / MB);
+
+    printf("\nredundant transfers\n");
+    printf("  repeated EndWrites      : %u (same resource, same frame)\n", repeatedEndWrites);
+    printf("  EndWrites w/o transfer  : %u (resource is DEFAULT or DISABLE)\n", ineffectiveEndWrites);
+    printf("  sent but not copied     : %8.3f MB total (more than 2 GPUs may need it to catch up)\n", overSentBytes / MB);
+    printf("  redundant               : %8.3f MB avg per frame (%.1f%% of sent)\n", redundantSum / frameCount / MB, sentSum > 0 ? 100.0 * (double)redundantSum / (double)sentSum : 0.0);
+
+    printf("\nEndWrites -> EndAllAccess\n");
+    printf("  distance                : %.3f ms avg, %.3f ms max over %u resource frames\n", distanceCount > 0 ? distanceSum / distanceCount : 0.0, distanceMax, distanceCount);
+    printf("  missing EndAllAccess    : %u resource frames (the driver waits for the end of the frame)\n", missingEndAllAccess);
+
+    printf("\nGPU serialization\n");
+    printf("  serialized frames       : %u (BeginAllAccess waits for data written by the previous frame)\n", serializedFrames);
+    printf("  EndWrites position      : %.2f avg in the producing frame (0 = start, 1 = end; late EndWrites serialize more)\n",
+        serializedFrames > 0 ? serializedPositionSum / serializedFrames : 0.0);
+
+    if (list)
+    {
+        printf("\nserialized frame list\n");
+        for (std::map<unsigned int, FrameInfo>::const_iterator it = frames.begin(); it != frames.end(); ++it)
+        {
+            if (it->second.m_Serialized)
+            {
+                printf("  frame %u waits for frame %u (EndWrites at %.2f)\n", it->first, it->first - 1, it->second.m_EndWritesPosition);
+            }
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,295 @@
+//
+// Copyright (c) 2016 Advanced Micro Devices, Inc. All rights reserved.
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.  IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+// THE SOFTWARE.
+//
+//--------------------------------------------------------------------------------------
+// File: TransferValidatorMain.cpp
+//
+// CPU checks of AMD::TransferValidator: the notifications of the 1-step and 2-step
+// transfers over several frames, which must not report anything, then each mistake the
+// validator knows about, which must be reported once, with the right resource and frame,
+// and nothing else. Exits nonzero if a check fails.
+//
+// Build (any C++11 compiler, no Windows/D3D11/AGS dependency):
+//     g++ -std=c++11 -O2 -I../../src TransferValidatorMain.cpp ../../src/TransferValidator.cpp -o TransferValidator
+//     cl /EHsc /O2 /I..\..\src TransferValidatorMain.cpp ..\..\src\TransferValidator.cpp
+//
+// Usage:
+//     TransferValidator [--frames N]
+//--------------------------------------------------------------------------------------
+#include "TransferValidator.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace AMD;
+
+static int g_Failures = 0;
+
+static void Check(bool condition, const char * name, float value)
+{
+    printf("%-48s %10.4g %s\n", name, value, condition ? "ok" : "FAIL");
+    g_Failures += condition ? 0 : 1;
+}
+
+// stand-ins for the shadow map and the transfer shadow map, only their addresses matter
+static int g_ShadowMap = 0;
+static int g_ShadowMapTransfer = 0;
+
+// the last error the validator passed to the callback
+struct LastError
+{
+    unsigned int            m_Count;
+    TransferValidationError m_Error;
+};
+
+static void OnError(const TransferValidationError & error, void * pUserData)
+{
+    LastError * pLast = (LastError *)pUserData;
+    pLast->m_Count++;
+    pLast->m_Error = error;
+}
+
+//--------------------------------------------------------------------------------------
+// The clean flows of CrossfireAPI11
+//--------------------------------------------------------------------------------------
+
+// 1-step: the shadow map is rendered, the driver transfers it after EndWrites, and the
+// scene samples it before EndAllAccess
+static void OneStepFrame(TransferValidator & validator, unsigned int frame)
+{
+    validator.BeginFrame(frame);
+    validator.BeginAllAccess(&g_ShadowMap);
+    validator.Write(&g_ShadowMap);
+    validator.Write(&g_ShadowMap);
+    validator.EndWrites(&g_ShadowMap);
+    validator.Read(&g_ShadowMap);
+    validator.EndAllAccess(&g_ShadowMap);
+    validator.EndFrame();
+}
+
+// 2-step: the shadow map is copied into the transfer shadow map, which the driver sends
+// to the next GPU, and which is copied back into the shadow map a frame later
+static void TwoStepFrame(TransferValidator & validator, unsigned int frame)
+{
+    validator.BeginFrame(frame);
+    validator.BeginAllAccess(&g_ShadowMapTransfer);
+    validator.Read(&g_ShadowMapTransfer);
+    validator.Write(&g_ShadowMap);
+    validator.Write(&g_ShadowMap);
+    validator.Read(&g_ShadowMap);
+    validator.Write(&g_ShadowMapTransfer);
+    validator.EndWrites(&g_ShadowMapTransfer);
+    validator.EndAllAccess(&g_ShadowMapTransfer);
+    validator.Read(&g_ShadowMap);
+    validator.EndFrame();
+}
+
+static void RunCleanFlows(unsigned int frames)
+{
+    TransferValidator validator;
+    LastError         last;
+    memset(&last, 0, sizeof(last));
+    validator.SetCallback(OnError, &last);
+    validator.RegisterResource(&g_ShadowMap, "ShadowMap");
+    validator.RegisterResource(&g_ShadowMapTransfer, "ShadowMapTransfer");
+
+    for (unsigned int frame = 0; frame < frames; frame++)
+    {
+        OneStepFrame(validator, frame);
+    }
+    Check(validator.GetErrorCount() == 0 && last.m_Count == 0, "clean: 1-step errors", (float)validator.GetErrorCount());
+
+    for (unsigned int frame = 0; frame < frames; frame++)
+    {
+        TwoStepFrame(validator, frames + frame);
+    }
+    Check(validator.GetErrorCount() == 0 && last.m_Count == 0, "clean: 2-step errors", (float)validator.GetErrorCount());
+
+    // a frame without notifications, as when the transfers are off
+    validator.BeginFrame(2 * frames);
+    validator.Write(&g_ShadowMap);
+    validator.Read(&g_ShadowMap);
+    validator.EndFrame();
+    Check(validator.GetErrorCount() == 0, "clean: frame without notifications", (float)validator.GetErrorCount());
+}
+
+//--------------------------------------------------------------------------------------
+// The mistakes: a clean frame, then a frame with the mistake, then a clean frame again
+//--------------------------------------------------------------------------------------
+typedef void (*Mistake)(TransferValidator & validator);
+
+static void WriteAfterEndAllAccess(TransferValidator & validator)
+{
+    validator.BeginAllAccess(&g_ShadowMap);
+    validator.Write(&g_ShadowMap);
+    validator.EndWrites(&g_ShadowMap);
+    validator.EndAllAccess(&g_ShadowMap);
+    validator.Write(&g_ShadowMap);
+}
+
+static void ReadAfterEndAllAccess(TransferValidator & validator)
+{
+    validator.BeginAllAccess(&g_ShadowMap);
+    validator.Write(&g_ShadowMap);
+    validator.EndWrites(&g_ShadowMap);
+    validator.EndAllAccess(&g_ShadowMap);
+    validator.Read(&g_ShadowMap);
+}
+
+static void EndWritesWithoutWrites(TransferValidator & validator)
+{
+    validator.BeginAllAccess(&g_ShadowMap);
+    validator.EndWrites(&g_ShadowMap);
+    validator.EndAllAccess(&g_ShadowMap);
+}
+
+static void EndWritesTwice(TransferValidator & validator)
+{
+    validator.BeginAllAccess(&g_ShadowMap);
+    validator.Write(&g_ShadowMap);
+    validator.EndWrites(&g_ShadowMap);
+    validator.EndWrites(&g_ShadowMap);
+    validator.EndAllAccess(&g_ShadowMap);
+}
+
+static void EndWritesAfterEndAllAccess(TransferValidator & validator)
+{
+    validator.BeginAllAccess(&g_ShadowMap);
+    validator.Write(&g_ShadowMap);
+    validator.EndAllAccess(&g_ShadowMap);
+    validator.EndWrites(&g_ShadowMap);
+}
+
+static void DoubleBeginAllAccess(TransferValidator & validator)
+{
+    validator.BeginAllAccess(&g_ShadowMap);
+    validator.BeginAllAccess(&g_ShadowMap);
+    validator.Write(&g_ShadowMap);
+    validator.EndWrites(&g_ShadowMap);
+    validator.EndAllAccess(&g_ShadowMap);
+}
+
+static void BeginAllAccessAfterEndAllAccess(TransferValidator & validator)
+{
+    validator.BeginAllAccess(&g_ShadowMap);
+    validator.Write(&g_ShadowMap);
+    validator.EndWrites(&g_ShadowMap);
+    validator.EndAllAccess(&g_ShadowMap);
+    validator.BeginAllAccess(&g_ShadowMap);
+}
+
+static void DoubleEndAllAccess(TransferValidator & validator)
+{
+    validator.BeginAllAccess(&g_ShadowMap);
+    validator.Write(&g_ShadowMap);
+    validator.EndWrites(&g_ShadowMap);
+    validator.EndAllAccess(&g_ShadowMap);
+    validator.EndAllAccess(&g_ShadowMap);
+}
+
+static void MissingEndAllAccess(TransferValidator & validator)
+{
+    validator.BeginAllAccess(&g_ShadowMap);
+    validator.Write(&g_ShadowMap);
+    validator.EndWrites(&g_ShadowMap);
+    validator.Read(&g_ShadowMap);
+}
+
+static void RunMistake(const char * name, Mistake mistake, TRANSFER_VALIDATION_ERROR expected)
+{
+    TransferValidator validator;
+    LastError         last;
+    memset(&last, 0, sizeof(last));
+    validator.SetCallback(OnError, &last);
+    validator.RegisterResource(&g_ShadowMap, "ShadowMap");
+
+    OneStepFrame(validator, 7);
+
+    validator.BeginFrame(8);
+    mistake(validator);
+    validator.EndFrame();
+
+    OneStepFrame(validator, 9);
+
+    const bool reported = validator.GetErrorCount() == 1 && validator.GetErrorCount(expected) == 1 && last.m_Count == 1 &&
+                          last.m_Error.m_Error == expected && last.m_Error.m_Frame == 8 &&
+                          last.m_Error.m_pResource == &g_ShadowMap && strcmp(last.m_Error.m_Name, "ShadowMap") == 0;
+    Check(reported, name, (float)validator.GetErrorCount());
+}
+
+static void RunMistakes()
+{
+    RunMistake("mistake: write after EndAllAccess", WriteAfterEndAllAccess, TRANSFER_VALIDATION_ERROR_WRITE_AFTER_END_ALL_ACCESS);
+    RunMistake("mistake: read after EndAllAccess", ReadAfterEndAllAccess, TRANSFER_VALIDATION_ERROR_READ_AFTER_END_ALL_ACCESS);
+    RunMistake("mistake: EndWrites without writes", EndWritesWithoutWrites, TRANSFER_VALIDATION_ERROR_END_WRITES_WITHOUT_WRITES);
+    RunMistake("mistake: EndWrites twice", EndWritesTwice, TRANSFER_VALIDATION_ERROR_END_WRITES_WITHOUT_WRITES);
+    RunMistake("mistake: EndWrites after EndAllAccess", EndWritesAfterEndAllAccess, TRANSFER_VALIDATION_ERROR_END_WRITES_AFTER_END_ALL_ACCESS);
+    RunMistake("mistake: BeginAllAccess twice", DoubleBeginAllAccess, TRANSFER_VALIDATION_ERROR_DOUBLE_BEGIN_ALL_ACCESS);
+    RunMistake("mistake: BeginAllAccess after EndAllAccess", BeginAllAccessAfterEndAllAccess, TRANSFER_VALIDATION_ERROR_BEGIN_ALL_ACCESS_AFTER_END_ALL_ACCESS);
+    RunMistake("mistake: EndAllAccess twice", DoubleEndAllAccess, TRANSFER_VALIDATION_ERROR_DOUBLE_END_ALL_ACCESS);
+    RunMistake("mistake: no EndAllAccess at the end of frame", MissingEndAllAccess, TRANSFER_VALIDATION_ERROR_MISSING_END_ALL_ACCESS);
+
+    // a mistake on one resource is not reported on another
+    TransferValidator validator;
+    validator.BeginFrame(0);
+    validator.BeginAllAccess(&g_ShadowMapTransfer);
+    validator.Write(&g_ShadowMapTransfer);
+    validator.EndWrites(&g_ShadowMapTransfer);
+    validator.EndAllAccess(&g_ShadowMapTransfer);
+    validator.Write(&g_ShadowMap);
+    validator.EndFrame();
+    Check(validator.GetErrorCount() == 0, "mistake: resources are independent", (float)validator.GetErrorCount());
+
+    validator.BeginFrame(1);
+    MissingEndAllAccess(validator);
+    validator.EndFrame();
+    const unsigned int before = validator.GetErrorCount();
+    validator.ClearErrors();
+    Check(before == 1 && validator.GetErrorCount() == 0, "mistake: ClearErrors", (float)before);
+}
+
+int main(int argc, char * argv[])
+{
+    unsigned int frames = 16;
+
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (strcmp(argv[i], "--frames") == 0) { frames = (unsigned int)atoi(argv[i + 1]); }
+        else
+        {
+            printf("usage: TransferValidator [--frames N]\n");
+            return 1;
+        }
+    }
+
+    if (frames == 0)
+    {
+        fprintf(stderr, "--frames must be positive\n");
+        return 1;
+    }
+
+    RunCleanFlows(frames);
+    RunMistakes();
+
+    printf("%s\n", g_Failures == 0 ? "PASS" : "FAIL");
+    return g_Failures == 0 ? 0 : 1;
+}